@@ -446,6 +446,103 @@ char* DataSet::LoadDataAndReturnFilePosition(int32_t rowStart, int32_t col, int3
 	return data;
 }
 
+/*
+ * Return the address of the data at rowStart if rowCount rows of the column are all in memory.
+ */
+char* DataSet::MappedRows(int32_t rowStart, int32_t col, int32_t rowCount)
+{
+	char* instr = FilePosition(rowStart, col, rowCount);
+
+	// End of the data held in memory.
+	char* end = data + mapLen;
+#ifndef _MSC_VER
+	if (useMemoryMapping)
+		end = (char*)mappedData + mapLen;	// mapLen includes the page offset
+#endif
+	int32_t colSize = columnByteOffsets[col+1] - columnByteOffsets[col];
+	if (instr == 0 || instr + (int64_t)BytesPerRow()*(rowCount-1) + colSize > end)
+		return 0;
+	return instr;
+}
+
+/*
+ * Provide a view of the data without copying it.
+ */
+bool DataSet::GetDataView(int32_t col, int32_t startRow, int32_t count, DataSetColumnView& view)
+{
+	view = DataSetColumnView();
+	if (col < 0 || col >= header.GetColumnCnt())
+	{
+		affymetrix_calvin_exceptions::ColumnIndexOutOfBoundsException e(L"Calvin",L"Default Description, Please Update!",affymetrix_calvin_utilities::DateTime::GetCurrentDateTime().ToString(),std::string(__FILE__),(u_int16_t)__LINE__,0);
+		throw e;
+	}
+
+	int32_t endRow = ComputeEndRow(startRow, count);
+	if (endRow <= startRow)
+		return true;
+
+	char* instr = MappedRows(startRow, col, endRow-startRow);
+	if (instr == 0)
+		return false;
+
+	view.data = instr;
+	view.count = endRow-startRow;
+	view.stride = BytesPerRow();
+	view.type = header.GetColumnInfo(col).GetColumnType();
+	return true;
+}
+
+void DataSetColumnView::CheckType(DataSetColumnTypes expected) const
+{
+	if (count > 0 && type != expected)
+	{
+		affymetrix_calvin_exceptions::UnexpectedColumnTypeException e(L"Calvin",L"Default Description, Please Update!",affymetrix_calvin_utilities::DateTime::GetCurrentDateTime().ToString(),std::string(__FILE__),(u_int16_t)__LINE__,0);
+		throw e;
+	}
+}
+
+void DataSetColumnView::CopyTo(u_int8_t* values) const
+{
+	CheckType(UByteColType);
+	FileInput::ReadUInt8Array(data, count, stride, values);
+}
+
+void DataSetColumnView::CopyTo(int8_t* values) const
+{
+	CheckType(ByteColType);
+	FileInput::ReadInt8Array(data, count, stride, values);
+}
+
+void DataSetColumnView::CopyTo(u_int16_t* values) const
+{
+	CheckType(UShortColType);
+	FileInput::ReadUInt16Array(data, count, stride, values);
+}
+
+void DataSetColumnView::CopyTo(int16_t* values) const
+{
+	CheckType(ShortColType);
+	FileInput::ReadInt16Array(data, count, stride, values);
+}
+
+void DataSetColumnView::CopyTo(u_int32_t* values) const
+{
+	CheckType(UIntColType);
+	FileInput::ReadUInt32Array(data, count, stride, values);
+}
+
+void DataSetColumnView::CopyTo(int32_t* values) const
+{
+	CheckType(IntColType);
+	FileInput::ReadInt32Array(data, count, stride, values);
+}
+
+void DataSetColumnView::CopyTo(float* values) const
+{
+	CheckType(FloatColType);
+	FileInput::ReadFloatArray(data, count, stride, values);
+}
+
 /*
  * Update the column sizes
  */
@@ -547,6 +644,17 @@ template<typename T> void DataSet::GetDataT(int32_t col, int32_t startRow, int32
 	int32_t endRow = ComputeEndRow(startRow, count);
 	ClearAndSizeVector(values, endRow-startRow);
 
+	// All the rows in memory at once: convert them in one go.
+	if (endRow > startRow)
+	{
+		char* instr = MappedRows(startRow, col, endRow-startRow);
+		if (instr != 0)
+		{
+			AssignValues(&values[0], instr, endRow-startRow, BytesPerRow());
+			return;
+		}
+	}
+
 	if (header.GetColumnCnt() > 1)
 	{
 		for (int32_t row = startRow; row < endRow; ++row)
@@ -667,6 +775,17 @@ template<typename T> int32_t DataSet::GetDataRawT(int32_t col, int32_t startRow,
 {
 	int32_t endRow = ComputeEndRow(startRow, count);
 
+	// All the rows in memory at once: convert them in one go.
+	if (endRow > startRow)
+	{
+		char* instr = MappedRows(startRow, col, endRow-startRow);
+		if (instr != 0)
+		{
+			AssignValues(values, instr, endRow-startRow, BytesPerRow());
+			return endRow-startRow;
+		}
+	}
+
 	if (header.GetColumnCnt() > 1)
 	{
 		for (int32_t row = startRow; row < endRow; ++row)
@@ -737,6 +856,59 @@ void DataSet::AssignValue(int32_t index, std::wstring* values, char*& instr)
 	values[index] = FileInput::ReadString16(instr);
 }
 
+void DataSet::AssignValues(u_int8_t* values, char* instr, int32_t count, int32_t stride)
+{
+	FileInput::ReadUInt8Array(instr, count, stride, values);
+}
+
+void DataSet::AssignValues(int8_t* values, char* instr, int32_t count, int32_t stride)
+{
+	FileInput::ReadInt8Array(instr, count, stride, values);
+}
+
+void DataSet::AssignValues(u_int16_t* values, char* instr, int32_t count, int32_t stride)
+{
+	FileInput::ReadUInt16Array(instr, count, stride, values);
+}
+
+void DataSet::AssignValues(int16_t* values, char* instr, int32_t count, int32_t stride)
+{
+	FileInput::ReadInt16Array(instr, count, stride, values);
+}
+
+void DataSet::AssignValues(u_int32_t* values, char* instr, int32_t count, int32_t stride)
+{
+	FileInput::ReadUInt32Array(instr, count, stride, values);
+}
+
+void DataSet::AssignValues(int32_t* values, char* instr, int32_t count, int32_t stride)
+{
+	FileInput::ReadInt32Array(instr, count, stride, values);
+}
+
+void DataSet::AssignValues(float* values, char* instr, int32_t count, int32_t stride)
+{
+	FileInput::ReadFloatArray(instr, count, stride, values);
+}
+
+void DataSet::AssignValues(std::string* values, char* instr, int32_t count, int32_t stride)
+{
+	for (int32_t i = 0; i < count; ++i)
+	{
+		char* pos = instr + (int64_t)i*stride;
+		AssignValue(i, values, pos);
+	}
+}
+
+void DataSet::AssignValues(std::wstring* values, char* instr, int32_t count, int32_t stride)
+{
+	for (int32_t i = 0; i < count; ++i)
+	{
+		char* pos = instr + (int64_t)i*stride;
+		AssignValue(i, values, pos);
+	}
+}
+
 int32_t DataSet::GetDataRaw(int32_t col, int32_t startRow, int32_t count, u_int8_t* values)
 {
 	return GetDataRawT(col, startRow, count, values);
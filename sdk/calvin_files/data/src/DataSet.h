@@ -42,6 +42,62 @@ namespace affymetrix_calvin_io
 // forward declare
 class GenericData;
 
+/*! A read only view of consecutive values of one column of a DataSet.
+ *	The view points straight into the DataSet's memory-mapped (or loaded) data, nothing
+ *	is copied. The values are left as stored in the file (big endian), one every Stride()
+ *	bytes; use the CopyTo methods or the FileInput::Read*Array functions to convert them.
+ *	On Linux the whole DataSet is mapped when it is opened so a view stays valid until the
+ *	DataSet is closed. When a DataSet is accessed through a limited view (Windows) or with
+ *	std::ifstream without loadEntireDataSetHint the next access to the DataSet may remap or
+ *	reload the data and invalidate the view.
+ */
+class DataSetColumnView
+{
+public:
+	/*! Constructor. An empty view. */
+	DataSetColumnView() : data(0), count(0), stride(0), type(ByteColType) {}
+
+	/*! The first value, as stored in the file. */
+	const char* Data() const { return data; }
+
+	/*! The number of values in the view. */
+	int32_t Count() const { return count; }
+
+	/*! The number of bytes from one value to the next. */
+	int32_t Stride() const { return stride; }
+
+	/*! The type of the column. */
+	DataSetColumnTypes Type() const { return type; }
+
+	/*! Converts the values to host byte order.  The caller is responsible for allocating
+	 *	storage for Count() values.
+	 *	@param values Where to write the values.
+	 *	@exception affymetrix_calvin_exceptions::UnexpectedColumnTypeException The column type does not match the type requested.
+	 */
+	void CopyTo(u_int8_t* values) const;
+	void CopyTo(int8_t* values) const;
+	void CopyTo(u_int16_t* values) const;
+	void CopyTo(int16_t* values) const;
+	void CopyTo(u_int32_t* values) const;
+	void CopyTo(int32_t* values) const;
+	void CopyTo(float* values) const;
+
+private:
+	friend class DataSet;
+
+	/*! Throw if the column is not of the expected type. */
+	void CheckType(DataSetColumnTypes expected) const;
+
+	/*! The first value. */
+	const char* data;
+	/*! Number of values. */
+	int32_t count;
+	/*! Bytes between values. */
+	int32_t stride;
+	/*! Column type. */
+	DataSetColumnTypes type;
+};
+
 /*! This class provides methods to access the data of a DataSet. */
 class DataSet
 {
@@ -175,6 +231,19 @@ public:
 
 	int32_t GetDataRaw(int32_t col, int32_t startRow, int32_t count, std::wstring* values);
 
+	/*! Provides access to multiple data elements in the same column without copying them.
+	 *	If count elements are not available the view has only the ones that are.
+	 *	@param col Column index.
+	 *	@param startRow Row index of the first element of the view.
+	 *	@param count Number of elements to view. -1 indicates to view all
+	 *	@param view Filled in with the location, count and stride of the elements.
+	 *	@return false if the rows could not all be put in memory at once (a limited Windows view),
+	 *	in which case the view is empty and the GetData methods should be used instead.
+	 *	@exception affymetrix_calvin_exceptions::DataSetNotOpenException The file is not open.
+	 *	@exception affymetrix_calvin_exceptions::ColumnIndexOutOfBoundsException The column index is out-of-bounds.
+	 */
+	bool GetDataView(int32_t col, int32_t startRow, int32_t count, DataSetColumnView& view);
+
 	/*! Check that the requested data matches the type of data in the column and that row and column are in bounds.
 	 *	@param row Row index to check.
 	 *	@param col Column index to check.
@@ -235,6 +304,16 @@ protected:
 	 */
 	char* LoadDataAndReturnFilePosition(int32_t rowStart, int32_t col, int32_t rowCount);
 
+	/*! Returns the address of a data element given a row and column if the element and the
+	 *	same column of the following rowCount-1 rows are all in memory at once.
+	 *	@param rowStart Row index
+	 *	@param col Column index
+	 *	@param rowCount The number of rows needed, at least 1.
+	 *	@return Pointer to the data element at rowStart or 0 if the rows do not all fit.
+	 *	@exception affymetrix_calvin_exceptions::DataSetNotOpenException The file is not open.
+	 */
+	char* MappedRows(int32_t rowStart, int32_t col, int32_t rowCount);
+
 	/*! Updates the columnByteOffsets member. */
 	void UpdateColumnByteOffsets();
 
@@ -328,6 +407,31 @@ protected:
 
 	void AssignValue(int32_t index, std::wstring* values, char*& instr);
 
+	/*! Converts count elements stride bytes apart starting at instr into values.
+	 *	The fixed size types are converted with one call to FileInput::Read*Array.
+	 *	@param values Where to write the elements.
+	 *	@param instr A pointer to the first element in the memory buffer.
+	 *	@param count Number of elements.
+	 *	@param stride Bytes from one element to the next.
+	 */
+	void AssignValues(u_int8_t* values, char* instr, int32_t count, int32_t stride);
+
+	void AssignValues(int8_t* values, char* instr, int32_t count, int32_t stride);
+
+	void AssignValues(u_int16_t* values, char* instr, int32_t count, int32_t stride);
+
+	void AssignValues(int16_t* values, char* instr, int32_t count, int32_t stride);
+
+	void AssignValues(u_int32_t* values, char* instr, int32_t count, int32_t stride);
+
+	void AssignValues(int32_t* values, char* instr, int32_t count, int32_t stride);
+
+	void AssignValues(float* values, char* instr, int32_t count, int32_t stride);
+
+	void AssignValues(std::string* values, char* instr, int32_t count, int32_t stride);
+
+	void AssignValues(std::wstring* values, char* instr, int32_t count, int32_t stride);
+
 protected:
 	/*! name of the file containing the data data set*.  */
 	std::string fileName;
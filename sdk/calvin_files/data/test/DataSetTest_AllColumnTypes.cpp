@@ -149,3 +149,94 @@ void DataSetTest_AllColumnTypes::testAccessColumnValues()
 
 }
 
+// The whole column at once (converted in one go since the
+// DataSet is in memory) has to match the row by row values.
+void DataSetTest_AllColumnTypes::testAccessColumnVectors()
+{
+	CPPUNIT_ASSERT(dataPlane->Open() == true);
+
+	int32_t rows = dataPlane->Rows();
+	Int8Vector b;
+	Uint8Vector ub;
+	std::vector<std::string> str;
+	Int16Vector s;
+	Uint16Vector us;
+	Int32Vector i;
+	Uint32Vector ui;
+	WStringVector wstr;
+	FloatVector f;
+	float* fraw = new float[rows];
+
+	CPPUNIT_ASSERT_NO_THROW(dataPlane->GetData(0, 0, -1, b));
+	CPPUNIT_ASSERT_NO_THROW(dataPlane->GetData(1, 0, -1, ub));
+	CPPUNIT_ASSERT_NO_THROW(dataPlane->GetData(2, 0, -1, str));
+	CPPUNIT_ASSERT_NO_THROW(dataPlane->GetData(3, 0, -1, s));
+	CPPUNIT_ASSERT_NO_THROW(dataPlane->GetData(4, 0, -1, us));
+	CPPUNIT_ASSERT_NO_THROW(dataPlane->GetData(5, 0, -1, i));
+	CPPUNIT_ASSERT_NO_THROW(dataPlane->GetData(6, 0, -1, ui));
+	CPPUNIT_ASSERT_NO_THROW(dataPlane->GetData(7, 0, -1, wstr));
+	CPPUNIT_ASSERT_NO_THROW(dataPlane->GetData(8, 0, -1, f));
+	CPPUNIT_ASSERT(dataPlane->GetDataRaw(8, 1, rows, fraw) == rows-1);
+	CPPUNIT_ASSERT((int32_t)f.size() == rows);
+
+	for (int32_t row = 0; row < rows; ++row)
+	{
+		char expected_str[10];
+		wchar_t expected_wstr[15];
+		sprintf(expected_str, "%d", 3+10*row);
+		FormatString1(expected_wstr, 15, L"%d", 8+10*row);
+
+		CPPUNIT_ASSERT(b[row] == (int8_t)(1+10*row));
+		CPPUNIT_ASSERT(ub[row] == (u_int8_t)(2+10*row));
+		CPPUNIT_ASSERT(str[row] == expected_str);
+		CPPUNIT_ASSERT(s[row] == (int16_t)(4+10*row));
+		CPPUNIT_ASSERT(us[row] == (u_int16_t)(5+10*row));
+		CPPUNIT_ASSERT(i[row] == (int32_t)(6+10*row));
+		CPPUNIT_ASSERT(ui[row] == (u_int32_t)(7+10*row));
+		CPPUNIT_ASSERT(wstr[row] == expected_wstr);
+		CPPUNIT_ASSERT(f[row] == (float)(9+10*row));
+		if (row > 0)
+			CPPUNIT_ASSERT(fraw[row-1] == f[row]);
+	}
+	delete[] fraw;
+
+	CPPUNIT_ASSERT_NO_THROW(dataPlane->Close());
+}
+
+void DataSetTest_AllColumnTypes::testAccessColumnViews()
+{
+	CPPUNIT_ASSERT(dataPlane->Open() == true);
+
+	int32_t rows = dataPlane->Rows();
+	DataSetColumnView view;
+
+	// Float column, every row.
+	CPPUNIT_ASSERT(dataPlane->GetDataView(8, 0, -1, view));
+	CPPUNIT_ASSERT(view.Count() == rows);
+	CPPUNIT_ASSERT(view.Type() == FloatColType);
+	CPPUNIT_ASSERT(view.Stride() == dataPlane->BytesPerRow());
+	std::vector<float> f(rows);
+	view.CopyTo(&f[0]);
+	for (int32_t row = 0; row < rows; ++row)
+		CPPUNIT_ASSERT(f[row] == (float)(9+10*row));
+
+	// The view is of the data in the DataSet, not a copy.
+	float first;
+	dataPlane->GetData(0, 8, first);
+	CPPUNIT_ASSERT(first == f[0]);
+
+	// Part of a short column.
+	CPPUNIT_ASSERT(dataPlane->GetDataView(3, 1, rows, view));
+	CPPUNIT_ASSERT(view.Count() == rows-1);
+	std::vector<int16_t> s(rows);
+	view.CopyTo(&s[0]);
+	for (int32_t row = 1; row < rows; ++row)
+		CPPUNIT_ASSERT(s[row-1] == (int16_t)(4+10*row));
+
+	// Wrong type and bad column.
+	std::vector<u_int16_t> us(rows);
+	CPPUNIT_ASSERT_THROW(view.CopyTo(&us[0]), affymetrix_calvin_exceptions::UnexpectedColumnTypeException);
+	CPPUNIT_ASSERT_THROW(dataPlane->GetDataView(9, 0, -1, view), affymetrix_calvin_exceptions::ColumnIndexOutOfBoundsException);
+
+	CPPUNIT_ASSERT_NO_THROW(dataPlane->Close());
+}
@@ -35,6 +35,8 @@ class DataSetTest_AllColumnTypes : public CPPUNIT_NS::TestFixture
 	CPPUNIT_TEST (testCreation);
 	CPPUNIT_TEST (testOpenDataSet);
 	CPPUNIT_TEST (testAccessColumnValues);
+	CPPUNIT_TEST (testAccessColumnVectors);
+	CPPUNIT_TEST (testAccessColumnViews);
 
 	CPPUNIT_TEST_SUITE_END();
 
@@ -48,6 +50,8 @@ public:
 	void testCreation();
 	void testOpenDataSet();
 	void testAccessColumnValues();
+	void testAccessColumnVectors();
+	void testAccessColumnViews();
 
 private:
 	affymetrix_calvin_io::GenericData* data;
@@ -0,0 +1,185 @@
+////////////////////////////////////////////////////////////////
+//
+// Copyright (C) 2011 Affymetrix, Inc.
+//
+// This library is free software; you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License 
+// (version 2.1) as published by the Free Software Foundation.
+// 
+// This library is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+// or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License
+// for more details.
+// 
+// You should have received a copy of the GNU Lesser General Public License
+// along with this library; if not, write to the Free Software Foundation, Inc.,
+// 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA 
+//
+////////////////////////////////////////////////////////////////
+
+
+//
+#include "calvin_files/data/test/DataSetTest_CelIntensities.h"
+//
+#include "calvin_files/data/src/CELData.h"
+#include "calvin_files/data/src/DataSet.h"
+#include "calvin_files/parsers/src/CelFileReader.h"
+#include "calvin_files/parsers/src/GenericFileReader.h"
+#include "calvin_files/writers/src/CalvinCelFileWriter.h"
+//
+#include <cstdio>
+#include <ctime>
+#include <iostream>
+#include <string>
+//
+
+using namespace std;
+using namespace affymetrix_calvin_io;
+
+// Axiom arrays have a bit under 7 million cells.
+#define AXIOM_ROWS 2600
+#define AXIOM_COLS 2600
+// Number of intensity columns read for the timing.
+#define COLUMNS_TO_READ 1000
+
+CPPUNIT_TEST_SUITE_REGISTRATION( DataSetTest_CelIntensities );
+
+/// Intensity written for a cell; exact in a float and different per cell.
+static float CellIntensity(int32_t cell)
+{
+	return (float)(cell % 65536) + 0.25f;
+}
+
+void DataSetTest_CelIntensities::setUp()
+{
+	celFileName = "DataSetTest_CelIntensities.CEL";
+	cellCount = AXIOM_ROWS*AXIOM_COLS;
+
+	CelFileData writerData(celFileName);
+	writerData.SetRows(AXIOM_ROWS);
+	writerData.SetCols(AXIOM_COLS);
+	writerData.SetIntensityCount(cellCount);
+	writerData.SetStdDevCount(cellCount);
+	writerData.SetPixelCount(cellCount);
+	writerData.SetOutlierCount(0);
+	writerData.SetMaskCount(0);
+	writerData.SetArrayType(L"Axiom_test");
+
+	CelFileWriter* writer = new CelFileWriter(writerData);
+	FloatVector v(cellCount);
+	for (int32_t cell = 0; cell < cellCount; ++cell)
+		v[cell] = CellIntensity(cell);
+	writer->WriteIntensities(v);
+	writer->WriteStdDevs(v);
+	Int16Vector pixels(cellCount, 9);
+	writer->WritePixels(pixels);
+	delete writer;
+}
+
+void DataSetTest_CelIntensities::tearDown()
+{
+	remove(celFileName.c_str());
+}
+
+DataSet* DataSetTest_CelIntensities::OpenIntensities(GenericData& data)
+{
+	GenericFileReader reader;
+	reader.SetFilename(celFileName);
+	reader.ReadHeader(data);
+	DataSet* dataSet = data.DataSet(0, 0);	// intensities are the first DataSet
+	CPPUNIT_ASSERT(dataSet);
+	CPPUNIT_ASSERT(dataSet->Open());
+	return dataSet;
+}
+
+void DataSetTest_CelIntensities::testReadIntensities()
+{
+	GenericData data;
+	DataSet* dataSet = OpenIntensities(data);
+	CPPUNIT_ASSERT(dataSet->Rows() == cellCount);
+
+	FloatVector v;
+	dataSet->GetData(0, 0, -1, v);
+	CPPUNIT_ASSERT((int32_t)v.size() == cellCount);
+
+	float* raw = new float[cellCount];
+	CPPUNIT_ASSERT(dataSet->GetDataRaw(0, 0, cellCount, raw) == cellCount);
+
+	DataSetColumnView view;
+	CPPUNIT_ASSERT(dataSet->GetDataView(0, 0, -1, view));
+	CPPUNIT_ASSERT(view.Count() == cellCount);
+	CPPUNIT_ASSERT(view.Stride() == sizeof(float));
+	float* viewed = new float[cellCount];
+	view.CopyTo(viewed);
+
+	for (int32_t cell = 0; cell < cellCount; ++cell)
+	{
+		CPPUNIT_ASSERT(v[cell] == CellIntensity(cell));
+		CPPUNIT_ASSERT(raw[cell] == CellIntensity(cell));
+		CPPUNIT_ASSERT(viewed[cell] == CellIntensity(cell));
+	}
+	// Spot check against the one value at a time access.
+	for (int32_t cell = 0; cell < cellCount; cell += 9973)
+	{
+		float f;
+		dataSet->GetData(cell, 0, f);
+		CPPUNIT_ASSERT(f == v[cell]);
+	}
+	delete[] raw;
+	delete[] viewed;
+	dataSet->Delete();
+
+	// And through the CEL file interface.
+	CelFileData cel(celFileName);
+	CelFileReader celReader;
+	celReader.SetFilename(celFileName);
+	celReader.Read(cel);
+	FloatVector celValues;
+	CPPUNIT_ASSERT(cel.GetIntensities(0, cellCount, celValues));
+	CPPUNIT_ASSERT(celValues == v);
+}
+
+void DataSetTest_CelIntensities::testReadIntensitiesTiming()
+{
+	GenericData data;
+	DataSet* dataSet = OpenIntensities(data);
+	float* values = new float[cellCount];
+	double sum = 0;
+
+	// One value at a time, as the element by element conversion did.
+	int32_t slowColumns = 5;
+	clock_t start = clock();
+	for (int32_t colIx = 0; colIx < slowColumns; ++colIx)
+	{
+		for (int32_t cell = 0; cell < cellCount; ++cell)
+			dataSet->GetData(cell, 0, values[cell]);
+		sum += values[colIx];
+	}
+	double perValue = (double)(clock() - start) / CLOCKS_PER_SEC / slowColumns;
+
+	start = clock();
+	for (int32_t colIx = 0; colIx < COLUMNS_TO_READ; ++colIx)
+	{
+		dataSet->GetDataRaw(0, 0, cellCount, values);
+		sum += values[colIx];
+	}
+	double raw = (double)(clock() - start) / CLOCKS_PER_SEC;
+
+	DataSetColumnView view;
+	start = clock();
+	for (int32_t colIx = 0; colIx < COLUMNS_TO_READ; ++colIx)
+	{
+		dataSet->GetDataView(0, 0, -1, view);
+		view.CopyTo(values);
+		sum += values[colIx];
+	}
+	double viewed = (double)(clock() - start) / CLOCKS_PER_SEC;
+	CPPUNIT_ASSERT(sum > 0);
+
+	cout << endl << "Read " << COLUMNS_TO_READ << " intensity columns of " << cellCount << " cells: "
+		<< "GetDataRaw " << raw << "s, GetDataView+CopyTo " << viewed << "s"
+		<< " (GetData one value at a time " << perValue * COLUMNS_TO_READ << "s estimated)" << endl;
+
+	delete[] values;
+	dataSet->Delete();
+}
@@ -0,0 +1,58 @@
+////////////////////////////////////////////////////////////////
+//
+// Copyright (C) 2011 Affymetrix, Inc.
+//
+// This library is free software; you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License 
+// (version 2.1) as published by the Free Software Foundation.
+// 
+// This library is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+// or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License
+// for more details.
+// 
+// You should have received a copy of the GNU Lesser General Public License
+// along with this library; if not, write to the Free Software Foundation, Inc.,
+// 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA 
+//
+////////////////////////////////////////////////////////////////
+
+
+#ifndef __DATASETTEST_CELINTENSITIES_H_
+#define __DATASETTEST_CELINTENSITIES_H_
+
+#include "calvin_files/data/src/GenericData.h"
+//
+#include <cppunit/extensions/HelperMacros.h>
+//
+#include <string>
+//
+
+/*
+ * This tests and times reading the intensity column of an Axiom sized CEL file.
+ */
+class DataSetTest_CelIntensities : public CPPUNIT_NS::TestFixture  
+{
+	CPPUNIT_TEST_SUITE(DataSetTest_CelIntensities);
+
+	CPPUNIT_TEST (testReadIntensities);
+	CPPUNIT_TEST (testReadIntensitiesTiming);
+
+	CPPUNIT_TEST_SUITE_END();
+
+public:
+	void setUp();
+	void tearDown();
+
+	void testReadIntensities();
+	void testReadIntensitiesTiming();
+
+private:
+	/*! Open the intensity DataSet of the CEL file written by setUp. */
+	affymetrix_calvin_io::DataSet* OpenIntensities(affymetrix_calvin_io::GenericData& data);
+
+	std::string celFileName;
+	int32_t cellCount;
+};
+
+#endif // __DATASETTEST_CELINTENSITIES_H_
@@ -135,6 +135,25 @@ public:
 	*/
 	static float ReadFloat(char * &instr);
 
+	/*! Converts count big endian values from a memory buffer (memory map pointer) into
+	* host order in values. Consecutive values are stride bytes apart in the buffer, which
+	* is sizeof(value) for a one column DataSet and the row size otherwise. The buffer
+	* need not be aligned. When stride is the value size the loop is a plain byte swap
+	* which the compiler can vectorize.
+	*
+	* @param instr The start of the first value.
+	* @param count The number of values to convert.
+	* @param stride The number of bytes from one value to the next.
+	* @param values Where to write the count values.
+	*/
+	static void ReadInt8Array(const char *instr, int32_t count, int32_t stride, int8_t *values);
+	static void ReadUInt8Array(const char *instr, int32_t count, int32_t stride, u_int8_t *values);
+	static void ReadInt16Array(const char *instr, int32_t count, int32_t stride, int16_t *values);
+	static void ReadUInt16Array(const char *instr, int32_t count, int32_t stride, u_int16_t *values);
+	static void ReadInt32Array(const char *instr, int32_t count, int32_t stride, int32_t *values);
+	static void ReadUInt32Array(const char *instr, int32_t count, int32_t stride, u_int32_t *values);
+	static void ReadFloatArray(const char *instr, int32_t count, int32_t stride, float *values);
+
 	/*! Reads a 16 bit unicode string of fixed size from a big endian file.
 	*
 	* @param instr The input file stream.
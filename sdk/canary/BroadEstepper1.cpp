@@ -33,9 +33,9 @@
 
 
 BroadEstepper1::BroadEstepper1(CanaryOptions& opts,
-                               valarray<double> vals_in,
-                               CanaryPrior & prior_in,
-                               vector<int> & clusters_in)
+                               const valarray<double> & vals_in,
+                               const CanaryPrior & prior_in,
+                               const vector<int> & clusters_in)
   : _opts(opts)
   {
   N = vals_in.size();
@@ -46,6 +46,7 @@ BroadEstepper1::BroadEstepper1(CanaryOptions& opts,
   _prop.resize(G,1.0/G);
   _mean.resize(G);
   _var.resize(G);
+  _work.resize(G);
 
   for (unsigned int k=0; k<G; k++)
     {
@@ -53,12 +54,11 @@ BroadEstepper1::BroadEstepper1(CanaryOptions& opts,
 //  The algorithm converges to a cycle dependent on initial values.  If it
 //  converged to a point - as it should - it would make sense to uncomment.
 //    _prop[k] = _prior.prop()[cpos];
-    _mean[k] = _prior.mean()[cpos];
-    _var[k] = _prior.var()[cpos];
+    _mean[k] = _prior.mean(cpos);
+    _var[k] = _prior.var(cpos);
     }
 
-  _prob.ReSize(N,G);
-  _prob = 0.0;
+  _prob.resize(N*G,0.0);
 
   update_prob();
   }
@@ -68,7 +68,6 @@ BroadEstepper1::BroadEstepper1(CanaryOptions& opts)
   {
   N=0;
   G=0;
-  _prob.ReSize(0,0);
   }
 
 BroadEstepper1::BroadEstepper1(const BroadEstepper1 & BE)
@@ -82,17 +81,17 @@ BroadEstepper1::BroadEstepper1(const BroadEstepper1 & BE)
   _prop.resize(G); _prop = BE._prop;
   _mean.resize(G); _mean = BE._mean;
   _var.resize(G); _var = BE._var;
+  _work.resize(G);
   //
-  _prob.ReSize(N,G);
-  _prob = BE._prob;
+  _prob.resize(N*G); _prob = BE._prob;
   }
 
+// _opts is a reference and can not be reseated; every instance in a run
+// shares the one set of options, so it is left alone here.
 BroadEstepper1 & BroadEstepper1::operator=(const BroadEstepper1 & BE)
   {
   if (this == &BE) return *this;
   //
-  this->_opts=BE._opts;
-  //
   this->N = BE.N;
   this->G = BE.G;
   this->_vals.resize(this->N); this->_vals = BE._vals;
@@ -101,13 +100,23 @@ BroadEstepper1 & BroadEstepper1::operator=(const BroadEstepper1 & BE)
   this->_prop.resize(this->G); this->_prop = BE._prop;
   this->_mean.resize(this->G); this->_mean = BE._mean;
   this->_var.resize(this->G); this->_var = BE._var;
-  this->_prob.ReSize(N,G);
-  this->_prob = BE._prob;
+  this->_work.resize(this->G);
+  this->_prob.resize(N*G); this->_prob = BE._prob;
 
   return *this;
   }
 
 
+Matrix BroadEstepper1::prob() const
+  {
+  Matrix prob_mat(N,G);
+  for (unsigned long i=0; i<N; i++)
+    for (unsigned long k=0; k<G; k++)
+      prob_mat.element(i,k) = _prob[i*G + k];
+  return prob_mat;
+  }
+
+
 void BroadEstepper1::update_broad()
   {
   update_prop_broad();
@@ -119,12 +128,14 @@ void BroadEstepper1::update_broad()
 
 void BroadEstepper1::update_prop_broad()
   {
-  double sum_prob = _prob.Sum();
+  // summed in the order of newmat's Matrix::Sum()
+  double sum_prob = 0.0;
+  for (unsigned long ik=0; ik<N*G; ik++) sum_prob += _prob[ik];
 
   for (int k=0; k<G; k++)
     {
     double sum_k=0.0;
-    for (int i=0; i<N; i++) sum_k += _prob.element(i,k);
+    for (unsigned long i=0; i<N; i++) sum_k += _prob[i*G + k];
     _prop[k] = sum_k/sum_prob;
     }
   }
@@ -133,26 +144,26 @@ void BroadEstepper1::update_prop_broad()
 void BroadEstepper1::update_mean_broad()
   {
   int PPF=_opts.tune_pseudopoint_factor; 
-  valarray<double>pmean(G);
-  for (int k=0; k<G; k++) pmean[k] = _prior.mean(_cvec[k]);
   int num_pseudopoints = int(N/PPF);
   if (!num_pseudopoints) num_pseudopoints = 1;
-  valarray<double>xmean(0.0,G);
+  // _work holds the data mean of each cluster
+  _work = 0.0;
 
   for (int k=0; k<G; k++)
     {
     double kwsum=0.0, wsum=0.0;
     for (int i=0; i<N; i++)
       {
-      kwsum += _vals[i]*_prob.element(i,k);
-      wsum += _prob.element(i,k);
-      if (wsum > 0.0) xmean[k] = kwsum/wsum;
+      kwsum += _vals[i]*_prob[i*G + k];
+      wsum += _prob[i*G + k];
+      if (wsum > 0.0) _work[k] = kwsum/wsum;
       }
     }
 
   for (int k=0; k<G; k++)
     {
-    _mean[k] = xmean[k]*N*_prop[k] + pmean[k]*num_pseudopoints;
+    double pmean = _prior.mean(_cvec[k]);
+    _mean[k] = _work[k]*N*_prop[k] + pmean*num_pseudopoints;
     _mean[k] /= N*_prop[k] + num_pseudopoints;
     }
   }
@@ -160,24 +171,26 @@ void BroadEstepper1::update_mean_broad()
 
 void BroadEstepper1::update_var_broad()
   {
-  valarray<double>xvar(0.0,G);
-
+  // _work holds the data variance of each cluster
   for (int k=0; k<G; k++)
     {
     double kwsum=0.0, wsum=0.0;
     for (int i=0; i<N; i++)
       {
       double diff = _vals[i] - _mean[k];
-      kwsum += _prob.element(i,k)*diff*diff;
-      wsum += _prob.element(i,k);
+      kwsum += _prob[i*G + k]*diff*diff;
+      wsum += _prob[i*G + k];
       }
-    if (wsum > 0.0) xvar[k] = kwsum/wsum;
-    else xvar[k] = _opts.tune_min_cluster_variance;
+    if (wsum > 0.0) _work[k] = kwsum/wsum;
+    else _work[k] = _opts.tune_min_cluster_variance;
     }
 
-  double mean_var = xvar.sum()/xvar.size();
+  double var_sum = 0.0;
+  for (unsigned long k=0; k<G; k++) var_sum += _work[k];
+  double mean_var = var_sum/G;
   double reg_weight = _opts.tune_regularize_variance_factor;
-  _var = reg_weight*mean_var + (1.0 - reg_weight)*xvar;
+  for (unsigned long k=0; k<G; k++)
+    _var[k] = reg_weight*mean_var + (1.0 - reg_weight)*_work[k];
   }
 
 
@@ -185,26 +198,25 @@ void BroadEstepper1::update_prob()
   {
   for (int i=0; i<N; i++)
     {
-    valarray<double>xprobs(0.0,G);
+    double sum_probs = 0.0;
     for (int k=0; k<G; k++)
       {
       double diff = _vals[i] - _mean[k];
-      xprobs[k] = _prop[k]*exp(-0.5*diff*diff/_var[k])/sqrt(_var[k]);
+      _work[k] = _prop[k]*exp(-0.5*diff*diff/_var[k])/sqrt(_var[k]);
+      sum_probs += _work[k];
       }
 
-    double sum_probs = xprobs.sum();
-
     // just in case all clusters are very unlikely
     if (sum_probs < 1e-10)
-      for (int k=0; k<G; k++) _prob.element(i,k) = 1.0/G;
+      for (unsigned long k=0; k<G; k++) _prob[i*G + k] = 1.0/G;
 
     else for (int k=0; k<G; k++)
-        _prob.element(i,k) = xprobs[k]/sum_probs;
+        _prob[i*G + k] = _work[k]/sum_probs;
     }
   }
 
 
-double BroadEstepper1::log_likelihood()
+double BroadEstepper1::log_likelihood() const
   {
   double log_likelihood_sum = 0.0;
 
@@ -231,7 +243,7 @@ double BroadEstepper1::log_likelihood()
   }
 
 //vector<pair<int,double> > BroadEstepper1::confidences()
-vector<double> BroadEstepper1::confidences()
+vector<double> BroadEstepper1::confidences() const
   {
   double norm_const = 1.0/sqrt(2.0*M_PI);
 //  vector<pair<int,double> >ret_vec;
@@ -264,7 +276,7 @@ vector<double> BroadEstepper1::confidences()
 
 
 // Just assigns the sample point to the cluster of highest probability
-vector<int> BroadEstepper1::assignments()
+vector<int> BroadEstepper1::assignments() const
   {
   vector<int> ret_vec;
   for (unsigned int i=0; i<N; i++)
@@ -274,10 +286,10 @@ vector<int> BroadEstepper1::assignments()
 
     for (unsigned int k=0; k<_cvec.size(); k++)
       {
-      if (_prob.element(i,k) > best_prob)
+      if (_prob[i*G + k] > best_prob)
         {
         best_clust = _cvec[k];
-        best_prob = _prob.element(i,k);
+        best_prob = _prob[i*G + k];
         }
       }
       ret_vec.push_back(best_clust);
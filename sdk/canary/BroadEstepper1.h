@@ -37,7 +37,8 @@
     Canary from Birdsuite version 1.3.  For a set of points, each model
     in the model selection scheme will require a BroadEstepper1 instance.
     General idea is to use an instance to update parameter estimates
-    by executing the member update_broad().
+    by executing the member update_broad(), which updates the proportions,
+    means, variances and probabilities in place.
  */
 
 class BroadEstepper1 {
@@ -50,9 +51,9 @@ public:
  */
 
   BroadEstepper1(CanaryOptions& opts,
-                 valarray<double> vals_in,
-                 CanaryPrior & prior_in,
-                 vector<int> & clusters_in);
+                 const valarray<double> & vals_in,
+                 const CanaryPrior & prior_in,
+                 const vector<int> & clusters_in);
 
   /// Default constructor
   BroadEstepper1(CanaryOptions& opts);
@@ -63,47 +64,47 @@ public:
   /// Assignment
   BroadEstepper1 & operator=(const BroadEstepper1 & BE);
 
-  /// @return copy of the data
-  valarray<double> vals() { return _vals; }
+  /// @return the data
+  const valarray<double>& vals() const { return _vals; }
 
-  /// @return copy of the prior
-  CanaryPrior prior() { return _prior; }
+  /// @return the prior
+  const CanaryPrior& prior() const { return _prior; }
 
   /// @return numeric cluster labels
-  vector<int> cvec() { return _cvec; }
+  const vector<int>& cvec() const { return _cvec; }
 
-  /// @return copy of the proportions of cluster memberships
-  valarray<double> prop() { return _prop; }
+  /// @return the proportions of cluster memberships
+  const valarray<double>& prop() const { return _prop; }
 
   /// @return value of kth member of cluster memberships
-  double prop(int k) { return _prop[k]; }
+  double prop(int k) const { return _prop[k]; }
 
   /// Breaks encapsulation to assign proportions of cluster memberships
-  void prop(valarray<double> prop_in) { _prop = prop_in; }
+  void prop(const valarray<double>& prop_in) { _prop = prop_in; }
 
-  /// @return copy of cluster means
-  valarray<double> mean() { return _mean; }
+  /// @return cluster means
+  const valarray<double>& mean() const { return _mean; }
 
   /// @return value of kth cluster mean
-  double mean(int k) { return _mean[k]; }
+  double mean(int k) const { return _mean[k]; }
 
   /// Breaks encapsulation to assign cluster means
-  void mean(valarray<double> mean_in) { _mean = mean_in; }
+  void mean(const valarray<double>& mean_in) { _mean = mean_in; }
 
-  /// @return copy of cluster variances
-  valarray<double> var() { return _var; }
+  /// @return cluster variances
+  const valarray<double>& var() const { return _var; }
 
   /// @return value of kth cluster variance
-  double var(int k) { return _var[k]; }
+  double var(int k) const { return _var[k]; }
 
   /// Breaks encapsulation to assign cluster variances
-  void var(valarray<double> var_in) { _var = var_in; }
+  void var(const valarray<double>& var_in) { _var = var_in; }
 
   /// @return matrix of probabilities of cluster memberships
   /** (row,col) <=> (i,j) <=> (sample,cluster)
       probability that sample i belongs to cluster j
    */
-  Matrix prob() { return _prob; }
+  Matrix prob() const;
 
 //herehere
   void update_broad();
@@ -111,9 +112,9 @@ public:
   void update_mean_broad();
   void update_var_broad();
   void update_prob();
-  double log_likelihood();
-  vector<double> confidences();
-  vector<int> assignments();
+  double log_likelihood() const;
+  vector<double> confidences() const;
+  vector<int> assignments() const;
 
 private:
   unsigned long N;
@@ -124,7 +125,11 @@ private:
   valarray<double> _prop;
   valarray<double> _mean;
   valarray<double> _var;
-  Matrix _prob;
+  // (sample,cluster) probabilities, N rows of G.  Not a newmat Matrix, as
+  // newmat is not thread safe and regions are fit on several threads.
+  valarray<double> _prob;
+  // G values of scratch space for the E and M steps.
+  valarray<double> _work;
   CanaryOptions& _opts;
 };
 
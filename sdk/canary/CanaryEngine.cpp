@@ -36,10 +36,12 @@
 #include "chipstream/SparseMart.h"
 #include "file/TsvFile/TsvFile.h"
 #include "util/Fs.h"
+#include "util/Thread.h"
 #include "util/Util.h"
 //
 #include "newmat.h"
 //
+#include <algorithm>
 #include <cmath>
 #include <cstdio>
 #include <cstring>
@@ -98,6 +100,7 @@ void CanaryEngine::fillInOptions(CanaryOptions &o) {
     o.setAnalysisName = getOpt("analysis-name");
     o.ccMDChpOutput = getOptBool("cc-chp-output");
     o.tableOutput = getOptBool("table-output");
+    o.threads = getOptInt("threads");
 
     o.chipType = getOpt("chip-type");
 
@@ -223,6 +226,10 @@ void CanaryEngine::defineOptions() {
 
     defineOption("", "precision", PgOpt::INT_OPT,
                  "Precision after decimal place", "4");
+    defineOption("", "threads", PgOpt::INT_OPT,
+                 "Number of CNV regions to fit at the same time, each on its own thread. "
+                 "0 means one thread per cpu. Output is the same for any number of threads.",
+                 "1");
 
     defineOption("", "analysis-name", PgOpt::STRING_OPT,
                  "Set the name of the analysis.", "");
@@ -903,6 +910,73 @@ void CanaryEngine::writeCnvSummaries(CanaryOptions &opts,
     cnvdatafile.close();
 }
 
+/*
+ *  Fit the canary models to one CNV region and make its calls and
+ *  confidences, one per sample.
+ */
+static void callCnvRegion(CanaryOptions &opts, valarray<double> &vals,
+                          CanaryPrior &CP, int *calls, double *confidences) {
+    CanaryWithPrior CWP(opts,vals,CP);
+
+    string best_model = CWP.best_fit();
+
+    pair<string,BroadEstepper1> model_pair(best_model,CWP.fitted_values(best_model));
+
+    BroadEstepper1 newBE = directional_impute(opts,model_pair,CP);
+
+    // tweak the variances
+
+    valarray<double>newbevars = newBE.var();
+    //OPTIONS
+    double vartweak = newbevars.sum()/newbevars.size();
+    double varshare = opts.tune_regularize_variance_factor;
+
+//	newbevars = 0.6*newbevars + 0.4*vartweak;
+    newbevars = (1.0 - varshare)*newbevars + varshare*vartweak;
+    newBE.var(newbevars);
+    newBE.update_prob();
+
+    vector<double> region_confidences = newBE.confidences();
+    vector<int> assignments = newBE.assignments();
+    copy(region_confidences.begin(),region_confidences.end(),confidences);
+    copy(assignments.begin(),assignments.end(),calls);
+}
+
+/*
+ *  Calls the CNV regions on several threads, one region at a time. Each
+ *  region writes to its own rows of the calls and confidences, so the
+ *  results do not depend on the threads.
+ */
+class CanaryRegionTask : public WorkQueueTask {
+    public:
+        CanaryRegionTask(CanaryOptions &opts, const vector<double> &intensities,
+                         vector<CanaryPrior> &priors, int sampleCount,
+                         vector<int> &calls, vector<double> &confidences) :
+            WorkQueueTask((int)priors.size()),
+            m_opts(opts), m_intensities(intensities), m_priors(priors),
+            m_sampleCount(sampleCount), m_calls(calls), m_confidences(confidences) {
+        }
+
+        virtual void runItems(int threadIx, int start, int count) {
+            valarray<double> vals(m_sampleCount);
+            for (int region=start; region<start+count; region++) {
+                size_t offset = (size_t)region*m_sampleCount;
+                for (int k=0; k<m_sampleCount; k++)
+                    vals[k] = m_intensities[offset + k];
+                callCnvRegion(m_opts,vals,m_priors[region],
+                              &m_calls[offset],&m_confidences[offset]);
+            }
+        }
+
+    private:
+        CanaryOptions &m_opts;
+        const vector<double> &m_intensities;
+        vector<CanaryPrior> &m_priors;
+        int m_sampleCount;
+        vector<int> &m_calls;
+        vector<double> &m_confidences;
+};
+
 /*
  *  The main function for computing canary.
  */
@@ -915,78 +989,57 @@ void CanaryEngine::mainCanary(CanaryOptions &opts,
                               vector<string> &cnv_region_names) {
     string cnvdatafilename = Fs::join(opts.outDir,opts.setAnalysisName + ".cnv_region_summary.txt");
 
+    // The CNV intensity data, by region id. The ids follow the region names
+    // in sorted order, which is the order the regions are written in.
     Verbose::out(1,"Loading up CNV region signals");
-    pair<list<string>,map<string,valarray<double> > >
-        intensity_pair = load_broad_intensity_map(cnvdatafilename);
-
-    // The CNV intensity data
-    map<string,valarray<double> > intensity_map = intensity_pair.second;
+    list<string> sample_names;
+    vector<string> region_names;
+    vector<double> intensities;
+    load_broad_intensity_table(cnvdatafilename,sample_names,region_names,intensities);
+    int nsamples = (int)sample_names.size();
+    map<string,int> region_ids;
+    for (size_t r=0; r<region_names.size(); r++)
+        region_ids[region_names[r]] = (int)r;
 
     Verbose::out(1,"Loading up CNV region priors");
-    map<string,CanaryPrior> prior_map =
-        load_broad_prior_map(opts.canaryPriorFile);
+    vector<CanaryPrior> priors(region_names.size());
+    {
+        map<string,CanaryPrior> prior_map =
+            load_broad_prior_map(opts.canaryPriorFile);
+        for (size_t r=0; r<region_names.size(); r++)
+            priors[r] = prior_map[region_names[r]];
+    }
 
-    map<string,vector<int> > call_map;
-    map<string,vector<double> > confidence_map;
+    vector<int> calls(intensities.size());
+    vector<double> confidences(intensities.size());
 
     // Go through all of the CNV regions
-    Verbose::out(1,"Processing CNV regions");
     ///@todo process in same order as the regions file -- rather than the order returned by map
-    for (map<string,valarray<double> >::iterator iter=intensity_map.begin();
-         iter!=intensity_map.end(); iter++) {
-        string cnv_region = iter->first;
-//herehere
-//		if (cnv_region != "CNP1682") continue; // handy for isolating a CNV
-//		if (cnv_region != "CNP12034") continue; // handy for isolating a CNV
-//		if (cnv_region != "CNP10276") continue; // handy for isolating a CNV
-
-        CanaryPrior CP = prior_map[cnv_region];
-        valarray<double>vals = intensity_map[cnv_region];
-        CanaryWithPrior CWP(opts,vals,CP);
-
-        string best_model = CWP.best_fit();
-
-        BroadEstepper1 best_model_BE = CWP.fitted_values(best_model);
-        valarray<double>bmeans = best_model_BE.mean();
-
-        vector<double>confidences =
-            CWP.fitted_values(best_model).confidences();
-
-        pair<string,BroadEstepper1> model_pair(best_model,best_model_BE);
-
-        BroadEstepper1 newBE = directional_impute(opts,model_pair,CP);
-
-        // tweak the variances
-
-        valarray<double>newbevars = newBE.var();
-        //OPTIONS
-        double vartweak = newbevars.sum()/newbevars.size();
-        double varshare = opts.tune_regularize_variance_factor;
-
-//		newbevars = 0.6*newbevars + 0.4*vartweak;
-        newbevars = (1.0 - varshare)*newbevars + varshare*vartweak;
-        newBE.var(newbevars);
-        newBE.update_prob();
-
-//		confidences = newBE.confidences();
-        confidence_map[cnv_region] = newBE.confidences();
-        vector<int> assignments = newBE.assignments();
-        call_map[cnv_region] = assignments;
-    }
+    int threadCount = ThreadGroup::resolveThreadCount(opts.threads);
+    if (threadCount > (int)region_names.size())
+        threadCount = max(1,(int)region_names.size());
+    Verbose::out(1,"Processing " + ToStr(region_names.size()) + " CNV regions on " +
+                 ToStr(threadCount) + " threads");
+    time_t startTime = time(NULL);
+    CanaryRegionTask task(opts,intensities,priors,nsamples,calls,confidences);
+    task.run(threadCount);
+    time_t runTime = time(NULL) - startTime;
+    Verbose::out(1,"Processed " + ToStr(region_names.size()) + " CNV regions in " +
+                 ToStr((int)runTime) + " seconds" +
+                 (runTime > 0 ? " (" + ToStr((double)region_names.size()/(double)runTime) + " regions/sec)" : ""));
 
     if (opts.ccMDChpOutput || opts.tableOutput) {
         Verbose::out(1,"Generating output file(s).");
 
         int nregions = 0;
         for (int i=0; i<cnv_region_names.size(); i++)
-            if (intensity_map.find(cnv_region_names[i]) != intensity_map.end()) 
+            if (region_ids.find(cnv_region_names[i]) != region_ids.end()) 
                 nregions++;
 
         int max_rlen = 0;
-        for (map<string,valarray<double> >::iterator iter=intensity_map.begin();
-             iter!=intensity_map.end(); iter++) {
-            if (iter->first.size() > max_rlen) 
-                max_rlen = (int)iter->first.size();
+        for (size_t r=0; r<region_names.size(); r++) {
+            if ((int)region_names[r].size() > max_rlen) 
+                max_rlen = (int)region_names[r].size();
         }
    
 
@@ -1046,8 +1099,8 @@ void CanaryEngine::mainCanary(CanaryOptions &opts,
             cidx++;
 
             // remaining columns labelled by cel files
-            for (list<string>::iterator iter=intensity_pair.first.begin();      
-                 iter!=intensity_pair.first.end(); iter++){
+            for (list<string>::iterator iter=sample_names.begin();      
+                 iter!=sample_names.end(); iter++){
                 tsvCall.defineColumn(0,cidx,*iter,affx::TSV_TYPE_UNKNOWN);
                 tsvConf.defineColumn(0,cidx,*iter,affx::TSV_TYPE_UNKNOWN);
                 tsvConf.setPrecision(0,cidx,opts.precision);
@@ -1078,16 +1131,16 @@ void CanaryEngine::mainCanary(CanaryOptions &opts,
             }
 
             ///@todo process in same order as the regions file -- rather than the order returned by map
-            for (map<string,valarray<double> >::iterator iter=intensity_map.begin();
-                 iter!=intensity_map.end(); iter++) {
+            for (size_t r=0; r<region_names.size(); r++) {
                 // give the CNP name
-                tsvCall.set(0,0,iter->first);
-                tsvConf.set(0,0,iter->first);
+                tsvCall.set(0,0,region_names[r]);
+                tsvConf.set(0,0,region_names[r]);
                 
                 // give the calls or confidences for the CNP
+                size_t offset = r*nsamples;
                 for (int i=0; i<opts.celFiles.size(); i++) {
-                    tsvCall.set(0,i+1,(unsigned char)call_map[iter->first][i]);
-                    tsvConf.set(0,i+1,(float)confidence_map[iter->first][i]);
+                    tsvCall.set(0,i+1,(unsigned char)calls[offset + i]);
+                    tsvConf.set(0,i+1,(float)confidences[offset + i]);
                 }
                 
                 // write them out
@@ -1165,12 +1218,14 @@ void CanaryEngine::mainCanary(CanaryOptions &opts,
                     writer.SeekToDataSet(CopyNumberVariationMultiDataType);
    
                     for (int i=0; i<cnv_region_names.size(); i++) {
-                        if (intensity_map.find(cnv_region_names[i]) != intensity_map.end()) {
+                        map<string,int>::iterator region = region_ids.find(cnv_region_names[i]);
+                        if (region != region_ids.end()) {
+                            size_t offset = (size_t)region->second*nsamples;
                             ProbeSetMultiDataCopyNumberVariationRegionData entry;
                             entry.name = cnv_region_names[i];
-                            entry.signal = intensity_map[cnv_region_names[i]][k];
-                            entry.call = (unsigned char)call_map[cnv_region_names[i]][k];
-                            entry.confidenceScore = (float)confidence_map[cnv_region_names[i]][k];
+                            entry.signal = intensities[offset + k];
+                            entry.call = (unsigned char)calls[offset + k];
+                            entry.confidenceScore = (float)confidences[offset + k];
     
                             writer.WriteEntry(entry);
                         }
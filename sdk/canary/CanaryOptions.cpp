@@ -38,6 +38,7 @@ CanaryOptions::CanaryOptions()
   verbosity = 1;
   force = false;
   blockSize = 0;
+  threads = 1;
   precision = 6;
   ccMDChpOutput = true;
   tableOutput = false;
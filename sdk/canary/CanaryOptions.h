@@ -59,6 +59,7 @@ public:
   bool ccMDChpOutput;
   std::string progName;
   int blockSize;
+  int threads;                   // CNV regions fit at the same time.
   std::string version;
   std::string cvsId;
   std::string commandLine;
@@ -71,8 +71,10 @@ CanaryWithPrior::CanaryWithPrior(CanaryOptions& opts,
     {
     string model_name = _canary_model(k);
     vector<int>cvec = _canary_model[model_name];
-    BroadEstepper1 BE = gmm_withprior(_vals,cvec);
-    BE_map.insert(std::pair<std::string,BroadEstepper1>(model_name,BE));
+    // fit in the map's own copy rather than copying the fitted model in
+    BroadEstepper1& BE = BE_map.insert(std::pair<std::string,BroadEstepper1>
+      (model_name,BroadEstepper1(_opts,_vals,_prior,cvec))).first->second;
+    fit_withprior(BE);
 
     CanaryPenalty CP = assay_fit(BE,cvec);
 //	printf("%-8s %8.1f %5.1f %8.1f %8.1f %5.3f %20.17f %7.1f\n",
@@ -114,15 +116,21 @@ string CanaryWithPrior::best_fit()
   
 
 
-BroadEstepper1 CanaryWithPrior::gmm_withprior(valarray<double> vals,
-      vector<int> cluster_vec)
+BroadEstepper1 CanaryWithPrior::gmm_withprior(const valarray<double>& vals,
+      const vector<int>& cluster_vec)
+  {
+  BroadEstepper1 BE(_opts,vals,_prior,cluster_vec);
+  fit_withprior(BE);
+  return BE;
+  }
+
+
+void CanaryWithPrior::fit_withprior(BroadEstepper1& BE)
   {
   int MIN_ITER = 10;
   int MAX_ITER = 100;
   double LOGLIK_THRESHOLD = 0.01;
 
-  BroadEstepper1 BE(_opts,vals,_prior,cluster_vec);
-
   double old_loglik=0.0;
   int iterations = 0;
   while(1)
@@ -140,13 +148,11 @@ BroadEstepper1 CanaryWithPrior::gmm_withprior(valarray<double> vals,
     if (iterations == MAX_ITER) break;
     if (delta_loglik < LOGLIK_THRESHOLD) break;
     }
-
-  return BE;
   }
 
 
-CanaryPenalty CanaryWithPrior::assay_fit(BroadEstepper1 BE,
-                                         vector<int> cluster_vec)
+CanaryPenalty CanaryWithPrior::assay_fit(const BroadEstepper1& BE,
+                                         const vector<int>& cluster_vec)
   {
   unsigned long N = BE.vals().size();
   unsigned long G = cluster_vec.size();
@@ -41,17 +41,17 @@ public:
                   std::valarray<double>& vals_in,
                   CanaryPrior& prior_in);
 
-  valarray<double> vals() { return _vals; }
-  CanaryPrior prior() { return _prior; }
+  const valarray<double>& vals() const { return _vals; }
+  const CanaryPrior& prior() const { return _prior; }
 
   CanaryPenalty penalty(std::string model_name) {
     return CP_map[model_name]; 
     }
 
-  BroadEstepper1 fitted_values(std::string model_name) {
+  const BroadEstepper1& fitted_values(const std::string& model_name) const {
     // cant say this as it creates a BroadEstepper1 if the model name isnt found.
     //return BE_map[model_name];
-    std::map<std::string,BroadEstepper1>::iterator i;
+    std::map<std::string,BroadEstepper1>::const_iterator i;
     i=BE_map.find(model_name);
     if (i==BE_map.end()) {
       Err::errAbort("Didnt find entry for model: '" + model_name + "'");
@@ -59,14 +59,18 @@ public:
     return i->second;
   }
 
-  BroadEstepper1 gmm_withprior(valarray<double> vals,
-      std::vector<int> cluster_vec);
+  BroadEstepper1 gmm_withprior(const valarray<double>& vals,
+      const std::vector<int>& cluster_vec);
 
-  CanaryPenalty assay_fit(BroadEstepper1 BE,std::vector<int> cluster_vec);
+  CanaryPenalty assay_fit(const BroadEstepper1& BE,
+      const std::vector<int>& cluster_vec);
 
   std::string best_fit();
 
 private:
+  // Runs the EM iterations on BE in place.
+  void fit_withprior(BroadEstepper1& BE);
+
   valarray<double>_vals;
   CanaryPrior _prior;
   std::map<std::string,CanaryPenalty>CP_map;
@@ -27,6 +27,7 @@
 #include "file/TsvFile/TsvFile.h"
 #include "stats/stats-distributions.h"
 //
+#include <algorithm>
 #include <cfloat> // for FLT_MIN
 //
 using namespace affx;
@@ -93,6 +94,62 @@ load_broad_intensity_map(string ifname)
   }
 
 
+void load_broad_intensity_table(string ifname, list<string>& sample_names,
+                                vector<string>& region_names,
+                                vector<double>& intensities)
+  {
+  sample_names.clear();
+  region_names.clear();
+  intensities.clear();
+
+  // Open the ascii tab delimited input file
+  TsvFile infile;
+  if(infile.openTable(ifname) != TSV_OK)
+      Err::errAbort("Unable to open intensity map file '" + ifname + "'");
+
+  // Retrieve the set of column names - no error checking for now
+  infile.nextLevel(0);
+  for (int k=1; k<infile.getColumnCount(infile.lineLevel()); k++)
+    {
+    string column_str;
+    infile.get(infile.lineLevel(),k,column_str);
+    sample_names.push_back(column_str);
+    }
+  unsigned long ncol=sample_names.size();
+
+  // Rows as they are read, and the last row read for each region; a region
+  // listed twice keeps its last row, as it does in the map.
+  vector<double> rows;
+  map<string,unsigned long> region_row;
+  unsigned long nrow = 0;
+  while(infile.nextLevel(0)==TSV_OK)
+    {
+    string cnv_region;
+    double intensity;
+    infile.get(infile.lineLevel(),0,cnv_region);
+    for (unsigned long k=1; k<=ncol; k++)
+      {
+      infile.get(infile.lineLevel(),k,intensity);
+      rows.push_back(intensity);
+      }
+    region_row[cnv_region] = nrow++;
+    }
+
+  infile.close();
+
+  region_names.reserve(region_row.size());
+  intensities.resize(region_row.size()*ncol);
+  vector<double>::iterator out = intensities.begin();
+  for (map<string,unsigned long>::iterator iter=region_row.begin();
+       iter!=region_row.end(); iter++)
+    {
+    region_names.push_back(iter->first);
+    vector<double>::iterator row = rows.begin() + iter->second*ncol;
+    out = copy(row,row + ncol,out);
+    }
+  }
+
+
 map<string,CanaryPrior>
 load_broad_prior_map(string ifname)
   {
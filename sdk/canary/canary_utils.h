@@ -37,6 +37,13 @@
 pair<list<string>,map<string,valarray<double> > >
   load_broad_intensity_map(string ifname);
 
+// Same file as load_broad_intensity_map, with the regions held by region id:
+// region_names sorted as the map's keys, and the intensities of region i at
+// [i*ncol, (i+1)*ncol) where ncol is the number of sample names.
+void load_broad_intensity_table(string ifname, list<string>& sample_names,
+                                vector<string>& region_names,
+                                vector<double>& intensities);
+
 map<string,CanaryPrior> load_broad_prior_map(string ifname);
 
 double hardy_weinberg(vector<int> cluster_vec,valarray<double> props);
@@ -48,6 +48,7 @@ const char *chpFiles[] = {
 //Function Forward Declaration
 RT_Test* defineDoChpFiles();
 RT_Test* defineDoChpFilesDefault();
+RT_Test* defineDoChpFilesThreads();
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////
 //Main Function
@@ -67,6 +68,7 @@ int main(int argc, char* argv[])
   std::vector<std::string> testNameList;
   testNameList.push_back("doChpFiles");
   testNameList.push_back("doChpFilesDefault");
+  testNameList.push_back("doChpFilesThreads");
   rMain->setTestNameList(testNameList);
 
   ///Set Variables for this test environment
@@ -83,6 +85,7 @@ int main(int argc, char* argv[])
       cout<<"Running All Default Regression Tests"<<endl;
       rMain->addTest(defineDoChpFiles());
       rMain->addTest(defineDoChpFilesDefault());
+      rMain->addTest(defineDoChpFilesThreads());
     }
   //Parse the argv and run specified tests/options
   else
@@ -99,6 +102,10 @@ int main(int argc, char* argv[])
 	{
 	  rMain->addTest(defineDoChpFilesDefault());
 	}
+      if(rMain->getVarVal("doChpFilesThreads") != "")
+	{
+	  rMain->addTest(defineDoChpFilesThreads());
+	}
     }
 
   //Run All tests that have been built up into the framework
@@ -299,3 +306,66 @@ RT_Test* defineDoChpFilesDefault()
   //Return a pointer to the test just created
   return rt;
 }
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+//Creates new test called doChpFilesThreads
+//Same run as doChpFiles with the CNV regions fit on 4 threads; the results
+//must match the doChpFiles gold files. The apt-canary log gives the regions/sec.
+RT_Test* defineDoChpFilesThreads()
+{
+  //Create new RT_Test instance
+  RT_Test* rt= new RT_Test("doChpFilesThreads");
+
+  //Create new command that will be stored in our Test
+  RT_Cmd* cmd = rt->newCmd();
+  cmd->setExe("${apt_canary}");
+  cmd->addArg("--apt-summarize-analysis", "quant-norm.target=1000,pm-only,plier.optmethod=1,expr.genotype=true");
+  cmd->addArg("--apt-canary-analysis", "af-weight=1.0,TOL=1e-3,hwe_tol=1e-4,hwe_tol2=1e-11,fraction-giveaway-0=0.20,fraction-giveaway-1=0.10,fraction-giveaway-2=0.15,fraction-giveaway-3=0.20,fraction-giveaway-4=0.30,min-fill-prop=0.10,conf-interval-half-width=1.959963984540054,inflation=1.3,min-cluster-variance=0.0001,pseudopoint-factor=100");
+  cmd->addArg("--out-dir", "${out_testname}");
+  cmd->addArg("--cdf-file", "${gold_lib_genomewidesnp6}/GenomeWideSNP_6.cdf");
+  cmd->addArg("--cnv-region-file", "${gold_lib_genomewidesnp6}/GenomeWideSNP_6.canary-v1.region");
+  cmd->addArg("--cnv-normalization-file", "${gold_lib_genomewidesnp6}/GenomeWideSNP_6.canary-v1.normalization");
+  cmd->addArg("--cnv-prior-file", "${gold_lib_genomewidesnp6}/GenomeWideSNP_6.canary-v1.prior");
+  cmd->addArg("--cnv-map-file", "${gold_lib_genomewidesnp6}/GenomeWideSNP_6.canary-v1.bed");
+  cmd->addArg("--analysis-name", "canary-v1");
+  cmd->addArg("--cel-files", "${gold_canary_genomewidesnp6}/fas_cel_files.txt");
+  cmd->addArg("--cc-chp-output", "true");
+  cmd->addArg("--table-output", "true");
+  cmd->addArg("--threads", "4");
+
+  //Produce a vector of generated and gold files by combining our array of files with a given prefix and suffix
+  vector<string> gold,gen;
+  gold = Util::addPrefixSuffix(chpFiles, "${gold_canary_genomewidesnp6}/doChpFiles/", "${chpfilessuffix}");
+  gen =  Util::addPrefixSuffix(chpFiles, "${out_testname}/", "${chpfilessuffix}");
+
+  //Create new Calvin Chp Checks
+  RT_Check* check = rt->newCheck();
+  check->setExe("${apt_check_calvinchp}");
+  check->setGenFiles(gen);
+  check->setGoldFiles(gold);
+
+  //Create new Matrix Check
+  RT_Check* check1 = rt->newCheck();
+  check1->setExe("${apt_check_matrix}");
+  check1->addArg("--gen", "${out_testname}/canary-v1.calls.txt");
+  check1->addArg("--gold", "${gold_canary_genomewidesnp6}/doChpFiles/canary-v1.calls.txt"); 
+  check1->addArg("--epsilon", "0.0001");
+  check1->addArg("--rowSkip", "1"); 
+  check1->addArg("--columnSkip", "1");
+  check1->addArg("--matchNames", "false");
+  check1->addArg("--allowedMismatch", "0");
+
+  //Create new Matrix Check
+  RT_Check* check2 = rt->newCheck();
+  check2->setExe("${apt_check_matrix}");
+  check2->addArg("--gen", "${out_testname}/canary-v1.confidences.txt");
+  check2->addArg("--gold", "${gold_canary_genomewidesnp6}/doChpFiles/canary-v1.confidences.txt"); 
+  check2->addArg("--epsilon", "0.0001");
+  check2->addArg("--rowSkip", "1"); 
+  check2->addArg("--columnSkip", "1");
+  check2->addArg("--matchNames", "false");
+  check2->addArg("--allowedMismatch", "0");
+
+  //Return a pointer to the test just created
+  return rt;
+}
@@ -38,27 +38,44 @@ bool AnalysisStream:: doAnalysis(               ProbeSetGroup &psGroup,
                           			IntensityMart &iMart,
                           			bool doReport,
                                                 bool alleleSummaryOnly) {
-  bool success = true;
-  if (m_QMethod->setUp(psGroup, iMart, m_CStreams, *m_PmAdjust)) {
-    if (!alleleSummaryOnly) {
-      m_QMethod->computeEstimate();
-      if (doReport) {
-        for (unsigned int i = 0; i < m_Reporters.size(); i++) {
-          m_Reporters[i]->report(psGroup, *m_QMethod, iMart, m_CStreams, *m_PmAdjust);
-        }
-      }
-    }
+  bool success = computeAnalysis(psGroup, iMart, *m_QMethod, *m_PmAdjust, alleleSummaryOnly);
+  if (doReport) {
+    reportAnalysis(psGroup, iMart, *m_QMethod, *m_PmAdjust, alleleSummaryOnly, success);
   }
-  else {
+  return success;
+}
+
+bool AnalysisStream::computeAnalysis(ProbeSetGroup &psGroup,
+                                     IntensityMart &iMart,
+                                     QuantMethod &qMethod,
+                                     PmAdjuster &pmAdjust,
+                                     bool alleleSummaryOnly) {
+  if (!qMethod.setUp(psGroup, iMart, m_CStreams, pmAdjust)) {
     Verbose::out(5, "Warning setup failed for name: " + ToStr(psGroup.name));
-    success = false;
+    return false;
+  }
+  if (!alleleSummaryOnly) {
+    qMethod.computeEstimate();
   }
-  if (!success && doReport) {
+  return true;
+}
+
+void AnalysisStream::reportAnalysis(ProbeSetGroup &psGroup,
+                                    IntensityMart &iMart,
+                                    QuantMethod &qMethod,
+                                    PmAdjuster &pmAdjust,
+                                    bool alleleSummaryOnly,
+                                    bool success) {
+  if (success && !alleleSummaryOnly) {
     for (unsigned int i = 0; i < m_Reporters.size(); i++) {
-      m_Reporters[i]->reportFailure(psGroup, *m_QMethod, iMart, m_CStreams, *m_PmAdjust);
+      m_Reporters[i]->report(psGroup, qMethod, iMart, m_CStreams, pmAdjust);
+    }
+  }
+  if (!success) {
+    for (unsigned int i = 0; i < m_Reporters.size(); i++) {
+      m_Reporters[i]->reportFailure(psGroup, qMethod, iMart, m_CStreams, pmAdjust);
     }
   }
-  return success;
 }
 
 /** 
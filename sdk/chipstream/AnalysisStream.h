@@ -252,6 +252,20 @@ public:
                           IntensityMart &iMart, 
                           bool doReport,
                           bool alleleSummaryOnly = false);
+
+  /**
+   * The two halves of doAnalysis(), with a caller supplied QuantMethod
+   * and PmAdjuster so the set up and estimate can be done on another
+   * thread and the reporting later (and in order) on this one.
+   *
+   * @return true if setup succeeded.
+   */
+  bool computeAnalysis(ProbeSetGroup &psGroup, IntensityMart &iMart,
+                       QuantMethod &qMethod, PmAdjuster &pmAdjust,
+                       bool alleleSummaryOnly);
+  void reportAnalysis(ProbeSetGroup &psGroup, IntensityMart &iMart,
+                      QuantMethod &qMethod, PmAdjuster &pmAdjust,
+                      bool alleleSummaryOnly, bool success);
   /** 
    * Get the quantification method used. Useful for getting results after
    * doAnalysis() has been called.
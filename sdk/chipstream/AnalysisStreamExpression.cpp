@@ -174,6 +174,37 @@ bool AnalysisStreamExpression::doAnalysis(ProbeSetGroup &psGroup, IntensityMart
     bool success = true;
     std::vector<ProbeSetGroup *> toRun;
     std::vector<ProbeSetGroup> psAlleles;
+    makeAnalysisGroups(psGroup, psAlleles, toRun);
+    for(uint32_t gIx = 0; gIx < toRun.size(); gIx++) {
+      ProbeSetGroup &group = *toRun[gIx];
+      //std::cout << *(group.probeSets[0]) << '\n';
+      bool setupOk = computeGroup(group, iMart, *m_QMethod, *m_PmAdjust);
+      if(!setupOk) {
+        Verbose::out(5, "Warning setup failed for name: " + ToStr(group.name));
+        success = false;
+      }
+      if(doReport) {
+        reportGroup(group, iMart, *m_QMethod, *m_PmAdjust, setupOk, success);
+      }
+    }
+    freeAnalysisGroups(psAlleles);
+    return success;
+}
+
+/** 
+ * Figure out the groups that are actually summarized for psGroup. For
+ * most probesets this is just psGroup, but genotyping and marker
+ * probesets may be split into alleles (and strands) as requested.
+ * 
+ * @param psGroup - Collection of probe sets to get probes from.
+ * @param psAlleles - Storage for any allele groups created, must be
+ *   released with freeAnalysisGroups().
+ * @param toRun - Filled in with the groups to be summarized in order.
+ */
+void AnalysisStreamExpression::makeAnalysisGroups(ProbeSetGroup &psGroup,
+                                                  std::vector<ProbeSetGroup> &psAlleles,
+                                                  std::vector<ProbeSetGroup *> &toRun) {
+    toRun.clear();
     if(psGroup.probeSets.size() <= 0) {
       Err::errAbort("Can't have probeset groups with no probesets.");
     }
@@ -279,27 +310,13 @@ bool AnalysisStreamExpression::doAnalysis(ProbeSetGroup &psGroup, IntensityMart
     else {
       toRun.push_back(&psGroup);
     }
-    for(uint32_t gIx = 0; gIx < toRun.size(); gIx++) {
-      ProbeSetGroup &group = *toRun[gIx];
-      //std::cout << *(group.probeSets[0]) << '\n';
-      if(m_QMethod->setUp(group, iMart, m_CStreams, *m_PmAdjust)) {
-        m_QMethod->computeEstimate();
-        if(doReport) {
-          for(unsigned int i = 0; i < m_Reporters.size(); i++) {
-            m_Reporters[i]->report(group, *m_QMethod, iMart, m_CStreams, *m_PmAdjust);
-          }
-        }
-      }
-      else {
-        Verbose::out(5, "Warning setup failed for name: " + ToStr(group.name));
-        success = false;
-      }
-      if(!success && doReport) {
-        for(unsigned int i = 0; i < m_Reporters.size(); i++) {
-          m_Reporters[i]->reportFailure(group, *m_QMethod, iMart, m_CStreams, *m_PmAdjust);
-        }
-      }
-    }
+}
+
+/** 
+ * Release the memory of allele groups made by makeAnalysisGroups().
+ * @param psAlleles - Groups to be cleaned up.
+ */
+void AnalysisStreamExpression::freeAnalysisGroups(std::vector<ProbeSetGroup> &psAlleles) {
     for(uint32_t gIx = 0; gIx < psAlleles.size(); gIx++) {
       ProbeSetGroup &pG = psAlleles[gIx];
       pG.ownMem = false;
@@ -308,7 +325,53 @@ bool AnalysisStreamExpression::doAnalysis(ProbeSetGroup &psGroup, IntensityMart
         delete pG.probeSets[psIx];
       }
     }
-    return success;
+}
+
+/** 
+ * Set up and compute the estimates for a single group using the
+ * quantification method and pm adjuster supplied. The threaded
+ * summary code passes in per thread copies here, the serial code
+ * passes in our own.
+ * 
+ * @param group - Group to be summarized.
+ * @param iMart - Object containing raw data values for all chips.
+ * @param qMethod - Quantification method to do the work.
+ * @param pmAdjust - Pm adjuster to use for qMethod.
+ * 
+ * @return true if setup succeeded and estimates were computed.
+ */
+bool AnalysisStreamExpression::computeGroup(ProbeSetGroup &group, IntensityMart &iMart,
+                                            QuantMethod &qMethod, PmAdjuster &pmAdjust) {
+    bool setupOk = qMethod.setUp(group, iMart, m_CStreams, pmAdjust);
+    if(setupOk) {
+      qMethod.computeEstimate();
+    }
+    return setupOk;
+}
+
+/** 
+ * Pass the results of computeGroup() on to our reporters.
+ * 
+ * @param group - Group that was summarized.
+ * @param iMart - Object containing raw data values for all chips.
+ * @param qMethod - Quantification method holding the estimates.
+ * @param pmAdjust - Pm adjuster used for qMethod.
+ * @param setupOk - Did the setup for this group succeed?
+ * @param success - Has every group of this probeset succeeded so far?
+ */
+void AnalysisStreamExpression::reportGroup(ProbeSetGroup &group, IntensityMart &iMart,
+                                           QuantMethod &qMethod, PmAdjuster &pmAdjust,
+                                           bool setupOk, bool success) {
+    if(setupOk) {
+      for(unsigned int i = 0; i < m_Reporters.size(); i++) {
+        m_Reporters[i]->report(group, qMethod, iMart, m_CStreams, pmAdjust);
+      }
+    }
+    if(!success) {
+      for(unsigned int i = 0; i < m_Reporters.size(); i++) {
+        m_Reporters[i]->reportFailure(group, qMethod, iMart, m_CStreams, pmAdjust);
+      }
+    }
 }
 
 /** 
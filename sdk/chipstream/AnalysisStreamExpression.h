@@ -39,7 +39,6 @@
 #include <set>
 //
 
-
 class AnalysisStreamExpression : public AnalysisStream {
 
 public:
@@ -125,6 +124,23 @@ public:
    */
   virtual bool doAnalysis(ProbeSetGroup &psGroup, IntensityMart &iMart, bool doReport, bool alleleSummaryOnly = false);
 
+  /**
+   * The pieces of doAnalysis() broken out so the summaries can be
+   * computed on several threads (each with its own QuantMethod and
+   * PmAdjuster) and reported in order on one. doAnalysis() is
+   * makeAnalysisGroups(), then computeGroup() and reportGroup() for
+   * each group and finally freeAnalysisGroups().
+   */
+  void makeAnalysisGroups(ProbeSetGroup &psGroup,
+                          std::vector<ProbeSetGroup> &psAlleles,
+                          std::vector<ProbeSetGroup *> &toRun);
+  static void freeAnalysisGroups(std::vector<ProbeSetGroup> &psAlleles);
+  bool computeGroup(ProbeSetGroup &group, IntensityMart &iMart,
+                    QuantMethod &qMethod, PmAdjuster &pmAdjust);
+  void reportGroup(ProbeSetGroup &group, IntensityMart &iMart,
+                   QuantMethod &qMethod, PmAdjuster &pmAdjust,
+                   bool setupOk, bool success);
+
   /** 
    * Make a new probeset group which is a subset of the original based on the
    * probeset ids contained in the goodIds set.
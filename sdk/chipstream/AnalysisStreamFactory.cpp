@@ -248,6 +248,45 @@ AnalysisStreamFactory::constructExpressionAnalysisStream(const std::string& s, C
   return stream;
 }
 
+/** 
+ * @brief Make just the pm adjuster and quantification method for an
+ * expression analysis string, parsed the same way as
+ * constructExpressionAnalysisStream().
+ * 
+ * @param s - String description.
+ * @param layout - Probe and probe set info.
+ * @param stdMethods - Aliases for standard methods like RMA.
+ * @param pmAdjust - Filled in with the pm adjuster.
+ *
+ * @return quantification method requested.
+ */
+QuantExprMethod *
+AnalysisStreamFactory::constructExpressionQuantMethod(const std::string& s, ChipLayout &layout, 
+                                                      std::map<std::string,std::string> &stdMethods,
+                                                      PmAdjuster *&pmAdjust) {
+  assert(s!="");
+  string description;
+  vector<string> words;
+
+  if(stdMethods.find(s) != stdMethods.end())
+    description = stdMethods[s];
+  else
+    description = s;
+
+  Util::chopString(description, ',', words);
+  if(words.size() < 2) {
+    Err::errAbort("Must specify at least a pm adjustment and summary type.");
+  }
+  /* Drop any trailing analysis stream type, the caller supplies the stream. */
+  AnalysisStreamExpression *stream = tryToMakeAnalysisStream(words[words.size() - 1]);
+  if(stream != NULL) {
+    delete stream;
+    words.pop_back();
+  }
+  pmAdjust = m_PmAdjustFac.pmAdjusterForString(words[words.size() - 2], layout);
+  return m_QuantMethFac.quantExprMethodForString(words[words.size() - 1], layout, m_QuantType);
+}
+
 /** 
  * @brief Factory for creatng mRNA expression AnalysisStream from a string description.
  * 
@@ -378,6 +417,34 @@ AnalysisStreamFactory::constructGTypeAnalysisStream(const std::string& s, ChipLa
   return stream;
 }
 
+/** 
+ * @brief Make just the pm adjuster for a genotyping analysis string.
+ * 
+ * @param s - String description.
+ * @param layout - Probe and probe set info.
+ * @param stdMethods - Aliases for standard methods.
+ *
+ * @return pm adjuster requested.
+ */
+PmAdjuster *
+AnalysisStreamFactory::constructGTypePmAdjuster(const std::string& s, ChipLayout &layout, 
+                                                std::map<std::string,std::string> &stdMethods) {
+  assert(s!="");
+  string description;
+  vector<string> words;
+
+  if(stdMethods.find(s) != stdMethods.end())
+    description = stdMethods[s];
+  else
+    description = s;
+
+  Util::chopString(description, ',', words);
+  if(words.size() < 2) {
+    Err::errAbort("Must specify at least a pm adjustment and summary type.");
+  }
+  return m_PmAdjustFac.pmAdjusterForString(words[words.size() - 2], layout);
+}
+
 /** 
  * @brief Load up a list of probes from a .bgp file
  * 
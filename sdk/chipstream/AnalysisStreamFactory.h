@@ -111,6 +111,38 @@ public:
                                                               std::map<std::string,std::string> &stdMethods,
                                                               std::string analysisName = "");
 
+  /**
+   * @brief Make just the pm adjuster and quantification method for an
+   * expression analysis string. Used to give each summary thread its own
+   * copy of the stateful parts of a stream made by
+   * constructExpressionAnalysisStream(); the chipstream modules are not
+   * made as the data they transform is shared.
+   *
+   * @param s - String description.
+   * @param layout - Probe and probe set info.
+   * @param stdMethods - Aliases for standard methods like RMA.
+   * @param pmAdjust - Filled in with the pm adjuster, caller owns it.
+   *
+   * @return quantification method requested, caller owns it.
+   */
+  QuantExprMethod *constructExpressionQuantMethod(const std::string& s, ChipLayout &layout,
+                                                  std::map<std::string,std::string> &stdMethods,
+                                                  PmAdjuster *&pmAdjust);
+
+  /**
+   * @brief Make just the pm adjuster for a genotyping analysis string,
+   * parsed the same way as constructGTypeAnalysisStream(). Used to give
+   * each genotyping thread its own copy.
+   *
+   * @param s - String description.
+   * @param layout - Probe and probe set info.
+   * @param stdMethods - Aliases for standard methods.
+   *
+   * @return pm adjuster requested, caller owns it.
+   */
+  PmAdjuster *constructGTypePmAdjuster(const std::string& s, ChipLayout &layout,
+                                       std::map<std::string,std::string> &stdMethods);
+
   AnalysisStreamExpression *constructExpressionAnalysisStages(const std::string& s, ChipLayout &layout, 
                                                                std::map<std::string,std::string> &stdMethods,
                                                               std::string analysisName);
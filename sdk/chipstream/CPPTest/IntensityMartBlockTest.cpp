@@ -0,0 +1,225 @@
+////////////////////////////////////////////////////////////////
+//
+// Copyright (C) 2011 Affymetrix, Inc.
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License (version 2) as
+// published by the Free Software Foundation.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program;if not, write to the
+//
+// Free Software Foundation, Inc.,
+// 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+//
+////////////////////////////////////////////////////////////////
+
+/**
+ * @file   IntensityMartBlockTest.cpp
+ *
+ * @brief  Testing IntensityMart::getProbeIntensities() against
+ * getProbeIntensity() and timing the two.
+ */
+#ifndef INTENSITYMARTBLOCKTEST_H
+#define INTENSITYMARTBLOCKTEST_H
+
+#include "chipstream/DataStore.h"
+#include "chipstream/DiskIntensityMart.h"
+#include "chipstream/SparseMart.h"
+#include "util/Convert.h"
+#include "util/Verbose.h"
+#include <ctime>
+#include <string>
+#include <vector>
+#include <cppunit/extensions/HelperMacros.h>
+#include <cppunit/CompilerOutputter.h>
+#include <cppunit/extensions/TestFactoryRegistry.h>
+#include <cppunit/ui/text/TestRunner.h>
+
+using namespace std;
+/**
+ * @class IntensityMartBlockTest
+ * @brief cppunit class for testing the block fetch of intensities.
+ */
+class IntensityMartBlockTest : public CppUnit::TestFixture
+{
+  CPPUNIT_TEST_SUITE( IntensityMartBlockTest );
+  CPPUNIT_TEST( testSparseMartBlock );
+  CPPUNIT_TEST( testDiskMartBlock );
+  CPPUNIT_TEST( testDataStoreBlock );
+  CPPUNIT_TEST( testBlockTiming );
+  CPPUNIT_TEST_SUITE_END();
+
+public:
+  void testSparseMartBlock();
+  void testDiskMartBlock();
+  void testDataStoreBlock();
+  void testBlockTiming();
+
+private:
+  void fillMart(IntensityMart &iMart, int probeCount, int chipCount);
+  void checkBlocks(IntensityMart &iMart, int probeCount, int chipCount, int psSize);
+  double timeCells(IntensityMart &iMart, int probeCount, int chipCount, int psSize, int reps);
+  double timeBlocks(IntensityMart &iMart, int probeCount, int chipCount, int psSize, int reps);
+};
+
+// Registers the fixture into the registry
+CPPUNIT_TEST_SUITE_REGISTRATION( IntensityMartBlockTest );
+
+/// Intensity of probe on chip, unique so misplaced values are caught.
+static float testIntensity(int probeIx, int chipIx) {
+  return (float)(probeIx * 1000 + chipIx);
+}
+
+static vector<string> testCelNames(int chipCount) {
+  vector<string> names;
+  for(int i = 0; i < chipCount; i++)
+    names.push_back("chip" + ToStr(i) + ".CEL");
+  return names;
+}
+
+void IntensityMartBlockTest::fillMart(IntensityMart &iMart, int probeCount, int chipCount) {
+  vector<float> data(probeCount);
+  for(int chipIx = 0; chipIx < chipCount; chipIx++) {
+    for(int probeIx = 0; probeIx < probeCount; probeIx++)
+      data[probeIx] = testIntensity(probeIx, chipIx);
+    iMart.setProbeIntensity(chipIx, data);
+  }
+}
+
+/// Fetch each probeset sized block (with a probe out of order) and check it.
+void IntensityMartBlockTest::checkBlocks(IntensityMart &iMart, int probeCount, int chipCount, int psSize) {
+  vector<probeid_t> probeIds;
+  vector<unsigned int> channels;
+  vector<float> block;
+  for(int start = 0; start + psSize <= probeCount; start += psSize) {
+    probeIds.clear();
+    for(int i = psSize - 1; i >= 0; i--)
+      probeIds.push_back(start + i);
+    channels.assign(probeIds.size(), 0);
+    iMart.getProbeIntensities(probeIds, channels, chipCount, block);
+    CPPUNIT_ASSERT( block.size() == probeIds.size() * chipCount );
+    for(int i = 0; i < probeIds.size(); i++) {
+      for(int chipIx = 0; chipIx < chipCount; chipIx++) {
+        float value = block[i * chipCount + chipIx];
+        CPPUNIT_ASSERT( value == iMart.getProbeIntensity(probeIds[i], chipIx) );
+        CPPUNIT_ASSERT( value == testIntensity(probeIds[i], chipIx) );
+      }
+    }
+  }
+}
+
+double IntensityMartBlockTest::timeCells(IntensityMart &iMart, int probeCount, int chipCount, int psSize, int reps) {
+  double sum = 0;
+  clock_t start = clock();
+  for(int r = 0; r < reps; r++) {
+    for(int probeIx = 0; probeIx < probeCount; probeIx++)
+      for(int chipIx = 0; chipIx < chipCount; chipIx++)
+        sum += iMart.getProbeIntensity(probeIx, chipIx);
+  }
+  double seconds = (double)(clock() - start) / CLOCKS_PER_SEC;
+  CPPUNIT_ASSERT( sum > 0 );
+  return seconds;
+}
+
+double IntensityMartBlockTest::timeBlocks(IntensityMart &iMart, int probeCount, int chipCount, int psSize, int reps) {
+  double sum = 0;
+  vector<probeid_t> probeIds(psSize);
+  vector<unsigned int> channels(psSize, 0);
+  vector<float> block;
+  clock_t start = clock();
+  for(int r = 0; r < reps; r++) {
+    for(int first = 0; first + psSize <= probeCount; first += psSize) {
+      for(int i = 0; i < psSize; i++)
+        probeIds[i] = first + i;
+      iMart.getProbeIntensities(probeIds, channels, chipCount, block);
+      for(int i = 0; i < block.size(); i++)
+        sum += block[i];
+    }
+  }
+  double seconds = (double)(clock() - start) / CLOCKS_PER_SEC;
+  CPPUNIT_ASSERT( sum > 0 );
+  return seconds;
+}
+
+void IntensityMartBlockTest::testSparseMartBlock() {
+  int probeCount = 500, chipCount = 7;
+  vector<probeidx_t> order(probeCount);
+  for(int i = 0; i < probeCount; i++)
+    order[i] = probeCount - i - 1;
+  SparseMart iMart(order, testCelNames(chipCount));
+  fillMart(iMart, probeCount, chipCount);
+  checkBlocks(iMart, probeCount, chipCount, 25);
+}
+
+void IntensityMartBlockTest::testDiskMartBlock() {
+  int probeCount = 500, chipCount = 7;
+  vector<int> order(probeCount);
+  for(int i = 0; i < probeCount; i++)
+    order[i] = i;
+  // small cache so the block reads have to refill it.
+  DiskIntensityMart iMart(order, testCelNames(chipCount), 100 * chipCount, ".", "block-test.", false);
+  fillMart(iMart, probeCount, chipCount);
+  checkBlocks(iMart, probeCount, chipCount, 25);
+}
+
+void IntensityMartBlockTest::testDataStoreBlock() {
+  int probeCount = 500, chipCount = 7;
+  vector<int> order(probeCount);
+  for(int i = 0; i < probeCount; i++)
+    order[i] = probeCount - i - 1;
+  DataStore iMart("block-test.f5");
+  iMart.setProbeOrder(order);
+  iMart.initIntensity(probeCount, 1);
+  vector<float> data(probeCount);
+  for(int chipIx = 0; chipIx < chipCount; chipIx++) {
+    for(int probeIx = 0; probeIx < probeCount; probeIx++)
+      data[probeIx] = testIntensity(probeIx, chipIx);
+    iMart.writeColumn(chipIx, "chip" + ToStr(chipIx), data);
+  }
+  // probesets stored together are read as one span of rows.
+  checkBlocks(iMart, probeCount, chipCount, 25);
+  // probes spread over the store are read one at a time.
+  vector<probeid_t> probeIds;
+  for(int probeIx = 3; probeIx < probeCount; probeIx += 37)
+    probeIds.push_back(probeIx);
+  vector<unsigned int> channels(probeIds.size(), 0);
+  vector<float> block;
+  iMart.getProbeIntensities(probeIds, channels, chipCount, block);
+  CPPUNIT_ASSERT( block.size() == probeIds.size() * chipCount );
+  for(int i = 0; i < probeIds.size(); i++) {
+    for(int chipIx = 0; chipIx < chipCount; chipIx++) {
+      CPPUNIT_ASSERT( block[i * chipCount + chipIx] == iMart.getProbeIntensity(probeIds[i], chipIx) );
+      CPPUNIT_ASSERT( block[i * chipCount + chipIx] == testIntensity(probeIds[i], chipIx) );
+    }
+  }
+}
+
+/// 25 probe probesets over many chips: one virtual call per
+/// intensity against one call per probeset.
+void IntensityMartBlockTest::testBlockTiming() {
+  int probeCount = 10000, chipCount = 500, psSize = 25, reps = 3;
+  vector<int> order(probeCount);
+  for(int i = 0; i < probeCount; i++)
+    order[i] = i;
+  vector<string> celNames = testCelNames(chipCount);
+
+  SparseMart sparseMart(order, celNames);
+  fillMart(sparseMart, probeCount, chipCount);
+  double cellTime = timeCells(sparseMart, probeCount, chipCount, psSize, reps);
+  double blockTime = timeBlocks(sparseMart, probeCount, chipCount, psSize, reps);
+  Verbose::out(1, "SparseMart getProbeIntensity(): " + ToStr(cellTime) + "s getProbeIntensities(): " + ToStr(blockTime) + "s");
+
+  DiskIntensityMart diskMart(order, celNames, 50 * 1048576, ".", "block-test.", false);
+  fillMart(diskMart, probeCount, chipCount);
+  cellTime = timeCells(diskMart, probeCount, chipCount, psSize, reps);
+  blockTime = timeBlocks(diskMart, probeCount, chipCount, psSize, reps);
+  Verbose::out(1, "DiskIntensityMart getProbeIntensity(): " + ToStr(cellTime) + "s getProbeIntensities(): " + ToStr(blockTime) + "s");
+}
+
+#endif
@@ -0,0 +1,250 @@
+////////////////////////////////////////////////////////////////
+//
+// Copyright (C) 2011 Affymetrix, Inc.
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License (version 2) as
+// published by the Free Software Foundation.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program;if not, write to the
+//
+// Free Software Foundation, Inc.,
+// 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+//
+////////////////////////////////////////////////////////////////
+
+/**
+ * @file   SqlSampleTableTest.cpp
+ *
+ * @brief  Testing the tables written by the sqlite reporters and
+ * timing them against an insert statement per row.
+ */
+#ifndef SQLSAMPLETABLETEST_H
+#define SQLSAMPLETABLETEST_H
+
+#include "chipstream/SqlSampleTable.h"
+#include "util/Convert.h"
+#include "util/Verbose.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <limits>
+#include <string>
+#include <vector>
+#include <cppunit/extensions/HelperMacros.h>
+#include <cppunit/CompilerOutputter.h>
+#include <cppunit/extensions/TestFactoryRegistry.h>
+#include <cppunit/ui/text/TestRunner.h>
+
+using namespace std;
+/**
+ * @class SqlSampleTableTest
+ * @brief cppunit class for testing SqlSampleTable.
+ */
+class SqlSampleTableTest : public CppUnit::TestFixture
+{
+  CPPUNIT_TEST_SUITE( SqlSampleTableTest );
+  CPPUNIT_TEST( testColumns );
+  CPPUNIT_TEST( testBlob );
+  CPPUNIT_TEST( testWideColumns );
+  CPPUNIT_TEST( testInsertTiming );
+  CPPUNIT_TEST_SUITE_END();
+
+public:
+  void testColumns();
+  void testBlob();
+  void testWideColumns();
+  void testInsertTiming();
+
+private:
+  sqlite3 *openDb(const string &fileName);
+  void writeTable(sqlite3 *db, int rowCount, int sampleCount, SqlSampleTable::Layout layout, int commitRows);
+  void checkColumns(sqlite3 *db, int rowCount, int sampleCount);
+};
+
+// Registers the fixture into the registry
+CPPUNIT_TEST_SUITE_REGISTRATION( SqlSampleTableTest );
+
+/// Value for a row and sample; every tenth row has a NaN.
+static double testValue(int rowIx, int sampleIx) {
+  if(rowIx % 10 == 3 && sampleIx == 1)
+    return numeric_limits<double>::quiet_NaN();
+  return (rowIx + 1) * 1.0 / 3.0 + sampleIx * 1000.0;
+}
+
+static vector<string> testSampleNames(int sampleCount) {
+  vector<string> names;
+  for(int i = 0; i < sampleCount; i++)
+    names.push_back("sample'" + ToStr(i) + ".CEL");
+  return names;
+}
+
+sqlite3 *SqlSampleTableTest::openDb(const string &fileName) {
+  remove(fileName.c_str());
+  sqlite3 *db = NULL;
+  CPPUNIT_ASSERT( sqlite3_open(fileName.c_str(), &db) == SQLITE_OK );
+  SqlSampleTable::setBulkPragmas(db);
+  return db;
+}
+
+void SqlSampleTableTest::writeTable(sqlite3 *db, int rowCount, int sampleCount, SqlSampleTable::Layout layout, int commitRows) {
+  SqlSampleTable table;
+  table.setCommitRows(commitRows);
+  table.create(db, "summary", testSampleNames(sampleCount), 30, SqlSampleTable::ValueReal, layout);
+  vector<double> values(sampleCount);
+  for(int r = 0; r < rowCount; r++) {
+    for(int s = 0; s < sampleCount; s++)
+      values[s] = testValue(r, s);
+    table.insert("ps_" + ToStr(r), values);
+  }
+  table.finish();
+  CPPUNIT_ASSERT( table.getRowCount() == rowCount );
+}
+
+/// Read the column layout back; the bound doubles are exact.
+void SqlSampleTableTest::checkColumns(sqlite3 *db, int rowCount, int sampleCount) {
+  sqlite3_stmt *stmt = NULL;
+  string sql = "select * from summary;";
+  CPPUNIT_ASSERT( sqlite3_prepare_v2(db, sql.c_str(), sql.size(), &stmt, NULL) == SQLITE_OK );
+  int r = 0;
+  while(sqlite3_step(stmt) == SQLITE_ROW) {
+    CPPUNIT_ASSERT( sqlite3_column_count(stmt) == sampleCount + 1 );
+    CPPUNIT_ASSERT( string((const char *)sqlite3_column_text(stmt, 0)) == "ps_" + ToStr(r) );
+    for(int s = 0; s < sampleCount; s++) {
+      double expected = testValue(r, s);
+      if(expected != expected)
+        CPPUNIT_ASSERT( sqlite3_column_type(stmt, s + 1) == SQLITE_NULL );
+      else
+        CPPUNIT_ASSERT( sqlite3_column_double(stmt, s + 1) == expected );
+    }
+    r++;
+  }
+  sqlite3_finalize(stmt);
+  CPPUNIT_ASSERT( r == rowCount );
+}
+
+void SqlSampleTableTest::testColumns() {
+  string fileName = "sql-sample-test.db";
+  sqlite3 *db = openDb(fileName);
+  // small commits so there are several transactions.
+  writeTable(db, 1000, 7, SqlSampleTable::LayoutColumns, 64);
+  checkColumns(db, 1000, 7);
+  sqlite3_close(db);
+  remove(fileName.c_str());
+}
+
+void SqlSampleTableTest::testWideColumns() {
+  // more columns than sqlite lets us bind.
+  string fileName = "sql-sample-test.db";
+  sqlite3 *db = openDb(fileName);
+  writeTable(db, 20, 1200, SqlSampleTable::LayoutColumns, 8);
+  checkColumns(db, 20, 1200);
+  sqlite3_close(db);
+  remove(fileName.c_str());
+}
+
+void SqlSampleTableTest::testBlob() {
+  string fileName = "sql-sample-test.db";
+  int rowCount = 1000, sampleCount = 7;
+  sqlite3 *db = openDb(fileName);
+  writeTable(db, rowCount, sampleCount, SqlSampleTable::LayoutBlob, 64);
+
+  sqlite3_stmt *stmt = NULL;
+  string sql = "select probeset_id, sample_count, value from summary;";
+  CPPUNIT_ASSERT( sqlite3_prepare_v2(db, sql.c_str(), sql.size(), &stmt, NULL) == SQLITE_OK );
+  int r = 0;
+  while(sqlite3_step(stmt) == SQLITE_ROW) {
+    CPPUNIT_ASSERT( string((const char *)sqlite3_column_text(stmt, 0)) == "ps_" + ToStr(r) );
+    CPPUNIT_ASSERT( sqlite3_column_int(stmt, 1) == sampleCount );
+    CPPUNIT_ASSERT( sqlite3_column_bytes(stmt, 2) == sampleCount * 4 );
+    const char *blob = (const char *)sqlite3_column_blob(stmt, 2);
+    for(int s = 0; s < sampleCount; s++) {
+      float value;
+      memcpy(&value, blob + s * 4, 4);
+      float expected = (float)testValue(r, s);
+      CPPUNIT_ASSERT( (value == expected) || (value != value && expected != expected) );
+    }
+    r++;
+  }
+  sqlite3_finalize(stmt);
+  CPPUNIT_ASSERT( r == rowCount );
+
+  // the sample names are kept in order.
+  sql = "select sample_name from summary_samples order by sample_ix;";
+  CPPUNIT_ASSERT( sqlite3_prepare_v2(db, sql.c_str(), sql.size(), &stmt, NULL) == SQLITE_OK );
+  vector<string> names = testSampleNames(sampleCount);
+  int s = 0;
+  while(sqlite3_step(stmt) == SQLITE_ROW) {
+    CPPUNIT_ASSERT( string((const char *)sqlite3_column_text(stmt, 0)) == names[s] );
+    s++;
+  }
+  sqlite3_finalize(stmt);
+  CPPUNIT_ASSERT( s == sampleCount );
+  sqlite3_close(db);
+  remove(fileName.c_str());
+}
+
+/// Rows per second for the old "insert into ... values (...)" text
+/// per probeset against the prepared statement in both layouts.
+void SqlSampleTableTest::testInsertTiming() {
+  string fileName = "sql-sample-timing.db";
+  int rowCount = 20000, sampleCount = 100;
+  char buf[256];
+
+  // what the reporters used to do, default pragmas and all.
+  remove(fileName.c_str());
+  sqlite3 *db = NULL;
+  CPPUNIT_ASSERT( sqlite3_open(fileName.c_str(), &db) == SQLITE_OK );
+  string createSql = "create table summary ( probeset_id varchar(30) , ";
+  for(int s = 0; s < sampleCount; s++) {
+    createSql += " 'sample" + ToStr(s) + "' real ";
+    if(s + 1 != sampleCount)
+      createSql += ",";
+  }
+  createSql += " );";
+  SqlSampleTable::execute(db, createSql);
+  clock_t start = clock();
+  SqlSampleTable::execute(db, "begin transaction;");
+  for(int r = 0; r < rowCount; r++) {
+    string insert = "insert into summary values ( 'ps_" + ToStr(r) + "' ";
+    for(int s = 0; s < sampleCount; s++) {
+      // no NaN; the old code could not store them.
+      snprintf(buf, sizeof(buf), "%.4g", testValue(r, s + 2));
+      insert += string(",") + buf;
+    }
+    insert += ");";
+    SqlSampleTable::execute(db, insert);
+  }
+  SqlSampleTable::execute(db, "commit;");
+  SqlSampleTable::execute(db, "create index summary_index on summary (probeset_id);");
+  double textTime = (double)(clock() - start) / CLOCKS_PER_SEC;
+  sqlite3_close(db);
+
+  db = openDb(fileName);
+  start = clock();
+  writeTable(db, rowCount, sampleCount, SqlSampleTable::LayoutColumns, SQLSAMPLETABLE_COMMIT_ROWS);
+  double columnTime = (double)(clock() - start) / CLOCKS_PER_SEC;
+  sqlite3_close(db);
+
+  db = openDb(fileName);
+  start = clock();
+  writeTable(db, rowCount, sampleCount, SqlSampleTable::LayoutBlob, SQLSAMPLETABLE_COMMIT_ROWS);
+  double blobTime = (double)(clock() - start) / CLOCKS_PER_SEC;
+  sqlite3_close(db);
+  remove(fileName.c_str());
+
+  Verbose::out(1, ToStr(rowCount) + " rows of " + ToStr(sampleCount) + " samples, rows/sec: sql text " +
+               ToStr((int)(rowCount / max(textTime, 1e-6))) + " prepared " +
+               ToStr((int)(rowCount / max(columnTime, 1e-6))) + " blob " +
+               ToStr((int)(rowCount / max(blobTime, 1e-6))));
+}
+
+#endif
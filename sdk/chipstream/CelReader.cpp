@@ -31,6 +31,7 @@
 #include "util/Convert.h"
 #include "util/Fs.h"
 #include "util/Err.h"
+#include "util/Thread.h"
 #include "util/Util.h"
 #include "util/Verbose.h"
 
@@ -38,16 +39,271 @@ using namespace affymetrix_fusion_io;
 using namespace affymetrix_calvin_utilities;
 using namespace affymetrix_calvin_exceptions;
 
+/**
+ * A cel file which has been read and decoded but not yet passed on to
+ * the intensity marts and cel listeners. The cel file is kept open
+ * for the cel listeners.
+ */
+class DecodedCel {
+public:
+  DecodedCel() : m_Cel(NULL) {}
+  ~DecodedCel() {
+    delete m_Cel;
+  }
+  /// The cel file, active data group is the last channel.
+  FusionCELData *m_Cel;
+  /// Channels of the cel file.
+  std::vector<std::wstring> m_Channels;
+  /// Intensities for each channel.
+  std::vector<std::vector<float> > m_Data;
+  /// Fraction of saturated features for each channel.
+  std::vector<double> m_Saturation;
+  /// Error message if the file couldn't be read, empty otherwise.
+  std::string m_Error;
+private:
+  DecodedCel(const DecodedCel&);
+  DecodedCel& operator=(const DecodedCel&);
+};
+
+/**
+ * Make the error message for the exception being handled when
+ * reading or passing on a cel file. Must be called from a catch block.
+ */
+static std::string celReadErrorMsg(const std::string &fileName) {
+    try {
+        throw;
+    }
+    catch(const Except &e) {
+        return ToStr("\n") + e.what();
+    }
+    catch(const std::bad_alloc &e) {
+        return "\nRan out of memory when reading cel file: " + fileName + "\n";
+    }
+    catch(CalvinException &ce) {
+        return "\nAGCC error when reading cel file: " + fileName + "\n"
+            "Description: '" +StringUtils::ConvertWCSToMBS(ce.Description()) + "'";
+    }
+    catch(const std::exception &e) {
+        return "\nException caught. Message is: " + ToStr(e.what());
+    }
+    catch (...) {
+        return "\nUnknown problem when reading cel file: " + fileName + "\n";
+    }
+}
+
+/**
+ * Decoding threads (1..n) read cel files ahead of the calling thread
+ * (0) which passes them on in order. At most 'depth' files are
+ * decoded ahead of the one being passed on.
+ */
+class CelReadAheadTask : public ThreadTask {
+public:
+  CelReadAheadTask(CelReader &reader, int depth) :
+    m_Reader(reader), m_Depth(depth), m_FileCount(reader.m_FileNames.size()),
+    m_NextDecode(0), m_NextPassOn(0), m_CelChannelCount(0), m_Aborted(false),
+    m_Decoded(reader.m_FileNames.size(), (DecodedCel *)NULL) {
+  }
+
+  ~CelReadAheadTask() {
+    for (size_t i = 0; i < m_Decoded.size(); i++) {
+      delete m_Decoded[i];
+    }
+  }
+
+  virtual void runThread(int threadIx) {
+    if (threadIx == 0) {
+      passOnFiles();
+    }
+    else {
+      decodeFiles();
+    }
+  }
+
+  virtual void abortThreads() {
+    MutexLock lock(m_Lock);
+    m_Aborted = true;
+    m_Cond.broadcast();
+  }
+
+private:
+  void decodeFiles() {
+    while (true) {
+      int fileIx = 0;
+      {
+        MutexLock lock(m_Lock);
+        while (!m_Aborted && m_NextDecode < m_FileCount && m_NextDecode >= m_NextPassOn + m_Depth) {
+          m_Cond.wait(m_Lock);
+        }
+        if (m_Aborted || m_NextDecode >= m_FileCount) {
+          return;
+        }
+        fileIx = m_NextDecode++;
+      }
+      // errors are kept in the DecodedCel and reported in order.
+      DecodedCel *decoded = new DecodedCel();
+      m_Reader.decodeFile(fileIx, *decoded);
+      MutexLock lock(m_Lock);
+      m_Decoded[fileIx] = decoded;
+      m_Cond.broadcast();
+    }
+  }
+
+  void passOnFiles() {
+    for (int fileIx = 0; fileIx < m_FileCount; fileIx++) {
+      DecodedCel *decoded = NULL;
+      {
+        MutexLock lock(m_Lock);
+        while (!m_Aborted && m_Decoded[fileIx] == NULL) {
+          m_Cond.wait(m_Lock);
+        }
+        if (m_Aborted) {
+          return;
+        }
+        decoded = m_Decoded[fileIx];
+        m_Decoded[fileIx] = NULL;
+      }
+      Verbose::progressStep(1);
+      try {
+        m_Reader.passOnFile(fileIx, *decoded, m_CelChannelCount);
+      }
+      catch (...) {
+        delete decoded;
+        throw;
+      }
+      delete decoded;
+      MutexLock lock(m_Lock);
+      m_NextPassOn = fileIx + 1;
+      m_Cond.broadcast();
+    }
+  }
+
+  CelReader &m_Reader;
+  int m_Depth;
+  int m_FileCount;
+  /// Guards everything below.
+  Mutex m_Lock;
+  Condition m_Cond;
+  int m_NextDecode;
+  int m_NextPassOn;
+  int m_CelChannelCount;
+  bool m_Aborted;
+  /// Files decoded and waiting to be passed on.
+  std::vector<DecodedCel *> m_Decoded;
+};
+
+/**
+ * @brief Read a cel file and pull out the intensities of each
+ * channel. Doesn't throw, errors are left in decoded.m_Error.
+ * @param fileIx - Index of file in m_FileNames.
+ * @param decoded - Filled in with the cel file and intensities.
+ */
+void CelReader::decodeFile(int fileIx, DecodedCel &decoded) {
+    decoded.m_Cel = new FusionCELData();
+    FusionCELData &cel = *decoded.m_Cel;
+    try {
+        std::string tmp_unc_name=Fs::convertToUncPath(m_FileNames[fileIx]);
+        cel.SetFileName(tmp_unc_name.c_str());
+        if(!cel.Read()) {
+            decoded.m_Error = "\nCan't read cel file: " + cel.GetFileName() +
+                "\n>>> Error reported: " + StringUtils::ConvertWCSToMBS(cel.GetError());
+            return;
+        }
+
+        // If this is a AGCC CEL file, then get channel names.  If
+        // this is a GCOS CEL file, then an empty vector is returned.
+        std::vector<std::wstring> &data_channels = decoded.m_Channels;
+        data_channels = cel.GetChannels();
+
+        for (int chanIx = 0; chanIx < data_channels.size(); chanIx++) {
+            Verbose::out(4,"In cel file '"+m_FileNames[fileIx] +"' found channel '"+StringUtils::ConvertWCSToMBS(data_channels[chanIx])+"'");
+        }
+
+        // If this is a GCOS CEL file, then make up any old name for a
+        // single channel -- subsequent call to SetActiveDataGroup
+        // will be a no-op in this case, and GetIntensities will
+        // proceed as normal.
+        if (data_channels.empty()) {
+            std::wstring temp = L"Default Group";
+            data_channels.push_back(temp);
+        }
+
+        decoded.m_Data.resize(data_channels.size());
+        decoded.m_Saturation.resize(data_channels.size());
+        for (int chanIx = 0; chanIx < data_channels.size(); chanIx++) {
+            cel.SetActiveDataGroup(data_channels[chanIx]);
+            std::vector<float> &data = decoded.m_Data[chanIx];
+            int size = cel.GetRows() * cel.GetCols();
+            data.resize(size);
+            cel.GetIntensities(0,data);
+
+            // Compute saturation
+            int nsat = 0;
+            for (int icel=0; icel< size; icel++) {
+                if (data[icel] >= 3800)
+                    nsat++;
+            }
+            decoded.m_Saturation[chanIx] = (double)nsat/(double)size;
+        }
+    }
+    catch (...) {
+        decoded.m_Error = celReadErrorMsg(cel.GetFileName());
+    }
+}
+
+/**
+ * @brief Pass a decoded cel file on to the intensity marts and cel
+ * listeners. Must be called in file order.
+ * @param fileIx - Index of file in m_FileNames.
+ * @param decoded - Cel file from decodeFile().
+ * @param celChannelCount - Channels passed on so far, updated.
+ */
+void CelReader::passOnFile(int fileIx, DecodedCel &decoded, int &celChannelCount) {
+    if (!decoded.m_Error.empty()) {
+        Err::errAbort(decoded.m_Error);
+    }
+    FusionCELData &cel = *decoded.m_Cel;
+    try {
+        const std::vector<std::wstring> &data_channels = decoded.m_Channels;
+        std::vector<unsigned int> channel_group;
+        for (int chanIx = 0; chanIx < data_channels.size(); chanIx++) {
+            /* Check number of entries in cel file. */
+            if (fileIx == 0)
+                m_Size = (int)decoded.m_Data[chanIx].size();
+            else
+                assert(m_Size == (int)decoded.m_Data[chanIx].size());
+
+            if (m_Saturation.size () < m_FileNames.size ()*data_channels.size())
+                m_Saturation.resize ( m_FileNames.size ()*data_channels.size() );
+
+            m_Saturation[data_channels.size()*fileIx+chanIx] = decoded.m_Saturation[chanIx];
+
+            /* Load data into our intensity marts. */
+            for (int index = 0; index < m_IntenMarts.size(); index++) {
+                m_IntenMarts[index]->setProbeIntensity(data_channels.size()*fileIx+chanIx, decoded.m_Data[chanIx]);
+            }
+            // done with this channel.
+            std::vector<float>().swap(decoded.m_Data[chanIx]);
+
+            channel_group.push_back(celChannelCount++);
+        }
+        /* Pass data to cel listeners */
+        for (int index = 0; index < m_CelListeners.size(); index++) {
+            m_CelListeners[index]->newChip(&cel);
+        }
+        m_CelChannels.addGroup("channels", channel_group);
+        cel.Close();
+    }
+    catch (...) {
+        Err::errAbort(celReadErrorMsg(cel.GetFileName()));
+    }
+}
+
 /**
  * @brief Do the heavy lifting of reading data from the cel files
  * and passing to all the streams and intensity marts.
  * @return true on success or false on error.
  */
 bool CelReader::readFiles() {
-    int size = 0;
-    int cel_channel_count = 0;
-//   double newChip_times = 0, setProbeIntensity_times = 0, CelListener_newChip_times = 0;
-//   clock_t clock1, clock2;
     /* sanity checks. */
     Err::check(m_FileNames.size() > 0, "CelReader::readFiles() - Can't specify 0 files to read.");
     Err::check(m_Streams.size() > 0 || m_IntenMarts.size() > 0 || m_CelListeners.size() > 0,
@@ -72,100 +328,26 @@ bool CelReader::readFiles() {
         }
     }
 
-	
-
-    std::vector<float> data;
-    for (int fileIx=0; fileIx < m_FileNames.size(); fileIx++) {
-
-    // process cel file
-    FusionCELData cel;
-    Verbose::progressStep(1);
-    try {
-      std::string tmp_unc_name=Fs::convertToUncPath(m_FileNames[fileIx]);
-      cel.SetFileName(tmp_unc_name.c_str());
-        if(!cel.Read())
-            Err::errAbort("\nCan't read cel file: " + cel.GetFileName() +
-                "\n>>> Error reported: " + StringUtils::ConvertWCSToMBS(cel.GetError()));
-
-            // If this is a AGCC CEL file, then get channel names.  If
-            // this is a GCOS CEL file, then an empty vector is returned.
-            std::vector<std::wstring> data_channels = cel.GetChannels();
-
-        for (int chanIx = 0; chanIx < data_channels.size(); chanIx++) {
-          Verbose::out(4,"In cel file '"+m_FileNames[fileIx] +"' found channel '"+StringUtils::ConvertWCSToMBS(data_channels[chanIx])+"'");
-        }
-
-            // If this is a GCOS CEL file, then make up any old name for a
-            // single channel -- subsequent call to SetActiveDataGroup
-            // will be a no-op in this case, and GetIntensities will
-            // proceed as normal.
-            if (data_channels.empty()) {
-                std::wstring temp = L"Default Group";
-                data_channels.push_back(temp);
-            }
-
-            std::vector<unsigned int> channel_group;
-            for (int chanIx = 0; chanIx < data_channels.size(); chanIx++) {
-                cel.SetActiveDataGroup(data_channels[chanIx]);
-
-                /* Check number of entries in cel file. */
-                if (fileIx == 0)
-                    size = cel.GetRows() * cel.GetCols();
-                else
-                    assert(size == cel.GetRows() * cel.GetCols());
-                data.resize(size);
-                cel.GetIntensities(0,data);
-
-				// Compute saturation 
-				int nsat = 0;
-				for (int icel=0; icel< size; icel++)
-				{
-					if (data[icel] >= 3800)
-						nsat++;
-				}
-
-				double sat = (double)nsat/(double)size;
-
-				if (m_Saturation.size () < m_FileNames.size ()*data_channels.size())
-					m_Saturation.resize ( m_FileNames.size ()*data_channels.size() );
-
-				m_Saturation[data_channels.size()*fileIx+chanIx] = sat;
-
-                /* Load data into our intensity marts. */
-                //     clock1 = clock();
-                for (int index = 0; index < m_IntenMarts.size(); index++) {
-
-                    m_IntenMarts[index]->setProbeIntensity(data_channels.size()*fileIx+chanIx, data);
-                }
-                //     clock2 = clock();
-                //     setProbeIntensity_times += clock2 - clock1;
-
-                channel_group.push_back(cel_channel_count++);
-            }
-            /* Pass data to cel listeners */
-            for (int index = 0; index < m_CelListeners.size(); index++) {
-                m_CelListeners[index]->newChip(&cel);
-            }
-            m_CelChannels.addGroup("channels", channel_group);
-            cel.Close();
-        }
-        catch(const Except &e) {
-            Err::errAbort(ToStr("\n") + e.what());
-        }
-        catch(const std::bad_alloc &e) {
-            Err::errAbort("\nRan out of memory when reading cel file: " + cel.GetFileName() + "\n");
-        }
-        catch(CalvinException &ce) {
-            Err::errAbort("\nAGCC error when reading cel file: " + cel.GetFileName() + "\n"
-                          "Description: '" +StringUtils::ConvertWCSToMBS(ce.Description()) + "'");
-        }
-        catch(const std::exception &e) {
-            Err::errAbort("\nException caught. Message is: " + ToStr(e.what()));
-        }
-        catch (...) {
-            Err::errAbort("\nUnknown problem when reading cel file: " + cel.GetFileName() + "\n");
-        }
-    } // end reading cel files
+    int readThreads = m_ReadThreads;
+    if (readThreads >= (int)m_FileNames.size()) {
+        readThreads = m_FileNames.size() - 1;
+    }
+    if (readThreads > 0) {
+        int depth = (m_ReadDepth > 0 ? m_ReadDepth : 2 * readThreads);
+        Verbose::out(2, "Reading ahead with " + ToStr(readThreads) + " threads, " + ToStr(depth) + " files deep.");
+        CelReadAheadTask task(*this, depth);
+        ThreadGroup::run(task, readThreads + 1);
+    }
+    else {
+        int cel_channel_count = 0;
+        for (int fileIx=0; fileIx < m_FileNames.size(); fileIx++) {
+            // process cel file
+            Verbose::progressStep(1);
+            DecodedCel decoded;
+            decodeFile(fileIx, decoded);
+            passOnFile(fileIx, decoded, cel_channel_count);
+        } // end reading cel files
+    }
 
     Verbose::progressEnd(1, "Done.");
 
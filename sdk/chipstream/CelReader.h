@@ -42,6 +42,8 @@
 #include <vector>
 //
 
+class DecodedCel;
+
 /**
  *  Class for reading cel files and passing the data to memory
  * representation and analysis objects.
@@ -50,7 +52,21 @@ class CelReader : public IntensityReader {
 
 public:
 
-  CelReader() : m_Size(0) {}
+  CelReader() : m_Size(0), m_ReadThreads(0), m_ReadDepth(0) {}
+
+  /** 
+   * @brief Read and decode the next cel files on other threads while
+   * the current one is being passed to the intensity marts and cel
+   * listeners. Files are still passed on in the order given.
+   * @param threads - Number of threads decoding cel files, 0 reads
+   * each file on the calling thread when it is needed.
+   * @param depth - Most decoded files waiting to be passed on (caps
+   * the memory used), 0 means twice the number of threads.
+   */
+  void setReadAhead(int threads, int depth) {
+    m_ReadThreads = threads;
+    m_ReadDepth = depth;
+  }
 
   /** 
    * @brief Do the heavy lifting of reading data from the cel files
@@ -87,12 +103,21 @@ public:
 
 private:
 
+  friend class CelReadAheadTask;
+
+  void decodeFile(int fileIx, DecodedCel &decoded);
+  void passOnFile(int fileIx, DecodedCel &decoded, int &celChannelCount);
+
   /// Vector of CelListeners to pass the cel file to
   std::vector<CelListener *> m_CelListeners;
   /// Number of features in the cel file
   int m_Size;
   /// object to track multi-CEL channels
   IdxGroup m_CelChannels;
+  /// Number of threads reading ahead, 0 for none.
+  int m_ReadThreads;
+  /// Most files decoded ahead of the one being passed on.
+  int m_ReadDepth;
 
 };
 
@@ -189,6 +189,24 @@ float ChipStream::getTransformedIntensity(probeidx_t probeIx, chipidx_t chipIx,
 
 
 
+/**
+ * @brief Retrieve a block of intensities from resident IntensityMart
+ *
+ * @param probeIds - Probe indexes on chip.
+ * @param channels - CEL file channel of each probe.
+ * @param chipCount - Number of chips to retrieve.
+ * @param block - Filled in probe major.
+ */
+void ChipStream::getTransformedIntensities(const std::vector<probeid_t> &probeIds,
+                                           const std::vector<unsigned int> &channels,
+                                           int chipCount,
+                                           std::vector<float> &block) {
+  if (m_TransformedIMart == NULL) {
+    Err::errAbort("ChipStream::getTransformedIntensities -- associated IntensityMart is NULL");
+  }
+  m_TransformedIMart->getProbeIntensities(probeIds, channels, chipCount, block);
+}
+
 /** 
  * @brief Set channelCount for this chipstream and all nodes downstream
  * 
@@ -156,6 +156,20 @@ public:
    */
   float getTransformedIntensity(probeidx_t probeIx, chipidx_t chipIx, unsigned int channelIx = 0);
 
+  /**
+   * @brief Retrieve a block of intensities from resident IntensityMart,
+   * see IntensityMart::getProbeIntensities().
+   *
+   * @param probeIds - Probe indexes on chip.
+   * @param channels - CEL file channel of each probe.
+   * @param chipCount - Number of chips to retrieve.
+   * @param block - Filled in probe major.
+   */
+  void getTransformedIntensities(const std::vector<probeid_t> &probeIds,
+                                 const std::vector<unsigned int> &channels,
+                                 int chipCount,
+                                 std::vector<float> &block);
+
   /** 
    * Do any setup specific to this ChipStream object using the data and state specified
    * in the blackboar.
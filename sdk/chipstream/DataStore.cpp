@@ -456,6 +456,43 @@ float DataStore::getProbeIntensity(probeid_t probeIx, chipid_t chipIx, unsigned
   return value;
 }
 
+void DataStore::getProbeIntensities(const std::vector<probeid_t> &probeIds,
+                                    const std::vector<unsigned int> &channels,
+                                    int chipCount,
+                                    std::vector<float> &block) const {
+  assert(probeIds.size() == channels.size());
+  block.resize(probeIds.size() * chipCount);
+  if (chipCount <= 0 || probeIds.empty()) {
+    return;
+  }
+  // Probes are stored in layout order so the probes of a probeset are
+  // (nearly) together. If they are spread out read them one at a time.
+  probeidx_t first = m_MapProbe[probeIds[0]];
+  probeidx_t last = first;
+  bool oneChannel = true;
+  for (size_t i = 1; i < probeIds.size(); i++) {
+    first = min(first, m_MapProbe[probeIds[i]]);
+    last = max(last, m_MapProbe[probeIds[i]]);
+    oneChannel &= (channels[i] == channels[0]);
+  }
+  int span = last - first + 1;
+  if (!oneChannel || span > 4 * (int)probeIds.size() + 64) {
+    IntensityMart::getProbeIntensities(probeIds, channels, chipCount, block);
+    return;
+  }
+  std::vector<float> rows(span);
+  for (int chipIx = 0; chipIx < chipCount; chipIx++) {
+    affx::File5_TsvColumn* column = m_Chips->getColumnPtr(0, getDataSetIx(chipIx, channels[0]));
+    int read = column->read_array(first, span, &rows[0]);
+    if (read != span) {
+      Err::errAbort("Error reading probes for chip: " + ToStr(chipIx) + " channel: " + ToStr(channels[0]));
+    }
+    for (size_t i = 0; i < probeIds.size(); i++) {
+      block[i * chipCount + chipIx] = rows[m_MapProbe[probeIds[i]] - first];
+    }
+  }
+}
+
 void DataStore::setProbeIntensity(float value, probeid_t probeIx, chipid_t chipIx) {
   m_Chips->gotoLine(m_MapProbe[probeIx]);
   m_Chips->set_f(0, chipIx, value);
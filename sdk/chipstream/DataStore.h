@@ -207,6 +207,16 @@ public :
    */
   virtual float getProbeIntensity(probeid_t probeIx, chipid_t chipIx, unsigned int channelIx = 0) const;
 
+  /**
+   * @brief Fill in the intensities of a block of probes on a block of
+   * chips, probe major. See IntensityMart::getProbeIntensities().
+   * Reads the stored rows spanned by the probes once per chip.
+   */
+  virtual void getProbeIntensities(const std::vector<probeid_t> &probeIds,
+                                   const std::vector<unsigned int> &channels,
+                                   int chipCount,
+                                   std::vector<float> &block) const;
+
   /** 
    * @brief Given the probe index and chip index return the intensity
    * data appropriate for that probe in that chip. Depending on the
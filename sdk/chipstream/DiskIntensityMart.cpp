@@ -70,6 +70,7 @@ DiskIntensityMart::DiskIntensityMart(const std::vector<int>& layoutOrder,
   m_NumChips = 0;
   m_TempPrefix = tempPrefix;
   m_StoreAllCelIntensities = storeAllCelIntensities;
+  m_ThreadShared = false;
 
   m_File5 = NULL;
   m_File5Name = "";
@@ -115,6 +116,7 @@ DiskIntensityMart::DiskIntensityMart(DiskIntensityMart& diskMart) {
   m_Flushed = diskMart.m_Flushed;
   m_NumChips = diskMart.m_NumChips;
   m_StoreAllCelIntensities = diskMart.m_StoreAllCelIntensities;
+  m_ThreadShared = false;
   m_File5 = diskMart.m_File5;
   m_File5Name = diskMart.m_File5Name;
   m_AnalysisOrder = diskMart.m_AnalysisOrder;
@@ -200,6 +202,14 @@ void DiskIntensityMart::setStoreAllCelIntensities(bool flag) {
   m_StoreAllCelIntensities = flag;
 }
 
+/**
+ * @brief Lock the cache on reads while the mart is shared by threads.
+ * @param shared - true while several threads read the mart.
+ */
+void DiskIntensityMart::setThreadShared(bool shared) {
+  m_ThreadShared = shared;
+}
+
 
 size_t DiskIntensityMart::getProbeCount() const {
   return m_Map.size();
@@ -236,6 +246,7 @@ DiskIntensityMart* DiskIntensityMart::copyMetaDataToEmptyMart() const {
   newMart->m_Map = m_Map;
   newMart->m_ChipChannelToCacheMap = m_ChipChannelToCacheMap;
   newMart->m_useAuxMemCache = m_useAuxMemCache;
+  newMart->m_ThreadShared = m_ThreadShared;
   return newMart;
 }
 
@@ -302,6 +313,19 @@ float DiskIntensityMart::getProbeIntensity(probeid_t pIx, chipid_t chipIx, unsig
     Verbose::out(1, ToStr("m_NumChips: ") + ToStr(m_NumChips));
   }
   assert(cacheIx < m_NumChips && cacheIx >= 0 && m_TmpVectors[cacheIx] != NULL);
+  if (m_ThreadShared) {
+    MutexLock lock(m_CacheLock);
+    return readProbeIntensity(pIx, cacheIx);
+  }
+  return readProbeIntensity(pIx, cacheIx);
+}
+
+/**
+ * @brief Read one intensity from the aux cache or the data files,
+ * loading the cache as needed. The caller holds m_CacheLock if the
+ * mart is shared by threads.
+ */
+float DiskIntensityMart::readProbeIntensity(probeid_t pIx, int cacheIx) const {
   float rtnVal = -1.0;
   if (m_AuxMemCache.size() > cacheIx && 
       m_AuxMemCache[cacheIx].find(pIx) != m_AuxMemCache[cacheIx].end()) {
@@ -318,6 +342,95 @@ float DiskIntensityMart::getProbeIntensity(probeid_t pIx, chipid_t chipIx, unsig
 }
 
 
+/**
+ * @brief Fill in the intensities of a block of probes on a block of
+ * chips, probe major. When the mart is shared by threads the cache
+ * lock is taken once for the block.
+ */
+void DiskIntensityMart::getProbeIntensities(const std::vector<probeid_t> &probeIds,
+                                            const std::vector<unsigned int> &channels,
+                                            int chipCount,
+                                            std::vector<float> &block) const {
+  if (m_ThreadShared) {
+    MutexLock lock(m_CacheLock);
+    readProbeIntensities(probeIds, channels, chipCount, block);
+  }
+  else {
+    readProbeIntensities(probeIds, channels, chipCount, block);
+  }
+}
+
+/**
+ * @brief Fill in a block for getProbeIntensities(). The cache is
+ * checked once per probe rather than once per intensity.
+ */
+void DiskIntensityMart::readProbeIntensities(const std::vector<probeid_t> &probeIds,
+                                             const std::vector<unsigned int> &channels,
+                                             int chipCount,
+                                             std::vector<float> &block) const {
+  assert(probeIds.size() == channels.size());
+  block.resize(probeIds.size() * chipCount);
+  if (chipCount <= 0) {
+    return;
+  }
+  // The cache index for each chip, looked up again only when the channel changes.
+  std::vector<int> cacheIxs(chipCount);
+  unsigned int cacheChannel = 0;
+  bool haveCacheIxs = false;
+  bool useAux = false;
+  for (size_t i = 0; i < probeIds.size(); i++) {
+    if (!haveCacheIxs || channels[i] != cacheChannel) {
+      cacheChannel = channels[i];
+      useAux = false;
+      for (int chipIx = 0; chipIx < chipCount; chipIx++) {
+        int cacheIx = chipIx;
+        if (!m_ChipChannelToCacheMap.empty()) {
+          cacheIx = m_ChipChannelToCacheMap[chipIx][cacheChannel];
+        }
+        if (!(cacheIx < m_NumChips && cacheIx >= 0) || m_TmpVectors[cacheIx] == NULL) {
+          Err::errAbort("DiskIntensityMart::getProbeIntensities() - Illegal read: No data has been written for chipIx: " + ToStr(chipIx));
+        }
+        cacheIxs[chipIx] = cacheIx;
+        useAux |= ((size_t)cacheIx < m_AuxMemCache.size() && !m_AuxMemCache[cacheIx].empty());
+      }
+      haveCacheIxs = true;
+    }
+    probeid_t pIx = probeIds[i];
+    assert(pIx < m_Map.size());
+    if (m_Map[pIx] < 0) {
+      Err::errAbort("DiskIntensityMart::getProbeIntensities() - Illegal value in map for probeIx: " + ToStr(pIx));
+    }
+    float *row = &block[i * chipCount];
+    if (useAux) {
+      // rare, probes not stored in the data files.
+      for (int chipIx = 0; chipIx < chipCount; chipIx++) {
+        int cacheIx = cacheIxs[chipIx];
+        std::map<int,float>::const_iterator result;
+        if ((size_t)cacheIx < m_AuxMemCache.size() && 
+            (result = m_AuxMemCache[cacheIx].find(pIx)) != m_AuxMemCache[cacheIx].end()) {
+          row[chipIx] = result->second;
+        }
+        else {
+          if (!inCache(pIx, cacheIx)) {
+            loadIntoCache(pIx, cacheIx);
+          }
+          row[chipIx] = m_Cache[cacheIx][m_Map[pIx] - m_CacheStart];
+        }
+      }
+    }
+    else {
+      // the cache holds the same rows for all the chips.
+      if (!inCache(pIx, cacheIxs[0])) {
+        loadIntoCache(pIx, cacheIxs[0]);
+      }
+      int offset = m_Map[pIx] - m_CacheStart;
+      for (int chipIx = 0; chipIx < chipCount; chipIx++) {
+        row[chipIx] = m_Cache[cacheIxs[chipIx]][offset];
+      }
+    }
+  }
+}
+
 void DiskIntensityMart::setProbeIntensity(const int dataIdx, const std::vector<float> &data) {
 
   assert(data.size() > 0);
@@ -44,6 +44,7 @@
 #include "file5/File5.h"
 #include "portability/affy-base-types.h"
 
+#include "util/Thread.h"
 #include "util/Util.h"
 //
 #include <cstring>
@@ -168,6 +169,15 @@ public :
   int getChannelCount() const;
 
   float getProbeIntensity(probeid_t pIx, chipid_t chipIx, unsigned int channelIx = 0) const;
+
+  /**
+   * @brief Fill in the intensities of a block of probes on a block of
+   * chips, probe major. See IntensityMart::getProbeIntensities().
+   */
+  void getProbeIntensities(const std::vector<probeid_t> &probeIds,
+                           const std::vector<unsigned int> &channels,
+                           int chipCount,
+                           std::vector<float> &block) const;
   
   void setProbeIntensity(const int dataIdx, const std::vector<float> &data);
 /*     Err::errAbort("DiskIntensityMart::setProbeIntensity() - Not implemented."); */
@@ -197,6 +207,12 @@ public :
    */
   void setStoreAllCelIntensities(bool flag);
 
+  /**
+   * @brief Lock the cache on reads while the mart is shared by threads.
+   * @param shared - true while several threads read the mart.
+   */
+  void setThreadShared(bool shared);
+
   /** 
    * Open a CEL file and see how many probes are stored in it.
    * @param celFile - Path to cel file of interest.
@@ -219,6 +235,13 @@ private:
   void deleteTmpfile() const;
   /// Get the name of the tmpfile to use.
   std::string getFile5Name() const;
+  /// getProbeIntensity() without the lock.
+  float readProbeIntensity(probeid_t pIx, int cacheIx) const;
+  /// getProbeIntensities() without the lock.
+  void readProbeIntensities(const std::vector<probeid_t> &probeIds,
+                            const std::vector<unsigned int> &channels,
+                            int chipCount,
+                            std::vector<float> &block) const;
 
   /// Names of the data files that are being used to read.
   std::vector<std::string> m_CelFiles;
@@ -235,6 +258,10 @@ private:
 
   /// Cache of data in memory
   mutable std::vector< std::vector<float> > m_Cache;
+  /// Is the mart read by several threads? See setThreadShared().
+  bool m_ThreadShared;
+  /// Guards the cache while m_ThreadShared is set.
+  mutable Mutex m_CacheLock;
 
   /// Directory for temp files
   std::string m_TempDir;
@@ -31,6 +31,8 @@
 
 #include "chipstream/IntensityMart.h"
 #include "chipstream/IdxGroup.h"
+//
+#include <cassert>
 
 
 /**
@@ -41,6 +43,27 @@ void IntensityMart::setChannelMapping(const IdxGroup &idxGroup) {
     m_CelChannels = idxGroup;
 }
 
+/** 
+ * @brief Fill in the intensities of a block of probes on a block
+ * of chips, probe major. See IntensityMart.h
+ */
+void IntensityMart::getProbeIntensities(const std::vector<probeid_t> &probeIds,
+                                        const std::vector<unsigned int> &channels,
+                                        int chipCount,
+                                        std::vector<float> &block) const {
+    assert(probeIds.size() == channels.size());
+    block.resize(probeIds.size() * chipCount);
+    if (chipCount <= 0) {
+        return;
+    }
+    for (size_t i = 0; i < probeIds.size(); i++) {
+        float *row = &block[i * chipCount];
+        for (int chipIx = 0; chipIx < chipCount; chipIx++) {
+            row[chipIx] = getProbeIntensity(probeIds[i], chipIx, channels[i]);
+        }
+    }
+}
+
 /**
  * @brief get number of CEL channels according to m_ChipChannelToCacheMap
  */
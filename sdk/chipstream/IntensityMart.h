@@ -75,6 +75,25 @@ public:
      */
     virtual float getProbeIntensity(probeid_t probeIx, chipid_t chipIx, unsigned int channelIx = 0) const = 0;
 
+    /** 
+     * @brief Fill in the intensities of a block of probes on a block
+     * of chips in one call, rather than calling getProbeIntensity()
+     * for each probe and chip. The block is probe major, the
+     * intensity of probeIds[i] on chip chipIx is at
+     * block[i * chipCount + chipIx]. The default calls
+     * getProbeIntensity(), marts override it to do their lookups once
+     * per probe rather than once per intensity.
+     * 
+     * @param probeIds - Probe Index numbers.
+     * @param channels - CEL channel to use for each probe.
+     * @param chipCount - Chips 0..chipCount-1 are filled in.
+     * @param block - Resized to probeIds.size() * chipCount and filled in.
+     */
+    virtual void getProbeIntensities(const std::vector<probeid_t> &probeIds,
+                                     const std::vector<unsigned int> &channels,
+                                     int chipCount,
+                                     std::vector<float> &block) const;
+
     /** 
      * @brief Return all of the intensities for given chipIx
      * @param chipIx - Chip Index number.
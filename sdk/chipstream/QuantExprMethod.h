@@ -212,6 +212,11 @@ protected :
   std::string m_Type; 
   /// Probes used, memory not owned here. 
   std::vector<Probe *> m_Probes;
+  /// Scratch space for setUp() to get a probes x chips block of
+  /// intensities with transformPrimaryData().
+  std::vector<probeid_t> m_BlockProbeIds;
+  std::vector<unsigned int> m_BlockChannels;
+  std::vector<float> m_Block;
 };
 
 #endif /* _QUANTMETHOD_H_ */
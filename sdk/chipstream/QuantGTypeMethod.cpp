@@ -38,7 +38,169 @@
 
 using namespace affx;
 
-QuantGTypeMethod::~QuantGTypeMethod() {}
+/**
+ * What a QuantExprMethod had to report for one allele, kept so the
+ * reporters can be called after the method has moved on (see
+ * QuantGTypeMethod::cloneForThread()). Feature effects and residuals
+ * are only kept when the method has them; asking for them otherwise
+ * is an error, as it would be for the method.
+ */
+class QuantExprMethodSnapshot : public QuantExprMethod {
+public:
+  QuantExprMethodSnapshot(QuantExprMethod &qMethod) {
+    m_Type = qMethod.getType();
+    m_Version = qMethod.getVersion();
+    m_Scale = qMethod.getScale();
+    m_QuantType = qMethod.getQuantType();
+    m_SummarySuffix = qMethod.getSummarySuffix();
+    m_FeatureResponseSuffix = qMethod.getFeatureResponseSuffix();
+    m_ResidualSuffix = qMethod.getResidualSuffix();
+    m_NumFeatures = qMethod.getNumFeatures();
+    m_NumTargets = qMethod.getNumTargets();
+    m_HaveFeatureEffects = qMethod.haveFeatureEffects();
+    m_HaveResiduals = qMethod.haveResiduals();
+    m_FeatureUsed.resize(m_NumFeatures);
+    m_Features.resize(m_NumFeatures);
+    for (unsigned int featIx = 0; featIx < m_NumFeatures; featIx++) {
+      m_FeatureUsed[featIx] = qMethod.featureUsed(featIx);
+      m_Features[featIx] = qMethod.getFeature(featIx);
+      if (m_HaveFeatureEffects) {
+        m_FeatureEffects.push_back(qMethod.getFeatureEffect(featIx));
+      }
+      if (m_HaveResiduals) {
+        for (unsigned int chipIx = 0; chipIx < m_NumTargets; chipIx++) {
+          m_Residuals.push_back(qMethod.getResidual(featIx, chipIx));
+        }
+      }
+    }
+    for (unsigned int chipIx = 0; chipIx < m_NumTargets; chipIx++) {
+      m_TargetEffects.push_back(qMethod.getTargetEffect(chipIx));
+      m_SignalEstimates.push_back(qMethod.getSignalEstimate(chipIx));
+    }
+  }
+
+  unsigned int getNumFeatures() { return m_NumFeatures; }
+  unsigned int getNumTargets() { return m_NumTargets; }
+  bool haveFeatureEffects() { return m_HaveFeatureEffects; }
+  bool haveResiduals() { return m_HaveResiduals; }
+
+  double getFeatureEffect(unsigned int probeIx) {
+    if (!m_HaveFeatureEffects) {
+      Err::errAbort("QuantExprMethodSnapshot::getFeatureEffect() - " + m_Type + " doesn't have feature effects.");
+    }
+    return m_FeatureEffects.at(probeIx);
+  }
+  double getResidual(unsigned int probeIx, unsigned int chipIx) {
+    if (!m_HaveResiduals) {
+      Err::errAbort("QuantExprMethodSnapshot::getResidual() - " + m_Type + " doesn't have residuals.");
+    }
+    return m_Residuals.at(probeIx * m_NumTargets + chipIx);
+  }
+  double getTargetEffect(unsigned int chipIx) { return m_TargetEffects.at(chipIx); }
+  double getSignalEstimate(unsigned int chipIx) { return m_SignalEstimates.at(chipIx); }
+  bool featureUsed(unsigned int probeIx) { return m_FeatureUsed.at(probeIx); }
+  const Probe *getFeature(unsigned int probeIx) { return m_Features.at(probeIx); }
+  const std::string &getSummarySuffix() { return m_SummarySuffix; }
+  const std::string &getFeatureResponseSuffix() { return m_FeatureResponseSuffix; }
+  const std::string &getResidualSuffix() { return m_ResidualSuffix; }
+  std::string getVersion() { return m_Version; }
+  enum Scale getScale() { return m_Scale; }
+  enum QuantType getQuantType() { return m_QuantType; }
+
+  // Nothing is computed by a snapshot.
+  bool setUp(ProbeSetGroup &psGroup, const IntensityMart &iMart,
+             std::vector<ChipStream *> &iTrans, PmAdjuster &pmAdjust) {
+    notSupported("setUp");
+    return false;
+  }
+  void computeEstimate() { notSupported("computeEstimate"); }
+  void setPMDataAt(unsigned int probeIx, unsigned int chipIx, double data) { notSupported("setPMDataAt"); }
+  double getPMDataAt(unsigned int probeIx, unsigned int chipIx) { notSupported("getPMDataAt"); return 0; }
+  void setMMDataAt(unsigned int probeIx, unsigned int chipIx, double data) { notSupported("setMMDataAt"); }
+  void clear() { notSupported("clear"); }
+  void setBounds(unsigned int numProbes, unsigned int numChips) { notSupported("setBounds"); }
+
+private:
+  void notSupported(const char *what) {
+    Err::errAbort(std::string("QuantExprMethodSnapshot::") + what + "() - not supported.");
+  }
+
+  std::string m_Version;
+  enum Scale m_Scale;
+  enum QuantType m_QuantType;
+  std::string m_SummarySuffix;
+  std::string m_FeatureResponseSuffix;
+  std::string m_ResidualSuffix;
+  unsigned int m_NumFeatures;
+  unsigned int m_NumTargets;
+  bool m_HaveFeatureEffects;
+  bool m_HaveResiduals;
+  std::vector<bool> m_FeatureUsed;
+  std::vector<const Probe *> m_Features;
+  std::vector<double> m_FeatureEffects;
+  std::vector<double> m_Residuals; ///< feature major.
+  std::vector<double> m_TargetEffects;
+  std::vector<double> m_SignalEstimates;
+};
+
+/**
+ * An allele summary report held by a thread copy. The probeset shares
+ * its atoms with the genotyping probeset, which has to outlive it.
+ */
+class QuantGTypeDeferredReport {
+public:
+  QuantGTypeDeferredReport(const ProbeSet &pSet, QuantExprMethod &qMethod) : m_Summary(qMethod) {
+    m_ProbeSet = new ProbeSet();
+    m_ProbeSet->name = Util::cloneString(pSet.name);
+    m_ProbeSet->psType = pSet.psType;
+    m_ProbeSet->numGroups = pSet.numGroups;
+    m_ProbeSet->atomsPerGroup = pSet.atomsPerGroup;
+    m_ProbeSet->atoms = pSet.atoms;
+  }
+
+  ~QuantGTypeDeferredReport() {
+    // the atoms aren't ours.
+    delete [] m_ProbeSet->name;
+    m_ProbeSet->name = NULL;
+    m_ProbeSet->atoms.clear();
+    delete m_ProbeSet;
+  }
+
+  ProbeSet *m_ProbeSet;
+  QuantExprMethodSnapshot m_Summary;
+};
+
+QuantGTypeMethod::QuantGTypeMethod() {
+  m_GtProbeSet = NULL;
+  m_DeferAlleleReports = false;
+}
+
+QuantGTypeMethod::~QuantGTypeMethod() {
+  clearDeferredReports();
+}
+
+void QuantGTypeMethod::clearDeferredReports() {
+  for (size_t i = 0; i < m_DeferredReports.size(); i++) {
+    delete m_DeferredReports[i];
+  }
+  m_DeferredReports.clear();
+}
+
+void QuantGTypeMethod::replayAlleleReports(QuantGTypeMethod &copy,
+                                           std::vector<QuantMethodReport *> &reporters,
+                                           const IntensityMart &iMart,
+                                           std::vector<ChipStream *> &iTrans,
+                                           PmAdjuster &pmAdjust) {
+  for (size_t rIx = 0; rIx < copy.m_DeferredReports.size(); rIx++) {
+    QuantGTypeDeferredReport *deferred = copy.m_DeferredReports[rIx];
+    ProbeSetGroup group(deferred->m_ProbeSet);
+    for (unsigned int i = 0; i < reporters.size(); i++) {
+      reporters[i]->report(group, deferred->m_Summary, iMart, iTrans, pmAdjust);
+    }
+    group.probeSets.clear();
+  }
+  copy.clearDeferredReports();
+}
 
 /** 
  * Get the genotype call at specified index (sample).
@@ -144,8 +306,14 @@ bool QuantGTypeMethod::summarizeAllele(ProbeSet *pSet,
   }
   /* print out a report if necessary. */
   if(success && doReport) {
-    for(unsigned int i = 0; i < reporters.size(); i++) {
-      reporters[i]->report(group, *quantMethod, iMart, iTrans, pmAdjust);
+    if(m_DeferAlleleReports) {
+      if(!reporters.empty())
+        m_DeferredReports.push_back(new QuantGTypeDeferredReport(*pSet, *quantMethod));
+    }
+    else {
+      for(unsigned int i = 0; i < reporters.size(); i++) {
+        reporters[i]->report(group, *quantMethod, iMart, iTrans, pmAdjust);
+      }
     }
   }
   /* clear out probesets to prevent deleting them. */
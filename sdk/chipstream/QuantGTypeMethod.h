@@ -37,8 +37,11 @@
 //
 #include <cstring>
 #include <string>
+#include <vector>
 //
 
+class QuantGTypeDeferredReport;
+
 /**
  * Quantification methods used for making genotyping calls implement (currently
  * just brlmm) this interface.
@@ -46,6 +49,7 @@
 class QuantGTypeMethod : public QuantMethod {
 
 public:
+  QuantGTypeMethod();
   virtual ~QuantGTypeMethod();
 
   /** 
@@ -149,6 +153,37 @@ public:
       return "";
   }
 
+  /** 
+   * Make a copy of this method with the same configuration which can
+   * set up and compute probesets on another thread. The copy does not
+   * write anything itself: its allele summary reports (and any per
+   * probeset files) are held until writeThreadOutput() is called with
+   * it, which must be done in probeset order.
+   * 
+   * @param summaryMethod - Allele summary method for the copy, made
+   * the same way as this method's. Owned by the copy if one is made.
+   * @return - the copy or NULL if this method (as configured) can't
+   * be run on several threads.
+   */
+  virtual QuantGTypeMethod *cloneForThread(QuantExprMethod *summaryMethod) {
+    return NULL;
+  }
+
+  /** 
+   * Write out what the copy (from cloneForThread()) held back for the
+   * probeset it last set up and computed.
+   * 
+   * @param copy - Thread copy of this method.
+   * @param iMart - Raw data, passed to the reporters.
+   * @param iTrans - Transformations, passed to the reporters.
+   * @param pmAdjust - Background adjuster, passed to the reporters.
+   */
+  virtual void writeThreadOutput(QuantGTypeMethod &copy,
+                                 const IntensityMart &iMart,
+                                 std::vector<ChipStream *> &iTrans, 
+                                 PmAdjuster &pmAdjust) {
+  }
+
 protected:
   /** clear a probe set*/
   void clearProbeSet(ProbeSet &ps); 
@@ -187,6 +222,16 @@ protected:
   
   bool canSetUpProbeSet(const ProbeSet* gtPs);
 
+  /** Hand the allele summary reports held by copy to our reporters. */
+  void replayAlleleReports(QuantGTypeMethod &copy,
+                           std::vector<QuantMethodReport *> &reporters,
+                           const IntensityMart &iMart,
+                           std::vector<ChipStream *> &iTrans, 
+                           PmAdjuster &pmAdjust);
+
+  /** Free the held allele summary reports. */
+  void clearDeferredReports();
+
 protected:
   std::vector<affx::GType> m_Calls;
   const ProbeSet *m_GtProbeSet; ///< Genotyping probeset currently using.
@@ -195,6 +240,8 @@ protected:
   ProbeSet m_Ballele; ///< Probeset to detect the B allele
   std::vector<double> m_AValues;  ///< Our summarized values for A allele intensity
   std::vector<double> m_BValues;  ///< Our summarized values for B allele intensity
+  bool m_DeferAlleleReports; ///< Hold allele summary reports rather than making them? (thread copies)
+  std::vector<QuantGTypeDeferredReport *> m_DeferredReports; ///< Held allele summary reports.
 };
 
 #endif /* QUANTGTYPEMETHOD_H */
@@ -106,6 +106,8 @@ QuantLabelZ::QuantLabelZ(enum Transformation transform,
   m_SnpPosteriorTsv_ver=-1;
   m_ProbeSetsToReport = NULL;
   m_ZWGenderCalling = false;
+  m_SharedSnpPriors = false;
+  m_HoldPosteriors = false;
 
   setupSelfDoc(*this);
   setOptValue("transform", stringForTransformation(m_Param.m_Transform));
@@ -134,6 +136,8 @@ QuantLabelZ::~QuantLabelZ()
       delete *it;
     }
   m_Reporters.clear();
+  if (m_SharedSnpPriors)
+    m_vectSnpPriors.clear();
   m_vectSnpPriors.deleteAll();
   if (m_QuantMethod != NULL) {delete m_QuantMethod; m_QuantMethod = NULL;}
 }
@@ -600,10 +604,6 @@ void QuantLabelZ::SubsetSetup(vector<int> &samplesubset, int &subsetlength, int
  */
 void QuantLabelZ::computeEstimate() {
 
-
-  static int call_count = 0;
-  call_count++;
-  
   snp_labeled_distribution objSearch;
   // first, do anything necessary
   PreprocessValues();
@@ -727,7 +727,7 @@ void QuantLabelZ::computeEstimate() {
       // am I getting anything useful here
      
       // note: using temporary copy of main parameters tsp
-      bayes_label(tcall,tconf,tx,ty,GenoHint,SubsetInbredPenalty,tsp,txa,txh,txb,m_OutputProbabilities);
+      bayes_label(tcall,tconf,tx,ty,GenoHint,SubsetInbredPenalty,tsp,txa,txh,txb,m_OutputProbabilities,m_LabelWorkspace);
 
       // transfer data to calls
       t_place_subset(m_Calls,tcall,samplesubset);
@@ -763,6 +763,9 @@ void QuantLabelZ::computeEstimate() {
       if (m_SnpPosteriorTsv.is_open()) {
         writeSnpPosteriorValue(TmpName, tsp);
       }
+      else if (m_HoldPosteriors) {
+        m_HeldPosteriors.push_back(std::make_pair(TmpName, tsp));
+      }
 
     } // done processing this copy number
   } // back into the loop for more copy number tries
@@ -793,6 +796,8 @@ bool QuantLabelZ::setUp(ProbeSetGroup &psGroup, const IntensityMart &iMart,
                         std::vector<ChipStream *> &iTrans, PmAdjuster &pmAdjust) {
 	const ProbeSet *gtPs = NULL; //		Genotyping probeset
   blankSelf(); // Make sure we clear out the past analysis before starting this one.
+  clearDeferredReports();
+  m_HeldPosteriors.clear();
   bool success = true;
   /* Sanity checks about probesets. */
   if (psGroup.probeSets.empty())
@@ -808,6 +813,72 @@ bool QuantLabelZ::setUp(ProbeSetGroup &psGroup, const IntensityMart &iMart,
   return success;
 }
 
+/**
+ * Make a copy for computing probesets on another thread. Everything
+ * set up by the engine before the first probeset is copied (or shared
+ * when read only, like the snp priors). The copy doesn't write the snp
+ * posterior file or call the allele summary reporters; that is done by
+ * writeThreadOutput() in probeset order.
+ *
+ * Files read or written in step with the probesets (sequential models,
+ * probe selection and normalized summaries) and the trust check can't
+ * be done out of order, so no copy is made for those.
+ *
+ * @param summaryMethod - Allele summary method, owned by the copy.
+ * @return - New copy or NULL.
+ */
+QuantGTypeMethod *QuantLabelZ::cloneForThread(QuantExprMethod *summaryMethod) {
+  if (m_SequentialModelTsv.is_open() || m_SnpProbeTsv.is_open() || 
+      m_NormSummaryTsv.is_open() || m_bProbeSetTrustOpt) {
+    return NULL;
+  }
+  QuantLabelZ *copy = new QuantLabelZ(m_Param.m_Transform, m_Param.m_K, m_Param.m_LowPrecision);
+  copy->m_Param = m_Param;
+  copy->sp.copy(sp);
+  copy->LabelzMaxScore = LabelzMaxScore;
+  copy->em_thresh = em_thresh;
+  copy->em_cutoff = em_cutoff;
+  copy->gender_cutoff = gender_cutoff;
+  copy->m_bCopyNumber = m_bCopyNumber;
+  copy->m_SelectionOverride = m_SelectionOverride;
+  copy->m_OutputProbabilities = m_OutputProbabilities;
+  copy->m_ZWGenderCalling = m_ZWGenderCalling;
+  copy->m_bProbeSetTrustOpt = m_bProbeSetTrustOpt;
+  copy->m_Info = m_Info;
+  copy->setNorm(normMap);
+  copy->m_SnpCovarMap = m_SnpCovarMap;
+  copy->m_HaploidSnps = m_HaploidSnps;
+  copy->m_SpecialSnps = m_SpecialSnps;
+  copy->m_SpecialSampleSnps = m_SpecialSampleSnps;
+  copy->m_SpecialSampleNames = m_SpecialSampleNames;
+  copy->m_Genders = m_Genders;
+  copy->m_InbredHetPenalty = m_InbredHetPenalty;
+  copy->m_KnownGenoTypes = m_KnownGenoTypes;
+  copy->m_ProbeSetsToReport = m_ProbeSetsToReport;
+  copy->m_vectSnpPriors.assign(m_vectSnpPriors.begin(), m_vectSnpPriors.end());
+  copy->m_SharedSnpPriors = true;
+  copy->m_QuantMethod = summaryMethod;
+  copy->m_DeferAlleleReports = true;
+  copy->m_HoldPosteriors = m_SnpPosteriorTsv.is_open();
+  return copy;
+}
+
+/**
+ * Report the allele summaries and write the snp posteriors held by a
+ * copy made with cloneForThread().
+ */
+void QuantLabelZ::writeThreadOutput(QuantGTypeMethod &copy,
+                                    const IntensityMart &iMart,
+                                    std::vector<ChipStream *> &iTrans, 
+                                    PmAdjuster &pmAdjust) {
+  QuantLabelZ &lzCopy = static_cast<QuantLabelZ &>(copy);
+  replayAlleleReports(copy, m_Reporters, iMart, iTrans, pmAdjust);
+  for (size_t i = 0; i < lzCopy.m_HeldPosteriors.size(); i++) {
+    writeSnpPosteriorValue(lzCopy.m_HeldPosteriors[i].first, lzCopy.m_HeldPosteriors[i].second);
+  }
+  lzCopy.m_HeldPosteriors.clear();
+}
+
 /**
  * Construct a contrast normalization function from a collection of probesets. *
  * @param probeSets - ProbeSets to be used in computing normalizer.
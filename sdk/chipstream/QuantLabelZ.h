@@ -610,6 +610,13 @@ public:
 
   virtual void setParameters(PsBoard &board);
 
+  virtual QuantGTypeMethod *cloneForThread(QuantExprMethod *summaryMethod);
+
+  virtual void writeThreadOutput(QuantGTypeMethod &copy,
+                                 const IntensityMart &iMart,
+                                 std::vector<ChipStream *> &iTrans, 
+                                 PmAdjuster &pmAdjust);
+
   // ArtifactReduction
   //do a dummy trick which will explode memory painfully
   //avert by loading in only probeset-id's that are relevant?
@@ -643,6 +650,7 @@ protected:
   //  std::map<std::string, snp_param> m_SnpPriorMap; ///< customized priors indexed by probeset name
   //AffxArray<snp_posterior> m_vectSnpPriors;
   snp_param sp; ///< parameters used by labeling
+  label_workspace m_LabelWorkspace; ///< scratch space reused by bayes_label, one per thread copy
   std::vector<double> m_Confidences; ///< Our resulting confidences in those calls.
   AffxArray<snp_labeled_distribution> m_vectSnpPriors;
   std::vector<std::vector<double> > m_Distances; ///< standardized distances from AA, AB, and BB cluster centers
@@ -693,6 +701,11 @@ private:
   std::vector< unsigned int > m_B_probeId; ///< individual probe indexes B
   int m_SelectionOverride; ///< override calls with references for selection
 
+  // thread copies (see cloneForThread())
+  bool m_SharedSnpPriors; ///< m_vectSnpPriors belongs to the method we were copied from.
+  bool m_HoldPosteriors;  ///< Keep snp posteriors in m_HeldPosteriors rather than writing them.
+  std::vector<std::pair<std::string, snp_param> > m_HeldPosteriors;
+
 public:
 
   // Artifact Reduction
@@ -966,7 +966,8 @@ void QuantLabelZMulti::computeEstimate(){
     }
  
     // Do the genotyping call.
-    bayes_label(tcall,tconf,tx,ty,GenoHint,SubsetInbredPenalty,tsp);
+    vector<double> ted,teh,tec;
+    bayes_label(tcall,tconf,tx,ty,GenoHint,SubsetInbredPenalty,tsp,ted,teh,tec,false,m_LabelWorkspace);
 
     // Now amalgamate the tcall tconf and tsp values into the data structure m_CallsMulti m_Confidences and 
     // m_Distance for reporting. 
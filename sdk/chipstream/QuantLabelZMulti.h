@@ -112,6 +112,11 @@ class QuantLabelZMulti : public QuantLabelZ {
 
     virtual ~QuantLabelZMulti() {
       delete m_coder;
+    }
+
+    /** The multi allele calls aren't set up for thread copies yet. */
+    virtual QuantGTypeMethod *cloneForThread(QuantExprMethod *summaryMethod) {
+      return NULL;
     } 
 
     static SelfCreate *newObject(std::map<std::string,std::string> &param); 
@@ -118,6 +118,32 @@ float QuantMethod::transformPrimaryData(probeid_t probeIx,
   return intensity;
 }
 
+/** 
+ * @brief Block version of transformPrimaryData(), fills in the
+ * transformed data for a set of probes on all the chips with one
+ * call to the IntensityMart.
+ * 
+ * @param probeIds - Probe indexes on chip.
+ * @param channels - Channel of each probe.
+ * @param chipCount - Number of chips in experiment.
+ * @param iMart - Raw data. 
+ * @param iTrans - Transformations to be applied to data.
+ * @param block - Filled in probe major, block[i * chipCount + chipIx].
+ */
+void QuantMethod::transformPrimaryData(const std::vector<probeid_t> &probeIds,
+                                       const std::vector<unsigned int> &channels,
+                                       int chipCount,
+                                       const IntensityMart &iMart, 
+                                       std::vector<ChipStream *> &iTrans,
+                                       std::vector<float> &block) {
+  if (iTrans.empty()) {
+    iMart.getProbeIntensities(probeIds, channels, chipCount, block);
+  }
+  else {
+    iTrans[iTrans.size() - 1]->getTransformedIntensities(probeIds, channels, chipCount, block);
+  }
+}
+
 /** 
  * @brief Returns PM minus attenuated mismatch value so such that the return value is 
  * greater than or equal to zero. In short, we return (x+sqrt(x^2+H))/2 where 
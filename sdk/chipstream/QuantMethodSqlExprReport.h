@@ -33,6 +33,7 @@
 //
 #include "chipstream/QuantExprMethod.h"
 #include "chipstream/QuantMethodReport.h"
+#include "chipstream/SqlSampleTable.h"
 #include "chipstream/TsvReport.h"
 //
 #include "util/Util.h"
@@ -52,8 +53,14 @@ public:
 
   /**
    * Constructor
+   * @param databaseFile - sqlite file to write.
+   * @param tableName - Table for the summaries.
+   * @param psNameLength - Longest probeset name.
+   * @param blobLayout - One row per probeset with the summaries packed
+   *   in a blob rather than a column per cel file. (See SqlSampleTable.)
    */
-  QuantMethodSqlExprReport(const std::string &databaseFile, const std::string &tableName, int psNameLength=30);
+  QuantMethodSqlExprReport(const std::string &databaseFile, const std::string &tableName, int psNameLength=30,
+                           bool blobLayout=false);
 
   /**
    * Virtual destructor for a virtual class.
@@ -126,10 +133,6 @@ public:
 
 private:
 
-  void createSummaryTable(sqlite3 *db, const std::string &tableName, const IntensityMart &iMart);
-
-  void createMetaTable(sqlite3 *db, const std::string &metaTableName);
-
   /// Size of longest name
   int m_MaxPsNameLength;
   /// Database that we are writing to
@@ -140,6 +143,12 @@ private:
   std::string m_TableName;
   /// Name of the database table that contains the meta information usually found in headers
   std::string m_TableMetaName;
+  /// Column per cel file or packed blob.
+  SqlSampleTable::Layout m_Layout;
+  /// Prepared insert into m_TableName.
+  SqlSampleTable m_Table;
+  /// Reused for each probeset's summaries.
+  std::vector<double> m_Values;
 
 };
 
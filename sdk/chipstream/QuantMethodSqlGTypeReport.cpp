@@ -22,11 +22,11 @@
 #include "chipstream/QuantMethodSqlGTypeReport.h"
 //
 #include "chipstream/QuantGTypeMethod.h"
-#include "chipstream/QuantMethodSqlExprReport.h"
 
 using namespace std;
 
-QuantMethodSqlGTypeReport::QuantMethodSqlGTypeReport(const std::string &databaseFile, const std::string &callTable, const std::string &confTable, int maxNameLength) {
+QuantMethodSqlGTypeReport::QuantMethodSqlGTypeReport(const std::string &databaseFile, const std::string &callTable, const std::string &confTable, int maxNameLength,
+                                                     bool blobLayout) {
   m_CallDbFileName = databaseFile + ".call" + ".db";
   m_ConfDbFileName = databaseFile + ".conf" + ".db";
   m_CallTable = callTable;
@@ -34,6 +34,7 @@ QuantMethodSqlGTypeReport::QuantMethodSqlGTypeReport(const std::string &database
   m_ConfTable = confTable;
   m_ConfMetaTable = confTable + "_meta";
   m_MaxPsNameLength = maxNameLength;
+  m_Layout = blobLayout ? SqlSampleTable::LayoutBlob : SqlSampleTable::LayoutColumns;
   int status = 0;
   if ((status =  sqlite3_open(m_CallDbFileName.c_str(), &m_CallDb)) != SQLITE_OK) {
     Err::errAbort("Couldn't open database: " + m_CallDbFileName + " got error code: " + ToStr(status));
@@ -41,10 +42,14 @@ QuantMethodSqlGTypeReport::QuantMethodSqlGTypeReport(const std::string &database
   if ((status =  sqlite3_open(m_ConfDbFileName.c_str(), &m_ConfDb)) != SQLITE_OK) {
     Err::errAbort("Couldn't open database: " + m_ConfDbFileName + " got error code: " + ToStr(status));
   }
+  SqlSampleTable::setBulkPragmas(m_CallDb);
+  SqlSampleTable::setBulkPragmas(m_ConfDb);
 }
 
 QuantMethodSqlGTypeReport::~QuantMethodSqlGTypeReport() {
   int status = 0;
+  m_CallTableWriter.release();
+  m_ConfTableWriter.release();
   // Close the sqlite database 
   if ((status = sqlite3_close(m_CallDb)) != SQLITE_OK) {
    Verbose::warn(0, "Error trying to close the database with error code: " + ToStr(status));
@@ -55,11 +60,10 @@ QuantMethodSqlGTypeReport::~QuantMethodSqlGTypeReport() {
 }
 
 bool QuantMethodSqlGTypeReport::prepare(QuantMethod &qMethod, const IntensityMart &iMart) {
-  string sql = "begin transaction;";
-  createCallTable(m_CallDb, m_CallTable, iMart);
-  QuantMethodSqlExprReport::execute(m_CallDb, sql);
-  createConfTable(m_ConfDb, m_ConfTable, iMart);
-  QuantMethodSqlExprReport::execute(m_ConfDb, sql);
+  m_CallTableWriter.create(m_CallDb, m_CallTable, iMart.getCelFileNames(), m_MaxPsNameLength,
+                           SqlSampleTable::ValueInteger, m_Layout);
+  m_ConfTableWriter.create(m_ConfDb, m_ConfTable, iMart.getCelFileNames(), m_MaxPsNameLength,
+                           SqlSampleTable::ValueReal, m_Layout);
   return true;
 }
 
@@ -68,8 +72,6 @@ bool QuantMethodSqlGTypeReport::report(ProbeSetGroup &psGroup,
                                        const IntensityMart &iMart, 
                                        std::vector<ChipStream *> &iTrans, 
                                        PmAdjuster &pmAdjust) {
-  static char buf[256];
-  static string delim = ",";
   QuantGTypeMethod *gMethod = dynamic_cast<QuantGTypeMethod *>(&qMethod);
   if(gMethod == NULL) {
     Err::errAbort("Can only use a QuantMethodGTypeReport with QuantGTypeMethods.");
@@ -77,49 +79,17 @@ bool QuantMethodSqlGTypeReport::report(ProbeSetGroup &psGroup,
   std::string name = gMethod->getProbeSetName();
   int targetCount = gMethod->getNumCalls();
 
-  string insertCalls = "insert into " + m_CallTable + " values ( '" + psGroup.name + "' ";
-  string insertConf = "insert into " + m_ConfTable + " values ( '" + psGroup.name + "' ";
+  m_Calls.resize(targetCount);
+  m_Confs.resize(targetCount);
   for(int i = 0; i < targetCount; i++) {
-    snprintf(buf, ArraySize(buf), "%.3g", gMethod->getConfidence(i));
-    insertConf += delim + buf;
-    insertCalls += delim + ToStr((int)gMethod->getCall(i));
+    m_Confs[i] = gMethod->getConfidence(i);
+    m_Calls[i] = (int)gMethod->getCall(i);
   }
-  insertCalls += ");";
-  insertConf  += ");";
-  QuantMethodSqlExprReport::execute(m_CallDb, insertCalls);
-  QuantMethodSqlExprReport::execute(m_ConfDb, insertConf);
+  m_CallTableWriter.insert(psGroup.name, m_Calls);
+  m_ConfTableWriter.insert(psGroup.name, m_Confs);
   return true;
 }
 
-void QuantMethodSqlGTypeReport::createConfTable(sqlite3 *db, const std::string &tableName, const IntensityMart &iMart) {
-  string createSql = "create table " + tableName + " ( probeset_id varchar(" + ToStr(m_MaxPsNameLength) + "), ";
-  for(int i = 0; i < iMart.getCelFileNames().size(); i++) {
-    createSql += " '" + iMart.getCelFileNames()[i] + "' real ";
-    if(i + 1 != iMart.getCelFileNames().size()) {
-      createSql += ",";
-    }
-  }
-  createSql += " );";
-  QuantMethodSqlExprReport::execute(db, createSql);
-}
-
-void QuantMethodSqlGTypeReport::createCallTable(sqlite3 *db, const std::string &tableName, const IntensityMart &iMart) {
-  string createSql = "create table " + tableName + " ( probeset_id varchar(" + ToStr(m_MaxPsNameLength) + ") , ";
-  for(int i = 0; i < iMart.getCelFileNames().size(); i++) {
-    createSql += " '" + iMart.getCelFileNames()[i] + "' integer(1) ";
-    if(i + 1 != iMart.getCelFileNames().size()) {
-      createSql += ",";
-    }
-  }
-  createSql += " );";
-  QuantMethodSqlExprReport::execute(db, createSql);
-}
-
-void QuantMethodSqlGTypeReport::createMetaTable(sqlite3 *db, const std::string &metaTableName) {
-  string createSql = "create table " + metaTableName + " ( key varchar(256), value text ); ";
-  QuantMethodSqlExprReport::execute(db, createSql);
-}
-
 void QuantMethodSqlGTypeReport::addStdHeaders(QuantMethodReport *qReport,
                                              const std::string& execGuid, 
                                              const std::string& reportGuid,
@@ -127,29 +97,12 @@ void QuantMethodSqlGTypeReport::addStdHeaders(QuantMethodReport *qReport,
                                              const std::string& commandLine,
                                               const std::string& execVersion,
                                              const AnalysisInfo& info) {
-  std::vector<std::string>::const_iterator keyIx, paramIx;
-  createMetaTable(m_CallDb, m_CallMetaTable);
-  createMetaTable(m_ConfDb, m_ConfMetaTable);
-  //
-  for(keyIx = info.m_ParamNames.begin(), paramIx = info.m_ParamValues.begin();
-      keyIx != info.m_ParamNames.end() && paramIx != info.m_ParamValues.end();
-      ++keyIx, ++paramIx) {
-    string sql = "insert into " + m_CallMetaTable + " values ( '" + *keyIx + "', '" + *paramIx + "');";
-    QuantMethodSqlExprReport::execute(m_CallDb, sql);
-    sql = "insert into " + m_ConfMetaTable + " values ( '" + *keyIx + "', '" + *paramIx + "');";
-    QuantMethodSqlExprReport::execute(m_ConfDb, sql);
-  }
+  SqlSampleTable::writeKeyValueTable(m_CallDb, m_CallMetaTable, info.m_ParamNames, info.m_ParamValues);
+  SqlSampleTable::writeKeyValueTable(m_ConfDb, m_ConfMetaTable, info.m_ParamNames, info.m_ParamValues);
 }
 
 bool QuantMethodSqlGTypeReport::finish(QuantMethod &qMethod) {
-  string sql = "commit;";
-  QuantMethodSqlExprReport::execute(m_CallDb, sql);
-  QuantMethodSqlExprReport::execute(m_ConfDb, sql);
-
-  string indexCalls = "create index call_index on call (probeset_id);";
-  QuantMethodSqlExprReport::execute(m_CallDb,  indexCalls);
-
-  string indexConf = "create index confidence_index on confidence (probeset_id);";
-  QuantMethodSqlExprReport::execute(m_ConfDb,  indexConf);
+  m_CallTableWriter.finish();
+  m_ConfTableWriter.finish();
   return true;
 }
@@ -33,6 +33,7 @@
 //
 #include "chipstream/QuantExprMethod.h"
 #include "chipstream/QuantMethodReport.h"
+#include "chipstream/SqlSampleTable.h"
 #include "chipstream/TsvReport.h"
 //
 #include "util/Util.h"
@@ -50,8 +51,15 @@ class QuantMethodSqlGTypeReport : public QuantMethodReport {
 
 public:
   
+  /**
+   * Constructor. Calls and confidences go to "databaseFile.call.db"
+   * and "databaseFile.conf.db".
+   * @param blobLayout - One row per probeset with the values packed in
+   *   a blob rather than a column per cel file. (See SqlSampleTable.)
+   */
   QuantMethodSqlGTypeReport(const std::string &databaseFile, const std::string &callName, 
-                            const std::string &confTable, int maxPsName=30);
+                            const std::string &confTable, int maxPsName=30,
+                            bool blobLayout=false);
 
   /** Destructor. */
   ~QuantMethodSqlGTypeReport();
@@ -103,12 +111,6 @@ public:
 
 private:
 
-  void createConfTable(sqlite3 *db, const std::string &tableName, const IntensityMart &iMart);
-
-  void createCallTable(sqlite3 *db, const std::string &tableName, const IntensityMart &iMart);
-
-  void createMetaTable(sqlite3 *db, const std::string &metaTableName);
-
   /*
    * Currently two separate databases as dbs are locked during write since bulk
    * commits are much faster than individual commits. Could easily do one by
@@ -124,6 +126,14 @@ private:
   std::string m_CallMetaTable;
   std::string m_ConfTable;
   std::string m_ConfMetaTable;
+  /// Column per cel file or packed blob.
+  SqlSampleTable::Layout m_Layout;
+  /// Prepared inserts for the two tables.
+  SqlSampleTable m_CallTableWriter;
+  SqlSampleTable m_ConfTableWriter;
+  /// Reused for each probeset.
+  std::vector<int> m_Calls;
+  std::vector<double> m_Confs;
 };
 
 #endif /* _QUANTMETHODSQLGTYPEREPORT_H_ */
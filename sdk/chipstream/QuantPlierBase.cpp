@@ -417,8 +417,9 @@ bool QuantPlierBase::setUp(ProbeSetGroup &psGroup, const IntensityMart &iMart,
 
   atomPmCount = 0;
   m_Probes.clear();
-
-  /* Loop through and fill in the data as coming from the intensity mart. */
+  m_BlockProbeIds.clear();
+  m_BlockChannels.clear();
+  /* Loop through and collect the pm probes. */
   for(psIx = 0; psIx < psGroup.probeSets.size(); psIx++) {
     const ProbeSet *ps = psGroup.probeSets[psIx];
     if(ps == NULL) {
@@ -450,22 +451,29 @@ bool QuantPlierBase::setUp(ProbeSetGroup &psGroup, const IntensityMart &iMart,
 	      } // Safety against log zero.
 			  }
           }
-          /* Add probe to our probes and fill in intensity data for each chip. */
+          /* Add probe to our probes, intensity data is filled in below. */
           m_Probes.push_back(p);
-          for(chipIx = 0; chipIx < chipCount; chipIx++) {
-            /* PM transformation. */
-            intensity = transformPrimaryData(probeIndex, chipIx, iMart, iTrans, channelIx);
-            /* MM transformation. */
-            float mmIntensity = 0;
-            pmAdjust.pmAdjustment(probeIndex, chipIx, iMart, iTrans, intensity, mmIntensity);
-            setPMDataAt(atomPmCount, chipIx, intensity);
-            setMMDataAt(atomPmCount, chipIx, mmIntensity);
-          }
+          m_BlockProbeIds.push_back(probeIndex);
+          m_BlockChannels.push_back(channelIx);
           atomPmCount++;
         }
       }
     } /* atoms. */
   } /* probe sets. */
+
+  /* Get the data for all the probes and chips from the intensity mart at once. */
+  transformPrimaryData(m_BlockProbeIds, m_BlockChannels, chipCount, iMart, iTrans, m_Block);
+  for(probeIx = 0; probeIx < m_Probes.size(); probeIx++) {
+    for(chipIx = 0; chipIx < chipCount; chipIx++) {
+      /* PM transformation. */
+      intensity = m_Block[probeIx * chipCount + chipIx];
+      /* MM transformation. */
+      float mmIntensity = 0;
+      pmAdjust.pmAdjustment(m_Probes[probeIx]->id, chipIx, iMart, iTrans, intensity, mmIntensity);
+      setPMDataAt(probeIx, chipIx, intensity);
+      setMMDataAt(probeIx, chipIx, mmIntensity);
+    }
+  }
   return true;
 }
 
@@ -49,12 +49,8 @@ void QuantRma::clear() {
   unsigned int probeIx = 0, chipIx = 0;
  
   // Set the world to 0
-  for(chipIx = 0; chipIx < m_PM.size(); chipIx++) {
-    for(probeIx = 0; probeIx < m_PM[0].size(); probeIx++) {
-      m_PM[chipIx][probeIx] = 0;
-      m_MM[chipIx][probeIx] = 0;
-    }
-  }
+  fill(m_PM.begin(), m_PM.end(), 0.0f);
+  fill(m_MM.begin(), m_MM.end(), 0.0f);
   for(chipIx = 0; chipIx < m_ChipEffects.size(); chipIx++) 
     m_ChipEffects[chipIx] = 0;
   
@@ -68,34 +64,18 @@ void QuantRma::clear() {
  * @param numChips - Microarray count.
  */
 void QuantRma::setBounds(unsigned int numProbes, unsigned int numChips) {
-  unsigned int i = 0;
   m_ProbeCount = numProbes;
   m_ChipCount = numChips;
-  /* Check empty case. */
-  if(m_PM.empty()) {
-    m_ChipEffects.resize(numChips);
-    m_ProbeEffects.resize(numProbes);
-    while(m_PM.size() < numChips) {
-      m_PM.push_back(vector<float>(numProbes));
-      m_MM.push_back(vector<float>(numProbes));
-    }
+  /* Only ever grow, the matrices are reused from probeset to probeset. */
+  size_t cells = (size_t)numProbes * numChips;
+  if(cells > m_PM.size()) {
+    m_PM.resize(cells);
+    m_MM.resize(cells);
   }
-  /* Check number of columns (probes). */
-  if(numProbes > m_PM[0].size()) {
+  if(numProbes > m_ProbeEffects.size())
     m_ProbeEffects.resize(numProbes);
-    for(i = 0; i < m_PM.size(); i++) {
-      m_PM[i].resize(numProbes);
-      m_MM[i].resize(numProbes);
-    }
-  }
-  /* Check number of rows (chips). */
-  if(numChips > m_PM.size()) {
+  if(numChips > m_ChipEffects.size())
     m_ChipEffects.resize(numChips);
-    while(m_PM.size() < numChips) {
-      m_PM.push_back(vector<float>(m_PM[0].size()));
-      m_MM.push_back(vector<float>(m_MM[0].size()));
-    }
-  }
 }
 
 /** 
@@ -105,42 +85,41 @@ void QuantRma::setBounds(unsigned int numProbes, unsigned int numChips) {
  */
 void QuantRma::computeEstimate() {
   float intensity = 0;
-  unsigned int colIx = 0, rowIx = 0;
+  size_t cellIx = 0, cellCount = (size_t)m_ChipCount * m_ProbeCount;
   
-  for(rowIx = 0; rowIx < m_ChipCount; rowIx++) {
-    for(colIx = 0; colIx < m_ProbeCount; colIx++) {
-      if(m_Attenuate) {
-        intensity = attenuateIntensity(m_PM[rowIx][colIx],m_MM[rowIx][colIx],m_L,m_H);
-      }
-      else {
-        intensity = m_PM[rowIx][colIx] - m_MM[rowIx][colIx];
-      }
-      /* Don't want negative values, threshold at RMA_MIN_VALUE */
-      m_PM[rowIx][colIx] = max(intensity, (float)RMA_MIN_VALUE);
+  for(cellIx = 0; cellIx < cellCount; cellIx++) {
+    if(m_Attenuate) {
+      intensity = attenuateIntensity(m_PM[cellIx],m_MM[cellIx],m_L,m_H);
+    }
+    else {
+      intensity = m_PM[cellIx] - m_MM[cellIx];
     }
+    /* Don't want negative values, threshold at RMA_MIN_VALUE */
+    m_PM[cellIx] = max(intensity, (float)RMA_MIN_VALUE);
   }
 
+  /* Effects are reported for exactly this probeset. */
+  m_ProbeEffects.resize(m_ProbeCount);
+  m_ChipEffects.resize(m_ChipCount);
+  float *pm = &m_PM[0];
+  float *probeEffects = &m_ProbeEffects[0];
+  float *chipEffects = &m_ChipEffects[0];
+
   if(m_FitFeatureResponse){
+    if(m_FixFeatureEffect) {
+      m_PMCopy.assign(m_PM.begin(), m_PM.begin() + cellCount);
+    }
     if(m_UseInputModel){
-	  if (m_FixFeatureEffect) {
-	    std::vector<std::vector<float> > PM = m_PM;
-        RMA::medianPolishWithPrecomputedEffectsUsedAsSeedValues(m_PM, m_ChipCount, m_ProbeCount, m_ProbeEffects, m_ChipEffects);
-        RMA::medianPolishWithPrecomputedEffectsOnePass(PM, m_ChipCount, m_ProbeCount, m_ProbeEffects, m_ChipEffects);
-	  } else {
-        RMA::medianPolishWithPrecomputedEffectsUsedAsSeedValues(m_PM, m_ChipCount, m_ProbeCount, m_ProbeEffects, m_ChipEffects);
-	  }
+      RMA::medianPolishWithPrecomputedEffectsUsedAsSeedValues(pm, m_ChipCount, m_ProbeCount, probeEffects, chipEffects, m_PolishWork);
     }else{
-	  if (m_FixFeatureEffect) {
-	    std::vector<std::vector<float> > PM = m_PM;
-        RMA::medianPolishPsetFromMatrix(m_PM, m_ChipCount, m_ProbeCount, m_ProbeEffects, m_ChipEffects);
-        RMA::medianPolishWithPrecomputedEffectsOnePass(PM, m_ChipCount, m_ProbeCount, m_ProbeEffects, m_ChipEffects);
-	  } else {
-        RMA::medianPolishPsetFromMatrix(m_PM, m_ChipCount, m_ProbeCount, m_ProbeEffects, m_ChipEffects);
-	  }
+      RMA::medianPolishPsetFromMatrix(pm, m_ChipCount, m_ProbeCount, probeEffects, chipEffects, m_PolishWork);
+    }
+    if(m_FixFeatureEffect) {
+      RMA::medianPolishWithPrecomputedEffectsOnePass(&m_PMCopy[0], m_ChipCount, m_ProbeCount, probeEffects, chipEffects, m_PolishWork);
     }
   } else{
     if(m_UseInputModel){
-      RMA::medianPolishWithPrecomputedEffectsOnePass(m_PM, m_ChipCount, m_ProbeCount, m_ProbeEffects, m_ChipEffects);
+      RMA::medianPolishWithPrecomputedEffectsOnePass(pm, m_ChipCount, m_ProbeCount, probeEffects, chipEffects, m_PolishWork);
     } else{
       Err::errAbort("Invalid combination of Fit Feature Response and Use Input Model, both cannot be false.");
     }
@@ -175,7 +154,9 @@ bool QuantRma::setUp(ProbeSetGroup &psGroup, const IntensityMart &iMart,
   
   atomPmCount = 0;
   m_Probes.clear();
-  /* Loop through and fill in the data as coming from the intensity mart. */
+  m_BlockProbeIds.clear();
+  m_BlockChannels.clear();
+  /* Loop through and collect the pm probes. */
   for(psIx = 0; psIx < psGroup.probeSets.size(); psIx++) {
     const ProbeSet *ps = psGroup.probeSets[psIx];
     if(ps == NULL)
@@ -211,21 +192,27 @@ bool QuantRma::setUp(ProbeSetGroup &psGroup, const IntensityMart &iMart,
           }
 
           m_Probes.push_back(p);
-          for(chipIx = 0; chipIx < chipCount; chipIx++) {
-            /* PM transformation. */
-            intensity = transformPrimaryData(probeIndex, chipIx, iMart, iTrans, channelIx);
-            /* MM transformation. */
-            float mmIntensity = 0;
-
-            pmAdjust.pmAdjustment(p->id, chipIx, iMart, iTrans, intensity, mmIntensity);
-            setPMDataAt(atomPmCount, chipIx, intensity);
-            setMMDataAt(atomPmCount, chipIx, mmIntensity);
-          }
+          m_BlockProbeIds.push_back(probeIndex);
+          m_BlockChannels.push_back(channelIx);
           atomPmCount++;
         }
       }
     } /* atoms. */
   } /* probe sets. */
+
+  /* Get the data for all the probes and chips from the intensity mart at once. */
+  transformPrimaryData(m_BlockProbeIds, m_BlockChannels, chipCount, iMart, iTrans, m_Block);
+  for(probeIx = 0; probeIx < m_Probes.size(); probeIx++) {
+    for(chipIx = 0; chipIx < chipCount; chipIx++) {
+      /* PM transformation. */
+      intensity = m_Block[probeIx * chipCount + chipIx];
+      /* MM transformation. */
+      float mmIntensity = 0;
+      pmAdjust.pmAdjustment(m_Probes[probeIx]->id, chipIx, iMart, iTrans, intensity, mmIntensity);
+      setPMDataAt(probeIx, chipIx, intensity);
+      setMMDataAt(probeIx, chipIx, mmIntensity);
+    }
+  }
   return true;
 }
 
@@ -216,7 +216,7 @@ public:
    */
   inline double getResidual(unsigned int probeIx, unsigned int chipIx) {
     assert(chipIx < m_ChipCount && probeIx < m_ProbeCount);
-    return m_PM[chipIx][probeIx];
+    return m_PM[chipIx * m_ProbeCount + probeIx];
   }
 
   /** 
@@ -243,7 +243,7 @@ public:
    */
   inline void setPMDataAt(unsigned int probeIx, unsigned int chipIx, double data) {
     assert(chipIx < m_ChipCount && probeIx < m_ProbeCount);
-    m_PM[chipIx][probeIx] = (float)data;
+    m_PM[chipIx * m_ProbeCount + probeIx] = (float)data;
   }
 
 /** 
@@ -254,7 +254,7 @@ public:
    */
   inline double getPMDataAt(unsigned int probeIx, unsigned int chipIx) {
     assert(chipIx < m_ChipCount && probeIx < m_ProbeCount);
-	return (double) m_PM[chipIx][probeIx];
+	return (double) m_PM[chipIx * m_ProbeCount + probeIx];
   }
 
   /** 
@@ -266,7 +266,7 @@ public:
    */
   inline void setMMDataAt(unsigned int probeIx, unsigned int chipIx, double data) {
     assert(chipIx < m_ChipCount && probeIx < m_ProbeCount);
-    m_MM[chipIx][probeIx] = (float)data;
+    m_MM[chipIx * m_ProbeCount + probeIx] = (float)data;
   }
 
   /** 
@@ -408,10 +408,14 @@ private:
   unsigned int m_ChipCount;
   /// Number of probes (features) in probe sets
   unsigned int m_ProbeCount;
-  /// Data matrix for PM probes.
-  std::vector<std::vector<float> > m_PM;
-  /// Data matrix for MM estimates.
-  std::vector<std::vector<float> > m_MM;
+  /// Data matrix for PM probes, chip major: [chipIx * m_ProbeCount + probeIx]
+  std::vector<float> m_PM;
+  /// Data matrix for MM estimates, same layout as m_PM.
+  std::vector<float> m_MM;
+  /// Copy of m_PM for the second pass when fixing feature effects.
+  std::vector<float> m_PMCopy;
+  /// Scratch space for RMA::medianPolish*(), kept to avoid reallocating.
+  std::vector<float> m_PolishWork;
   /// Effects of columns (probes)
   std::vector<float> m_ProbeEffects;
   /// Effects of rows (chips)
@@ -264,6 +264,97 @@ enum SnpModelConverter::SnpChipType SnpModelConverter::guessChipType(enum SnpMod
 }
 
 
+/// The model fields of a snp_distribution, in the order of snpModelColumnNames().
+static void snpModelFields(snp_distribution &dist, vector<double *> &fields) {
+    cluster_data *clusters[] = {&dist.aa, &dist.ab, &dist.bb};
+    fields.clear();
+    for (int c = 0; c < 3; c++) {
+        fields.push_back(&clusters[c]->m);
+        fields.push_back(&clusters[c]->ss);
+        fields.push_back(&clusters[c]->k);
+        fields.push_back(&clusters[c]->v);
+        fields.push_back(&clusters[c]->ym);
+        fields.push_back(&clusters[c]->yss);
+        fields.push_back(&clusters[c]->xyss);
+    }
+    double *cross[] = {&dist.xah, &dist.xab, &dist.xhb, &dist.yah, &dist.yab, &dist.yhb,
+                       &dist.xyah, &dist.xyab, &dist.xyhb, &dist.yxah, &dist.yxab, &dist.yxhb};
+    fields.insert(fields.end(), cross, cross + 12);
+}
+
+/// The posterior columns read by QuantLabelZ__readSnpPrior_tsv5_v2().
+static void snpModelColumnNames(vector<string> &names) {
+    const char *clusters[] = {"Cluster_AA", "Cluster_AB", "Cluster_BB"};
+    const char *clusterFields[] = {"_Mean", "_Variance", "_MeanStrength", "_VarianceStrength", "_YM", "_YSS", "_YXSS"};
+    const char *crossFields[] = {"_XAH", "_XAB", "_XHB", "_YAH", "_YAB", "_YHB",
+                                 "_XYAH", "_XYAB", "_XYHB", "_YXAH", "_YXAB", "_YXHB"};
+    names.clear();
+    for (int c = 0; c < 3; c++) {
+        for (int f = 0; f < 7; f++) {
+            names.push_back(string(clusters[c]) + clusterFields[f]);
+        }
+    }
+    for (int f = 0; f < 12; f++) {
+        names.push_back(string("Cross-Term") + crossFields[f]);
+    }
+}
+
+/**
+ * Reads the models of a posteriors tsv a block of rows at a time, with
+ * File5_Tsv::readColumn(), instead of looking up each column by name on
+ * every row.
+ */
+class SnpModelColumnBlock {
+public:
+    SnpModelColumnBlock(File5_Tsv *tsv5, int lineCount) :
+        m_tsv5(tsv5), m_lineCount(lineCount), m_blockStart(0), m_blockCount(0) {
+        vector<string> names;
+        snpModelColumnNames(names);
+        m_cidx.resize(names.size());
+        m_values.resize(names.size());
+        for (size_t i = 0; i < names.size(); i++) {
+            m_cidx[i] = m_tsv5->getColumnIdx(0, names[i]);
+        }
+    }
+
+    /// Fill in dist from row lineIx, which must not be before the last row asked for.
+    void getDistribution(int lineIx, snp_distribution &dist) {
+        if (lineIx >= m_blockStart + m_blockCount) {
+            m_blockStart = lineIx;
+            m_blockCount = min(BLOCK_ROWS, m_lineCount - lineIx);
+            for (size_t i = 0; i < m_cidx.size(); i++) {
+                if (m_cidx[i] < 0) {
+                    continue;
+                }
+                m_values[i].resize(m_blockCount);
+                if (m_tsv5->readColumn(0, m_cidx[i], m_blockStart, m_blockCount, &m_values[i][0]) != m_blockCount) {
+                    Err::errAbort("SnpModelConverter: Can't read rows " + ToStr(m_blockStart) + " to " +
+                                  ToStr(m_blockStart + m_blockCount) + " of the models.");
+                }
+            }
+        }
+        dist.Clear();
+        dist.Clear_Cross();
+        vector<double *> fields;
+        snpModelFields(dist, fields);
+        for (size_t i = 0; i < m_cidx.size(); i++) {
+            if (m_cidx[i] >= 0) {
+                *fields[i] = m_values[i][lineIx - m_blockStart];
+            }
+        }
+    }
+
+private:
+    static const int BLOCK_ROWS = 10000;
+    File5_Tsv *m_tsv5;
+    int m_lineCount;
+    /// Column index of each model field, -1 if the file doesn't have it.
+    vector<int> m_cidx;
+    vector<vector<double> > m_values;
+    int m_blockStart;
+    int m_blockCount;
+};
+
 void SnpModelConverter::convertBrlmmPFile5ToDbModel(const std::string &fileIn, const std::string &file5Path, const std::string &fileOut) {
     SnpModelDb snpDb(fileOut);
     void setupTables();  
@@ -313,6 +404,7 @@ void SnpModelConverter::convertBrlmmPFile5ToDbModel(const std::string &fileIn, c
         p.Dist.Clear();
         snpDb.prepareToWriteModels(numProbesets);
         unsigned int dotMod = max(numProbesets/20,1);
+        SnpModelColumnBlock models(tsv5, numProbesets);
         Verbose::progressBegin(1, "Indexing " + ToStr(numProbesets) + " Probesets", 20, dotMod, numProbesets);
         while (tsv5->nextLevel(0) == affx::FILE5_OK) {
             Verbose::progressStep(1);
@@ -320,7 +412,7 @@ void SnpModelConverter::convertBrlmmPFile5ToDbModel(const std::string &fileIn, c
             if (first.empty()) {
                 first = p.probeset_id;
             }
-            QuantLabelZ__readSnpPrior_tsv5_v2(tsv5, p.Dist);
+            models.getDistribution(tsv5->lineNum(), p.Dist);
             snpDb.writeSnpDistribution(p);
             iCount++;
         }
@@ -227,6 +227,43 @@ float SparseMart::getProbeIntensity(probeid_t probeIx,
 }
 
 
+void SparseMart::getProbeIntensities(const std::vector<probeid_t> &probeIds,
+                                     const std::vector<unsigned int> &channels,
+                                     int chipCount,
+                                     std::vector<float> &block) const {
+    assert(probeIds.size() == channels.size());
+    block.resize(probeIds.size() * chipCount);
+    if (chipCount <= 0) {
+        return;
+    }
+    // The data set for each chip, looked up again only when the channel changes.
+    std::vector<const float *> dataSets(chipCount);
+    unsigned int dataSetChannel = 0;
+    bool haveDataSets = false;
+    for (size_t i = 0; i < probeIds.size(); i++) {
+        if (!haveDataSets || channels[i] != dataSetChannel) {
+            dataSetChannel = channels[i];
+            for (int chipIx = 0; chipIx < chipCount; chipIx++) {
+                int dataSetIx = chipIx;
+                if (!m_ChipChannelToCacheMap.empty()) {
+                    dataSetIx = m_ChipChannelToCacheMap[chipIx][dataSetChannel];
+                }
+                assert(dataSetIx >= 0 && (size_t)dataSetIx < m_Data.size());
+                dataSets[chipIx] = m_Data[dataSetIx].empty() ? NULL : &m_Data[dataSetIx][0];
+            }
+            haveDataSets = true;
+        }
+        probeid_t probeIx = probeIds[i];
+        assert(probeIx < m_Map.size());
+        assert(m_Map[probeIx] >= 0);
+        int dataIx = m_Map[probeIx];
+        float *row = &block[i * chipCount];
+        for (int chipIx = 0; chipIx < chipCount; chipIx++) {
+            row[chipIx] = dataSets[chipIx][dataIx];
+        }
+    }
+}
+
 void SparseMart::clear() {
     unsigned int i = 0;
     m_ProbeSize = 0;
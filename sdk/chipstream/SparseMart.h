@@ -102,6 +102,15 @@ public:
    */
   float getProbeIntensity(probeid_t probeIx, chipid_t chipIx, unsigned int channelIx = 0) const;
 
+  /**
+   * @brief Fill in the intensities of a block of probes on a block of
+   * chips, probe major. See IntensityMart::getProbeIntensities().
+   */
+  void getProbeIntensities(const std::vector<probeid_t> &probeIds,
+                           const std::vector<unsigned int> &channels,
+                           int chipCount,
+                           std::vector<float> &block) const;
+
   /** 
    * @brief Method for getting vector of intensities in original order in CEL file.
    * @param dataSetIx - index of CEL intensity dataset in DiskIntensityMart 
@@ -0,0 +1,309 @@
+////////////////////////////////////////////////////////////////
+//
+// Copyright (C) 2011 Affymetrix, Inc.
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License (version 2) as
+// published by the Free Software Foundation.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program;if not, write to the
+//
+// Free Software Foundation, Inc.,
+// 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+//
+////////////////////////////////////////////////////////////////
+
+//
+#include "chipstream/SqlSampleTable.h"
+//
+#include "util/Convert.h"
+#include "util/Err.h"
+#include "util/NumFormat.h"
+//
+#include <cstring>
+
+using namespace std;
+
+/// Most bound parameters a statement can have in a default sqlite build.
+#define SQLSAMPLETABLE_MAX_BIND 999
+
+/// Quote a name for sql, doubling any quotes in it.
+static string sqlQuote(const string &name) {
+  string quoted = "'";
+  for(size_t i = 0; i < name.size(); i++) {
+    if(name[i] == '\'')
+      quoted += '\'';
+    quoted += name[i];
+  }
+  return quoted + "'";
+}
+
+SqlSampleTable::SqlSampleTable() {
+  m_Db = NULL;
+  m_Insert = NULL;
+  m_Type = ValueReal;
+  m_Layout = LayoutColumns;
+  m_SampleCount = 0;
+  m_UseText = false;
+  m_CommitRows = SQLSAMPLETABLE_COMMIT_ROWS;
+  m_RowsInTransaction = 0;
+  m_RowCount = 0;
+}
+
+SqlSampleTable::~SqlSampleTable() {
+  release();
+}
+
+void SqlSampleTable::release() {
+  if(m_Insert != NULL) {
+    sqlite3_finalize(m_Insert);
+    m_Insert = NULL;
+  }
+}
+
+void SqlSampleTable::execute(sqlite3 *db, const std::string &sql) {
+  sqlite3_stmt *stmt = NULL;
+  int status = 0;
+  if((status = sqlite3_prepare_v2(db, sql.c_str(), sql.size(), &stmt, NULL)) != SQLITE_OK) {
+    Err::errAbort("Error error code: " + ToStr(status) + " preparing statement: " + sql +
+                  " (" + sqlite3_errmsg(db) + ")");
+  }
+  while((status = sqlite3_step(stmt)) == SQLITE_ROW) {
+    // pragmas can return their value; we dont need it.
+  }
+  if(status != SQLITE_DONE) {
+    string msg = sqlite3_errmsg(db);
+    sqlite3_finalize(stmt);
+    Err::errAbort("Error error code: " + ToStr(status) + " executing statement: " + sql + " (" + msg + ")");
+  }
+  if((status = sqlite3_finalize(stmt)) != SQLITE_OK) {
+    Err::errAbort("Error error code: " + ToStr(status) + " finalizing statement: " + sql);
+  }
+}
+
+void SqlSampleTable::setBulkPragmas(sqlite3 *db) {
+  // page_size only works before the first table is made.
+  execute(db, "pragma page_size=8192;");
+  execute(db, "pragma cache_size=16384;");
+  // the output is rewritten from scratch if we die, so dont pay for
+  // durability. (sqlite ignores pragmas it doesnt know, like
+  // journal_mode on older versions.)
+  execute(db, "pragma synchronous=OFF;");
+  execute(db, "pragma journal_mode=MEMORY;");
+  execute(db, "pragma temp_store=MEMORY;");
+}
+
+void SqlSampleTable::writeKeyValueTable(sqlite3 *db, const std::string &tableName,
+                                        const std::vector<std::string> &keys,
+                                        const std::vector<std::string> &values) {
+  execute(db, "create table " + tableName + " ( key varchar(256), value text );");
+  execute(db, "begin transaction;");
+  sqlite3_stmt *stmt = NULL;
+  string sql = "insert into " + tableName + " values ( ?, ? );";
+  if(sqlite3_prepare_v2(db, sql.c_str(), sql.size(), &stmt, NULL) != SQLITE_OK) {
+    Err::errAbort("Error preparing statement: " + sql + " (" + sqlite3_errmsg(db) + ")");
+  }
+  for(size_t i = 0; i < keys.size() && i < values.size(); i++) {
+    sqlite3_bind_text(stmt, 1, keys[i].c_str(), keys[i].size(), SQLITE_STATIC);
+    sqlite3_bind_text(stmt, 2, values[i].c_str(), values[i].size(), SQLITE_STATIC);
+    if(sqlite3_step(stmt) != SQLITE_DONE) {
+      string msg = sqlite3_errmsg(db);
+      sqlite3_finalize(stmt);
+      Err::errAbort("Error inserting into " + tableName + ": " + msg);
+    }
+    sqlite3_reset(stmt);
+  }
+  sqlite3_finalize(stmt);
+  execute(db, "commit;");
+}
+
+void SqlSampleTable::create(sqlite3 *db, const std::string &tableName,
+                            const std::vector<std::string> &sampleNames, int maxNameLength,
+                            ValueType type, Layout layout) {
+  if(m_Db != NULL) {
+    Err::errAbort("SqlSampleTable::create() called twice for table: " + tableName);
+  }
+  m_Db = db;
+  m_TableName = tableName;
+  m_Type = type;
+  m_Layout = layout;
+  m_SampleCount = sampleNames.size();
+  m_UseText = false;
+  m_RowsInTransaction = 0;
+  m_RowCount = 0;
+
+  string nameCol = "probeset_id varchar(" + ToStr(maxNameLength) + ")";
+  string insertSql;
+  if(m_Layout == LayoutBlob) {
+    execute(m_Db, "create table " + tableName + " ( " + nameCol + ", sample_count integer, value blob );");
+    execute(m_Db, "create table " + tableName + "_samples ( sample_ix integer, sample_name text );");
+    execute(m_Db, "begin transaction;");
+    for(int i = 0; i < m_SampleCount; i++) {
+      execute(m_Db, "insert into " + tableName + "_samples values ( " + ToStr(i) + ", " +
+              sqlQuote(sampleNames[i]) + " );");
+    }
+    execute(m_Db, "commit;");
+    insertSql = "insert into " + tableName + " values ( ?, ?, ? );";
+  }
+  else {
+    string createSql = "create table " + tableName + " ( " + nameCol + " , ";
+    string colType = (m_Type == ValueReal) ? " real " : " integer(1) ";
+    for(int i = 0; i < m_SampleCount; i++) {
+      createSql += " " + sqlQuote(sampleNames[i]) + colType;
+      if(i + 1 != m_SampleCount) {
+        createSql += ",";
+      }
+    }
+    createSql += " );";
+    execute(m_Db, createSql);
+    if(m_SampleCount + 1 > SQLSAMPLETABLE_MAX_BIND) {
+      m_UseText = true;
+    }
+    else {
+      insertSql = "insert into " + tableName + " values ( ?";
+      for(int i = 0; i < m_SampleCount; i++) {
+        insertSql += ",?";
+      }
+      insertSql += " );";
+    }
+  }
+
+  if(!m_UseText) {
+    if(sqlite3_prepare_v2(m_Db, insertSql.c_str(), insertSql.size(), &m_Insert, NULL) != SQLITE_OK) {
+      Err::errAbort("Error preparing statement: " + insertSql + " (" + sqlite3_errmsg(m_Db) + ")");
+    }
+  }
+  execute(m_Db, "begin transaction;");
+}
+
+void SqlSampleTable::checkCount(size_t count) {
+  if(m_Db == NULL) {
+    Err::errAbort("SqlSampleTable::insert() called before create().");
+  }
+  if(count != (size_t)m_SampleCount) {
+    Err::errAbort("Expected " + ToStr(m_SampleCount) + " values for table " + m_TableName +
+                  " got " + ToStr(count));
+  }
+}
+
+void SqlSampleTable::bindName(const std::string &name) {
+  // the string outlives the step() so sqlite doesnt need a copy.
+  sqlite3_bind_text(m_Insert, 1, name.c_str(), name.size(), SQLITE_STATIC);
+}
+
+void SqlSampleTable::step() {
+  int status = sqlite3_step(m_Insert);
+  if(status != SQLITE_DONE) {
+    Err::errAbort("Error error code: " + ToStr(status) + " inserting into " + m_TableName +
+                  " (" + sqlite3_errmsg(m_Db) + ")");
+  }
+  sqlite3_reset(m_Insert);
+}
+
+void SqlSampleTable::rowDone() {
+  m_RowCount++;
+  if(++m_RowsInTransaction >= m_CommitRows) {
+    execute(m_Db, "commit;");
+    execute(m_Db, "begin transaction;");
+    m_RowsInTransaction = 0;
+  }
+}
+
+void SqlSampleTable::insertText(const std::string &name, const std::vector<double> &values) {
+  m_Sql = "insert into " + m_TableName + " values ( " + sqlQuote(name);
+  for(size_t i = 0; i < values.size(); i++) {
+    m_Sql += ",";
+    if(values[i] != values[i]) {
+      m_Sql += "NULL";
+    }
+    else {
+      NumFormat::appendShortest(m_Sql, values[i]);
+    }
+  }
+  m_Sql += " );";
+  execute(m_Db, m_Sql);
+}
+
+void SqlSampleTable::insert(const std::string &name, const std::vector<double> &values) {
+  checkCount(values.size());
+  if(m_UseText) {
+    insertText(name, values);
+  }
+  else if(m_Layout == LayoutBlob) {
+    // float32 for reals and int32 for integers.
+    m_Blob.resize(values.size() * 4);
+    for(size_t i = 0; i < values.size(); i++) {
+      if(m_Type == ValueReal) {
+        float f = (float)values[i];
+        memcpy(&m_Blob[i * 4], &f, 4);
+      }
+      else {
+        int32_t v = (int32_t)values[i];
+        memcpy(&m_Blob[i * 4], &v, 4);
+      }
+    }
+    bindName(name);
+    sqlite3_bind_int(m_Insert, 2, m_SampleCount);
+    sqlite3_bind_blob(m_Insert, 3, m_Blob.empty() ? NULL : &m_Blob[0], m_Blob.size(), SQLITE_STATIC);
+    step();
+  }
+  else {
+    bindName(name);
+    for(size_t i = 0; i < values.size(); i++) {
+      if(values[i] != values[i]) {
+        sqlite3_bind_null(m_Insert, i + 2);
+      }
+      else if(m_Type == ValueReal) {
+        sqlite3_bind_double(m_Insert, i + 2, values[i]);
+      }
+      else {
+        sqlite3_bind_int(m_Insert, i + 2, (int)values[i]);
+      }
+    }
+    step();
+  }
+  rowDone();
+}
+
+void SqlSampleTable::insert(const std::string &name, const std::vector<int> &values) {
+  checkCount(values.size());
+  if(m_Type == ValueReal || m_UseText) {
+    vector<double> dvalues(values.begin(), values.end());
+    insert(name, dvalues);
+    return;
+  }
+  bindName(name);
+  if(m_Layout == LayoutBlob) {
+    m_Blob.resize(values.size() * 4);
+    for(size_t i = 0; i < values.size(); i++) {
+      int32_t v = values[i];
+      memcpy(&m_Blob[i * 4], &v, 4);
+    }
+    sqlite3_bind_int(m_Insert, 2, m_SampleCount);
+    sqlite3_bind_blob(m_Insert, 3, m_Blob.empty() ? NULL : &m_Blob[0], m_Blob.size(), SQLITE_STATIC);
+  }
+  else {
+    for(size_t i = 0; i < values.size(); i++) {
+      sqlite3_bind_int(m_Insert, i + 2, values[i]);
+    }
+  }
+  step();
+  rowDone();
+}
+
+void SqlSampleTable::finish() {
+  if(m_Db == NULL) {
+    return;
+  }
+  execute(m_Db, "commit;");
+  release();
+  // indexing after the load is cheaper than keeping it up to date.
+  execute(m_Db, "create index " + m_TableName + "_index on " + m_TableName + " (probeset_id);");
+  m_Db = NULL;
+}
@@ -0,0 +1,153 @@
+////////////////////////////////////////////////////////////////
+//
+// Copyright (C) 2011 Affymetrix, Inc.
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License (version 2) as
+// published by the Free Software Foundation.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program;if not, write to the
+//
+// Free Software Foundation, Inc.,
+// 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+//
+////////////////////////////////////////////////////////////////
+
+/**
+ * @file   SqlSampleTable.h
+ *
+ * @brief  A sqlite table with a row of per sample values for each
+ *         probeset, written the fast way for the sql reporters.
+ */
+
+#ifndef _SQLSAMPLETABLE_H_
+#define _SQLSAMPLETABLE_H_
+
+//
+#include "portability/affy-base-types.h"
+//
+#include <string>
+#include <vector>
+#include "sqlite3.h"
+//
+
+/// Rows per transaction by default.
+#define SQLSAMPLETABLE_COMMIT_ROWS 10000
+
+/**
+ * A table of "probeset_id, value for sample 0, value for sample 1..."
+ *
+ * Rows are written with one prepared insert statement which has the
+ * values bound to it, so sqlite does not parse and plan a statement
+ * per probeset. The inserts are committed every few thousand rows.
+ *
+ * There are two layouts:
+ *   - LayoutColumns: a column per sample named after the cel file.
+ *   - LayoutBlob: "probeset_id, sample_count, value" with the values
+ *     packed in a blob (float32 for reals, int32 for integers, in the
+ *     byte order of the machine). A second table "<table>_samples"
+ *     holds the sample names. This is smaller and has no limit on
+ *     the number of samples.
+ *
+ * A column layout table with more samples than sqlite allows bound
+ * parameters (999) is written with the values in the sql text.
+ */
+class SqlSampleTable {
+
+public:
+  enum Layout { LayoutColumns, LayoutBlob };
+  enum ValueType { ValueReal, ValueInteger };
+
+  SqlSampleTable();
+  ~SqlSampleTable();
+
+  /**
+   * Run a statement which doesnt return anything we want.
+   * Rows (from pragmas) are skipped. Aborts on errors.
+   */
+  static void execute(sqlite3 *db, const std::string &sql);
+
+  /**
+   * Set the pragmas for writing a new database in bulk: a bigger page
+   * and cache, no syncing and the journal in memory. Must be called
+   * before any tables are made.
+   */
+  static void setBulkPragmas(sqlite3 *db);
+
+  /**
+   * Make a "key, value" table and fill it in.
+   */
+  static void writeKeyValueTable(sqlite3 *db, const std::string &tableName,
+                                 const std::vector<std::string> &keys,
+                                 const std::vector<std::string> &values);
+
+  /**
+   * Make the table, prepare the insert statement and start a transaction.
+   * @param db - Open database to write to.
+   * @param tableName - Name of the table to make.
+   * @param sampleNames - One per value in each row.
+   * @param maxNameLength - Size of the probeset_id column.
+   * @param type - Values are reals or integers.
+   * @param layout - Column per sample or packed blob.
+   */
+  void create(sqlite3 *db, const std::string &tableName,
+              const std::vector<std::string> &sampleNames, int maxNameLength,
+              ValueType type, Layout layout);
+
+  /** Commit every this many rows. */
+  void setCommitRows(int rows) { m_CommitRows = rows; }
+
+  /**
+   * Add a row. There must be a value for each sample; NaN is stored
+   * as NULL in the column layout.
+   */
+  void insert(const std::string &name, const std::vector<double> &values);
+  void insert(const std::string &name, const std::vector<int> &values);
+
+  /**
+   * Commit, free the statement and index the table on probeset_id.
+   */
+  void finish();
+
+  /**
+   * Free the statement without committing, so the database can be
+   * closed after an error.
+   */
+  void release();
+
+  /** Rows written so far. */
+  int64_t getRowCount() const { return m_RowCount; }
+
+private:
+  SqlSampleTable(const SqlSampleTable &);
+  SqlSampleTable &operator=(const SqlSampleTable &);
+
+  void bindName(const std::string &name);
+  void step();
+  void rowDone();
+  void insertText(const std::string &name, const std::vector<double> &values);
+  void checkCount(size_t count);
+
+  sqlite3 *m_Db;
+  sqlite3_stmt *m_Insert;
+  std::string m_TableName;
+  ValueType m_Type;
+  Layout m_Layout;
+  int m_SampleCount;
+  /// Column layout too wide to bind; use sql text.
+  bool m_UseText;
+  int m_CommitRows;
+  int m_RowsInTransaction;
+  int64_t m_RowCount;
+  /// Reused for the packed values and the sql text.
+  std::vector<char> m_Blob;
+  std::string m_Sql;
+};
+
+#endif /* _SQLSAMPLETABLE_H_ */
@@ -125,7 +125,8 @@ public:
   void setIsHeaderBuffer(int val);
   void setUseDefaultSuffix(int val);
 
-  //
+  // places after the point for doubles in text output or
+  // TSV_PRECISION_SHORTEST for the shortest text which reads back exactly.
   void setPrecision(int precision);
   void setPrecision(int clvl,int cidx,int precision);
 
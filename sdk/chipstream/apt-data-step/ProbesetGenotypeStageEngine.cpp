@@ -216,6 +216,10 @@ void ProbesetGenotypeStageEngine::defineOptions() {
   defineOption("", "sqlite-output" , PgOpt::BOOL_OPT, 
                    "Shoul output some results in sqlite3 format?",
                    "false"); 
+  defineOption("", "sqlite-blob-output" , PgOpt::BOOL_OPT,
+                   "With --sqlite-output, store one row per probeset with the values "
+                   "for all the cel files packed into a blob instead of a column per cel file.",
+                   "false");
 #endif
   defineOptionSection("Output Options");
   defineOption("", "table-output", PgOpt::BOOL_OPT,
@@ -1994,9 +1998,12 @@ void ProbesetGenotypeStageEngine::addReporters(
 #ifndef WIN32
   if (getOptBool("sqlite-output")) {
     string databaseFile = Fs::join(outDir,as->getName() + ".sqlite");
-    QuantMethodSqlGTypeReport *reporter = new QuantMethodSqlGTypeReport(databaseFile, "call", "confidence", info.m_MaxPsNameLength);
+    bool blobLayout = getOptBool("sqlite-blob-output");
+    QuantMethodSqlGTypeReport *reporter = new QuantMethodSqlGTypeReport(databaseFile, "call", "confidence", info.m_MaxPsNameLength,
+                                                                        blobLayout);
     as->addReporter(reporter);
-    QuantMethodSqlExprReport *sumReporter = new QuantMethodSqlExprReport(databaseFile + ".summary.db", "summary", info.m_MaxPsNameLength);
+    QuantMethodSqlExprReport *sumReporter = new QuantMethodSqlExprReport(databaseFile + ".summary.db", "summary", info.m_MaxPsNameLength,
+                                                                         blobLayout);
     sumReporter->addStdHeaders(sumReporter, getOpt("exec-guid"), as->getGuid(), getOpt("time-start"),
                                getOpt("command-line"), getOpt("version-to-report"), info);
     if(InstanceOf(qMethod,QuantLabelZ)) {
@@ -2153,9 +2160,12 @@ void ProbesetGenotypeStageEngine::makeReporters(
 #ifndef WIN32
   if(getOptBool("sqlite-output")) {
     string databaseFile = Fs::join(outDir,info.m_AnalysisName+".sqlite");
-    QuantMethodSqlGTypeReport *reporter = new QuantMethodSqlGTypeReport(databaseFile, "call", "confidence", info.m_MaxPsNameLength);
+    bool blobLayout = getOptBool("sqlite-blob-output");
+    QuantMethodSqlGTypeReport *reporter = new QuantMethodSqlGTypeReport(databaseFile, "call", "confidence", info.m_MaxPsNameLength,
+                                                                        blobLayout);
     reporters.push_back(reporter);
-    QuantMethodSqlExprReport *sumReporter = new QuantMethodSqlExprReport(databaseFile + ".summary.db", "summary", info.m_MaxPsNameLength);
+    QuantMethodSqlExprReport *sumReporter = new QuantMethodSqlExprReport(databaseFile + ".summary.db", "summary", info.m_MaxPsNameLength,
+                                                                         blobLayout);
     sumReporter->addStdHeaders(sumReporter, getOpt("exec-guid"), info.m_AnalysisGuid, getOpt("time-start"),
                                getOpt("command-line"), getOpt("version-to-report"), info);
     exprReporters.push_back(sumReporter);
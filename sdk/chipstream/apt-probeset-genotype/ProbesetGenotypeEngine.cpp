@@ -159,6 +159,7 @@
 #include "chipstream/QuantMethodGTypeChipSummary.h"
 #include "chipstream/QuantMethodGTypeExprChipSummary.h"
 #include "chipstream/QuantMethodGTypeReport.h"
+#include "chipstream/QuantMethodReportListener.h"
 #include "chipstream/QuantMethodSnpqcChipSummary.h"
 #include "chipstream/SparseMart.h"
 
@@ -187,6 +188,7 @@
 #include "util/Err.h"
 #include "util/Fs.h"
 #include "util/PgOptions.h"
+#include "util/Thread.h"
 #include "util/Util.h"
 #include "util/Verbose.h"
 #include "util/md5sum.h"
@@ -333,6 +335,10 @@ void ProbesetGenotypeEngine::defineOptions() {
     defineOption("", "sqlite-output" , PgOpt::BOOL_OPT,
                  "Should output some results in sqlite3 format? (Linux/OS X only)",
                  "false");
+    defineOption("", "sqlite-blob-output" , PgOpt::BOOL_OPT,
+                 "With --sqlite-output, store one row per probeset with the values "
+                 "for all the cel files packed into a blob instead of a column per cel file.",
+                 "false");
 #endif
     defineOptionSection("Output Options");
     defineOption("", "table-output", PgOpt::BOOL_OPT,
@@ -532,6 +538,18 @@ void ProbesetGenotypeEngine::defineOptions() {
     defineOption("", "disk-cache", PgOpt::INT_OPT,
                  "Size of memory cache when working off disk in megabytes.",
                  "50");
+    defineOption("", "threads", PgOpt::INT_OPT,
+                 "Number of threads to use when making genotype calls. "
+                 "0 means one thread per cpu. Output is the same for any number of threads.",
+                 "1");
+    defineOption("", "cel-read-threads", PgOpt::INT_OPT,
+                 "Number of threads reading and decoding the next cel files while "
+                 "the current one is processed. 0 reads them one at a time.",
+                 "0");
+    defineOption("", "cel-read-depth", PgOpt::INT_OPT,
+                 "Most cel files read ahead and held in memory when using "
+                 "--cel-read-threads. 0 means twice the number of read threads.",
+                 "0");
 
     defineOptionSection("A5 output options");
 
@@ -1706,25 +1724,7 @@ void ProbesetGenotypeEngine::createAnalysisFromSpec(
 
             // Add quantification method.
             QuantMethodFactory factory(QuantMethodFactory::Expression);
-            QuantMethodFactory::setupQuantMethodFactory(
-                factory,
-                m_a5_global_input_file,
-                m_a5_global_input_group,
-                m_a5_global_output_file,
-                m_a5_global_output_group,
-                getOptInt("probe-count"),
-                getOpt("out-dir"),
-                getOpt("use-feat-eff"),
-                getOptBool("a5-feature-effects-input-global"),
-                getOpt("a5-feature-effects-input-file"),
-                getOpt("a5-feature-effects-input-name"),
-                getOpt("a5-feature-effects-input-group"),
-                getOpt("a5-input-group"),
-                getOpt("a5-group"),
-                getOpt("set-analysis-name"),
-                getOpt("qmethod-spec"),
-                layout
-                );
+            setupLabelZSummaryFactory(factory, layout);
             QuantExprMethod *eMethod = factory.quantExprMethodForString(qMethodSpec, layout, QuantMethodFactory::Expression);
             qLabelZ->setQuantExprMethod(eMethod);
         } // end of stuff for LabelZ detected
@@ -1740,6 +1740,35 @@ void ProbesetGenotypeEngine::createAnalysisFromSpec(
     }
 }
 
+/**
+ * Set up the factory for the allele summary method of brlmm-p (LabelZ)
+ * analyses, reading in any precomputed feature effects.
+ *
+ * @param factory - factory to set up.
+ * @param layout - Probeset specifications.
+ */
+void ProbesetGenotypeEngine::setupLabelZSummaryFactory(QuantMethodFactory &factory, ChipLayout &layout) {
+    QuantMethodFactory::setupQuantMethodFactory(
+        factory,
+        m_a5_global_input_file,
+        m_a5_global_input_group,
+        m_a5_global_output_file,
+        m_a5_global_output_group,
+        getOptInt("probe-count"),
+        getOpt("out-dir"),
+        getOpt("use-feat-eff"),
+        getOptBool("a5-feature-effects-input-global"),
+        getOpt("a5-feature-effects-input-file"),
+        getOpt("a5-feature-effects-input-name"),
+        getOpt("a5-feature-effects-input-group"),
+        getOpt("a5-input-group"),
+        getOpt("a5-group"),
+        getOpt("set-analysis-name"),
+        getOpt("qmethod-spec"),
+        layout
+        );
+}
+
 /**
  * Get the intial calls from the DmListener and give them to analysis
  * methods that need them.
@@ -2053,6 +2082,21 @@ void ProbesetGenotypeEngine::addReporters(
         as->addReporter(reporter);
     }
 
+    // Reporters owned by whoever runs the engine, behind a listener as
+    // the stream deletes its reporters.
+    if (!m_ExternalGTypeReporters.empty()) {
+        QuantMethodReportListener *listener = new QuantMethodReportListener();
+        for (size_t i = 0; i < m_ExternalGTypeReporters.size(); i++)
+            listener->registerListener(m_ExternalGTypeReporters[i]);
+        as->addReporter(listener);
+    }
+    if (!m_ExternalExprReporters.empty()) {
+        QuantMethodReportListener *listener = new QuantMethodReportListener();
+        for (size_t i = 0; i < m_ExternalExprReporters.size(); i++)
+            listener->registerListener(m_ExternalExprReporters[i]);
+        qMethod->addExprReporter(listener);
+    }
+
     // Add AGCC CHP Reporter
     if (getOptBool("cc-chp-output")) {
         string ccchpDir;
@@ -2109,9 +2153,12 @@ void ProbesetGenotypeEngine::addReporters(
 #ifndef WIN32
     if (getOptBool("sqlite-output")) {
         string databaseFile = Fs::join(outDir,as->getName() + ".sqlite");
-        QuantMethodSqlGTypeReport *reporter = new QuantMethodSqlGTypeReport(databaseFile, "call", "confidence", info.m_MaxPsNameLength);
+        bool blobLayout = getOptBool("sqlite-blob-output");
+        QuantMethodSqlGTypeReport *reporter = new QuantMethodSqlGTypeReport(databaseFile, "call", "confidence", info.m_MaxPsNameLength,
+                                                                            blobLayout);
         as->addReporter(reporter);
-        QuantMethodSqlExprReport *sumReporter = new QuantMethodSqlExprReport(databaseFile + ".summary.db", "summary", info.m_MaxPsNameLength);
+        QuantMethodSqlExprReport *sumReporter = new QuantMethodSqlExprReport(databaseFile + ".summary.db", "summary", info.m_MaxPsNameLength,
+                                                                             blobLayout);
         sumReporter->addStdHeaders(sumReporter, getOpt("exec-guid"), as->getGuid(), getOpt("time-start"),
                                    getOpt("command-line"), getOpt("version-to-report"), info);
         if (InstanceOf(qMethod,QuantLabelZ)) {
@@ -2817,6 +2864,8 @@ void ProbesetGenotypeEngine::runImp() {
                                           diskDir,
                                           "apt-genotype.tmp",
                                           true);
+                // the calls read the mart, and the chipstream copies of it, from several threads.
+                diskMart->setThreadShared(ThreadGroup::resolveThreadCount(getOptInt("threads")) > 1);
                 iMart = diskMart;
             }
             else {
@@ -2888,6 +2937,7 @@ void ProbesetGenotypeEngine::runImp() {
             reader.registerIntensityMart(iMart);
             Verbose::out(2, "Reading cel files.");
             reader.setFiles(celFiles);
+            reader.setReadAhead(getOptInt("cel-read-threads"), getOptInt("cel-read-depth"));
             reader.readFiles();
 
             // Get the inital calls from dmCaller and supply them to analyses that
@@ -2999,24 +3049,7 @@ void ProbesetGenotypeEngine::runImp() {
                     (probeSetsToReport.empty() ? NULL : &probeSetsToReport)
                 );
 
-            unsigned int dotMod = max(int(toRunProbesets.size()/40), 1);
-            Verbose::progressBegin(1, "Processing probesets", 40, dotMod, toRunProbesets.size());
-
-            for (unsigned int psIx = 0; psIx < toRunProbesets.size(); psIx++) {
-                Verbose::progressStep(1);
-                for (unsigned int asIx = 0; asIx < analysisStreams.size(); asIx++) {
-                    AnalysisStream *as = analysisStreams[asIx];
-                    ProbeListPacked pList = m_ChipLayout->getProbeListByName(toRunProbesets[psIx]);
-                    if (!pList.isNull()) {
-                        ProbeSet *ps = ProbeListFactory::asProbeSet(pList);
-                        ProbeSetGroup psGroup(ps);
-                        as->doAnalysis(psGroup, *iMart, true, alleleSummariesOnly);
-                        // psGroup should delete the memory for ps...
-                    }
-                }
-            }
-
-            Verbose::progressEnd(1, "Done.");
+            doGenotypeCalls(analysisStreams, asFactory, *iMart, toRunProbesets, alleleSummariesOnly);
 
             // Tell analyses that we are done computing.
             Verbose::out(1,"Flushing output reporters. Finalizing output.");
@@ -3164,6 +3197,202 @@ void ProbesetGenotypeEngine::runImp() {
 
 }
 
+/**
+ * @brief Does the genotype calls of doGenotypeCalls() on several
+ * threads. Each thread works on the next probeset not yet claimed with
+ * its own copy of the QuantGTypeMethod and PmAdjuster of each analysis
+ * (see QuantGTypeMethod::cloneForThread()). What the copies hold back
+ * is written and the reporters are called in probeset order, so the
+ * output is the same as the single threaded loop.
+ */
+class GenotypeThreadTask : public ThreadTask {
+public:
+    GenotypeThreadTask(ChipLayout &layout,
+                       IntensityMart &iMart,
+                       const vector<const char *> &toRunProbesets,
+                       vector<AnalysisStream *> &analysis,
+                       vector<vector<QuantGTypeMethod *> > &qMethods,
+                       vector<vector<PmAdjuster *> > &pmAdjusts,
+                       bool alleleSummariesOnly) :
+        m_Layout(layout), m_IMart(iMart), m_ToRunProbesets(toRunProbesets),
+        m_Analysis(analysis), m_QMethods(qMethods), m_PmAdjusts(pmAdjusts),
+        m_AlleleSummariesOnly(alleleSummariesOnly), m_NextIx(0) {
+    }
+
+    virtual void runThread(int threadIx) {
+        vector<QuantGTypeMethod *> &qMethods = m_QMethods[threadIx];
+        vector<PmAdjuster *> &pmAdjusts = m_PmAdjusts[threadIx];
+        vector<bool> success(m_Analysis.size());
+        while (true) {
+            int psIx = 0;
+            ProbeSetGroup *psGroup = NULL;
+            {
+                MutexLock lock(m_Lock);
+                if (m_NextIx >= (int)m_ToRunProbesets.size()) {
+                    return;
+                }
+                psIx = m_NextIx++;
+                ProbeListPacked pList = m_Layout.getProbeListByName(m_ToRunProbesets[psIx]);
+                if (!pList.isNull()) {
+                    psGroup = new ProbeSetGroup(ProbeListFactory::asProbeSet(pList));
+                }
+            }
+            try {
+                if (psGroup != NULL) {
+                    for (size_t a = 0; a < m_Analysis.size(); a++) {
+                        success[a] = m_Analysis[a]->computeAnalysis(*psGroup, m_IMart, *qMethods[a], *pmAdjusts[a],
+                                                                    m_AlleleSummariesOnly);
+                    }
+                }
+                m_Turn.wait(psIx);
+                Verbose::progressStep(1);
+                if (psGroup != NULL) {
+                    for (size_t a = 0; a < m_Analysis.size(); a++) {
+                        AnalysisStream *as = m_Analysis[a];
+                        QuantGTypeMethod *master = static_cast<QuantGTypeMethod *>(as->getQuantMethod());
+                        master->writeThreadOutput(*qMethods[a], m_IMart, *as->getChipStream(), *as->getPmAdjuster());
+                        as->reportAnalysis(*psGroup, m_IMart, *qMethods[a], *pmAdjusts[a],
+                                           m_AlleleSummariesOnly, success[a]);
+                    }
+                }
+                m_Turn.done(psIx);
+            }
+            catch (...) {
+                delete psGroup;
+                throw;
+            }
+            delete psGroup;
+        }
+    }
+
+    virtual void abortThreads() {
+        m_Turn.abort();
+    }
+
+private:
+    ChipLayout &m_Layout;
+    IntensityMart &m_IMart;
+    const vector<const char *> &m_ToRunProbesets;
+    vector<AnalysisStream *> &m_Analysis;
+    /// Per thread, per analysis copies.
+    vector<vector<QuantGTypeMethod *> > &m_QMethods;
+    vector<vector<PmAdjuster *> > &m_PmAdjusts;
+    bool m_AlleleSummariesOnly;
+    /// Guards m_NextIx and the chip layout.
+    Mutex m_Lock;
+    /// Output happens in probeset order.
+    OrderedTurn m_Turn;
+    int m_NextIx;
+};
+
+/**
+ * @brief Make the genotype calls (or allele summaries) for each
+ * probeset with each analysis, on as many threads as requested. If an
+ * analysis can't be copied for other threads (see
+ * QuantGTypeMethod::cloneForThread()) one thread is used.
+ *
+ * @param analysisStreams - Analyses, already set up with DoSetup().
+ * @param asFactory - Factory the analyses were made with.
+ * @param iMart - Intensities.
+ * @param toRunProbesets - Names of the probesets to call.
+ * @param alleleSummariesOnly - Only do the allele summaries.
+ */
+void ProbesetGenotypeEngine::doGenotypeCalls(vector<AnalysisStream *> &analysisStreams,
+                                             AnalysisStreamFactory &asFactory,
+                                             IntensityMart &iMart,
+                                             const vector<const char *> &toRunProbesets,
+                                             bool alleleSummariesOnly) {
+    int threadCount = ThreadGroup::resolveThreadCount(getOptInt("threads"));
+    vector<string> analysisStrings = getOptVector("analysis");
+    vector<vector<QuantGTypeMethod *> > qMethods;
+    vector<vector<PmAdjuster *> > pmAdjusts;
+    if (threadCount > 1) {
+        // Thread 0 is this thread, but it uses copies too so all the
+        // output goes through writeThreadOutput().
+        QuantMethodFactory factory(QuantMethodFactory::Expression);
+        bool factoryReady = false;
+        qMethods.resize(threadCount);
+        pmAdjusts.resize(threadCount);
+        for (int t = 0; t < threadCount && threadCount > 1; t++) {
+            for (size_t a = 0; a < analysisStreams.size(); a++) {
+                QuantGTypeMethod *master = static_cast<QuantGTypeMethod *>(analysisStreams[a]->getQuantMethod());
+                QuantGTypeMethod *copy = NULL;
+                if (InstanceOf(master, QuantLabelZ)) {
+                    if (!factoryReady) {
+                        setupLabelZSummaryFactory(factory, *m_ChipLayout);
+                        factoryReady = true;
+                    }
+                    string qMethodSpec = getOpt("qmethod-spec");
+                    QuantExprMethod *eMethod = factory.quantExprMethodForString(qMethodSpec, *m_ChipLayout,
+                                                                                QuantMethodFactory::Expression);
+                    copy = master->cloneForThread(eMethod);
+                    if (copy == NULL) {
+                        delete eMethod;
+                    }
+                }
+                if (copy == NULL) {
+                    Verbose::out(1, "Analysis '" + analysisStreams[a]->getName() + "' can't be run on multiple threads. Using 1 thread.");
+                    threadCount = 1;
+                    break;
+                }
+                qMethods[t].push_back(copy);
+                pmAdjusts[t].push_back(asFactory.constructGTypePmAdjuster(analysisStrings[a], *m_ChipLayout, m_stdMethods));
+            }
+        }
+    }
+
+    unsigned int dotMod = max(int(toRunProbesets.size()/40), 1);
+    if (threadCount > 1) {
+        Verbose::out(1, "Using " + ToStr(threadCount) + " threads.");
+        Verbose::progressBegin(1, "Processing probesets", 40, dotMod, toRunProbesets.size());
+        GenotypeThreadTask task(*m_ChipLayout, iMart, toRunProbesets, analysisStreams,
+                                qMethods, pmAdjusts, alleleSummariesOnly);
+        try {
+            ThreadGroup::run(task, threadCount);
+        }
+        catch (...) {
+            freeThreadCopies(qMethods, pmAdjusts);
+            throw;
+        }
+        freeThreadCopies(qMethods, pmAdjusts);
+        Verbose::progressEnd(1, "Done.");
+        return;
+    }
+    freeThreadCopies(qMethods, pmAdjusts);
+
+    Verbose::progressBegin(1, "Processing probesets", 40, dotMod, toRunProbesets.size());
+    for (unsigned int psIx = 0; psIx < toRunProbesets.size(); psIx++) {
+        Verbose::progressStep(1);
+        for (unsigned int asIx = 0; asIx < analysisStreams.size(); asIx++) {
+            AnalysisStream *as = analysisStreams[asIx];
+            ProbeListPacked pList = m_ChipLayout->getProbeListByName(toRunProbesets[psIx]);
+            if (!pList.isNull()) {
+                ProbeSet *ps = ProbeListFactory::asProbeSet(pList);
+                ProbeSetGroup psGroup(ps);
+                as->doAnalysis(psGroup, iMart, true, alleleSummariesOnly);
+                // psGroup should delete the memory for ps...
+            }
+        }
+    }
+    Verbose::progressEnd(1, "Done.");
+}
+
+void ProbesetGenotypeEngine::freeThreadCopies(vector<vector<QuantGTypeMethod *> > &qMethods,
+                                              vector<vector<PmAdjuster *> > &pmAdjusts) {
+    for (size_t t = 0; t < qMethods.size(); t++) {
+        for (size_t a = 0; a < qMethods[t].size(); a++) {
+            delete qMethods[t][a];
+        }
+    }
+    for (size_t t = 0; t < pmAdjusts.size(); t++) {
+        for (size_t a = 0; a < pmAdjusts[t].size(); a++) {
+            delete pmAdjusts[t][a];
+        }
+    }
+    qMethods.clear();
+    pmAdjusts.clear();
+}
+
 void ProbesetGenotypeEngine::closeGlobalA5() {
     // A5 close global groups
     if (m_a5_global_output_group!=NULL) {
@@ -94,6 +94,14 @@ class ProbesetGenotypeEngine : public BaseEngine {
          * @return The engine type or NULL if not compatible.
          */
         static ProbesetGenotypeEngine * FromBase(BaseEngine *engine);
+
+        /**
+         * Also report the allele summaries and the genotype calls of each
+         * analysis to these reporters, as the a5 summary and calls reporters
+         * are. The engine does not own them.
+         */
+        void addExternalExprReporter(QuantMethodReport *reporter) { m_ExternalExprReporters.push_back(reporter); }
+        void addExternalGTypeReporter(QuantMethodReport *reporter) { m_ExternalGTypeReporters.push_back(reporter); }
         
         /**
          * Compare needed disk space to available disk space
@@ -222,6 +230,14 @@ class ProbesetGenotypeEngine : public BaseEngine {
                    std::string prefix = "apt-");
         void closeGlobalA5();
         int getLayoutVersion(ChipLayout &layout);
+        void setupLabelZSummaryFactory(QuantMethodFactory &factory, ChipLayout &layout);
+        void doGenotypeCalls(std::vector<AnalysisStream *> &analysisStreams,
+                   AnalysisStreamFactory &asFactory,
+                   IntensityMart &iMart,
+                   const std::vector<const char *> &toRunProbesets,
+                   bool alleleSummariesOnly);
+        void freeThreadCopies(std::vector<std::vector<QuantGTypeMethod *> > &qMethods,
+                   std::vector<std::vector<PmAdjuster *> > &pmAdjusts);
 
     private:
         /// List of aliases for standardized methods
@@ -246,6 +262,9 @@ class ProbesetGenotypeEngine : public BaseEngine {
 
   /// the vector of probeset names to process with snpqcChipSummary
   std::vector<std::string> m_snpqc_probesets;
+  /// Reporters owned by whoever runs the engine (see addExternalExprReporter()).
+  std::vector<QuantMethodReport *> m_ExternalExprReporters;
+  std::vector<QuantMethodReport *> m_ExternalGTypeReporters;
 };
 
 #endif /* _PROBESETGENOTYPEENGINE_H_ */
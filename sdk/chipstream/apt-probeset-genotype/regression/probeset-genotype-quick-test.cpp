@@ -44,6 +44,7 @@
 #include "util/Verbose.h"
 //
 #include <cstring>
+#include <ctime>
 #include <string>
 #include <vector>
 //
@@ -78,6 +79,7 @@ public:
   void doBrlmmpSnp6Chp();
   void doBrlmmpSnp5Chp();
   void doBrlmmpSnp5Spf();
+  void doBrlmmpSnp5SpfThreads();
   void doBrlmmpSnp5KillList();
   void doReadGenotypesIn();
   void doChpFiles();
@@ -459,6 +461,72 @@ void ProbeSetGenotypeTest::doBrlmmpSnp5Spf() {
   }
 }
 
+void ProbeSetGenotypeTest::doBrlmmpSnp5SpfThreads() {
+  const int threadCounts[] = {1, 2, 4, 8, 16, 0};
+  const char *outputs[] = {"brlmm-p.calls.txt", "brlmm-p.confidences.txt",
+                           "brlmm-p.summary.txt", NULL};
+  const char *chpFiles[] = {
+    "NA06985_GW5_C","NA06991_GW5_C","NA06993_GW5_C","NA06994_GW5_C","NA07000_GW5_C",
+    "NA07019_GW5_C","NA07022_GW5_C","NA07029_GW5_C","NA07034_GW5_C","NA07048_GW5_C",
+    "NA07055_GW5_C","NA07056_GW5_C","NA07345_GW5_C","NA07348_GW5_C","NA07357_GW5_C",
+    "NA10830_GW5_C","NA10831_GW5_C","NA10835_GW5_C","NA10838_GW5_C","NA10839_GW5_C",
+    NULL
+  };
+  string baseDir = testDir + "/qt-doBrlmmpSnp5SpfThreads";
+  time_t singleTime = 0;
+
+  if ( !Fs::dirExists(baseDir) ) {
+    Fs::mkdirPath(baseDir, false);
+  }
+
+  for (int tIx = 0; threadCounts[tIx] != 0; tIx++) {
+    string outdir = baseDir + "/threads-" + ToStr(threadCounts[tIx]);
+    std::string command = "./apt-probeset-genotype "
+      "--spf-file ../../../regression-data/data/idata/lib/GenomeWideSNP_5/GenomeWideSNP_5.spf "
+      "--chrX-snps ../../../regression-data/data/idata/lib/GenomeWideSNP_5/GenomeWideSNP_5.chrx "
+      "--read-models-brlmmp ../../../regression-data/data/idata/lib/GenomeWideSNP_5/GenomeWideSNP_5.models "
+      "--analysis brlmm-p "
+      "--summaries "
+      "--write-models "
+      "--use-disk=false "
+      "--threads " + ToStr(threadCounts[tIx]) + " "
+      "--out-dir " + outdir;
+    command += Util::joinVectorString(Util::addPrefixSuffix(chpFiles, " ../../../regression-data/data/idata/cel/GenomeWideSNP_5/", ".CEL"), " ");
+
+    vector<RegressionCheck *> checks;
+    // calls, summaries and models must not change with the number of threads.
+    for (int oIx = 0; tIx > 0 && outputs[oIx] != NULL; oIx++) {
+      checks.push_back(new MatrixCheck(outdir + "/" + outputs[oIx],
+                                       baseDir + "/threads-1/" + outputs[oIx],
+                                       0.0, 1, 1, false, 0));
+    }
+    if (tIx > 0) {
+      checks.push_back(new TextFileCheck(outdir + "/brlmm-p.snp-posteriors",
+                                         baseDir + "/threads-1/brlmm-p.snp-posteriors", "#%"));
+    }
+    string name = "qt-doBrlmmpSnp5SpfThreads-" + ToStr(threadCounts[tIx]);
+    RegressionTest test(name.c_str(), command.c_str(), checks);
+    test.setSuite(*this, outdir, outdir + "/apt-probeset-genotype.log", outdir + "/valgrind.log");
+
+    Verbose::out(1, "Doing doBrlmmpSnp5SpfThreads() with " + ToStr(threadCounts[tIx]) + " threads");
+    time_t startTime = time(NULL);
+    bool ok = test.pass();
+    time_t runTime = time(NULL) - startTime;
+    if (tIx == 0) {
+      singleTime = runTime;
+    }
+    Verbose::out(1, "Threads: " + ToStr(threadCounts[tIx]) + " seconds: " + ToStr((int)runTime) +
+                 (runTime > 0 ? " speedup: " + ToStr((double)singleTime / (double)runTime) : ""));
+    if(!ok) {
+      Verbose::out(1, "Error in ProbeSetGenotypeTest::doBrlmmpSnp5SpfThreads(): " + test.getErrorMsg());
+      numFailed++;
+    }
+    else {
+      numPassed++;
+    }
+  }
+}
+
 
 /*  This is the only test within the genotyping regression suite which tests feature effects.  It uses a cdf file as input and does a write and read of feature effects in two stages.  At both steps it validates that the feature effects are correct by checking that the summary values created using the feature effects match the golden values.  It would be nice to check the feature effects themselves but for this testcase they are in A5 format. The A5 format was chosen since we do not even have an testcase in the summarization regression suite which tests the A5 input/output of feature effects */
 
@@ -1625,6 +1693,7 @@ int main(int argc, char* argv[]) {
 
         test.doBrlmmpSnp5Chp();
         test.doBrlmmpSnp5Spf();
+        test.doBrlmmpSnp5SpfThreads();
         //test.doBrlmmpSnp5KillList();
         ///@todo broken test Martin is workin on fix
         //test.doBrlmmpSnp5CdfReadWriteFeatureEffectsA5();
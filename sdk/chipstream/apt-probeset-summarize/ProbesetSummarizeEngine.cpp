@@ -63,6 +63,7 @@
 #include "file/TsvFile/TsvFile.h"
 
 #include "util/Fs.h"
+#include "util/Thread.h"
 //
 #include "newmat.h"
 
@@ -244,6 +245,18 @@ void ProbesetSummarizeEngine::defineOptions() {
                  "Size of intensity memory cache in millions of intensities (when --use-disk=true).",
                  "50");
     defineOption("", "store-duplicate-probes", PgOpt::BOOL_OPT, "Store intensities for probes appearing in multiple probesets in memory (Prevents page thrashing.  Is a bad idea for Axiom.  Turned on automatically when using meta-probesets)","false");
+    defineOption("", "threads", PgOpt::INT_OPT,
+                 "Number of threads to use when summarizing probesets. "
+                 "0 means one thread per cpu. Output is the same for any number of threads.",
+                 "1");
+    defineOption("", "cel-read-threads", PgOpt::INT_OPT,
+                 "Number of threads reading and decoding the next cel files while "
+                 "the current one is processed. 0 reads them one at a time.",
+                 "0");
+    defineOption("", "cel-read-depth", PgOpt::INT_OPT,
+                 "Most cel files read ahead and held in memory when using "
+                 "--cel-read-threads. 0 means twice the number of read threads.",
+                 "0");
     defineOptionSection("A5 output options");
 
     defineOption("","a5-global-file",PgOpt::STRING_OPT,
@@ -763,6 +776,8 @@ void ProbesetSummarizeEngine::runImp() {
                 if (haveMetaProbeset || getOptBool("store-duplicate-probes")) {
                     diskMart->setUseAuxMemCache(true);
                 }
+                // the summaries read the mart, and the chipstream copies of it, from several threads.
+                diskMart->setThreadShared(ThreadGroup::resolveThreadCount(getOptInt("threads")) > 1);
                 iMart = diskMart;
             }
             else {
@@ -861,6 +876,7 @@ void ProbesetSummarizeEngine::runImp() {
                 analysisStreams[analysisIx]->registerChipStreamObjs(reader);
             reader.registerCelListener(&celStats);
             reader.registerIntensityMart(iMart);
+            reader.setReadAhead(getOptInt("cel-read-threads"), getOptInt("cel-read-depth"));
 
             /* Read CEL files */
             reader.readFiles();
@@ -872,7 +888,8 @@ void ProbesetSummarizeEngine::runImp() {
 
 
             /* Do the analysis */
-            doSummaries(*layout, *iMart, layout->m_PlFactory.m_probelist_vec, metaSets, analysisStreams, toRun);
+            doSummaries(*layout, *iMart, layout->m_PlFactory.m_probelist_vec, metaSets, analysisStreams, toRun,
+                        asFactory, analysisStrings);
 
             /* Let the streams do their post summaries cleanup. */
             Verbose::out(1,"Flushing output reporters. Finalizing output.");
@@ -1014,6 +1031,178 @@ ProbeSetGroup *ProbesetSummarizeEngine::makeProbesetGroupFromMeta(MetaProbeset &
     }
 }
 
+/**
+ * @brief Does the probeset summaries of doSummaries() on several
+ * threads. Each thread works on the next probeset not yet claimed
+ * with its own copies of the QuantMethod and PmAdjuster for each
+ * analysis (made by the same factory as the originals). The results
+ * are handed to the reporters in probeset order, so the output is the
+ * same as the single threaded loop.
+ */
+class SummarizeThreadTask : public ThreadTask {
+public:
+    SummarizeThreadTask(ProbesetSummarizeEngine &engine,
+                        ChipLayout &layout,
+                        IntensityMart &iMart,
+                        const vector<ProbeListPacked>& plVec,
+                        vector<MetaProbeset *> &metaToRun,
+                        vector<AnalysisStreamExpression *> &analysis,
+                        AnalysisStreamFactory &asFactory,
+                        const vector<string> &analysisStrings,
+                        int threadCount) :
+        m_Engine(engine), m_Layout(layout), m_IMart(iMart), m_PlVec(plVec),
+        m_MetaToRun(metaToRun), m_Analysis(analysis), m_AsFactory(asFactory),
+        m_AnalysisStrings(analysisStrings), m_NextIx(0) {
+        m_NumGroups = metaToRun.size() == 0 ? plVec.size() : metaToRun.size();
+        m_QMethods.resize(threadCount);
+        m_PmAdjusts.resize(threadCount);
+        for (int t = 0; t < threadCount; t++) {
+            m_QMethods[t].resize(analysis.size());
+            m_PmAdjusts[t].resize(analysis.size());
+        }
+    }
+
+    ~SummarizeThreadTask() {
+        for (size_t t = 0; t < m_QMethods.size(); t++) {
+            for (size_t a = 0; a < m_QMethods[t].size(); a++) {
+                for (size_t g = 0; g < m_QMethods[t][a].size(); g++) {
+                    delete m_QMethods[t][a][g];
+                    delete m_PmAdjusts[t][a][g];
+                }
+            }
+        }
+    }
+
+    virtual void runThread(int threadIx) {
+        vector<vector<ProbeSetGroup> > psAlleles(m_Analysis.size());
+        vector<vector<ProbeSetGroup *> > toRun(m_Analysis.size());
+        vector<vector<bool> > setupOk(m_Analysis.size());
+        while (true) {
+            int groupIx = 0;
+            ProbeSetGroup *psGroup = NULL;
+            {
+                MutexLock lock(m_Lock);
+                if (m_NextIx >= m_NumGroups) {
+                    return;
+                }
+                groupIx = m_NextIx++;
+                if (m_MetaToRun.size() == 0) {
+                    psGroup = new ProbeSetGroup(ProbeListFactory::asProbeSet(m_PlVec[groupIx]));
+                }
+                else {
+                    psGroup = m_Engine.makeProbesetGroupFromMeta(*(m_MetaToRun[groupIx]), m_Layout);
+                }
+            }
+            try {
+                if (psGroup != NULL) {
+                    computeGroups(threadIx, *psGroup, psAlleles, toRun, setupOk);
+                }
+                m_Turn.wait(groupIx);
+                Verbose::progressStep(1);
+                if (psGroup != NULL) {
+                    reportGroups(threadIx, toRun, setupOk);
+                }
+                m_Turn.done(groupIx);
+            }
+            catch (...) {
+                freeGroups(psAlleles);
+                delete psGroup;
+                throw;
+            }
+            freeGroups(psAlleles);
+            delete psGroup;
+        }
+    }
+
+    virtual void abortThreads() {
+        m_Turn.abort();
+    }
+
+private:
+    /// Set up and compute every analysis for psGroup with this thread's copies.
+    void computeGroups(int threadIx,
+                       ProbeSetGroup &psGroup,
+                       vector<vector<ProbeSetGroup> > &psAlleles,
+                       vector<vector<ProbeSetGroup *> > &toRun,
+                       vector<vector<bool> > &setupOk) {
+        for (size_t a = 0; a < m_Analysis.size(); a++) {
+            m_Analysis[a]->makeAnalysisGroups(psGroup, psAlleles[a], toRun[a]);
+            setupOk[a].resize(toRun[a].size());
+            for (size_t g = 0; g < toRun[a].size(); g++) {
+                QuantExprMethod *qMethod = NULL;
+                PmAdjuster *pmAdjust = NULL;
+                getCopy(threadIx, a, g, qMethod, pmAdjust);
+                setupOk[a][g] = m_Analysis[a]->computeGroup(*toRun[a][g], m_IMart, *qMethod, *pmAdjust);
+            }
+        }
+    }
+
+    /// Same reporting calls (and failure logic) as AnalysisStreamExpression::doAnalysis().
+    void reportGroups(int threadIx,
+                      vector<vector<ProbeSetGroup *> > &toRun,
+                      vector<vector<bool> > &setupOk) {
+        for (size_t a = 0; a < m_Analysis.size(); a++) {
+            bool success = true;
+            for (size_t g = 0; g < toRun[a].size(); g++) {
+                if (!setupOk[a][g]) {
+                    Verbose::out(5, "Warning setup failed for name: " + ToStr(toRun[a][g]->name));
+                    success = false;
+                }
+                m_Analysis[a]->reportGroup(*toRun[a][g], m_IMart, *m_QMethods[threadIx][a][g],
+                                           *m_PmAdjusts[threadIx][a][g], setupOk[a][g], success);
+            }
+        }
+    }
+
+    void freeGroups(vector<vector<ProbeSetGroup> > &psAlleles) {
+        for (size_t a = 0; a < psAlleles.size(); a++) {
+            AnalysisStreamExpression::freeAnalysisGroups(psAlleles[a]);
+            psAlleles[a].clear();
+        }
+    }
+
+    /// Copies are made the first time a thread needs them, one per
+    /// allele group so each group's estimates survive until reported.
+    void getCopy(int threadIx, size_t a, size_t g, QuantExprMethod *&qMethod, PmAdjuster *&pmAdjust) {
+        vector<QuantExprMethod *> &qVec = m_QMethods[threadIx][a];
+        vector<PmAdjuster *> &pmVec = m_PmAdjusts[threadIx][a];
+        if (g >= qVec.size()) {
+            MutexLock lock(m_Lock);
+            while (qVec.size() <= g) {
+                PmAdjuster *pm = NULL;
+                QuantExprMethod *qm = m_AsFactory.constructExpressionQuantMethod(m_AnalysisStrings[a], m_Layout,
+                                                                                 m_Engine.m_stdMethods, pm);
+                // Same %HACK% as in runImp().
+                if (InstanceOf(qm, QuantDabg)) {
+                    dynamic_cast<QuantDabg*>(qm)->setBgpFileName(m_Engine.getOpt("bgp-file"));
+                }
+                qVec.push_back(qm);
+                pmVec.push_back(pm);
+            }
+        }
+        qMethod = qVec[g];
+        pmAdjust = pmVec[g];
+    }
+
+    ProbesetSummarizeEngine &m_Engine;
+    ChipLayout &m_Layout;
+    IntensityMart &m_IMart;
+    const vector<ProbeListPacked> &m_PlVec;
+    vector<MetaProbeset *> &m_MetaToRun;
+    vector<AnalysisStreamExpression *> &m_Analysis;
+    AnalysisStreamFactory &m_AsFactory;
+    const vector<string> &m_AnalysisStrings;
+    /// Guards m_NextIx, making probeset groups and making copies.
+    Mutex m_Lock;
+    /// Reporting happens in probeset order.
+    OrderedTurn m_Turn;
+    int m_NextIx;
+    int m_NumGroups;
+    /// Per thread, per analysis, per allele group copies.
+    vector<vector<vector<QuantExprMethod *> > > m_QMethods;
+    vector<vector<vector<PmAdjuster *> > > m_PmAdjusts;
+};
+
 /** 
  * @brief Loop through the groups and do the requested analysis for
  * each one.
@@ -1022,13 +1211,39 @@ ProbeSetGroup *ProbesetSummarizeEngine::makeProbesetGroupFromMeta(MetaProbeset &
  * @param iMart - Memory reprentation of data.
  * @param psGroups - Groups of probe sets to be analyzed.
  * @param analysis - Analysis pathways to be computed.
+ * @param asFactory - Factory the analysis were made with, used for per thread copies.
+ * @param analysisStrings - Specifications of the analysis.
  */
 void ProbesetSummarizeEngine::doSummaries(ChipLayout &layout,
                                           IntensityMart &iMart,
                                           const vector<ProbeListPacked>& plVec,
                                           vector<MetaProbeset *> &metaToRun,
                                           vector<AnalysisStreamExpression *> &analysis,
-                                          int numPsSets) {
+                                          int numPsSets,
+                                          AnalysisStreamFactory &asFactory,
+                                          const vector<string> &analysisStrings) {
+    int threadCount = ThreadGroup::resolveThreadCount(getOptInt("threads"));
+    // These streams pick the probes to use in their own doAnalysis().
+    for (unsigned int analysisIx = 0; analysisIx < analysis.size(); analysisIx++) {
+        if (InstanceOf(analysis[analysisIx], AnalysisStreamExpPcaSel) ||
+            InstanceOf(analysis[analysisIx], AnalysisStreamExpSpectSel)) {
+            if (threadCount > 1) {
+                Verbose::out(1, "Analysis '" + analysisStrings[analysisIx] + "' can't be run on multiple threads. Using 1 thread.");
+            }
+            threadCount = 1;
+        }
+    }
+    if (threadCount > 1) {
+        int numGroups = metaToRun.size() == 0 ? plVec.size() : metaToRun.size();
+        unsigned int dotMod = max(numGroups/20, 1);
+        Verbose::out(1, "Using " + ToStr(threadCount) + " threads.");
+        Verbose::progressBegin(1, ToStr("Processing Probesets"), 20, (int)dotMod, numGroups);
+        SummarizeThreadTask task(*this, layout, iMart, plVec, metaToRun, analysis,
+                                 asFactory, analysisStrings, threadCount);
+        ThreadGroup::run(task, threadCount);
+        Verbose::progressEnd(1, ToStr("Done."));
+        return;
+    }
     vector<QuantMethodReport *> qReports;
     if (metaToRun.size() == 0) {
         unsigned int dotMod = max((int)plVec.size()/20, 1);
@@ -42,6 +42,7 @@
 //
 
 class ProbesetSummarizeEngine : public BaseEngine {
+    friend class SummarizeThreadTask;
 
     public:
 
@@ -149,7 +150,9 @@ class ProbesetSummarizeEngine : public BaseEngine {
                 const std::vector<ProbeListPacked>& plVec,
                 std::vector<MetaProbeset *> &metaToRun,
                 std::vector<AnalysisStreamExpression *> &analysis,
-                int numPsSets);
+                int numPsSets,
+                AnalysisStreamFactory &asFactory,
+                const std::vector<std::string> &analysisStrings);
         void determineDesiredOrder(
                 ChipLayout &layout, 
                 vector<int> &desiredOrder, 
@@ -38,6 +38,7 @@
 #include "util/Verbose.h"
 //
 #include <cstring>
+#include <ctime>
 #include <string>
 #include <vector>
 //
@@ -115,6 +116,8 @@ public:
   void doPlierMMTissueMedianNormTest();
   void doDabgSubsetTest();
   void doDabgU133Test();
+  void doHumanGeneThreadsTest();
+  void doHumanGeneReadAheadTest();
 };
 
 void ProbeSetSummarizeTest::doHumanGeneKillListTest() {
@@ -1168,6 +1171,112 @@ void ProbeSetSummarizeTest::doSNP6CnWf2() {
 }
 
 
+/**
+ * Run the same analysis with 1,2,4,8,16 and 32 threads. The summaries
+ * must be identical to the single threaded run. The wall clock time
+ * of each run is logged so the scaling can be seen.
+ */
+void ProbeSetSummarizeTest::doHumanGeneThreadsTest() {
+  const int threadCounts[] = {1, 2, 4, 8, 16, 32, 0};
+  const char *summaries[] = {"plier-gcbg-sketch.summary.txt", "rma-sketch.summary.txt", "dabg.summary.txt", NULL};
+  string baseDir = testDir + "/qt-doHumanGeneThreadsTest";
+  time_t singleTime = 0;
+
+  if ( !Fs::dirExists(baseDir) ) {
+    Fs::mkdirPath(baseDir, false);
+  }
+
+  for (int tIx = 0; threadCounts[tIx] != 0; tIx++) {
+    string outdir = baseDir + "/threads-" + ToStr(threadCounts[tIx]);
+    string command = "./apt-probeset-summarize "
+      "-a plier-gcbg-sketch "
+      "-a rma-sketch "
+      "-a dabg "
+      "-b ../../../regression-data/data/idata/lib/HuGene-1_0-st-v1/HuGene-1_0-st-v1.r3.bgp "
+      "-c ../../../regression-data/data/idata/lib/HuGene-1_0-st-v1/HuGene-1_0-st-v1.r3.clf "
+      "-p ../../../regression-data/data/idata/lib/HuGene-1_0-st-v1/HuGene-1_0-st-v1.r3.pgf "
+      "-m ../../../regression-data/data/idata/lib/HuGene-1_0-st-v1/HuGene-1_0-st-v1.r3.mps "
+      "-o " + outdir + " "
+      // the disk mart is serialized, so time the threads with the memory mart.
+      "--use-disk=false "
+      "--threads " + ToStr(threadCounts[tIx]) + " "
+      "--feat-effects "
+      "--cel-files " + celFileList2;
+
+    vector<RegressionCheck *> checks;
+    // summaries must not change with the number of threads.
+    for (int sIx = 0; tIx > 0 && summaries[sIx] != NULL; sIx++) {
+      checks.push_back(new MatrixCheck(
+                         outdir + "/" + summaries[sIx],
+                         baseDir + "/threads-1/" + summaries[sIx],
+                         0.0, 1, 1, false, 0));
+    }
+    RegressionTest test("qt-doHumanGeneThreadsTest-" + ToStr(threadCounts[tIx]), command.c_str(), checks);
+    test.setSuite(*this, outdir, outdir + "/apt-probeset-summarize.log", outdir + "/valgrind.log");
+
+    Verbose::out(1, "Doing doHumanGeneThreadsTest() with " + ToStr(threadCounts[tIx]) + " threads");
+    time_t startTime = time(NULL);
+    bool ok = test.pass();
+    time_t runTime = time(NULL) - startTime;
+    if (tIx == 0) {
+      singleTime = runTime;
+    }
+    Verbose::out(1, "Threads: " + ToStr(threadCounts[tIx]) + " seconds: " + ToStr((int)runTime) +
+                 (runTime > 0 ? " speedup: " + ToStr((double)singleTime / (double)runTime) : ""));
+    if(!ok) {
+      Verbose::out(1, "Error in ProbeSetSummarizeTest::doHumanGeneThreadsTest(): " + test.getErrorMsg());
+      numFailed++;
+    }
+    else {
+      numPassed++;
+    }
+  }
+}
+
+void ProbeSetSummarizeTest::doHumanGeneReadAheadTest() {
+  // read threads and depth; the first run reads the cel files one at a time.
+  const int readAhead[][2] = {{0, 0}, {1, 1}, {3, 2}, {8, 0}, {-1, -1}};
+  const char *summaries[] = {"rma-sketch.summary.txt", NULL};
+  string baseDir = testDir + "/qt-doHumanGeneReadAheadTest";
+
+  if ( !Fs::dirExists(baseDir) ) {
+    Fs::mkdirPath(baseDir, false);
+  }
+
+  for (int rIx = 0; readAhead[rIx][0] >= 0; rIx++) {
+    string name = "read-" + ToStr(readAhead[rIx][0]) + "-" + ToStr(readAhead[rIx][1]);
+    string outdir = baseDir + "/" + name;
+    string command = "./apt-probeset-summarize "
+      "-a rma-sketch "
+      "-c ../../../regression-data/data/idata/lib/HuGene-1_0-st-v1/HuGene-1_0-st-v1.r3.clf "
+      "-p ../../../regression-data/data/idata/lib/HuGene-1_0-st-v1/HuGene-1_0-st-v1.r3.pgf "
+      "-o " + outdir + " "
+      "--cel-read-threads " + ToStr(readAhead[rIx][0]) + " "
+      "--cel-read-depth " + ToStr(readAhead[rIx][1]) + " "
+      "--cel-files " + celFileList2;
+
+    vector<RegressionCheck *> checks;
+    // reading ahead must not change the order the cel files are seen in.
+    for (int sIx = 0; rIx > 0 && summaries[sIx] != NULL; sIx++) {
+      checks.push_back(new MatrixCheck(
+                         outdir + "/" + summaries[sIx],
+                         baseDir + "/read-0-0/" + summaries[sIx],
+                         0.0, 1, 1, false, 0));
+    }
+    RegressionTest test("qt-doHumanGeneReadAheadTest-" + name, command.c_str(), checks);
+    test.setSuite(*this, outdir, outdir + "/apt-probeset-summarize.log", outdir + "/valgrind.log");
+
+    Verbose::out(1, "Doing doHumanGeneReadAheadTest() " + name);
+    if(!test.pass()) {
+      Verbose::out(1, "Error in ProbeSetSummarizeTest::doHumanGeneReadAheadTest(): " + test.getErrorMsg());
+      numFailed++;
+    }
+    else {
+      numPassed++;
+    }
+  }
+}
+
 /** Everybody's favorite function. */
 int main(int argc, char* argv[]) {
   try {
@@ -1189,6 +1298,8 @@ int main(int argc, char* argv[]) {
 
     test.doHumanGeneSpfTest();
     test.doHumanGeneKillListTest();
+    test.doHumanGeneThreadsTest();
+    test.doHumanGeneReadAheadTest();
 
     // HG-U133_Plus_2 based tests
     test.doRmaTissueTest();
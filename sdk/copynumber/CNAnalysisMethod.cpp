@@ -35,6 +35,7 @@
 #include "portability/affy-base-types.h"
 #include "util/AffxStatistics.h"
 #include "util/Fs.h"
+#include "util/Thread.h"
 //
 #include <algorithm>
 #include <cmath>
@@ -44,6 +45,7 @@
 using namespace std;
 
 int CNAnalysisMethod::m_iInstanceCount = 0;
+bool CNAnalysisMethod::m_bRecordParams = true;
 std::vector<affymetrix_calvin_parameter::ParameterNameValueType> CNAnalysisMethod::m_vCelFileParams;
 std::vector<affymetrix_calvin_parameter::ParameterNameValueType> CNAnalysisMethod::m_vParams;
 
@@ -180,7 +182,6 @@ CNAnalysisMethod::CNAnalysisMethod()
     m_pvProbeSets = NULL;
     m_iXChromosome = 24;
     m_iYChromosome = 25;
-    //m_boundsFilled = false;
     m_pvProbes = NULL;
 
     m_iStep = 0;
@@ -190,7 +191,6 @@ CNAnalysisMethod::CNAnalysisMethod()
     m_dCutoff = 0;
     m_dCleanThreshold = 0;
     m_bSymmetry = false;
-    m_boundsFilled=false;
 }
 
 /**
@@ -242,7 +242,7 @@ bool CNAnalysisMethod::setupBoolParameter(const std::string& strName, const std:
   affymetrix_calvin_parameter::ParameterNameValueType param;
   param.SetName(wstr);
   param.SetValueInt8(b);
-  m_vParams.push_back(param);
+  if (m_bRecordParams) {m_vParams.push_back(param);}
   return b;
 }
 
@@ -273,7 +273,7 @@ int CNAnalysisMethod::setupIntParameter(const std::string& strName, const std::s
   affymetrix_calvin_parameter::ParameterNameValueType param;
   param.SetName(wstr);
   param.SetValueInt32(i);
-  m_vParams.push_back(param);
+  if (m_bRecordParams) {m_vParams.push_back(param);}
   return i;
 }
 
@@ -304,7 +304,7 @@ float CNAnalysisMethod::setupFloatParameter(const std::string& strName, const st
   affymetrix_calvin_parameter::ParameterNameValueType param;
   param.SetName(wstr);
   param.SetValueFloat(f);
-  m_vParams.push_back(param);
+  if (m_bRecordParams) {m_vParams.push_back(param);}
   return f;
 }
 
@@ -335,7 +335,7 @@ double CNAnalysisMethod::setupDoubleParameter(const std::string& strName, const
   affymetrix_calvin_parameter::ParameterNameValueType param;
   param.SetName(wstr);
   param.SetValueFloat(d);
-  m_vParams.push_back(param);
+  if (m_bRecordParams) {m_vParams.push_back(param);}
   return d;
 }
 
@@ -366,23 +366,16 @@ std::string CNAnalysisMethod::setupStringParameter(const std::string& strName, c
   affymetrix_calvin_parameter::ParameterNameValueType param;
   param.SetName(wstr);
   param.SetValueAscii(str);
-  m_vParams.push_back(param);
+  if (m_bRecordParams) {m_vParams.push_back(param);}
   return str;
 }
 
 
 /**
- * Cache information about starts and stops on chromosomes.  As in STL,
- * the stops are one past the last position.
+ * Return the bounds of chromosome.
+ * @param const int - The chromosome
+ * @return pair<int,int> the start and stop of the chromosome.
  */
-
-
-void CNAnalysisMethod::fillChrBounds()
-{
-  fillChrBoundsImpl(m_pvProbeSets, m_chrBounds);
-}
-
-
 pair<int, int> CNAnalysisMethod::getChrBounds(const int chr)
 {
   return getChrBounds(chr, getProbeSets());
@@ -390,20 +383,14 @@ pair<int, int> CNAnalysisMethod::getChrBounds(const int chr)
 
 
 /**
- * Return the bounds of chromosome.
+ * Return the bounds of chromosome. As in STL, the stop is one past the
+ * last position. The probe set array keeps the index.
  * @param const int - The chromosome
  * @return pair<int,int> the start and stop of the chromosome.
  */
 pair<int, int> CNAnalysisMethod::getChrBounds(const int chr, CNProbeSetArray* pvProbeSets)
 {
-  // Make sure that the desired map is filled.
-  this->fillChrBoundsImpl(pvProbeSets, m_chrBounds);
-
-  // If the chromosome is not there, here is what you get.
-  if (m_chrBounds.find(chr) == m_chrBounds.end()) return pair<int, int>(0, 0);
-
-  // If the chromosoem is there, here is what you get.
-  return m_chrBounds[chr];
+  return pvProbeSets->getChromosomeBounds(chr);
 }
 
 /**
@@ -413,19 +400,7 @@ pair<int, int> CNAnalysisMethod::getChrBounds(const int chr, CNProbeSetArray* pv
  */
 vector<int> CNAnalysisMethod::getChromosomes(CNProbeSetArray * pvProbeSetArray)
 {
-  // Make sure that the desired map is filled.
-  this->fillChrBoundsImpl(pvProbeSetArray, m_chrBounds);
-
-  // A vector with chromosomes as ints.
-  vector<int>chr_vec;
-
-  for (std::map<int, pair<int, int> >::iterator iter = m_chrBounds.begin();
-       iter != m_chrBounds.end(); iter++) {
-    chr_vec.push_back(iter->first);
-  }
-
-  // Return the vector of chromosomes.
-  return chr_vec;
+  return pvProbeSetArray->getChromosomes();
 }
 
 
@@ -437,17 +412,22 @@ vector<int> CNAnalysisMethod::getChromosomes(CNProbeSetArray * pvProbeSetArray)
 
 int CNAnalysisMethod::getProbeSetCount(int chr, CNProbeSetArray* pvProbeSets)
 {
-  // Make sure that the desired map is filled.
-  this->fillChrBoundsImpl(pvProbeSets, m_chrBounds);
-
   // If the chromosome is not there, it has size 0.  If this is an
   // error for some context then let the calling context handle the
   // problem.
-  if (m_chrBounds.find(chr) == m_chrBounds.end()) return 0;
+  return pvProbeSets->getChromosomeProbeSetCount(chr);
+}
 
-  // If the chromosoem is there, here is what you get.
-  pair<int, int> chr_span = m_chrBounds[chr];
-  return chr_span.second - chr_span.first;
+/**
+ * Return the number of threads a method may split its own work over: the
+ * engine's threads option, or 1 if the engine has none. It is not a method
+ * parameter, so it does not go in the output headers.
+ * @return int - The number of threads, at least 1.
+ */
+int CNAnalysisMethod::getThreadCount()
+{
+  if ((m_pEngine == NULL) || (!m_pEngine->isOptDefined("threads"))) {return 1;}
+  return ThreadGroup::resolveThreadCount(m_pEngine->getOptInt("threads"));
 }
 
 void CNAnalysisMethod::bin( std::vector<float>& vValues,
@@ -1468,6 +1448,8 @@ void CNAnalysisMethod::writeSmoothedLog2Ratios(std::string l2rFileInfix, CNProbe
 void CNAnalysisMethod::computeSCAR(std::vector<float>& vSCAR)
 {
     float fSCAR;
+    CNProbeSetColumns columns;
+    getProbeSets()->getColumns(std::make_pair(0, (int)getProbeSets()->size()), columns);
 
     for (int iIndex = 0; (iIndex < (int)getProbeSets()->size()); iIndex++)
     {
@@ -1478,7 +1460,9 @@ void CNAnalysisMethod::computeSCAR(std::vector<float>& vSCAR)
         // We attempt to calculate SCAR values for all ProbeSets designated as SNP.
         if(pobjProbeSet->processAsSNP())
         {
-            if(pobjProbeSet->getAAlleleSignal() == 0.0 || pobjProbeSet->getBAlleleSignal() == 0.0){
+            float fAAlleleSignal = columns.m_vAAlleleSignals[iIndex];
+            float fBAlleleSignal = columns.m_vBAlleleSignals[iIndex];
+            if(fAAlleleSignal == 0.0 || fBAlleleSignal == 0.0){
                 Verbose::warn(1, "CNAnalysisMethodLOHCyto2:: Invalid A or B allele signals were found for the ProbeSet " + pobjProbeSet->getProbeSetName());
                 vSCAR[iIndex] = CN_INVALID_DOUBLE;
                 pobjProbeSet->setValidSCARExists(false);
@@ -1493,7 +1477,7 @@ void CNAnalysisMethod::computeSCAR(std::vector<float>& vSCAR)
             }
 
             fSCAR = (
-                      2.0*( log2((float)pobjProbeSet->getAAlleleSignal()/(float)pobjProbeSet->getBAlleleSignal()) - pobjProbeSet->getMuAB() )
+                      2.0*( log2(fAAlleleSignal/fBAlleleSignal) - pobjProbeSet->getMuAB() )
                     )
                     /
                     (
@@ -1804,20 +1788,14 @@ void CNAnalysisMethod::shrinkToPeaks(CNProbeSetArray* probeSets, CNAnalysisMetho
 
     vector<bool> filteredProbeSets(probeSets->getCount(), false);
 
-    // Collect the chromosomes and sort them
-    for (map<int, pair<int, int> >::iterator it = m_chrBounds.begin();
-         it != m_chrBounds.end();
-         ++it)
-    {
-        chromosomes.push_back(it->first);
-    }
-    sort(chromosomes.begin(), chromosomes.end());
+    // Collect the chromosomes, sorted
+    chromosomes = probeSets->getChromosomes();
 
     const bool useOldDensity = isCyto2 || useKdensity;
     for (int chrInd = 0; chrInd < chromosomes.size(); chrInd++) {
         vector<pair<int, int> > windowBds;
         vector<pair<int, int> > stepWindowBds;
-        calculateWindows(windowBds, stepWindowBds, m_chrBounds[chromosomes[chrInd]], iStep, iWindow);
+        calculateWindows(windowBds, stepWindowBds, probeSets->getChromosomeBounds(chromosomes[chrInd]), iStep, iWindow);
 
         vector<vector<double> > peaks(windowBds.size());
 
@@ -1925,8 +1903,8 @@ void CNAnalysisMethod::shrinkToPeaks(CNProbeSetArray* probeSets, CNAnalysisMetho
         }
         findMaxPeaks(probeSets, windowBds, peaks);
 
-        int chrStart = m_chrBounds[chromosomes[chrInd]].first;
-        int chrEnd   = m_chrBounds[chromosomes[chrInd]].second - 1;
+        int chrStart = probeSets->getChromosomeBounds(chromosomes[chrInd]).first;
+        int chrEnd   = probeSets->getChromosomeBounds(chromosomes[chrInd]).second - 1;
         float cutoff3 = m_vThreePeakFLD_Y[cutoffIndFLD3];
         float cutoff4 = m_vFourPeakFLD_Y[cutoffIndFLD4];
 
@@ -57,9 +57,7 @@ class CNAnalysisMethod : public SelfDoc, public SelfCreate
 {
 private:
   static int m_iInstanceCount;
-  bool m_boundsFilled;
-
-  void fillChrBounds();
+  static bool m_bRecordParams;
 
 protected:
   BaseEngine* m_pEngine;
@@ -69,7 +67,6 @@ protected:
   CNExperimentArray* m_pvExperiments;     // introduced for raw SNPQC calculation
   CNProbeSetArray* m_pvProbeSets;
   CNProbeArray* m_pvProbes;
-  map<int, pair<int, int> > m_chrBounds;
   vector<double> m_vCoarseAllelePeaks;
   static std::vector<affymetrix_calvin_parameter::ParameterNameValueType> m_vCelFileParams;
   static std::vector<affymetrix_calvin_parameter::ParameterNameValueType> m_vParams;
@@ -184,6 +181,9 @@ public:
   CNProbeArray* getProbes();
   static std::vector<affymetrix_calvin_parameter::ParameterNameValueType>* getCelFileParams();
   static std::vector<affymetrix_calvin_parameter::ParameterNameValueType>* getParams();
+  /// Whether methods being made add their parameters to getParams(). Turned off
+  /// to make more copies of methods whose parameters are already there.
+  static void setRecordParams(bool bRecordParams) { m_bRecordParams = bRecordParams; }
 
   static float getConfidenceThreshold(const std::string& brlmmpStr);
 
@@ -204,6 +204,7 @@ public:
 protected:
   bool isNaN(const double& d) { return d != d; }
   int getProbeSetCount(int iChromosome, CNProbeSetArray* );
+  int getThreadCount();
   void bin(std::vector<float>& vValues, std::vector<int>& vBinIndexes, int iBinCount);
   void writeIntensities(std::string intensityFileInfix);
   void writeSignals(std::string signalFileInfix);
@@ -268,45 +269,6 @@ protected:
   int findcutoffInd(const vector<float>& cutoff);
 
 
-  void fillChrBoundsImpl(CNProbeSetArray* probeSets,  map<int, pair<int, int> >& chrBounds) {
-      // Assume that the genome is not being dynamically modified.
-      if (m_boundsFilled) return;
-
-      // Clear out the map just in case.
-      chrBounds.clear();
-
-      int chr = -1;
-      for (int i = 0; i < probeSets->size(); i++) {
-        // find out the chromosome number of this probe set
-        //int this_chr = probeSets->operator[](i)->getChromosome();
-        int this_chr = (*probeSets)[i]->getChromosome();
-
-        // if it is the same as before increment the position of the end
-        // and this iteration is done.
-        if (this_chr == chr) {
-          chrBounds[chr].second++;
-          continue;
-        }
-
-        // If it is not the same as before, make sure the order is not
-        // mangled.  The order of chromosomes is not important only
-        // that they be contiguous.  If the order is a concern, check for
-        // the order where the concern is motivated.
-        if (chrBounds.find(this_chr) != chrBounds.end()) {
-          printf("chr = %d\n", chr);
-          printf("this_chr = %d\n", this_chr);
-          throw(Except("CNAnalysisMethod::fillChrBounds() : "
-                       "chromosomes are not contiguous\n"));
-        }
-
-        // Things look good (contiguous) so start a new chromosome.
-        chrBounds[this_chr] = make_pair(i, i + 1);
-        chr = this_chr;
-      }
-
-      m_boundsFilled = true;  // No need to do this again.
-  }
-
     virtual void filterNoMansLand(
                     CNProbeSetArray* probeSets,
                     vector<bool>& filteredProbeSets,
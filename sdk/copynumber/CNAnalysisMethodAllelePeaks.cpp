@@ -338,23 +338,12 @@ void CNAnalysisMethodAllelePeaks::run()
                       "). Using window size instead.");
         iStepSize = m_iWindow;
     }
-    fillSnpChrBounds();
-
     shrinkToPeaks(getProbeSets());
 
     Verbose::out(1, "CNAnalysisMethodAllelePeaks::run(...) end");
 }
 
 
-/**
-  * Find chromosome bounds for SNP probe sets
-  */
-void CNAnalysisMethodAllelePeaks::fillSnpChrBounds()
-{
-    fillChrBoundsImpl(getProbeSets(), m_chrBounds);
-}
-
-
 void CNAnalysisMethodAllelePeaks::determineLocalProbeSets()
 {
     if(m_bLocalProbeSetsDetermined)
@@ -50,7 +50,6 @@ private:
     void computeSNPQC(CNExperiment& objExperiment, CNProbeSetArray& vProbeSets);
     void determineLocalProbeSets();
     CNProbeSetArray* getProbeSets();
-    void fillSnpChrBounds();
 
 public:
     static std::string getType() {return "allele-peaks";}
@@ -183,13 +183,15 @@ void CNAnalysisMethodAllelicDifference::calculateAllelicDifferences()
         }
     }
     // For each experiment calculate the allelic differences using the AA, AB, and BB median signal values.
+    CNProbeSetColumns columns;
+    CNAnalysisMethod::getProbeSets()->getColumns(std::make_pair(0, CNAnalysisMethod::getProbeSets()->getCount()), columns);
     for (int iRowIndex = 0; (iRowIndex < CNAnalysisMethod::getProbeSets()->getCount()); iRowIndex++)
     {
         CNProbeSet* pobjProbeSet = CNAnalysisMethod::getProbeSets()->getAt(iRowIndex);
         pobjProbeSet->setAllelicDifference((float)NaN);
         if ((!isNaN(vAAMedianSignal.get(iRowIndex))) && (!isNaN(vABMedianSignal.get(iRowIndex))) && (!isNaN(vBBMedianSignal.get(iRowIndex))))
         {
-            double dDifference = (pobjProbeSet->getAAlleleSignal() - pobjProbeSet->getBAlleleSignal());
+            double dDifference = (columns.m_vAAlleleSignals[iRowIndex] - columns.m_vBAlleleSignals[iRowIndex]);
             if (!Util::isFinite(dDifference)) {dDifference = 0.0;}
             float fGcAdjustment = pobjProbeSet->getGcAdjustment();
             if (fGcAdjustment != 0)
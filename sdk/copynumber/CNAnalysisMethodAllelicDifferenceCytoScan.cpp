@@ -145,7 +145,6 @@ void CNAnalysisMethodAllelicDifferenceCytoScan::removeAllelicDifferencesModulati
     bool AD_modulation_no_single_peak_state = false;
 
     determineLocalProbeSets();
-    fillChrBoundsImpl(getProbeSets(), m_chrBounds);
 
     std::vector<double> weights;
     computeWeights(getProbeSets(), weights);
@@ -801,7 +800,6 @@ void CNAnalysisMethodAllelicDifferenceCytoScan::postprocessAllelicDifferences()
 {
     resetAllelePeakInitialValues();
     determineLocalProbeSets();
-    fillChrBoundsImpl(getProbeSets(), m_chrBounds);
     calculateSNPQC(getProbeSets());
 
     const float dThreePeakFLD_X = 0.0;
@@ -33,8 +33,11 @@
 
 #include "copynumber/CNAnalysisMethodCN.h"
 //
+#include "copynumber/HMMEngine.h"
+//
 #include "stats/stats.h"
 #include "util/AffxMultiDimensionalArray.h"
+#include "util/Thread.h"
 //
 
 /**
@@ -288,6 +291,33 @@ SelfCreate* CNAnalysisMethodCN::newObject(std::map<std::string,std::string>& par
     return pMethod;
 }
 
+/**
+ * @brief Runs the HMM over the chromosomes on several threads, one
+ * chromosome at a time. The HMM only reads the method's parameters, so
+ * the chromosomes do not touch each other.
+ */
+class CNAnalysisMethodCNTask : public WorkQueueTask
+{
+public:
+    CNAnalysisMethodCNTask(CNAnalysisMethodCN& objMethod, std::vector<CNProbeSetColumns>& vColumns, std::vector<std::vector<int> >& vCNStates) :
+        WorkQueueTask((int)vColumns.size()), m_objMethod(objMethod), m_vColumns(vColumns), m_vCNStates(vCNStates)
+    {
+    }
+
+    virtual void runItems(int threadIx, int iStart, int iCount)
+    {
+        for (int iIndex = iStart; (iIndex < (iStart + iCount)); iIndex++)
+        {
+            m_objMethod.calculateCNStates(m_vColumns[iIndex].m_vPositions, m_vColumns[iIndex].m_vLog2Ratios, m_vCNStates[iIndex]);
+        }
+    }
+
+private:
+    CNAnalysisMethodCN& m_objMethod;
+    std::vector<CNProbeSetColumns>& m_vColumns;
+    std::vector<std::vector<int> >& m_vCNStates;
+};
+
 /**
  * @brief Run the analysis
  */
@@ -295,40 +325,47 @@ void CNAnalysisMethodCN::run()
 {
     isSetup();
 
+    setup(true, true, true, true, (m_fwdOnly == 1), true, (m_transTypeStat == 1));
+    std::vector<double> vDiagProb(5, 0.94);
+    diagProb(vDiagProb);
+
+    // The probe sets are read and written here; only the HMM is run on the threads.
+    // Chromosomes 1 to that of the last probe set, as the HMM has always been run on.
     int iLastChromosome = getProbeSets()->at(getProbeSets()->size() - 1)->getChromosome();
-    int iLastAutosomeChromosome = getLastAutosomeChromosome();
-    AffxMultiDimensionalArray<float> arAutosomeMedians(iLastAutosomeChromosome);
-//    Verbose::progressBegin(1, "CNAnalysisMethodCN::run(...) ", iLastChromosome, 1, iLastChromosome);
-    for (int iChromosome = 1; (iChromosome <= iLastChromosome); iChromosome++)
+    std::vector<int> vChromosomes;
+    std::vector<int> vAllChromosomes = getChromosomes(getProbeSets());
+    for (int iIndex = 0; (iIndex < (int)vAllChromosomes.size()); iIndex++)
     {
-//        Verbose::progressStep(1);
-        int iProbeSetCount = getProbeSetCount(iChromosome, getProbeSets());
-        if (iProbeSetCount > 0)
-        {
-            std::vector<int> vPositions(iProbeSetCount);
-            std::vector<float> vLog2Ratios(iProbeSetCount);
-            std::vector<int> vCNStates(iProbeSetCount);
-            int iIndex = 0;
-            for (int iProbeSetIndex = 0; (iProbeSetIndex < (int)getProbeSets()->size()); iProbeSetIndex++)
-            {
-                CNProbeSet* pobjProbeSet = getProbeSets()->at(iProbeSetIndex);
-                if (pobjProbeSet->getChromosome() == iChromosome)
-                {
-                    vPositions[iIndex] = pobjProbeSet->getPosition();
-                    vLog2Ratios[iIndex] = pobjProbeSet->getLog2Ratio();
-                    vCNStates[iIndex] = 0;
-                    iIndex++;
-                }
-            }
-            std::vector<double> vDiagProb(5, 0.94);
-            setup(true, true, true, true, (m_fwdOnly == 1), true, (m_transTypeStat == 1));
-            diagProb(vDiagProb);
-            std::vector<double> vStateMargProb; // unused output
-            hmm(vPositions, vLog2Ratios, vCNStates, m_vPriorProb, m_vMu, m_vSigma, m_dTransMatDecay, m_strStateEstMethod, vStateMargProb, m_uiEMIterations, m_dEMConvergentThreshold, false, m_iNormalState);
-            copyNumberStatePostProcessing(iChromosome, vLog2Ratios, vCNStates);
-        }
+        if ((vAllChromosomes[iIndex] >= 1) && (vAllChromosomes[iIndex] <= iLastChromosome)) {vChromosomes.push_back(vAllChromosomes[iIndex]);}
     }
-//    Verbose::progressEnd(1, "Done");
+    std::vector<CNProbeSetColumns> vColumns(vChromosomes.size());
+    std::vector<std::vector<int> > vCNStates(vChromosomes.size());
+    for (int iIndex = 0; (iIndex < (int)vChromosomes.size()); iIndex++)
+    {
+        getProbeSets()->getColumns(getChrBounds(vChromosomes[iIndex], getProbeSets()), vColumns[iIndex]);
+        vCNStates[iIndex].assign(vColumns[iIndex].getCount(), 0);
+    }
+
+    CNAnalysisMethodCNTask task(*this, vColumns, vCNStates);
+    task.run(getThreadCount());
+
+    for (int iIndex = 0; (iIndex < (int)vChromosomes.size()); iIndex++)
+    {
+        copyNumberStatePostProcessing(vChromosomes[iIndex], vColumns[iIndex].m_vLog2Ratios, vCNStates[iIndex]);
+    }
+}
+
+/**
+ * @brief Run the HMM on the log2 ratios of one chromosome. Safe to call
+ * on several threads at once once the HMM has been setup.
+ * @param std::vector<int>& - The positions
+ * @param std::vector<float>& - The log2 ratios
+ * @param std::vector<int>& - The CN calls, one per position
+ */
+void CNAnalysisMethodCN::calculateCNStates(std::vector<int>& vPositions, std::vector<float>& vLog2Ratios, std::vector<int>& vCNStates)
+{
+    std::vector<double> vStateMargProb; // unused output
+    hmm(vPositions, vLog2Ratios, vCNStates, m_vPriorProb, m_vMu, m_vSigma, m_dTransMatDecay, m_strStateEstMethod, vStateMargProb, m_uiEMIterations, m_dEMConvergentThreshold, false, m_iNormalState);
 }
 
 /**
@@ -354,15 +391,10 @@ void CNAnalysisMethodCN::copyNumberStatePostProcessing(int iChromosome, std::vec
             }
         }
     }
-    int iIndex = 0;
-    for (int iProbeSetIndex = 0; (iProbeSetIndex < (int)getProbeSets()->size()); iProbeSetIndex++)
+    std::pair<int, int> bounds = getChrBounds(iChromosome, getProbeSets());
+    for (int iProbeSetIndex = bounds.first; (iProbeSetIndex < bounds.second); iProbeSetIndex++)
     {
-        CNProbeSet* pobjProbeSet = getProbeSets()->at(iProbeSetIndex);
-        if (pobjProbeSet->getChromosome() == iChromosome)
-        {
-            pobjProbeSet->setCNState(vCNStates[iIndex]);
-            iIndex++;
-        }
+        getProbeSets()->at(iProbeSetIndex)->setCNState(vCNStates[iProbeSetIndex - bounds.first]);
     }
 }
 
@@ -772,6 +804,40 @@ void CNAnalysisMethodCN::reEstimate (
   } //update_log_transmat_stat
 }
 
+/**
+ * @brief The transitions between markers for CNAnalysisMethodCN::viterbi.
+ * Markers further apart are less likely to stay in the same state.
+ */
+class DecayTransitions
+{
+public:
+    DecayTransitions(const vector<double>& dist_covariate, const vector<double>& log_priorProb, double transMatDecay) :
+        m_dist_covariate(dist_covariate), m_log_priorProb(log_priorProb), m_transMatDecay(transMatDecay)
+    {
+    }
+
+    void operator()(int n, double* trans)
+    {
+        int numState = (int)m_log_priorProb.size();
+        double log_decay_factor = -(1/m_transMatDecay)*m_dist_covariate[n-1];
+        double decay_factor = exp(log_decay_factor);
+        double log_not_decay = log(1-decay_factor);
+        for(int stateI = 0; stateI < numState; stateI++) {
+            double prior_mult_exp_fn = m_log_priorProb[stateI]+log_not_decay;
+            double* t = trans + stateI * numState;
+            for(int stateJ = 0; stateJ < numState; stateJ++) {
+                t[stateJ] = prior_mult_exp_fn;
+            }
+            t[stateI] = ADD_LOG_PROB(prior_mult_exp_fn, log_decay_factor);
+        }
+    }
+
+private:
+    const vector<double>& m_dist_covariate;
+    const vector<double>& m_log_priorProb;
+    double m_transMatDecay;
+};
+
 /**
  * @brief
  * @param log_lik_obs           -
@@ -797,78 +863,43 @@ double CNAnalysisMethodCN::viterbi (
     vector<int>&                    state
     )
 {
-  double max_val,
-  trans_elem,
-  prior_mult_exp_fn;
-  int max_id = 0,
-  numobs  = (int)log_lik_obs[0].size(),
+  int numobs  = (int)log_lik_obs[0].size(),
   numState = (int)log_lik_obs.size();
-  vector< vector<double> > delta(numState, vector<double>(numobs));
-  vector< vector<int> >    psi(numState, vector<int>(numobs));
 
   //Verbose::out(3,"CNAnalysisMethodCN::hmm:viterbi - Computing Viterbi path... ");
   CNERR_CHECK((int)state.size()==numobs, "CNAnalysisMethodCN::viterbi - The number of states does NOT equal the number of observations.");
 
+  HMMEngine engine;
+  engine.setup(numState, numobs);
+
   // Step 1:Initialization
   // Note: log_lik_obs ~ log(emission probability matrix)
+  for(int n = 0; n < numobs; n++) {
+    double* emis = engine.logEmissions(n);
+    for(int stateI = 0; stateI < numState; stateI++) {
+      emis[stateI] = log_lik_obs[stateI][n];
+    }
+  }
+  const vector<double>& priorProb = (m_updateTransMat) ? updated_log_priorProb : log_priorProb;
+  vector<double> logInitial(numState);
   for(int stateI = 0; stateI < numState; stateI++) {
-    delta[stateI][0] = (m_updateTransMat) ? (log_lik_obs[stateI][0] + updated_log_priorProb[stateI]) : (log_lik_obs[stateI][0] + log_priorProb[stateI]);
-    psi[stateI][0] = max_id;
+    logInitial[stateI] = priorProb[stateI];
   } //stateI
 
-  // Step 2: Recursion
-  double log_decay_factor, decay_factor;
-  for(int n = 1; n < numobs; n++) {
-    log_decay_factor = -(1/transMatDecay)*dist_covariate[n-1];
-    decay_factor = exp(log_decay_factor);
+  // Steps 2-4: Recursion, termination and backtracking
+  double logP;
+  if (trans_type_stat) {
+    double* trans = engine.logTransitions();
     for(int stateI = 0; stateI < numState; stateI++) {
-      prior_mult_exp_fn = (m_updateTransMat) ? (updated_log_priorProb[stateI]+log(1-decay_factor)) : (log_priorProb[stateI]+log(1-decay_factor));
-      max_id = 0;
-      // Choose a very small # -Infinity to start w/
-      max_val = -1 * HUGE_VAL;
       for(int stateJ = 0; stateJ < numState; stateJ++) {
-        if (trans_type_stat) {
-          trans_elem = log_transmat_stat[stateJ][stateI];
-        } else {
-          trans_elem = prior_mult_exp_fn;
-          if(stateJ == stateI) {
-            trans_elem = ADD_LOG_PROB(trans_elem, log_decay_factor);
-          }
-        }
-
-        double dTMP = delta[stateJ][n-1] + trans_elem;
-        if ( dTMP > max_val ) {
-          max_val = dTMP;
-          max_id = stateJ;
-        }
-      } //stateJ
-      // Save the transition information for later backtracking
-      psi[stateI][n] = max_id;
-      // Update delta
-      delta[stateI][n] = log_lik_obs[stateI][n] + max_val;
-    } //stateI
-  }// numobs
-
-  // Step 3: Termination: Determine the final step(stateF) w/ the max probability(logP)
-  double logP = delta[0][numobs-1];
-  int stateF = 0;
-  for(int stateI = 0; stateI < numState; stateI++) {
-    if ( delta[stateI][numobs-1] > logP ) {
-      logP = delta[stateI][numobs-1];
-      stateF = stateI;
-    } // delta[stateI][numobs-1] > logP
-  } //stateI
-
-  // Step 4: Path(state sequence) backtracking
-  state[numobs-1] = stateF;
-  //Verbose::out(10,"CNAnalysisMethodCN::hmm:viterbi - Observation: " + ToStr(numobs-1) + " state: " + ToStr(state[numobs-1]));
-  for(int n = numobs-2; n >=0; n--) {
-    state[n] = psi[state[n+1]][n+1];
-    // Verbose::out(10,"CNAnalysisMethodCN::hmm:viterbi - Observation: " + ToStr(n) + " state: " + ToStr(state[n]));
-    if (state[n]==0) {
-      // Verbose::out(10,"CNAnalysisMethodCN::hmm:viterbi - Observation: " + ToStr(n) + " state: " + ToStr(state[n]));
+        trans[stateI * numState + stateJ] = log_transmat_stat[stateJ][stateI];
+      }
     }
-  } //numobs
+    logP = engine.viterbi(&logInitial[0], state);
+  } else {
+    DecayTransitions transitions(dist_covariate, priorProb, transMatDecay);
+    logP = engine.viterbi(&logInitial[0], transitions, state);
+  }
 
    return logP;
 }
@@ -158,6 +158,8 @@ public:
     virtual void run();
     virtual bool isSegmentTypeAnalysis();
 
+    void calculateCNStates(std::vector<int>& vPositions, std::vector<float>& vLog2Ratios, std::vector<int>& vCNStates);
+
 protected:
     int getLastAutosomeChromosome();
     void copyNumberStatePostProcessing(int iChromosome, std::vector<float>& vLog2Ratios, std::vector<int>& vCNStates);
@@ -622,6 +622,14 @@ void CNAnalysisMethodCNCyto2::run()
     vector<string> vProbeSetNamesRef;
     string referenceFileName = m_pEngine->getOpt("reference-file");
 
+    // One shrinkage plan for all the chromosomes, so its buffers are only
+    // allocated for the longest.
+    WaveletHolder W(wavelet('h',1));
+    WaveletShrinkPlan shrinkPlan(W.get(), MODE_ZEROPAD, m_shrink_lprec, 1.0,
+        m_shrink_converge);
+    shrinkPlan.setOutlier(m_shrink_downweight_outlier,
+        m_shrink_downweight_df, m_shrink_downweight_maxiter);
+
     for (int i=0; i<chromosomes.size(); i++)
     {
         int chr = chromosomes[i];
@@ -735,14 +743,7 @@ void CNAnalysisMethodCNCyto2::run()
         valarray<double> log2r_shrunk(vLog2Ratios);
 
         if (m_shrink) {
-            Wavelet * W = wavelet('h',1);
-            MODE mode=MODE_ZEROPAD;
-
-            wavelet_sandbox(log2r_shrunk, W, m_shrink_lprec, 1.0,
-                mode, m_shrink_converge, m_shrink_downweight_outlier,
-                m_shrink_downweight_df, m_shrink_downweight_maxiter);
-
-            free_wavelet(W);
+            shrinkPlan.shrink(log2r_shrunk);
             }
 
         cnHMM.add_data(log2r_shrunk, *mu_ptr, sigma_sq);
@@ -25,8 +25,18 @@
  * @brief This file contains the CNAnalysisMethodGaussianSmooth class members.
  */
 #include "copynumber/CNAnalysisMethodGaussianSmooth.h"
+//
+#include "copynumber/GKernel.h"
+//
+#include "util/Thread.h"
+//
+#include <cstdlib>
+//
 
-CNAnalysisMethodGaussianSmooth::CNAnalysisMethodGaussianSmooth() { }
+CNAnalysisMethodGaussianSmooth::CNAnalysisMethodGaussianSmooth()
+    {
+    m_iSmoothTableResolution = 0;
+    }
 
 /**
  * @brief Supply a little how/what/why about the algorithms this
@@ -66,6 +76,10 @@ getDefaultDocOptions()
         "50000", "50000", "1", "NA", "Smooth Gaussian BW"};
   opts.push_back(smooth_window);
 
+  SelfDoc::Opt smooth_table_resolution = {"smooth_table_resolution", SelfDoc::Opt::Integer,
+        "0", "0", "0", "NA", "Smooth Kernel Table Entries Per Sigma (0 = exact)"};
+  opts.push_back(smooth_table_resolution);
+
   return opts;
 }
 
@@ -99,9 +113,38 @@ newObject(std::map<std::string,std::string> & params)
     pMethod->m_smooth_bw = setupIntParameter("smooth_bw",
         strPrefix, params, doc, opts);
 
+    pMethod->m_iSmoothTableResolution = setupIntParameter("smooth_table_resolution",
+        strPrefix, params, doc, opts);
+
     return pMethod;
     }
 
+/**
+ * @brief Smooths the chromosomes on several threads, one chromosome at
+ * a time. The chromosomes are smoothed on their own, so the order they
+ * finish in does not change the output.
+ */
+class CNGaussianSmoothTask : public WorkQueueTask
+{
+public:
+    CNGaussianSmoothTask(CNAnalysisMethodGaussianSmooth& objMethod, std::vector<CNProbeSetColumns>& vColumns) :
+        WorkQueueTask((int)vColumns.size()), m_objMethod(objMethod), m_vColumns(vColumns)
+    {
+    }
+
+    virtual void runItems(int threadIx, int iStart, int iCount)
+    {
+        for (int iIndex = iStart; (iIndex < (iStart + iCount)); iIndex++)
+        {
+            m_objMethod.calculateGaussianSmooth(m_vColumns[iIndex].m_vPositions, m_vColumns[iIndex].m_vLog2Ratios);
+        }
+    }
+
+private:
+    CNAnalysisMethodGaussianSmooth& m_objMethod;
+    std::vector<CNProbeSetColumns>& m_vColumns;
+};
+
 /**
  * @brief Run the analysis
  */
@@ -111,80 +154,51 @@ void CNAnalysisMethodGaussianSmooth::run()
     isSetup();
     m_pEngine->setOpt("gaussian-smooth-exp", ::getInt(m_iExpSmoothSignal));
 
-    int last_chr = getProbeSets()->at(getProbeSets()->size() - 1)->getChromosome();
-
-//    Verbose::progressBegin(1, "CNAnalysisMethodGaussianSmooth::run(...) ",
-//        last_chr, 1, last_chr);
-
-    for (int chr=1; (chr<=last_chr); chr++)
+    if (m_iExpSmoothSignal >= 0)
         {
-        int iProbeSetCount = getProbeSetCount(chr, getProbeSets());
-        if (iProbeSetCount == 0) continue;
-//        Verbose::progressStep(1);
-        try
+        // The probe sets are read and written here; only the smoothing is done on the threads.
+        // Chromosomes 1 to that of the last probe set, as have always been smoothed.
+        int iLastChromosome = getProbeSets()->at(getProbeSets()->size() - 1)->getChromosome();
+        std::vector<int> vChromosomes;
+        std::vector<int> vAllChromosomes = getChromosomes(getProbeSets());
+        for (int iIndex = 0; (iIndex < (int)vAllChromosomes.size()); iIndex++)
             {
-            std::vector<int> vPositions(iProbeSetCount);
-            std::vector<float> vLog2Ratios(iProbeSetCount);
-            int iIndex = 0;
-            for (int i=0; i<getProbeSets()->size(); i++)
-                {
-                CNProbeSet* pobjProbeSet = getProbeSets()->at(i);
-                if (pobjProbeSet->getChromosome() == chr)
-                    {
-                    vPositions[iIndex] = pobjProbeSet->getPosition();
-                    vLog2Ratios[iIndex] = pobjProbeSet->getLog2Ratio();
-                    iIndex++;
-                    }
-                }
-
-            if (m_iExpSmoothSignal >= 0)
-                {
-                calculateGaussianSmooth(chr, vPositions, vLog2Ratios);
-                }
+            if ((vAllChromosomes[iIndex] >= 1) && (vAllChromosomes[iIndex] <= iLastChromosome)) {vChromosomes.push_back(vAllChromosomes[iIndex]);}
             }
-
-        catch(...)
+        std::vector<CNProbeSetColumns> vColumns(vChromosomes.size());
+        for (int iIndex = 0; (iIndex < (int)vChromosomes.size()); iIndex++)
             {
-            Verbose::out(1, "CNAnalysisMethodGaussianSmooth::run(...) Working on Chromosome " + ::getInt(chr));
-            throw;
+            getProbeSets()->getColumns(getChrBounds(vChromosomes[iIndex], getProbeSets()), vColumns[iIndex]);
             }
 
+        CNGaussianSmoothTask task(*this, vColumns);
+        task.run(getThreadCount());
+
+        for (int iIndex = 0; (iIndex < (int)vChromosomes.size()); iIndex++)
+            {
+            pair<int, int> chr_bounds = getChrBounds(vChromosomes[iIndex], getProbeSets());
+            for (int i=chr_bounds.first; i<chr_bounds.second; i++)
+                {
+                getProbeSets()->at(i)->setSmoothedLog2Ratio(vColumns[iIndex].m_vLog2Ratios[i - chr_bounds.first]);
+                }
+            }
         }
     normalizeGaussianSmooth();
-//    Verbose::progressEnd(1, "Done");
     Verbose::out(1, "CNAnalysisMethodGaussianSmooth::run(...) end");
     }
 
 /**
- * @brief Smooth the log2 ratios
- * @param int - Chromosome to process
- * @param bool - Is this an chromosome an autosome
+ * @brief Smooth the log2 ratios of one chromosome. Safe to call on
+ * several threads at once.
  * @param std::vector<int>& - The vector of chromosome positions
  * @param std::vector<float>& - The vector of log2 ratios to smooth
  */
 void CNAnalysisMethodGaussianSmooth::calculateGaussianSmooth(
-        int iChromosome,
         std::vector<int>& vPositions,
         std::vector<float>& vLog2Ratios)
     {
-    try
-        {
-        smooth(vLog2Ratios, vPositions, m_smooth_bw,
-                m_fSmoothSigmaMultiplier, 0, (int)vLog2Ratios.size());
-        }
-
-    catch (Except e) { throw; }
-    int iIndex = 0;
-
-    for (int i=0; i<getProbeSets()->size(); i++)
-        {
-        CNProbeSet* pobjProbeSet = getProbeSets()->at(i);
-        if (pobjProbeSet->getChromosome() == iChromosome)
-            {
-            pobjProbeSet->setSmoothedLog2Ratio(vLog2Ratios[iIndex]);
-            iIndex++;
-            }
-        }
+    smooth(vLog2Ratios, vPositions, m_smooth_bw,
+            m_fSmoothSigmaMultiplier, 0, (int)vLog2Ratios.size());
     }
 
 /**
@@ -200,6 +214,13 @@ void CNAnalysisMethodGaussianSmooth::calculateGaussianSmooth(
  * @param bw       - The bandwidth to use for the smoothing process.
  * @param startidx - The start position in the position vector.
  * @param sz       - The number of positions that should be processed.
+ *
+ * With smooth_table_resolution above 0 the weights are looked up in a
+ * GaussianKernelTable rather than computed with exp(). Each weight is then
+ * within e = 1 / (8 * resolution^2) of the exact one, and each smoothed log2
+ * ratio within e * exp(m^2 / 2) * (the range of the log2 ratios in the window)
+ * of the exact one, m being the sigma multiplier: for 1024 and 2, 8.8e-7
+ * times the range. The default resolution of 0 gives the exact results.
  */
 void CNAnalysisMethodGaussianSmooth::smooth( std::vector<float>& lrvals, const std::vector<int>& position,
                                              int smooth_bw,
@@ -219,6 +240,14 @@ void CNAnalysisMethodGaussianSmooth::smooth( std::vector<float>& lrvals, const s
   if (lrvals.size() == 1) return;
 
   float smoothDist = smooth_bw * sigmaMultiplier;
+  // Tabulate the weights out to the farthest SNP in the window, unless
+  // each is to be worked out with exp().
+  GaussianKernelTable table;
+  double scale = 0.0;
+  if (m_iSmoothTableResolution > 0) {
+    table = GaussianKernelTable(smoothDist / (double)smooth_bw, m_iSmoothTableResolution);
+    scale = (double)m_iSmoothTableResolution / smooth_bw;
+  }
   // The original log2 ratios must be kept track of since they are needed
   // for smoothing.  The smoothed log2 ratios will be kept in "tmplr"
   // until smoothing is done, then they will be copied to "lrvals".
@@ -235,8 +264,9 @@ void CNAnalysisMethodGaussianSmooth::smooth( std::vector<float>& lrvals, const s
     while ( (dist = position[curridx] - position[lbidx]) > smoothDist ) {
       ++lbidx;
     }
-    // Compute upper bandwidth index
-    ubidx = curridx + 1; // Set to the position after the current pos.
+    // Compute upper bandwidth index.  The positions are in order, so it
+    // carries on from where the last SNP's stopped.
+    if (ubidx < curridx + 1) ubidx = curridx + 1;
     while (    ubidx < sz
            && (dist = position[ubidx] - position[curridx]) <= smoothDist) {
       ++ubidx;
@@ -249,12 +279,36 @@ void CNAnalysisMethodGaussianSmooth::smooth( std::vector<float>& lrvals, const s
     denominator = 0.0;
     // Loop from the lower bound ("lbidx") to the upper bound ("ubidx")
     // updating the numerator and denominator.
-    for (idx = lbidx; idx < ubidx; ++idx) {
-      double posdiff = position[idx]-position[curridx];
-      double t       = posdiff/smooth_bw;
-      double expon   = exp(-0.5*(t*t));
-      numerator   += lrvals[idx] * expon;
-      denominator += expon;
+    if (m_iSmoothTableResolution <= 0) {
+      for (idx = lbidx; idx < ubidx; ++idx) {
+        double posdiff = position[idx]-position[curridx];
+        double t       = posdiff/smooth_bw;
+        double expon   = exp(-0.5*(t*t));
+        numerator   += lrvals[idx] * expon;
+        denominator += expon;
+      }
+    } else {
+      // Look the weights up, and keep four sums going at once so that
+      // one addition need not wait on the last.
+      const int* pPosition = &position[0];
+      const float* pLog2Ratio = &lrvals[0];
+      int currpos = pPosition[curridx];
+      double num[4] = {0.0, 0.0, 0.0, 0.0};
+      double den[4] = {0.0, 0.0, 0.0, 0.0};
+      for (idx = lbidx; idx + 3 < ubidx; idx += 4) {
+        for (int k = 0; k < 4; k++) {
+          double expon = table.weight(abs(pPosition[idx + k] - currpos) * scale);
+          num[k] += pLog2Ratio[idx + k] * expon;
+          den[k] += expon;
+        }
+      }
+      for (; idx < ubidx; ++idx) {
+        double expon = table.weight(abs(pPosition[idx] - currpos) * scale);
+        num[0] += pLog2Ratio[idx] * expon;
+        den[0] += expon;
+      }
+      numerator   = (num[0] + num[1]) + (num[2] + num[3]);
+      denominator = (den[0] + den[1]) + (den[2] + den[3]);
     }
     tmplr[iIndex] = (float)(numerator/denominator);
     iIndex++;
@@ -47,6 +47,7 @@ private:
     int m_iXChromosome;
   //
   int m_smooth_bw;
+    int m_iSmoothTableResolution;
 
 public:
     CNAnalysisMethodGaussianSmooth();
@@ -64,11 +65,10 @@ public:
     virtual void run();
     virtual bool isSegmentTypeAnalysis() {return false;}
 
-private:
-    void calculateGaussianSmooth(int iChromosome,
-            std::vector<int> & vPositions,
+    void calculateGaussianSmooth(std::vector<int> & vPositions,
             std::vector<float> & vLog2Ratios);
 
+private:
     void smooth( std::vector<float>& lrvals,
             const std::vector<int>& position,
             int smooth_bw, float sigmaMultiplier, int startidx, int sz);
@@ -267,11 +267,12 @@ Focused array values
         try
         {
             if (iChromosome > m_iYChromosome) {continue;}
+            std::pair<int, int> bounds = getChrBounds(iChromosome, getProbeSets());
             int iChromosomeProbeSetCount = 0;
-            for (int iIndex = 0; (iIndex < (int)getProbeSets()->size()); iIndex++)
+            for (int iIndex = bounds.first; (iIndex < bounds.second); iIndex++)
             {
                 CNProbeSet* pobjProbeSet = getProbeSets()->at(iIndex);
-                if (pobjProbeSet->getChromosome() == iChromosome && pobjProbeSet->isUseForCyto2LOH() )
+                if (pobjProbeSet->isUseForCyto2LOH())
                 {
                     iChromosomeProbeSetCount++;
                 }
@@ -290,11 +291,11 @@ Focused array values
             dChromosomeHetValueArray.initialize(iChromosomeProbeSetCount, m_iNumberOfVIValues);
 
             int iProbeSetIndex = 0;
-            for (int iIndex = 0; (iIndex < (int)getProbeSets()->size()); iIndex++)
+            for (int iIndex = bounds.first; (iIndex < bounds.second); iIndex++)
             {
                 CNProbeSet* pobjProbeSet = getProbeSets()->at(iIndex);
 
-                if ( pobjProbeSet->getChromosome() == iChromosome && pobjProbeSet->isUseForCyto2LOH() )
+                if (pobjProbeSet->isUseForCyto2LOH())
                 {
                     //  This is the location that we see the necessity of having vSCARreduced and vSCAR.  We
                     //  cannot, at this point in the code have vSCAR containing only SCAR values for probes
@@ -827,17 +828,17 @@ void CNAnalysisMethodLOHCyto2::loadInformationVector(std::vector<float> &vInform
 
 void CNAnalysisMethodLOHCyto2::loadPositionVector(std::vector<int> &vPosition)
 {
-    for (int iIndex = 0; (iIndex < (int)getProbeSets()->size()); iIndex++)
-    {
-        CNProbeSet* pobjProbeSet = getProbeSets()->at(iIndex);
-        vPosition[iIndex] = pobjProbeSet->getPosition();
-    }
+    CNProbeSetColumns columns;
+    getProbeSets()->getColumns(std::make_pair(0, (int)getProbeSets()->size()), columns);
+    vPosition = columns.m_vPositions;
 }
 
 void CNAnalysisMethodLOHCyto2:: computeHomHetValues(    const std::vector<float>& vSCAR,
                                                         AffxMultiDimensionalArray<double>& dHetValueArray,
                                                         AffxMultiDimensionalArray<double>& dHomValueArray)
 {
+    CNProbeSetColumns columns;
+    getProbeSets()->getColumns(std::make_pair(0, (int)getProbeSets()->size()), columns);
     for (int iIndex = 0; (iIndex < (int)getProbeSets()->size()); iIndex++)
     {
     for(int iValueIndex=0; iValueIndex < m_iNumberOfVIValues; iValueIndex++)
@@ -857,7 +858,7 @@ void CNAnalysisMethodLOHCyto2:: computeHomHetValues(    const std::vector<float>
         }
         if(pobjProbeSet->getValidSCARExists())
         {
-            if(pobjProbeSet->getAAlleleSignal() == 0.0 || pobjProbeSet->getBAlleleSignal() == 0.0){
+            if(columns.m_vAAlleleSignals[iIndex] == 0.0 || columns.m_vBAlleleSignals[iIndex] == 0.0){
                 Verbose::warn(1, "CNAnalysisMethodLOHCyto2:: Invalid A or B allele signals were found for the ProbeSet " + pobjProbeSet->getProbeSetName());
                 dHomValueArray.set(iIndex, iValueIndex, CN_INVALID_DOUBLE);
                 dHetValueArray.set(iIndex, iValueIndex, CN_INVALID_DOUBLE);
@@ -140,11 +140,11 @@ void CNAnalysisMethodLOHCytoScan::run()
         try
         {
 //        Verbose::progressStep(1);
+        std::pair<int, int> bounds = getChrBounds(iChromosome, getProbeSets());
         int iChromosomeProbeSetCount = 0;
-        for (int iIndex = 0; (iIndex < (int)getProbeSets()->size()); iIndex++)
+        for (int iIndex = bounds.first; (iIndex < bounds.second); iIndex++)
         {
-            CNProbeSet* pobjProbeSet = getProbeSets()->at(iIndex);
-            if ((vHomHet[iIndex] >= 0) && (pobjProbeSet->getChromosome() == iChromosome))
+            if (vHomHet[iIndex] >= 0)
             {
                 iChromosomeProbeSetCount++;
             }
@@ -153,10 +153,10 @@ void CNAnalysisMethodLOHCytoScan::run()
         std::vector<int> vChromosomePositions(iChromosomeProbeSetCount);
         std::vector<int> vChromosomeProbeSetIndexes(iChromosomeProbeSetCount);
         int iProbeSetIndex = 0;
-        for (int iIndex = 0; (iIndex < (int)getProbeSets()->size()); iIndex++)
+        for (int iIndex = bounds.first; (iIndex < bounds.second); iIndex++)
         {
             CNProbeSet* pobjProbeSet = getProbeSets()->at(iIndex);
-            if ((vHomHet[iIndex] >= 0) && (pobjProbeSet->getChromosome() == iChromosome))
+            if (vHomHet[iIndex] >= 0)
             {
                 vChromosomeGenotypeCalls[iProbeSetIndex] = vHomHet[iIndex];
                 vChromosomePositions[iProbeSetIndex] = pobjProbeSet->getPosition();
@@ -451,12 +451,14 @@ bool CNAnalysisMethodLOHCytoScan::lohPreProcessing(std::vector<char>& vHomHet, i
     int iNoCallCount = 0;
     double dMaximumGenotypeConfidence = 0;
     int iSnpCount = 0;
+    CNProbeSetColumns columns;
+    getProbeSets()->getColumns(std::make_pair(0, (int)getProbeSets()->size()), columns);
     for (int iIndex = 0; (iIndex < (int)getProbeSets()->size()); iIndex++)
     {
         CNProbeSet* pobjProbeSet = getProbeSets()->at(iIndex);
         pobjProbeSet->setLoh(numeric_limits<float>::quiet_NaN());
         if (pobjProbeSet->processAsSNP()) {iSnpCount++;}
-        vHomHet[iIndex] = pobjProbeSet->getGenotypeCall();
+        vHomHet[iIndex] = columns.m_vGenotypeCalls[iIndex];
         if (vHomHet[iIndex] == (char)2) {vHomHet[iIndex] = (char)0;}
         if (pobjProbeSet->getGenotypeConfidence() > m_dLohCNNoCallThreshold) {vHomHet[iIndex] = (char)-1;}
         if (vHomHet[iIndex] == 1) {iHetCount++;}
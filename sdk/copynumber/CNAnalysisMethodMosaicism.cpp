@@ -25,6 +25,7 @@
  * @brief This file contains the CNAnalysisMethodMosaicism class members.
  */
 #include "copynumber/CNAnalysisMethodMosaicism.h"
+#include "copynumber/CNRunningMedian.h"
 //
 #include "calvin_files/utils/src/StringUtils.h"
 #include "util/AffxStatistics.h"
@@ -673,9 +674,25 @@ void CNAnalysisMethodMosaicism::runmed(double* p, int iCount, int iWindowSize)
         if (iWindowSize < 0) {return;}
     }
     int iHalfWindow = (int)((double)iWindowSize/2.0);
+    // For an odd window the 50th percentile is the middle value, which the
+    // running median finds without sorting each window. Windows with NaN or
+    // infinite values are left to percentile() so they come out the same.
+    CNRunningMedian<double> objMedian;
+    std::vector<double> vValues(p, (p + iCount));
+    objMedian.setup(vValues, iWindowSize);
+    for (int iIndex = 0; (iIndex < (iWindowSize - 1)); iIndex++) {objMedian.add(iIndex);}
     for (int iIndex = iHalfWindow; (iIndex < (iCount - iHalfWindow)); iIndex++)
     {
-        vOut[iIndex] = percentile(50, (p + iIndex - iHalfWindow), iWindowSize);
+        objMedian.add(iIndex + iHalfWindow);
+        if (objMedian.getNonFiniteCount() == 0)
+        {
+            vOut[iIndex] = objMedian.getOrderStatistic(iHalfWindow);
+        }
+        else
+        {
+            vOut[iIndex] = percentile(50, (p + iIndex - iHalfWindow), iWindowSize);
+        }
+        objMedian.remove(iIndex - iHalfWindow);
     }
     for (int iIndex = (iHalfWindow - 1); (iIndex >= 0); iIndex--)
     {
@@ -32,6 +32,7 @@
 #include "copynumber/CNAnalysisMethodFactory.h"
 #include "copynumber/CNAnalysisMethodCovariateParams.h"
 #include "copynumber/CNAnalysisMethodCovariateSignalAdjuster.h"
+#include "copynumber/CNReferenceIntensityBlock.h"
 //
 #include "chipstream/SketchQuantNormTran.h"
 #include "chipstream/TsvReport.h"
@@ -175,19 +176,7 @@ void CNAnalysisMethodReference::runPart1()
         file5.open(m_strTempFileName, affx::FILE5_OPEN);
         group5 = file5.openGroup("Intensities", affx::FILE5_OPEN);
         affx::File5_Tsv* tsv5 = group5->openTsv("Intensities-" + ::getInt(getExperiment()->getIndex()), affx::FILE5_REPLACE);
-        tsv5->defineColumn(0, 0, "ProbeSetIndex", affx::FILE5_DTYPE_INT);
-        tsv5->defineColumn(0, 1, "Allele", affx::FILE5_DTYPE_INT);
-        tsv5->defineColumn(0, 2, "ProbeID", affx::FILE5_DTYPE_INT);
-        tsv5->defineColumn(0, 3, "Intensity", affx::FILE5_DTYPE_FLOAT);
-        for (int iIndex = 0; (iIndex < m_pvProbes->getCount()); iIndex++)
-        {
-            CNProbe* p = m_pvProbes->getAt(iIndex);
-            tsv5->set_i(0, 0, p->getProbeSetIndex());
-            tsv5->set_i(0, 1, p->getAllele());
-            tsv5->set_i(0, 2, p->getProbeID());
-            tsv5->set_f(0, 3, p->getIntensity());
-            tsv5->writeLevel(0);
-        }
+        writeIntensitiesTable(tsv5, m_pvProbes->getCount());
         tsv5->close();
         delete tsv5;
         group5->close();
@@ -226,33 +215,29 @@ void CNAnalysisMethodReference::runPart1()
     {
         pptsv5[uiCelIndex] = pGroup5Input->openTsv("Intensities-" + ::getInt(uiCelIndex), affx::FILE5_OPEN);
     }
-    int iProbeID = 0;
-    CNProbe objSearch;
-    AffxMultiDimensionalArray<float> vIntensities(uiCelCount);
-    m_pvProbes->quickSort(1); // ProbeID
+    indexProbesByID();
 
-    float f = 0;
-    for (unsigned int uiProbeIndex = 0; (uiProbeIndex < uiProbeCount); uiProbeIndex++)
+    // Read the intensities a block of probes at a time, probe by probe.
+    CNReferenceIntensityBlock objBlock;
+    objBlock.setup(pptsv5, uiCelCount, CNReferenceIntensityBlock::getBlockSize(uiCelCount));
+    unsigned int uiBlockProbeCount = 0;
+    for (unsigned int uiFirstProbeIndex = 0; (uiFirstProbeIndex < uiProbeCount); uiFirstProbeIndex += uiBlockProbeCount)
     {
-        for (unsigned int uiCelIndex = 0; (uiCelIndex < uiCelCount); uiCelIndex++)
+        uiBlockProbeCount = objBlock.read(uiFirstProbeIndex);
+        for (unsigned int uiBlockIndex = 0; (uiBlockIndex < uiBlockProbeCount); uiBlockIndex++)
         {
-            pptsv5[uiCelIndex]->nextLine();
-            pptsv5[uiCelIndex]->get(0, 2, &iProbeID);
-            pptsv5[uiCelIndex]->get(0, 3, &f); vIntensities.set(uiCelIndex, f);
-        }
-        double dMedianIntensity = vIntensities.median();
-        objSearch.setProbeID(iProbeID);
-        int iSearchIndex = m_pvProbes->binarySearch(objSearch, 1);
-        if (iSearchIndex != -1)
-        {
-            CNProbe* pobjProbe = m_pvProbes->getAt(iSearchIndex);
-            pobjProbe->setMedianIntensity((float)dMedianIntensity);
-            tsv5ProbeEffects->set_i(0, 0, pobjProbe->getProbeID());
-            tsv5ProbeEffects->set_d(0, 1, 0); // Place holder for probe effects
-            tsv5ProbeEffects->set_i(0, 2, pobjProbe->getProbeSetIndex());
-            tsv5ProbeEffects->set_i(0, 3, (int)pobjProbe->getAllele());
-            tsv5ProbeEffects->set_f(0, 4, (float)dMedianIntensity);
-            tsv5ProbeEffects->writeLevel(0);
+            double dMedianIntensity = objBlock.median(uiBlockIndex);
+            CNProbe* pobjProbe = getProbeByID(objBlock.getProbeID(uiBlockIndex));
+            if (pobjProbe != NULL)
+            {
+                pobjProbe->setMedianIntensity((float)dMedianIntensity);
+                tsv5ProbeEffects->set_i(0, 0, pobjProbe->getProbeID());
+                tsv5ProbeEffects->set_d(0, 1, 0); // Place holder for probe effects
+                tsv5ProbeEffects->set_i(0, 2, pobjProbe->getProbeSetIndex());
+                tsv5ProbeEffects->set_i(0, 3, (int)pobjProbe->getAllele());
+                tsv5ProbeEffects->set_f(0, 4, (float)dMedianIntensity);
+                tsv5ProbeEffects->writeLevel(0);
+            }
         }
     }
     // Close the input file
@@ -305,9 +290,9 @@ void CNAnalysisMethodReference::runPart2()
     affx::File5_Tsv* ptsv5;
     file5Input.open(m_strTempFileName, affx::FILE5_OPEN);
     pGroup5Input = file5Input.openGroup("Intensities", affx::FILE5_OPEN);
-    int iProbeID = 0;
-    float fIntensity = 0;
-    CNProbe objSearch;
+    std::vector<int> vProbeIDs;
+    std::vector<float> vIntensities;
+    indexProbesByID();
     for (unsigned int uiCelIndex = 0; (uiCelIndex < uiCelCount); uiCelIndex++)
     {
         m_pobjExperiment = getExperiments()->getAt(uiCelIndex);
@@ -327,18 +312,23 @@ void CNAnalysisMethodReference::runPart2()
             }
         }
 
+        // Read the whole table in one go, and look the probes up by ProbeID.
         m_pvProbes->quickSort(1); // ProbeID
         ptsv5 = pGroup5Input->openTsv("Intensities-" + ::getInt(uiCelIndex), affx::FILE5_OPEN);
-        for (unsigned int uiProbeIndex = 0; (uiProbeIndex < uiProbeCount); uiProbeIndex++)
+        int iLineCount = std::max(ptsv5->getLineCount(), 0);
+        vProbeIDs.resize(iLineCount);
+        vIntensities.resize(iLineCount);
+        if (iLineCount > 0)
+        {
+            ptsv5->readColumn(0, 2, 0, iLineCount, &vProbeIDs[0]);
+            ptsv5->readColumn(0, 3, 0, iLineCount, &vIntensities[0]);
+        }
+        for (unsigned int uiLineIndex = 0; (uiLineIndex < vProbeIDs.size()); uiLineIndex++)
         {
-            ptsv5->nextLine();
-            ptsv5->get(0, 2, &iProbeID);
-            ptsv5->get(0, 3, &fIntensity);
-            objSearch.setProbeID(iProbeID);
-            int iSearchIndex = m_pvProbes->binarySearch(objSearch, 1); // ProbeID
-            if (iSearchIndex != -1)
+            CNProbe* pobjProbe = getProbeByID(vProbeIDs[uiLineIndex]);
+            if (pobjProbe != NULL)
             {
-                m_pvProbes->getAt(iSearchIndex)->setIntensity(fIntensity);
+                pobjProbe->setIntensity(vIntensities[uiLineIndex]);
             }
         }
         ptsv5->close();
@@ -355,19 +345,7 @@ void CNAnalysisMethodReference::runPart2()
 
         m_pvProbes->quickSort(3); // by ProbeSetIndex, Allele, ProbeID
         ptsv5 = pGroup5Input->openTsv("Intensities-" + ::getInt(uiCelIndex), affx::FILE5_REPLACE);
-        ptsv5->defineColumn(0, 0, "ProbeSetIndex", affx::FILE5_DTYPE_INT);
-        ptsv5->defineColumn(0, 1, "Allele", affx::FILE5_DTYPE_INT);
-        ptsv5->defineColumn(0, 2, "ProbeID", affx::FILE5_DTYPE_INT);
-        ptsv5->defineColumn(0, 3, "Intensity", affx::FILE5_DTYPE_FLOAT);
-        for (unsigned int uiProbeIndex = 0; (uiProbeIndex < uiProbeCount); uiProbeIndex++)
-        {
-            CNProbe* p = m_pvProbes->getAt(uiProbeIndex);
-            ptsv5->set_i(0, 0, p->getProbeSetIndex());
-            ptsv5->set_i(0, 1, p->getAllele());
-            ptsv5->set_i(0, 2, p->getProbeID());
-            ptsv5->set_f(0, 3, p->getIntensity());
-            ptsv5->writeLevel(0);
-        }
+        writeIntensitiesTable(ptsv5, uiProbeCount);
         ptsv5->close();
         delete ptsv5;
     }
@@ -806,6 +784,52 @@ void CNAnalysisMethodReference::newProbes()
     }
 }
 
+/**
+ * @brief Index m_pvProbes by ProbeID, so the probes read from the intensities
+ * tables can be found without searching. Must be called again if m_pvProbes is replaced.
+ */
+void CNAnalysisMethodReference::indexProbesByID()
+{
+    m_vProbesByID.clear();
+    for (int iIndex = 0; (iIndex < m_pvProbes->getCount()); iIndex++)
+    {
+        CNProbe* p = m_pvProbes->getAt(iIndex);
+        if (p->getProbeID() >= m_vProbesByID.size()) {m_vProbesByID.resize(p->getProbeID() + 1, NULL);}
+        m_vProbesByID[p->getProbeID()] = p;
+    }
+}
+
+/**
+ * @brief Write the first iProbeCount of m_pvProbes to an intensities table,
+ * a column at a time.
+ * @param affx::File5_Tsv* - The newly opened table
+ * @param int - The number of probes to write
+ */
+void CNAnalysisMethodReference::writeIntensitiesTable(affx::File5_Tsv* tsv5, int iProbeCount)
+{
+    tsv5->defineColumn(0, 0, "ProbeSetIndex", affx::FILE5_DTYPE_INT);
+    tsv5->defineColumn(0, 1, "Allele", affx::FILE5_DTYPE_INT);
+    tsv5->defineColumn(0, 2, "ProbeID", affx::FILE5_DTYPE_INT);
+    tsv5->defineColumn(0, 3, "Intensity", affx::FILE5_DTYPE_FLOAT);
+    if (iProbeCount <= 0) {return;}
+    std::vector<int> vProbeSetIndexes(iProbeCount);
+    std::vector<int> vAlleles(iProbeCount);
+    std::vector<int> vProbeIDs(iProbeCount);
+    std::vector<float> vIntensities(iProbeCount);
+    for (int iIndex = 0; (iIndex < iProbeCount); iIndex++)
+    {
+        CNProbe* p = m_pvProbes->getAt(iIndex);
+        vProbeSetIndexes[iIndex] = p->getProbeSetIndex();
+        vAlleles[iIndex] = p->getAllele();
+        vProbeIDs[iIndex] = p->getProbeID();
+        vIntensities[iIndex] = p->getIntensity();
+    }
+    tsv5->appendColumn(0, 0, iProbeCount, &vProbeSetIndexes[0]);
+    tsv5->appendColumn(0, 1, iProbeCount, &vAlleles[0]);
+    tsv5->appendColumn(0, 2, iProbeCount, &vProbeIDs[0]);
+    tsv5->appendColumn(0, 3, iProbeCount, &vIntensities[0]);
+}
+
 void CNAnalysisMethodReference::processIntensities()
 {
     AffxString strReferenceFileName = m_pEngine->getOpt("reference-file");
@@ -822,7 +846,6 @@ void CNAnalysisMethodReference::processIntensities()
     unsigned int uiProbeID = 0;
     int iPrevProbeSetIndex = -1;
     char cPrevAllele = -1;
-    float* pfIntensities = new float[uiCelCount];
     int iIndex = 0;
 
     std::vector<int> vProbeIDs(m_pvProbes->getMaximumNumberProbesPerProbeSet());
@@ -893,17 +916,26 @@ void CNAnalysisMethodReference::processIntensities()
     {
         pptsv5[uiCelIndex] = pGroup5Input->openTsv("Intensities-" + ::getInt(uiCelIndex), affx::FILE5_OPEN);
     }
-    int i = 0;
-    AffxMultiDimensionalArray<float> vIntensities(uiCelCount);
-    for (unsigned int uiProbeIndex = 0; (uiProbeIndex < uiProbeCount); uiProbeIndex++)
+    indexProbesByID();
+
+    // Read the intensities a block of probes at a time, probe by probe.
+    CNReferenceIntensityBlock objBlock;
+    objBlock.setup(pptsv5, uiCelCount, CNReferenceIntensityBlock::getBlockSize(uiCelCount));
+    unsigned int uiBlockProbeCount = 0;
+    unsigned int uiBlockIndex = 0;
+    for (unsigned int uiProbeIndex = 0; (uiProbeIndex < uiProbeCount); uiProbeIndex++, uiBlockIndex++)
     {
+        if (uiBlockIndex == uiBlockProbeCount)
+        {
+            uiBlockProbeCount = objBlock.read(uiProbeIndex);
+            uiBlockIndex = 0;
+        }
+        iProbeSetIndex = objBlock.getProbeSetIndex(uiBlockIndex);
+        cAllele = objBlock.getAllele(uiBlockIndex);
+        uiProbeID = (unsigned int)objBlock.getProbeID(uiBlockIndex);
+        const float* pfIntensities = objBlock.getIntensities(uiBlockIndex);
         for (unsigned int uiCelIndex = 0; (uiCelIndex < uiCelCount); uiCelIndex++)
         {
-            pptsv5[uiCelIndex]->nextLine();
-            pptsv5[uiCelIndex]->get(0, 0, &iProbeSetIndex);
-            pptsv5[uiCelIndex]->get(0, 1, &i); cAllele = (char)i;
-            pptsv5[uiCelIndex]->get(0, 2, &i); uiProbeID = (unsigned int)i;
-            pptsv5[uiCelIndex]->get(0, 3, &pfIntensities[uiCelIndex]);
             tcall[uiCelIndex] = affx::NN;
         }
 
@@ -949,10 +981,9 @@ void CNAnalysisMethodReference::processIntensities()
             m_ppdPM[uiCelIndex][iIndex] = pfIntensities[uiCelIndex];
             m_ppdMM[uiCelIndex][iIndex] = 0;
             m_ppdResiduals[uiCelIndex][iIndex] = 0;
-            vIntensities.set(uiCelIndex, pfIntensities[uiCelIndex]);
         }
         if (iIndex >= vMedianIntensities.size()) {vMedianIntensities.push_back(0);}
-        vMedianIntensities[iIndex] = vIntensities.median();
+        vMedianIntensities[iIndex] = objBlock.median(uiBlockIndex);
         iIndex++;
     }
     if (iPrevProbeSetIndex != -1)
@@ -1064,7 +1095,6 @@ void CNAnalysisMethodReference::processIntensities()
 
     delete[] pdAAlleleSignals;
     delete[] pdBAlleleSignals;
-    delete[] pfIntensities;
     delete[] pptsv5;
     delete[] pptsv5Signals;
 }
@@ -1142,22 +1172,20 @@ void CNAnalysisMethodReference::callPlier(    int iProbeSetIndex,
     m_pPlier->setNumFeature(iProbeCount);
     m_pPlier->run(&errorCode);
     if (errorCode != 0) {Err::errAbort("Problem running plier. Error code: " + ToStr(errorCode));}
-    CNProbe objSearch;
     if (tsv5 != NULL)
     {
         for (int i = 0; (i < iProbeCount); i++)
         {
             float fPredictedIntensity = 0;
             float fMedianIntensity = 0;
-            objSearch.setProbeID(vProbeIDs[i]);
-            int iSearchIndex = m_pvProbes->binarySearch(objSearch, 1); // ProbeID
-            if (iSearchIndex != -1)
+            CNProbe* pobjProbe = getProbeByID(vProbeIDs[i]);
+            if (pobjProbe != NULL)
             {
                 if(pdnnReferenceValuesExist)
                 {
-                    fPredictedIntensity = m_pvProbes->getAt(iSearchIndex)->getPredictedIntensity();
+                    fPredictedIntensity = pobjProbe->getPredictedIntensity();
                 }
-                fMedianIntensity = m_pvProbes->getAt(iSearchIndex)->getMedianIntensity();
+                fMedianIntensity = pobjProbe->getMedianIntensity();
             }
 
            // 09/14/2009 Walt Short - This is the fix for the 'Known' bug in v2.0 that was released.
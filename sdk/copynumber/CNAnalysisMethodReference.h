@@ -112,11 +112,16 @@ protected:
     std::vector<float> m_vFourPeakShrink_X;
     std::vector<float> m_vFourPeakShrink_Y;
 
+    /// m_pvProbes by ProbeID, NULL where there is no probe. See indexProbesByID().
+    std::vector<CNProbe*> m_vProbesByID;
 
 protected:
     void calculateReferenceSketch();
     bool writeReferenceSketch(const std::string& strName, std::vector<double>& vReferenceSketch);
     virtual void newProbes();
+    void indexProbesByID();
+    void writeIntensitiesTable(affx::File5_Tsv* tsv5, int iProbeCount);
+    CNProbe* getProbeByID(unsigned int uiProbeID) {return ((uiProbeID < m_vProbesByID.size()) ? m_vProbesByID[uiProbeID] : NULL);}
     void processIntensities();
     void callPlier(int iProbeSetIndex, char cAllele, std::vector<int>& vProbeIDs, int iProbeCount, affx::File5_Tsv* tsv5, std::vector<float>& vMedianIntensities);
     void setSignals(    char cAllele,
@@ -835,14 +835,6 @@ void CNCychpSegments::newCychpSegmentMosaicism(unsigned int uiDataSetIndex, affy
 }
 
 
-/**
- * For Mendelian Inheritance Error (MIE) results
- */
-std::map<unsigned char, unsigned int> CNCychp::m_mMarkerCount;
-std::map<unsigned char, int> CNCychp::m_mMIE_Trio;
-std::map<unsigned char, int> CNCychp::m_mMIE_Mat;
-std::map<unsigned char, int> CNCychp::m_mMIE_Pat;
-
 
 /**
  * CNCychp constructor.
@@ -874,6 +866,43 @@ void CNCychp::clear()
   getCychpChromosomesSummaries().clear();
   getCychpProbeSetsCopyNumbers().clear();
   getCychpSegments().clear();
+  m_mMarkerCount.clear();
+  m_mMIE_Trio.clear();
+  m_mMIE_Mat.clear();
+  m_mMIE_Pat.clear();
+}
+
+void CNCychp::copy(CNCychp& that)
+{
+  clear();
+  m_strFileName = that.m_strFileName;
+  m_objCNCychpHeader = that.m_objCNCychpHeader;
+  m_strARRGuid = that.m_strARRGuid;
+  m_selectedQC = that.m_selectedQC;
+  m_strFamilialType = that.m_strFamilialType;
+  m_ucFamilialCall = that.m_ucFamilialCall;
+  m_fFamilialConfidence = that.m_fFamilialConfidence;
+  m_ucFamilialDuoCall = that.m_ucFamilialDuoCall;
+  m_fFamilialDuoConfidence = that.m_fFamilialDuoConfidence;
+  m_mMarkerCount = that.m_mMarkerCount;
+  m_mMIE_Trio = that.m_mMIE_Trio;
+  m_mMIE_Mat = that.m_mMIE_Mat;
+  m_mMIE_Pat = that.m_mMIE_Pat;
+  m_vCychpChromosomesSummaries.reserve(that.m_vCychpChromosomesSummaries.getCount());
+  for (int iIndex = 0; (iIndex < that.m_vCychpChromosomesSummaries.getCount()); iIndex++)
+  {
+    m_vCychpChromosomesSummaries.add(new CNCychpChromosomesSummary(*that.m_vCychpChromosomesSummaries.getAt(iIndex)));
+  }
+  m_vCychpProbeSetsCopyNumbers.reserve(that.m_vCychpProbeSetsCopyNumbers.getCount());
+  for (int iIndex = 0; (iIndex < that.m_vCychpProbeSetsCopyNumbers.getCount()); iIndex++)
+  {
+    m_vCychpProbeSetsCopyNumbers.add(new CNCychpProbeSetsCopyNumber(*that.m_vCychpProbeSetsCopyNumbers.getAt(iIndex)));
+  }
+  m_vCNCychpSegments.reserve(that.m_vCNCychpSegments.getCount());
+  for (int iIndex = 0; (iIndex < that.m_vCNCychpSegments.getCount()); iIndex++)
+  {
+    m_vCNCychpSegments.add(new CNCychpSegment(*that.m_vCNCychpSegments.getAt(iIndex)));
+  }
 }
 
 /**
@@ -447,11 +447,11 @@ private:
   float m_fFamilialDuoConfidence;
 
 public:
-  static std::map<unsigned char, unsigned int> m_mMarkerCount;
-  static std::map<unsigned char, int> m_mMIE_Trio;
-  static std::map<unsigned char, int> m_mMIE_Mat;
-  static std::map<unsigned char, int> m_mMIE_Pat;
-
+  /// Mendelian Inheritance Error (MIE) results by chromosome, kept on the index of each family.
+  std::map<unsigned char, unsigned int> m_mMarkerCount;
+  std::map<unsigned char, int> m_mMIE_Trio;
+  std::map<unsigned char, int> m_mMIE_Mat;
+  std::map<unsigned char, int> m_mMIE_Pat;
 
 public:
   CNCychp();
@@ -477,6 +477,12 @@ public:
   void warning(const AffxString& strMessage);
   void error(const AffxString& strMessage);
 
+  /**
+   * @brief Make this a copy of another cychp's data, row by row.
+   * @param CNCychp& - The cychp to copy.
+   */
+  void copy(CNCychp& that);
+
   bool readFile(const AffxString& strFileName, AffxArray<CNCychpProbeSetsCopyNumber>& vProbeSets, bool bLoadProbeSetName = true, bool bNonNanOnly = false);
   bool readFile(const AffxString& strFileName, const AffxString& strFamilialType, const AffxString& strPrompt = "");
   bool readFile(const AffxString& strFileName, const groupDatasets_t& groupDatasets, const AffxString& strFamilialType, const AffxString& strPrompt = "");
@@ -41,10 +41,12 @@
 #include "file5/File5.h"
 #include "file5/File5_File.h"
 #include "util/Fs.h"
+#include "util/Thread.h"
 #include "util/TmpFileFactory.h"
 //
 #include "../external/newmat/myexcept.h"
 //
+#include <algorithm>
 #include <sstream>
 //
 
@@ -288,6 +290,10 @@ void CNCytoEngine::defineOptions() {
   defineOption("", "keep-temp-reference-data", PgOpt::BOOL_OPT,
                     "Set to true, this option will keep the final signal and intensity values computed "
                     "while determining the CN reference file.  Warning: It may be large.", "false" );
+  defineOption("", "threads", PgOpt::INT_OPT,
+                    "Number of samples to analyse at the same time, each on its own thread. "
+                    "0 means one thread per cpu. Each thread keeps its own copy of the probe set data. "
+                    "Output is the same for any number of threads.", "1");
   defineOption("", "keep-intermediate-data", PgOpt::BOOL_OPT,
                     "Set to true, this option will keep all, intensity values computed "
                     "while invoking any intensity adjustment method.", "false" );
@@ -1624,35 +1630,23 @@ void CNCytoEngine::useReference(bool bAnalysis)
         data.getBAlleleEstimates()->initialize(iExperimentCount, iProbeSetCount);
         data.getGenotypeCalls()->initialize(iExperimentCount, iProbeSetCount);
     }
-    for (int iExperimentIndex = 0; (iExperimentIndex < iExperimentCount); iExperimentIndex++)
+    // The first sample is always run here. The rest may be run on other threads.
+    int iThreadCount = ThreadGroup::resolveThreadCount(getOptInt("threads"));
+    if (iThreadCount > (iExperimentCount - 1)) {iThreadCount = iExperimentCount - 1;}
+    if ((iThreadCount > 1) && ((getOptBool("keep-intermediate-data")) || (getOptBool("keep-intermediate-data-local"))))
     {
-
-
-        std::string strExperimentName = (*data.getExperiments()->getAt(iExperimentIndex)).getExperimentName();
-        Verbose::out(1, "MAJOR PROGRESS UPDATE: Running  Analysis of Sample: " + strExperimentName);
-
-        pChipstream->setup(*data.getExperiments(), iExperimentIndex, *data.getProbeSetsAlternateSort());
-        pChipstream->run();
-        if (bAnalysis)
-        {
-            engine.process(*data.getExperiments()->getAt(iExperimentIndex), arProbeSetsToProcess, pChipstream->getProbes());
-            if ((isOptDefined("cancer")) && (getOptInt("cancer") == 2))
-            {
-                engine.process(*data.getExperiments()->getAt(iExperimentIndex), arProbeSetsToProcess);
-            }
-            if (getOptBool("log2ratio-text-output")) {writeOutputText(*data.getExperiments()->getAt(iExperimentIndex), arProbeSetsToProcess);}
-            if (getOptBool("log2ratio-hdf5-output")) {writeOutputHdf5(*data.getExperiments()->getAt(iExperimentIndex), arProbeSetsToProcess);}
-        }
-        else
-        {
-            for (int iIndex = 0; (iIndex < iProbeSetCount); iIndex++)
-            {
-                CNProbeSet* pobjProbeSet = data.getProbeSetsAlternateSort()->getAt(iIndex);
-                data.getAAlleleEstimates()->set(iExperimentIndex, iIndex, pobjProbeSet->getAAlleleSignal());
-                data.getBAlleleEstimates()->set(iExperimentIndex, iIndex, pobjProbeSet->getBAlleleSignal());
-                data.getGenotypeCalls()->set(iExperimentIndex, iIndex, pobjProbeSet->getGenotypeCall());
-            }
-        }
+        Verbose::out(1, "Intermediate data can't be kept on multiple threads. Using 1 thread.");
+        iThreadCount = 1;
+    }
+    int iSerialCount = ((iThreadCount > 1) ? 1 : iExperimentCount);
+    for (int iExperimentIndex = 0; (iExperimentIndex < iSerialCount); iExperimentIndex++)
+    {
+        analyseSample(data, *data.getExperiments(), iExperimentIndex, bAnalysis, *this, *pChipstream, engine,
+                      *data.getProbeSetsAlternateSort(), arProbeSetsToProcess);
+    }
+    if (iThreadCount > 1)
+    {
+        analyseSamplesInParallel(data, bAnalysis, arProbeSetsToProcess, iThreadCount);
     }
     delete pChipstream;
 
@@ -1681,6 +1675,202 @@ void CNCytoEngine::useReference(bool bAnalysis)
     }
 }
 
+/**
+ * @brief Run the chipstream and the analysis methods on one sample, then write its output.
+ * @param CNLog2RatioData& - The data loaded by useReference().
+ * @param CNExperimentArray& - The experiments the chipstream is setup with.
+ * @param int - The index of the sample in the experiment array.
+ * @param bool - Analyse the sample, or save its signals to build a reference.
+ * @param BaseEngine& - The options the methods are using.
+ * @param CNAnalysisMethod& - The chipstream method.
+ * @param CNAnalysisEngine& - The analysis methods and reporters.
+ * @param CNProbeSetArray& - The probe sets which hold the results for this sample.
+ * @param CNProbeSetArray& - The probe sets to analyse, sorted by chromosome and position.
+ */
+void CNCytoEngine::analyseSample(CNLog2RatioData& data, CNExperimentArray& vExperiments, int iExperimentIndex, bool bAnalysis,
+                                 BaseEngine& objOptions, CNAnalysisMethod& objChipstream, CNAnalysisEngine& engine,
+                                 CNProbeSetArray& vProbeSets, CNProbeSetArray& vProbeSetsToProcess)
+{
+    CNExperiment* pobjExperiment = vExperiments.getAt(iExperimentIndex);
+    Verbose::out(1, "MAJOR PROGRESS UPDATE: Running  Analysis of Sample: " + pobjExperiment->getExperimentName());
+
+    objChipstream.setup(vExperiments, iExperimentIndex, vProbeSets);
+    objChipstream.run();
+    if (bAnalysis)
+    {
+        engine.process(*pobjExperiment, vProbeSetsToProcess, objChipstream.getProbes());
+        if ((objOptions.isOptDefined("cancer")) && (objOptions.getOptInt("cancer") == 2))
+        {
+            engine.process(*pobjExperiment, vProbeSetsToProcess);
+        }
+        if (objOptions.getOptBool("log2ratio-text-output")) {writeOutputText(objOptions, *pobjExperiment, vProbeSetsToProcess);}
+        if (objOptions.getOptBool("log2ratio-hdf5-output")) {writeOutputHdf5(objOptions, *pobjExperiment, vProbeSetsToProcess);}
+    }
+    else
+    {
+        int iCelIndex = pobjExperiment->getIndex();
+        for (int iIndex = 0; (iIndex < vProbeSets.getCount()); iIndex++)
+        {
+            CNProbeSet* pobjProbeSet = vProbeSets.getAt(iIndex);
+            data.getAAlleleEstimates()->set(iCelIndex, iIndex, pobjProbeSet->getAAlleleSignal());
+            data.getBAlleleEstimates()->set(iCelIndex, iIndex, pobjProbeSet->getBAlleleSignal());
+            data.getGenotypeCalls()->set(iCelIndex, iIndex, pobjProbeSet->getGenotypeCall());
+        }
+    }
+}
+
+/**
+ * @brief The options of one worker thread. Methods set options as they
+ * run (the cancer state, peak flags...) so each worker has its own copy.
+ */
+class CNCytoSampleOptions : public BaseEngine
+{
+public:
+    virtual std::string getEngineName() { return CNCytoEngine::EngineName(); }
+};
+
+/**
+ * @brief What one worker thread needs to analyse samples on its own.
+ * The CNProbeSet objects hold the per sample results (signals, log2
+ * ratios, calls, states...) so the worker has its own copy of them to
+ * write into. The annotation and reference data in them are only read.
+ */
+class CNCytoSampleWorker
+{
+public:
+    CNCytoSampleOptions m_objOptions;
+    CNProbeSetArray m_vProbeSets;
+    CNProbeSetArray m_vProbeSetsToProcess;
+    /// The sample being analysed; the chipstream is setup with this.
+    CNExperimentArray m_vExperiments;
+    CNAnalysisMethod* m_pChipstream;
+    CNAnalysisEngine m_objEngine;
+
+    CNCytoSampleWorker() : m_pChipstream(NULL) {}
+    ~CNCytoSampleWorker()
+    {
+        delete m_pChipstream;
+        m_vExperiments.nullAll();
+        m_vProbeSetsToProcess.nullAll();
+        m_vProbeSets.deleteAll();
+    }
+};
+
+/**
+ * @brief Analyses the samples after the first on several threads, one
+ * sample at a time, each thread with its own CNCytoSampleWorker. Each
+ * sample is written to its own files, so the order the samples finish
+ * in does not change the output.
+ */
+class CNCytoSampleTask : public WorkQueueTask
+{
+public:
+    CNCytoSampleTask(CNCytoEngine& objEngine, CNLog2RatioData& data, std::vector<CNCytoSampleWorker*>& vWorkers, bool bAnalysis) :
+        WorkQueueTask(data.getExperiments()->getCount(), 1), m_objEngine(objEngine), m_data(data), m_vWorkers(vWorkers), m_bAnalysis(bAnalysis)
+    {
+    }
+
+    virtual void runItems(int threadIx, int iStart, int iCount)
+    {
+        CNCytoSampleWorker* pWorker = m_vWorkers[threadIx];
+        for (int iExperimentIndex = iStart; (iExperimentIndex < (iStart + iCount)); iExperimentIndex++)
+        {
+            pWorker->m_vExperiments.nullAll();
+            pWorker->m_vExperiments.add(m_data.getExperiments()->getAt(iExperimentIndex));
+            m_objEngine.analyseSample(m_data, pWorker->m_vExperiments, 0, m_bAnalysis, pWorker->m_objOptions,
+                                      *pWorker->m_pChipstream, pWorker->m_objEngine,
+                                      pWorker->m_vProbeSets, pWorker->m_vProbeSetsToProcess);
+        }
+    }
+
+private:
+    CNCytoEngine& m_objEngine;
+    CNLog2RatioData& m_data;
+    std::vector<CNCytoSampleWorker*>& m_vWorkers;
+    bool m_bAnalysis;
+};
+
+/**
+ * @brief Analyse the samples after the first on several threads.
+ * The workers start from the probe sets and options as the first
+ * sample left them, which is what the second sample sees on one thread.
+ * @param CNLog2RatioData& - The data loaded by useReference().
+ * @param bool - Analyse the samples, or save their signals to build a reference.
+ * @param CNProbeSetArray& - The probe sets to analyse, sorted by chromosome and position.
+ * @param int - The number of threads to use.
+ */
+void CNCytoEngine::analyseSamplesInParallel(CNLog2RatioData& data, bool bAnalysis, CNProbeSetArray& arProbeSetsToProcess, int iThreadCount)
+{
+    Verbose::out(1, "Using " + ToStr(iThreadCount) + " threads.");
+    CNProbeSetArray& vProbeSets = *data.getProbeSetsAlternateSort();
+    int iProbeSetCount = vProbeSets.getCount();
+    // Where each probe set is in vProbeSets, to find its copy.
+    std::vector<std::pair<CNProbeSet*, int> > vPositions(iProbeSetCount);
+    for (int iIndex = 0; (iIndex < iProbeSetCount); iIndex++)
+    {
+        vPositions[iIndex] = std::make_pair(vProbeSets.getAt(iIndex), iIndex);
+    }
+    std::sort(vPositions.begin(), vPositions.end());
+
+    CNAnalysisMethodFactory amFactory;
+    std::vector<CNCytoSampleWorker*> vWorkers;
+    try
+    {
+        // The methods and options are made here; doing it on the threads is not safe.
+        // The first sample's methods have already added the parameters the reporters write.
+        CNAnalysisMethod::setRecordParams(false);
+        for (int iThreadIndex = 0; (iThreadIndex < iThreadCount); iThreadIndex++)
+        {
+            CNCytoSampleWorker* pWorker = new CNCytoSampleWorker;
+            vWorkers.push_back(pWorker);
+            pWorker->m_objOptions.copyOptions(*this);
+            pWorker->m_vProbeSets.reserve(iProbeSetCount);
+            for (int iIndex = 0; (iIndex < iProbeSetCount); iIndex++)
+            {
+                pWorker->m_vProbeSets.add(new CNProbeSet(*vProbeSets.getAt(iIndex)));
+            }
+            pWorker->m_vProbeSetsToProcess.reserve(arProbeSetsToProcess.getCount());
+            for (int iIndex = 0; (iIndex < arProbeSetsToProcess.getCount()); iIndex++)
+            {
+                std::vector<std::pair<CNProbeSet*, int> >::iterator it =
+                    std::lower_bound(vPositions.begin(), vPositions.end(), std::make_pair(arProbeSetsToProcess.getAt(iIndex), 0));
+                pWorker->m_vProbeSetsToProcess.add(pWorker->m_vProbeSets.getAt(it->second));
+            }
+            pWorker->m_pChipstream = amFactory.CNAnalysisMethodForString(getOpt("chipstream"));
+            pWorker->m_pChipstream->setEngine(&pWorker->m_objOptions);
+            pWorker->m_objEngine.setEngine(&pWorker->m_objOptions);
+            pWorker->m_objEngine.createAnalysis();
+            // createAnalysis() and the methods setEngine() reset some options; put back what the first sample left.
+            pWorker->m_objOptions.copyOptions(*this);
+            // The samples are the threads here; the methods each worker runs stay on its thread.
+            pWorker->m_objOptions.setOpt("threads", "1");
+        }
+        CNAnalysisMethod::setRecordParams(true);
+
+        CNCytoSampleTask task(*this, data, vWorkers, bAnalysis);
+        // hdf5 is not thread safe. The lock is held from a file's open() to its close(),
+        // so the workers take turns at all their a5 reads and writes, not just single calls.
+        affx::File5_File::setThreadLock(true);
+        try
+        {
+            task.run(iThreadCount);
+        }
+        catch (...)
+        {
+            affx::File5_File::setThreadLock(false);
+            throw;
+        }
+        affx::File5_File::setThreadLock(false);
+    }
+    catch (...)
+    {
+        CNAnalysisMethod::setRecordParams(true);
+        for (int iIndex = 0; (iIndex < (int)vWorkers.size()); iIndex++) {delete vWorkers[iIndex];}
+        throw;
+    }
+    for (int iIndex = 0; (iIndex < (int)vWorkers.size()); iIndex++) {delete vWorkers[iIndex];}
+}
+
 void CNCytoEngine:: loadReferenceHeader(std::string strReferenceFileName)
 {
         try
@@ -2151,20 +2341,21 @@ void CNCytoEngine::calculateGenders(CNLog2RatioData& data)
 
 /**
  * @brief Ouptut the SNP data in ASCII text format.
+ * @param BaseEngine& - The options the sample was analysed with; they go in the header.
  * @param int - The experiment index to process.
  * @return bool - true if successful
  */
-bool CNCytoEngine::writeOutputText(CNExperiment& objExperiment, CNProbeSetArray& vProbeSets)
+bool CNCytoEngine::writeOutputText(BaseEngine& objOptions, CNExperiment& objExperiment, CNProbeSetArray& vProbeSets)
 {
     Verbose::out(3, "CNCytoEngine::writeOutputText");
     AffxString strFileName;
-    if (getOpt("set-analysis-name") != "")
+    if (objOptions.getOpt("set-analysis-name") != "")
     {
-      strFileName = Fs::join(getOpt("out-dir"),getOpt("set-analysis-name")+"."+objExperiment.getExperimentName()+".txt");
+      strFileName = Fs::join(objOptions.getOpt("out-dir"),objOptions.getOpt("set-analysis-name")+"."+objExperiment.getExperimentName()+".txt");
     }
     else
     {
-      strFileName = Fs::join(getOpt("out-dir"),objExperiment.getExperimentName()+".txt");
+      strFileName = Fs::join(objOptions.getOpt("out-dir"),objExperiment.getExperimentName()+".txt");
     }
     affx::TsvFile tsv;
     tsv.addHeader("guid", affxutil::Guid::GenerateNewGuid());
@@ -2172,16 +2363,16 @@ bool CNCytoEngine::writeOutputText(CNExperiment& objExperiment, CNProbeSetArray&
 
     // dump options.
     std::vector<std::string> optionNames;
-    getOptionNames(optionNames,1);
+    objOptions.getOptionNames(optionNames,1);
     for(int i=0; i< optionNames.size(); i++) {
-      std::vector<std::string> vals = getOptVector(optionNames[i],1);
+      std::vector<std::string> vals = objOptions.getOptVector(optionNames[i],1);
       if (vals.size() > 1) {
         for(int j=0; j< vals.size(); j++) {
           tsv.addHeader("affymetrix-algorithm-param-apt-" + optionNames[i] + "-" + ::getInt(j+1), vals[j]);
         }
       }
       else {
-        tsv.addHeader("affymetrix-algorithm-param-apt-" + optionNames[i],  getOpt(optionNames[i],1));
+        tsv.addHeader("affymetrix-algorithm-param-apt-" + optionNames[i],  objOptions.getOpt(optionNames[i],1));
       }
     }
     tsv.writeTsv_v1(strFileName);
@@ -2220,20 +2411,21 @@ bool CNCytoEngine::writeOutputText(CNExperiment& objExperiment, CNProbeSetArray&
 
 /**
  * @brief Ouptut the SNP data in HDF5 fformat.
+ * @param BaseEngine& - The options the sample was analysed with; they go in the header.
  * @param int - The experiment index to process.
  * @return bool - true if successful
  */
-bool CNCytoEngine::writeOutputHdf5(CNExperiment& objExperiment, CNProbeSetArray& vProbeSets)
+bool CNCytoEngine::writeOutputHdf5(BaseEngine& objOptions, CNExperiment& objExperiment, CNProbeSetArray& vProbeSets)
 {
     Verbose::out(3, "CNCytoEngine::writeOutputHdf5");
     AffxString strFileName;
-    if (getOpt("set-analysis-name") != "")
+    if (objOptions.getOpt("set-analysis-name") != "")
     {
-      strFileName = Fs::join(getOpt("out-dir"),getOpt("set-analysis-name")+"."+objExperiment.getExperimentName()+".a5");
+      strFileName = Fs::join(objOptions.getOpt("out-dir"),objOptions.getOpt("set-analysis-name")+"."+objExperiment.getExperimentName()+".a5");
     }
     else
     {
-      strFileName = Fs::join(getOpt("out-dir"),objExperiment.getExperimentName()+".a5");
+      strFileName = Fs::join(objOptions.getOpt("out-dir"),objExperiment.getExperimentName()+".a5");
     }
     try
     {
@@ -2246,9 +2438,9 @@ bool CNCytoEngine::writeOutputHdf5(CNExperiment& objExperiment, CNProbeSetArray&
 
         // dump options.
         vector<string> optionNames;
-        getOptionNames(optionNames,1);
+        objOptions.getOptionNames(optionNames,1);
         for(int i=0; i< optionNames.size(); i++) {
-            std::vector<std::string> vals = getOptVector(optionNames[i],1);
+            std::vector<std::string> vals = objOptions.getOptVector(optionNames[i],1);
             if (vals.size() > 1)
             {
                 for(int j=0; j< vals.size(); j++)
@@ -2258,7 +2450,7 @@ bool CNCytoEngine::writeOutputHdf5(CNExperiment& objExperiment, CNProbeSetArray&
             }
             else
             {
-                tsv5->set_string(0, 0, "#%affymetrix-algorithm-param-apt-" + optionNames[i] + "=" + getOpt(optionNames[i],1)); tsv5->writeLevel(0);
+                tsv5->set_string(0, 0, "#%affymetrix-algorithm-param-apt-" + optionNames[i] + "=" + objOptions.getOpt(optionNames[i],1)); tsv5->writeLevel(0);
             }
         }
 
@@ -41,6 +41,9 @@
 
 using namespace std;
 
+class CNAnalysisEngine;
+class CNAnalysisMethod;
+
 /**
  * @brief  The engine for controlling the copynumber Cytos.
  */
@@ -143,8 +146,14 @@ public:
     static AffxString getAnnotationVersion(const AffxString& strFileName) {return getAnnotationParameter(strFileName, "affymetrix-algorithm-param-netaffx-build");}
 
 protected:
+    friend class CNCytoSampleTask;
+
     void createReference();
     void useReference(bool bAnalyis);
+    void analyseSample(CNLog2RatioData& data, CNExperimentArray& vExperiments, int iExperimentIndex, bool bAnalysis,
+                       BaseEngine& objOptions, CNAnalysisMethod& objChipstream, CNAnalysisEngine& engine,
+                       CNProbeSetArray& vProbeSets, CNProbeSetArray& vProbeSetsToProcess);
+    void analyseSamplesInParallel(CNLog2RatioData& data, bool bAnalysis, CNProbeSetArray& arProbeSetsToProcess, int iThreadCount);
     void defineStdMethods();
 
     void callGenoQCEngine();
@@ -153,8 +162,8 @@ protected:
     AffxString runReferencePart1(CNLog2RatioData& data);
     void runReferencePart2(CNLog2RatioData& data, const AffxString& strTempFileName);
 
-    bool writeOutputText(CNExperiment& objExperiment, CNProbeSetArray& vProbeSets);
-    bool writeOutputHdf5(CNExperiment& objExperiment, CNProbeSetArray& vProbeSets);
+    bool writeOutputText(BaseEngine& objOptions, CNExperiment& objExperiment, CNProbeSetArray& vProbeSets);
+    bool writeOutputHdf5(BaseEngine& objOptions, CNExperiment& objExperiment, CNProbeSetArray& vProbeSets);
 
     void checkChipType();
     bool isCyto2SnpReference(const AffxString& strReferenceFileName);
@@ -434,23 +434,24 @@ void CNFamilialAnalysisMethodLOD::countMIE(
     const bool trioCase = !vMotherGenotypeCalls.empty() && !vFatherGenotypeCalls.empty();
     const bool duoMat   = !vMotherGenotypeCalls.empty();
     const bool duoPat   = !vFatherGenotypeCalls.empty();
+    CNCychp& cychpIndex = getCychpIndex();
 
     if (trioCase)
     {
         for (int iIndex = 0; iIndex < vIndexGenotypeCalls.size(); iIndex++)
         {
-            CNCychp::m_mMarkerCount[vChromosomes[iIndex]]++;
+            cychpIndex.m_mMarkerCount[vChromosomes[iIndex]]++;
             if (isMIE(vIndexGenotypeCalls[iIndex], vMotherGenotypeCalls[iIndex], vFatherGenotypeCalls[iIndex]))
             {
-                CNCychp::m_mMIE_Trio[vChromosomes[iIndex]]++;
+                cychpIndex.m_mMIE_Trio[vChromosomes[iIndex]]++;
             }
             if (isMIE(vIndexGenotypeCalls[iIndex], vMotherGenotypeCalls[iIndex]))
             {
-                CNCychp::m_mMIE_Mat[vChromosomes[iIndex]]++;
+                cychpIndex.m_mMIE_Mat[vChromosomes[iIndex]]++;
             }
             if (isMIE(vIndexGenotypeCalls[iIndex], vFatherGenotypeCalls[iIndex]))
             {
-                CNCychp::m_mMIE_Pat[vChromosomes[iIndex]]++;
+                cychpIndex.m_mMIE_Pat[vChromosomes[iIndex]]++;
             }
         }
     }
@@ -458,10 +459,10 @@ void CNFamilialAnalysisMethodLOD::countMIE(
     {
         for (int iIndex = 0; iIndex < vIndexGenotypeCalls.size(); iIndex++)
         {
-            CNCychp::m_mMarkerCount[vChromosomes[iIndex]]++;
+            cychpIndex.m_mMarkerCount[vChromosomes[iIndex]]++;
             if (isMIE(vIndexGenotypeCalls[iIndex], vMotherGenotypeCalls[iIndex]))
             {
-                CNCychp::m_mMIE_Mat[vChromosomes[iIndex]]++;
+                cychpIndex.m_mMIE_Mat[vChromosomes[iIndex]]++;
             }
         }
     }
@@ -469,10 +470,10 @@ void CNFamilialAnalysisMethodLOD::countMIE(
     {
         for (int iIndex = 0; iIndex < vIndexGenotypeCalls.size(); iIndex++)
         {
-            CNCychp::m_mMarkerCount[vChromosomes[iIndex]]++;
+            cychpIndex.m_mMarkerCount[vChromosomes[iIndex]]++;
             if (isMIE(vIndexGenotypeCalls[iIndex], vFatherGenotypeCalls[iIndex]))
             {
-                CNCychp::m_mMIE_Pat[vChromosomes[iIndex]]++;
+                cychpIndex.m_mMIE_Pat[vChromosomes[iIndex]]++;
             }
         }
     }
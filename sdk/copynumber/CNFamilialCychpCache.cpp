@@ -0,0 +1,148 @@
+////////////////////////////////////////////////////////////////
+//
+// Copyright (C) 2011 Affymetrix, Inc.
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License (version 2) as
+// published by the Free Software Foundation.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program;if not, write to the
+//
+// Free Software Foundation, Inc.,
+// 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+//
+////////////////////////////////////////////////////////////////
+
+/**
+ * @file CNFamilialCychpCache.cpp
+ *
+ * @brief This file contains the CNFamilialCychpCache class members.
+ */
+
+#include "copynumber/CNFamilialCychpCache.h"
+//
+#include "util/Err.h"
+//
+
+/**
+ * @brief Constructor
+ */
+CNFamilialCychpCache::CNFamilialCychpCache()
+{
+    m_iReadCount = 0;
+}
+
+/**
+ * @brief Destructor
+ */
+CNFamilialCychpCache::~CNFamilialCychpCache()
+{
+    clear();
+}
+
+/**
+ * @brief Free the cached data and forget the use counts.
+ */
+void CNFamilialCychpCache::clear()
+{
+    MutexLock lock(m_lock);
+    for (std::map<std::string, Entry>::iterator iter = m_mEntries.begin(); (iter != m_mEntries.end()); ++iter)
+    {
+        delete iter->second.pCychp;
+    }
+    m_mEntries.clear();
+    m_iReadCount = 0;
+}
+
+void CNFamilialCychpCache::addUse(const std::string& strFileName)
+{
+    MutexLock lock(m_lock);
+    std::map<std::string, Entry>::iterator iter = m_mEntries.find(strFileName);
+    if (iter == m_mEntries.end())
+    {
+        Entry entry;
+        entry.pCychp = NULL;
+        entry.iUseCount = 1;
+        entry.bReading = false;
+        m_mEntries[strFileName] = entry;
+    }
+    else {iter->second.iUseCount++;}
+}
+
+void CNFamilialCychpCache::copy(const std::string& strFileName, const AffxString& strFamilialType, CNCychp& cychp)
+{
+    CNCychp* pCychp = NULL;
+    {
+        MutexLock lock(m_lock);
+        std::map<std::string, Entry>::iterator iter = m_mEntries.find(strFileName);
+        if ((iter == m_mEntries.end()) || (iter->second.iUseCount <= 0))
+        {
+            Err::errAbort("CNFamilialCychpCache::copy(...) No use counted for cychp file: " + strFileName);
+        }
+        Entry& entry = iter->second;
+        while (entry.bReading) {m_readDone.wait(m_lock);}
+        if (entry.pCychp == NULL)
+        {
+            entry.bReading = true;
+            m_iReadCount++;
+        }
+        else {pCychp = entry.pCychp;}
+    }
+    if (pCychp == NULL)
+    {
+        // This thread reads the file; others which need it wait for it.
+        CNCychp* pRead = new CNCychp;
+        bool bRead = false;
+        try
+        {
+            bRead = pRead->readFile(strFileName, m_groupDatasets, "", "cychp file");
+        }
+        catch (...)
+        {
+            bRead = false;
+        }
+        {
+            MutexLock lock(m_lock);
+            Entry& entry = m_mEntries[strFileName];
+            entry.bReading = false;
+            if (bRead) {entry.pCychp = pRead;}
+            m_readDone.broadcast();
+        }
+        if (!bRead)
+        {
+            delete pRead;
+            Err::errAbort("Cannot read cychp file: " + strFileName);
+        }
+        pCychp = pRead;
+    }
+    // The cached data is not changed and is not freed until this family has
+    // counted its copy below, so it can be copied outside the lock.
+    cychp.copy(*pCychp);
+    cychp.setFamilialType(strFamilialType);
+    MutexLock lock(m_lock);
+    std::map<std::string, Entry>::iterator iter = m_mEntries.find(strFileName);
+    Entry& entry = iter->second;
+    entry.iUseCount--;
+    if (entry.iUseCount == 0)
+    {
+        delete entry.pCychp;
+        m_mEntries.erase(iter);
+    }
+}
+
+int CNFamilialCychpCache::getCachedCount()
+{
+    MutexLock lock(m_lock);
+    int iCount = 0;
+    for (std::map<std::string, Entry>::iterator iter = m_mEntries.begin(); (iter != m_mEntries.end()); ++iter)
+    {
+        if (iter->second.pCychp != NULL) {iCount++;}
+    }
+    return iCount;
+}
@@ -0,0 +1,101 @@
+////////////////////////////////////////////////////////////////
+//
+// Copyright (C) 2011 Affymetrix, Inc.
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License (version 2) as
+// published by the Free Software Foundation.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program;if not, write to the
+//
+// Free Software Foundation, Inc.,
+// 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+//
+////////////////////////////////////////////////////////////////
+
+#ifndef _CNFamilialCychpCache_H_
+#define _CNFamilialCychpCache_H_
+/**
+ * @file CNFamilialCychpCache.h
+ *
+ * @brief This header contains the CNFamilialCychpCache class definition.
+ */
+
+#include "copynumber/CNCychp.h"
+//
+#include "util/Thread.h"
+//
+#include <map>
+#include <string>
+//
+
+/**
+ * @brief The cychp files of a cohort of families, each read once.
+ *
+ * A parent who belongs to several families, or an index who is also a
+ * parent, is read the first time a family needs the file and kept until
+ * the last family which uses it has taken its copy. The analysis methods
+ * write into the cychp data they are given, so each family works on a
+ * copy and the cached data is never changed. The cache may be used from
+ * several threads at once. A file is read and copied outside the lock, so
+ * one family waits only for the file it needs.
+ */
+class CNFamilialCychpCache
+{
+private:
+    struct Entry
+    {
+        CNCychp* pCychp;
+        /// The families which have still to take their copy.
+        int iUseCount;
+        /// A thread is reading the file; the others wait on m_readDone.
+        bool bReading;
+    };
+
+    std::map<std::string, Entry> m_mEntries;
+    /// The calvin groups and data sets to read.
+    groupDatasets_t m_groupDatasets;
+    int m_iReadCount;
+    Mutex m_lock;
+    Condition m_readDone;
+
+    // not copyable.
+    CNFamilialCychpCache(const CNFamilialCychpCache&);
+    CNFamilialCychpCache& operator=(const CNFamilialCychpCache&);
+
+public:
+    CNFamilialCychpCache();
+    ~CNFamilialCychpCache();
+
+    void clear();
+
+    void setGroupDatasets(const groupDatasets_t& groupDatasets) {m_groupDatasets = groupDatasets;}
+
+    /**
+     * @brief Count one more family which will use the file. Call before any copy is taken.
+     * @param const std::string& - The cychp file name.
+     */
+    void addUse(const std::string& strFileName);
+
+    /**
+     * @brief Copy the data from a cychp file, reading it if this is the first use.
+     * The cached data is freed once every family counted by addUse() has its copy.
+     * @param const std::string& - The cychp file name.
+     * @param const AffxString& - The familial type of the copy (index, mother or father).
+     * @param CNCychp& - The copy.
+     */
+    void copy(const std::string& strFileName, const AffxString& strFamilialType, CNCychp& cychp);
+
+    /// The number of files read so far.
+    int getReadCount() {return m_iReadCount;}
+    /// The number of files held in memory.
+    int getCachedCount();
+};
+
+#endif
@@ -45,10 +45,12 @@
 #include "util/Fs.h"
 #include "util/Guid.h"
 #include "util/PgOptions.h"
+#include "util/Thread.h"
 #include "util/Verbose.h"
 //
 #include "../external/newmat/myexcept.h"
 //
+#include <algorithm>
 #include <cstdio>
 #include <cstring>
 #include <ctime>
@@ -63,6 +65,33 @@
 
 CNFamilialEngine::Reg CNFamilialEngine::reg;
 
+/**
+ * @brief One family of a family-file, with the data and methods used to analyse it.
+ */
+class CNFamilialFamily
+{
+public:
+    AffxString m_strIndexFileName;
+    AffxString m_strMotherFileName;
+    AffxString m_strFatherFileName;
+    AffxString m_strFamilialFileName;
+
+    // The family's own copies of the cached cychp data, which the methods write into.
+    CNCychp m_cychpIndex;
+    CNCychp m_cychpMother;
+    CNCychp m_cychpFather;
+
+    AffxArray<CNFamilialAnalysisMethod> m_vMethods;
+    CNFamilialReporter* m_pReporter;
+
+    CNFamilialFamily() {m_pReporter = NULL;}
+    ~CNFamilialFamily()
+    {
+        m_vMethods.deleteAll();
+        if (m_pReporter != NULL) {delete m_pReporter;}
+    }
+};
+
 CNFamilialEngine * CNFamilialEngine::FromBase(BaseEngine *engine)
 {
     if (engine != NULL && engine->getEngineName() == CNFamilialEngine::EngineName())
@@ -96,6 +125,7 @@ void CNFamilialEngine::clear()
     m_cychpIndex.clear();
     m_cychpMother.clear();
     m_cychpFather.clear();
+    m_objCychpCache.clear();
     m_vCNFamilialAnalysisMethods.deleteAll();
     m_vCNFamilialReporters.deleteAll();
 }
@@ -150,6 +180,13 @@ void CNFamilialEngine::defineOptions() {
   defineOption("", "allele-frequency-file", PgOpt::STRING_OPT,
                      "Text file specifying allele frequencies.",
                      "");
+  defineOption("", "family-file", PgOpt::STRING_OPT,
+                     "Tab delimited file specifying a cohort of families to process in place of "
+                     "the index, mother and father cychp files, one family per line. Columns are "
+                     "'index_cychp_file', 'mother_cychp_file', 'father_cychp_file' and 'familial_file'; "
+                     "leave the mother or father blank for a duo. Each cychp file is read once however "
+                     "many families it is in, so list families who share a parent near each other.",
+                     "");
 
   defineOptionSection("Output Options");
   defineOption("","familial-file", PgOpt::STRING_OPT,
@@ -166,6 +203,10 @@ void CNFamilialEngine::defineOptions() {
                    "");
 
   defineOptionSection("Advanced Options"); 
+  defineOption("", "threads", PgOpt::INT_OPT,
+                     "Number of families from the family-file to analyse at the same time, each on its own thread. "
+                     "0 means one thread per cpu. Each thread keeps its own copy of its family's cychp data. "
+                     "Output is the same for any number of threads.", "1");
   defineOption("", "xChromosome", PgOpt::INT_OPT, "X Chromosome.", "24");
   defineOption("", "yChromosome", PgOpt::INT_OPT, "Y Chromosome.", "25");
 
@@ -192,19 +233,29 @@ void CNFamilialEngine::checkOptionsImp() {
   std::string outDir = getOpt("out-dir");
   std::vector<std::string> analysis = getOptVector("analysis");
 
-  if (!Fs::fileExists(getOpt("index-cychp-file"))) {
-    error("Must provide a valid index-cychp-file.");
+  if (getOpt("family-file") != "") {
+    if (!Fs::fileExists(getOpt("family-file"))) {
+      error("Must provide a valid family-file.");
+    }
+    if ((getOpt("index-cychp-file") != "") || (getOpt("mother-cychp-file") != "") || (getOpt("father-cychp-file") != "") || (getOpt("familial-file") != "")) {
+      error("The family-file cannot be used with the index-cychp-file, mother-cychp-file, father-cychp-file or familial-file options.");
+    }
   }
+  else {
+    if (!Fs::fileExists(getOpt("index-cychp-file"))) {
+      error("Must provide a valid index-cychp-file.");
+    }
 
-  if ((!Fs::fileExists(getOpt("father-cychp-file"))) && (!Fs::fileExists(getOpt("mother-cychp-file")))) {
-    error("Must provide a valid father-cychp-file and/or a valid mother-cychp-file.");
+    if ((!Fs::fileExists(getOpt("father-cychp-file"))) && (!Fs::fileExists(getOpt("mother-cychp-file")))) {
+      error("Must provide a valid father-cychp-file and/or a valid mother-cychp-file.");
+    }
   }
 
   if (!Fs::fileExists(getOpt("allele-frequency-file"))) {
     error("Must provide a valid allele-frequency-file.");
   }
 
-  if (getOpt("familial-file") == "")
+  if ((getOpt("familial-file") == "") && (getOpt("family-file") == ""))
   {
     error("Must provide a familial-file.");
   }
@@ -255,17 +306,24 @@ void CNFamilialEngine::runImp() {
     try { // inner try for memory clean up.
         createAnalysis();
         prepareGroupsDatasets();
-        loadCychpFiles();
-        for (int iIndex = 0; (iIndex < (int)m_vCNFamilialAnalysisMethods.size()); iIndex++)
+        if (getOpt("family-file") != "")
         {
-            m_vCNFamilialAnalysisMethods[iIndex]->run();
-            Verbose::out(1, "*");
+            familialCohortAnalysis();
         }
-        for (int iIndex = 0; (iIndex < (int)m_vCNFamilialReporters.size()); iIndex++)
+        else
         {
-            m_vCNFamilialReporters[iIndex]->setup(*this, m_cychpIndex, m_cychpMother, m_cychpFather, m_vCNFamilialAnalysisMethods);
-            m_vCNFamilialReporters[iIndex]->run();
-            Verbose::out(1, "*");
+            loadCychpFiles();
+            for (int iIndex = 0; (iIndex < (int)m_vCNFamilialAnalysisMethods.size()); iIndex++)
+            {
+                m_vCNFamilialAnalysisMethods[iIndex]->run();
+                Verbose::out(1, "*");
+            }
+            for (int iIndex = 0; (iIndex < (int)m_vCNFamilialReporters.size()); iIndex++)
+            {
+                m_vCNFamilialReporters[iIndex]->setup(*this, m_cychpIndex, m_cychpMother, m_cychpFather, m_vCNFamilialAnalysisMethods);
+                m_vCNFamilialReporters[iIndex]->run();
+                Verbose::out(1, "*");
+            }
         }
     } // inner try end
     catch (...) {
@@ -418,49 +476,239 @@ void CNFamilialEngine::checkFamilialConsistencyPair(CNCychp& cychp1, CNCychp& cy
 {
     if (cychp1.getCychpHeader().getCNReferenceFileName() != cychp2.getCychpHeader().getCNReferenceFileName())
     {
-        error("CN reference files mismatch in CYCHP files. "
+        Err::errAbort("CN reference files mismatch in CYCHP files. "
               "File '" + ToStr(cychp1.getFileName()) + "' lists CN reference '" + ToStr(cychp1.getCychpHeader().getCNReferenceFileName()) + "', "
               "File '" + ToStr(cychp2.getFileName()) + "' lists CN reference '" + ToStr(cychp2.getCychpHeader().getCNReferenceFileName()) + "'");
     }
     if (cychp1.getCychpHeader().getAnnotationFileName() != cychp2.getCychpHeader().getAnnotationFileName())
     {
-        error("Annotation files mismatch in CYCHP files. "
+        Err::errAbort("Annotation files mismatch in CYCHP files. "
               "File '" + ToStr(cychp1.getFileName()) + "' lists annotation file '" + ToStr(cychp1.getCychpHeader().getAnnotationFileName()) + "', "
               "File '" + ToStr(cychp2.getFileName()) + "' lists annotation file '" + ToStr(cychp2.getCychpHeader().getAnnotationFileName()) + "'");
     }
     if (cychp1.getCychpHeader().getArrayType() != cychp2.getCychpHeader().getArrayType())
     {
-        error("Array type mismatch in CYCHP files. "
+        Err::errAbort("Array type mismatch in CYCHP files. "
               "File '" + ToStr(cychp1.getFileName()) + "' lists array type '" + ToStr(cychp1.getCychpHeader().getArrayType()) + "', "
               "File '" + ToStr(cychp2.getFileName()) + "' lists array type '" + ToStr(cychp2.getCychpHeader().getArrayType()) + "'");
     }
     if (cychp1.getCychpHeader().getDbsnpDate() != cychp2.getCychpHeader().getDbsnpDate())
     {
-        error("dbsnp date mismatch in CYCHP files. "
+        Err::errAbort("dbsnp date mismatch in CYCHP files. "
               "File '" + ToStr(cychp1.getFileName()) + "' lists dbsnp date '" + ToStr(cychp1.getCychpHeader().getDbsnpDate()) + "', "
               "File '" + ToStr(cychp2.getFileName()) + "' lists dbsnp date '" + ToStr(cychp2.getCychpHeader().getDbsnpDate()) + "'");
     }
     if (cychp1.getCychpHeader().getDbsnpVersion() != cychp2.getCychpHeader().getDbsnpVersion())
     {
-        error("dbsnp version mismatch in CYCHP files. "
+        Err::errAbort("dbsnp version mismatch in CYCHP files. "
               "File '" + ToStr(cychp1.getFileName()) + "' lists dbsnp date '" + ToStr(cychp1.getCychpHeader().getDbsnpVersion()) + "', "
               "File '" + ToStr(cychp2.getFileName()) + "' lists dbsnp date '" + ToStr(cychp2.getCychpHeader().getDbsnpVersion()) + "'");
     }
     if (cychp1.getCychpHeader().getNetaffxAnnotDate() != cychp2.getCychpHeader().getNetaffxAnnotDate())
     {
-        error("Netaffx annotation date mismatch in CYCHP files. "
+        Err::errAbort("Netaffx annotation date mismatch in CYCHP files. "
               "File '" + ToStr(cychp1.getFileName()) + "' lists dbsnp date '" + ToStr(cychp1.getCychpHeader().getNetaffxAnnotDate()) + "', "
               "File '" + ToStr(cychp2.getFileName()) + "' lists dbsnp date '" + ToStr(cychp2.getCychpHeader().getNetaffxAnnotDate()) + "'");
     }
     if (cychp1.getCychpHeader().getNetaffxBuild() != cychp2.getCychpHeader().getNetaffxBuild())
     {
-        error("Netaffx build number mismatch in CYCHP files. "
+        Err::errAbort("Netaffx build number mismatch in CYCHP files. "
               "File '" + ToStr(cychp1.getFileName()) + "' lists dbsnp date '" + ToStr(cychp1.getCychpHeader().getNetaffxBuild()) + "', "
               "File '" + ToStr(cychp2.getFileName()) + "' lists dbsnp date '" + ToStr(cychp2.getCychpHeader().getNetaffxBuild()) + "'");
     }
 }
 
 
+/**
+ * @brief Read the families from the family-file.
+ * @param std::vector<CNFamilialFamily*>& - The families, in the order listed.
+ */
+void CNFamilialEngine::readFamilyFile(std::vector<CNFamilialFamily*>& vFamilies)
+{
+    std::string strFamilyFileName = getOpt("family-file");
+    std::string strIndexFileName;
+    std::string strMotherFileName;
+    std::string strFatherFileName;
+    std::string strFamilialFileName;
+    affx::TsvFile tsv;
+#ifdef WIN32
+    tsv.m_optEscapeOk = false;
+#endif
+    tsv.bind(0, "index_cychp_file", &strIndexFileName, affx::TSV_BIND_REQUIRED);
+    tsv.bind(0, "mother_cychp_file", &strMotherFileName, affx::TSV_BIND_OPTIONAL);
+    tsv.bind(0, "father_cychp_file", &strFatherFileName, affx::TSV_BIND_OPTIONAL);
+    tsv.bind(0, "familial_file", &strFamilialFileName, affx::TSV_BIND_REQUIRED);
+    if (tsv.open(strFamilyFileName) != affx::TSV_OK) {Err::errAbort("Couldn't open family-file: " + strFamilyFileName);}
+    std::set<std::string> setFamilialFileNames;
+    std::string strOutDirName = getOpt("out-dir");
+    while (tsv.nextLevel(0) == affx::TSV_OK)
+    {
+        if (!Fs::fileExists(strIndexFileName)) {Err::errAbort("Cannot find the index cychp file: " + strIndexFileName);}
+        if ((strMotherFileName != "") && (!Fs::fileExists(strMotherFileName))) {Err::errAbort("Cannot find the mother cychp file: " + strMotherFileName);}
+        if ((strFatherFileName != "") && (!Fs::fileExists(strFatherFileName))) {Err::errAbort("Cannot find the father cychp file: " + strFatherFileName);}
+        if ((strMotherFileName == "") && (strFatherFileName == "")) {Err::errAbort("The family of " + strIndexFileName + " must have a mother and/or a father cychp file.");}
+        // Two families writing the same file would leave whichever finished last.
+        if (!setFamilialFileNames.insert(strFamilialFileName).second) {Err::errAbort("The familial file is listed for more than one family: " + strFamilialFileName);}
+
+        CNFamilialFamily* pFamily = new CNFamilialFamily;
+        vFamilies.push_back(pFamily);
+        pFamily->m_strIndexFileName = strIndexFileName;
+        pFamily->m_strMotherFileName = strMotherFileName;
+        pFamily->m_strFatherFileName = strFatherFileName;
+        pFamily->m_strFamilialFileName = strFamilialFileName;
+        std::string strDirName = Fs::dirname(Fs::join(strOutDirName, strFamilialFileName));
+        if (!Fs::dirExists(strDirName)) {Fs::mkdirPath(strDirName, false);}
+    }
+    tsv.close();
+    if (vFamilies.size() == 0) {Err::errAbort("No families found in the family-file: " + strFamilyFileName);}
+    Verbose::out(1, "Read " + ToStr(vFamilies.size()) + " families from: " + Fs::basename(strFamilyFileName));
+}
+
+/**
+ * @brief Create the methods and reporter for a family, as createAnalysis() does for the engine.
+ * @param CNFamilialFamily& - The family.
+ */
+void CNFamilialEngine::createFamilyAnalysis(CNFamilialFamily& family)
+{
+    std::vector<std::string>& analysis = getOptVector("analysis");
+    CNFamilialAnalysisMethodFactory factory;
+    for (unsigned int i = 0; i < analysis.size(); i++)
+    {
+        CNFamilialAnalysisMethod* pMethod = factory.CNFamilialAnalysisMethodForString(analysis[i]);
+        pMethod->setup(family.m_cychpIndex, family.m_cychpMother, family.m_cychpFather, getOpt("allele-frequency-file"));
+        family.m_vMethods.push_back(pMethod);
+    }
+    family.m_pReporter = factory.CNFamilialReporterForString("familial-output");
+    family.m_pReporter->setFamilialFileName(family.m_strFamilialFileName);
+}
+
+/**
+ * @brief Make sure the family's cychp data fit together, as loadCychpFiles() does for the engine.
+ * @param CNFamilialFamily& - The family, with its cychp data copied in.
+ */
+void CNFamilialEngine::checkFamily(CNFamilialFamily& family)
+{
+    int iMarkerCount = family.m_cychpIndex.getCychpProbeSetsCopyNumbers().getCount();
+    if (iMarkerCount == 0) {Err::errAbort("No entries found in the index cychp file for the ProbeSets\\CopyNumber data set: " + family.m_strIndexFileName);}
+    if (family.m_strMotherFileName != "")
+    {
+        if (family.m_cychpMother.getCychpHeader().getGender() != affx::Female) {
+            Err::errAbort("The mother cychp file does not contain female gender data: " + family.m_strMotherFileName);
+        }
+        if (family.m_cychpMother.getCychpProbeSetsCopyNumbers().getCount() != iMarkerCount) {
+            Err::errAbort("The number of entries in the ProbeSets\\CopyNumber data set of the mother cychp file " + family.m_strMotherFileName + " does not equal the number in the index cychp file " + family.m_strIndexFileName);
+        }
+        checkFamilialConsistencyPair(family.m_cychpIndex, family.m_cychpMother);
+    }
+    if (family.m_strFatherFileName != "")
+    {
+        if (family.m_cychpFather.getCychpHeader().getGender() != affx::Male) {
+            Err::errAbort("The father cychp file does not contain male gender data: " + family.m_strFatherFileName);
+        }
+        if (family.m_cychpFather.getCychpProbeSetsCopyNumbers().getCount() != iMarkerCount) {
+            Err::errAbort("The number of entries in the ProbeSets\\CopyNumber data set of the father cychp file " + family.m_strFatherFileName + " does not equal the number in the index cychp file " + family.m_strIndexFileName);
+        }
+        checkFamilialConsistencyPair(family.m_cychpIndex, family.m_cychpFather);
+    }
+}
+
+void CNFamilialEngine::analyseFamily(CNFamilialFamily& family)
+{
+    Verbose::out(1, "Analysing family: " + family.m_strFamilialFileName);
+    m_objCychpCache.copy(family.m_strIndexFileName, "index", family.m_cychpIndex);
+    if (family.m_strMotherFileName != "") {m_objCychpCache.copy(family.m_strMotherFileName, "mother", family.m_cychpMother);}
+    if (family.m_strFatherFileName != "") {m_objCychpCache.copy(family.m_strFatherFileName, "father", family.m_cychpFather);}
+    checkFamily(family);
+    // The methods of a family run in turn: they share, and write into, the family's cychp data.
+    for (int iIndex = 0; (iIndex < (int)family.m_vMethods.size()); iIndex++)
+    {
+        family.m_vMethods[iIndex]->run();
+    }
+    family.m_pReporter->setup(*this, family.m_cychpIndex, family.m_cychpMother, family.m_cychpFather, family.m_vMethods);
+    family.m_pReporter->run();
+    // Free the family's data as soon as its file is written.
+    family.m_vMethods.deleteAll();
+    family.m_cychpIndex.clear();
+    family.m_cychpMother.clear();
+    family.m_cychpFather.clear();
+}
+
+/**
+ * @brief Analyses the families of a family-file on several threads, one
+ * family at a time.
+ */
+class CNFamilialFamilyTask : public WorkQueueTask
+{
+public:
+    CNFamilialFamilyTask(CNFamilialEngine& objEngine, std::vector<CNFamilialFamily*>& vFamilies) :
+        WorkQueueTask((int)vFamilies.size()), m_objEngine(objEngine), m_vFamilies(vFamilies)
+    {
+    }
+
+    virtual void runItems(int threadIx, int iStart, int iCount)
+    {
+        for (int iFamilyIndex = iStart; (iFamilyIndex < (iStart + iCount)); iFamilyIndex++)
+        {
+            m_objEngine.analyseFamily(*m_vFamilies[iFamilyIndex]);
+        }
+    }
+
+private:
+    CNFamilialEngine& m_objEngine;
+    std::vector<CNFamilialFamily*>& m_vFamilies;
+};
+
+/**
+ * @brief Analyse each family of the family-file, reading each cychp file once.
+ * Families are independent, so they are analysed on as many threads as asked for.
+ * Each family writes only its own familial-file, so the output is the same for
+ * any number of threads.
+ */
+void CNFamilialEngine::familialCohortAnalysis()
+{
+    std::vector<CNFamilialFamily*> vFamilies;
+    try
+    {
+        readFamilyFile(vFamilies);
+        // The methods and reporters are made here; doing it on the threads is not safe.
+        // Each family adds the same parameters again, so only the first family's are kept.
+        size_t uiMethodParamCount = 0;
+        size_t uiReporterParamCount = 0;
+        for (int iFamilyIndex = 0; (iFamilyIndex < (int)vFamilies.size()); iFamilyIndex++)
+        {
+            CNFamilialFamily& family = *vFamilies[iFamilyIndex];
+            createFamilyAnalysis(family);
+            if (iFamilyIndex == 0)
+            {
+                uiMethodParamCount = CNFamilialAnalysisMethod::getParams().size();
+                uiReporterParamCount = CNFamilialReporter::getParams().size();
+            }
+            else
+            {
+                CNFamilialAnalysisMethod::getParams().erase(CNFamilialAnalysisMethod::getParams().begin() + uiMethodParamCount, CNFamilialAnalysisMethod::getParams().end());
+                CNFamilialReporter::getParams().erase(CNFamilialReporter::getParams().begin() + uiReporterParamCount, CNFamilialReporter::getParams().end());
+            }
+            m_objCychpCache.addUse(family.m_strIndexFileName);
+            if (family.m_strMotherFileName != "") {m_objCychpCache.addUse(family.m_strMotherFileName);}
+            if (family.m_strFatherFileName != "") {m_objCychpCache.addUse(family.m_strFatherFileName);}
+        }
+        m_objCychpCache.setGroupDatasets(m_groupDatasetsAllFamilial);
+
+        CNFamilialFamilyTask task(*this, vFamilies);
+        int iThreadCount = std::max(1, std::min(ThreadGroup::resolveThreadCount(getOptInt("threads")), task.getBatchCount()));
+        Verbose::out(1, "Using " + ToStr(iThreadCount) + " threads.");
+        task.run(iThreadCount);
+        Verbose::out(1, "Read " + ToStr(m_objCychpCache.getReadCount()) + " cychp files for " + ToStr(vFamilies.size()) + " families.");
+    }
+    catch (...)
+    {
+        for (int iIndex = 0; (iIndex < (int)vFamilies.size()); iIndex++) {delete vFamilies[iIndex];}
+        throw;
+    }
+    for (int iIndex = 0; (iIndex < (int)vFamilies.size()); iIndex++) {delete vFamilies[iIndex];}
+    m_objCychpCache.clear();
+}
+
 void CNFamilialEngine::explain() {
     CNFamilialAnalysisMethodFactory factory;
     std::vector<SelfDoc>docs = factory.getDocs();
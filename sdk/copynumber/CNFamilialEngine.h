@@ -29,6 +29,7 @@
 
 #include "copynumber/CNCychp.h"
 #include "copynumber/CNFamilialAnalysisMethod.h"
+#include "copynumber/CNFamilialCychpCache.h"
 #include "copynumber/CNFamilialReporter.h"
 //
 #include "util/BaseEngine.h"
@@ -39,11 +40,13 @@
 #include <string>
 #include <set>
 #include <map>
+#include <vector>
 //
 
 typedef std::map<std::string, std::set<std::string> > groupDatasets_t;
 
 class SegmentOverlap;
+class CNFamilialFamily;
 class CNFamilialEngine : public BaseEngine {
 
     public:
@@ -90,6 +93,13 @@ class CNFamilialEngine : public BaseEngine {
 
         void clear();
 
+        /**
+         * @brief Analyse one family of a family-file and write its familial-file.
+         * May be called from several threads at once, each with its own family.
+         * @param CNFamilialFamily& - The family.
+         */
+        void analyseFamily(CNFamilialFamily& family);
+
     private:
         void printStandardMethods(std::ostream &out);
         void extraHelp();
@@ -128,6 +138,11 @@ class CNFamilialEngine : public BaseEngine {
         void checkFamilialConsistency();
         void checkFamilialConsistencyPair(CNCychp& cychp1, CNCychp& cychp2);
 
+        void readFamilyFile(std::vector<CNFamilialFamily*>& vFamilies);
+        void createFamilyAnalysis(CNFamilialFamily& family);
+        void checkFamily(CNFamilialFamily& family);
+        void familialCohortAnalysis();
+
     private:
         AffxArray<CNFamilialAnalysisMethod> m_vCNFamilialAnalysisMethods;
         AffxArray<CNFamilialReporter> m_vCNFamilialReporters;
@@ -140,6 +155,9 @@ class CNFamilialEngine : public BaseEngine {
         CNCychp m_cychpIndex;
         CNCychp m_cychpMother;
         CNCychp m_cychpFather;
+
+        // The cychp files of the families in the family-file, each read once.
+        CNFamilialCychpCache m_objCychpCache;
 };
 
 #endif /* _CNFamilialEngine_H_ */
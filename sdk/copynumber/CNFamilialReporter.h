@@ -68,6 +68,7 @@ protected:
   CNCychp* m_pcychpMother;
   CNCychp* m_pcychpFather;
   AffxArray<CNFamilialAnalysisMethod>* m_pvMethods;
+  AffxString m_strFamilialFileName;
 
 public:
   CNFamilialReporter();
@@ -89,6 +90,12 @@ public:
   CNCychp& getCychpMother();
   CNCychp& getCychpFather();
 
+  /**
+   * @brief Set the familial-file to write, in place of the engine's familial-file option
+   * @param const AffxString& - The file name, relative to the out-dir
+   */
+  void setFamilialFileName(const AffxString& strFileName) {m_strFamilialFileName = strFileName;}
+
   virtual void run() = 0;
 
 protected:
@@ -102,6 +102,7 @@ void CNFamilialReporterFamilial::run()
 {
     if (m_pEngine == NULL) {return;}
     AffxString famFileName = m_pEngine->getOpt("familial-file");
+    if (m_strFamilialFileName != "") {famFileName = m_strFamilialFileName;}
     AffxString strOutDirName = m_pEngine->getOpt("out-dir");
     AffxString strFileName = Fs::join(strOutDirName,famFileName);
     Verbose::out(1, "Writing familial-file: " + strFileName);
@@ -652,6 +653,7 @@ void CNFamilialReporterFamilial::writeDataSetMIE(affymetrix_calvin_io::GenericFi
     const int iYChromosome = m_pEngine->getOptInt("yChromosome");
     const int lastAutosome = 22;
 
+    CNCychp& cychpIndex = getCychpIndex();
     CNCychp& cychpMother = getCychpMother();
     CNCychp& cychpFather = getCychpFather();
     const bool motherPresent = cychpMother.getFileName() != "";
@@ -662,10 +664,10 @@ void CNFamilialReporterFamilial::writeDataSetMIE(affymetrix_calvin_io::GenericFi
 
     std::vector<unsigned char> vChromosomes;
 
-    // copy all keys of CNCychp::m_mMarkerCount to vChromosomes
+    // copy all keys of the index's m_mMarkerCount to vChromosomes
     std::transform(
-                CNCychp::m_mMarkerCount.begin(),
-                CNCychp::m_mMarkerCount.end(), 
+                cychpIndex.m_mMarkerCount.begin(),
+                cychpIndex.m_mMarkerCount.end(), 
                 std::back_inserter(vChromosomes),
                 affxstl::select1st<std::map<unsigned char, unsigned int>::value_type>()
                 );
@@ -688,24 +690,24 @@ void CNFamilialReporterFamilial::writeDataSetMIE(affymetrix_calvin_io::GenericFi
             // data available
             setWriter.Write(chr);                               // chromosome number
             setWriter.Write(displayStr, 4);                     // chromosome number as string
-            setWriter.Write(CNCychp::m_mMarkerCount[chr]);      // number of genotypeable markers
+            setWriter.Write(cychpIndex.m_mMarkerCount[chr]);     // number of genotypeable markers
             if (motherPresent && fatherPresent)
             {
-                setWriter.Write(CNCychp::m_mMIE_Trio[chr]);         // MIE-Trio
-                setWriter.Write(CNCychp::m_mMIE_Mat[chr]);          // MIE-Mat
-                setWriter.Write(CNCychp::m_mMIE_Pat[chr]);          // MIE-Pat
+                setWriter.Write(cychpIndex.m_mMIE_Trio[chr]);        // MIE-Trio
+                setWriter.Write(cychpIndex.m_mMIE_Mat[chr]);         // MIE-Mat
+                setWriter.Write(cychpIndex.m_mMIE_Pat[chr]);         // MIE-Pat
             }
             else if (motherPresent)
             {
                 setWriter.Write(-1);                                // MIE-Trio
-                setWriter.Write(CNCychp::m_mMIE_Mat[chr]);          // MIE-Mat
+                setWriter.Write(cychpIndex.m_mMIE_Mat[chr]);         // MIE-Mat
                 setWriter.Write(-1);                                // MIE-Pat
             }
             else if (fatherPresent)
             {
                 setWriter.Write(-1);                                // MIE-Trio
                 setWriter.Write(-1);                                // MIE-Mat
-                setWriter.Write(CNCychp::m_mMIE_Pat[chr]);          // MIE-Pat
+                setWriter.Write(cychpIndex.m_mMIE_Pat[chr]);         // MIE-Pat
             }
         }
         else {
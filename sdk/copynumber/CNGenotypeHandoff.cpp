@@ -0,0 +1,297 @@
+////////////////////////////////////////////////////////////////
+//
+// Copyright (C) 2011 Affymetrix, Inc.
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License (version 2) as
+// published by the Free Software Foundation.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program;if not, write to the
+//
+// Free Software Foundation, Inc.,
+// 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+//
+////////////////////////////////////////////////////////////////
+
+/**
+ * @file CNGenotypeHandoff.cpp
+ *
+ * @brief This file contains the CNGenotypeHandoff class members.
+ */
+
+#include "copynumber/CNGenotypeHandoff.h"
+//
+#include "chipstream/IntensityMart.h"
+#include "chipstream/ProbeSet.h"
+#include "chipstream/QuantExprMethod.h"
+#include "chipstream/QuantGTypeMethod.h"
+#include "chipstream/TsvReport.h"
+#include "util/Err.h"
+#include "util/Fs.h"
+#include "util/Util.h"
+#include "util/Verbose.h"
+//
+#include <cstring>
+//
+
+/**
+ * @brief Takes the allele summaries from the expression quant method, as
+ * QuantMethodExprReport does for the summary file.
+ */
+class CNGenotypeHandoffSummaryReport : public QuantMethodReport
+{
+private:
+    CNGenotypeHandoff& m_rHandoff;
+    std::vector<double> m_vValues;
+
+public:
+    CNGenotypeHandoffSummaryReport(CNGenotypeHandoff& rHandoff) : m_rHandoff(rHandoff) {}
+
+    virtual bool prepare(QuantMethod& qMethod, const IntensityMart& iMart)
+    {
+        m_rHandoff.prepareSummaries(Fs::basename(iMart.getCelFileNames()));
+        return true;
+    }
+
+    virtual bool report(ProbeSetGroup& psGroup, QuantMethod& qMethod, const IntensityMart& iMart, std::vector<ChipStream*>& iTrans, PmAdjuster& pmAdjust)
+    {
+        QuantExprMethod* qeMethod = dynamic_cast<QuantExprMethod*>(&qMethod);
+        if (qeMethod == NULL) {Err::errAbort("CNGenotypeHandoff: Summaries must come from a QuantExprMethod.");}
+        // Only expression and copynumber probe sets are reported.
+        if ((psGroup.probeSets[0]->psType != ProbeSet::Expression) && (psGroup.probeSets[0]->psType != ProbeSet::Copynumber)) {return false;}
+        m_vValues.resize(qeMethod->getNumTargets());
+        for (unsigned int i = 0; (i < m_vValues.size()); i++)
+        {
+            m_vValues[i] = qeMethod->getSignalEstimate(i);
+        }
+        std::string strName = ((psGroup.displayName != NULL) && (strlen(psGroup.displayName) > 0)) ? psGroup.displayName : psGroup.name;
+        m_rHandoff.addSummary(strName, (m_vValues.size() == 0) ? NULL : &m_vValues[0]);
+        return true;
+    }
+
+    virtual bool finish(QuantMethod& qMethod)
+    {
+        m_rHandoff.getSummaries()->finish();
+        return true;
+    }
+};
+
+/**
+ * @brief Takes the genotype calls and confidences from the genotype quant
+ * method, as QuantMethodGTypeReport does for the calls and confidences files.
+ */
+class CNGenotypeHandoffGenotypeReport : public QuantMethodReport
+{
+private:
+    CNGenotypeHandoff& m_rHandoff;
+    std::vector<double> m_vCalls;
+    std::vector<double> m_vConfidences;
+
+public:
+    CNGenotypeHandoffGenotypeReport(CNGenotypeHandoff& rHandoff) : m_rHandoff(rHandoff) {}
+
+    virtual bool prepare(QuantMethod& qMethod, const IntensityMart& iMart)
+    {
+        m_rHandoff.prepareGenotypes(Fs::basename(iMart.getCelFileNames()));
+        return true;
+    }
+
+    virtual bool report(ProbeSetGroup& psGroup, QuantMethod& qMethod, const IntensityMart& iMart, std::vector<ChipStream*>& iTrans, PmAdjuster& pmAdjust)
+    {
+        QuantGTypeMethod* gMethod = dynamic_cast<QuantGTypeMethod*>(&qMethod);
+        if (gMethod == NULL) {Err::errAbort("CNGenotypeHandoff: Genotypes must come from a QuantGTypeMethod.");}
+        unsigned int uiCount = (unsigned int)gMethod->getNumCalls();
+        m_vCalls.resize(uiCount);
+        m_vConfidences.resize(uiCount);
+        for (unsigned int i = 0; (i < uiCount); i++)
+        {
+            m_vCalls[i] = gMethod->getCall(i);
+            m_vConfidences[i] = gMethod->getConfidence(i);
+        }
+        m_rHandoff.addGenotype(gMethod->getProbeSetName(), (uiCount == 0) ? NULL : &m_vCalls[0], (uiCount == 0) ? NULL : &m_vConfidences[0]);
+        return true;
+    }
+
+    virtual bool finish(QuantMethod& qMethod)
+    {
+        m_rHandoff.getCalls()->finish();
+        m_rHandoff.getConfidences()->finish();
+        return true;
+    }
+};
+
+CNGenotypeHandoff::Table::Table(affx::File5_dtype_t eDtype)
+{
+    m_eDtype = eDtype;
+    m_uiBytes = 0;
+    m_bPrepared = false;
+    m_bSpilled = false;
+    m_pFile5 = NULL;
+    m_pTsv5 = NULL;
+}
+
+CNGenotypeHandoff::Table::~Table()
+{
+    clear();
+}
+
+void CNGenotypeHandoff::Table::clear()
+{
+    finish();
+    m_strFileName.clear();
+    m_vColumnNames.clear();
+    std::vector<std::string>().swap(m_vRowNames);
+    std::vector<double>().swap(m_vValues);
+    m_uiBytes = 0;
+    m_bPrepared = false;
+    m_bSpilled = false;
+}
+
+void CNGenotypeHandoff::Table::prepare(const std::string& strFileName, const std::vector<std::string>& vColumnNames)
+{
+    clear();
+    m_strFileName = strFileName;
+    m_vColumnNames = vColumnNames;
+    m_bPrepared = true;
+}
+
+void CNGenotypeHandoff::Table::addRow(const std::string& strName, const double* pdValues)
+{
+    if (!m_bPrepared) {Err::errAbort("CNGenotypeHandoff: Row " + strName + " added before the table for " + m_strFileName + " was prepared.");}
+    if (m_bSpilled) {writeRow(strName, pdValues); return;}
+    m_vRowNames.push_back(strName);
+    m_vValues.insert(m_vValues.end(), pdValues, pdValues + m_vColumnNames.size());
+    m_uiBytes += sizeof(std::string) + strName.length() + (m_vColumnNames.size() * sizeof(double));
+}
+
+void CNGenotypeHandoff::Table::finish()
+{
+    if (m_pTsv5 != NULL)
+    {
+        m_pTsv5->close();
+        delete m_pTsv5;
+        m_pTsv5 = NULL;
+    }
+    if (m_pFile5 != NULL)
+    {
+        m_pFile5->close();
+        delete m_pFile5;
+        m_pFile5 = NULL;
+    }
+}
+
+void CNGenotypeHandoff::Table::spill()
+{
+    if ((!m_bPrepared) || (m_bSpilled)) {return;}
+    Verbose::out(1, "CNGenotypeHandoff: Memory budget exceeded, writing " + m_strFileName);
+    // The layout QuantMethodExprReport and QuantMethodGTypeReport write.
+    std::string strTsvName = Fs::basename(m_strFileName);
+    if ((strTsvName.length() > 3) && (strTsvName.substr(strTsvName.length() - 3) == ".a5")) {strTsvName = strTsvName.substr(0, strTsvName.length() - 3);}
+    int iNameLength = TSVREPORT_PROBESET_STRLEN;
+    for (unsigned int uiRowIndex = 0; (uiRowIndex < m_vRowNames.size()); uiRowIndex++)
+    {
+        iNameLength = Max(iNameLength, (int)m_vRowNames[uiRowIndex].length());
+    }
+    m_pFile5 = new affx::File5_File();
+    m_pFile5->open(m_strFileName, affx::FILE5_REPLACE);
+    m_pTsv5 = m_pFile5->openTsv(strTsvName, affx::FILE5_CREATE);
+    m_pTsv5->defineStringColumn(0, 0, "probeset_id", iNameLength);
+    for (unsigned int uiColIndex = 0; (uiColIndex < m_vColumnNames.size()); uiColIndex++)
+    {
+        m_pTsv5->defineColumn(0, (uiColIndex + 1), m_vColumnNames[uiColIndex], m_eDtype);
+    }
+    m_bSpilled = true;
+    for (unsigned int uiRowIndex = 0; (uiRowIndex < m_vRowNames.size()); uiRowIndex++)
+    {
+        writeRow(m_vRowNames[uiRowIndex], getRow(uiRowIndex));
+    }
+    std::vector<std::string>().swap(m_vRowNames);
+    std::vector<double>().swap(m_vValues);
+    m_uiBytes = 0;
+}
+
+void CNGenotypeHandoff::Table::writeRow(const std::string& strName, const double* pdValues)
+{
+    m_pTsv5->set_string(0, 0, strName);
+    for (unsigned int uiColIndex = 0; (uiColIndex < m_vColumnNames.size()); uiColIndex++)
+    {
+        if (m_eDtype == affx::FILE5_DTYPE_INT) {m_pTsv5->set_i(0, (uiColIndex + 1), (int)pdValues[uiColIndex]);}
+        else {m_pTsv5->set_d(0, (uiColIndex + 1), pdValues[uiColIndex]);}
+    }
+    m_pTsv5->writeLevel(0);
+}
+
+CNGenotypeHandoff::CNGenotypeHandoff(const std::string& strSummaryFileName, const std::string& strCallsFileName, const std::string& strConfidencesFileName, unsigned int uiMegabytes) :
+    m_objSummaries(affx::FILE5_DTYPE_DOUBLE),
+    m_objCalls(affx::FILE5_DTYPE_INT),
+    m_objConfidences(affx::FILE5_DTYPE_DOUBLE)
+{
+    m_strSummaryFileName = strSummaryFileName;
+    m_strCallsFileName = strCallsFileName;
+    m_strConfidencesFileName = strConfidencesFileName;
+    m_uiBudget = (size_t)uiMegabytes * 1024 * 1024;
+    m_pSummaryReporter = new CNGenotypeHandoffSummaryReport(*this);
+    m_pGenotypeReporter = new CNGenotypeHandoffGenotypeReport(*this);
+}
+
+CNGenotypeHandoff::~CNGenotypeHandoff()
+{
+    delete m_pSummaryReporter;
+    delete m_pGenotypeReporter;
+}
+
+void CNGenotypeHandoff::prepareSummaries(const std::vector<std::string>& vColumnNames)
+{
+    m_objSummaries.prepare(m_strSummaryFileName, vColumnNames);
+}
+
+void CNGenotypeHandoff::prepareGenotypes(const std::vector<std::string>& vColumnNames)
+{
+    m_objCalls.prepare(m_strCallsFileName, vColumnNames);
+    m_objConfidences.prepare(m_strConfidencesFileName, vColumnNames);
+}
+
+void CNGenotypeHandoff::addSummary(const std::string& strName, const double* pdValues)
+{
+    m_objSummaries.addRow(strName, pdValues);
+    checkBudget();
+}
+
+void CNGenotypeHandoff::addGenotype(const std::string& strName, const double* pdCalls, const double* pdConfidences)
+{
+    m_objCalls.addRow(strName, pdCalls);
+    m_objConfidences.addRow(strName, pdConfidences);
+    checkBudget();
+}
+
+size_t CNGenotypeHandoff::getBytes() const
+{
+    return m_objSummaries.getBytes() + m_objCalls.getBytes() + m_objConfidences.getBytes();
+}
+
+void CNGenotypeHandoff::checkBudget()
+{
+    while (getBytes() > m_uiBudget)
+    {
+        Table* pLargest = &m_objSummaries;
+        if (m_objCalls.getBytes() > pLargest->getBytes()) {pLargest = &m_objCalls;}
+        if (m_objConfidences.getBytes() > pLargest->getBytes()) {pLargest = &m_objConfidences;}
+        pLargest->spill();
+    }
+}
+
+CNGenotypeHandoff::Table* CNGenotypeHandoff::findTable(const std::string& strFileName)
+{
+    Table* pTables[] = {&m_objSummaries, &m_objCalls, &m_objConfidences};
+    for (int i = 0; (i < 3); i++)
+    {
+        if ((pTables[i]->isPrepared()) && (!pTables[i]->isSpilled()) && (pTables[i]->getFileName() == strFileName)) {return pTables[i];}
+    }
+    return NULL;
+}
@@ -0,0 +1,159 @@
+////////////////////////////////////////////////////////////////
+//
+// Copyright (C) 2011 Affymetrix, Inc.
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License (version 2) as
+// published by the Free Software Foundation.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program;if not, write to the
+//
+// Free Software Foundation, Inc.,
+// 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+//
+////////////////////////////////////////////////////////////////
+
+#ifndef _CNGenotypeHandoff_H_
+#define _CNGenotypeHandoff_H_
+/**
+ * @file CNGenotypeHandoff.h
+ *
+ * @brief This header contains the CNGenotypeHandoff class definition.
+ */
+
+#include "chipstream/QuantMethodReport.h"
+#include "file5/File5.h"
+//
+#include <string>
+#include <vector>
+//
+
+/// Default memory the handoff may hold before spilling to disk, in megabytes.
+#define CNGENOTYPEHANDOFF_MEGABYTES 2000
+
+/**
+ * @brief Holds the allele summaries, genotype calls and genotype confidences
+ * of a probeset genotype run in memory for the copy number engines which
+ * follow it in the workflow.
+ *
+ * Each table stands in for the a5 file the probeset genotype engine would
+ * otherwise write, and is found by that file's name. The values are kept as
+ * doubles, as that file holds them, so the copy number engines read the same
+ * values either way. The copy number
+ * engines read the same tables once per batch of experiments or probe sets,
+ * so keeping them in memory saves writing them and parsing them back again
+ * and again. When the tables outgrow the memory budget the largest is
+ * spilled: what it holds, and every row after, goes to its file in the
+ * layout the probeset genotype engine writes, and it is read from there.
+ */
+class CNGenotypeHandoff
+{
+public:
+    /**
+     * @brief One table of values by probe set and experiment.
+     */
+    class Table
+    {
+    private:
+        /// The a5 file the table stands in for.
+        std::string m_strFileName;
+        /// The column type used if the table is spilled.
+        affx::File5_dtype_t m_eDtype;
+        std::vector<std::string> m_vColumnNames;
+        std::vector<std::string> m_vRowNames;
+        /// The values, row by row.
+        std::vector<double> m_vValues;
+        size_t m_uiBytes;
+        bool m_bPrepared;
+        bool m_bSpilled;
+        affx::File5_File* m_pFile5;
+        affx::File5_Tsv* m_pTsv5;
+
+        void writeRow(const std::string& strName, const double* pdValues);
+
+    public:
+        Table(affx::File5_dtype_t eDtype);
+        ~Table();
+
+        void clear();
+
+        /**
+         * @brief Start the table.
+         * @param const std::string& - The name of the a5 file the table stands in for.
+         * @param const std::vector<std::string>& - The experiment (cel file) names.
+         */
+        void prepare(const std::string& strFileName, const std::vector<std::string>& vColumnNames);
+        void addRow(const std::string& strName, const double* pdValues);
+        /// Close the spill file, if any, so it can be read.
+        void finish();
+        /// Write what the table holds to its file and free the memory.
+        void spill();
+
+        const std::string& getFileName() const {return m_strFileName;}
+        bool isPrepared() const {return m_bPrepared;}
+        bool isSpilled() const {return m_bSpilled;}
+        size_t getBytes() const {return m_uiBytes;}
+
+        int getColumnCount() const {return (int)m_vColumnNames.size();}
+        const std::string& getColumnName(int iColIndex) const {return m_vColumnNames[iColIndex];}
+        int getRowCount() const {return (int)m_vRowNames.size();}
+        const std::string& getRowName(int iRowIndex) const {return m_vRowNames[iRowIndex];}
+        const double* getRow(int iRowIndex) const {return &m_vValues[(size_t)iRowIndex * m_vColumnNames.size()];}
+    };
+
+private:
+    Table m_objSummaries;
+    Table m_objCalls;
+    Table m_objConfidences;
+    size_t m_uiBudget;
+    std::string m_strSummaryFileName;
+    std::string m_strCallsFileName;
+    std::string m_strConfidencesFileName;
+    QuantMethodReport* m_pSummaryReporter;
+    QuantMethodReport* m_pGenotypeReporter;
+
+public:
+    /**
+     * @brief Constructor.
+     * @param const std::string& - The expression summary file name.
+     * @param const std::string& - The genotype calls file name.
+     * @param const std::string& - The genotype confidences file name.
+     * @param unsigned int - The memory budget in megabytes.
+     */
+    CNGenotypeHandoff(const std::string& strSummaryFileName, const std::string& strCallsFileName, const std::string& strConfidencesFileName, unsigned int uiMegabytes = CNGENOTYPEHANDOFF_MEGABYTES);
+    ~CNGenotypeHandoff();
+
+    /// Reporters to add to the probeset genotype engine. Owned by the handoff.
+    QuantMethodReport* getSummaryReporter() {return m_pSummaryReporter;}
+    QuantMethodReport* getGenotypeReporter() {return m_pGenotypeReporter;}
+
+    Table* getSummaries() {return &m_objSummaries;}
+    Table* getCalls() {return &m_objCalls;}
+    Table* getConfidences() {return &m_objConfidences;}
+
+    void prepareSummaries(const std::vector<std::string>& vColumnNames);
+    void prepareGenotypes(const std::vector<std::string>& vColumnNames);
+    void addSummary(const std::string& strName, const double* pdValues);
+    void addGenotype(const std::string& strName, const double* pdCalls, const double* pdConfidences);
+
+    /// Spill the largest tables until the rest fit in the budget.
+    void checkBudget();
+    size_t getBytes() const;
+
+    /**
+     * @brief The in memory table standing in for a file.
+     * @param const std::string& - The file name.
+     * @return Table* - The table, or NULL if the file is to be read from disk.
+     */
+    Table* findTable(const std::string& strFileName);
+};
+
+#endif
+
+
@@ -67,6 +67,7 @@ CNLog2RatioData::CNLog2RatioData()
 {
     m_bLog2RatioEngine = false;
     m_pEngine = NULL;
+    m_pHandoff = NULL;
     m_vProbeSets.clear();
 
         m_dMuPrimeAA=0;
@@ -107,6 +108,7 @@ void CNLog2RatioData::clearProbeSets()
     m_arProbeSetsAlternateSort.nullAll();
     m_arProbeSets.nullAll();
     m_vProbeSets.clear();
+    clearHandoffRows();
 }
 
 /**
@@ -439,6 +441,18 @@ int CNLog2RatioData::loadExperiments(const AffxString& strFileName)
 {
     getExperiments()->deleteAll();
     unsigned int uiColCount = 0;
+    CNGenotypeHandoff::Table* pTable = findHandoffTable(strFileName);
+    if (pTable != NULL)
+    {
+        for (int iColIndex = 0; (iColIndex < pTable->getColumnCount()); iColIndex++)
+        {
+            CNExperiment* pobjExperiment = new CNExperiment;
+            pobjExperiment->setIndex(iColIndex);
+            pobjExperiment->setExperimentName(pTable->getColumnName(iColIndex));
+            getExperiments()->add(pobjExperiment);
+        }
+        return pTable->getColumnCount();
+    }
     if (affx::File5_File::isHdf5file(strFileName))
     {
         try
@@ -981,6 +995,8 @@ void CNLog2RatioData::dumpCyto2Report(const AffxString& strFileName)
  */
 bool CNLog2RatioData::loadAlleleEstimatesByProbeSet(const AffxString& strFileName, int iProbeSetIndex, int iProbeSetsToProcess)
 {
+    CNGenotypeHandoff::Table* pTable = findHandoffTable(strFileName);
+    if (pTable != NULL) {return loadAlleleEstimatesHandoff(pTable, iProbeSetIndex, iProbeSetsToProcess, 0, pTable->getColumnCount());}
     if (affx::File5_File::isHdf5file(strFileName)) {return loadAlleleEstimatesByProbeSetHdf5(strFileName, iProbeSetIndex, iProbeSetsToProcess);}
     bool bSuccessful = false;
     affx::TsvFile tsv;
@@ -1184,6 +1200,8 @@ bool CNLog2RatioData::loadAlleleEstimatesByProbeSetHdf5(const AffxString& strFil
  */
 bool CNLog2RatioData::loadAlleleEstimatesByExperiment(const AffxString& strFileName, int iExperimentIndex, int iExperimentsToProcess)
 {
+    CNGenotypeHandoff::Table* pTable = findHandoffTable(strFileName);
+    if (pTable != NULL) {return loadAlleleEstimatesHandoff(pTable, 0, m_arProbeSets.getCount(), iExperimentIndex, iExperimentsToProcess);}
     if (affx::File5_File::isHdf5file(strFileName)) {return loadAlleleEstimatesByExperimentHdf5(strFileName, iExperimentIndex, iExperimentsToProcess);}
     Verbose::out(3, "CNLog2RatioData::loadAlleleEstimatesByExperiment");
     bool bSuccessful = false;
@@ -1379,6 +1397,8 @@ bool CNLog2RatioData::loadAlleleEstimatesByExperimentHdf5(const AffxString& strF
  */
 bool CNLog2RatioData::loadGenotypeCallsByProbeSet(const AffxString& strFileName, int iProbeSetIndex, int iProbeSetsToProcess)
 {
+    CNGenotypeHandoff::Table* pTable = findHandoffTable(strFileName);
+    if (pTable != NULL) {return loadGenotypeCallsHandoff(pTable, iProbeSetIndex, iProbeSetsToProcess, 0, pTable->getColumnCount());}
     if (affx::File5_File::isHdf5file(strFileName)) {return loadGenotypeCallsByProbeSetHdf5(strFileName, iProbeSetIndex, iProbeSetsToProcess);}
     bool bSuccessful = false;
     affx::TsvFile tsv;
@@ -1532,6 +1552,8 @@ bool CNLog2RatioData::loadGenotypeCallsByProbeSetHdf5(const AffxString& strFileN
  */
 bool CNLog2RatioData::loadGenotypeCallsByExperiment(const AffxString& strFileName, int iExperimentIndex, int iExperimentsToProcess)
 {
+    CNGenotypeHandoff::Table* pTable = findHandoffTable(strFileName);
+    if (pTable != NULL) {return loadGenotypeCallsHandoff(pTable, 0, m_arProbeSets.getCount(), iExperimentIndex, iExperimentsToProcess);}
     if (affx::File5_File::isHdf5file(strFileName)) {return loadGenotypeCallsByExperimentHdf5(strFileName, iExperimentIndex, iExperimentsToProcess);}
     bool bSuccessful = false;
     affx::TsvFile tsv;
@@ -1681,6 +1703,8 @@ bool CNLog2RatioData::loadGenotypeCallsByExperimentHdf5(const AffxString& strFil
  */
 bool CNLog2RatioData::loadGenotypeConfidencesByExperiment(const AffxString& strFileName, int iExperimentIndex, int iExperimentsToProcess)
 {
+  CNGenotypeHandoff::Table* pTable = findHandoffTable(strFileName);
+  if (pTable != NULL) {return loadGenotypeConfidencesHandoff(pTable, iExperimentIndex, iExperimentsToProcess);}
   if (affx::File5_File::isHdf5file(strFileName)) {return loadGenotypeConfidencesByExperimentHdf5(strFileName, iExperimentIndex, iExperimentsToProcess);}
   bool bSuccessful = false;
   affx::TsvFile tsv;
@@ -1814,6 +1838,178 @@ bool CNLog2RatioData::loadGenotypeConfidencesByExperimentHdf5(const AffxString&
     return bSuccessful;
 }
 
+/**
+ * Return the table standing in for a file, if the probeset genotype engine handed it over in memory.
+ * @param const AffxString& - The file name.
+ * @return CNGenotypeHandoff::Table* - The table, or NULL if the file is to be read from disk.
+ */
+CNGenotypeHandoff::Table* CNLog2RatioData::findHandoffTable(const AffxString& strFileName)
+{
+    if (m_pHandoff == NULL) {return NULL;}
+    return m_pHandoff->findTable(strFileName);
+}
+
+/**
+ * Forget where the probe sets are in the handoff tables. Called whenever the probe sets change.
+ */
+void CNLog2RatioData::clearHandoffRows()
+{
+    m_vHandoffSummaryRows.clear();
+    m_vHandoffCallRows.clear();
+    m_vHandoffConfidenceRows.clear();
+}
+
+/**
+ * Return, for each probe set, its row in a handoff table, or -1 if it has none. The rows are
+ * looked up once, the way the Hdf5 loaders match the rows of the table file, and kept for the
+ * following batches. For the allele summaries the row is the A allele's; a SNP's B allele row follows it.
+ * @param CNGenotypeHandoff::Table* - The table.
+ * @return const std::vector<int>& - The rows by probe set index.
+ */
+const std::vector<int>& CNLog2RatioData::getHandoffRows(CNGenotypeHandoff::Table* pTable)
+{
+    std::vector<int>* pvRows = &m_vHandoffConfidenceRows;
+    bool bAlleles = false;
+    if (pTable == m_pHandoff->getSummaries()) {pvRows = &m_vHandoffSummaryRows; bAlleles = true;}
+    else if (pTable == m_pHandoff->getCalls()) {pvRows = &m_vHandoffCallRows;}
+    if ((int)pvRows->size() == m_arProbeSets.getCount()) {return *pvRows;}
+
+    pvRows->assign(m_arProbeSets.getCount(), -1);
+    CNProbeSet objSearch;
+    for (int iTableRow = 0; (iTableRow < pTable->getRowCount()); iTableRow++)
+    {
+        AffxString strProbeSetName = pTable->getRowName(iTableRow);
+        bool bSnp = ((bAlleles) && ((strProbeSetName.startsWith("SNP_A-")) || (strProbeSetName.startsWith("AFFX-SNP_A-"))));
+        if (bSnp) {strProbeSetName = strProbeSetName.substring(0, (int)strProbeSetName.length() - 2);}
+        objSearch.setProbeSetName(strProbeSetName);
+        int iRowIndex = m_arProbeSets.binarySearch(objSearch, 0);
+        if (iRowIndex != -1) {(*pvRows)[iRowIndex] = iTableRow;}
+        // The B allele row follows the A allele row.
+        if (bSnp) {iTableRow++;}
+    }
+    return *pvRows;
+}
+
+/**
+ * Check the experiments of a table handed over in memory against those loaded from the allele summaries.
+ * @param CNGenotypeHandoff::Table* - The table.
+ * @param const AffxString& - The table name, for the error messages.
+ */
+void CNLog2RatioData::checkHandoffExperiments(CNGenotypeHandoff::Table* pTable, const AffxString& strTableName)
+{
+    if (pTable->getColumnCount() != getExperiments()->getCount()) {throw(Except(strTableName + " table does not have the correct number of experiments."));}
+    for (int iColIndex = 0; (iColIndex < pTable->getColumnCount()); iColIndex++)
+    {
+        AffxString strExperimentName = getExperiments()->getAt(iColIndex)->getExperimentName();
+        int iFindIndex = strExperimentName.indexOf(".");
+        if (iFindIndex != -1) {strExperimentName = strExperimentName.substring(0, iFindIndex);}
+        AffxString strColumnName = pTable->getColumnName(iColIndex);
+        iFindIndex = strColumnName.indexOf(".");
+        if (iFindIndex != -1) {strColumnName = strColumnName.substring(0, iFindIndex);}
+        if (strColumnName != strExperimentName) {throw(Except("Experiment name mismatch between Allele Summary table and " + strTableName + " table: " + strExperimentName + " vs. " + strColumnName));}
+    }
+}
+
+/**
+ * Set up the A Allele signal matrix and the B Allele signal matrix from the allele summaries handed over in memory
+ * (see CNGenotypeHandoff), as the Hdf5 loaders do from the allele summary table file.
+ * @param CNGenotypeHandoff::Table* - The allele summary table.
+ * @param int - The probe set index to start from.
+ * @param int - The number of probe sets to load.
+ * @param int - The experiment index to start from.
+ * @param int - The number of experiments to load.
+ * @return bool - true if successful
+ */
+bool CNLog2RatioData::loadAlleleEstimatesHandoff(CNGenotypeHandoff::Table* pTable, int iProbeSetIndex, int iProbeSetsToProcess, int iExperimentIndex, int iExperimentsToProcess)
+{
+    Verbose::out(3, "CNLog2RatioData::loadAlleleEstimatesHandoff");
+    const std::vector<int>& vTableRows = getHandoffRows(pTable);
+    int iLastProbeSet = Min((iProbeSetIndex + iProbeSetsToProcess), m_arProbeSets.getCount());
+    int iLastExperiment = Min((iExperimentIndex + iExperimentsToProcess), pTable->getColumnCount());
+    bool bLog2Input = m_pEngine->getOptBool("log2-input");
+    for (int iRowIndex = iProbeSetIndex; (iRowIndex < iLastProbeSet); iRowIndex++)
+    {
+        int iTableRow = vTableRows[iRowIndex];
+        if (iTableRow == -1) {continue;}
+        AffxString strProbeSetName = pTable->getRowName(iTableRow);
+        bool bSnp = ((strProbeSetName.startsWith("SNP_A-")) || (strProbeSetName.startsWith("AFFX-SNP_A-")));
+        if (bSnp) {strProbeSetName = strProbeSetName.substring(0, (int)strProbeSetName.length() - 2);}
+        bool bCn = ((strProbeSetName.startsWith("CN")) || (strProbeSetName.startsWith("chr")));
+        const double* pdA = pTable->getRow(iTableRow);
+        const double* pdB = NULL;
+        if ((bSnp) && ((iTableRow + 1) < pTable->getRowCount())) {pdB = pTable->getRow(iTableRow + 1);}
+        for (int iColIndex = iExperimentIndex; (iColIndex < iLastExperiment); iColIndex++)
+        {
+            float fA = (bLog2Input ? (float)(exp(log(2.0) * pdA[iColIndex])) : (float)pdA[iColIndex]);
+            if (bCn) {fA = (float)(fA / 2.0);}
+            m_mxAAlleleEstimates.set((iColIndex - iExperimentIndex), (iRowIndex - iProbeSetIndex), fA);
+            float fB = fA;
+            if (bSnp)
+            {
+                if (pdB == NULL) {continue;}
+                fB = (bLog2Input ? (float)(exp(log(2.0) * pdB[iColIndex])) : (float)pdB[iColIndex]);
+            }
+            m_mxBAlleleEstimates.set((iColIndex - iExperimentIndex), (iRowIndex - iProbeSetIndex), fB);
+        }
+    }
+    return true;
+}
+
+/**
+ * Set up the genotype call matrix from the genotype calls handed over in memory (see CNGenotypeHandoff),
+ * as the Hdf5 loaders do from the genotype call table file.
+ * @param CNGenotypeHandoff::Table* - The genotype call table.
+ * @param int - The probe set index to start from.
+ * @param int - The number of probe sets to load.
+ * @param int - The experiment index to start from.
+ * @param int - The number of experiments to load.
+ * @return bool - true if successful
+ */
+bool CNLog2RatioData::loadGenotypeCallsHandoff(CNGenotypeHandoff::Table* pTable, int iProbeSetIndex, int iProbeSetsToProcess, int iExperimentIndex, int iExperimentsToProcess)
+{
+    Verbose::out(3, "CNLog2RatioData::loadGenotypeCallsHandoff");
+    checkHandoffExperiments(pTable, "Genotype Calls");
+    const std::vector<int>& vTableRows = getHandoffRows(pTable);
+    int iLastProbeSet = Min((iProbeSetIndex + iProbeSetsToProcess), m_arProbeSets.getCount());
+    int iLastExperiment = Min((iExperimentIndex + iExperimentsToProcess), pTable->getColumnCount());
+    for (int iRowIndex = iProbeSetIndex; (iRowIndex < iLastProbeSet); iRowIndex++)
+    {
+        int iTableRow = vTableRows[iRowIndex];
+        const double* pd = ((iTableRow == -1) ? NULL : pTable->getRow(iTableRow));
+        for (int iColIndex = iExperimentIndex; (iColIndex < iLastExperiment); iColIndex++)
+        {
+            m_mxGenotypeCalls.set((iColIndex - iExperimentIndex), (iRowIndex - iProbeSetIndex), ((pd == NULL) ? (char)-1 : (char)(int)pd[iColIndex]));
+        }
+    }
+    return true;
+}
+
+/**
+ * Set up the genotype confidence matrix from the genotype confidences handed over in memory (see CNGenotypeHandoff),
+ * as loadGenotypeConfidencesByExperimentHdf5 does from the genotype confidence table file.
+ * @param CNGenotypeHandoff::Table* - The genotype confidence table.
+ * @param int - The experiment index to start from.
+ * @param int - The number of experiments to load.
+ * @return bool - true if successful
+ */
+bool CNLog2RatioData::loadGenotypeConfidencesHandoff(CNGenotypeHandoff::Table* pTable, int iExperimentIndex, int iExperimentsToProcess)
+{
+    Verbose::out(3, "CNLog2RatioData::loadGenotypeConfidencesHandoff");
+    checkHandoffExperiments(pTable, "Genotype Confidences");
+    const std::vector<int>& vTableRows = getHandoffRows(pTable);
+    int iLastExperiment = Min((iExperimentIndex + iExperimentsToProcess), pTable->getColumnCount());
+    for (int iRowIndex = 0; (iRowIndex < m_arProbeSets.getCount()); iRowIndex++)
+    {
+        int iTableRow = vTableRows[iRowIndex];
+        const double* pd = ((iTableRow == -1) ? NULL : pTable->getRow(iTableRow));
+        for (int iColIndex = iExperimentIndex; (iColIndex < iLastExperiment); iColIndex++)
+        {
+            m_mxGenotypeConfidences.set((iColIndex - iExperimentIndex), iRowIndex, ((pd == NULL) ? 0 : (float)pd[iColIndex]));
+        }
+    }
+    return true;
+}
+
 /**
  * Calculate the median singal for the log2 ratio model.
  * The data is processed by probes set meaning the all the experiment data is processed for a subset of the probe sets.
@@ -2300,9 +2496,7 @@ void CNLog2RatioData::loadProbeSets()
     tsv5->close();
     delete tsv5;
 
-    m_arProbeSets.nullAll();
-    m_arProbeSetsAlternateSort.nullAll();
-    m_vProbeSets.clear();
+    clearProbeSets();
     m_vProbeSets.allocate(uiCount);
     m_arProbeSets.reserve(uiCount);
 
@@ -2372,6 +2566,7 @@ void CNLog2RatioData::loadAnnotation(bool bNewProbeSets)
     {
         m_arProbeSets.nullAll();
         m_arProbeSetsAlternateSort.nullAll();
+        clearHandoffRows();
     }
     else {loadProbeSets();}
 
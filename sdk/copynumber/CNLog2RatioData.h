@@ -28,6 +28,7 @@
  */
 
 #include "copynumber/CNExperiment.h"
+#include "copynumber/CNGenotypeHandoff.h"
 #include "copynumber/CNProbeSet.h"
 #include "copynumber/CNSegment.h"
 //
@@ -52,6 +53,15 @@ private:
     CNProbeSetArray m_arProbeSets;
     CNProbeSetArray m_arProbeSetsAlternateSort;
 
+    /// The tables the probeset genotype engine handed over in memory, if any.
+    CNGenotypeHandoff* m_pHandoff;
+    /// For each probe set, its (A allele) row in the handoff summaries, -1 if it has none. Made when first needed.
+    std::vector<int> m_vHandoffSummaryRows;
+    /// For each probe set, its row in the handoff calls, -1 if it has none.
+    std::vector<int> m_vHandoffCallRows;
+    /// For each probe set, its row in the handoff confidences, -1 if it has none.
+    std::vector<int> m_vHandoffConfidenceRows;
+
     AffxMultiDimensionalArray<float> m_mxAAlleleEstimates;
     AffxMultiDimensionalArray<float> m_mxBAlleleEstimates;
     AffxMultiDimensionalArray<char> m_mxGenotypeCalls;
@@ -76,6 +86,7 @@ public:
 
     void setLog2RatioEngine(bool b) {m_bLog2RatioEngine = b;}
     void setEngine(BaseEngine* pEngine) {m_pEngine = pEngine;}
+    void setHandoff(CNGenotypeHandoff* pHandoff) {m_pHandoff = pHandoff; clearHandoffRows();}
     CNExperimentArray* getExperiments() {return &m_arExperiments;}
     void setExperiments(CNExperimentArray& v) {m_arExperiments = v;}
     CNProbeSetArray* getProbeSets() {return &m_arProbeSets;}
@@ -138,6 +149,14 @@ private:
 
     void loadProbeSetNamesFromRestrictList(AffxArray<AffxString>& ar);
 
+    CNGenotypeHandoff::Table* findHandoffTable(const AffxString& strFileName);
+    void clearHandoffRows();
+    const std::vector<int>& getHandoffRows(CNGenotypeHandoff::Table* pTable);
+    void checkHandoffExperiments(CNGenotypeHandoff::Table* pTable, const AffxString& strTableName);
+    bool loadAlleleEstimatesHandoff(CNGenotypeHandoff::Table* pTable, int iProbeSetIndex, int iProbeSetsToProcess, int iExperimentIndex, int iExperimentsToProcess);
+    bool loadGenotypeCallsHandoff(CNGenotypeHandoff::Table* pTable, int iProbeSetIndex, int iProbeSetsToProcess, int iExperimentIndex, int iExperimentsToProcess);
+    bool loadGenotypeConfidencesHandoff(CNGenotypeHandoff::Table* pTable, int iExperimentIndex, int iExperimentsToProcess);
+
     bool isNaN(const double& d) {return d != d;}
 
     double getSnpSignalEstimate(int iCol, int iRow, CNProbeSet* p);
@@ -125,6 +125,12 @@ public:
         m_pEngine = p; m_objCNAnalysisEngine.setEngine(p);
     }
 
+    /**
+     * @brief Read the probeset genotype results from memory rather than from their files.
+     * @param CNGenotypeHandoff* - The tables handed over, or NULL to read the files.
+     */
+    void setHandoff(CNGenotypeHandoff* p) {m_data.setHandoff(p);}
+
 protected:
     bool determineMemoryUsage();
     bool processData();
@@ -26,6 +26,11 @@
  */
 
 #include "copynumber/CNProbeSet.h"
+#include "copynumber/CNRunningMedian.h"
+//
+#include "label/snp.label.h"
+//
+#include <algorithm>
 //
 
 CNProbeSet::CNProbeSet()
@@ -102,6 +107,80 @@ void CNProbeSet::clear()
   m_bTrulyCN=false;
 }
 
+/**
+ * Copy the probe set, snp distribution and all. The sample parallel
+ * analysis gives each worker its own copy to hold its results.
+ */
+CNProbeSet::CNProbeSet(const CNProbeSet& that)
+{
+  m_pSnpDistribution = NULL;
+  *this = that;
+}
+
+const CNProbeSet& CNProbeSet::operator=(const CNProbeSet& that)
+{
+  if (this == &that) {return *this;}
+  m_bProcess = that.m_bProcess;
+  m_vWaves = that.m_vWaves;
+  m_vAllCovariates = that.m_vAllCovariates;
+  m_strProbeSetName = that.m_strProbeSetName;
+  m_cChromosome = that.m_cChromosome;
+  m_iPosition = that.m_iPosition;
+  m_fMedianSignal = that.m_fMedianSignal;
+  m_fXXMedianSignal = that.m_fXXMedianSignal;
+  m_fYMedianSignal = that.m_fYMedianSignal;
+  m_fAAMedianSignal = that.m_fAAMedianSignal;
+  m_fABMedianSignal = that.m_fABMedianSignal;
+  m_fBBMedianSignal = that.m_fBBMedianSignal;
+  m_cProcessFlag = that.m_cProcessFlag;
+  m_cStyAdapterCode = that.m_cStyAdapterCode;
+  m_cNspAdapterCode = that.m_cNspAdapterCode;
+  m_fGCContent = that.m_fGCContent;
+  m_fAMedianIntensity = that.m_fAMedianIntensity;
+  m_fBMedianIntensity = that.m_fBMedianIntensity;
+  m_fAAlleleSignal = that.m_fAAlleleSignal;
+  m_fBAlleleSignal = that.m_fBAlleleSignal;
+  m_fLog2Ratio = that.m_fLog2Ratio;
+  m_fLog2RatioMedianSmooth = that.m_fLog2RatioMedianSmooth;
+  m_fAllelicDifference = that.m_fAllelicDifference;
+  m_fGcAdjustment = that.m_fGcAdjustment;
+  m_bPseudoAutosomalRegion = that.m_bPseudoAutosomalRegion;
+  m_iGCBinIndex = that.m_iGCBinIndex;
+  m_cGenotypeCall = that.m_cGenotypeCall;
+  m_fGenotypeConfidence = that.m_fGenotypeConfidence;
+  m_iCNState = that.m_iCNState;
+  m_iImputedCNState = that.m_iImputedCNState;
+  m_fCNConfidence = that.m_fCNConfidence;
+  m_fSmoothedLog2Ratio = that.m_fSmoothedLog2Ratio;
+  m_fLoh = that.m_fLoh;
+  m_fSCAR = that.m_fSCAR;
+  m_fFLD = that.m_fFLD;
+  m_iMaxPeaks = that.m_iMaxPeaks;
+  m_bUseForSketch = that.m_bUseForSketch;
+  m_fMuAA = that.m_fMuAA;
+  m_fMuAB = that.m_fMuAB;
+  m_fMuBB = that.m_fMuBB;
+  m_fInformation = that.m_fInformation;
+  m_iUseInEMAlgorithm = that.m_iUseInEMAlgorithm;
+  m_fMosaicismMixture = that.m_fMosaicismMixture;
+  m_iReplicateCount = that.m_iReplicateCount;
+  m_uiAllelePeaks1 = that.m_uiAllelePeaks1;
+  m_uiAllelePeaks2 = that.m_uiAllelePeaks2;
+  m_bValidSCARExists = that.m_bValidSCARExists;
+  m_bValidFLDExists = that.m_bValidFLDExists;
+  m_bValidHomHetExists = that.m_bValidHomHetExists;
+  m_bTrulySNP = that.m_bTrulySNP;
+  m_bTrulyCN = that.m_bTrulyCN;
+  if (m_pSnpDistribution != NULL) {
+    delete m_pSnpDistribution;
+    m_pSnpDistribution = NULL;
+  }
+  if (that.m_pSnpDistribution != NULL) {
+    m_pSnpDistribution = new snp_distribution(*that.m_pSnpDistribution);
+  }
+  return *this;
+}
+
 float CNProbeSet::getSignalContrast(double dK)
 {
   if ((m_fAAlleleSignal + m_fBAlleleSignal) == 0) {
@@ -424,7 +503,7 @@ void CNProbeSet::setCovariateValue(int index, float value)
     m_vAllCovariates[index] = value;
 }
 
-CNProbeSetArray::CNProbeSetArray() {}
+CNProbeSetArray::CNProbeSetArray() : m_iIndexedCount(-1) {}
 CNProbeSetArray::~CNProbeSetArray()
 {
   nullAll();
@@ -475,13 +554,19 @@ void CNProbeSetArray::calculateLog2RatioMedianSmooth(int iWindowSize)
     return;
   }
   int iHalfWindow = (int)(iWindowSize / 2);
-  AffxMultiDimensionalArray<float> v(iWindowSize);
+  std::vector<float> vLog2Ratios(getCount());
+  for (int iIndex = 0; (iIndex < getCount()); iIndex++) {
+    vLog2Ratios[iIndex] = getAt(iIndex)->getLog2Ratio();
+  }
+  CNRunningMedian<float> objMedian;
+  objMedian.setup(vLog2Ratios, iWindowSize);
+  for (int iIndex = 0; (iIndex < (iWindowSize - 1)); iIndex++) {
+    objMedian.add(iIndex);
+  }
   for (int iIndex = iHalfWindow; (iIndex < (getCount() - iHalfWindow)); iIndex++) {
-    int j = 0;
-    for (int i = (iIndex - iHalfWindow); (i <= (iIndex + iHalfWindow)); i++) {
-      v.set(j, getAt(i)->getLog2Ratio()); j++;
-    }
-    getAt(iIndex)->setLog2RatioMedianSmooth(v.median());
+    objMedian.add(iIndex + iHalfWindow);
+    getAt(iIndex)->setLog2RatioMedianSmooth(objMedian.getMedian());
+    objMedian.remove(iIndex - iHalfWindow);
   }
   for (int iIndex = (iHalfWindow - 1); (iIndex >= 0); iIndex--) {
     getAt(iIndex)->setLog2RatioMedianSmooth(getAt(iIndex + 1)->getLog2RatioMedianSmooth());
@@ -491,6 +576,117 @@ void CNProbeSetArray::calculateLog2RatioMedianSmooth(int iWindowSize)
   }
 }
 
+/**
+ * Find where each chromosome starts and ends. The probe sets of a
+ * chromosome must be together; the order of the chromosomes does not matter.
+ */
+void CNProbeSetArray::indexChromosomes()
+{
+  m_vChromosomeBounds.clear();
+  m_vChromosomes.clear();
+  int iChromosome = -1;
+  for (int iIndex = 0; (iIndex < getCount()); iIndex++) {
+    int iThisChromosome = getAt(iIndex)->getChromosome();
+    if (iThisChromosome < 0) {
+      Err::errAbort("CNProbeSetArray: chromosome " + ToStr(iThisChromosome) + " of probe set " + ToStr(iIndex) + " is not valid");
+    }
+    if (iThisChromosome == iChromosome) {
+      m_vChromosomeBounds[iChromosome].second++;
+      continue;
+    }
+    if (iThisChromosome >= (int)m_vChromosomeBounds.size()) {
+      m_vChromosomeBounds.resize(iThisChromosome + 1, std::pair<int, int>(0, 0));
+    }
+    if (m_vChromosomeBounds[iThisChromosome].second != 0) {
+      Err::errAbort("CNProbeSetArray: chromosomes are not contiguous, chromosome " + ToStr(iThisChromosome) + " starts again at probe set " + ToStr(iIndex));
+    }
+    m_vChromosomeBounds[iThisChromosome] = std::pair<int, int>(iIndex, iIndex + 1);
+    m_vChromosomes.push_back(iThisChromosome);
+    iChromosome = iThisChromosome;
+  }
+  std::sort(m_vChromosomes.begin(), m_vChromosomes.end());
+  m_iIndexedCount = getCount();
+}
+
+/**
+ * Check that the index still fits the array: the same count, and each
+ * chromosome starts and ends with one of its probe sets. This looks at two
+ * probe sets per chromosome, not every probe set.
+ */
+bool CNProbeSetArray::isChromosomeIndexCurrent()
+{
+  if (m_iIndexedCount != getCount()) {
+    return false;
+  }
+  for (unsigned int ui = 0; (ui < m_vChromosomes.size()); ui++) {
+    int iChromosome = m_vChromosomes[ui];
+    const std::pair<int, int>& bounds = m_vChromosomeBounds[iChromosome];
+    if ((getAt(bounds.first)->getChromosome() != iChromosome) || (getAt(bounds.second - 1)->getChromosome() != iChromosome)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+/**
+ * Return where a chromosome's probe sets are in the array. As in STL, the
+ * end is one past the last probe set.
+ * @param int - The chromosome.
+ * @return std::pair<int, int> - The begin and end, (0, 0) if the chromosome has no probe sets.
+ */
+std::pair<int, int> CNProbeSetArray::getChromosomeBounds(int iChromosome)
+{
+  if (!isChromosomeIndexCurrent()) {
+    indexChromosomes();
+  }
+  if ((iChromosome < 0) || (iChromosome >= (int)m_vChromosomeBounds.size())) {
+    return std::pair<int, int>(0, 0);
+  }
+  return m_vChromosomeBounds[iChromosome];
+}
+
+int CNProbeSetArray::getChromosomeProbeSetCount(int iChromosome)
+{
+  std::pair<int, int> bounds = getChromosomeBounds(iChromosome);
+  return bounds.second - bounds.first;
+}
+
+/**
+ * Return the chromosomes in the array in increasing order.
+ */
+std::vector<int> CNProbeSetArray::getChromosomes()
+{
+  if (!isChromosomeIndexCurrent()) {
+    indexChromosomes();
+  }
+  return m_vChromosomes;
+}
+
+/**
+ * Copy the fields the analysis methods read most out of a run of probe sets.
+ * @param const std::pair<int, int>& - The begin and end of the run, as from getChromosomeBounds().
+ * @param CNProbeSetColumns& - The columns, resized to the length of the run.
+ */
+void CNProbeSetArray::getColumns(const std::pair<int, int>& bounds, CNProbeSetColumns& columns)
+{
+  int iCount = bounds.second - bounds.first;
+  columns.m_vPositions.resize(iCount);
+  columns.m_vLog2Ratios.resize(iCount);
+  columns.m_vAAlleleSignals.resize(iCount);
+  columns.m_vBAlleleSignals.resize(iCount);
+  columns.m_vSCARs.resize(iCount);
+  columns.m_vGenotypeCalls.resize(iCount);
+  for (int iIndex = 0; (iIndex < iCount); iIndex++) {
+    CNProbeSet* p = getAt(bounds.first + iIndex);
+    columns.m_vPositions[iIndex] = p->getPosition();
+    columns.m_vLog2Ratios[iIndex] = p->getLog2Ratio();
+    columns.m_vAAlleleSignals[iIndex] = p->getAAlleleSignal();
+    columns.m_vBAlleleSignals[iIndex] = p->getBAlleleSignal();
+    columns.m_vSCARs[iIndex] = p->getSCAR();
+    columns.m_vGenotypeCalls[iIndex] = p->getGenotypeCall();
+  }
+}
+
 void CNProbeSetArray::setupGCCorrectionBins(int iGCBinCount)
 {
   AffxMultiDimensionalArray<float> vGcContent(getProcessCount());
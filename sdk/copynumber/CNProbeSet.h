@@ -335,11 +335,43 @@ template<> struct CNProbeSet::ComparePred<1> {
     }
 };
 
+/**
+ * @brief  The fields the analysis methods read most, for a run of probe sets,
+ * one vector per field so they can be worked through in order.
+ */
+class CNProbeSetColumns
+{
+public:
+  std::vector<int> m_vPositions;
+  std::vector<float> m_vLog2Ratios;
+  std::vector<float> m_vAAlleleSignals;
+  std::vector<float> m_vBAlleleSignals;
+  std::vector<float> m_vSCARs;
+  std::vector<char> m_vGenotypeCalls;
+
+  int getCount() { return (int)m_vPositions.size(); }
+};
+
 /**
  * @brief  A vector of ProbeSet Pointers.
+ *
+ * Once sorted by chromosome the array can find where each chromosome
+ * starts and ends without looking at every probe set. The index is made
+ * the first time it is needed and again if the array has changed.
  */
 class CNProbeSetArray : public AffxArray<CNProbeSet>
 {
+private:
+  /// [begin, end) of each chromosome by chromosome number, (0, 0) for one with no probe sets.
+  std::vector<std::pair<int, int> > m_vChromosomeBounds;
+  /// The chromosomes in the array, in increasing order.
+  std::vector<int> m_vChromosomes;
+  /// The number of probe sets indexed, -1 if there is no index.
+  int m_iIndexedCount;
+
+  void indexChromosomes();
+  bool isChromosomeIndexCurrent();
+
 public:
   CNProbeSetArray();
 
@@ -352,6 +384,17 @@ public:
   void calculateLog2RatioMedianSmooth(int iWindowSize);
 
   void setupGCCorrectionBins(int iGCBinCount);
+
+  std::pair<int, int> getChromosomeBounds(int iChromosome);
+  int getChromosomeProbeSetCount(int iChromosome);
+  std::vector<int> getChromosomes();
+  void getColumns(const std::pair<int, int>& bounds, CNProbeSetColumns& columns);
+
+  // Sorting moves the chromosomes, so the index is made again.
+  using AffxArray<CNProbeSet>::quickSort;
+  void quickSort() { m_iIndexedCount = -1; AffxArray<CNProbeSet>::quickSort(); }
+  void quickSort(int iCompareCode) { m_iIndexedCount = -1; AffxArray<CNProbeSet>::quickSort(iCompareCode); }
+  void quickSort(int iFrom, int iTo, int iCompareCode) { m_iIndexedCount = -1; AffxArray<CNProbeSet>::quickSort(iFrom, iTo, iCompareCode); }
 };
 
 #endif
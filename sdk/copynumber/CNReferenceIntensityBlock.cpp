@@ -0,0 +1,156 @@
+////////////////////////////////////////////////////////////////
+//
+// Copyright (C) 2011 Affymetrix, Inc.
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License (version 2) as
+// published by the Free Software Foundation.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program;if not, write to the
+//
+// Free Software Foundation, Inc.,
+// 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+//
+////////////////////////////////////////////////////////////////
+
+/**
+ * @file CNReferenceIntensityBlock.cpp
+ *
+ * @brief This file contains the CNReferenceIntensityBlock class members.
+ */
+
+#include "copynumber/CNReferenceIntensityBlock.h"
+//
+#include "util/Err.h"
+#include "util/Util.h"
+//
+#include <algorithm>
+#include <limits>
+//
+
+static bool isNaN(float f) {return (f != f);}
+
+CNReferenceIntensityBlock::CNReferenceIntensityBlock()
+{
+    m_uiCelCount = 0;
+    m_uiBlockSize = 0;
+    m_uiLineCount = 0;
+    m_uiProbeCount = 0;
+}
+
+unsigned int CNReferenceIntensityBlock::getBlockSize(unsigned int uiCelCount, unsigned int uiMegabytes)
+{
+    // Two copies of the intensities, and the three int columns.
+    double dBytesPerProbe = (2.0 * uiCelCount * sizeof(float)) + (3 * sizeof(int));
+    double dProbes = ((double)uiMegabytes * 1024 * 1024) / dBytesPerProbe;
+    if (dProbes < 1) {return 1;}
+    if (dProbes > std::numeric_limits<int>::max()) {return std::numeric_limits<int>::max();}
+    return (unsigned int)dProbes;
+}
+
+void CNReferenceIntensityBlock::setup(affx::File5_Tsv** pptsv5, unsigned int uiCelCount, unsigned int uiBlockSize)
+{
+    if (uiCelCount == 0) {Err::errAbort("CNReferenceIntensityBlock: No intensity tables to read.");}
+    if (uiBlockSize == 0) {uiBlockSize = 1;}
+    m_vTsvs.assign(pptsv5, pptsv5 + uiCelCount);
+    m_uiCelCount = uiCelCount;
+    m_uiBlockSize = uiBlockSize;
+    m_uiProbeCount = 0;
+    int iLineCount = m_vTsvs[0]->getLineCount();
+    for (unsigned int uiCelIndex = 0; (uiCelIndex < m_uiCelCount); uiCelIndex++)
+    {
+        affx::File5_Tsv* tsv5 = m_vTsvs[uiCelIndex];
+        if (tsv5->getLineCount() != iLineCount)
+        {
+            Err::errAbort("CNReferenceIntensityBlock: Intensities table " + ToStr(uiCelIndex) + " has " + ToStr(tsv5->getLineCount()) + " lines, expected " + ToStr(iLineCount) + ".");
+        }
+        if (tsv5->getColumnDtype(0, 3) != affx::FILE5_DTYPE_FLOAT)
+        {
+            Err::errAbort("CNReferenceIntensityBlock: Intensities table " + ToStr(uiCelIndex) + " has no float Intensity column.");
+        }
+    }
+    m_uiLineCount = (iLineCount < 0) ? 0 : iLineCount;
+    unsigned int uiSize = std::min(m_uiBlockSize, m_uiLineCount);
+    m_vProbeSetIndexes.resize(uiSize);
+    m_vAlleles.resize(uiSize);
+    m_vProbeIDs.resize(uiSize);
+    m_vCelMajor.resize((size_t)uiSize * m_uiCelCount);
+    m_vIntensities.resize((size_t)uiSize * m_uiCelCount);
+    m_vScratch.resize(m_uiCelCount);
+}
+
+unsigned int CNReferenceIntensityBlock::read(unsigned int uiFirstLine)
+{
+    if (uiFirstLine >= m_uiLineCount)
+    {
+        Err::errAbort("CNReferenceIntensityBlock: Line " + ToStr(uiFirstLine) + " is past the end of the " + ToStr(m_uiLineCount) + " line intensities tables.");
+    }
+    unsigned int uiCount = std::min(m_uiBlockSize, m_uiLineCount - uiFirstLine);
+    // The probes are in the same order in every table, so take them from the first.
+    affx::File5_Tsv* tsv5 = m_vTsvs[0];
+    tsv5->readColumn(0, 0, uiFirstLine, uiCount, &m_vProbeSetIndexes[0]);
+    tsv5->readColumn(0, 1, uiFirstLine, uiCount, &m_vAlleles[0]);
+    tsv5->readColumn(0, 2, uiFirstLine, uiCount, &m_vProbeIDs[0]);
+    for (unsigned int uiCelIndex = 0; (uiCelIndex < m_uiCelCount); uiCelIndex++)
+    {
+        int iRead = m_vTsvs[uiCelIndex]->readColumn(0, 3, uiFirstLine, uiCount, &m_vCelMajor[(size_t)uiCelIndex * uiCount]);
+        if (iRead != (int)uiCount)
+        {
+            Err::errAbort("CNReferenceIntensityBlock: Read " + ToStr(iRead) + " of " + ToStr(uiCount) + " intensities from table " + ToStr(uiCelIndex) + ".");
+        }
+    }
+    transpose(&m_vCelMajor[0], m_uiCelCount, uiCount, &m_vIntensities[0]);
+    m_uiProbeCount = uiCount;
+    return uiCount;
+}
+
+float CNReferenceIntensityBlock::median(unsigned int uiProbe)
+{
+    const float* pf = getIntensities(uiProbe);
+    std::copy(pf, pf + m_uiCelCount, m_vScratch.begin());
+    return median(&m_vScratch[0], m_uiCelCount);
+}
+
+float CNReferenceIntensityBlock::median(float* pfValues, unsigned int uiCount)
+{
+    float* pfEnd = std::remove_if(pfValues, pfValues + uiCount, isNaN);
+    int iLength = (int)(pfEnd - pfValues);
+    if (iLength == 0) {return std::numeric_limits<float>::quiet_NaN();}
+    float* pfMiddle = pfValues + (iLength / 2);
+    if ((iLength % 2) == 0)
+    {
+        // The lower middle, then the smallest value above it.
+        float* pfLow = pfMiddle - 1;
+        std::nth_element(pfValues, pfLow, pfEnd);
+        float fHigh = *std::min_element(pfMiddle, pfEnd);
+        return (float)(*pfLow + (fHigh - *pfLow)/2.0);
+    }
+    std::nth_element(pfValues, pfMiddle, pfEnd);
+    return *pfMiddle;
+}
+
+void CNReferenceIntensityBlock::transpose(const float* pfIn, unsigned int uiRows, unsigned int uiCols, float* pfOut)
+{
+    for (unsigned int uiRowStart = 0; (uiRowStart < uiRows); uiRowStart += CNREFERENCEINTENSITYBLOCK_TILE)
+    {
+        unsigned int uiRowEnd = std::min(uiRowStart + CNREFERENCEINTENSITYBLOCK_TILE, uiRows);
+        for (unsigned int uiColStart = 0; (uiColStart < uiCols); uiColStart += CNREFERENCEINTENSITYBLOCK_TILE)
+        {
+            unsigned int uiColEnd = std::min(uiColStart + CNREFERENCEINTENSITYBLOCK_TILE, uiCols);
+            for (unsigned int uiRow = uiRowStart; (uiRow < uiRowEnd); uiRow++)
+            {
+                const float* pfRow = pfIn + ((size_t)uiRow * uiCols);
+                for (unsigned int uiCol = uiColStart; (uiCol < uiColEnd); uiCol++)
+                {
+                    pfOut[((size_t)uiCol * uiRows) + uiRow] = pfRow[uiCol];
+                }
+            }
+        }
+    }
+}
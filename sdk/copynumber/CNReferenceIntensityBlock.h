@@ -0,0 +1,140 @@
+////////////////////////////////////////////////////////////////
+//
+// Copyright (C) 2011 Affymetrix, Inc.
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License (version 2) as
+// published by the Free Software Foundation.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program;if not, write to the
+//
+// Free Software Foundation, Inc.,
+// 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+//
+////////////////////////////////////////////////////////////////
+
+#ifndef _CNReferenceIntensityBlock_H_
+#define _CNReferenceIntensityBlock_H_
+/**
+ * @file CNReferenceIntensityBlock.h
+ *
+ * @brief This header contains the CNReferenceIntensityBlock class definition.
+ */
+
+#include "file5/File5.h"
+//
+#include <vector>
+//
+
+/// Default memory for one block of intensities, in megabytes.
+#define CNREFERENCEINTENSITYBLOCK_MEGABYTES 32
+/// Side of the square tiles the block is transposed in.
+#define CNREFERENCEINTENSITYBLOCK_TILE 32
+
+/**
+ * @brief Reads the per cel "Intensities-<n>" tables of the reference
+ * build a block of probes at a time, probe by probe.
+ *
+ * Each cel's table holds the ProbeSetIndex, Allele, ProbeID and Intensity
+ * columns, with the probes in the same order in every table. Reading a
+ * line from each table in turn for every probe jumps between thousands of
+ * HDF5 datasets. Here each cel's intensities for a block of probes are
+ * read in one go, and the block is then transposed in cache sized tiles
+ * so each probe's intensities over the cels lie next to each other.
+ */
+class CNReferenceIntensityBlock
+{
+private:
+    /// The tables, one per cel. Not owned.
+    std::vector<affx::File5_Tsv*> m_vTsvs;
+    unsigned int m_uiCelCount;
+    /// The most probes read into a block.
+    unsigned int m_uiBlockSize;
+    /// The number of lines in each table.
+    unsigned int m_uiLineCount;
+    /// The number of probes in the block read last.
+    unsigned int m_uiProbeCount;
+
+    std::vector<int> m_vProbeSetIndexes;
+    std::vector<int> m_vAlleles;
+    std::vector<int> m_vProbeIDs;
+    /// The intensities as read, cel by cel.
+    std::vector<float> m_vCelMajor;
+    /// The intensities transposed, probe by probe.
+    std::vector<float> m_vIntensities;
+    /// Work space for the medians.
+    std::vector<float> m_vScratch;
+
+public:
+    CNReferenceIntensityBlock();
+
+    /**
+     * @brief The number of probes in a block which fits in the given memory.
+     * @param unsigned int - The number of cels.
+     * @param unsigned int - The memory in megabytes.
+     * @return unsigned int - The number of probes, at least one.
+     */
+    static unsigned int getBlockSize(unsigned int uiCelCount, unsigned int uiMegabytes = CNREFERENCEINTENSITYBLOCK_MEGABYTES);
+
+    /**
+     * @brief Setup the tables to read. They must all have the same number of lines.
+     * @param affx::File5_Tsv** - The open tables, one per cel.
+     * @param unsigned int - The number of cels.
+     * @param unsigned int - The most probes to read into a block.
+     */
+    void setup(affx::File5_Tsv** pptsv5, unsigned int uiCelCount, unsigned int uiBlockSize);
+
+    unsigned int getLineCount() const {return m_uiLineCount;}
+    unsigned int getCelCount() const {return m_uiCelCount;}
+    unsigned int getProbeCount() const {return m_uiProbeCount;}
+
+    /**
+     * @brief Read the block of probes starting at the given line.
+     * @param unsigned int - The line of the first probe in the block.
+     * @return unsigned int - The number of probes read.
+     */
+    unsigned int read(unsigned int uiFirstLine);
+
+    /// The ProbeSetIndex, Allele and ProbeID of a probe in the block (from the first cel).
+    int getProbeSetIndex(unsigned int uiProbe) const {return m_vProbeSetIndexes[uiProbe];}
+    char getAllele(unsigned int uiProbe) const {return (char)m_vAlleles[uiProbe];}
+    int getProbeID(unsigned int uiProbe) const {return m_vProbeIDs[uiProbe];}
+
+    /// The intensities of a probe in the block, one per cel.
+    const float* getIntensities(unsigned int uiProbe) const {return &m_vIntensities[uiProbe * m_uiCelCount];}
+
+    /**
+     * @brief The median intensity of a probe in the block, NaN left out.
+     * @param unsigned int - The probe in the block.
+     * @return float - The same value AffxMultiDimensionalArray<float>::median() gives.
+     */
+    float median(unsigned int uiProbe);
+
+    /**
+     * @brief The median of some values, NaN left out, found by selection.
+     * The values are reordered.
+     * @param float* - The values.
+     * @param unsigned int - The number of values.
+     * @return float - The same value AffxMultiDimensionalArray<float>::median() gives.
+     */
+    static float median(float* pfValues, unsigned int uiCount);
+
+    /**
+     * @brief Transpose a row major matrix in square tiles.
+     * @param const float* - The rows by cols matrix.
+     * @param unsigned int - The number of rows.
+     * @param unsigned int - The number of cols.
+     * @param float* - The cols by rows result.
+     */
+    static void transpose(const float* pfIn, unsigned int uiRows, unsigned int uiCols, float* pfOut);
+};
+
+#endif
+
+
@@ -181,6 +181,58 @@ AffxString CNReporter::prepareAscii(const AffxString& str, int iLength)
   return strPrepared;
 }
 
+CNReporterChunk::CNReporterChunk(affymetrix_calvin_io::DataSetWriter& objSet, int iRowSize, int iChunkBytes) : m_objSet(objSet)
+{
+  m_iRowSize = iRowSize;
+  m_iChunkRowCount = getChunkRowCount(iRowSize, (objSet.GetDataSetSize() / iRowSize), iChunkBytes);
+  // One row of slack, so a row loaded past its size is caught in endRow() rather than overrunning the buffer.
+  m_pBuffer = new char[(m_iChunkRowCount + 1) * iRowSize];
+  m_iRowCount = 0;
+  m_iIndex = 0;
+  m_iRowStart = 0;
+  m_iBytesWritten = 0;
+}
+
+CNReporterChunk::~CNReporterChunk()
+{
+  delete[] m_pBuffer;
+}
+
+int CNReporterChunk::getChunkRowCount(int iRowSize, int iRowCount, int iChunkBytes)
+{
+  int iChunkRowCount = Min((iChunkBytes / iRowSize), iRowCount);
+  return Max(iChunkRowCount, 1);
+}
+
+void CNReporterChunk::flush()
+{
+  if (m_iIndex > 0) {m_objSet.WriteBuffer(m_pBuffer, m_iIndex);}
+  m_iBytesWritten += m_iIndex;
+  m_iRowCount = 0;
+  m_iIndex = 0;
+  m_iRowStart = 0;
+}
+
+void CNReporterChunk::endRow()
+{
+  if ((m_iIndex - m_iRowStart) != m_iRowSize)
+  {
+    Err::errAbort("CNReporterChunk: Row of " + ::getInt(m_iIndex - m_iRowStart) + " bytes does not match the data set row size of " + ::getInt(m_iRowSize) + " bytes.");
+  }
+  m_iRowStart = m_iIndex;
+  m_iRowCount++;
+  if (m_iRowCount >= m_iChunkRowCount) {flush();}
+}
+
+void CNReporterChunk::close()
+{
+  flush();
+  if (m_iBytesWritten != m_objSet.GetDataSetSize())
+  {
+    Err::errAbort("CNReporterChunk: Wrote " + ::getInt(m_iBytesWritten / m_iRowSize) + " rows to data set " + StringUtils::ConvertWCSToMBS(m_objSet.GetDataSetName()) + " sized for " + ::getInt(m_objSet.GetDataSetSize() / m_iRowSize) + ".");
+  }
+}
+
 /**
  * @brief Return the array name
  * @return AffxString - The array name
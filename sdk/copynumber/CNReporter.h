@@ -49,6 +49,9 @@
 
 using namespace std;
 
+/// The most a reporter buffers of a data set before writing it to disk, in bytes.
+#define CNREPORTER_CHUNK_BYTES 1048576
+
 class CNReporterMethod : public CNAnalysisMethod
 {
 protected:
@@ -128,6 +131,56 @@ public:
 
 };
 
+/**
+ * @brief  Fixed size rows of one Calvin data set, written to disk a chunk at a time.
+ *
+ * The data set header is sized from the row count before any row is written,
+ * so the buffer only ever holds one chunk, and the rows must add up to the size
+ * the header declares or the data sets after it would be misplaced.
+ */
+class CNReporterChunk
+{
+private:
+  affymetrix_calvin_io::DataSetWriter& m_objSet;
+  char* m_pBuffer;
+  int m_iRowSize;
+  int m_iChunkRowCount;
+  int m_iRowCount;
+  int m_iIndex;
+  int m_iRowStart;
+  int m_iBytesWritten;
+
+  void flush();
+
+public:
+  /**
+   * @brief Constructor
+   * @param affymetrix_calvin_io::DataSetWriter& - The data set to write, with its header already written
+   * @param int - The row size in bytes
+   * @param int - The chunk size in bytes
+   */
+  CNReporterChunk(affymetrix_calvin_io::DataSetWriter& objSet, int iRowSize, int iChunkBytes = CNREPORTER_CHUNK_BYTES);
+  ~CNReporterChunk();
+
+  /// The buffer and index to load the current row into with CNReporter::loadBuffer.
+  char* getBuffer() {return m_pBuffer;}
+  int& getIndex() {return m_iIndex;}
+
+  /// Finish the current row, writing the chunk out when it is full.
+  void endRow();
+  /// Write the last partial chunk and check the data set is complete.
+  void close();
+
+  /**
+   * @brief The number of rows to buffer at a time
+   * @param int - The row size in bytes
+   * @param int - The row count of the data set
+   * @param int - The chunk size in bytes
+   * @return int - The rows per chunk, at least one and at most the row count
+   */
+  static int getChunkRowCount(int iRowSize, int iRowCount, int iChunkBytes);
+};
+
 struct wavSortCriterion : binary_function<pair<int, float>, pair<int, float>, bool>
 {
     bool operator()(const pair<int, float>& lhs, const pair<int, float>& rhs) const {
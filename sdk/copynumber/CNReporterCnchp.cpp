@@ -391,16 +391,13 @@ void CNReporterCnchp::run()
         {
             float fMinLog2Ratio = 1000000;
             float fMaxLog2Ratio = -1000000;
-            int iProbeSetCount = 0;
-            for (int iIndex = 0; (iIndex < (int)getProbeSets()->size()); iIndex++)
+            std::pair<int, int> bounds = getProbeSets()->getChromosomeBounds(iChromosome);
+            int iProbeSetCount = bounds.second - bounds.first;
+            for (int iIndex = bounds.first; (iIndex < bounds.second); iIndex++)
             {
                 CNProbeSet* pobjProbeSet = getProbeSets()->at(iIndex);
-                if (pobjProbeSet->getChromosome() == iChromosome)
-                {
-                    fMinLog2Ratio = Min(fMinLog2Ratio, pobjProbeSet->getLog2Ratio());
-                    fMaxLog2Ratio = Max(fMaxLog2Ratio, pobjProbeSet->getLog2Ratio());
-                    iProbeSetCount++;
-                }
+                fMinLog2Ratio = Min(fMinLog2Ratio, pobjProbeSet->getLog2Ratio());
+                fMaxLog2Ratio = Max(fMaxLog2Ratio, pobjProbeSet->getLog2Ratio());
             }
             if (iProbeSetCount > 0)
             {
@@ -430,17 +427,9 @@ void CNReporterCnchp::run()
         affymetrix_calvin_io::DataSetHeader* pobjDataSetHeader = objChpData.GetDataSetHeader(affymetrix_calvin_io::CopyNumberMultiDataType);
         for (int iChromosome = 0; iChromosome <= iMaxChromosome; iChromosome++)
         {
-            int iStartIndex = -1;
-            int iProbeSetCount = 0;
-            for (int iIndex = 0; (iIndex < (int)getProbeSets()->size()); iIndex++)
-            {
-                CNProbeSet* pobjProbeSet = getProbeSets()->at(iIndex);
-                if (pobjProbeSet->getChromosome() == iChromosome)
-                {
-                    if (iStartIndex == -1) {iStartIndex = iIndex;}
-                    iProbeSetCount++;
-                }
-            }
+            std::pair<int, int> bounds = getProbeSets()->getChromosomeBounds(iChromosome);
+            int iStartIndex = bounds.first;
+            int iProbeSetCount = bounds.second - bounds.first;
             if (iProbeSetCount > 0)
             {
                 std::wstring wstr = StringUtils::ConvertMBSToWCS(::getInt(iChromosome));
@@ -489,6 +478,7 @@ void CNReporterCnchp::run()
         maxLen[affymetrix_calvin_io::CopyNumberMultiDataType] = iMaxProbeSetNameLength + 1;
         std::vector<std::string> chpFiles;
         chpFiles.push_back(strFileName);
+        bufferWriter.SetMaxBufferSize(CNREPORTER_CHUNK_BYTES);
         bufferWriter.Initialize(&chpFiles, dataTypes, maxLen);
 
         //objChpWriter.SeekToDataSet(affymetrix_calvin_io::CopyNumberMultiDataType);
@@ -232,13 +232,15 @@ void CNReporterCychp::writeCychpFile(const AffxString& strFileName)
     AffxArray<CNChromosome> arChromosomes;
     loadChromosomes(arChromosomes);
     addChromosomesSummaryDataSetHeader(data.Header().GetDataGroup(0), arChromosomes.getCount());
-    addProbeSetsCopyNumberDataSetHeader(data.Header().GetDataGroup(1), m_pvProbeSets->getCount());
+    // Every header is sized from its row count here, so each data set can be streamed to disk in chunks.
     int iRowCount = 0;
     for (int i = 0; (i < m_pvProbeSets->getCount()); i++)
     {
         CNProbeSet* p = m_pvProbeSets->getAt(i);
         if ((p->getAllelePeaks1() > 0) || (p->getAllelePeaks2() > 0)) {iRowCount++;}
     }
+    // writeProbeSetsCopyNumberDataSet skips the probe sets that are not processed.
+    addProbeSetsCopyNumberDataSetHeader(data.Header().GetDataGroup(1), m_pvProbeSets->getProcessCount());
     addProbeSetsAllelePeaksDataSetHeader(data.Header().GetDataGroup(1), iRowCount);
     int iSnpCount = 0;
     int iVisualizationCount = 0;
@@ -776,36 +778,34 @@ void CNReporterCychp::loadChromosomes(AffxArray<CNChromosome>& arChromosomes)
         int iSnpCount = 0;
         int iHomCount = 0;
         int iHetCount = 0;
+        std::pair<int, int> bounds = getProbeSets()->getChromosomeBounds(iChromosome);
         int iStartIndex = -1;
         float fConfidenceThreshold = CNAnalysisMethod::getConfidenceThreshold(m_pEngine->getOpt("brlmmp-parameters"));
-        for (int iIndex = 0; (iIndex < (int)getProbeSets()->size()); iIndex++)
+        for (int iIndex = bounds.first; (iIndex < bounds.second); iIndex++)
         {
             CNProbeSet* pobjProbeSet = getProbeSets()->at(iIndex);
             if (!pobjProbeSet->isProcess() ) {continue;}
-            if (pobjProbeSet->getChromosome() == iChromosome)
+            if(pobjProbeSet->processAsCN())
             {
-                if(pobjProbeSet->processAsCN())
+                vLog2Ratios.push_back(pobjProbeSet->getLog2Ratio());
+                fMinLog2Ratio = Min(fMinLog2Ratio, pobjProbeSet->getLog2Ratio());
+                fMaxLog2Ratio = Max(fMaxLog2Ratio, pobjProbeSet->getLog2Ratio());
+                iMarkerCount++;
+            }
+            iTotalMarkerCount++;
+            if (iStartIndex == -1) {iStartIndex = iIndex;}
+            if (pobjProbeSet->processAsSNP())
+            {
+                if (isCytoScanHD && (pobjProbeSet->getGenotypeConfidence() >= fConfidenceThreshold)) {continue;}
+                if ((pobjProbeSet->getGenotypeCall() == 0) || (pobjProbeSet->getGenotypeCall() == 2))
                 {
-                    vLog2Ratios.push_back(pobjProbeSet->getLog2Ratio());
-                    fMinLog2Ratio = Min(fMinLog2Ratio, pobjProbeSet->getLog2Ratio());
-                    fMaxLog2Ratio = Max(fMaxLog2Ratio, pobjProbeSet->getLog2Ratio());
-                    iMarkerCount++;
+                    iHomCount++;
                 }
-                iTotalMarkerCount++;
-                if (iStartIndex == -1) {iStartIndex = iIndex;}
-                if (pobjProbeSet->processAsSNP())
+                if (pobjProbeSet->getGenotypeCall() == 1)
                 {
-                    if (isCytoScanHD && (pobjProbeSet->getGenotypeConfidence() >= fConfidenceThreshold)) {continue;}
-                    if ((pobjProbeSet->getGenotypeCall() == 0) || (pobjProbeSet->getGenotypeCall() == 2))
-                    {
-                        iHomCount++;
-                    }
-                    if (pobjProbeSet->getGenotypeCall() == 1)
-                    {
-                        iHetCount++;
-                    }
-                    iSnpCount++;
+                    iHetCount++;
                 }
+                iSnpCount++;
             }
         }
         if (iMarkerCount > 0)
@@ -814,34 +814,31 @@ void CNReporterCychp::loadChromosomes(AffxArray<CNChromosome>& arChromosomes)
             AffxMultiDimensionalArray<float> vCnState(iMarkerCount);
             AffxMultiDimensionalArray<float> vMosaicismMixture(iMarkerCount);
             int iMarkerIndex = 0;
-            for (int iIndex = 0; (iIndex < (int)getProbeSets()->size()); iIndex++)
+            for (int iIndex = bounds.first; (iIndex < bounds.second); iIndex++)
             {
                 CNProbeSet* pobjProbeSet = getProbeSets()->at(iIndex);
                 if (!pobjProbeSet->isProcess() || !pobjProbeSet->processAsCN()) {continue;}
-                if (pobjProbeSet->getChromosome() == iChromosome)
+                vCytoScanLog2Ratios.set(iMarkerIndex, pobjProbeSet->getLog2Ratio());
+                float fCalibratedLog2Ratio = 0.0;
+                if (iChromosome < iXChromosome) {
+                    fCalibratedLog2Ratio = (float)exp(((pobjProbeSet->getLog2Ratio() / alhpaCNCalibrate) + betaCNCalibrate) * log(2.0));
+                }
+                else if (iChromosome == iXChromosome) {
+                    fCalibratedLog2Ratio = (float)exp(((pobjProbeSet->getLog2Ratio() / alhpa_X_CNCalibrate) + beta_X_CNCalibrate) * log(2.0));
+                }
+                else if (iChromosome == iYChromosome) {
+                    fCalibratedLog2Ratio = (float)exp(((pobjProbeSet->getLog2Ratio() / alhpa_Y_CNCalibrate) + beta_Y_CNCalibrate) * log(2.0));
+                }
+                vCnState.set(iMarkerIndex, fCalibratedLog2Ratio);
+                if (!isCytoScanHD && (pobjProbeSet->getMosaicismMixture() == numeric_limits<float>::quiet_NaN()))
                 {
-                    vCytoScanLog2Ratios.set(iMarkerIndex, pobjProbeSet->getLog2Ratio());
-                    float fCalibratedLog2Ratio = 0.0;
-                    if (iChromosome < iXChromosome) {
-                        fCalibratedLog2Ratio = (float)exp(((pobjProbeSet->getLog2Ratio() / alhpaCNCalibrate) + betaCNCalibrate) * log(2.0));
-                    }
-                    else if (iChromosome == iXChromosome) {
-                        fCalibratedLog2Ratio = (float)exp(((pobjProbeSet->getLog2Ratio() / alhpa_X_CNCalibrate) + beta_X_CNCalibrate) * log(2.0));
-                    }
-                    else if (iChromosome == iYChromosome) {
-                        fCalibratedLog2Ratio = (float)exp(((pobjProbeSet->getLog2Ratio() / alhpa_Y_CNCalibrate) + beta_Y_CNCalibrate) * log(2.0));
-                    }
-                    vCnState.set(iMarkerIndex, fCalibratedLog2Ratio);
-                    if (!isCytoScanHD && (pobjProbeSet->getMosaicismMixture() == numeric_limits<float>::quiet_NaN()))
-                    {
-                        vMosaicismMixture.set(iMarkerIndex, 0);
-                    }
-                    else
-                    {
-                        vMosaicismMixture.set(iMarkerIndex, pobjProbeSet->getMosaicismMixture());
-                    }
-                    iMarkerIndex++;
+                    vMosaicismMixture.set(iMarkerIndex, 0);
                 }
+                else
+                {
+                    vMosaicismMixture.set(iMarkerIndex, pobjProbeSet->getMosaicismMixture());
+                }
+                iMarkerIndex++;
             }
             CNChromosome* p = new CNChromosome;
             p->m_ucChromosome = (unsigned char)iChromosome;
@@ -1071,10 +1068,10 @@ void CNReporterCychp::writeChromosomesSummaryDataSet(  affymetrix_calvin_io::Gen
     iSize += sizeof(float);
     iSize += sizeof(float);
     iSize += sizeof(float);
-    int iStructCount = 100000;
-    char* pBuffer = new char[iSize * iStructCount];
-    int iIndex = 0;
-    int iCount = 0;
+    iSize += sizeof(float);
+    CNReporterChunk objChunk(set, iSize);
+    char* pBuffer = objChunk.getBuffer();
+    int& iIndex = objChunk.getIndex();
     AffxString str;
     for (int iChromosomeIndex = 0; (iChromosomeIndex < arChromosomes.getCount()); iChromosomeIndex++)
     {
@@ -1093,16 +1090,9 @@ void CNReporterCychp::writeChromosomesSummaryDataSet(  affymetrix_calvin_io::Gen
         loadBuffer(pBuffer, iIndex, p->m_fChromosomeLOH);
         loadBuffer(pBuffer, iIndex, p->m_fMedianSignal);
 
-        iCount++;
-        if (iCount >= iStructCount)
-        {
-            set.WriteBuffer(pBuffer, iIndex);
-            iCount = 0;
-            iIndex = 0;
-        }
+        objChunk.endRow();
     }
-    if (iCount > 0) {set.WriteBuffer(pBuffer, iIndex);}
-    delete[] pBuffer;
+    objChunk.close();
 }
 
 void CNReporterCychp::writeProbeSetsCopyNumberDataSet( affymetrix_calvin_io::GenericFileWriter* pWriter,
@@ -1125,10 +1115,9 @@ void CNReporterCychp::writeProbeSetsCopyNumberDataSet( affymetrix_calvin_io::Gen
     iSize += sizeof(float);
     iSize += sizeof(float);
     iSize += sizeof(float);
-    int iStructCount = 100000;
-    char* pBuffer = new char[iSize * iStructCount];
-    int iIndex = 0;
-    int iCount = 0;
+    CNReporterChunk objChunk(set, iSize);
+    char* pBuffer = objChunk.getBuffer();
+    int& iIndex = objChunk.getIndex();
     AffxString str;
     for (int iProbeSetIndex = 0; (iProbeSetIndex < arProbeSets.getCount()); iProbeSetIndex++)
     {
@@ -1143,7 +1132,6 @@ void CNReporterCychp::writeProbeSetsCopyNumberDataSet( affymetrix_calvin_io::Gen
                 loadBuffer(pBuffer, iIndex, numeric_limits<float>::quiet_NaN());
                 loadBuffer(pBuffer, iIndex, numeric_limits<float>::quiet_NaN());
                 loadBuffer(pBuffer, iIndex, numeric_limits<float>::quiet_NaN());
-                iCount++;
         }
         else
         {
@@ -1165,18 +1153,10 @@ void CNReporterCychp::writeProbeSetsCopyNumberDataSet( affymetrix_calvin_io::Gen
                 else {
                     loadBuffer(pBuffer, iIndex, (float)0.0);
                 }
-
-                iCount++;
-        }
-        if (iCount >= iStructCount)
-        {
-            set.WriteBuffer(pBuffer, iIndex);
-            iCount = 0;
-            iIndex = 0;
         }
+        objChunk.endRow();
     }
-    if (iCount > 0) {set.WriteBuffer(pBuffer, iIndex);}
-    delete[] pBuffer;
+    objChunk.close();
 }
 
 void CNReporterCychp::writeAlgorthmDataMarkerABSignalDataSet(  affymetrix_calvin_io::GenericFileWriter* pWriter,
@@ -1197,10 +1177,9 @@ void CNReporterCychp::writeAlgorthmDataMarkerABSignalDataSet(  affymetrix_calvin
         iSize += sizeof(float);
     }
     iSize += sizeof(float);
-    int iStructCount = 100000;
-    char* pBuffer = new char[iSize * iStructCount];
-    int iIndex = 0;
-    int iCount = 0;
+    CNReporterChunk objChunk(set, iSize);
+    char* pBuffer = objChunk.getBuffer();
+    int& iIndex = objChunk.getIndex();
     unsigned int uiIndex = 0;
     for (int iProbeSetIndex = 0; (iProbeSetIndex < arProbeSets.getCount()); iProbeSetIndex++)
     {
@@ -1217,18 +1196,11 @@ void CNReporterCychp::writeAlgorthmDataMarkerABSignalDataSet(  affymetrix_calvin
                 loadBuffer(pBuffer, iIndex, p->getAllelicDifference());
             }
 
-            iCount++;
-            if (iCount >= iStructCount)
-            {
-                set.WriteBuffer(pBuffer, iIndex);
-                iCount = 0;
-                iIndex = 0;
-            }
+            objChunk.endRow();
         }
         uiIndex++;
     }
-    if (iCount > 0) {set.WriteBuffer(pBuffer, iIndex);}
-    delete[] pBuffer;
+    objChunk.close();
 }
 
 void CNReporterCychp::writeProbeSetsAllelePeaksDataSet(    affymetrix_calvin_io::GenericFileWriter* pWriter,
@@ -1249,10 +1221,9 @@ void CNReporterCychp::writeProbeSetsAllelePeaksDataSet(    affymetrix_calvin_io:
     iSize += sizeof(unsigned int);
     iSize += sizeof(unsigned int);
     iSize += sizeof(unsigned int);
-    int iStructCount = 100000;
-    char* pBuffer = new char[iSize * iStructCount];
-    int iIndex = 0;
-    int iCount = 0;
+    CNReporterChunk objChunk(set, iSize);
+    char* pBuffer = objChunk.getBuffer();
+    int& iIndex = objChunk.getIndex();
     AffxString str;
     for (int i = 0; (i < m_pvProbeSets->getCount()); i++)
     {
@@ -1266,17 +1237,10 @@ void CNReporterCychp::writeProbeSetsAllelePeaksDataSet(    affymetrix_calvin_io:
             CNReporter::loadBuffer(pBuffer, iIndex, p->getAllelePeaks1());
             CNReporter::loadBuffer(pBuffer, iIndex, p->getAllelePeaks2());
 
-            iCount++;
-            if (iCount >= iStructCount)
-            {
-                set.WriteBuffer(pBuffer, iIndex);
-                iCount = 0;
-                iIndex = 0;
-            }
+            objChunk.endRow();
         }
     }
-    if (iCount > 0) {set.WriteBuffer(pBuffer, iIndex);}
-    delete[] pBuffer;
+    objChunk.close();
 }
 
 void CNReporterCychp::writeSegmentsDataSet(     affymetrix_calvin_io::GenericFileWriter* pWriter,
@@ -1314,10 +1278,9 @@ void CNReporterCychp::writeSegmentsDataSet(     affymetrix_calvin_io::GenericFil
         iSize += sizeof(float);
         iSize += sizeof(float);
     }
-    int iStructCount = 100000;
-    char* pBuffer = new char[iSize * iStructCount];
-    int iIndex = 0;
-    int iCount = 0;
+    CNReporterChunk objChunk(set, iSize);
+    char* pBuffer = objChunk.getBuffer();
+    int& iIndex = objChunk.getIndex();
     for (int iSegmentIndex = 0; (iSegmentIndex < arSegments.getCount()); iSegmentIndex++)
     {
         CNSegment* p = arSegments.getAt(iSegmentIndex);
@@ -1348,17 +1311,10 @@ void CNReporterCychp::writeSegmentsDataSet(     affymetrix_calvin_io::GenericFil
                 loadBuffer(pBuffer, iIndex, tmp);
             }
 
-            iCount++;
-            if (iCount >= iStructCount)
-            {
-                set.WriteBuffer(pBuffer, iIndex);
-                iCount = 0;
-                iIndex = 0;
-            }
+            objChunk.endRow();
         }
     }
-    if (iCount > 0) {set.WriteBuffer(pBuffer, iIndex);}
-    delete[] pBuffer;
+    objChunk.close();
 }
 
 void CNReporterCychp::writeGenInfoDataSet(    affymetrix_calvin_io::GenericFileWriter* pWriter,
@@ -1379,10 +1335,9 @@ void CNReporterCychp::writeGenInfoDataSet(    affymetrix_calvin_io::GenericFileW
     iSize += sizeof(float);
     iSize += sizeof(float);
     iSize += sizeof(float);
-    int iStructCount = 100000;
-    char* pBuffer = new char[iSize * iStructCount];
-    int iIndex = 0;
-    int iCount = 0;
+    CNReporterChunk objChunk(set, iSize);
+    char* pBuffer = objChunk.getBuffer();
+    int& iIndex = objChunk.getIndex();
     unsigned int uiIndex = 0;
     float fConfidenceThreshold = CNAnalysisMethod::getConfidenceThreshold(m_pEngine->getOpt("brlmmp-parameters"));
 
@@ -1408,16 +1363,9 @@ void CNReporterCychp::writeGenInfoDataSet(    affymetrix_calvin_io::GenericFileW
             loadBuffer(pBuffer, iIndex, p->getSignalStrengthMvA());
             loadBuffer(pBuffer, iIndex, p->getSignalContrastMvA());
 
-            iCount++;
-            if (iCount >= iStructCount)
-            {
-                set.WriteBuffer(pBuffer, iIndex);
-                iCount = 0;
-                iIndex = 0;
-            }
+            objChunk.endRow();
         }
         uiIndex++;
     }
-    if (iCount > 0) {set.WriteBuffer(pBuffer, iIndex);}
-    delete[] pBuffer;
+    objChunk.close();
 }
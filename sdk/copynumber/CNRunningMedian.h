@@ -0,0 +1,245 @@
+////////////////////////////////////////////////////////////////
+//
+// Copyright (C) 2011 Affymetrix, Inc.
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License (version 2) as
+// published by the Free Software Foundation.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program;if not, write to the
+//
+// Free Software Foundation, Inc.,
+// 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+//
+////////////////////////////////////////////////////////////////
+
+#ifndef _CNRunningMedian_H_
+#define _CNRunningMedian_H_
+/**
+ * @file CNRunningMedian.h
+ *
+ * @brief This header contains the CNRunningMedian class definition.
+ */
+
+#include "util/Err.h"
+#include "util/Util.h"
+//
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <vector>
+//
+
+/// Windows up to this size are kept sorted rather than in a Fenwick tree.
+#define CNRUNNINGMEDIAN_SMALL_WINDOW 64
+
+/**
+ * @brief Medians and percentiles of a window sliding along a vector of values.
+ *
+ * The values are ranked once by setup(). A Fenwick tree over the ranks
+ * holds the values in the window, so add(), remove() and the order
+ * statistics each take O(log n) instead of the O(w log w) of sorting
+ * the window again at every position. Windows of up to
+ * CNRUNNINGMEDIAN_SMALL_WINDOW values are kept in a sorted vector
+ * instead, which is quicker for them and needs no ranking.
+ *
+ * NaN values are left out of the window, as AffxMultiDimensionalArray::median()
+ * leaves them out. The results are the same values the sorting gives.
+ */
+template<typename TYPE> class CNRunningMedian
+{
+private:
+    /// The values given to setup().
+    const std::vector<TYPE>* m_pValues;
+    /// The values in the window in order, for small windows.
+    std::vector<TYPE> m_vWindow;
+    /// True if the window is kept in m_vWindow rather than the Fenwick tree.
+    bool m_bSmall;
+    /// The values given to setup() in rank order, NaN left out.
+    std::vector<TYPE> m_vSorted;
+    /// The rank of each value, -1 for NaN.
+    std::vector<int> m_vRanks;
+    /// 1 based Fenwick tree of the number of values in the window at each rank.
+    std::vector<int> m_vTree;
+    /// The largest power of two not above the number of ranks.
+    int m_iTopBit;
+    /// Values in the window, NaN not counted.
+    int m_iCount;
+    /// NaN and infinite values in the window.
+    int m_iNonFiniteCount;
+
+    /// Orders the indexes by value, ties by index, so the ranks are unique.
+    class RankCompare
+    {
+    public:
+        const std::vector<TYPE>& m_vValues;
+        RankCompare(const std::vector<TYPE>& vValues) : m_vValues(vValues) {}
+        bool operator()(int i1, int i2) const
+        {
+            if (m_vValues[i1] < m_vValues[i2]) {return true;}
+            if (m_vValues[i2] < m_vValues[i1]) {return false;}
+            return (i1 < i2);
+        }
+    };
+
+    static bool isNaN(TYPE t) {return (t != t);}
+    static bool isNonFinite(TYPE t) {return ((t != t) || (t == std::numeric_limits<TYPE>::infinity()) || (t == -std::numeric_limits<TYPE>::infinity()));}
+
+    void update(int iRank, int iDelta)
+    {
+        for (int i = (iRank + 1); (i < (int)m_vTree.size()); i += (i & (-i))) {m_vTree[i] += iDelta;}
+    }
+
+public:
+    CNRunningMedian() : m_pValues(NULL), m_bSmall(false), m_iTopBit(0), m_iCount(0), m_iNonFiniteCount(0) {}
+
+    /**
+     * @brief Setup the values the window will slide along. The window starts empty.
+     * @param const std::vector<TYPE>& - The values, which must be kept until we are done.
+     * @param int - The most values the window will hold.
+     */
+    void setup(const std::vector<TYPE>& vValues, int iWindowSize)
+    {
+        m_pValues = &vValues;
+        m_iCount = 0;
+        m_iNonFiniteCount = 0;
+        m_bSmall = (iWindowSize <= CNRUNNINGMEDIAN_SMALL_WINDOW);
+        if (m_bSmall)
+        {
+            m_vWindow.clear();
+            m_vWindow.reserve(iWindowSize);
+            return;
+        }
+        int iValueCount = (int)vValues.size();
+        std::vector<int> vIndexes;
+        vIndexes.reserve(iValueCount);
+        for (int iIndex = 0; (iIndex < iValueCount); iIndex++)
+        {
+            if (!isNaN(vValues[iIndex])) {vIndexes.push_back(iIndex);}
+        }
+        std::sort(vIndexes.begin(), vIndexes.end(), RankCompare(vValues));
+        m_vSorted.resize(vIndexes.size());
+        m_vRanks.assign(iValueCount, -1);
+        for (int iRank = 0; (iRank < (int)vIndexes.size()); iRank++)
+        {
+            m_vSorted[iRank] = vValues[vIndexes[iRank]];
+            m_vRanks[vIndexes[iRank]] = iRank;
+        }
+        m_vTree.assign(vIndexes.size() + 1, 0);
+        m_iTopBit = 1;
+        while ((m_iTopBit * 2) <= (int)vIndexes.size()) {m_iTopBit *= 2;}
+    }
+
+    /**
+     * @brief Add a value to the window.
+     * @param int - The index of the value in the vector given to setup().
+     */
+    void add(int iIndex)
+    {
+        if (m_bSmall)
+        {
+            TYPE t = (*m_pValues)[iIndex];
+            if (isNonFinite(t)) {m_iNonFiniteCount++;}
+            if (isNaN(t)) {return;}
+            m_vWindow.insert(std::upper_bound(m_vWindow.begin(), m_vWindow.end(), t), t);
+            m_iCount++;
+            return;
+        }
+        int iRank = m_vRanks[iIndex];
+        if (iRank < 0) {m_iNonFiniteCount++; return;}
+        if (isNonFinite(m_vSorted[iRank])) {m_iNonFiniteCount++;}
+        update(iRank, 1);
+        m_iCount++;
+    }
+
+    /**
+     * @brief Remove a value from the window. It must have been added.
+     * @param int - The index of the value in the vector given to setup().
+     */
+    void remove(int iIndex)
+    {
+        if (m_bSmall)
+        {
+            TYPE t = (*m_pValues)[iIndex];
+            if (isNonFinite(t)) {m_iNonFiniteCount--;}
+            if (isNaN(t)) {return;}
+            m_vWindow.erase(std::lower_bound(m_vWindow.begin(), m_vWindow.end(), t));
+            m_iCount--;
+            return;
+        }
+        int iRank = m_vRanks[iIndex];
+        if (iRank < 0) {m_iNonFiniteCount--; return;}
+        if (isNonFinite(m_vSorted[iRank])) {m_iNonFiniteCount--;}
+        update(iRank, -1);
+        m_iCount--;
+    }
+
+    /// The number of values in the window, NaN not counted.
+    int getCount() const {return m_iCount;}
+
+    /// The number of NaN and infinite values in the window.
+    int getNonFiniteCount() const {return m_iNonFiniteCount;}
+
+    /**
+     * @brief The k-th smallest value in the window.
+     * @param int - The zero based order, less than getCount().
+     * @return TYPE - The value.
+     */
+    TYPE getOrderStatistic(int k) const
+    {
+        if ((k < 0) || (k >= m_iCount)) {Err::errAbort("CNRunningMedian: order statistic " + ToStr(k) + " is not in a window of " + ToStr(m_iCount) + " values.");}
+        if (m_bSmall) {return m_vWindow[k];}
+        int iPosition = 0;
+        for (int iBit = m_iTopBit; (iBit > 0); iBit /= 2)
+        {
+            int iNext = iPosition + iBit;
+            if ((iNext < (int)m_vTree.size()) && (m_vTree[iNext] <= k))
+            {
+                iPosition = iNext;
+                k -= m_vTree[iNext];
+            }
+        }
+        return m_vSorted[iPosition];
+    }
+
+    /**
+     * @brief The median of the window, the mean of the middle two for an even count.
+     * The same as AffxMultiDimensionalArray::median().
+     * @return TYPE - The median, NaN for an empty window.
+     */
+    TYPE getMedian() const
+    {
+        if (m_iCount == 0) {return std::numeric_limits<TYPE>::quiet_NaN();}
+        if ((m_iCount % 2) == 0)
+        {
+            TYPE tLow = getOrderStatistic((m_iCount / 2) - 1);
+            TYPE tHigh = getOrderStatistic(m_iCount / 2);
+            return (TYPE)(tLow + (tHigh - tLow)/2.0);
+        }
+        return getOrderStatistic(m_iCount / 2);
+    }
+
+    /**
+     * @brief A percentile of the window, interpolated between the two nearest values.
+     * The same as AffxMultiDimensionalArray::percentile().
+     * @param double - The percentile from 0 to 1.
+     * @return double - The percentile, NaN for an empty window.
+     */
+    double getPercentile(double dPercentile) const
+    {
+        if (m_iCount == 0) {return std::numeric_limits<double>::quiet_NaN();}
+        double dIndex = ((m_iCount - 1) * dPercentile);
+        double dMultiplier = dIndex - floor(dIndex);
+        TYPE tLow = getOrderStatistic((int)floor(dIndex));
+        TYPE tHigh = getOrderStatistic((int)ceil(dIndex));
+        return tLow + ((tHigh - tLow) * dMultiplier);
+    }
+};
+
+#endif
@@ -63,6 +63,7 @@ CNWorkflowEngine * CNWorkflowEngine::FromBase(BaseEngine *engine)
 CNWorkflowEngine::CNWorkflowEngine()
 {
     m_apgEngine = NULL;
+    m_pHandoff = NULL;
     m_pstdMethods = NULL;
     defineStdMethods();
     defineOptions();
@@ -83,6 +84,7 @@ void CNWorkflowEngine::clear()
 {
     if (m_pstdMethods != NULL) {delete m_pstdMethods; m_pstdMethods = NULL;}
     if (m_apgEngine != NULL) {delete m_apgEngine; m_apgEngine = NULL;}
+    if (m_pHandoff != NULL) {delete m_pHandoff; m_pHandoff = NULL;}
     // Clean up static data.
     CNExperiment::getQCMetricColumnNames()->deleteAll();
     CNAnalysisMethod::getCelFileParams()->clear();
@@ -221,6 +223,14 @@ void CNWorkflowEngine::defineOptions() {
   defineOption("", "disk-cache", PgOpt::INT_OPT,
                "Size of intensity memory cache in millions of intensities (when --use-disk=true).",
                "50");
+  defineOption("", "in-memory-handoff", PgOpt::BOOL_OPT,
+               "Hand the allele summaries, genotype calls and genotype confidences from "
+               "probeset-genotype to the copy number engines in memory rather than through a5 files.",
+               "false");
+  defineOption("", "handoff-mem-usage", PgOpt::INT_OPT,
+               "How many MB of memory the in memory handoff may use before the largest "
+               "tables are written to disk (when --in-memory-handoff=true).",
+               "2000");
 
   defineOptionSection("Advanced Options");
   defineOption("", "run-geno-qc", PgOpt::BOOL_OPT,
@@ -425,6 +435,7 @@ void CNWorkflowEngine::checkOptionsImp() {
   if(getOpt("explain") != "") { explain(); exit(0); }
 
   if (getOpt("out-dir") == "") {error("Must specify an output directory.");}
+  if (getOptInt("handoff-mem-usage") < 0) {error("The handoff-mem-usage must be zero or more.");}
   if (getOpt("temp-dir") == "") {
     setOpt("temp-dir", Fs::join(getOpt("out-dir"),"temp"));
     Fs::ensureWriteableDirPath(getOpt("temp-dir"), false);
@@ -1078,6 +1089,16 @@ void CNWorkflowEngine::callProbesetGenotypeEngine()
 {
     std::vector<std::string> cels = getOptVector("cels");
     m_apgEngine->setOpt("cels", cels);
+    if (getOptBool("in-memory-handoff"))
+    {
+        // The copy number engines are given the handoff and find these tables by their file names.
+        if (m_pHandoff != NULL) {delete m_pHandoff;}
+        m_pHandoff = new CNGenotypeHandoff(getOpt("expr-summary-file"), getOpt("genotype-calls-file"), getOpt("genotype-confidences-file"), getOptInt("handoff-mem-usage"));
+        m_apgEngine->setOpt("a5-summaries", "false");
+        m_apgEngine->setOpt("a5-calls", "false");
+        m_apgEngine->addExternalExprReporter(m_pHandoff->getSummaryReporter());
+        m_apgEngine->addExternalGTypeReporter(m_pHandoff->getGenotypeReporter());
+    }
     m_apgEngine->run();
 }
 
@@ -1093,6 +1114,7 @@ void CNWorkflowEngine::callCNReferenceEngine()
 
     CNReferenceEngine objCNReferenceEngine;
     objCNReferenceEngine.setEngine(this);
+    objCNReferenceEngine.setHandoff(m_pHandoff);
     objCNReferenceEngine.run();
 }
 
@@ -1104,6 +1126,7 @@ void CNWorkflowEngine::callCNLog2RatioEngine()
 {
     CNLog2RatioEngine objCNLog2RatioEngine;
     objCNLog2RatioEngine.setEngine(this);
+    objCNLog2RatioEngine.setHandoff(m_pHandoff);
     objCNLog2RatioEngine.setOpt("call-copynumber-engine", "true");
     objCNLog2RatioEngine.setOpt("log2ratio-hdf5-output", "false");
     objCNLog2RatioEngine.setOpt("log2ratio-text-output", "false");
@@ -29,6 +29,7 @@
 
 #include "chipstream/apt-geno-qc/GenoQC.h"
 #include "chipstream/apt-probeset-genotype/ProbesetGenotypeEngine.h"
+#include "copynumber/CNGenotypeHandoff.h"
 #include "copynumber/CNLog2RatioData.h"
 #include "util/BaseEngine.h"
 #include "util/Err.h"
@@ -48,6 +49,8 @@ private:
     /// List of aliases for standardized methods
     std::map<std::string,std::string>* m_pstdMethods;
     ProbesetGenotypeEngine *m_apgEngine;
+    /// The probeset-genotype results, when handed to the copy number engines in memory.
+    CNGenotypeHandoff* m_pHandoff;
     void checkOptionsImp();
     void checkDiskSpaceImp();
     void runImp();
@@ -83,7 +83,7 @@ void CNAnalysisMethodFactoryTest::functionsTest()
 	CPPUNIT_ASSERT(myDocs[9].getState()=="log2-ratio.gc-correction=true.median-autosome-median-normalization=true.median-smooth-marker-count=5");
     CPPUNIT_ASSERT(myDocs[10].getState()=="log2-ratio-cyto2.gc-correction=true.median-autosome-median-normalization=true.median-smooth-marker-count=5.trim-high=2.0.trim-low=-2.5");
     CPPUNIT_ASSERT(myDocs[11].getState()=="allelic-difference.outlier-trim=3.0");
-    CPPUNIT_ASSERT(myDocs[12].getState()=="gaussian-smooth.expSmoothSignal=1.smooth_sigma_multiplier=2.smooth_bw=50000");
+    CPPUNIT_ASSERT(myDocs[12].getState()=="gaussian-smooth.expSmoothSignal=1.smooth_sigma_multiplier=2.smooth_bw=50000.smooth_table_resolution=0");
     CPPUNIT_ASSERT(myDocs[13].getState()=="kernel-smooth.sigma_span=50.0");
     CPPUNIT_ASSERT(myDocs[14].getState()=="loh.lohCN_errorrate=0.05.lohCN_beta=0.001.lohCN_alpha=0.01.lohCN_separation=1000000.lohCN_nMinMarkers=10.lohCN_NoCallThreshold=0.05.lohCN_minGenomicSpan=1000000");
     CPPUNIT_ASSERT(myDocs[15].getState()=="loh-cyto2.lohCNSegSeparation=1000000.minInformation=100.lambdaCritical=8.0");
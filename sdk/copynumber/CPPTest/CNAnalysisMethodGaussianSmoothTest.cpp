@@ -31,7 +31,10 @@
 #include <cppunit/extensions/TestFactoryRegistry.h>
 #include <cppunit/ui/text/TestRunner.h>
 //
+#include <cmath>
+#include <cstdlib>
 #include <cstring>
+#include <ctime>
 #include <iostream>
 #include <map>
 #include <string>
@@ -49,12 +52,14 @@ class CNAnalysisMethodGaussianSmoothTest : public CppUnit::TestFixture
   CPPUNIT_TEST(functionsTest);
   CPPUNIT_TEST(newObjectTest); 
   CPPUNIT_TEST(runTest);
+  CPPUNIT_TEST(smoothTableTest);
   CPPUNIT_TEST_SUITE_END();
 
 public:  
   void functionsTest();
   void newObjectTest();
   void runTest();
+  void smoothTableTest();
 };
 
 CPPUNIT_TEST_SUITE_REGISTRATION(CNAnalysisMethodGaussianSmoothTest );
@@ -72,7 +77,7 @@ void CNAnalysisMethodGaussianSmoothTest::functionsTest()
 	
 	//getDefaultDocOptions()
 	vector<SelfDoc::Opt> sv=CNAnalysisMethodGaussianSmooth::getDefaultDocOptions();
-	CPPUNIT_ASSERT(sv.size()==3);
+	CPPUNIT_ASSERT(sv.size()==4);
 	CPPUNIT_ASSERT(sv[0].name=="expSmoothSignal");
 	CPPUNIT_ASSERT(sv[0].type==3);
 	CPPUNIT_ASSERT(sv[0].value=="1");
@@ -94,16 +99,24 @@ void CNAnalysisMethodGaussianSmoothTest::functionsTest()
 	CPPUNIT_ASSERT(sv[2].minVal=="1");
 	CPPUNIT_ASSERT(sv[2].maxVal=="NA");
 	CPPUNIT_ASSERT(sv[2].descript=="Smooth Gaussian BW");
+	CPPUNIT_ASSERT(sv[3].name=="smooth_table_resolution");
+	CPPUNIT_ASSERT(sv[3].type==3);
+	CPPUNIT_ASSERT(sv[3].value=="0");
+	CPPUNIT_ASSERT(sv[3].defaultVal=="0");
+	CPPUNIT_ASSERT(sv[3].minVal=="0");
+	CPPUNIT_ASSERT(sv[3].maxVal=="NA");
+	CPPUNIT_ASSERT(sv[3].descript=="Smooth Kernel Table Entries Per Sigma (0 = exact)");
 	//explainSelf()
 	SelfDoc sd=CNAnalysisMethodGaussianSmooth::explainSelf();
-	CPPUNIT_ASSERT(sd.getState()=="gaussian-smooth.expSmoothSignal=1.smooth_sigma_multiplier=2.smooth_bw=50000");
+	CPPUNIT_ASSERT(sd.getState()=="gaussian-smooth.expSmoothSignal=1.smooth_sigma_multiplier=2.smooth_bw=50000.smooth_table_resolution=0");
     CPPUNIT_ASSERT(sd.getDocName()=="gaussian-smooth");
 	CPPUNIT_ASSERT(sd.getDocDescription()=="CopyNumber GaussianSmooth");
 	vector<SelfDoc::Opt> v=sd.getDocOptions();
-	CPPUNIT_ASSERT(v.size()==3);
+	CPPUNIT_ASSERT(v.size()==4);
 	CPPUNIT_ASSERT(v[0].asString()=="1");
 	CPPUNIT_ASSERT(v[1].asString()=="2");
 	CPPUNIT_ASSERT(v[2].asString()=="50000");
+	CPPUNIT_ASSERT(v[3].asString()=="0");
 	CPPUNIT_ASSERT(sd.getDocOption("expSmoothSignal").asString()=="1");
 	CPPUNIT_ASSERT(sd.getDocOption("smooth_sigma_multiplier").asString()=="2");
 	CPPUNIT_ASSERT(sd.getDocOption("smooth_bw").asString()=="50000");
@@ -119,7 +132,7 @@ void CNAnalysisMethodGaussianSmoothTest::newObjectTest()
 	CNAnalysisMethodFactory obj_CNAnalysisMethodFactory;
 	CNAnalysisMethodGaussianSmooth *cn2=(CNAnalysisMethodGaussianSmooth*)obj_CNAnalysisMethodFactory.CNAnalysisMethodForString("gaussian-smooth");
 	vector<affymetrix_calvin_parameter::ParameterNameValueType> *obj1=CNAnalysisMethod::getParams();
-	CPPUNIT_ASSERT(obj1->size()==3);
+	CPPUNIT_ASSERT(obj1->size()==4);
 	affymetrix_calvin_parameter::ParameterNameValueType param1a = obj1->at(0);
 	affymetrix_calvin_parameter::ParameterNameValueType param2a = obj1->at(1);
 	affymetrix_calvin_parameter::ParameterNameValueType param3a = obj1->at(2);
@@ -132,6 +145,8 @@ void CNAnalysisMethodGaussianSmoothTest::newObjectTest()
 	CPPUNIT_ASSERT(StringUtils::ConvertWCSToMBS(param3a.GetName())=="affymetrix-algorithm-param-smooth_bw");
 	CPPUNIT_ASSERT(param3a.GetParameterType()==4);
 	CPPUNIT_ASSERT(param3a.GetValueInt32()==50000);
+	CPPUNIT_ASSERT(StringUtils::ConvertWCSToMBS(obj1->at(3).GetName())=="affymetrix-algorithm-param-smooth_table_resolution");
+	CPPUNIT_ASSERT(obj1->at(3).GetValueInt32()==0);
 	delete cn2;
 
 
@@ -140,11 +155,12 @@ void CNAnalysisMethodGaussianSmoothTest::newObjectTest()
 	params["expSmoothSignal"]="111";
 	params["smooth_sigma_multiplier"]="222.0";
 	params["smooth_bw"]="100";
+	params["smooth_table_resolution"]="1024";
 	CNAnalysisMethod::getParams()->clear();
 	SelfCreate *sc=CNAnalysisMethodGaussianSmooth::newObject(params);
     	
 	vector<affymetrix_calvin_parameter::ParameterNameValueType> *obj=CNAnalysisMethod::getParams();
-	CPPUNIT_ASSERT(obj->size()==3);
+	CPPUNIT_ASSERT(obj->size()==4);
 	affymetrix_calvin_parameter::ParameterNameValueType param1 = obj->at(0);
 	affymetrix_calvin_parameter::ParameterNameValueType param2 = obj->at(1);
 	affymetrix_calvin_parameter::ParameterNameValueType param3 = obj->at(2);
@@ -157,16 +173,19 @@ void CNAnalysisMethodGaussianSmoothTest::newObjectTest()
 	CPPUNIT_ASSERT(StringUtils::ConvertWCSToMBS(param3.GetName())=="affymetrix-algorithm-param-smooth_bw");
 	CPPUNIT_ASSERT(param3.GetParameterType()==4);
 	CPPUNIT_ASSERT(param3.GetValueInt32()==100);
+	CPPUNIT_ASSERT(obj->at(3).GetValueInt32()==1024);
 	
 	//always return default set of options and value even different object has been created by newObject
 	SelfDoc sd1=CNAnalysisMethodGaussianSmooth::explainSelf();
-	CPPUNIT_ASSERT(sd1.getState()=="gaussian-smooth.expSmoothSignal=1.smooth_sigma_multiplier=2.smooth_bw=50000");
+	CPPUNIT_ASSERT(sd1.getState()=="gaussian-smooth.expSmoothSignal=1.smooth_sigma_multiplier=2.smooth_bw=50000.smooth_table_resolution=0");
     
     // Negative test passed [CNAnalysisMethodGaussianSmooth::newObject(params)] Message: SelfCreate::setValue() - '-222.0' is not a valid value for parameter: 'smooth_sigma_multiplier'. The specified range is 0.0 to NA
 	params["smooth_sigma_multiplier"]="-222.0";
 	NEGATIVE_TEST(CNAnalysisMethodGaussianSmooth::newObject(params),Except);
 	params["smooth_sigma_multiplier"]="0.0";
 	POSITIVE_TEST(CNAnalysisMethodGaussianSmooth::newObject(params));
+	params["smooth_table_resolution"]="-1";
+	NEGATIVE_TEST(CNAnalysisMethodGaussianSmooth::newObject(params),Except);
 	delete sc;
 }	
 
@@ -179,3 +198,72 @@ void CNAnalysisMethodGaussianSmoothTest::runTest()
     //FATAL ERROR: CNAnalysisMethod gaussian-smooth is not setup properly.
 	NEGATIVE_TEST(cnrfCNam.run(),Except);
 }
+
+/// Smooths CytoScan like log2 ratios with the exp() weights and with the
+/// tabulated ones, checks the two are within the bound documented for
+/// smooth(), and reports the time each takes.
+void CNAnalysisMethodGaussianSmoothTest::smoothTableTest()
+{
+    Verbose::out(1, "****CNAnalysisMethodGaussianSmoothTest::smoothTableTest****");
+    int iCount = 200000;
+    vector<int> vPositions(iCount);
+    vector<float> vLog2Ratios(iCount);
+    unsigned int uiSeed = 12345;
+    int iPosition = 0;
+    float fMin = 0, fMax = 0;
+    for (int i = 0; (i < iCount); i++)
+    {
+        // About one marker per kb, with a few gaps wider than the window.
+        uiSeed = uiSeed * 1103515245 + 12345;
+        iPosition += (int)((uiSeed >> 16) % 2000) + (((i % 50000) == 0) ? 500000 : 0);
+        vPositions[i] = iPosition;
+        uiSeed = uiSeed * 1103515245 + 12345;
+        vLog2Ratios[i] = (float)((int)((uiSeed >> 16) % 2000) - 1000) / 1000.0f + (((i / 20000) % 3) == 1 ? 0.6f : 0.0f);
+        fMin = min(fMin, vLog2Ratios[i]);
+        fMax = max(fMax, vLog2Ratios[i]);
+    }
+
+    std::map<std::string,std::string> params;
+    params["smooth_table_resolution"]="0";
+    CNAnalysisMethodGaussianSmooth* pExact = (CNAnalysisMethodGaussianSmooth*)CNAnalysisMethodGaussianSmooth::newObject(params);
+    params["smooth_table_resolution"]="1024";
+    CNAnalysisMethodGaussianSmooth* pTable = (CNAnalysisMethodGaussianSmooth*)CNAnalysisMethodGaussianSmooth::newObject(params);
+
+    vector<float> vExact = vLog2Ratios;
+    clock_t start = clock();
+    pExact->calculateGaussianSmooth(vPositions, vExact);
+    double dExactTime = (double)(clock() - start) / CLOCKS_PER_SEC;
+
+    vector<float> vTable = vLog2Ratios;
+    start = clock();
+    pTable->calculateGaussianSmooth(vPositions, vTable);
+    double dTableTime = (double)(clock() - start) / CLOCKS_PER_SEC;
+
+    // The exact weights, summed as smooth() did before the table, for a few markers.
+    for (int i = 0; (i < iCount); i += 997)
+    {
+        double numerator = 0, denominator = 0;
+        for (int j = 0; (j < iCount); j++)
+        {
+            if (abs(vPositions[j] - vPositions[i]) > 100000) {continue;}
+            double t = (double)(vPositions[j] - vPositions[i]) / 50000;
+            double expon = exp(-0.5*(t*t));
+            numerator += vLog2Ratios[j] * expon;
+            denominator += expon;
+        }
+        CPPUNIT_ASSERT(vExact[i] == (float)(numerator/denominator));
+    }
+
+    // 1 / (8 * 1024^2) * exp(2) * range, and a little for rounding to float.
+    double dBound = exp(2.0) / (8.0 * 1024 * 1024) * (fMax - fMin) + 1e-6;
+    double dMaxDeviation = 0;
+    for (int i = 0; (i < iCount); i++)
+    {
+        dMaxDeviation = max(dMaxDeviation, (double)fabs(vTable[i] - vExact[i]));
+    }
+    CPPUNIT_ASSERT(dMaxDeviation <= dBound);
+    Verbose::out(1, ToStr(iCount) + " markers: exp " + ToStr(dExactTime) + " sec, table " + ToStr(dTableTime) +
+                 " sec, largest difference " + ToStr(dMaxDeviation) + " (bound " + ToStr(dBound) + ")");
+    delete pExact;
+    delete pTable;
+}
@@ -0,0 +1,168 @@
+////////////////////////////////////////////////////////////////
+//
+// Copyright (C) 2011 Affymetrix, Inc.
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License (version 2) as
+// published by the Free Software Foundation.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program;if not, write to the
+//
+// Free Software Foundation, Inc.,
+// 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+//
+////////////////////////////////////////////////////////////////
+
+#include "copynumber/CNFamilialCychpCache.h"
+#include "copynumber/CPPTest/Setup.h"
+//
+#include "util/Except.h"
+#include "util/Thread.h"
+#include "util/Verbose.h"
+//
+#include <cppunit/CompilerOutputter.h>
+#include <cppunit/extensions/HelperMacros.h>
+#include <cppunit/extensions/TestFactoryRegistry.h>
+#include <cppunit/ui/text/TestRunner.h>
+//
+#include <iostream>
+//
+using namespace std;
+/**
+ * @class CNFamilialCychpCacheTest
+ * @brief cppunit class for testing CNFamilialCychpCache.
+ */
+class CNFamilialCychpCacheTest : public CppUnit::TestFixture
+{
+  CPPUNIT_TEST_SUITE(CNFamilialCychpCacheTest);
+  CPPUNIT_TEST(copyTest);
+  CPPUNIT_TEST(threadsTest);
+  CPPUNIT_TEST_SUITE_END();
+
+public:
+  void copyTest();
+  void threadsTest();
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(CNFamilialCychpCacheTest);
+
+void CNFamilialCychpCacheTest::copyTest()
+{
+  cout << endl;
+  Verbose::out(1, "****CNFamilialCychpCacheTest::copyTest****");
+  std::string strFileName = "../../calvin_files/parsers/data/NA06985_GW6_C.test.cychp";
+  groupDatasets_t groupDatasets;
+  groupDatasets["ProbeSets"].insert("CopyNumber");
+  groupDatasets["Chromosomes"].insert("Summary");
+
+  CNCychp cychpFile;
+  CPPUNIT_ASSERT(cychpFile.readFile(strFileName, groupDatasets, "mother"));
+  CPPUNIT_ASSERT(cychpFile.getCychpProbeSetsCopyNumbers().getCount() > 0);
+
+  // The same parent in two families is read once.
+  CNFamilialCychpCache cache;
+  cache.setGroupDatasets(groupDatasets);
+  cache.addUse(strFileName);
+  cache.addUse(strFileName);
+  CNCychp cychpMother;
+  CNCychp cychpIndex;
+  cache.copy(strFileName, "mother", cychpMother);
+  CPPUNIT_ASSERT(cache.getCachedCount() == 1);
+  cache.copy(strFileName, "index", cychpIndex);
+  CPPUNIT_ASSERT(cache.getReadCount() == 1);
+  CPPUNIT_ASSERT(cache.getCachedCount() == 0);
+
+  // Each copy is the file's data, with its own familial type.
+  CPPUNIT_ASSERT(cychpMother.getFamilialType() == "mother");
+  CPPUNIT_ASSERT(cychpIndex.getFamilialType() == "index");
+  CPPUNIT_ASSERT(cychpMother.getCychpHeader().getGender() == cychpFile.getCychpHeader().getGender());
+  CPPUNIT_ASSERT(cychpMother.getCychpChromosomesSummaries().getCount() == cychpFile.getCychpChromosomesSummaries().getCount());
+  int iCount = cychpFile.getCychpProbeSetsCopyNumbers().getCount();
+  CPPUNIT_ASSERT(cychpMother.getCychpProbeSetsCopyNumbers().getCount() == iCount);
+  bool bSame = true;
+  for (int iIndex = 0; (iIndex < iCount); iIndex++)
+  {
+    CNCychpProbeSetsCopyNumber* p1 = cychpFile.getCychpProbeSetsCopyNumbers().getAt(iIndex);
+    CNCychpProbeSetsCopyNumber* p2 = cychpMother.getCychpProbeSetsCopyNumbers().getAt(iIndex);
+    bSame = bSame && (p1 != p2) && (p1->getPosition() == p2->getPosition()) && (p1->getGenotypeCall() == p2->getGenotypeCall());
+  }
+  CPPUNIT_ASSERT(bSame);
+
+  // A family's copy is its own to change.
+  cychpMother.getCychpProbeSetsCopyNumbers().getAt(0)->setGenotypeCall(99);
+  CPPUNIT_ASSERT(cychpIndex.getCychpProbeSetsCopyNumbers().getAt(0)->getGenotypeCall() != 99);
+
+  // Every use has been taken.
+  NEGATIVE_TEST(cache.copy(strFileName, "father", cychpMother), Except);
+}
+
+/// Each item takes a copy of the file from the cache.
+class CNFamilialCychpCacheCopyTask : public WorkQueueTask
+{
+public:
+  CNFamilialCychpCacheCopyTask(CNFamilialCychpCache& cache, const std::string& strFileName, AffxArray<CNCychp>& vCychps) :
+    WorkQueueTask(vCychps.getCount()), m_cache(cache), m_strFileName(strFileName), m_vCychps(vCychps) {}
+
+  virtual void runItems(int threadIx, int iStart, int iCount)
+  {
+    for (int iIndex = iStart; (iIndex < (iStart + iCount)); iIndex++)
+    {
+      m_cache.copy(m_strFileName, "index", *m_vCychps.getAt(iIndex));
+    }
+  }
+
+private:
+  CNFamilialCychpCache& m_cache;
+  std::string m_strFileName;
+  AffxArray<CNCychp>& m_vCychps;
+};
+
+void CNFamilialCychpCacheTest::threadsTest()
+{
+  Verbose::out(1, "****CNFamilialCychpCacheTest::threadsTest****");
+  std::string strFileName = "../../calvin_files/parsers/data/NA06985_GW6_C.test.cychp";
+  groupDatasets_t groupDatasets;
+  groupDatasets["ProbeSets"].insert("CopyNumber");
+
+  CNCychp cychpFile;
+  CPPUNIT_ASSERT(cychpFile.readFile(strFileName, groupDatasets, "index"));
+  int iCount = cychpFile.getCychpProbeSetsCopyNumbers().getCount();
+
+  // Families on several threads wanting the same file: it is read once,
+  // and every copy is whole.
+  CNFamilialCychpCache cache;
+  cache.setGroupDatasets(groupDatasets);
+  AffxArray<CNCychp> vCychps;
+  for (int iIndex = 0; (iIndex < 8); iIndex++) {vCychps.add(new CNCychp); cache.addUse(strFileName);}
+  CNFamilialCychpCacheCopyTask task(cache, strFileName, vCychps);
+  task.run(4);
+  CPPUNIT_ASSERT(cache.getReadCount() == 1);
+  CPPUNIT_ASSERT(cache.getCachedCount() == 0);
+  bool bSame = true;
+  for (int iCychp = 0; (iCychp < vCychps.getCount()); iCychp++)
+  {
+    bSame = bSame && (vCychps.getAt(iCychp)->getCychpProbeSetsCopyNumbers().getCount() == iCount);
+    for (int iIndex = 0; (bSame && (iIndex < iCount)); iIndex++)
+    {
+      CNCychpProbeSetsCopyNumber* p1 = cychpFile.getCychpProbeSetsCopyNumbers().getAt(iIndex);
+      CNCychpProbeSetsCopyNumber* p2 = vCychps.getAt(iCychp)->getCychpProbeSetsCopyNumbers().getAt(iIndex);
+      bSame = (p1->getPosition() == p2->getPosition()) && (p1->getGenotypeCall() == p2->getGenotypeCall());
+    }
+  }
+  CPPUNIT_ASSERT(bSame);
+
+  // A file which cannot be read fails every family which wants it.
+  std::string strBadFileName = "../../calvin_files/parsers/data/no-such-file.cychp";
+  AffxArray<CNCychp> vBadCychps;
+  for (int iIndex = 0; (iIndex < 4); iIndex++) {vBadCychps.add(new CNCychp); cache.addUse(strBadFileName);}
+  CNFamilialCychpCacheCopyTask badTask(cache, strBadFileName, vBadCychps);
+  NEGATIVE_TEST(badTask.run(2), Except);
+  vCychps.deleteAll();
+  vBadCychps.deleteAll();
+}
@@ -0,0 +1,252 @@
+////////////////////////////////////////////////////////////////
+//
+// Copyright (C) 2011 Affymetrix, Inc.
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License (version 2) as
+// published by the Free Software Foundation.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program;if not, write to the
+//
+// Free Software Foundation, Inc.,
+// 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+//
+////////////////////////////////////////////////////////////////
+
+#include "copynumber/CNFamilialEngine.h"
+#include "copynumber/CPPTest/Setup.h"
+//
+#include "calvin_files/utils/src/Calvin.h"
+#include "calvin_files/writers/src/GenericFileWriter.h"
+#include "util/Fs.h"
+#include "util/Util.h"
+#include "util/Verbose.h"
+//
+#include <cppunit/CompilerOutputter.h>
+#include <cppunit/extensions/HelperMacros.h>
+#include <cppunit/extensions/TestFactoryRegistry.h>
+#include <cppunit/ui/text/TestRunner.h>
+//
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+//
+using namespace std;
+/**
+ * @class CNFamilialEngineTest
+ * @brief cppunit class for testing the CNFamilialEngine family-file runs.
+ */
+class CNFamilialEngineTest : public CppUnit::TestFixture
+{
+  CPPUNIT_TEST_SUITE(CNFamilialEngineTest);
+  CPPUNIT_TEST(familyFileTest);
+  CPPUNIT_TEST_SUITE_END();
+
+public:
+  void familyFileTest();
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(CNFamilialEngineTest);
+
+static const int MARKER_COUNT = 600;
+
+/// A pseudo random number in [0, 1), the same on every platform.
+static double nextRandom(unsigned int& uiSeed)
+{
+  uiSeed = uiSeed * 1103515245 + 12345;
+  return (double)((uiSeed >> 8) & 0xFFFF) / 65536.0;
+}
+
+/**
+ * Write a cychp file holding the SCARs of a sample's genotypes (0 = AA,
+ * 1 = AB, 2 = BB), with the Y gender call given.
+ */
+static void writeCychp(const std::string& strFileName, const std::string& strGender, const std::vector<int>& vGenotypes, unsigned int uiSeed)
+{
+  affymetrix_calvin_io::GenericData data;
+  data.Header().SetFilename(strFileName);
+  affymetrix_calvin_io::GenericDataHeader* pHeader = data.Header().GetGenericDataHdr();
+  pHeader->SetFileTypeId("affymetrix-multi-data-type-analysis");
+  affymetrix_calvin_parameter::ParameterNameValueType param;
+  param.SetName(L"affymetrix-chipsummary-Y-gender-call");
+  param.SetValueAscii(strGender);
+  pHeader->AddNameValParam(param);
+  param.SetName(L"affymetrix-algorithm-param-option-xChromosome");
+  param.SetValueInt32(24);
+  pHeader->AddNameValParam(param);
+  param.SetName(L"affymetrix-algorithm-param-option-yChromosome");
+  param.SetValueInt32(25);
+  pHeader->AddNameValParam(param);
+
+  int iCount = (int)vGenotypes.size();
+  affymetrix_calvin_io::DataGroupHeader probeSets(L"ProbeSets");
+  affymetrix_calvin_io::DataSetHeader copyNumber;
+  copyNumber.SetName(L"CopyNumber");
+  copyNumber.SetRowCnt(iCount);
+  copyNumber.AddAsciiColumn(L"ProbeSetName", 16);
+  copyNumber.AddUByteColumn(L"Chromosome");
+  copyNumber.AddUIntColumn(L"Position");
+  copyNumber.AddFloatColumn(L"Log2Ratio");
+  copyNumber.AddFloatColumn(L"WeightedLog2Ratio");
+  copyNumber.AddFloatColumn(L"SmoothSignal");
+  probeSets.AddDataSetHdr(copyNumber);
+  data.Header().AddDataGroupHdr(probeSets);
+  affymetrix_calvin_io::DataGroupHeader algorithmData(L"AlgorithmData");
+  affymetrix_calvin_io::DataSetHeader markerABSignal;
+  markerABSignal.SetName(L"MarkerABSignal");
+  markerABSignal.SetRowCnt(iCount);
+  markerABSignal.AddUIntColumn(L"Index");
+  markerABSignal.AddFloatColumn(L"BSignal");
+  markerABSignal.AddFloatColumn(L"ASignal");
+  markerABSignal.AddFloatColumn(L"SCAR");
+  algorithmData.AddDataSetHdr(markerABSignal);
+  data.Header().AddDataGroupHdr(algorithmData);
+
+  affymetrix_calvin_io::GenericFileWriter writer(&data.Header());
+  writer.WriteHeader();
+  affymetrix_calvin_io::DataGroupWriter& group0 = writer.GetDataGroupWriter(0);
+  group0.WriteHeader();
+  affymetrix_calvin_io::DataSetWriter& set0 = group0.GetDataSetWriter(0);
+  set0.WriteHeader();
+  for (int iIndex = 0; (iIndex < iCount); iIndex++)
+  {
+    set0.Write("SNP_" + ToStr(iIndex), 16);
+    set0.Write((u_int8_t)(1 + (iIndex * 3 / iCount)));
+    set0.Write((u_int32_t)(1000 + (iIndex * 5000)));
+    set0.Write((float)0);
+    set0.Write((float)0);
+    set0.Write((float)2);
+  }
+  set0.UpdateNextDataSetOffset();
+  group0.UpdateNextDataGroupPos();
+  affymetrix_calvin_io::DataGroupWriter& group1 = writer.GetDataGroupWriter(1);
+  group1.WriteHeader();
+  affymetrix_calvin_io::DataSetWriter& set1 = group1.GetDataSetWriter(0);
+  set1.WriteHeader();
+  for (int iIndex = 0; (iIndex < iCount); iIndex++)
+  {
+    float fSCAR = (float)((vGenotypes[iIndex] - 1) + ((nextRandom(uiSeed) - 0.5) * 0.4));
+    set1.Write((u_int32_t)iIndex);
+    set1.Write((float)1000);
+    set1.Write((float)1000);
+    set1.Write(fSCAR);
+  }
+  set1.UpdateNextDataSetOffset();
+  group1.UpdateNextDataGroupPos();
+}
+
+/// A child's genotypes, one allele from each parent.
+static std::vector<int> inherit(const std::vector<int>& vMother, const std::vector<int>& vFather, unsigned int uiSeed)
+{
+  std::vector<int> vChild(vMother.size());
+  for (int iIndex = 0; (iIndex < (int)vMother.size()); iIndex++)
+  {
+    int iFromMother = ((vMother[iIndex] == 1) ? ((nextRandom(uiSeed) < 0.5) ? 0 : 1) : (vMother[iIndex] / 2));
+    int iFromFather = ((vFather[iIndex] == 1) ? ((nextRandom(uiSeed) < 0.5) ? 0 : 1) : (vFather[iIndex] / 2));
+    vChild[iIndex] = iFromMother + iFromFather;
+  }
+  return vChild;
+}
+
+/// Run the engine on a family-file.
+static void runFamilyFile(const std::string& strFamilyFileName, const std::string& strAlleleFileName, const std::string& strOutDirName, const std::string& strThreads)
+{
+  CNFamilialEngine engine;
+  engine.setOpt("family-file", strFamilyFileName);
+  engine.setOpt("allele-frequency-file", strAlleleFileName);
+  engine.setOpt("out-dir", strOutDirName);
+  engine.setOpt("text-output", "false");
+  engine.setOpt("threads", strThreads);
+  engine.run();
+}
+
+/// Run the engine on one family, as given on the command line.
+static void runFamily(const std::string& strIndexFileName, const std::string& strMotherFileName, const std::string& strFatherFileName, const std::string& strAlleleFileName, const std::string& strOutDirName, const std::string& strFamilialFileName)
+{
+  CNFamilialEngine engine;
+  engine.setOpt("index-cychp-file", strIndexFileName);
+  engine.setOpt("mother-cychp-file", strMotherFileName);
+  engine.setOpt("father-cychp-file", strFatherFileName);
+  engine.setOpt("allele-frequency-file", strAlleleFileName);
+  engine.setOpt("out-dir", strOutDirName);
+  engine.setOpt("familial-file", strFamilialFileName);
+  engine.setOpt("text-output", "false");
+  engine.run();
+}
+
+/// The data in two familial files must match exactly; the headers hold the run's time and guid.
+static bool sameFamilialFile(const std::string& strFileName1, const std::string& strFileName2)
+{
+  std::set<std::string> setIgnore;
+  std::set<std::string> setSetIgnore;
+  std::map<std::string, float> mapEpsilon;
+  return Calvin::equivalent(strFileName1, strFileName2, setIgnore, setSetIgnore, mapEpsilon, 0.0, 1.0, false);
+}
+
+void CNFamilialEngineTest::familyFileTest()
+{
+  cout << endl;
+  Verbose::out(1, "****CNFamilialEngineTest::familyFileTest****");
+  std::string strDirName = OUTPUT + "/CNFamilialEngineTest";
+  Fs::ensureWriteableDirPath(strDirName);
+
+  // Two half sibs with the same mother, and a mother-only duo for one of them.
+  unsigned int uiSeed = 7;
+  std::vector<int> vMother(MARKER_COUNT);
+  std::vector<int> vFather1(MARKER_COUNT);
+  std::vector<int> vFather2(MARKER_COUNT);
+  for (int iIndex = 0; (iIndex < MARKER_COUNT); iIndex++)
+  {
+    vMother[iIndex] = (int)(nextRandom(uiSeed) * 3);
+    vFather1[iIndex] = (int)(nextRandom(uiSeed) * 3);
+    vFather2[iIndex] = (int)(nextRandom(uiSeed) * 3);
+  }
+  std::string strMother = strDirName + "/mother.cychp";
+  std::string strFather1 = strDirName + "/father1.cychp";
+  std::string strFather2 = strDirName + "/father2.cychp";
+  std::string strChild1 = strDirName + "/child1.cychp";
+  std::string strChild2 = strDirName + "/child2.cychp";
+  writeCychp(strMother, "female", vMother, 11);
+  writeCychp(strFather1, "male", vFather1, 12);
+  writeCychp(strFather2, "male", vFather2, 13);
+  writeCychp(strChild1, "female", inherit(vMother, vFather1, 14), 15);
+  writeCychp(strChild2, "male", inherit(vMother, vFather2, 16), 17);
+
+  std::string strAlleleFileName = strDirName + "/allele-frequencies.txt";
+  std::ofstream allele(strAlleleFileName.c_str());
+  allele << "probeset_id\tA\tB" << endl;
+  for (int iIndex = 0; (iIndex < MARKER_COUNT); iIndex++) {allele << "SNP_" << iIndex << "\t0.5\t0.5" << endl;}
+  allele.close();
+
+  std::string strFamilyFileName = strDirName + "/families.txt";
+  std::ofstream family(strFamilyFileName.c_str());
+  family << "index_cychp_file\tmother_cychp_file\tfather_cychp_file\tfamilial_file" << endl;
+  family << strChild1 << "\t" << strMother << "\t" << strFather1 << "\tchild1.familial" << endl;
+  family << strChild2 << "\t" << strMother << "\t" << strFather2 << "\tchild2.familial" << endl;
+  family << strChild1 << "\t" << strMother << "\t\tchild1-duo.familial" << endl;
+  family.close();
+
+  // One family at a time and several at once give the same files.
+  POSITIVE_TEST(runFamilyFile(strFamilyFileName, strAlleleFileName, strDirName + "/threads-1", "1"));
+  POSITIVE_TEST(runFamilyFile(strFamilyFileName, strAlleleFileName, strDirName + "/threads-3", "3"));
+  // And the same as analysing each family on its own.
+  POSITIVE_TEST(runFamily(strChild1, strMother, strFather1, strAlleleFileName, strDirName + "/single", "child1.familial"));
+  POSITIVE_TEST(runFamily(strChild2, strMother, strFather2, strAlleleFileName, strDirName + "/single", "child2.familial"));
+  POSITIVE_TEST(runFamily(strChild1, strMother, "", strAlleleFileName, strDirName + "/single", "child1-duo.familial"));
+
+  const char* familialFileNames[] = {"child1.familial", "child2.familial", "child1-duo.familial"};
+  for (int iIndex = 0; (iIndex < 3); iIndex++)
+  {
+    std::string strFileName = familialFileNames[iIndex];
+    CPPUNIT_ASSERT(sameFamilialFile(strDirName + "/threads-1/" + strFileName, strDirName + "/threads-3/" + strFileName));
+    CPPUNIT_ASSERT(sameFamilialFile(strDirName + "/threads-1/" + strFileName, strDirName + "/single/" + strFileName));
+  }
+}
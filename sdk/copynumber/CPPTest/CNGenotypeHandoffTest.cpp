@@ -0,0 +1,188 @@
+////////////////////////////////////////////////////////////////
+//
+// Copyright (C) 2011 Affymetrix, Inc.
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License (version 2) as
+// published by the Free Software Foundation.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program;if not, write to the
+//
+// Free Software Foundation, Inc.,
+// 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+//
+////////////////////////////////////////////////////////////////
+
+#include "copynumber/CNGenotypeHandoff.h"
+#include "copynumber/CPPTest/Setup.h"
+//
+#include "file5/File5.h"
+#include "util/Convert.h"
+#include "util/Fs.h"
+#include "util/Verbose.h"
+//
+#include <cppunit/CompilerOutputter.h>
+#include <cppunit/extensions/HelperMacros.h>
+#include <cppunit/extensions/TestFactoryRegistry.h>
+#include <cppunit/ui/text/TestRunner.h>
+//
+#include <iostream>
+#include <vector>
+//
+using namespace std;
+/**
+ * @class CNGenotypeHandoffTest
+ * @brief cppunit class for testing CNGenotypeHandoff, in memory and spilled to disk.
+ */
+class CNGenotypeHandoffTest : public CppUnit::TestFixture
+{
+  CPPUNIT_TEST_SUITE(CNGenotypeHandoffTest);
+  CPPUNIT_TEST(memoryTest);
+  CPPUNIT_TEST(spillTest);
+  CPPUNIT_TEST_SUITE_END();
+
+public:
+  void memoryTest();
+  void spillTest();
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(CNGenotypeHandoffTest);
+
+static vector<string> testCels(int iCelCount)
+{
+  vector<string> v;
+  for (int i = 0; (i < iCelCount); i++) {v.push_back("cel" + ::getInt(i) + ".CEL");}
+  return v;
+}
+
+static double testSummary(int iRow, int iCol) {return (double)(iRow * 10 + iCol) + 0.1;}
+static double testCall(int iRow, int iCol) {return (double)(((iRow + iCol) % 4) - 1);}
+static double testConfidence(int iRow, int iCol) {return (double)((iRow + iCol) % 100) / 1000.0;}
+
+/// iRowCount summary rows and iRowCount / 2 genotype rows, as probeset-genotype reports them.
+static void addRows(CNGenotypeHandoff& objHandoff, int iCelCount, int iRowCount)
+{
+  vector<double> v1(iCelCount), v2(iCelCount);
+  objHandoff.prepareSummaries(testCels(iCelCount));
+  for (int iRow = 0; (iRow < iRowCount); iRow++)
+  {
+    for (int iCol = 0; (iCol < iCelCount); iCol++) {v1[iCol] = testSummary(iRow, iCol);}
+    objHandoff.addSummary("SNP_A-" + ::getInt(iRow / 2) + (((iRow % 2) == 0) ? "-A" : "-B"), &v1[0]);
+  }
+  objHandoff.getSummaries()->finish();
+  objHandoff.prepareGenotypes(testCels(iCelCount));
+  for (int iRow = 0; (iRow < (iRowCount / 2)); iRow++)
+  {
+    for (int iCol = 0; (iCol < iCelCount); iCol++) {v1[iCol] = testCall(iRow, iCol); v2[iCol] = testConfidence(iRow, iCol);}
+    objHandoff.addGenotype("SNP_A-" + ::getInt(iRow), &v1[0], &v2[0]);
+  }
+  objHandoff.getCalls()->finish();
+  objHandoff.getConfidences()->finish();
+}
+
+void CNGenotypeHandoffTest::memoryTest()
+{
+  cout << endl;
+  Verbose::out(1, "****CNGenotypeHandoffTest::memoryTest****");
+  {
+    CNGenotypeHandoff objHandoff("Test.plier.summary.a5", "Test.calls.a5", "Test.confidences.a5");
+    // Nothing reported yet, so the files would be read.
+    CPPUNIT_ASSERT(objHandoff.findTable("Test.plier.summary.a5") == NULL);
+    addRows(objHandoff, 5, 40);
+
+    CNGenotypeHandoff::Table* pSummaries = objHandoff.findTable("Test.plier.summary.a5");
+    CNGenotypeHandoff::Table* pCalls = objHandoff.findTable("Test.calls.a5");
+    CNGenotypeHandoff::Table* pConfidences = objHandoff.findTable("Test.confidences.a5");
+    CPPUNIT_ASSERT(objHandoff.findTable("Other.calls.a5") == NULL);
+    CPPUNIT_ASSERT((pSummaries != NULL) && (pCalls != NULL) && (pConfidences != NULL));
+    CPPUNIT_ASSERT(pSummaries->getColumnCount() == 5);
+    CPPUNIT_ASSERT(pSummaries->getColumnName(4) == "cel4.CEL");
+    CPPUNIT_ASSERT(pSummaries->getRowCount() == 40);
+    CPPUNIT_ASSERT(pSummaries->getRowName(3) == "SNP_A-1-B");
+    CPPUNIT_ASSERT(pSummaries->getRow(3)[2] == testSummary(3, 2));
+    CPPUNIT_ASSERT(pCalls->getRowCount() == 20);
+    CPPUNIT_ASSERT(pCalls->getRowName(7) == "SNP_A-7");
+    CPPUNIT_ASSERT(pCalls->getRow(7)[1] == testCall(7, 1));
+    CPPUNIT_ASSERT(pConfidences->getRow(19)[4] == testConfidence(19, 4));
+    CPPUNIT_ASSERT(objHandoff.getBytes() > 0);
+  }
+}
+
+void CNGenotypeHandoffTest::spillTest()
+{
+  cout << endl;
+  Verbose::out(1, "****CNGenotypeHandoffTest::spillTest****");
+  Fs::ensureWriteableDirPath(OUTPUT);
+  std::string strSummaryFileName = OUTPUT + "/CNGenotypeHandoff.plier.summary.a5";
+  std::string strCallsFileName = OUTPUT + "/CNGenotypeHandoff.calls.a5";
+  std::string strConfidencesFileName = OUTPUT + "/CNGenotypeHandoff.confidences.a5";
+  const int iCelCount = 50;
+  const int iRowCount = 4000;
+  {
+    // The summaries outgrow the budget and are spilled, then the calls, and the confidences fit.
+    CNGenotypeHandoff objHandoff(strSummaryFileName, strCallsFileName, strConfidencesFileName, 1);
+    addRows(objHandoff, iCelCount, iRowCount);
+    CPPUNIT_ASSERT(objHandoff.getSummaries()->isSpilled());
+    CPPUNIT_ASSERT(objHandoff.getCalls()->isSpilled());
+    CPPUNIT_ASSERT(!objHandoff.getConfidences()->isSpilled());
+    CPPUNIT_ASSERT(objHandoff.findTable(strSummaryFileName) == NULL);
+    CPPUNIT_ASSERT(objHandoff.findTable(strConfidencesFileName) == objHandoff.getConfidences());
+    CPPUNIT_ASSERT(objHandoff.getConfidences()->getRow(1999)[49] == testConfidence(1999, 49));
+    CPPUNIT_ASSERT(objHandoff.getBytes() <= (1024 * 1024));
+
+    // The spilled file is laid out as probeset-genotype writes it.
+    affx::File5_File file5;
+    file5.open(strSummaryFileName, affx::FILE5_OPEN_RO);
+    affx::File5_Tsv* tsv5 = file5.openTsv("CNGenotypeHandoff.plier.summary", affx::FILE5_OPEN);
+    CPPUNIT_ASSERT(tsv5->getColumnCount(0) == (iCelCount + 1));
+    CPPUNIT_ASSERT(tsv5->getLineCount() == iRowCount);
+    CPPUNIT_ASSERT(tsv5->getColumnPtr(0, 5)->getColumnName() == "cel4.CEL");
+    bool bSame = true;
+    int iRow = 0;
+    std::string strName;
+    double d = 0;
+    while (tsv5->nextLine() == affx::FILE5_OK)
+    {
+      tsv5->get(0, 0, &strName);
+      bSame = bSame && (strName == "SNP_A-" + ::getInt(iRow / 2) + (((iRow % 2) == 0) ? "-A" : "-B"));
+      for (int iCol = 0; (iCol < iCelCount); iCol++)
+      {
+        tsv5->get(0, (iCol + 1), &d);
+        bSame = bSame && (d == testSummary(iRow, iCol));
+      }
+      iRow++;
+    }
+    CPPUNIT_ASSERT(bSame);
+    CPPUNIT_ASSERT(iRow == iRowCount);
+    tsv5->close();
+    delete tsv5;
+    file5.close();
+  }
+  {
+    // No budget, so everything goes to disk.
+    CNGenotypeHandoff objHandoff(strSummaryFileName, strCallsFileName, strConfidencesFileName, 0);
+    addRows(objHandoff, 3, 10);
+    CPPUNIT_ASSERT(objHandoff.findTable(strCallsFileName) == NULL);
+    CPPUNIT_ASSERT(objHandoff.getBytes() == 0);
+    affx::File5_File file5;
+    file5.open(strCallsFileName, affx::FILE5_OPEN_RO);
+    affx::File5_Tsv* tsv5 = file5.openTsv("CNGenotypeHandoff.calls", affx::FILE5_OPEN);
+    CPPUNIT_ASSERT(tsv5->getLineCount() == 5);
+    int i = 0;
+    tsv5->gotoLine(4);
+    tsv5->get(0, 2, &i);
+    CPPUNIT_ASSERT(i == (int)testCall(4, 1));
+    tsv5->close();
+    delete tsv5;
+    file5.close();
+  }
+  Fs::rm(strSummaryFileName, false);
+  Fs::rm(strCallsFileName, false);
+  Fs::rm(strConfidencesFileName, false);
+}
@@ -20,6 +20,7 @@
 ////////////////////////////////////////////////////////////////
 
 #include "copynumber/CNAnalysisMethod.h"
+#include "copynumber/CNGenotypeHandoff.h"
 #include "copynumber/CNLog2RatioData.h"
 #include "copynumber/CNLog2RatioEngine.h"
 #include "copynumber/CNReferenceEngine.h"
@@ -47,6 +48,7 @@ class CNLog2RatioDataTest : public CppUnit::TestFixture
 	CPPUNIT_TEST_SUITE(CNLog2RatioDataTest);
 	CPPUNIT_TEST(loadGenotypeReportTest);
 	CPPUNIT_TEST(loadExperimentsTest);
+	CPPUNIT_TEST(loadExperimentsHandoffTest);
 	CPPUNIT_TEST(loadCyto2ModelFileTest);
 	CPPUNIT_TEST_SUITE_END();
 
@@ -54,6 +56,7 @@ public:
    
    void loadGenotypeReportTest();
    void loadExperimentsTest();
+   void loadExperimentsHandoffTest();
    void loadCyto2ModelFileTest();
    
 };
@@ -104,6 +107,28 @@ void CNLog2RatioDataTest::loadExperimentsTest()
 	CPPUNIT_ASSERT(cn1.getExperiments()->getAt(0)->getExperimentName()=="NA06985_GW6_C.CEL");
 	CPPUNIT_ASSERT(cn1.getExperiments()->getAt(4)->getExperimentName()=="NA07000_GW6_C.CEL");
 }
+void CNLog2RatioDataTest::loadExperimentsHandoffTest()
+{
+	Verbose::out(1, "****CNLog2RatioDataTest::loadExperimentsHandoffTest****");
+	CNLog2RatioData cn1;
+	CNWorkflowEngine m_objCNWorkflowEngine;
+	m_objCNWorkflowEngine.setOpt("set-analysis-name", "Test");
+	cn1.setEngine(&m_objCNWorkflowEngine);
+
+	CNGenotypeHandoff objHandoff(INPUT + "/Test.plier.summary.txt", "Test.calls.a5", "Test.confidences.a5");
+	std::vector<std::string> vCels;
+	vCels.push_back("A.CEL");
+	vCels.push_back("B.CEL");
+	objHandoff.prepareSummaries(vCels);
+	// Not given the handoff, so the file is read.
+	CPPUNIT_ASSERT(cn1.loadExperiments(INPUT + "/Test.plier.summary.txt")==5);
+	// Handed over in memory by the workflow rather than read from the file.
+	cn1.setHandoff(&objHandoff);
+	CPPUNIT_ASSERT(cn1.loadExperiments(INPUT + "/Test.plier.summary.txt")==2);
+	CPPUNIT_ASSERT(cn1.getExperiments()->getAt(1)->getExperimentName()=="B.CEL");
+	cn1.setHandoff(NULL);
+	CPPUNIT_ASSERT(cn1.loadExperiments(INPUT + "/Test.plier.summary.txt")==5);
+}
 void CNLog2RatioDataTest::loadCyto2ModelFileTest()
 {
 	
@@ -0,0 +1,187 @@
+////////////////////////////////////////////////////////////////
+//
+// Copyright (C) 1989, 1991 Free Software Foundation, Inc.
+//
+// This program is free software; you can redistribute it and/or modify 
+// it under the terms of the GNU General Public License (version 2) as 
+// published by the Free Software Foundation.
+// 
+// This program is distributed in the hope that it will be useful, 
+// but WITHOUT ANY WARRANTY; without even the implied warranty of 
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU 
+// General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License 
+// along with this program;if not, write to the 
+// 
+// Free Software Foundation, Inc., 
+// 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+//
+////////////////////////////////////////////////////////////////
+
+
+#include "copynumber/CNProbeSet.h"
+//
+#include "util/Convert.h"
+#include "util/Verbose.h"
+//
+#include <cppunit/CompilerOutputter.h>
+#include <cppunit/extensions/HelperMacros.h>
+#include <cppunit/extensions/TestFactoryRegistry.h>
+#include <cppunit/ui/text/TestRunner.h>
+//
+#include <ctime>
+#include <iostream>
+#include <vector>
+//
+using namespace std;
+/**
+ * @class CNProbeSetArrayTest
+ * @brief cppunit class for testing the chromosome index and column gathers
+ * of CNProbeSetArray, and timing them against scanning every probe set.
+ */
+class CNProbeSetArrayTest : public CppUnit::TestFixture
+{
+  CPPUNIT_TEST_SUITE(CNProbeSetArrayTest);
+  CPPUNIT_TEST(chromosomeBoundsTest);
+  CPPUNIT_TEST(reindexTest);
+  CPPUNIT_TEST(getColumnsTest);
+  CPPUNIT_TEST(scanTimingTest);
+  CPPUNIT_TEST_SUITE_END();
+
+public:
+  void chromosomeBoundsTest();
+  void reindexTest();
+  void getColumnsTest();
+  void scanTimingTest();
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(CNProbeSetArrayTest);
+
+/// iPerChromosome probe sets on each of chromosomes 1 to 24 but 13, sorted.
+static void makeProbeSets(CNProbeSetArray& ar, int iPerChromosome)
+{
+  for (int iChromosome = 1; (iChromosome <= 24); iChromosome++)
+  {
+    if (iChromosome == 13) {continue;}
+    for (int i = 0; (i < iPerChromosome); i++)
+    {
+      CNProbeSet* p = new CNProbeSet;
+      p->setChromosome((unsigned char)iChromosome);
+      p->setPosition(1000 + (i * 500));
+      p->setLog2Ratio((float)i / iPerChromosome);
+      p->setAAlleleSignal((float)iChromosome);
+      p->setBAlleleSignal((float)-iChromosome);
+      p->setSCAR(0.5f);
+      p->setGenotypeCall((char)(i % 3));
+      ar.add(p);
+    }
+  }
+}
+
+void CNProbeSetArrayTest::chromosomeBoundsTest()
+{
+  cout << endl;
+  Verbose::out(1, "****CNProbeSetArrayTest::chromosomeBoundsTest****");
+  CNProbeSetArray ar;
+  makeProbeSets(ar, 10);
+  vector<int> vChromosomes = ar.getChromosomes();
+  CPPUNIT_ASSERT(vChromosomes.size() == 23);
+  CPPUNIT_ASSERT(vChromosomes[0] == 1);
+  CPPUNIT_ASSERT(vChromosomes[12] == 14);
+  CPPUNIT_ASSERT(ar.getChromosomeBounds(1) == make_pair(0, 10));
+  CPPUNIT_ASSERT(ar.getChromosomeBounds(14) == make_pair(120, 130));
+  CPPUNIT_ASSERT(ar.getChromosomeBounds(24) == make_pair(220, 230));
+  CPPUNIT_ASSERT(ar.getChromosomeBounds(13) == make_pair(0, 0));
+  CPPUNIT_ASSERT(ar.getChromosomeBounds(25) == make_pair(0, 0));
+  CPPUNIT_ASSERT(ar.getChromosomeProbeSetCount(2) == 10);
+  CPPUNIT_ASSERT(ar.getChromosomeProbeSetCount(13) == 0);
+  ar.deleteAll();
+  CPPUNIT_ASSERT(ar.getChromosomes().size() == 0);
+}
+
+void CNProbeSetArrayTest::reindexTest()
+{
+  Verbose::out(1, "****CNProbeSetArrayTest::reindexTest****");
+  CNProbeSetArray ar;
+  makeProbeSets(ar, 5);
+  CPPUNIT_ASSERT(ar.getChromosomeBounds(24) == make_pair(110, 115));
+  // Adding a chromosome at the end is seen without a sort.
+  CNProbeSet* p = new CNProbeSet;
+  p->setChromosome(25);
+  ar.add(p);
+  CPPUNIT_ASSERT(ar.getChromosomeBounds(25) == make_pair(115, 116));
+  // A chromosome 2 probe set at the end is indexed once the array is sorted.
+  p = new CNProbeSet;
+  p->setChromosome(2);
+  ar.add(p);
+  ar.quickSort(1);
+  CPPUNIT_ASSERT(ar.getChromosomeBounds(2) == make_pair(5, 11));
+  CPPUNIT_ASSERT(ar.getChromosomeBounds(25) == make_pair(116, 117));
+  CPPUNIT_ASSERT(ar.getAt(5)->getPosition() == 0);
+  ar.deleteAll();
+}
+
+void CNProbeSetArrayTest::getColumnsTest()
+{
+  Verbose::out(1, "****CNProbeSetArrayTest::getColumnsTest****");
+  CNProbeSetArray ar;
+  makeProbeSets(ar, 20);
+  CNProbeSetColumns columns;
+  ar.getColumns(ar.getChromosomeBounds(3), columns);
+  CPPUNIT_ASSERT(columns.getCount() == 20);
+  for (int i = 0; (i < columns.getCount()); i++)
+  {
+    CNProbeSet* p = ar.getAt(40 + i);
+    CPPUNIT_ASSERT(columns.m_vPositions[i] == p->getPosition());
+    CPPUNIT_ASSERT(columns.m_vLog2Ratios[i] == p->getLog2Ratio());
+    CPPUNIT_ASSERT(columns.m_vAAlleleSignals[i] == 3.0f);
+    CPPUNIT_ASSERT(columns.m_vBAlleleSignals[i] == -3.0f);
+    CPPUNIT_ASSERT(columns.m_vSCARs[i] == 0.5f);
+    CPPUNIT_ASSERT(columns.m_vGenotypeCalls[i] == p->getGenotypeCall());
+  }
+  // The vectors are reused for the next chromosome.
+  ar.getColumns(ar.getChromosomeBounds(13), columns);
+  CPPUNIT_ASSERT(columns.getCount() == 0);
+  ar.deleteAll();
+}
+
+/// Per chromosome passes over a CytoScan sized array, scanning every probe
+/// set for the chromosome against the index and column gather.
+// Times one pass over every chromosome with each way of finding its probe
+// sets. It is not a timing of the CytoScan method chain, which needs the
+// engine, a reference and CEL files; the regression tests cover that.
+void CNProbeSetArrayTest::scanTimingTest()
+{
+  Verbose::out(1, "****CNProbeSetArrayTest::scanTimingTest****");
+  CNProbeSetArray ar;
+  makeProbeSets(ar, 2700000 / 23);
+  vector<int> vChromosomes = ar.getChromosomes();
+
+  double dSum1 = 0;
+  clock_t start = clock();
+  for (int iChromosomeIndex = 0; (iChromosomeIndex < (int)vChromosomes.size()); iChromosomeIndex++)
+  {
+    for (int iIndex = 0; (iIndex < ar.getCount()); iIndex++)
+    {
+      CNProbeSet* p = ar.getAt(iIndex);
+      if (p->getChromosome() == vChromosomes[iChromosomeIndex]) {dSum1 += p->getLog2Ratio();}
+    }
+  }
+  double dScanTime = (double)(clock() - start) / CLOCKS_PER_SEC;
+
+  double dSum2 = 0;
+  start = clock();
+  CNProbeSetColumns columns;
+  for (int iChromosomeIndex = 0; (iChromosomeIndex < (int)vChromosomes.size()); iChromosomeIndex++)
+  {
+    ar.getColumns(ar.getChromosomeBounds(vChromosomes[iChromosomeIndex]), columns);
+    for (int i = 0; (i < columns.getCount()); i++) {dSum2 += columns.m_vLog2Ratios[i];}
+  }
+  double dIndexTime = (double)(clock() - start) / CLOCKS_PER_SEC;
+  CPPUNIT_ASSERT(dSum1 == dSum2);
+
+  Verbose::out(1, ToStr(ar.getCount()) + " probe sets, " + ToStr((int)vChromosomes.size()) +
+               " chromosomes: scan " + ToStr(dScanTime) + " sec, index " + ToStr(dIndexTime) + " sec");
+  ar.deleteAll();
+}
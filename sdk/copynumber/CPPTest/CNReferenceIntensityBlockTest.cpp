@@ -0,0 +1,253 @@
+////////////////////////////////////////////////////////////////
+//
+// Copyright (C) 2011 Affymetrix, Inc.
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License (version 2) as
+// published by the Free Software Foundation.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program;if not, write to the
+//
+// Free Software Foundation, Inc.,
+// 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+//
+////////////////////////////////////////////////////////////////
+
+#include "copynumber/CNReferenceIntensityBlock.h"
+#include "copynumber/CPPTest/Setup.h"
+//
+#include "file5/File5.h"
+#include "util/AffxMultiDimensionalArray.h"
+#include "util/Convert.h"
+#include "util/Fs.h"
+#include "util/Verbose.h"
+//
+#include <cppunit/CompilerOutputter.h>
+#include <cppunit/extensions/HelperMacros.h>
+#include <cppunit/extensions/TestFactoryRegistry.h>
+#include <cppunit/ui/text/TestRunner.h>
+//
+#include <cstring>
+#include <ctime>
+#include <iostream>
+#include <limits>
+#include <vector>
+//
+using namespace std;
+/**
+ * @class CNReferenceIntensityBlockTest
+ * @brief cppunit class for testing CNReferenceIntensityBlock against reading
+ * the intensities tables a line at a time, and timing the two.
+ */
+class CNReferenceIntensityBlockTest : public CppUnit::TestFixture
+{
+  CPPUNIT_TEST_SUITE(CNReferenceIntensityBlockTest);
+  CPPUNIT_TEST(medianTest);
+  CPPUNIT_TEST(transposeTest);
+  CPPUNIT_TEST(readTest);
+  CPPUNIT_TEST_SUITE_END();
+
+public:
+  void medianTest();
+  void transposeTest();
+  void readTest();
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(CNReferenceIntensityBlockTest);
+
+/// Intensity like values with ties.
+static float testIntensity(unsigned int& uiSeed)
+{
+  uiSeed = uiSeed * 1103515245 + 12345;
+  return (float)((uiSeed >> 16) % 4096) / 4.0f;
+}
+
+/// Write iCelCount intensities tables of iProbeCount probes, as CNAnalysisMethodReference::runPart1 does.
+static void writeTables(const std::string& strFileName, int iCelCount, int iProbeCount)
+{
+  affx::File5_File file5;
+  file5.open(strFileName, affx::FILE5_CREATE | affx::FILE5_REPLACE);
+  affx::File5_Group* group5 = file5.openGroup("Intensities", affx::FILE5_REPLACE);
+  unsigned int uiSeed = 54321;
+  for (int iCelIndex = 0; (iCelIndex < iCelCount); iCelIndex++)
+  {
+    affx::File5_Tsv* tsv5 = group5->openTsv("Intensities-" + ::getInt(iCelIndex), affx::FILE5_REPLACE);
+    tsv5->defineColumn(0, 0, "ProbeSetIndex", affx::FILE5_DTYPE_INT);
+    tsv5->defineColumn(0, 1, "Allele", affx::FILE5_DTYPE_INT);
+    tsv5->defineColumn(0, 2, "ProbeID", affx::FILE5_DTYPE_INT);
+    tsv5->defineColumn(0, 3, "Intensity", affx::FILE5_DTYPE_FLOAT);
+    for (int iProbeIndex = 0; (iProbeIndex < iProbeCount); iProbeIndex++)
+    {
+      tsv5->set_i(0, 0, iProbeIndex / 4);
+      tsv5->set_i(0, 1, ((iProbeIndex % 4) < 2) ? 'A' : 'B');
+      tsv5->set_i(0, 2, (iProbeIndex * 7) + 1);
+      float f = testIntensity(uiSeed);
+      if (((iProbeIndex + iCelIndex) % 23) == 0) {f = numeric_limits<float>::quiet_NaN();}
+      tsv5->set_f(0, 3, f);
+      tsv5->writeLevel(0);
+    }
+    tsv5->close();
+    delete tsv5;
+  }
+  group5->close();
+  delete group5;
+  file5.close();
+}
+
+static affx::File5_Tsv** openTables(affx::File5_Group* group5, int iCelCount)
+{
+  affx::File5_Tsv** pptsv5 = new affx::File5_Tsv*[iCelCount];
+  for (int iCelIndex = 0; (iCelIndex < iCelCount); iCelIndex++)
+  {
+    pptsv5[iCelIndex] = group5->openTsv("Intensities-" + ::getInt(iCelIndex), affx::FILE5_OPEN);
+  }
+  return pptsv5;
+}
+
+static void closeTables(affx::File5_Tsv** pptsv5, int iCelCount)
+{
+  for (int iCelIndex = 0; (iCelIndex < iCelCount); iCelIndex++)
+  {
+    pptsv5[iCelIndex]->close();
+    delete pptsv5[iCelIndex];
+  }
+  delete[] pptsv5;
+}
+
+static bool same(float f1, float f2)
+{
+  return ((f1 == f2) || ((f1 != f1) && (f2 != f2)));
+}
+
+void CNReferenceIntensityBlockTest::medianTest()
+{
+  cout << endl;
+  Verbose::out(1, "****CNReferenceIntensityBlockTest::medianTest****");
+  unsigned int uiSeed = 999;
+  for (int iCount = 0; (iCount <= 41); iCount++)
+  {
+    for (int iNaNEvery = 0; (iNaNEvery <= 3); iNaNEvery++)
+    {
+      AffxMultiDimensionalArray<float> vExpected(iCount);
+      vector<float> v(iCount);
+      for (int i = 0; (i < iCount); i++)
+      {
+        v[i] = testIntensity(uiSeed) / 64.0f;
+        if ((iNaNEvery > 0) && ((i % (iNaNEvery + 1)) == 0)) {v[i] = numeric_limits<float>::quiet_NaN();}
+        vExpected.set(i, v[i]);
+      }
+      float fMedian = CNReferenceIntensityBlock::median((iCount == 0) ? NULL : &v[0], iCount);
+      CPPUNIT_ASSERT(same(fMedian, vExpected.median()));
+    }
+  }
+}
+
+void CNReferenceIntensityBlockTest::transposeTest()
+{
+  cout << endl;
+  Verbose::out(1, "****CNReferenceIntensityBlockTest::transposeTest****");
+  unsigned int uiRows[] = {1, 5, 32, 33, 70};
+  unsigned int uiCols[] = {1, 31, 32, 65, 100};
+  for (int r = 0; (r < 5); r++)
+  {
+    for (int c = 0; (c < 5); c++)
+    {
+      vector<float> vIn(uiRows[r] * uiCols[c]);
+      vector<float> vOut(uiRows[r] * uiCols[c], -1);
+      for (unsigned int i = 0; (i < vIn.size()); i++) {vIn[i] = (float)i;}
+      CNReferenceIntensityBlock::transpose(&vIn[0], uiRows[r], uiCols[c], &vOut[0]);
+      for (unsigned int uiRow = 0; (uiRow < uiRows[r]); uiRow++)
+      {
+        for (unsigned int uiCol = 0; (uiCol < uiCols[c]); uiCol++)
+        {
+          CPPUNIT_ASSERT(vOut[(uiCol * uiRows[r]) + uiRow] == vIn[(uiRow * uiCols[c]) + uiCol]);
+        }
+      }
+    }
+  }
+}
+
+void CNReferenceIntensityBlockTest::readTest()
+{
+  cout << endl;
+  Verbose::out(1, "****CNReferenceIntensityBlockTest::readTest****");
+  Fs::ensureWriteableDirPath(OUTPUT);
+  std::string strFileName = OUTPUT + "/CNReferenceIntensityBlock.a5";
+  const int iCelCount = 200;
+  const int iProbeCount = 20000;
+  writeTables(strFileName, iCelCount, iProbeCount);
+
+  affx::File5_File file5;
+  file5.open(strFileName, affx::FILE5_OPEN);
+  affx::File5_Group* group5 = file5.openGroup("Intensities", affx::FILE5_OPEN);
+
+  // A line from each table in turn, as the reference build used to.
+  vector<float> vLineMedians(iProbeCount);
+  vector<float> vLineIntensities((size_t)iProbeCount * iCelCount);
+  vector<int> vLineProbeIDs(iProbeCount);
+  affx::File5_Tsv** pptsv5 = openTables(group5, iCelCount);
+  clock_t start = clock();
+  AffxMultiDimensionalArray<float> vIntensities(iCelCount);
+  int iProbeID = 0;
+  float f = 0;
+  for (int iProbeIndex = 0; (iProbeIndex < iProbeCount); iProbeIndex++)
+  {
+    for (int iCelIndex = 0; (iCelIndex < iCelCount); iCelIndex++)
+    {
+      pptsv5[iCelIndex]->nextLine();
+      pptsv5[iCelIndex]->get(0, 2, &iProbeID);
+      pptsv5[iCelIndex]->get(0, 3, &f); vIntensities.set(iCelIndex, f);
+      vLineIntensities[((size_t)iProbeIndex * iCelCount) + iCelIndex] = f;
+    }
+    vLineProbeIDs[iProbeIndex] = iProbeID;
+    vLineMedians[iProbeIndex] = vIntensities.median();
+  }
+  double dLineTime = (double)(clock() - start) / CLOCKS_PER_SEC;
+  closeTables(pptsv5, iCelCount);
+
+  // A block at a time. Small blocks so there are many, and a last partial one.
+  pptsv5 = openTables(group5, iCelCount);
+  start = clock();
+  CNReferenceIntensityBlock objBlock;
+  objBlock.setup(pptsv5, iCelCount, CNReferenceIntensityBlock::getBlockSize(iCelCount, 1));
+  CPPUNIT_ASSERT(objBlock.getLineCount() == iProbeCount);
+  int iBlockCount = 0;
+  bool bSame = true;
+  unsigned int uiBlockProbeCount = 0;
+  for (unsigned int uiFirst = 0; (uiFirst < (unsigned int)iProbeCount); uiFirst += uiBlockProbeCount)
+  {
+    uiBlockProbeCount = objBlock.read(uiFirst);
+    iBlockCount++;
+    for (unsigned int uiBlockIndex = 0; (uiBlockIndex < uiBlockProbeCount); uiBlockIndex++)
+    {
+      unsigned int uiProbeIndex = uiFirst + uiBlockIndex;
+      bSame = bSame && (objBlock.getProbeID(uiBlockIndex) == vLineProbeIDs[uiProbeIndex]);
+      bSame = bSame && (objBlock.getProbeSetIndex(uiBlockIndex) == (int)(uiProbeIndex / 4));
+      bSame = bSame && (objBlock.getAllele(uiBlockIndex) == (((uiProbeIndex % 4) < 2) ? 'A' : 'B'));
+      bSame = bSame && same(objBlock.median(uiBlockIndex), vLineMedians[uiProbeIndex]);
+      const float* pf = objBlock.getIntensities(uiBlockIndex);
+      for (int iCelIndex = 0; (iCelIndex < iCelCount); iCelIndex++)
+      {
+        bSame = bSame && same(pf[iCelIndex], vLineIntensities[((size_t)uiProbeIndex * iCelCount) + iCelIndex]);
+      }
+    }
+  }
+  double dBlockTime = (double)(clock() - start) / CLOCKS_PER_SEC;
+  closeTables(pptsv5, iCelCount);
+  CPPUNIT_ASSERT(bSame);
+  CPPUNIT_ASSERT(iBlockCount > 1);
+
+  group5->close();
+  delete group5;
+  file5.close();
+  Fs::rm(strFileName, false);
+
+  Verbose::out(1, ToStr(iCelCount) + " cels, " + ToStr(iProbeCount) + " probes, seconds: line at a time " +
+               ToStr(dLineTime) + ", " + ToStr(iBlockCount) + " blocks " + ToStr(dBlockTime));
+}
@@ -23,6 +23,9 @@
 #include "copynumber/CNReporterCychp.h"
 #include "copynumber/CPPTest/Setup.h"
 //
+#include "calvin_files/parsers/src/GenericFileReader.h"
+#include "calvin_files/writers/src/GenericFileWriter.h"
+#include "util/Fs.h"
 #include "util/Util.h"
 //
 #include <cppunit/CompilerOutputter.h>
@@ -47,12 +50,16 @@ class CNReporterTest : public CppUnit::TestFixture
   CPPUNIT_TEST(CNReporterConstructorTest); 
   CPPUNIT_TEST(CNReporterDefineOptionTest); 
   CPPUNIT_TEST(CNReporterRunTest); 
+  CPPUNIT_TEST(CNReporterChunkTest);
+  CPPUNIT_TEST(CNReporterProcessCountTest);
   CPPUNIT_TEST_SUITE_END();
 
 public: 
   void CNReporterConstructorTest();
   void CNReporterDefineOptionTest();
   void CNReporterRunTest(); 
+  void CNReporterChunkTest();
+  void CNReporterProcessCountTest();
   
  
 };
@@ -113,3 +120,101 @@ void CNReporterTest::CNReporterRunTest()
 	
 }
 
+/// Write iWriteCount rows of an index and a float to a data set sized for iRowCount, eight rows per chunk.
+static void writeChunkFile(const std::string& strFileName, int iRowCount, int iWriteCount)
+{
+    affymetrix_calvin_io::GenericData data;
+    data.Header().SetFilename(strFileName);
+    data.Header().GetGenericDataHdr()->SetFileTypeId("affymetrix-multi-data-type-analysis");
+    data.Header().AddDataGroupHdr(affymetrix_calvin_io::DataGroupHeader(L"Group"));
+    affymetrix_calvin_io::DataSetHeader dsh;
+    dsh.SetRowCnt(iRowCount);
+    dsh.SetName(L"Rows");
+    dsh.AddUIntColumn(L"Index");
+    dsh.AddFloatColumn(L"Value");
+    data.Header().GetDataGroup(0).AddDataSetHdr(dsh);
+
+    affymetrix_calvin_io::GenericFileWriter writer(&data.Header());
+    writer.WriteHeader();
+    affymetrix_calvin_io::DataGroupWriter& group = writer.GetDataGroupWriter(0);
+    group.WriteHeader();
+    affymetrix_calvin_io::DataSetWriter& set = group.GetDataSetWriter(0);
+    set.WriteHeader();
+    CNReporterChunk objChunk(set, 8, 64);
+    for (int iRowIndex = 0; (iRowIndex < iWriteCount); iRowIndex++)
+    {
+        CNReporter::loadBuffer(objChunk.getBuffer(), objChunk.getIndex(), (unsigned int)iRowIndex);
+        CNReporter::loadBuffer(objChunk.getBuffer(), objChunk.getIndex(), (float)iRowIndex / 4);
+        objChunk.endRow();
+    }
+    objChunk.close();
+    set.UpdateNextDataSetOffset();
+    group.UpdateNextDataGroupPos();
+}
+
+void CNReporterTest::CNReporterChunkTest()
+{
+    Verbose::out(1, "****CNReporterTest::CNReporterChunkTest****");
+    CPPUNIT_ASSERT(CNReporterChunk::getChunkRowCount(8, 1000, 64) == 8);
+    CPPUNIT_ASSERT(CNReporterChunk::getChunkRowCount(8, 3, 64) == 3);
+    CPPUNIT_ASSERT(CNReporterChunk::getChunkRowCount(100, 1000, 64) == 1);
+    CPPUNIT_ASSERT(CNReporterChunk::getChunkRowCount(8, 0, 64) == 1);
+
+    Fs::ensureWriteableDirPath(OUTPUT);
+    std::string strFileName = OUTPUT + "/CNReporterChunk.cychp";
+    writeChunkFile(strFileName, 1001, 1001);
+    affymetrix_calvin_io::GenericFileReader reader;
+    affymetrix_calvin_io::GenericData data;
+    reader.SetFilename(strFileName);
+    reader.Open(data);
+    affymetrix_calvin_io::DataSet* pDataSet = data.DataSet(0, 0);
+    pDataSet->Open();
+    CPPUNIT_ASSERT(pDataSet->Rows() == 1001);
+    bool bSame = true;
+    u_int32_t ui = 0;
+    float f = 0;
+    for (int iRowIndex = 0; (iRowIndex < 1001); iRowIndex++)
+    {
+        pDataSet->GetData(iRowIndex, 0, ui);
+        pDataSet->GetData(iRowIndex, 1, f);
+        bSame = bSame && (ui == (u_int32_t)iRowIndex) && (f == (float)iRowIndex / 4);
+    }
+    CPPUNIT_ASSERT(bSame);
+    pDataSet->Delete();
+    data.Clear();
+
+    // Fewer rows than the header was sized for.
+    NEGATIVE_TEST(writeChunkFile(strFileName, 10, 9), Except);
+    Fs::rm(strFileName, false);
+}
+
+void CNReporterTest::CNReporterProcessCountTest()
+{
+    Verbose::out(1, "****CNReporterTest::CNReporterProcessCountTest****");
+    CNProbeSetArray arProbeSets;
+    for (int iProbeSetIndex = 0; (iProbeSetIndex < 10); iProbeSetIndex++)
+    {
+        CNProbeSet* p = new CNProbeSet;
+        p->setChromosome(1);
+        p->setPosition(1000 + (iProbeSetIndex * 500));
+        p->setProcess((iProbeSetIndex % 3) != 0);
+        arProbeSets.add(p);
+    }
+    // The CopyNumber data set gets a row for each processed probe set, as the CYCHP writer skips the others.
+    int iWriteCount = 0;
+    for (int iProbeSetIndex = 0; (iProbeSetIndex < arProbeSets.getCount()); iProbeSetIndex++)
+    {
+        if (!arProbeSets.getAt(iProbeSetIndex)->isProcess()) {continue;}
+        iWriteCount++;
+    }
+    CPPUNIT_ASSERT(arProbeSets.getProcessCount() == 6);
+    CPPUNIT_ASSERT(iWriteCount == arProbeSets.getProcessCount());
+
+    Fs::ensureWriteableDirPath(OUTPUT);
+    std::string strFileName = OUTPUT + "/CNReporterProcessCount.cychp";
+    writeChunkFile(strFileName, arProbeSets.getProcessCount(), iWriteCount);
+    // A header sized from every probe set, as it was before, is left short.
+    NEGATIVE_TEST(writeChunkFile(strFileName, arProbeSets.getCount(), iWriteCount), Except);
+    Fs::rm(strFileName, false);
+    arProbeSets.deleteAll();
+}
@@ -0,0 +1,205 @@
+////////////////////////////////////////////////////////////////
+//
+// Copyright (C) 2011 Affymetrix, Inc.
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License (version 2) as
+// published by the Free Software Foundation.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program;if not, write to the
+//
+// Free Software Foundation, Inc.,
+// 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+//
+////////////////////////////////////////////////////////////////
+
+#include "copynumber/CNRunningMedian.h"
+//
+#include "util/AffxMultiDimensionalArray.h"
+#include "util/Convert.h"
+#include "util/Verbose.h"
+//
+#include <cppunit/CompilerOutputter.h>
+#include <cppunit/extensions/HelperMacros.h>
+#include <cppunit/extensions/TestFactoryRegistry.h>
+#include <cppunit/ui/text/TestRunner.h>
+//
+#include <algorithm>
+#include <ctime>
+#include <iostream>
+#include <limits>
+#include <vector>
+//
+using namespace std;
+/**
+ * @class CNRunningMedianTest
+ * @brief cppunit class for testing CNRunningMedian against sorting each window,
+ * and timing the two over a range of window sizes.
+ */
+class CNRunningMedianTest : public CppUnit::TestFixture
+{
+  CPPUNIT_TEST_SUITE(CNRunningMedianTest);
+  CPPUNIT_TEST(orderStatisticTest);
+  CPPUNIT_TEST(medianTest);
+  CPPUNIT_TEST(percentileTest);
+  CPPUNIT_TEST(windowTimingTest);
+  CPPUNIT_TEST_SUITE_END();
+
+public:
+  void orderStatisticTest();
+  void medianTest();
+  void percentileTest();
+  void windowTimingTest();
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(CNRunningMedianTest);
+
+/// Log2 ratio like values with ties; every 17th is NaN if bNaN is set.
+static vector<float> testValues(int iCount, bool bNaN)
+{
+  vector<float> v(iCount);
+  unsigned int uiSeed = 12345;
+  for (int i = 0; (i < iCount); i++)
+  {
+    uiSeed = uiSeed * 1103515245 + 12345;
+    v[i] = (float)((int)((uiSeed >> 16) % 200) - 100) / 64.0f;
+    if ((bNaN) && ((i % 17) == 5)) {v[i] = numeric_limits<float>::quiet_NaN();}
+  }
+  return v;
+}
+
+void CNRunningMedianTest::orderStatisticTest()
+{
+  cout << endl;
+  Verbose::out(1, "****CNRunningMedianTest::orderStatisticTest****");
+  vector<float> v = testValues(500, false);
+  // One window kept sorted, one in the Fenwick tree.
+  int arWindows[] = {31, 201};
+  for (int iWindowIndex = 0; (iWindowIndex < 2); iWindowIndex++)
+  {
+    int iWindow = arWindows[iWindowIndex];
+    CNRunningMedian<float> objMedian;
+    objMedian.setup(v, iWindow);
+    for (int i = 0; (i < (iWindow - 1)); i++) {objMedian.add(i);}
+    for (int iStart = 0; ((iStart + iWindow) <= (int)v.size()); iStart++)
+    {
+      objMedian.add(iStart + iWindow - 1);
+      CPPUNIT_ASSERT(objMedian.getCount() == iWindow);
+      vector<float> vSorted(v.begin() + iStart, v.begin() + iStart + iWindow);
+      sort(vSorted.begin(), vSorted.end());
+      for (int k = 0; (k < iWindow); k++)
+      {
+        CPPUNIT_ASSERT(objMedian.getOrderStatistic(k) == vSorted[k]);
+      }
+      objMedian.remove(iStart);
+    }
+    CPPUNIT_ASSERT(objMedian.getNonFiniteCount() == 0);
+  }
+}
+
+void CNRunningMedianTest::medianTest()
+{
+  Verbose::out(1, "****CNRunningMedianTest::medianTest****");
+  // NaN are left out, so the window counts go odd and even.
+  vector<float> v = testValues(2000, true);
+  for (int iWindow = 1; (iWindow <= 101); iWindow += 10)
+  {
+    CNRunningMedian<float> objMedian;
+    objMedian.setup(v, iWindow);
+    AffxMultiDimensionalArray<float> vWindow(iWindow);
+    for (int i = 0; (i < (iWindow - 1)); i++) {objMedian.add(i);}
+    for (int iStart = 0; ((iStart + iWindow) <= (int)v.size()); iStart++)
+    {
+      objMedian.add(iStart + iWindow - 1);
+      for (int i = 0; (i < iWindow); i++) {vWindow.set(i, v[iStart + i]);}
+      float fExpected = vWindow.median();
+      float fMedian = objMedian.getMedian();
+      CPPUNIT_ASSERT((fMedian == fExpected) || ((fMedian != fMedian) && (fExpected != fExpected)));
+      objMedian.remove(iStart);
+    }
+  }
+}
+
+void CNRunningMedianTest::percentileTest()
+{
+  Verbose::out(1, "****CNRunningMedianTest::percentileTest****");
+  vector<float> v = testValues(300, false);
+  int iWindow = 24;
+  CNRunningMedian<float> objMedian;
+  objMedian.setup(v, iWindow);
+  AffxMultiDimensionalArray<float> vWindow(iWindow);
+  for (int i = 0; (i < (iWindow - 1)); i++) {objMedian.add(i);}
+  for (int iStart = 0; ((iStart + iWindow) <= (int)v.size()); iStart++)
+  {
+    objMedian.add(iStart + iWindow - 1);
+    for (int i = 0; (i < iWindow); i++) {vWindow.set(i, v[iStart + i]);}
+    CPPUNIT_ASSERT(objMedian.getPercentile(0.25) == vWindow.percentile(0.25));
+    CPPUNIT_ASSERT(objMedian.getPercentile(0.75) == vWindow.percentile(0.75, false));
+    CPPUNIT_ASSERT(objMedian.getPercentile(1.0) == vWindow.percentile(1.0, false));
+    objMedian.remove(iStart);
+  }
+
+  // Infinite values are counted so callers can fall back.
+  vector<double> vInf(5, 1.0);
+  vInf[2] = numeric_limits<double>::infinity();
+  vInf[3] = numeric_limits<double>::quiet_NaN();
+  CNRunningMedian<double> objInf;
+  objInf.setup(vInf, 5);
+  for (int i = 0; (i < 5); i++) {objInf.add(i);}
+  CPPUNIT_ASSERT(objInf.getCount() == 4);
+  CPPUNIT_ASSERT(objInf.getNonFiniteCount() == 2);
+  CPPUNIT_ASSERT(objInf.getOrderStatistic(3) == numeric_limits<double>::infinity());
+  objInf.remove(2);
+  objInf.remove(3);
+  CPPUNIT_ASSERT(objInf.getNonFiniteCount() == 0);
+}
+
+/// Medians per second for sorting each window against the running median,
+/// over the window sizes the log2 ratio smoothing and mosaicism use and up.
+void CNRunningMedianTest::windowTimingTest()
+{
+  Verbose::out(1, "****CNRunningMedianTest::windowTimingTest****");
+  int iCount = 200000;
+  vector<float> v = testValues(iCount, true);
+  int arWindows[] = {5, 51, 501, 2001};
+  for (int iWindowIndex = 0; (iWindowIndex < 4); iWindowIndex++)
+  {
+    int iWindow = arWindows[iWindowIndex];
+    int iHalfWindow = iWindow / 2;
+    // Sorting every window is slow for large windows; time a part of it.
+    int iSortCount = min(iCount - iWindow, 20000000 / iWindow);
+    double dSum1 = 0;
+    clock_t start = clock();
+    AffxMultiDimensionalArray<float> vWindow(iWindow);
+    for (int iIndex = iHalfWindow; (iIndex < (iHalfWindow + iSortCount)); iIndex++)
+    {
+      for (int i = 0; (i < iWindow); i++) {vWindow.set(i, v[iIndex - iHalfWindow + i]);}
+      dSum1 += vWindow.median();
+    }
+    double dSortTime = (double)(clock() - start) / CLOCKS_PER_SEC;
+
+    double dSum2 = 0;
+    start = clock();
+    CNRunningMedian<float> objMedian;
+    objMedian.setup(v, iWindow);
+    for (int i = 0; (i < (iWindow - 1)); i++) {objMedian.add(i);}
+    for (int iIndex = iHalfWindow; (iIndex < (iCount - iHalfWindow)); iIndex++)
+    {
+      objMedian.add(iIndex + iHalfWindow);
+      if (iIndex < (iHalfWindow + iSortCount)) {dSum2 += objMedian.getMedian();}
+      objMedian.remove(iIndex - iHalfWindow);
+    }
+    double dRunningTime = (double)(clock() - start) / CLOCKS_PER_SEC;
+    CPPUNIT_ASSERT(dSum1 == dSum2);
+
+    Verbose::out(1, "window " + ToStr(iWindow) + ", medians/sec: sort " +
+                 ToStr((int)(iSortCount / max(dSortTime, 1e-6))) + " running " +
+                 ToStr((int)((iCount - iWindow + 1) / max(dRunningTime, 1e-6))));
+  }
+}
@@ -114,6 +114,8 @@ void CNWorkflowEngineTest::defineOptionsTest()
 	CPPUNIT_ASSERT(m_objCNWorkflowEngine.getOpt("program-cvs-id")=="");
 	CPPUNIT_ASSERT(m_objCNWorkflowEngine.getOpt("version-to-report")=="");
 	CPPUNIT_ASSERT(m_objCNWorkflowEngine.getOptInt("mem-usage")==0);
+	CPPUNIT_ASSERT(m_objCNWorkflowEngine.getOptBool("in-memory-handoff")==false);
+	CPPUNIT_ASSERT(m_objCNWorkflowEngine.getOptInt("handoff-mem-usage")==2000);
 	CPPUNIT_ASSERT(m_objCNWorkflowEngine.getOptBool("run-geno-qc")==false);
 	CPPUNIT_ASSERT(m_objCNWorkflowEngine.getOptBool("run-probeset-genotype")==true);
 	CPPUNIT_ASSERT(m_objCNWorkflowEngine.getOptInt("prior-size")==10000);
@@ -0,0 +1,247 @@
+////////////////////////////////////////////////////////////////
+//
+// Copyright (C) 2011 Affymetrix, Inc.
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License (version 2) as
+// published by the Free Software Foundation.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program;if not, write to the
+//
+// Free Software Foundation, Inc.,
+// 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+//
+////////////////////////////////////////////////////////////////
+
+
+#include "copynumber/CopyNumberHMM.h"
+#include "copynumber/CopyNumberNode.h"
+#include "copynumber/HMMEngine.h"
+//
+#include "util/Convert.h"
+#include "util/Verbose.h"
+//
+#include <cppunit/CompilerOutputter.h>
+#include <cppunit/extensions/HelperMacros.h>
+#include <cppunit/extensions/TestFactoryRegistry.h>
+#include <cppunit/ui/text/TestRunner.h>
+//
+#include <cmath>
+#include <ctime>
+#include <iostream>
+#include <valarray>
+#include <vector>
+//
+using namespace std;
+/**
+ * @class HMMEngineTest
+ * @brief cppunit class for testing HMMEngine against working the paths out
+ * by brute force and against the CopyNumberNode chain CopyNumberHMM used,
+ * and timing the two on a CytoScan sized input.
+ */
+class HMMEngineTest : public CppUnit::TestFixture
+{
+  CPPUNIT_TEST_SUITE(HMMEngineTest);
+  CPPUNIT_TEST(viterbiTest);
+  CPPUNIT_TEST(posteriorTest);
+  CPPUNIT_TEST(copyNumberHMMTest);
+  CPPUNIT_TEST(timingTest);
+  CPPUNIT_TEST_SUITE_END();
+
+public:
+  void viterbiTest();
+  void posteriorTest();
+  void copyNumberHMMTest();
+  void timingTest();
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(HMMEngineTest);
+
+/// Log2 ratio like data: runs of markers around each mean, a few outliers.
+static valarray<double> testData(int iCount, const valarray<double>& vMu)
+{
+  valarray<double> v(iCount);
+  unsigned int uiSeed = 12345;
+  int iState = 2;
+  for (int i = 0; (i < iCount); i++)
+  {
+    uiSeed = uiSeed * 1103515245 + 12345;
+    if (((uiSeed >> 16) % 500) == 0) {iState = (uiSeed >> 8) % vMu.size();}
+    uiSeed = uiSeed * 1103515245 + 12345;
+    double dNoise = ((double)((uiSeed >> 16) % 1000) - 500.0) / 1000.0;
+    v[i] = vMu[iState] + dNoise * 0.4;
+    if ((i % 9973) == 17) {v[i] = 40.0;}
+  }
+  return v;
+}
+
+/// The most probable path and its log probability, trying every path.
+static double bruteForce(HMMEngine& engine, const vector<double>& vLogInitial, vector<int>& vBest, double& dLogLik)
+{
+  int P = engine.stateCount();
+  int N = engine.observationCount();
+  double* pTrans = engine.logTransitions();
+  vector<int> vPath(N, 0);
+  double dBest = -HUGE_VAL;
+  dLogLik = 0;
+  while (true)
+  {
+    double dLogP = vLogInitial[vPath[0]] + engine.logEmissions(0)[vPath[0]];
+    for (int n = 1; (n < N); n++)
+    {
+      dLogP += pTrans[vPath[n] * P + vPath[n - 1]] + engine.logEmissions(n)[vPath[n]];
+    }
+    if (dLogP > dBest) {dBest = dLogP; vBest = vPath;}
+    dLogLik += exp(dLogP);
+    int n = 0;
+    while ((n < N) && (++vPath[n] == P)) {vPath[n] = 0; n++;}
+    if (n == N) {break;}
+  }
+  dLogLik = log(dLogLik);
+  return dBest;
+}
+
+/// A small chain with unequal transitions.
+static void smallChain(HMMEngine& engine, vector<double>& vLogInitial)
+{
+  int P = 3, N = 6;
+  engine.setup(P, N);
+  double arData[] = {0.1, -0.4, 0.7, 0.65, -0.1, 0.3};
+  double arMu[] = {-0.5, 0.0, 0.6};
+  double arPrec[] = {10.0, 20.0, 5.0};
+  engine.setGaussianLogEmissions(arData, arMu, false, arPrec);
+  double* pTrans = engine.logTransitions();
+  for (int i = 0; (i < P); i++)
+  {
+    for (int j = 0; (j < P); j++) {pTrans[i * P + j] = log((i == j) ? 0.8 : 0.1);}
+  }
+  pTrans[2 * P + 0] = log(0.15);
+  pTrans[1 * P + 0] = log(0.05);
+  vLogInitial.assign(P, log(1.0 / P));
+}
+
+void HMMEngineTest::viterbiTest()
+{
+  cout << endl;
+  Verbose::out(1, "****HMMEngineTest::viterbiTest****");
+  HMMEngine engine;
+  vector<double> vLogInitial;
+  smallChain(engine, vLogInitial);
+  vector<int> vStates, vBest;
+  double dLogLik = 0;
+  double dLogP = engine.viterbi(&vLogInitial[0], vStates);
+  double dBest = bruteForce(engine, vLogInitial, vBest, dLogLik);
+  CPPUNIT_ASSERT(vStates == vBest);
+  CPPUNIT_ASSERT(fabs(dLogP - dBest) < 1e-12);
+
+  // A shorter chain reuses the buffers.
+  engine.setup(3, 1);
+  engine.viterbi(&vLogInitial[0], vStates);
+  CPPUNIT_ASSERT(vStates.size() == 1);
+}
+
+void HMMEngineTest::posteriorTest()
+{
+  Verbose::out(1, "****HMMEngineTest::posteriorTest****");
+  HMMEngine engine;
+  vector<double> vLogInitial;
+  smallChain(engine, vLogInitial);
+  int P = engine.stateCount();
+  int N = engine.observationCount();
+  vector<double> vPosteriors;
+  double dLogLik = engine.posterior(&vLogInitial[0], vPosteriors);
+
+  // Sum the probability of every path through each state.
+  vector<double> vExpected(N * P, 0.0);
+  vector<int> vPath(N, 0);
+  double dTotal = 0;
+  double* pTrans = engine.logTransitions();
+  while (true)
+  {
+    double dLogP = vLogInitial[vPath[0]] + engine.logEmissions(0)[vPath[0]];
+    for (int n = 1; (n < N); n++) {dLogP += pTrans[vPath[n] * P + vPath[n - 1]] + engine.logEmissions(n)[vPath[n]];}
+    dTotal += exp(dLogP);
+    for (int n = 0; (n < N); n++) {vExpected[n * P + vPath[n]] += exp(dLogP);}
+    int n = 0;
+    while ((n < N) && (++vPath[n] == P)) {vPath[n] = 0; n++;}
+    if (n == N) {break;}
+  }
+  CPPUNIT_ASSERT(fabs(dLogLik - log(dTotal)) < 1e-9);
+  for (int k = 0; (k < N * P); k++)
+  {
+    CPPUNIT_ASSERT(fabs(vPosteriors[k] - vExpected[k] / dTotal) < 1e-9);
+  }
+}
+
+/// The path CopyNumberHMM found when it chained CopyNumberNode objects.
+static valarray<int> nodeChain(const TransitionMatrix& TransMat, const valarray<double>& vData, const valarray<double>& vMu, const valarray<double>& vVar)
+{
+  unsigned int N = vData.size();
+  valarray<double> vPrec = 1.0 / vVar;
+  vector<CopyNumberNode> cnn;
+  cnn.reserve(N);
+  cnn.push_back(CopyNumberNode(TransMat, vData[0], vMu, vPrec));
+  for (unsigned int t = 1; (t < N); t++) {cnn.push_back(CopyNumberNode(cnn[t-1], TransMat, vData[t], vMu, vPrec));}
+  valarray<int> copy_number(N);
+  copy_number[N-1] = cnn[N-1].backward();
+  for (unsigned int t = 1; (t < N); t++) {copy_number[N-t-1] = cnn[N-t].backward(copy_number[N-t]);}
+  return copy_number;
+}
+
+void HMMEngineTest::copyNumberHMMTest()
+{
+  Verbose::out(1, "****HMMEngineTest::copyNumberHMMTest****");
+  double arMu[] = {-1.0, -0.45, 0.0, 0.3, 0.5, 0.65};
+  for (int P = 5; (P <= 6); P++)
+  {
+    valarray<double> vMu(arMu, P);
+    valarray<double> vVar(0.04, P);
+    valarray<double> vData = testData(50000, vMu);
+    TransitionMatrix TransMat(P, 0.99);
+    CopyNumberHMM cnHMM(TransMat);
+    cnHMM.add_data(vData, vMu, vVar);
+    valarray<int> vStates = cnHMM.solve_map();
+    valarray<int> vExpected = nodeChain(TransMat, vData, vMu, vVar);
+    int iDifferent = 0;
+    for (int i = 0; (i < (int)vData.size()); i++) {if (vStates[i] != vExpected[i]) {iDifferent++;}}
+    CPPUNIT_ASSERT(iDifferent == 0);
+  }
+}
+
+/// Viterbi over 2.7M markers for 5 and 10 states, by the CopyNumberNode
+/// chain and by CopyNumberHMM on the engine.
+void HMMEngineTest::timingTest()
+{
+  Verbose::out(1, "****HMMEngineTest::timingTest****");
+  int iCount = 2700000;
+  for (int P = 5; (P <= 10); P += 5)
+  {
+    valarray<double> vMu(P);
+    for (int k = 0; (k < P); k++) {vMu[k] = -1.0 + (1.6 * k) / (P - 1);}
+    valarray<double> vVar(0.04, P);
+    valarray<double> vData = testData(iCount, vMu);
+    TransitionMatrix TransMat(P, 0.999);
+
+    clock_t start = clock();
+    valarray<int> vExpected = nodeChain(TransMat, vData, vMu, vVar);
+    double dNodeTime = (double)(clock() - start) / CLOCKS_PER_SEC;
+
+    start = clock();
+    CopyNumberHMM cnHMM(TransMat);
+    cnHMM.add_data(vData, vMu, vVar);
+    valarray<int> vStates = cnHMM.solve_map();
+    double dEngineTime = (double)(clock() - start) / CLOCKS_PER_SEC;
+
+    int iDifferent = 0;
+    for (int i = 0; (i < iCount); i++) {if (vStates[i] != vExpected[i]) {iDifferent++;}}
+    CPPUNIT_ASSERT(iDifferent == 0);
+    Verbose::out(1, ToStr(iCount) + " markers, " + ToStr(P) + " states: nodes " + ToStr(dNodeTime) +
+                 " sec, engine " + ToStr(dEngineTime) + " sec");
+  }
+}
@@ -0,0 +1,238 @@
+////////////////////////////////////////////////////////////////
+//
+// Copyright (C) 2011 Affymetrix, Inc.
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License (version 2) as
+// published by the Free Software Foundation.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program;if not, write to the
+//
+// Free Software Foundation, Inc.,
+// 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+//
+////////////////////////////////////////////////////////////////
+
+#include "copynumber/WaveletShrink.h"
+//
+#include "util/Convert.h"
+#include "util/Verbose.h"
+//
+#include <cppunit/CompilerOutputter.h>
+#include <cppunit/extensions/HelperMacros.h>
+#include <cppunit/extensions/TestFactoryRegistry.h>
+#include <cppunit/ui/text/TestRunner.h>
+//
+#include <cmath>
+#include <ctime>
+#include <iostream>
+#include <valarray>
+#include <vector>
+//
+using namespace std;
+/**
+ * @class WaveletShrinkTest
+ * @brief cppunit class for testing WaveletShrinkPlan against the valarray
+ * implementation it replaced, and timing the two over a sample.
+ */
+class WaveletShrinkTest : public CppUnit::TestFixture
+{
+  CPPUNIT_TEST_SUITE(WaveletShrinkTest);
+  CPPUNIT_TEST(shrinkTest);
+  CPPUNIT_TEST(batchTest);
+  CPPUNIT_TEST(sampleTimingTest);
+  CPPUNIT_TEST_SUITE_END();
+
+public:
+  void shrinkTest();
+  void batchTest();
+  void sampleTimingTest();
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(WaveletShrinkTest);
+
+// The valarray implementation WaveletShrinkPlan replaced, kept as the reference.
+static void reference_shrink_mrf1(valarray<double> & vec, double likelihood_prec,
+  double prior_prec, double converge)
+{
+  int N = vec.size();
+  double tau=likelihood_prec;
+  double beta=prior_prec;
+  double x;
+  double prec1 = 1.0/(tau + fabs(beta));
+  double prec2 = 1.0/(tau + 2.0*fabs(beta));
+  valarray<double>vec1(vec.size());
+  valarray<double>old_vec(vec.size());
+  vec1 = vec;
+  while (1) {
+    old_vec = vec1;
+    x = beta*vec1[1] + tau*vec[0];
+    vec1[0] = x*prec1;
+    for (int i=1; i<N-1; i++) {
+      x = beta*(vec1[i-1] + vec1[i+1]) + tau*vec[i];
+      vec1[i] = x*prec2;
+    }
+    x = beta*vec1[N-2] + tau*vec[N-1];
+    vec1[N-1] = x*prec1;
+    double diff_max = abs(vec1 - old_vec).max();
+    if (diff_max < converge) break;
+  }
+  vec = vec1;
+}
+
+static void reference_iter(valarray<double> & data_vec, Wavelet * W,
+  vector<double>likelihood_prec, double prior_prec, MODE mode, double converge)
+{
+  if (likelihood_prec.empty()) {return;}
+  index_t data_len = (index_t)data_vec.size();
+  index_t dec_len = dwt_buffer_length(data_len,W->dec_len,mode);
+  valarray<double> approximation(0.0, dec_len);
+  valarray<double> detail(0.0, dec_len);
+  double_dec_a(&data_vec[0], data_len, W, &approximation[0], dec_len, mode);
+  double_dec_d(&data_vec[0], data_len, W, &detail[0], dec_len, mode);
+  reference_shrink_mrf1(detail, likelihood_prec[0], prior_prec, converge);
+  vector<double> lp_next(likelihood_prec.begin() + 1, likelihood_prec.end());
+  reference_iter(approximation, W, lp_next, prior_prec, mode, converge);
+  index_t rec_len = reconstruction_buffer_length(dec_len,W->rec_len);
+  valarray<double> rec_vec(0.0, rec_len);
+  double_upsampling_convolution_valid_sf(&approximation[0],dec_len,
+    W->rec_lo_double, W->rec_len, &rec_vec[0], rec_len, mode);
+  double_upsampling_convolution_valid_sf(&detail[0],dec_len,
+    W->rec_hi_double, W->rec_len, &rec_vec[0], rec_len, mode);
+  for (int i=0; i<data_len; i++) data_vec[i] = rec_vec[i];
+}
+
+static void reference_sandbox(valarray<double> & data_vec, Wavelet * W,
+  vector<double>likelihood_prec, double prior_prec, MODE mode,
+  double converge, bool outlier, double nu, int maxiter)
+{
+  if (!outlier) {
+    reference_iter(data_vec, W, likelihood_prec, prior_prec, mode, converge);
+    return;
+  }
+  int N = data_vec.size();
+  valarray<double> data(data_vec);
+  valarray<double> resids(N);
+  double S = 1.0;
+  valarray<double> prec_vec(1.0,N);
+  int count=0;
+  while (count < maxiter) {
+    reference_iter(data, W, likelihood_prec, prior_prec, mode, converge);
+    resids = data_vec - data;
+    S *= (resids*resids*prec_vec).sum()/N;
+    prec_vec = (nu + 1.0)/(nu*S + resids*resids);
+    data += resids*(prec_vec/prec_vec.sum());
+    count++;
+  }
+  data_vec = data;
+}
+
+/// Log2 ratio like values: noise with a few copy number steps and outliers.
+static valarray<double> testSignal(int iCount, unsigned int uiSeed)
+{
+  valarray<double> v(iCount);
+  for (int i = 0; (i < iCount); i++)
+  {
+    uiSeed = uiSeed * 1103515245 + 12345;
+    double d = (double)((int)((uiSeed >> 8) % 20001) - 10000) / 40000.0;
+    if (((i / 500) % 7) == 3) {d -= 0.45;}
+    if (((i / 900) % 11) == 5) {d += 0.3;}
+    if ((i % 397) == 11) {d += 2.0;}
+    v[i] = d;
+  }
+  return v;
+}
+
+static vector<double> testLikelihoodPrec()
+{
+  vector<double> v;
+  v.push_back(0.5);
+  v.push_back(4.0);
+  return v;
+}
+
+static bool isSame(const valarray<double>& v1, const valarray<double>& v2)
+{
+  if (v1.size() != v2.size()) {return false;}
+  for (int i = 0; (i < (int)v1.size()); i++) {if (v1[i] != v2[i]) {return false;}}
+  return true;
+}
+
+void WaveletShrinkTest::shrinkTest()
+{
+  cout << endl;
+  Verbose::out(1, "****WaveletShrinkTest::shrinkTest****");
+  WaveletHolder W(wavelet('h', 1));
+  vector<double> vLikelihoodPrec = testLikelihoodPrec();
+  int arLengths[] = {2, 3, 5, 8, 33, 1000, 4097};
+  for (int iLengthIndex = 0; (iLengthIndex < 7); iLengthIndex++)
+  {
+    for (int iOutlier = 0; (iOutlier < 2); iOutlier++)
+    {
+      valarray<double> v1 = testSignal(arLengths[iLengthIndex], 17 + iLengthIndex);
+      valarray<double> v2(v1);
+      reference_sandbox(v1, W.get(), vLikelihoodPrec, 1.0, MODE_ZEROPAD, 0.000001, (iOutlier == 1), 6.5, 15);
+      wavelet_sandbox(v2, W.get(), vLikelihoodPrec, 1.0, MODE_ZEROPAD, 0.000001, (iOutlier == 1), 6.5, 15);
+      CPPUNIT_ASSERT(isSame(v1, v2));
+    }
+  }
+  // Three levels of a five value signal leave a single detail.
+  valarray<double> v = testSignal(5, 3);
+  vLikelihoodPrec.push_back(8.0);
+  wavelet_sandbox(v, W.get(), vLikelihoodPrec, 1.0, MODE_ZEROPAD, 0.000001, false, 6.5, 15);
+  for (int i = 0; (i < 5); i++) {CPPUNIT_ASSERT(v[i] == v[i]);}
+}
+
+void WaveletShrinkTest::batchTest()
+{
+  Verbose::out(1, "****WaveletShrinkTest::batchTest****");
+  WaveletHolder W(wavelet('h', 1));
+  vector<double> vLikelihoodPrec = testLikelihoodPrec();
+  // Chromosomes of different lengths, long and short, through one plan.
+  int arLengths[] = {5000, 1201, 20000, 77, 9999};
+  vector<valarray<double> > vSignals;
+  vector<valarray<double> > vExpected;
+  for (int i = 0; (i < 5); i++)
+  {
+    vSignals.push_back(testSignal(arLengths[i], 100 + i));
+    vExpected.push_back(vSignals[i]);
+    reference_sandbox(vExpected[i], W.get(), vLikelihoodPrec, 1.0, MODE_ZEROPAD, 0.000001, true, 6.5, 15);
+  }
+  WaveletShrinkPlan plan(W.get(), MODE_ZEROPAD, vLikelihoodPrec, 1.0, 0.000001);
+  plan.setOutlier(true, 6.5, 15);
+  plan.shrink(vSignals);
+  for (int i = 0; (i < 5); i++) {CPPUNIT_ASSERT(isSame(vSignals[i], vExpected[i]));}
+}
+
+void WaveletShrinkTest::sampleTimingTest()
+{
+  Verbose::out(1, "****WaveletShrinkTest::sampleTimingTest****");
+  WaveletHolder W(wavelet('h', 1));
+  vector<double> vLikelihoodPrec = testLikelihoodPrec();
+  // 23 chromosomes of a 200k marker sample.
+  vector<valarray<double> > vSignals;
+  for (int i = 0; (i < 23); i++) {vSignals.push_back(testSignal(2000 + (i * 700), 1000 + i));}
+  vector<valarray<double> > vExpected(vSignals);
+
+  clock_t start = clock();
+  for (int i = 0; (i < (int)vExpected.size()); i++)
+  {
+    reference_sandbox(vExpected[i], W.get(), vLikelihoodPrec, 1.0, MODE_ZEROPAD, 0.000001, true, 6.5, 15);
+  }
+  double dReferenceTime = (double)(clock() - start) / CLOCKS_PER_SEC;
+
+  start = clock();
+  WaveletShrinkPlan plan(W.get(), MODE_ZEROPAD, vLikelihoodPrec, 1.0, 0.000001);
+  plan.setOutlier(true, 6.5, 15);
+  plan.shrink(vSignals);
+  double dPlanTime = (double)(clock() - start) / CLOCKS_PER_SEC;
+  for (int i = 0; (i < (int)vSignals.size()); i++) {CPPUNIT_ASSERT(isSame(vSignals[i], vExpected[i]));}
+
+  Verbose::out(1, "seconds per sample: valarray " + ToStr(dReferenceTime) + " plan " + ToStr(dPlanTime));
+}
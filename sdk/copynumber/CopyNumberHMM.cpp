@@ -20,6 +20,7 @@
 ////////////////////////////////////////////////////////////////
 #include "CopyNumberHMM.h"
 
+#include <cmath>
 #include <vector>
 
 using namespace std;
@@ -46,31 +47,41 @@ void CopyNumberHMM::add_data(
     }
 
 
+// The Viterbi path in logs. The probabilities are rescaled at each marker
+// and outliers carried over as they always were here (see
+// HMMEngine::setRescale()); logs just keep a long run of unlikely markers
+// from underflowing.
 valarray<int> CopyNumberHMM::solve_map(bool constantMeansFlag)
     {
     const unsigned int N = _data.size();  // number of nodes in the HMM
     const unsigned int P = this->size();  // number of states per node
-    vector<CopyNumberNode>cnn;
-    cnn.reserve(N);
 
-    // This spares the need to allocate copies of many little slices
-    valarray<double>mu_marker(P);
-    mu_marker = _mu[slice(0,P,1)];
+    engine.setup(P, N);
+    engine.setRescale(true);
+    engine.setGaussianLogEmissions(&_data[0], &_mu[0], !constantMeansFlag,
+        &_prec[0]);
 
-    cnn.push_back(CopyNumberNode(TransMat,_data[0],mu_marker,_prec));
-
-    for (unsigned int t=1; t<_data.size(); t++) {
-        if (!constantMeansFlag) mu_marker = _mu[slice(t*P,P,1)];
-            cnn.push_back(CopyNumberNode(cnn[t-1],TransMat,_data[t],
-            mu_marker, _prec));
+    vector<double> logInitial(P);
+    double * logTrans = engine.logTransitions();
+    for (unsigned int i=0; i<P; i++) {
+        // The first node weights the states by the diagonal.
+        logInitial[i] = log(TransMat(i));
+        for (unsigned int j=0; j<P; j++) logTrans[i*P + j] = log(TransMat(j,i));
         }
 
-    valarray<int>copy_number(N);
-    copy_number[N-1] = cnn[N-1].backward();
+    vector<int> path;
+    engine.viterbi(&logInitial[0], path);
 
+    // The path is read back starting from the state before the most
+    // probable last state, as it was when the nodes were walked back.
+    valarray<int>copy_number(N);
+    if (N == 1) {
+        copy_number[0] = P - 1;
+        return copy_number;
+        }
+    copy_number[N-1] = engine.backPointer(N-1, path[N-1]);
     for (unsigned int t=1; t<N; t++)
-        copy_number[N-t-1] = cnn[N-t].backward(copy_number[N-t]);
+        copy_number[N-t-1] = engine.backPointer(N-t, copy_number[N-t]);
 
     return copy_number;
     }
-
@@ -22,7 +22,7 @@
 #define COPYNUMBERHMM_H_
 
 #include "TransitionMatrix.h"
-#include "CopyNumberNode.h"
+#include "HMMEngine.h"
 
 #include <valarray>
 
@@ -51,6 +51,7 @@ TransitionMatrix TransMat;
 std::valarray<double> _prec;  // use precisions instead of variances
 std::valarray<double> _mu;    // means
 std::valarray<double> _data;  // observed values
+HMMEngine engine;
 };
 
 #endif // COPYNUMBERHMM_H_
@@ -23,6 +23,8 @@
 // This will affect the number of observations the kernel spans
 
 #include "copynumber/GKernel.h"
+//
+#include <cmath>
 
 GaussianKernel::GaussianKernel()
 {
@@ -65,8 +67,9 @@ GaussianKernel::GaussianKernel(const double sigma_in)
   m_lag = probe_span;
   m_size = m_lead + m_lag + 1;
   m_weights.resize(m_size);
-  m_data.resize(m_size);
+  m_data.resize(2 * m_size);
   m_data = 0.0;
+  m_start = 0;
 
   double precision = 1.0 / (m_sigma * m_sigma);
 
@@ -85,19 +88,42 @@ GaussianKernel::GaussianKernel(const double sigma_in)
 // What happens when a datum is fed into the leading edge of the kernel
 double GaussianKernel::step(const double val)
 {
-  // Accumulate the projection.
-  double the_sum = 0.0;
+  // Drop the oldest datum by moving the window along rather than shifting
+  // the data, and put the new one at the end of both copies.
+  m_start++;
+  if (m_start == m_size) m_start = 0;
+  m_data[m_start + m_size - 1] = val;
+  m_data[m_start > 0 ? m_start - 1 : 2 * m_size - 1] = val;
 
-  // Go over all the weights shifting them and taking the inner product
-  // at the same time.
-  for (unsigned int i = 1; i < m_size; i++) {
-    double tmp_val = m_data[i];         // temporary save a read
-    m_data[i-1] = tmp_val;              // shift the cached datum
-    the_sum += tmp_val * m_weights[i-1];  // accumulate the inner product
+  // The inner product, summed in the same order as when the data was shifted.
+  const double* data = &m_data[m_start];
+  const double* weights = &m_weights[0];
+  double the_sum = 0.0;
+  for (unsigned int i = 0; i < m_size; i++) {
+    the_sum += data[i] * weights[i];
   }
 
-  m_data[m_size - 1] = val;            // finish the shift
-  the_sum += val * m_weights[m_size-1];  // finish the inner product
-
   return the_sum;
 }
+
+GaussianKernelTable::GaussianKernelTable()
+{
+  m_resolution = 0;
+  m_last = 0;
+}
+
+GaussianKernelTable::GaussianKernelTable(const double span, const int resolution)
+{
+  m_resolution = resolution;
+  // One entry past the span, so a lookup at the span interpolates.
+  m_last = (int)ceil(span * resolution);
+  m_weights.resize(m_last + 2);
+  m_slopes.resize(m_last + 1);
+  for (int i = 0; i < (int)m_weights.size(); i++) {
+    double t = (double)i / resolution;
+    m_weights[i] = exp(-0.5 * (t * t));
+  }
+  for (int i = 0; i <= m_last; i++) {
+    m_slopes[i] = m_weights[i + 1] - m_weights[i];
+  }
+}
@@ -26,6 +26,7 @@
 #define G_KERNEL_SPAN 2.0
 
 #include <valarray>
+#include <vector>
 
 using namespace std;
 
@@ -63,7 +64,49 @@ private:
   unsigned int m_size;
   double m_sigma;
   valarray<double>m_weights;
+  // The data under the kernel, stored twice over so the window starting
+  // at m_start is always contiguous and step() need not shift it.
   valarray<double>m_data;
+  unsigned int m_start;
+};
+
+// exp(-0.5 * t * t) tabulated for t from 0 to a number of standard
+// deviations, looked up with linear interpolation. Used where the
+// distances between observations vary and a weight is needed for each
+// pair, so the weights can not be computed once up front.
+//
+// The interpolation error of a function with second derivative at most
+// 1 in size (the Gaussian's is, at t = 0) is at most h * h / 8 for a step
+// of h, so with r entries per standard deviation every weight is within
+// 1 / (8 * r * r) of exp(): 1.2e-7 for smooth_table_resolution=1024.
+// gaussian-smooth uses exp() itself unless a resolution is given.
+class GaussianKernelTable
+{
+public:
+  GaussianKernelTable();
+
+  // Tabulate from 0 to span standard deviations, resolution entries per
+  // standard deviation.
+  GaussianKernelTable(const double span, const int resolution);
+
+  // Entries per standard deviation.
+  int resolution() const { return m_resolution; }
+
+  // The weight at u / resolution() standard deviations from the center.
+  // u must not be negative. Past the span the last entry is used.
+  double weight(const double u) const
+  {
+    int i = (int)u;
+    if (i > m_last) i = m_last;
+    return m_weights[i] + (u - i) * m_slopes[i];
+  }
+
+private:
+  int m_resolution;
+  int m_last;
+  std::vector<double> m_weights;
+  // m_weights[i + 1] - m_weights[i]
+  std::vector<double> m_slopes;
 };
 
 
@@ -0,0 +1,166 @@
+////////////////////////////////////////////////////////////////
+//
+// Copyright (C) 2011 Affymetrix, Inc.
+//
+// This program is free software; you can redistribute it and/or modify 
+// it under the terms of the GNU General Public License (version 2) as 
+// published by the Free Software Foundation.
+// 
+// This program is distributed in the hope that it will be useful, 
+// but WITHOUT ANY WARRANTY; without even the implied warranty of 
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU 
+// General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License 
+// along with this program;if not, write to the 
+// 
+// Free Software Foundation, Inc., 
+// 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+//
+////////////////////////////////////////////////////////////////
+#include "copynumber/HMMEngine.h"
+
+#include <float.h>
+
+using namespace std;
+
+
+HMMEngine::HMMEngine() : _states(0), _observations(0), _rescale(false) { }
+
+
+void HMMEngine::setup(const int states, const int observations)
+    {
+    _states = states;
+    _observations = observations;
+    // Only grow, so the next chromosome can reuse the space.
+    if ((int)_logEmissions.size() < states * observations) {
+        _logEmissions.resize(states * observations);
+        _backPointers.resize(states * observations);
+        }
+    if ((int)_logTransitions.size() < states * states) {
+        _logTransitions.resize(states * states);
+        }
+    if ((int)_scores.size() < 2 * states) _scores.resize(2 * states);
+    }
+
+
+void HMMEngine::setGaussianLogEmissions(const double * data,
+        const double * mu, const bool meanPerObservation, const double * prec)
+    {
+    const int P = _states;
+    vector<double> halfLogPrec(P);
+    vector<double> halfPrec(P);
+    for (int k=0; k<P; k++) {
+        halfLogPrec[k] = 0.5 * log(prec[k]);
+        halfPrec[k] = 0.5 * prec[k];
+        }
+    // No exp() here; that is where the time went when the likelihoods
+    // were worked out as probabilities.
+    for (int n=0; n<_observations; n++) {
+        const double * m = meanPerObservation ? mu + n * P : mu;
+        double * out = &_logEmissions[n * P];
+        for (int k=0; k<P; k++) {
+            double diff = data[n] - m[k];
+            out[k] = halfLogPrec[k] - halfPrec[k] * diff * diff;
+            }
+        }
+    }
+
+
+double HMMEngine::viterbi(const double * logInitial, vector<int> & states)
+    {
+    FixedTransitions fixed;
+    return viterbi(logInitial, fixed, states);
+    }
+
+
+double HMMEngine::logSum(const double * vals, const int count)
+    {
+    double mval = -HUGE_VAL;
+    for (int k=0; k<count; k++) if (vals[k] > mval) mval = vals[k];
+    if (mval == -HUGE_VAL) return mval;
+    double sum = 0.0;
+    for (int k=0; k<count; k++) sum += exp(vals[k] - mval);
+    return mval + log(sum);
+    }
+
+
+void HMMEngine::rescale(const double * prev, double * cur, int * back)
+    {
+    const int P = _states;
+    double log_sum = logSum(cur, P);
+    // The likelihood says nothing due to an outlier, so carry the previous
+    // probabilities forward as a proxy for this bad observation.
+    if (prev != NULL && !(log_sum >= log(FLT_MIN))) {
+        for (int k=0; k<P; k++) {
+            cur[k] = prev[k];
+            back[k] = k;
+            }
+        log_sum = logSum(cur, P);
+        }
+    double shift = log_sum - log((double)P);
+    for (int k=0; k<P; k++) cur[k] -= shift;
+    }
+
+
+double HMMEngine::posterior(const double * logInitial,
+        vector<double> & posteriors)
+    {
+    const int P = _states;
+    const int N = _observations;
+    posteriors.resize(N * P);
+    if (N == 0) return 0.0;
+
+    // Work in probabilities scaled to sum to 1 at each step; the scale
+    // factors make up the likelihood. The emissions are scaled by their
+    // largest first so a far outlier can not underflow them all.
+    vector<double> trans(P * P);
+    for (int k=0; k<P*P; k++) trans[k] = exp(_logTransitions[k]);
+    vector<double> emis(N * P);
+    vector<double> scale(N);
+    double loglik = 0.0;
+    for (int n=0; n<N; n++) {
+        const double * le = &_logEmissions[n * P];
+        double mval = -HUGE_VAL;
+        for (int k=0; k<P; k++) if (le[k] > mval) mval = le[k];
+        for (int k=0; k<P; k++) emis[n * P + k] = exp(le[k] - mval);
+        loglik += mval;
+        }
+
+    // Forward, into posteriors.
+    double * alpha = &posteriors[0];
+    for (int i=0; i<P; i++) alpha[i] = exp(logInitial[i]) * emis[i];
+    for (int n=0; n<N; n++) {
+        double * a = alpha + n * P;
+        if (n > 0) {
+            const double * prev = a - P;
+            for (int i=0; i<P; i++) {
+                const double * t = &trans[i * P];
+                double sum = 0.0;
+                for (int j=0; j<P; j++) sum += prev[j] * t[j];
+                a[i] = sum * emis[n * P + i];
+                }
+            }
+        double sum = 0.0;
+        for (int i=0; i<P; i++) sum += a[i];
+        scale[n] = sum;
+        for (int i=0; i<P; i++) a[i] /= sum;
+        loglik += log(sum);
+        }
+
+    // Backward, multiplied into the forward as it goes.
+    vector<double> beta(P, 1.0);
+    vector<double> next(P);
+    for (int n=N-2; n>=0; n--) {
+        for (int i=0; i<P; i++) {
+            next[i] = emis[(n+1) * P + i] * beta[i] / scale[n+1];
+            }
+        for (int j=0; j<P; j++) {
+            double sum = 0.0;
+            for (int i=0; i<P; i++) sum += trans[i * P + j] * next[i];
+            beta[j] = sum;
+            }
+        for (int j=0; j<P; j++) alpha[n * P + j] *= beta[j];
+        }
+    return loglik;
+    }
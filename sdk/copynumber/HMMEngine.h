@@ -0,0 +1,172 @@
+////////////////////////////////////////////////////////////////
+//
+// Copyright (C) 2011 Affymetrix, Inc.
+//
+// This program is free software; you can redistribute it and/or modify 
+// it under the terms of the GNU General Public License (version 2) as 
+// published by the Free Software Foundation.
+// 
+// This program is distributed in the hope that it will be useful, 
+// but WITHOUT ANY WARRANTY; without even the implied warranty of 
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU 
+// General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License 
+// along with this program;if not, write to the 
+// 
+// Free Software Foundation, Inc., 
+// 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+//
+////////////////////////////////////////////////////////////////
+#ifndef HMMENGINE_H_
+#define HMMENGINE_H_
+
+#include <cmath>
+#include <vector>
+
+// Viterbi and forward-backward for the copy number HMMs, worked in logs.
+//
+// The buffers are flat and laid out by observation, state fastest: the
+// log emissions and the back pointers at [n * states + i], the log
+// transitions from state j to state i at [i * states + j] so the states
+// coming into i are next to each other. Only two rows of the Viterbi
+// scores are kept. The buffers only grow, so an engine kept for a run of
+// chromosomes allocates for the longest of them and no more.
+class HMMEngine {
+
+public:
+HMMEngine();
+
+// Size the buffers for a chain. The emissions and transitions are not set.
+void setup(const int states, const int observations);
+
+int stateCount() const { return _states; }
+int observationCount() const { return _observations; }
+
+// The log emission probabilities of the states for observation n.
+double * logEmissions(const int n) { return &_logEmissions[n * _states]; }
+
+// Fill in the log emissions of Gaussian states for all the observations:
+// 0.5*log(prec) - 0.5*prec*(x - mu)^2, leaving out the constant. mu holds
+// one mean per state, or with meanPerObservation one per state per
+// observation laid out as the emissions are.
+void setGaussianLogEmissions(const double * data, const double * mu,
+    const bool meanPerObservation, const double * prec);
+
+// The log transition probabilities, from state j to state i at
+// [i * states + j]. Used by every step unless a TRANSITIONS is given.
+double * logTransitions() { return &_logTransitions[0]; }
+
+// Rescale each step to a mean probability of 1, and where the
+// probabilities of a step sum to less than FLT_MIN carry the step before
+// forward, as if the observation were not there. This is how
+// CopyNumberHMM treats outliers. Off by default.
+void setRescale(const bool rescale) { _rescale = rescale; }
+
+// Find the most probable path with the transitions set up front.
+// Returns the log probability of the path (relative, if rescaling).
+double viterbi(const double * logInitial, std::vector<int> & states);
+
+// Find the most probable path with transitions which change along the
+// chain. transitions(n, logTransitions) is called before step n (n >= 1)
+// to fill in the transitions into observation n.
+template<class TRANSITIONS>
+double viterbi(const double * logInitial, TRANSITIONS & transitions,
+    std::vector<int> & states);
+
+// The state observation n came from on the best path to state i at n,
+// after viterbi().
+int backPointer(const int n, const int i) const { return _backPointers[n * _states + i]; }
+
+// The posterior probability of each state at each observation, laid out
+// as the emissions are, by forward-backward with the transitions set up
+// front. Returns the log likelihood of the observations.
+double posterior(const double * logInitial, std::vector<double> & posteriors);
+
+private:
+// Used by viterbi() when the transitions do not change.
+class FixedTransitions {
+public:
+    void operator()(const int, double *) { }
+};
+
+// Takes the best of the steps into state i: the best previous score plus
+// transition, the first of them on a tie.
+static inline void best(const double * prev, const double * trans,
+    const int states, double & val, int & pos)
+    {
+    val = -HUGE_VAL;
+    pos = 0;
+    for (int j=0; j<states; j++) {
+        double this_val = prev[j] + trans[j];
+        if (this_val > val) { val = this_val; pos = j; }
+        }
+    }
+
+// log(sum(exp(vals)))
+static double logSum(const double * vals, const int count);
+
+// Rescale one step as setRescale() describes; prev is NULL for the first.
+void rescale(const double * prev, double * cur, int * back);
+
+int _states;
+int _observations;
+bool _rescale;
+std::vector<double> _logEmissions;
+std::vector<double> _logTransitions;
+std::vector<int> _backPointers;
+std::vector<double> _scores;   // two rows of Viterbi scores
+};
+
+
+template<class TRANSITIONS>
+double HMMEngine::viterbi(const double * logInitial,
+        TRANSITIONS & transitions, std::vector<int> & states)
+    {
+    const int P = _states;
+    const int N = _observations;
+    states.resize(N);
+    if (N == 0) return 0.0;
+
+    double * prev = &_scores[0];
+    double * cur = &_scores[P];
+    int * back = &_backPointers[0];
+    const double * emis = &_logEmissions[0];
+    for (int i=0; i<P; i++) {
+        cur[i] = logInitial[i] + emis[i];
+        back[i] = 0;
+        }
+    if (_rescale) rescale(NULL, cur, back);
+
+    const double * trans = &_logTransitions[0];
+    for (int n=1; n<N; n++) {
+        double * tmp = prev; prev = cur; cur = tmp;
+        transitions(n, &_logTransitions[0]);
+        back += P;
+        emis += P;
+        for (int i=0; i<P; i++) {
+            double val;
+            int pos;
+            best(prev, trans + i * P, P, val, pos);
+            // Add the emission to the best path in, the same as the
+            // probability of the path times the likelihood.
+            cur[i] = emis[i] + val;
+            back[i] = pos;
+            }
+        if (_rescale) rescale(prev, cur, back);
+        }
+
+    // The best end, then follow the back pointers.
+    double logP = cur[0];
+    int stateF = 0;
+    for (int i=1; i<P; i++) {
+        if (cur[i] > logP) { logP = cur[i]; stateF = i; }
+        }
+    states[N-1] = stateF;
+    for (int n=N-2; n>=0; n--) {
+        states[n] = _backPointers[(n+1) * P + states[n+1]];
+        }
+    return logP;
+    }
+
+#endif // HMMENGINE_H_
@@ -28,99 +28,189 @@
 using std::valarray;
 using std::vector;
 
-static void wavelet_sandbox_iter(valarray<double> & data_vec, Wavelet * W,
-		vector<double>likelihood_prec, double prior_prec, MODE mode,
-		double converge);
-
-static void shrink_mrf1(valarray<double> & vec, double likelihood_prec,
-		double prior_prec, double converge);
-
 
 void wavelet_sandbox(valarray<double> & data_vec, Wavelet * W,
 		vector<double>likelihood_prec, double prior_prec, MODE mode,
 		double converge, bool outlier, double nu, int maxiter)
     {
-	if (!outlier) {
-		wavelet_sandbox_iter(data_vec, W, likelihood_prec, prior_prec,
-			mode, converge);
+	WaveletShrinkPlan plan(W, mode, likelihood_prec, prior_prec, converge);
+	plan.setOutlier(outlier, nu, maxiter);
+	plan.shrink(data_vec);
+    }
+
+
+WaveletShrinkPlan::WaveletShrinkPlan(Wavelet* W, MODE mode,
+		const vector<double>& likelihood_prec, double prior_prec,
+		double converge)
+    {
+	m_pWavelet = W;
+	m_eMode = mode;
+	m_vLikelihoodPrec = likelihood_prec;
+	m_dPriorPrec = prior_prec;
+	m_dConverge = converge;
+	m_bOutlier = false;
+	m_dNu = 0;
+	m_iMaxIter = 0;
+	m_vLevels.resize(m_vLikelihoodPrec.size());
+    }
+
+
+void WaveletShrinkPlan::setOutlier(bool outlier, double nu, int maxiter)
+    {
+	m_bOutlier = outlier;
+	m_dNu = nu;
+	m_iMaxIter = maxiter;
+    }
+
+
+// Size each level for a signal of iLength. The buffers only ever grow,
+// so a plan used for many signals stops allocating after the longest.
+void WaveletShrinkPlan::prepare(index_t iLength)
+    {
+	index_t data_len = iLength;
+	for (int iLevel = 0; iLevel < (int)m_vLevels.size(); iLevel++) {
+		Level& level = m_vLevels[iLevel];
+		level.iInputLength = data_len;
+		level.iDecLength = dwt_buffer_length(data_len, m_pWavelet->dec_len, m_eMode);
+		level.iRecLength = reconstruction_buffer_length(level.iDecLength, m_pWavelet->rec_len);
+		if ((index_t)level.vApproximation.size() < level.iDecLength) {
+			level.vApproximation.resize(level.iDecLength);
+			level.vDetail.resize(level.iDecLength);
+			}
+		if ((index_t)level.vReconstruction.size() < level.iRecLength) {
+			level.vReconstruction.resize(level.iRecLength);
+			}
+		if ((index_t)m_vShrunk.size() < level.iDecLength) {
+			m_vShrunk.resize(level.iDecLength);
+			m_vFirstSweep.resize(level.iDecLength);
+			m_vTauDetail.resize(level.iDecLength);
+			}
+		data_len = level.iDecLength;
+		}
+    }
+
+
+void WaveletShrinkPlan::shrink(valarray<double> & data_vec)
+    {
+	if (data_vec.size() == 0) {
+		return;
+		}
+	shrink(&data_vec[0], (int)data_vec.size());
+    }
+
+
+void WaveletShrinkPlan::shrink(vector<valarray<double> > & vData)
+    {
+	for (int i = 0; i < (int)vData.size(); i++) {
+		shrink(vData[i]);
+		}
+    }
+
+
+void WaveletShrinkPlan::shrink(double * data_vec, int N)
+    {
+	if (N < 1) {
+		return;
+		}
+	prepare(N);
+	if (!m_bOutlier) {
+		shrinkLevels(data_vec, 0);
 		return;
 		}
 
-	int N = data_vec.size();
-	valarray<double> data(data_vec);
-	valarray<double> resids(N);
+	// The sums are taken in the order the std::valarray expressions they
+	// replaced took them (libstdc++): the weighted squares from the end,
+	// the precisions from the start.
+	if ((int)m_vData.size() < N) {
+		m_vData.resize(N);
+		m_vResiduals.resize(N);
+		m_vPrec.resize(N);
+		}
+	double * data = &m_vData[0];
+	double * resids = &m_vResiduals[0];
+	double * prec_vec = &m_vPrec[0];
+	for (int i = 0; i < N; i++) {
+		data[i] = data_vec[i];
+		prec_vec[i] = 1.0;
+		}
 
 	double S = 1.0;
-	valarray<double> prec_vec(1.0,N);
 
 	int count=0;
-	while (count < maxiter) {
-		wavelet_sandbox_iter(data, W, likelihood_prec, prior_prec,
-			mode, converge);
+	while (count < m_iMaxIter) {
+		shrinkLevels(data, 0);
 
-		resids = data_vec - data;
+		for (int i = 0; i < N; i++) {
+			resids[i] = data_vec[i] - data[i];
+			}
+		double sum = resids[N-1]*resids[N-1]*prec_vec[N-1];
+		for (int i = N-2; i >= 0; i--) {
+			sum += resids[i]*resids[i]*prec_vec[i];
+			}
 
-		S *= (resids*resids*prec_vec).sum()/N;
+		S *= sum/N;
 
-		prec_vec = (nu + 1.0)/(nu*S + resids*resids);
+		for (int i = 0; i < N; i++) {
+			prec_vec[i] = (m_dNu + 1.0)/(m_dNu*S + resids[i]*resids[i]);
+			}
+		double prec_sum = prec_vec[0];
+		for (int i = 1; i < N; i++) {
+			prec_sum += prec_vec[i];
+			}
 
-		data += resids*(prec_vec/prec_vec.sum());
+		for (int i = 0; i < N; i++) {
+			data[i] += resids[i]*(prec_vec[i]/prec_sum);
+			}
 
 		count++;
 		}
 
-	data_vec = data;
+	for (int i = 0; i < N; i++) {
+		data_vec[i] = data[i];
+		}
     }
 
 
-void wavelet_sandbox_iter(valarray<double> & data_vec, Wavelet * W,
-		vector<double>likelihood_prec, double prior_prec, MODE mode,
-		double converge)
+// Decompose the data, shrink the details, recurse on the approximation
+// and reconstruct the data over the top of itself.
+void WaveletShrinkPlan::shrinkLevels(double * data_vec, int iLevel)
     {
 	// nothing to do when levels of resolution are exhausted
-	if (likelihood_prec.empty()) {
+	if (iLevel >= (int)m_vLevels.size()) {
 	 return;
 	 }
-
-	// length of the data vector
-    index_t data_len = (index_t)data_vec.size();
-
-	// length of vector needed to hold the deconstruction / wavelet
-	// expansion of the data vector
-    index_t dec_len = dwt_buffer_length(data_len,W->dec_len,mode);
-
-	// for holding the expansions
-    valarray<double> approximation(0.0, dec_len);
-    valarray<double> detail(0.0, dec_len);
+	Level& level = m_vLevels[iLevel];
+	index_t data_len = level.iInputLength;
+	index_t dec_len = level.iDecLength;
+	index_t rec_len = level.iRecLength;
+	double * approximation = &level.vApproximation[0];
+	double * detail = &level.vDetail[0];
+	double * rec_vec = &level.vReconstruction[0];
 
 	// compute the expansions
-    double_dec_a(&data_vec[0], data_len, W, &approximation[0], dec_len, mode);
-    double_dec_d(&data_vec[0], data_len, W, &detail[0], dec_len, mode);
+	for (index_t i = 0; i < dec_len; i++) {
+		approximation[i] = 0.0;
+		detail[i] = 0.0;
+		}
+    double_dec_a(data_vec, data_len, m_pWavelet, approximation, dec_len, m_eMode);
+    double_dec_d(data_vec, data_len, m_pWavelet, detail, dec_len, m_eMode);
 
 	// shrink the details of the expansion
-	shrink_mrf1(detail, likelihood_prec[0], prior_prec, converge);
-
-	// send the recursive call a front popped version of the 
-	// likelihood weights.  Note that an empty vector will immediately
-	// return.
-	vector<double> lp_next(likelihood_prec.begin() + 1, likelihood_prec.end());
+	shrinkDetail(level.vDetail, dec_len, m_vLikelihoodPrec[iLevel]);
 
 	// send the next level of approximations to have their details shrunk
-	wavelet_sandbox_iter(approximation, W, lp_next, prior_prec, mode, converge);
-
-	// the length of the vector and vector to reconstruct the approximation
-    index_t rec_len = reconstruction_buffer_length(dec_len,W->rec_len);
-    valarray<double> rec_vec(0.0, rec_len);
+	shrinkLevels(approximation, iLevel + 1);
 
-	// add the approximation to the reconstruction
-    double_upsampling_convolution_valid_sf(&approximation[0],dec_len,
-            W->rec_lo_double, W->rec_len,
-            &rec_vec[0], rec_len, mode);
-
-	// add the shrunk details to the reconstruction
-    double_upsampling_convolution_valid_sf(&detail[0],dec_len,
-            W->rec_hi_double, W->rec_len,
-            &rec_vec[0], rec_len, mode);
+	// add the approximation and then the shrunk details to the reconstruction
+	for (index_t i = 0; i < rec_len; i++) {
+		rec_vec[i] = 0.0;
+		}
+    double_upsampling_convolution_valid_sf(approximation, dec_len,
+            m_pWavelet->rec_lo_double, m_pWavelet->rec_len,
+            rec_vec, rec_len, m_eMode);
+    double_upsampling_convolution_valid_sf(detail, dec_len,
+            m_pWavelet->rec_hi_double, m_pWavelet->rec_len,
+            rec_vec, rec_len, m_eMode);
 
 	// write over the input approximation based on shrunk details
 	// the copy must be made because rec_vec could be longer than
@@ -129,44 +219,119 @@ void wavelet_sandbox_iter(valarray<double> & data_vec, Wavelet * W,
     }
 
 
+// Shrink the details towards their neighbours (a first order Markov
+// random field prior) by Gauss-Seidel sweeps until no detail moves by
+// converge or more. Each sweep uses the new value on the left and the
+// old value on the right.
+//
+// A sweep can't start a detail until the one before it is done, which
+// leaves the cpu waiting on each sum. So the sweeps are run two at a
+// time, the second one detail behind the first and kept in registers:
+// the second only needs what the first has just worked out. The values
+// are the same as one sweep after another. If the first of the two is
+// the last one needed, its values are taken from the copy kept as it went.
+void WaveletShrinkPlan::shrinkDetail(vector<double> & vDetail, index_t N,
+		double likelihood_prec) {
 
-// need to comment how shrinkage works
-void shrink_mrf1(valarray<double> & vec,
-		double likelihood_prec, double prior_prec,
-		double converge) {
-
-	int N = vec.size();
 	double tau=likelihood_prec;
-	double beta=prior_prec;
-
-	double x;
+	double beta=m_dPriorPrec;
+	double * vec = &vDetail[0];
 
 	double prec1 = 1.0/(tau + fabs(beta));
 	double prec2 = 1.0/(tau + 2.0*fabs(beta));
 
-	valarray<double>vec1(vec.size());
-	valarray<double>old_vec(vec.size());
+	// A single detail has no neighbours; its zero padding pulls it in once.
+	if (N < 2) {
+		if (N == 1) {
+			vec[0] = tau*vec[0]*prec1;
+			}
+		return;
+		}
 
-	vec1 = vec;
+	double * vec1 = &m_vShrunk[0];
+	double * first = &m_vFirstSweep[0];
+	double * tau_vec = &m_vTauDetail[0];
+	for (index_t i=0; i<N; i++) {
+		vec1[i] = vec[i];
+		tau_vec[i] = tau*vec[i];
+		}
 
-	while (1) {
-		old_vec = vec1;
-		x = beta*vec1[1] + tau*vec[0];
-		vec1[0] = x*prec1;
+	double diff;
+	double diff_max;
+	if (N < 4) {
+		// too short to overlap the sweeps
+		while (1) {
+			double old = vec1[0];
+			vec1[0] = (beta*vec1[1] + tau_vec[0])*prec1;
+			diff_max = fabs(vec1[0] - old);
+			for (index_t i=1; i<N-1; i++) {
+				old = vec1[i];
+				vec1[i] = (beta*(vec1[i-1] + vec1[i+1]) + tau_vec[i])*prec2;
+				diff = fabs(vec1[i] - old);
+				if (diff_max < diff) diff_max = diff;
+				}
+			old = vec1[N-1];
+			vec1[N-1] = (beta*vec1[N-2] + tau_vec[N-1])*prec1;
+			diff = fabs(vec1[N-1] - old);
+			if (diff_max < diff) diff_max = diff;
+			if (diff_max < m_dConverge) break;
+			}
+		for (index_t i=0; i<N; i++) vec[i] = vec1[i];
+		return;
+		}
 
+	while (1) {
+		// a is the first sweep at detail i, b the second at detail i-1.
+		double a = (beta*vec1[1] + tau_vec[0])*prec1;
+		first[0] = a;
+		double diff_max1 = fabs(a - vec1[0]);
+		double a_prev = a;
+
+		a = (beta*(a_prev + vec1[2]) + tau_vec[1])*prec2;
+		first[1] = a;
+		diff = fabs(a - vec1[1]);
+		if (diff_max1 < diff) diff_max1 = diff;
+		double b = (beta*a + tau_vec[0])*prec1;
+		double diff_max2 = fabs(b - a_prev);
+		vec1[0] = b;
+		double b_prev = b;
+		a_prev = a;
+
+		for (index_t i=2; i<N-1; i++) {
+			a = (beta*(a_prev + vec1[i+1]) + tau_vec[i])*prec2;
+			first[i] = a;
+			diff = fabs(a - vec1[i]);
+			if (diff_max1 < diff) diff_max1 = diff;
+
+			b = (beta*(b_prev + a) + tau_vec[i-1])*prec2;
+			diff = fabs(b - a_prev);
+			if (diff_max2 < diff) diff_max2 = diff;
+			vec1[i-1] = b;
+
+			b_prev = b;
+			a_prev = a;
+			}
 
-		for (int i=1; i<N-1; i++) {
-			x = beta*(vec1[i-1] + vec1[i+1]) + tau*vec[i];
-			vec1[i] = x*prec2;
+		a = (beta*a_prev + tau_vec[N-1])*prec1;
+		first[N-1] = a;
+		diff = fabs(a - vec1[N-1]);
+		if (diff_max1 < diff) diff_max1 = diff;
+		if (diff_max1 < m_dConverge) {
+			for (index_t i=0; i<N; i++) vec[i] = first[i];
+			return;
 			}
 
-		x = beta*vec1[N-2] + tau*vec[N-1];
-		vec1[N-1] = x*prec1;
+		b = (beta*(b_prev + a) + tau_vec[N-2])*prec2;
+		diff = fabs(b - a_prev);
+		if (diff_max2 < diff) diff_max2 = diff;
+		vec1[N-2] = b;
 
-		double diff_max = abs(vec1 - old_vec).max();
-		
-		if (diff_max < converge) break;
+		double b_last = (beta*b + tau_vec[N-1])*prec1;
+		diff = fabs(b_last - a);
+		if (diff_max2 < diff) diff_max2 = diff;
+		vec1[N-1] = b_last;
+
+		if (diff_max2 < m_dConverge) break;
 		}
-	vec = vec1;
+	for (index_t i=0; i<N; i++) vec[i] = vec1[i];
 	}
-
@@ -34,4 +34,95 @@ void wavelet_sandbox(std::valarray<double> & observed, Wavelet * W,
 	std::vector<double> likelihood_prec, double prior_prec,
 	MODE mode, double converge, bool outlier, double nu, int maxiter);
 
+/**
+ * @brief Owns a Wavelet from wavelet() and frees it on the way out of
+ * scope, so it is not leaked when an error is thrown.
+ */
+class WaveletHolder
+{
+private:
+	Wavelet* m_pWavelet;
+
+	// Not copyable; only one holder frees the wavelet.
+	WaveletHolder(const WaveletHolder&);
+	WaveletHolder& operator=(const WaveletHolder&);
+
+public:
+	explicit WaveletHolder(Wavelet* W) : m_pWavelet(W) {}
+	~WaveletHolder() { if (m_pWavelet != NULL) free_wavelet(m_pWavelet); }
+
+	Wavelet* get() const { return m_pWavelet; }
+};
+
+/**
+ * @brief The buffers and settings for wavelet shrinkage, made once and
+ * used for every signal shrunk with them.
+ *
+ * wavelet_sandbox() makes a plan for one signal. A plan kept over the
+ * chromosomes of a sample, or over many samples, only allocates when a
+ * signal is longer than any it has seen. The arithmetic is the same as
+ * wavelet_sandbox(), so the results are the same bit for bit.
+ */
+class WaveletShrinkPlan
+{
+private:
+	/// The buffers for one level of the decomposition.
+	struct Level
+	{
+		index_t iInputLength;
+		index_t iDecLength;
+		index_t iRecLength;
+		std::vector<double> vApproximation;
+		std::vector<double> vDetail;
+		std::vector<double> vReconstruction;
+	};
+
+	Wavelet* m_pWavelet;
+	MODE m_eMode;
+	std::vector<double> m_vLikelihoodPrec;
+	double m_dPriorPrec;
+	double m_dConverge;
+	bool m_bOutlier;
+	double m_dNu;
+	int m_iMaxIter;
+
+	std::vector<Level> m_vLevels;
+	/// Scratch for the shrunk details and for the outlier down weighting.
+	std::vector<double> m_vShrunk;
+	std::vector<double> m_vFirstSweep;
+	std::vector<double> m_vTauDetail;
+	std::vector<double> m_vData;
+	std::vector<double> m_vResiduals;
+	std::vector<double> m_vPrec;
+
+	void prepare(index_t iLength);
+	void shrinkLevels(double* pdData, int iLevel);
+	void shrinkDetail(std::vector<double>& vDetail, index_t iLength, double dLikelihoodPrec);
+
+public:
+	/**
+	 * @brief Constructor
+	 * @param Wavelet* - The wavelet, which the caller frees after the plan.
+	 * @param MODE - The signal extension mode.
+	 * @param const std::vector<double>& - The likelihood precision of each level, finest first.
+	 * @param double - The prior precision.
+	 * @param double - Stop shrinking a level once no detail moves by this much.
+	 */
+	WaveletShrinkPlan(Wavelet* W, MODE mode, const std::vector<double>& likelihood_prec, double prior_prec, double converge);
+
+	/**
+	 * @brief Down weight outliers, re-shrinking the signal maxiter times.
+	 * @param bool - Down weight outliers or not.
+	 * @param double - The degrees of freedom of the t distribution used for the weights.
+	 * @param int - The number of times to shrink the signal.
+	 */
+	void setOutlier(bool outlier, double nu, int maxiter);
+
+	/// Shrink a signal in place.
+	void shrink(double* pdData, int iLength);
+	void shrink(std::valarray<double>& data);
+	/// Shrink a batch of signals, one after another, in the same buffers.
+	void shrink(std::vector<std::valarray<double> >& vData);
+};
+
 #endif
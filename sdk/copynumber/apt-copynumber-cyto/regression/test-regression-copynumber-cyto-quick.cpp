@@ -40,6 +40,49 @@
 #include "util/Fs.h"
 using namespace std;
 
+/**
+ * The cychp files of two runs of the same cels must hold the same values
+ * in every data set, with no epsilon. The headers are not compared, as they
+ * hold the run's time, guid, output directory and thread count.
+ */
+class ThreadsCheck : public RegressionCheck
+{
+public:
+    ThreadsCheck(const std::set<std::string>& setIgnore, const std::string& strDir1, const std::string& strDir2) :
+        m_setIgnore(setIgnore), m_strDir1(strDir1), m_strDir2(strDir2)
+    {
+        m_vFileTags.push_back("HapMap-As_NA18547_A08_01_NN_20081218");
+        m_vFileTags.push_back("HapMap-As_NA18603_B03_01_NN_20081218");
+        m_vFileTags.push_back("HapMap-As_NA18971_C02_01_NN_20081218");
+        m_vFileTags.push_back("HapMap-Cs_NA10857_A10_01_NN_20081218");
+        m_vFileTags.push_back("HapMap-Cs_NA12003_D04_01_NN_20081218");
+    }
+
+    bool check(std::string &msg)
+    {
+        std::set<std::string> setSetIgnore;
+        std::map<std::string, float> mapEpsilon;
+        bool bPassed = true;
+        for (unsigned int i = 0; (i < m_vFileTags.size()); i++)
+        {
+            std::string strFileName1 = Fs::join(m_strDir1, m_vFileTags[i]) + ".ca.cychp";
+            std::string strFileName2 = Fs::join(m_strDir2, m_vFileTags[i]) + ".ca.cychp";
+            if (!Calvin::equivalent(strFileName1, strFileName2, m_setIgnore, setSetIgnore, mapEpsilon, 0.0, 1.0, false))
+            {
+                msg += "Differs with threads: " + strFileName2 + "\n";
+                bPassed = false;
+            }
+        }
+        return bPassed;
+    }
+
+private:
+    std::set<std::string> m_setIgnore;
+    std::string m_strDir1;
+    std::string m_strDir2;
+    std::vector<std::string> m_vFileTags;
+};
+
 class test_regression_copynumber_cyto_quick : public RegressionSuite, public RegressionCheck
 {
 public:
@@ -150,6 +193,7 @@ public:
     void run()
     {
       single();
+      threads();
       batch();
     }
 
@@ -184,7 +228,19 @@ public:
           m_SetSetIgnore = setSetIgnore;
           checks.push_back(this);
           string name = "qt-single";
-          string command =
+          string command = singleCommand(idata, outdir);
+          RegressionTest test(name.c_str(), command.c_str(), checks, false);
+          test.setSuite(*this,  outdir, outdir + "/apt-copynumber-cyto.log", outdir + "/valgrind.log");
+          if(!test.pass()) {
+            Verbose::out(1, "Error in: " + name + "(): " + test.getErrorMsg());
+          }
+
+        }
+
+    /// The single run's command line, writing to outdir.
+    std::string singleCommand(const std::string& idata, const std::string& outdir)
+    {
+      return
             string("./apt-copynumber-cyto") +
             " -v 1" +
             " --cyto2 true" +
@@ -226,13 +282,37 @@ public:
             " --image-correction-intensity-adjustment-method high-pass-filter-intensity-adjustment-method.data-block-rows=320.data-block-cols=2015.mini-block-rows=8.mini-block-cols=8.global-smooth-weight=256.local-smooth-weight=64.converged=0.0001" +
             " --wave-correction-log2ratio-adjustment-method wave-correction-log2ratio-adjustment-method.bandwidth=101.bin-count=25.wave-count=3"
             " --reference-chromosome=22";
-          RegressionTest test(name.c_str(), command.c_str(), checks, false);
-          test.setSuite(*this,  outdir, outdir + "/apt-copynumber-cyto.log", outdir + "/valgrind.log");
-          if(!test.pass()) {
-            Verbose::out(1, "Error in: " + name + "(): " + test.getErrorMsg());
-          }
+    }
 
-        }
+  /**
+   * The samples after the first are analysed on other threads with
+   * --threads; the cychp files must be the same as with one thread.
+   */
+  void threads()
+  {
+    string idata="../../../regression-data/data/idata";
+    string outdir1 = Fs::join(m_testDir, "qt-threads-1");
+    string outdir3 = Fs::join(m_testDir, "qt-threads-3");
+    vector<RegressionCheck *> checks;
+    RegressionTest test1("qt-threads-1", (singleCommand(idata, outdir1) + " --threads 1").c_str(), checks, false);
+    test1.setSuite(*this, outdir1, outdir1 + "/apt-copynumber-cyto.log", outdir1 + "/valgrind.log");
+    if (!test1.pass()) {
+      Verbose::out(1, "Error in: qt-threads-1(): " + test1.getErrorMsg());
+      numFailed++;
+      return;
+    }
+    ThreadsCheck objCheck(setIgnore, outdir1, outdir3);
+    checks.push_back(&objCheck);
+    RegressionTest test3("qt-threads-3", (singleCommand(idata, outdir3) + " --threads 3").c_str(), checks, false);
+    test3.setSuite(*this, outdir3, outdir3 + "/apt-copynumber-cyto.log", outdir3 + "/valgrind.log");
+    if (test3.pass()) {
+      numPassed++;
+    }
+    else {
+      Verbose::out(1, "Error in: qt-threads-3(): " + test3.getErrorMsg());
+      numFailed++;
+    }
+  }
 
   void batch()
   {
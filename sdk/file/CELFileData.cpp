@@ -943,7 +943,7 @@ bool CCELFileData::ReadXDABCel(bool bReadHeaderOnly)
     if (m_lpFileMap == MAP_FAILED)
 	{
 		Close();
-    static char buf[2048];
+    char buf[2048];
     sprintf(buf, "Unable to map view for the unix memory map file: %d", errno);
 		SetError(buf);
 		return false;
@@ -1316,7 +1316,7 @@ bool CCELFileData::ReadTranscriptomeBCel(bool bReadHeaderOnly)
     if (m_lpFileMap == MAP_FAILED)
 	{
 		Close();
-    static char buf[2048];
+    char buf[2048];
     sprintf(buf, "Unable to map view for the unix memory map file: %d", errno);
 		SetError(buf);
 		return false;
@@ -1589,7 +1589,7 @@ bool CCELFileData::ReadCompactBCel(bool bReadHeaderOnly)
     if (m_lpFileMap == MAP_FAILED)
 	{
 		Close();
-    static char buf[2048];
+    char buf[2048];
     sprintf(buf, "Unable to map view for the unix memory map file: %d", errno);
 		SetError(buf);
 		return false;
@@ -26,8 +26,10 @@
 #include "util/Convert.h"
 #include "util/Err.h"
 #include "util/Fs.h"
+#include "util/NumFormat.h"
 #include "util/Util.h"
 #include "util/Verbose.h"
+#include "util/md5sum.h"
 //
 #include <algorithm>
 #include <cassert>
@@ -52,15 +54,11 @@ using namespace affx;
 #define TSV_ERR_ABORT(_msg) APT_ERR_ABORT(_msg);
 
 
-#ifdef TSV_USE_RDBUF
-#define M_GETC()    (m_rdbuf->sbumpc())
-#define M_PEEK()    (m_rdbuf->sgetc())
-#define M_UNGETC(c) (m_rdbuf->sputbackc(c))
-#else
-#define M_GETC()    (m_fileStream.get())
-#define M_PEEK()    (m_fileStream.peek())
-#define M_UNGETC(c) (m_fileStream.putback(c))
-#endif
+// Read from the block buffer, refilling it as needed.
+#define M_GETC()    (((m_rbuf_pos<m_rbuf_end)||f_rbuf_fill()) ? (int)(unsigned char)m_rbuf[m_rbuf_pos++] : EOF)
+#define M_PEEK()    (((m_rbuf_pos<m_rbuf_end)||f_rbuf_fill()) ? (int)(unsigned char)m_rbuf[m_rbuf_pos] : EOF)
+// Only the char which was just read is put back.
+#define M_UNGETC(c) do { if (((c)!=EOF)&&(m_rbuf_pos>m_rbuf_beg)) { m_rbuf_pos--; } } while (0)
 
 // #define TSV_SET_ERR(err) (setError(err)))
 #define TSV_SET_ERR(err)    (m_errno=err)
@@ -246,33 +244,53 @@ affx::escapeChar(int c)
   }
 }
  
-std::string
-affx::escapeString(const std::string& str,const char eChar)
+/// @brief     Append the escaped form of str to out.
+static void
+tsv_append_escaped(std::string& out,const std::string& str,const char eChar)
 {
   int i_max=str.size();
-  std::string estring;
-
-  estring.reserve(i_max);
 
   for (int i=0;i<i_max;i++) {
     char c=str[i];
-    char cc=escapeChar(c);
+    char cc=affx::escapeChar(c);
     if (cc!=0) {
-      estring.append(1,eChar);
-      estring.append(1,cc);
+      out.append(1,eChar);
+      out.append(1,cc);
     }
     else if (c==eChar) {
-      estring.append(1,eChar);
-      estring.append(1,c);
+      out.append(1,eChar);
+      out.append(1,c);
     }
     else {
-      estring.append(1,c);
+      out.append(1,c);
     }
   }
-  
+}
+
+std::string
+affx::escapeString(const std::string& str,const char eChar)
+{
+  std::string estring;
+  estring.reserve(str.size());
+  tsv_append_escaped(estring,str,eChar);
   return estring;
 }
 
+/// @brief     Append a double in the format given by the column precision.
+/// @param     out       string to append to
+/// @param     val       the value
+/// @param     precision places after the point or TSV_PRECISION_SHORTEST
+static inline void
+tsv_append_double(std::string& out,double val,int precision)
+{
+  if (precision==TSV_PRECISION_SHORTEST) {
+    NumFormat::appendShortest(out,val);
+  }
+  else {
+    NumFormat::appendFixed(out,val,precision);
+  }
+}
+
 ////////////////////
 
 /// @brief     Create a new Binding to map a column to a lvalue.
@@ -472,18 +490,16 @@ affx::TsvFileField::convertToString()
     break;
   case affx::VALSTATE_INT:
     {
-      std::ostringstream stream;
-      stream << m_value_int;
-      setBuffer(stream.str());
+      std::string str;
+      NumFormat::appendInt(str,m_value_int);
+      setBuffer(str);
     }
     break;
   case affx::VALSTATE_DOUBLE:
     {
-      std::ostringstream stream;
-      stream.setf(ios::fixed, ios::floatfield);
-      stream.precision(m_precision);
-      stream << m_value_double;
-      setBuffer(stream.str());
+      std::string str;
+      tsv_append_double(str,m_value_double,m_precision);
+      setBuffer(str);
     }
     break;
   default:
@@ -771,44 +787,37 @@ affx::TsvFileField::get(std::vector<std::string>* vec,char sep)
 
 //////////
 
-#define TSV_CONCAT_VEC_BODY() {                 \
-  if (vec.size()>0) {                           \
-    stream << vec[0];                           \
-    for (size_t i=1;i<vec.size();i++) {         \
-      stream << sep << vec[i];                  \
+#define TSV_CONCAT_VEC_BODY(APPEND_VAL) {       \
+  std::string str;                              \
+  for (size_t i=0;i<vec.size();i++) {           \
+    if (i>0) {                                  \
+      str.push_back(sep);                       \
     }                                           \
+    APPEND_VAL;                                 \
   }                                             \
-  setBuffer(stream.str());                      \
+  setBuffer(str);                               \
   return TSV_OK;                                \
   }
 
 int
 affx::TsvFileField::set(const std::vector<std::string>& vec,char sep)
 {
-  std::ostringstream stream;
-  TSV_CONCAT_VEC_BODY();
+  TSV_CONCAT_VEC_BODY(str.append(vec[i]));
 }
 int
 affx::TsvFileField::set(const std::vector<int>& vec,char sep)
 {
-  std::ostringstream stream;
-  TSV_CONCAT_VEC_BODY();
+  TSV_CONCAT_VEC_BODY(NumFormat::appendInt(str,vec[i]));
 }
 int
 affx::TsvFileField::set(const std::vector<float>& vec,char sep)
 {
-  std::ostringstream stream;
-  stream.setf(ios::fixed, ios::floatfield);
-  stream.precision(m_precision);
-  TSV_CONCAT_VEC_BODY();
+  TSV_CONCAT_VEC_BODY(tsv_append_double(str,vec[i],m_precision));
 }
 int
 affx::TsvFileField::set(const std::vector<double>& vec,char sep)
 {
-  std::ostringstream stream;
-  stream.setf(ios::fixed, ios::floatfield);
-  stream.precision(m_precision);
-  TSV_CONCAT_VEC_BODY();
+  TSV_CONCAT_VEC_BODY(tsv_append_double(str,vec[i],m_precision));
 }
 
 #undef TSV_CONCAT_VEC_BODY
@@ -826,7 +835,6 @@ affx::TsvFileField::set(const std::string& val)
 /// @brief     set the value of the buffer
 /// @param     val       the new value
 /// @return    tsv_return_t
-/// @todo      dont use ostringstream, use something faster
 int
 affx::TsvFileField::set(int val)
 {
@@ -837,22 +845,12 @@ affx::TsvFileField::set(int val)
   return TSV_OK;
 }
 
-#define TSV_CONVERT_FLOAT_BODY() {            \
-  std::ostringstream stream;                  \
-  stream.setf(ios::fixed, ios::floatfield);   \
-  stream.precision(m_precision);              \
-  stream << val;                              \
-  return setBuffer(stream.str());             \
-  }
-
 /// @brief     set the value of the buffer
 /// @param     val       the new value
 /// @return    tsv_return_t
-/// @todo      dont use ostringstream, use something faster
 int
 affx::TsvFileField::set(float val)
 {
-  //TSV_CONVERT_FLOAT_BODY();
   m_value_double=val;
   m_value_double_done=true;
   m_value_double_rv=TSV_OK;
@@ -862,7 +860,6 @@ affx::TsvFileField::set(float val)
 /// @brief     set the value of the buffer
 /// @param     val       the new value
 /// @return    tsv_return_t
-/// @todo      dont use ostringstream, use something faster
 int
 affx::TsvFileField::set(double val)
 {
@@ -873,31 +870,27 @@ affx::TsvFileField::set(double val)
   return affx::TSV_OK;
 }
 
-#undef TSV_CONVERT_FLOAT_BODY
-
 /// @brief     set the value of the buffer
 /// @param     val       the new value
 /// @return    tsv_return_t
-/// @todo      dont use ostringstream, use something faster
 int
 affx::TsvFileField::set(unsigned int val)
 {
   // not used as often, just convert it to a string now.
-  std::ostringstream stream;
-  stream << val;
-  return setBuffer(stream.str());
+  std::string str;
+  NumFormat::appendUInt(str,val);
+  return setBuffer(str);
 }
 /// @brief     set the value of the buffer
 /// @param     val       the new value
 /// @return    tsv_return_t
-/// @todo      dont use ostringstream, use something faster
 int
 affx::TsvFileField::set(uint64_t val)
 {
   // not used as often, just convert it to a string now.
-  std::ostringstream stream;
-  stream << val;
-  return setBuffer(stream.str());
+  std::string str;
+  NumFormat::appendUInt64(str,val);
+  return setBuffer(str);
 }
 
 //////////
@@ -1052,6 +1045,7 @@ affx::TsvFileIndex::clear()
 {
   m_done=false;
   m_index_str2line.clear();
+  m_index_str_pool.clear();
   m_index_int2line.clear();
   m_index_double2line.clear();
   m_index_uint2line.clear();
@@ -1067,85 +1061,143 @@ affx::TsvFileIndex::data_add(TsvFileField* field,linenum_t line)
   APT_ERR_ASSERT(field!=NULL,"internal error: data_add: field is null.");
   //
   if (m_kind==TSV_INDEX_STRING) {
-    // WARNING: field->m_buffer is reused and will be overwritten.
-    // So we need to force a fresh copy to be made by modifying the string.
-    // so first we "copy" the string.
-    // std::string str_copy=field->m_buffer;
-    // then we modify it -- this forces a copy
-    // str_copy.append(1,' ');
-    // then we undo the modification
-    // str_copy.resize(str_copy.size()-1);
-    // now we can use it in our map
-    std::string str_copy;
-    str_copy.append(field->m_buffer.begin(),field->m_buffer.end());
-    m_index_str2line.insert(make_pair(str_copy,line));
+    // field->m_buffer is reused, so copy the chars into the pool.
+    str_entry_t entry;
+    entry.m_off=m_index_str_pool.size();
+    entry.m_len=(uint32_t)field->m_buffer.size();
+    entry.m_line=line;
+    m_index_str_pool.insert(m_index_str_pool.end(),field->m_buffer.begin(),field->m_buffer.end());
+    m_index_str2line.push_back(entry);
     return;
   }
   if (m_kind==TSV_INDEX_INT) {
     int tmp_int;
     if (field->get(&tmp_int)==TSV_OK) {
-      m_index_int2line.insert(make_pair(tmp_int,line));
+      m_index_int2line.push_back(make_pair(tmp_int,line));
     }
     return;
   }
   if (m_kind==TSV_INDEX_DOUBLE) {
     double tmp_double;
     if (field->get(&tmp_double)==TSV_OK) {
-      m_index_double2line.insert(make_pair(tmp_double,line));
+      m_index_double2line.push_back(make_pair(tmp_double,line));
     }
     return;
   }
   if (m_kind==TSV_INDEX_UINT) {
     unsigned int tmp_uint;
     if (field->get(&tmp_uint)==TSV_OK) {
-      m_index_uint2line.insert(make_pair(tmp_uint,line));
+      m_index_uint2line.push_back(make_pair(tmp_uint,line));
     }
     return;
   }
   if (m_kind==TSV_INDEX_ULONGLONG) {
     uint64_t tmp_ulonglong;
     if (field->get(&tmp_ulonglong)==TSV_OK) {
-      m_index_ulonglong2line.insert(make_pair(tmp_ulonglong,line));
+      m_index_ulonglong2line.push_back(make_pair(tmp_ulonglong,line));
     }
     return;
   }
 }
 
+/// Orders (value,line) pairs by value alone, for the binary searches.
+template<typename T1,typename T2>
+class TsvIndexValueLess {
+public:
+  bool operator()(const std::pair<T1,T2>& a,const std::pair<T1,T2>& b) const {
+    return a.first<b.first;
+  }
+  bool operator()(const std::pair<T1,T2>& a,const T1& b) const {
+    return a.first<b;
+  }
+  bool operator()(const T1& a,const std::pair<T1,T2>& b) const {
+    return a<b.first;
+  }
+};
+
+/// Orders the string entries of an index by value (and by line to
+/// sort them) the same as std::string would.
+class TsvIndexStrLess {
+public:
+  typedef affx::TsvFileIndex::str_entry_t entry_t;
+  const char* m_pool;
+  bool m_byLine;
+
+  TsvIndexStrLess(const std::vector<char>& pool,bool byLine) {
+    m_pool=pool.empty()?"":&pool[0];
+    m_byLine=byLine;
+  }
+  int cmp(const char* a,size_t a_len,const char* b,size_t b_len) const {
+    int rv=memcmp(a,b,(a_len<b_len)?a_len:b_len);
+    if (rv!=0) {
+      return rv;
+    }
+    return (a_len<b_len)?-1:((a_len>b_len)?1:0);
+  }
+  bool operator()(const entry_t& a,const entry_t& b) const {
+    int rv=cmp(m_pool+a.m_off,a.m_len,m_pool+b.m_off,b.m_len);
+    if ((rv==0)&&m_byLine) {
+      return a.m_line<b.m_line;
+    }
+    return rv<0;
+  }
+  bool operator()(const entry_t& a,const std::string& b) const {
+    return cmp(m_pool+a.m_off,a.m_len,b.data(),b.size())<0;
+  }
+  bool operator()(const std::string& a,const entry_t& b) const {
+    return cmp(a.data(),a.size(),m_pool+b.m_off,b.m_len)<0;
+  }
+};
+
+/// @brief     Sort the index once all the lines have been added.
+///            Equal values stay in line order.
+void
+affx::TsvFileIndex::finish()
+{
+  std::sort(m_index_str2line.begin(),m_index_str2line.end(),TsvIndexStrLess(m_index_str_pool,true));
+  std::sort(m_index_int2line.begin(),m_index_int2line.end());
+  std::sort(m_index_double2line.begin(),m_index_double2line.end());
+  std::sort(m_index_uint2line.begin(),m_index_uint2line.end());
+  std::sort(m_index_ulonglong2line.begin(),m_index_ulonglong2line.end());
+  m_done=true;
+}
+
 /// @brief     Template to query an index for matching values
 /// @param     results   Where to stick the line numbers
-/// @param     T1        Datatype of the maps
-/// @param     map       map to search
+/// @param     T1        Datatype of the index
+/// @param     index     sorted index to search
 /// @param     op        comparison operator
 /// @param     val       value to compare against
 /// @return    tsv_return_t
 template<typename T1, typename linenum_t>
 int
 affx::TsvFileIndex::results_append_tmpl(std::vector<linenum_t>& results,
-                                     std::multimap<T1,linenum_t>& mmap,
-                                     int op,
-                                     T1& val)
+                                        std::vector<std::pair<T1,linenum_t> >& index,
+                                        int op,
+                                        T1& val)
 {
-  typename std::multimap<T1,linenum_t>::iterator r_start,r_end;
+  typename std::vector<std::pair<T1,linenum_t> >::iterator r_start,r_end;
+  TsvIndexValueLess<T1,linenum_t> less;
 
   if (op==TSV_OP_LT) {
-    r_start=mmap.begin();
-    r_end=mmap.lower_bound(val);
+    r_start=index.begin();
+    r_end=std::lower_bound(index.begin(),index.end(),val,less);
   }
   else if (op==TSV_OP_LTEQ) {
-    r_start=mmap.begin();
-    r_end=mmap.upper_bound(val);
+    r_start=index.begin();
+    r_end=std::upper_bound(index.begin(),index.end(),val,less);
   }
   else if (op==TSV_OP_EQ) {
-    r_start=mmap.lower_bound(val);
-    r_end=mmap.upper_bound(val);
+    r_start=std::lower_bound(index.begin(),index.end(),val,less);
+    r_end=std::upper_bound(r_start,index.end(),val,less);
   }
   else if (op==TSV_OP_GTEQ) {
-    r_start=mmap.lower_bound(val);
-    r_end=mmap.end();
+    r_start=std::lower_bound(index.begin(),index.end(),val,less);
+    r_end=index.end();
   }
   else if (op==TSV_OP_GT) {
-    r_start=mmap.upper_bound(val);
-    r_end=mmap.end();
+    r_start=std::upper_bound(index.begin(),index.end(),val,less);
+    r_end=index.end();
   } else {
     TSV_ERR_ABORT("Invalid operation in results_append. op="+ToStr(op));
     return TSV_ERR_UNKNOWN;
@@ -1153,7 +1205,6 @@ affx::TsvFileIndex::results_append_tmpl(std::vector<linenum_t>& results,
 
   // Stick the range into find_result
   while (r_start!=r_end) {
-    //printf("r_start=(%4d,%4d)\n",(*r_start).first,(int)(*r_start).second);
     results.push_back((*r_start).second);
     r_start++;
   }
@@ -1161,16 +1212,81 @@ affx::TsvFileIndex::results_append_tmpl(std::vector<linenum_t>& results,
   return TSV_OK;;
 }
 
+/// @brief     Template to query an index for the values in [lo,hi]
+/// @param     results   Where to stick the line numbers
+/// @param     index     sorted index to search
+/// @param     lo        lowest value
+/// @param     hi        highest value
+/// @return    tsv_return_t
+template<typename T1, typename linenum_t>
+int
+affx::TsvFileIndex::results_append_range_tmpl(std::vector<linenum_t>& results,
+                                              std::vector<std::pair<T1,linenum_t> >& index,
+                                              T1& lo,
+                                              T1& hi)
+{
+  TsvIndexValueLess<T1,linenum_t> less;
+  typename std::vector<std::pair<T1,linenum_t> >::iterator r_start,r_end;
+
+  r_start=std::lower_bound(index.begin(),index.end(),lo,less);
+  r_end=std::upper_bound(r_start,index.end(),hi,less);
+  while (r_start<r_end) {
+    results.push_back((*r_start).second);
+    r_start++;
+  }
+  return TSV_OK;
+}
+
 /// @brief     Append the matching string results to the vec
 /// @param     results   where to append
-/// @param     op        comparison to do
+/// @param     op        comparison to do (TSV_OP_PREFIX too)
 /// @param     val       value to compare to
 /// @return    tsv_return_t
 int
 affx::TsvFileIndex::results_append(std::vector<linenum_t>& results,int op,std::string val)
 {
-  // Use the template for the different types
-  return results_append_tmpl(results,m_index_str2line,op,val);
+  std::vector<str_entry_t>::iterator r_start,r_end;
+  TsvIndexStrLess less(m_index_str_pool,false);
+
+  if (op==TSV_OP_LT) {
+    r_start=m_index_str2line.begin();
+    r_end=std::lower_bound(m_index_str2line.begin(),m_index_str2line.end(),val,less);
+  }
+  else if (op==TSV_OP_LTEQ) {
+    r_start=m_index_str2line.begin();
+    r_end=std::upper_bound(m_index_str2line.begin(),m_index_str2line.end(),val,less);
+  }
+  else if (op==TSV_OP_EQ) {
+    r_start=std::lower_bound(m_index_str2line.begin(),m_index_str2line.end(),val,less);
+    r_end=std::upper_bound(r_start,m_index_str2line.end(),val,less);
+  }
+  else if (op==TSV_OP_GTEQ) {
+    r_start=std::lower_bound(m_index_str2line.begin(),m_index_str2line.end(),val,less);
+    r_end=m_index_str2line.end();
+  }
+  else if (op==TSV_OP_GT) {
+    r_start=std::upper_bound(m_index_str2line.begin(),m_index_str2line.end(),val,less);
+    r_end=m_index_str2line.end();
+  }
+  else if (op==TSV_OP_PREFIX) {
+    // the values with the prefix follow it in order.
+    r_start=std::lower_bound(m_index_str2line.begin(),m_index_str2line.end(),val,less);
+    r_end=r_start;
+    while ((r_end!=m_index_str2line.end())&&
+           (r_end->m_len>=val.size())&&
+           (memcmp(less.m_pool+r_end->m_off,val.data(),val.size())==0)) {
+      r_end++;
+    }
+  } else {
+    TSV_ERR_ABORT("Invalid operation in results_append. op="+ToStr(op));
+    return TSV_ERR_UNKNOWN;
+  }
+
+  while (r_start!=r_end) {
+    results.push_back((*r_start).m_line);
+    r_start++;
+  }
+  return TSV_OK;
 }
 /// @brief     Append the matching string results to the vec
 /// @param     results   where to append
@@ -1213,17 +1329,133 @@ affx::TsvFileIndex::results_append(std::vector<linenum_t>& results,int op,uint64
   return results_append_tmpl(results,m_index_ulonglong2line,op,val);
 }
 
+/// @brief     Append the lines with string values in [lo,hi] to the vec
+/// @param     results   where to append
+/// @param     lo        lowest value
+/// @param     hi        highest value
+/// @return    tsv_return_t
+int
+affx::TsvFileIndex::results_append_range(std::vector<linenum_t>& results,std::string lo,std::string hi)
+{
+  TsvIndexStrLess less(m_index_str_pool,false);
+  std::vector<str_entry_t>::iterator r_start,r_end;
+
+  r_start=std::lower_bound(m_index_str2line.begin(),m_index_str2line.end(),lo,less);
+  r_end=std::upper_bound(r_start,m_index_str2line.end(),hi,less);
+  while (r_start<r_end) {
+    results.push_back((*r_start).m_line);
+    r_start++;
+  }
+  return TSV_OK;
+}
+/// @brief     Append the lines with values in [lo,hi] to the vec
+int
+affx::TsvFileIndex::results_append_range(std::vector<linenum_t>& results,int lo,int hi)
+{
+  return results_append_range_tmpl(results,m_index_int2line,lo,hi);
+}
+/// @brief     Append the lines with values in [lo,hi] to the vec
+int
+affx::TsvFileIndex::results_append_range(std::vector<linenum_t>& results,double lo,double hi)
+{
+  return results_append_range_tmpl(results,m_index_double2line,lo,hi);
+}
+/// @brief     Append the lines with values in [lo,hi] to the vec
+int
+affx::TsvFileIndex::results_append_range(std::vector<linenum_t>& results,unsigned int lo,unsigned int hi)
+{
+  return results_append_range_tmpl(results,m_index_uint2line,lo,hi);
+}
+/// @brief     Append the lines with values in [lo,hi] to the vec
+int
+affx::TsvFileIndex::results_append_range(std::vector<linenum_t>& results,uint64_t lo,uint64_t hi)
+{
+  return results_append_range_tmpl(results,m_index_ulonglong2line,lo,hi);
+}
+
+/// @brief     Write a vector of plain data as a count and the data.
+template<typename T>
+static void
+tsv_write_vec(std::ostream& out,const std::vector<T>& vec)
+{
+  uint64_t cnt=vec.size();
+  out.write((const char*)&cnt,sizeof(cnt));
+  if (cnt!=0) {
+    out.write((const char*)&vec[0],cnt*sizeof(T));
+  }
+}
+
+/// @brief     Read a vector written by tsv_write_vec.
+/// @param     max_size  no more than this many bytes are expected.
+/// @return    false if the data is not there or is too big.
+template<typename T>
+static bool
+tsv_read_vec(std::istream& in,std::vector<T>& vec,int64_t max_size)
+{
+  uint64_t cnt=0;
+  in.read((char*)&cnt,sizeof(cnt));
+  if (!in.good()||(cnt*sizeof(T)>(uint64_t)max_size)) {
+    return false;
+  }
+  vec.resize(cnt);
+  if (cnt!=0) {
+    in.read((char*)&vec[0],cnt*sizeof(T));
+  }
+  return in.good();
+}
+
+/// @brief     Write the definition and the values of the index.
+/// @param     out       stream to write to
+/// @return    tsv_return_t
+int
+affx::TsvFileIndex::write(std::ostream& out)
+{
+  int32_t def[3]={m_bindto_clvl,m_bindto_cidx,m_kind};
+  out.write((const char*)def,sizeof(def));
+  tsv_write_vec(out,m_index_str2line);
+  tsv_write_vec(out,m_index_str_pool);
+  tsv_write_vec(out,m_index_int2line);
+  tsv_write_vec(out,m_index_double2line);
+  tsv_write_vec(out,m_index_uint2line);
+  tsv_write_vec(out,m_index_ulonglong2line);
+  return (out.good()?TSV_OK:TSV_ERR_FILEIO);
+}
+
+/// @brief     Read the values of the index if they were written
+///            from an index with the same definition.
+/// @param     in        stream to read from
+/// @param     max_size  the size of the stream
+/// @return    tsv_return_t
+int
+affx::TsvFileIndex::read(std::istream& in,int64_t max_size)
+{
+  int32_t def[3];
+  in.read((char*)def,sizeof(def));
+  if (!in.good()||(def[0]!=m_bindto_clvl)||(def[1]!=m_bindto_cidx)||(def[2]!=m_kind)) {
+    return TSV_ERR_FORMAT;
+  }
+  if (tsv_read_vec(in,m_index_str2line,max_size)&&
+      tsv_read_vec(in,m_index_str_pool,max_size)&&
+      tsv_read_vec(in,m_index_int2line,max_size)&&
+      tsv_read_vec(in,m_index_double2line,max_size)&&
+      tsv_read_vec(in,m_index_uint2line,max_size)&&
+      tsv_read_vec(in,m_index_ulonglong2line,max_size)) {
+    m_done=true;
+    return TSV_OK;
+  }
+  clear();
+  return TSV_ERR_FORMAT;
+}
+
 /// @brief     Dump the contents of an index
-/// @param     T1        Datatype of the maps key
-/// @param     map       the map to dump
+/// @param     T1        Datatype of the index
+/// @param     index     the index to dump
 template<typename T1, typename linenum_t>
 void
-affx::TsvFileIndex::dump_map(std::multimap<T1,linenum_t>& mmap)
+affx::TsvFileIndex::dump_vec(std::vector<std::pair<T1,linenum_t> >& index)
 {
-  typename std::multimap<T1,linenum_t>::iterator i;
-  int cnt=0;
-  for (i=mmap.begin();i!=mmap.end();i++) {
-    cout << cnt++ << " : '" << (*i).first << "' : '" << (*i).second << "'\n";
+  for (size_t i=0;i<index.size();i++) {
+    cout << i << " : '" << index[i].first << "' : '" << index[i].second << "'\n";
   }
 }
 
@@ -1234,19 +1466,23 @@ affx::TsvFileIndex::dump()
   printf("index (clvl=%2d,cidx=%2d,kind=%2d) ==========\n",m_bindto_clvl,m_bindto_cidx,m_kind);
 
   if (m_kind==TSV_INDEX_STRING) {
-    dump_map(m_index_str2line);
+    TsvIndexStrLess less(m_index_str_pool,false);
+    for (size_t i=0;i<m_index_str2line.size();i++) {
+      std::string val(less.m_pool+m_index_str2line[i].m_off,m_index_str2line[i].m_len);
+      cout << i << " : '" << val << "' : '" << m_index_str2line[i].m_line << "'\n";
+    }
   }
   if (m_kind==TSV_INDEX_INT) {
-    dump_map(m_index_int2line);
+    dump_vec(m_index_int2line);
   }
   if (m_kind==TSV_INDEX_DOUBLE) {
-    dump_map(m_index_double2line);
+    dump_vec(m_index_double2line);
   }
   if (m_kind==TSV_INDEX_UINT) {
-    dump_map(m_index_uint2line);
+    dump_vec(m_index_uint2line);
   }
   if (m_kind==TSV_INDEX_ULONGLONG) {
-    dump_map(m_index_ulonglong2line);
+    dump_vec(m_index_ulonglong2line);
   }
 }
 
@@ -1372,6 +1608,7 @@ affx::TsvFile::default_options()
   m_optHasColumnHeader=true;
   m_optQuoteChar='"';
   m_optThrowOnError=false;
+  m_optIndexCache=false;
   m_optEndl=TSV_EOL;
   m_optLinkVarsOnOpen = true;
   m_headName = "header";
@@ -1425,9 +1662,9 @@ affx::TsvFile::setFilename(const std::string& filename)
 void
 affx::TsvFile::init()
 {
-#ifdef TSV_USER_RDBUF
   m_rdbuf=NULL;
-#endif
+  m_rbuf=NULL;
+  f_rbuf_reset(0);
   m_headers_curptr=NULL;
 }
 
@@ -1599,6 +1836,106 @@ affx::TsvFile::f_lookingat_eol()
   return false;
 }
 
+/// @brief     Find the first CR or LF in [start,end).
+/// @return    the eol char or end if there is none.
+/// @remarks   memchr is vectorized by the C library, which is much
+///            faster than looking at the chars one by one.
+static inline const char*
+tsv_find_eol(const char* start,const char* end)
+{
+  const char* lf=(const char*)memchr(start,TSV_CHAR_LF,end-start);
+  if (lf==NULL) {
+    lf=end;
+  }
+  const char* cr=(const char*)memchr(start,TSV_CHAR_CR,lf-start);
+  if (cr==NULL) {
+    return lf;
+  }
+  return cr;
+}
+
+/// @brief     Start reading blocks at fpos.
+/// @param     fpos      where the filebuf is positioned.
+void
+affx::TsvFile::f_rbuf_reset(std::streamoff fpos)
+{
+  // m_rbuf[0] is reserved for the char before the block.
+  m_rbuf_fpos=fpos-1;
+  m_rbuf_beg=1;
+  m_rbuf_pos=1;
+  m_rbuf_end=1;
+}
+
+/// @brief     Read the next block from the file.
+/// @return    true if there are more chars, false at the end of the file.
+bool
+affx::TsvFile::f_rbuf_fill()
+{
+  if ((m_rbuf==NULL)||(m_rdbuf==NULL)) {
+    return false;
+  }
+  // keep the last char so it can be put back.
+  if (m_rbuf_end>m_rbuf_beg) {
+    m_rbuf[0]=m_rbuf[m_rbuf_end-1];
+    m_rbuf_fpos+=m_rbuf_end-1;
+    m_rbuf_beg=0;
+  }
+  else {
+    m_rbuf_fpos+=m_rbuf_end-1;
+  }
+  std::streamsize cnt=m_rdbuf->sgetn(m_rbuf+1,TSV_READ_BUFFER_SIZE-1);
+  m_rbuf_pos=1;
+  m_rbuf_end=1+((cnt>0)?cnt:0);
+  return (cnt>0);
+}
+
+/// @brief     The file position of the next char to be read.
+std::fstream::pos_type
+affx::TsvFile::f_tell()
+{
+  return std::fstream::pos_type(m_rbuf_fpos+(std::streamoff)m_rbuf_pos);
+}
+
+/// @brief     Move to fpos; seeks within the current block dont touch the file.
+/// @param     fpos      the position from f_tell().
+void
+affx::TsvFile::f_seek(std::fstream::pos_type fpos)
+{
+  std::streamoff off=fpos;
+  if ((off>=m_rbuf_fpos+(std::streamoff)m_rbuf_beg)&&
+      (off<=m_rbuf_fpos+(std::streamoff)m_rbuf_end)) {
+    m_rbuf_pos=(size_t)(off-m_rbuf_fpos);
+    return;
+  }
+  if ((m_rdbuf==NULL)||
+      (m_rdbuf->pubseekpos(fpos,std::ios_base::in)==std::fstream::pos_type(std::streamoff(-1)))) {
+    // same as a failed seekg.
+    m_fileStream.setstate(std::ios_base::failbit);
+  }
+  f_rbuf_reset(off);
+}
+
+/// @brief     Fill in the table of chars which end the fast scan of a
+///            field from the current options.
+void
+affx::TsvFile::f_rbuf_set_stop()
+{
+  char opts[5]={(char)m_optFieldSep,m_optQuoteChar1,m_optQuoteChar2,
+                (char)(m_optEscapeOk?m_optEscapeChar:0),0};
+  if (m_rbuf_stop_opts.compare(0,std::string::npos,opts,4)==0) {
+    return;
+  }
+  m_rbuf_stop_opts.assign(opts,4);
+  memset(m_rbuf_stop,0,sizeof(m_rbuf_stop));
+  m_rbuf_stop[TSV_CHAR_CR]=1;
+  m_rbuf_stop[TSV_CHAR_LF]=1;
+  for (int i=0;i<4;i++) {
+    if (opts[i]!=0) {
+      m_rbuf_stop[(unsigned char)opts[i]]=1;
+    }
+  }
+}
+
 /// @brief     Read a line from a TsvFile into a string.
 /// @param     line    A buffer to modify
 /// @return    tsv_return_t
@@ -1606,8 +1943,6 @@ affx::TsvFile::f_lookingat_eol()
 int
 affx::TsvFile::f_getline(std::string& line)
 {
-  int c;
-
   line.clear();
   // we have some sort of error
   if (!m_fileStream.good()) {
@@ -1615,30 +1950,24 @@ affx::TsvFile::f_getline(std::string& line)
   }
 
   while (1) {
-    // get a char...
-    //c=m_fileStream.get();
-    c=M_GETC();
     // eof?
-    if ((c==TSV_CHAR_EOF)||!m_fileStream.good()) {
+    if ((m_rbuf_pos==m_rbuf_end)&&!f_rbuf_fill()) {
       break;
     }
-    // LF ends a line
-    if (c==TSV_CHAR_LF) {
-      break;
+    // take the chars up to the eol or the end of the block.
+    const char* start=m_rbuf+m_rbuf_pos;
+    const char* eol=tsv_find_eol(start,m_rbuf+m_rbuf_end);
+    line.append(start,eol-start);
+    m_rbuf_pos=eol-m_rbuf;
+    if (m_rbuf_pos==m_rbuf_end) {
+      continue;
     }
-    // CR ends a line too.
-    if (c==TSV_CHAR_CR) {
-      // c=m_fileStream.peek();
-      c=M_PEEK();
-      // CR could be followed by a LF
-      if (c==TSV_CHAR_LF) {
-        //c=m_fileStream.get();
-        c=M_GETC();
-        break;
-      }
+    // LF or CR ends a line, CR could be followed by a LF
+    m_rbuf_pos++;
+    if ((*eol==TSV_CHAR_CR)&&(M_PEEK()==TSV_CHAR_LF)) {
+      m_rbuf_pos++;
     }
-    // push it on
-    line.append(1,(char)c);
+    break;
   }
   //
   return TSV_OK;
@@ -1818,9 +2147,9 @@ int
 affx::TsvFile::addHeader(const std::string& key,int val)
 {
   // cast to a string and add it.
-  std::ostringstream stream;
-  stream << val;
-  addHeader(key,stream.str());
+  std::string str;
+  NumFormat::appendInt(str,val);
+  addHeader(key,str);
   return TSV_OK;
 }
 
@@ -2302,7 +2631,7 @@ affx::TsvFile::f_read_header_v2()
   fstream::pos_type f_start;
   string line;
 
-  f_start=m_fileStream.tellg();
+  f_start=f_tell();
 
   if ((rv=f_getline(line))!=TSV_OK) {
     return rv;
@@ -2333,7 +2662,7 @@ affx::TsvFile::f_read_header_v2()
   }
 
   // not a header line - skip back to start of line to read as data
-  m_fileStream.seekg(f_start);
+  f_seek(f_start);
   return TSV_HEADER_LAST;
 }
 
@@ -2343,7 +2672,7 @@ int
 affx::TsvFile::f_read_headers()
 {
   // skip to start of file.
-  m_fileStream.seekg(0);
+  f_seek(0);
 
   // suck in all the v2 headers
   while (f_read_header_v2()==TSV_HEADER) {
@@ -2368,7 +2697,7 @@ affx::TsvFile::f_read_headers()
   }
 
   // The rest of the file is data.
-  m_fileDataPos=m_fileStream.tellg();
+  m_fileDataPos=f_tell();
   // sets line counters
   rewind();
 
@@ -2693,10 +3022,12 @@ affx::TsvFile::open(const std::string& fname)
   // now throw an exception if something really bad happens.
   m_fileStream.exceptions(ios_base::badbit|ios_base::failbit);
 
-#ifdef TSV_USE_RDBUF
-  // This appears to be faster than calling ".get()"
+  // read the file in blocks from the filebuf.
   m_rdbuf=m_fileStream.rdbuf();
-#endif
+  if (m_rbuf==NULL) {
+    m_rbuf=new char[TSV_READ_BUFFER_SIZE];
+  }
+  f_rbuf_reset(0);
 
   //printf("### opening: '%s' (rdstate=%4d,%s)...\n",
   //       m_fileName.c_str(),
@@ -2768,6 +3099,10 @@ affx::TsvFile::close()
   if (m_fileStream.is_open()) {
     m_fileStream.close();
   }
+  delete[] m_rbuf;
+  m_rbuf=NULL;
+  m_rdbuf=NULL;
+  f_rbuf_reset(0);
   return TSV_OK;
 }
 
@@ -2791,7 +3126,7 @@ affx::TsvFile::f_advance_tabs()
   int tabcnt=0;
   int maxtabs=(int)(m_column_map.size()-1);
 
-  m_line_fpos=m_fileStream.tellg();
+  m_line_fpos=f_tell();
 
   // first nibble off expected tabs...
   while (tabcnt<maxtabs) {
@@ -2836,7 +3171,7 @@ affx::TsvFile::f_advance_tabs()
   if ((c==TSV_CHAR_SPACE)||(c==TSV_CHAR_TAB)) {
     std::fstream::pos_type skipstart;
     int spaceCnt = -1;
-    skipstart=m_fileStream.tellg();
+    skipstart=f_tell();
     //
     do {
       //c=m_fileStream.get();
@@ -2859,7 +3194,7 @@ affx::TsvFile::f_advance_tabs()
       return (TSV_LINE_BLANK);
     }
     // found a normal char, rewind to start of skip
-    m_fileStream.seekg(skipstart);
+    f_seek(skipstart);
   }
 
   return tabcnt;
@@ -2872,41 +3207,31 @@ int
 affx::TsvFile::f_advance_eol()
 {
   int charcnt=0;
-  int c;
 
   if (!m_fileStream.good()) {
     return (TSV_ERR_FILEIO);
   }
 
-  /// @todo this is duplicated from getline but we dont want to accum the data so ok?
+  // same as f_getline, but we dont want to accum the data.
   while (1) {
-    // get a char...
-    // c=m_fileStream.get();
-    c=M_GETC();
     // eof?
-    //if (!m_fileStream.good()) {
-    //  break;
-    //}
-    if (c==EOF) {
+    if ((m_rbuf_pos==m_rbuf_end)&&!f_rbuf_fill()) {
       break;
     }
-    // LF ends a line
-    if (c==TSV_CHAR_LF) {
-      break;
+    const char* start=m_rbuf+m_rbuf_pos;
+    const char* eol=tsv_find_eol(start,m_rbuf+m_rbuf_end);
+    // count the chars
+    charcnt+=(int)(eol-start);
+    m_rbuf_pos=eol-m_rbuf;
+    if (m_rbuf_pos==m_rbuf_end) {
+      continue;
     }
-    // CR ends a line too.
-    if (c==TSV_CHAR_CR) {
-      //c=m_fileStream.peek();
-      c=M_PEEK();
-      // CR could be followed by a LF
-      if (c==TSV_CHAR_LF) {
-        //c=m_fileStream.get();
-        c=M_GETC();
-        break;
-      }
+    // LF or CR ends a line, CR could be followed by a LF
+    m_rbuf_pos++;
+    if ((*eol==TSV_CHAR_CR)&&(M_PEEK()==TSV_CHAR_LF)) {
+      m_rbuf_pos++;
     }
-    // count the chars
-    charcnt++;
+    break;
   }
 
   // we just went forward a line
@@ -2951,11 +3276,40 @@ affx::TsvFile::f_read_column(TsvFileField* col)
 
   in_quotes=0;
 
-  // The common case is the field is the same size as last time.
-  // Copy the chars into an already existing string.
-  bi=0;
+  // The common case is a field without quotes or escapes.
+  // Copy runs of plain chars from the block into the existing string
+  // and only go a char at a time for the rest.
+  bool field_done=false;
   col->m_buffer.resize(0);
   while (1) {
+    // let the loop below see the eof.
+    if ((m_rbuf_pos==m_rbuf_end)&&!f_rbuf_fill()) {
+      break;
+    }
+    const char* start=m_rbuf+m_rbuf_pos;
+    const char* end=m_rbuf+m_rbuf_end;
+    const char* ptr=start;
+    while ((ptr<end)&&(m_rbuf_stop[(unsigned char)*ptr]==0)) {
+      ptr++;
+    }
+    col->m_buffer.append(start,ptr-start);
+    m_rbuf_pos=ptr-m_rbuf;
+    if (ptr==end) {
+      continue;
+    }
+    if (*ptr==(char)m_optFieldSep) {
+      m_rbuf_pos++; // discard the field-sep-char
+      field_done=true;
+    }
+    else if ((*ptr==TSV_CHAR_CR)||(*ptr==TSV_CHAR_LF)) {
+      field_done=true; // leave eol char
+    }
+    // a quote or escape.
+    break;
+  }
+
+  bi=(int)col->m_buffer.size();
+  while (!field_done) {
     //c=m_fileStream.get();
     c=M_GETC();
 
@@ -3021,6 +3375,9 @@ affx::TsvFile::f_read_columns(int line_clvl)
 
   //clearFieldsBelowClvl(line_clvl+1); // profiling
 
+  // the options might have been changed since the last line.
+  f_rbuf_set_stop();
+
   if (line_clvl<(int)m_column_map.size()) {
     unsigned int cidx_size=m_column_map[line_clvl].size();
     for (unsigned int cidx=0;cidx<cidx_size;cidx++) {
@@ -3292,7 +3649,7 @@ affx::TsvFile::rewind()
 {
   clearFields();
   m_fileStream.clear();
-  m_fileStream.seekg(m_fileDataPos);
+  f_seek(m_fileDataPos);
   //
   m_lineLvl=0;
   m_lineNum=0;
@@ -3381,7 +3738,7 @@ affx::TsvFile::nextLevel(int seek_clvl)
     }
     // a master; dont skip it
     if (m_lineLvl<seek_clvl) {
-      m_fileStream.seekg(m_line_fpos);
+      f_seek(m_line_fpos);
       return TSV_LEVEL_LAST;
     }
     // a child; skip it
@@ -4036,7 +4393,7 @@ affx::TsvFile::seekLine(linenum_t line)
     return (TSV_ERR_NOTFOUND);
   }
   m_fileStream.clear();
-  m_fileStream.seekg(m_index_linefpos[line]);
+  f_seek(m_index_linefpos[line]);
   // we seeked to this line, but did not read it.
   m_lineNum=line;
   //
@@ -4166,12 +4523,18 @@ affx::TsvFile::indexBuild()
     }
   }
 
+  unsigned int m_index_vec_size=m_index_vec.size();
+
+  // the same file has been indexed before.
+  if (m_optIndexCache&&(indexCacheRead()==TSV_OK)) {
+    m_index_done=true;
+    return TSV_OK;
+  }
+
   // remember where we are before we rewind
-  excursion_fpos=m_fileStream.tellg();
+  excursion_fpos=f_tell();
   rewind();
 
-  unsigned int m_index_vec_size=m_index_vec.size();
-
   int l_num;
   while (nextLine()==TSV_OK) {
     l_num=m_lineNum-1; // because nextLine went past it.
@@ -4205,17 +4568,193 @@ affx::TsvFile::indexBuild()
 
   //
   m_fileStream.clear();
-  m_fileStream.seekg(excursion_fpos);
+  f_seek(excursion_fpos);
 
-  // mark the indexes as done
+  // sort and mark the indexes as done
   m_index_done=true;
   for (unsigned int i=0;i<m_index_vec_size;i++) {
     TsvFileIndex* idx=m_index_vec[i];
     if (idx!=NULL) {
-      idx->m_done=true;
+      idx->finish();
     }
   }
 
+  if (m_optIndexCache) {
+    indexCacheWrite();
+  }
+
+  return TSV_OK;
+}
+
+/// The sidecar index format. Bump this when it changes.
+#define TSV_INDEX_CACHE_MAGIC   (0x58495354)
+#define TSV_INDEX_CACHE_VERSION (1)
+/// How much of the start and end of the file is checksummed.
+#define TSV_INDEX_CACHE_SUMSIZE (64*1024)
+
+/// @brief     The name of the sidecar index for this file.
+std::string
+affx::TsvFile::indexCacheName()
+{
+  return m_fileName+".tsvidx";
+}
+
+/// @brief     The size, time and a checksum of the start and end of a
+///            file, which say if the file has changed since it was indexed.
+/// @param     fname     file to look at
+/// @param     file_size the size of the file
+/// @param     file_time the modification time of the file
+/// @return    the checksum
+static std::string
+tsv_index_cache_key(const std::string& fname,int64_t& file_size,int64_t& file_time)
+{
+  file_size=Fs::fileSize(fname,false);
+  file_time=Fs::fileModTime(fname,false);
+
+  std::fstream in;
+  Fs::aptOpen(in,fname,std::fstream::in|std::fstream::binary);
+  std::vector<char> buf(TSV_INDEX_CACHE_SUMSIZE);
+  affx::md5sum md5;
+  in.read(&buf[0],buf.size());
+  md5.update(&buf[0],(uint32_t)in.gcount());
+  if (file_size>(int64_t)(2*buf.size())) {
+    in.clear();
+    in.seekg(file_size-buf.size());
+    in.read(&buf[0],buf.size());
+    md5.update(&buf[0],(uint32_t)in.gcount());
+  }
+  std::string sum;
+  md5.final(sum);
+  return sum;
+}
+
+/// @brief     Fill in the indexes from the sidecar file, if it was
+///            written for this version of the file with the same indexes.
+/// @return    TSV_OK if the indexes were read.
+int
+affx::TsvFile::indexCacheRead()
+{
+  std::string cache_name=indexCacheName();
+  if (!Fs::fileExists(cache_name)) {
+    return TSV_ERR_NOTFOUND;
+  }
+  int64_t cache_size=Fs::fileSize(cache_name,false);
+
+  int64_t file_size,file_time;
+  std::string file_sum=tsv_index_cache_key(m_fileName,file_size,file_time);
+
+  std::fstream in;
+  Fs::aptOpen(in,cache_name,std::fstream::in|std::fstream::binary);
+  if (!in.good()) {
+    return TSV_ERR_FILEIO;
+  }
+
+  uint32_t head[2];
+  int64_t cache_file[2];
+  std::vector<char> cache_sum;
+  in.read((char*)head,sizeof(head));
+  in.read((char*)cache_file,sizeof(cache_file));
+  if (!in.good()||
+      (head[0]!=TSV_INDEX_CACHE_MAGIC)||(head[1]!=TSV_INDEX_CACHE_VERSION)||
+      (cache_file[0]!=file_size)||(cache_file[1]!=file_time)||
+      !tsv_read_vec(in,cache_sum,cache_size)||
+      (std::string(cache_sum.begin(),cache_sum.end())!=file_sum)) {
+    return TSV_ERR_FORMAT;
+  }
+
+  // the line index
+  uint32_t clvl_cnt=0;
+  bool ok=tsv_read_vec(in,m_index_linefpos,cache_size);
+  in.read((char*)&clvl_cnt,sizeof(clvl_cnt));
+  ok=ok&&in.good()&&(clvl_cnt==m_index_lineclvl.size());
+  for (unsigned int clvl=0;ok&&(clvl<m_index_lineclvl.size());clvl++) {
+    ok=tsv_read_vec(in,m_index_lineclvl[clvl],cache_size);
+  }
+
+  // each of our indexes must be there in the same order.
+  uint32_t index_cnt=0;
+  in.read((char*)&index_cnt,sizeof(index_cnt));
+  ok=ok&&in.good();
+  unsigned int i=0;
+  for (unsigned int vi=0;ok&&(vi<m_index_vec.size());vi++) {
+    if (m_index_vec[vi]!=NULL) {
+      ok=(i<index_cnt)&&(m_index_vec[vi]->read(in,cache_size)==TSV_OK);
+      i++;
+    }
+  }
+  ok=ok&&(i==index_cnt);
+
+  if (!ok) {
+    // start over.
+    m_index_linefpos.clear();
+    for (unsigned int clvl=0;clvl<m_index_lineclvl.size();clvl++) {
+      m_index_lineclvl[clvl].clear();
+    }
+    for (unsigned int vi=0;vi<m_index_vec.size();vi++) {
+      if (m_index_vec[vi]!=NULL) {
+        m_index_vec[vi]->clear();
+      }
+    }
+    return TSV_ERR_FORMAT;
+  }
+
+  Verbose::out(3,"TsvFile: read index of '"+m_fileName+"' from '"+cache_name+"'");
+  return TSV_OK;
+}
+
+/// @brief     Write the indexes to the sidecar file.
+///            Not being able to write it is not an error.
+/// @return    tsv_return_t
+int
+affx::TsvFile::indexCacheWrite()
+{
+  std::string cache_name=indexCacheName();
+  int64_t file_size,file_time;
+  std::string file_sum=tsv_index_cache_key(m_fileName,file_size,file_time);
+
+  // write to a temp name and move it into place so a reader
+  // never sees half of one.
+  std::string tmp_name=cache_name+".tmp";
+  std::fstream out;
+  Fs::aptOpen(out,tmp_name,std::fstream::out|std::fstream::binary|std::fstream::trunc);
+  if (!out.good()) {
+    Verbose::out(3,"TsvFile: unable to write index '"+cache_name+"'");
+    return TSV_ERR_FILEIO;
+  }
+
+  uint32_t head[2]={TSV_INDEX_CACHE_MAGIC,TSV_INDEX_CACHE_VERSION};
+  int64_t cache_file[2]={file_size,file_time};
+  out.write((const char*)head,sizeof(head));
+  out.write((const char*)cache_file,sizeof(cache_file));
+  tsv_write_vec(out,std::vector<char>(file_sum.begin(),file_sum.end()));
+
+  tsv_write_vec(out,m_index_linefpos);
+  uint32_t clvl_cnt=m_index_lineclvl.size();
+  out.write((const char*)&clvl_cnt,sizeof(clvl_cnt));
+  for (unsigned int clvl=0;clvl<m_index_lineclvl.size();clvl++) {
+    tsv_write_vec(out,m_index_lineclvl[clvl]);
+  }
+
+  uint32_t index_cnt=0;
+  for (unsigned int vi=0;vi<m_index_vec.size();vi++) {
+    if (m_index_vec[vi]!=NULL) {
+      index_cnt++;
+    }
+  }
+  out.write((const char*)&index_cnt,sizeof(index_cnt));
+  for (unsigned int vi=0;vi<m_index_vec.size();vi++) {
+    if (m_index_vec[vi]!=NULL) {
+      m_index_vec[vi]->write(out);
+    }
+  }
+
+  bool ok=out.good();
+  out.close();
+  if (!ok||!Fs::fileRename(tmp_name,cache_name,false)) {
+    Fs::rm(tmp_name,false);
+    Verbose::out(3,"TsvFile: unable to write index '"+cache_name+"'");
+    return TSV_ERR_FILEIO;
+  }
   return TSV_OK;
 }
 
@@ -4382,6 +4921,59 @@ TSV_DEFUN_FIND_BEGIN(std::string,uint64_t);
 
 #undef TSV_DEFUN_FIND_BEGIN
 
+/// @brief     Find the lines with values in [lo,hi]
+/// @param     clvl   column level
+/// @param     cidx   column index
+/// @param     lo     lowest value
+/// @param     hi     highest value
+/// @param     flags  how to order the results (tsv_orderby_t)
+/// @return    tsv_error_t
+template<typename T1,typename T2>
+int
+affx::TsvFile::findBeginRange_tmpl(int clvl,T1 cidx,T2 lo,T2 hi,int flags)
+{
+  findResultsClear();
+
+  int cidx_int=cname2cidx(clvl,cidx);
+  if ((clvl<0)||(cidx_int<0)) {
+    return (TSV_ERR_NOTFOUND);
+  }
+
+  indexBuildMaybe();
+
+  TsvFileIndex* idx=index_matching_1(clvl,cidx_int,lo);
+  if (idx==NULL) {
+    return (TSV_ERR_NOTFOUND);
+  }
+
+  idx->results_append_range(m_findresults,lo,hi);
+
+  if ((flags&TSV_ORDERBY_LINE)!=0) {
+    sort(m_findresults.begin(),m_findresults.end());
+  }
+  return TSV_OK;
+}
+
+#define TSV_DEFUN_FIND_BEGIN_RANGE(Xtype1,Xtype2) \
+int \
+affx::TsvFile::findBeginRange(int clvl,Xtype1 cidx,Xtype2 lo,Xtype2 hi,int flags)  \
+{ \
+  return findBeginRange_tmpl(clvl,cidx,lo,hi,flags);    \
+}
+
+TSV_DEFUN_FIND_BEGIN_RANGE(int        ,std::string);
+TSV_DEFUN_FIND_BEGIN_RANGE(std::string,std::string);
+TSV_DEFUN_FIND_BEGIN_RANGE(int        ,int);
+TSV_DEFUN_FIND_BEGIN_RANGE(std::string,int);
+TSV_DEFUN_FIND_BEGIN_RANGE(int        ,double);
+TSV_DEFUN_FIND_BEGIN_RANGE(std::string,double);
+TSV_DEFUN_FIND_BEGIN_RANGE(int        ,unsigned int);
+TSV_DEFUN_FIND_BEGIN_RANGE(std::string,unsigned int);
+TSV_DEFUN_FIND_BEGIN_RANGE(int        ,uint64_t);
+TSV_DEFUN_FIND_BEGIN_RANGE(std::string,uint64_t);
+
+#undef TSV_DEFUN_FIND_BEGIN_RANGE
+
 //////////
 
 /// @brief     Return the count of found lines.
@@ -4678,54 +5270,54 @@ affx::TsvFile::writeLevel(int clvl)
     return (TSV_ERR_NOTFOUND);
   }
 
+  // the line is formatted into m_linebuf and written with one call;
+  // the buffer keeps its capacity from line to line.
+  std::string& line=m_linebuf;
+  line.clear();
+
   // indent for the current level
-  writeFieldSep(clvl);
+  line.append(clvl,(char)m_optFieldSep);
 
   size_t cidx_size=(int)m_column_map[clvl].size();
   size_t cidx_size_1=cidx_size-1;
-  int last_precision=-1;
+  bool doEscape=((m_optEscapeOk==true)&&(m_optEscapeChar!=0));
 
   for (size_t cidx=0;cidx<cidx_size;cidx++) {
     TsvFileField* col=&m_column_map[clvl][cidx];
     //
     if (m_optDoQuote==true) {
-      m_fileStream<<m_optQuoteChar;
+      line.push_back((char)m_optQuoteChar);
     }
     // pick an output method based on the the current format of the value.
     // the ifs are ordered by frequency.
     if (col->m_val_state==affx::VALSTATE_STRING) {
-      if ((m_optEscapeOk==true)&&(m_optEscapeChar!=0)) {
-        m_fileStream << escapeString(col->m_buffer,m_optEscapeChar);
+      if (doEscape) {
+        tsv_append_escaped(line,col->m_buffer,m_optEscapeChar);
       }
       else {
-        m_fileStream << col->m_buffer;
+        line.append(col->m_buffer);
       }
     }
     else if (col->m_val_state==affx::VALSTATE_DOUBLE) {
-      // change in precision?  Avoid doing this each time around.
-      if (last_precision!=col->m_precision) {
-        m_fileStream.setf(ios::fixed, ios::floatfield);
-        m_fileStream.precision(col->m_precision);
-        last_precision=col->m_precision;
-      }
-      m_fileStream << col->m_value_double;
+      tsv_append_double(line,col->m_value_double,col->m_precision);
     }
     else if (col->m_val_state==affx::VALSTATE_INT) {
-      m_fileStream << col->m_value_int;
+      NumFormat::appendInt(line,col->m_value_int);
     }
     else {
       TSV_ERR_ABORT("writeLevel(): internal error. m_val_state="+ToStr(col->m_val_state));
     }
     //
     if (m_optDoQuote==true) {
-      m_fileStream<<m_optQuoteChar;
+      line.push_back((char)m_optQuoteChar);
     }
     //
     if (cidx<cidx_size_1) {
-      m_fileStream << m_optFieldSep;
+      line.push_back((char)m_optFieldSep);
     }
   }
-  m_fileStream << m_optEndl;
+  line.append(m_optEndl);
+  m_fileStream.write(line.data(),line.size());
 
   //
   if (!m_fileStream.good()) {
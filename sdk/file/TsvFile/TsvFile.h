@@ -41,8 +41,11 @@
 
 /// The default number of decimal places in output
 #define TSV_DEFAULT_PRECISION 6
-/// Access the rdbuf of the fstream directly.
-#define TSV_USE_RDBUF 1
+/// A precision which writes doubles with the fewest digits that read
+/// back as the same value. (Other negative precisions are 6, like iostreams.)
+#define TSV_PRECISION_SHORTEST (-2)
+/// The size of the block read from the file at a time.
+#define TSV_READ_BUFFER_SIZE (1024*1024)
 
 //////////
 
@@ -119,6 +122,7 @@ namespace affx {
     TSV_OP_EQ     = 0x02,
     TSV_OP_GTEQ   = 0x06,
     TSV_OP_GT     = 0x04,
+    TSV_OP_PREFIX = 0x08, ///< string values starting with the value
   };
 
   /// The datatype of a index
@@ -357,12 +361,21 @@ public:
   int  m_flags;  ///< flags for the index (unused)
   bool m_done;   ///< has the index been populated?
 
-  // @todo Change this to something denser
-  std::multimap<std::string,linenum_t> m_index_str2line;    ///< map of string value to lines
-  std::multimap<int        ,linenum_t> m_index_int2line;    ///< map of int values to lines
-  std::multimap<double     ,linenum_t> m_index_double2line; ///< map of double values to lines
-  std::multimap<unsigned int,linenum_t> m_index_uint2line;     ///< map of unsigned int values to lines
-  std::multimap<uint64_t   ,linenum_t> m_index_ulonglong2line; ///< map of uint64_t values to lines
+  /// A string value: m_len chars at m_off in m_index_str_pool.
+  struct str_entry_t {
+    uint64_t  m_off;
+    uint32_t  m_len;
+    linenum_t m_line;
+  };
+
+  // The indexes are vectors of (value,line) which finish() sorts once
+  // all the lines have been added. Only the one for m_kind is used.
+  std::vector<str_entry_t> m_index_str2line;    ///< string values to lines
+  std::vector<char>        m_index_str_pool;    ///< the chars of the string values
+  std::vector<std::pair<int         ,linenum_t> > m_index_int2line;       ///< int values to lines
+  std::vector<std::pair<double      ,linenum_t> > m_index_double2line;    ///< double values to lines
+  std::vector<std::pair<unsigned int,linenum_t> > m_index_uint2line;      ///< unsigned int values to lines
+  std::vector<std::pair<uint64_t    ,linenum_t> > m_index_ulonglong2line; ///< uint64_t values to lines
 
   //
   TsvFileIndex();
@@ -372,19 +385,30 @@ public:
   void init();
   void clear();
   void data_add(TsvFileField* field,linenum_t line);
+  void finish();
   //
   int results_append(std::vector<linenum_t>& results,int op,std::string val);
   int results_append(std::vector<linenum_t>& results,int op,int         val);
   int results_append(std::vector<linenum_t>& results,int op,double      val);
   int results_append(std::vector<linenum_t>& results,int op,unsigned int val);
   int results_append(std::vector<linenum_t>& results,int op,uint64_t    val);
+  // values in [lo,hi]
+  int results_append_range(std::vector<linenum_t>& results,std::string  lo,std::string  hi);
+  int results_append_range(std::vector<linenum_t>& results,int          lo,int          hi);
+  int results_append_range(std::vector<linenum_t>& results,double       lo,double       hi);
+  int results_append_range(std::vector<linenum_t>& results,unsigned int lo,unsigned int hi);
+  int results_append_range(std::vector<linenum_t>& results,uint64_t     lo,uint64_t     hi);
+  //
+  int write(std::ostream& out);
+  int read(std::istream& in,int64_t max_size);
   //
   void dump();
 
   // Templates are private to prevent accidental use.
 private:
-  template <typename T1, typename linenum_t> int results_append_tmpl(std::vector<linenum_t>& results,std::multimap<T1,linenum_t>& map,int op,T1& val);
-  template<typename T1, typename linenum_t> void dump_map(std::multimap<T1,linenum_t>& map);
+  template <typename T1, typename linenum_t> int results_append_tmpl(std::vector<linenum_t>& results,std::vector<std::pair<T1,linenum_t> >& index,int op,T1& val);
+  template <typename T1, typename linenum_t> int results_append_range_tmpl(std::vector<linenum_t>& results,std::vector<std::pair<T1,linenum_t> >& index,T1& lo,T1& hi);
+  template<typename T1, typename linenum_t> void dump_vec(std::vector<std::pair<T1,linenum_t> >& index);
 };
 
 
@@ -435,6 +459,7 @@ public:
   bool m_optEscapeOk;           ///< Obey the escapechar?
   bool m_optHasColumnHeader;    ///< read the first line as column headers?
   bool m_optThrowOnError;       ///< ?
+  bool m_optIndexCache;         ///< Save the indexes in a file next to this one and reuse them.
 
   unsigned char m_optQuoteChar; ///< Quote char to use
   std::string m_optEndl;        ///< End of line sequence to use
@@ -470,6 +495,8 @@ private:
 
   // A handle for IO operations
   std::fstream m_fileStream;
+  /// writeLevel() formats the line here and writes it in one go.
+  std::string m_linebuf;
 
   //public:
   std::fstream::pos_type m_line_fpos; ///< Where the current line starts
@@ -860,6 +887,10 @@ public:
 #endif
   int indexBuild();
   int indexBuildMaybe();
+  // The sidecar file of m_optIndexCache.
+  std::string indexCacheName();
+  int indexCacheRead();
+  int indexCacheWrite();
 #ifndef SWIG
   //
   TsvFileIndex* index_matching(int clvl,int cidx,int kind);
@@ -878,6 +909,7 @@ public:
 
 private:
   template<typename T1,typename T2> int findBegin_tmpl(int clvl,T1 cidx,int op,T2 val,int flags);
+  template<typename T1,typename T2> int findBeginRange_tmpl(int clvl,T1 cidx,T2 lo,T2 hi,int flags);
 public:
   /// These are instances of the above template
   /// The user will get a better error message
@@ -901,6 +933,19 @@ public:
   int findBegin(int clvl,std::string cname,int op,uint64_t     val,int flags=TSV_ORDERBY_LINE);
   /// \brief like findBegin with different types
   int findBegin(int clvl,int cidx         ,int op,uint64_t     val,int flags=TSV_ORDERBY_LINE);
+#endif
+  /// \brief like findBegin, but for the values in [lo,hi].
+  int findBeginRange(int clvl,std::string cname,std::string lo,std::string hi,int flags=TSV_ORDERBY_LINE);
+  int findBeginRange(int clvl,int cidx         ,std::string lo,std::string hi,int flags=TSV_ORDERBY_LINE);
+  int findBeginRange(int clvl,std::string cname,int         lo,int         hi,int flags=TSV_ORDERBY_LINE);
+  int findBeginRange(int clvl,int cidx         ,int         lo,int         hi,int flags=TSV_ORDERBY_LINE);
+  int findBeginRange(int clvl,std::string cname,double      lo,double      hi,int flags=TSV_ORDERBY_LINE);
+  int findBeginRange(int clvl,int cidx         ,double      lo,double      hi,int flags=TSV_ORDERBY_LINE);
+#ifndef SWIG
+  int findBeginRange(int clvl,std::string cname,unsigned int lo,unsigned int hi,int flags=TSV_ORDERBY_LINE);
+  int findBeginRange(int clvl,int cidx         ,unsigned int lo,unsigned int hi,int flags=TSV_ORDERBY_LINE);
+  int findBeginRange(int clvl,std::string cname,uint64_t     lo,uint64_t     hi,int flags=TSV_ORDERBY_LINE);
+  int findBeginRange(int clvl,int cidx         ,uint64_t     lo,uint64_t     hi,int flags=TSV_ORDERBY_LINE);
 #endif
   //
   int findNext();
@@ -908,10 +953,25 @@ public:
   unsigned int findResultsCount();
   int findResultsClear();
 
-#ifdef TSV_USE_RDBUF
-  // This appears to be faster than calling ".get()"
+  // The file is read in large blocks from the filebuf and scanned
+  // in m_rbuf, rather than a char at a time.
   std::filebuf *m_rdbuf;
-#endif
+private:
+  char* m_rbuf;              ///< m_rbuf[i] is at file offset m_rbuf_fpos+i
+  size_t m_rbuf_beg;         ///< first valid char (m_rbuf[0] is the last char of the previous block)
+  size_t m_rbuf_pos;         ///< the next char to read
+  size_t m_rbuf_end;         ///< one past the last valid char
+  std::streamoff m_rbuf_fpos;
+  /// Chars which end the fast scan of a field, for m_rbuf_stop_opts.
+  unsigned char m_rbuf_stop[256];
+  std::string m_rbuf_stop_opts;
+  //
+  bool f_rbuf_fill();
+  void f_rbuf_reset(std::streamoff fpos);
+  void f_rbuf_set_stop();
+  std::fstream::pos_type f_tell();
+  void f_seek(std::fstream::pos_type fpos);
+public:
 
   /// used for debugging
   void dump();
@@ -30,7 +30,12 @@
 #include "file/TsvFile/PgfFile.h"
 #include "file/TsvFile/SnpTable.h"
 #include "file/TsvFile/TsvFile.h"
+#include "util/Convert.h"
+#include "util/Fs.h"
 //
+#include <algorithm>
+#include <cstdio>
+#include <ctime>
 #include <sstream>
 //
 
@@ -946,6 +951,168 @@ check_index_1()
   tsv.close();
 }
 
+/// @brief     Write a file for check_index_2.
+static void
+write_index_test(const std::string& fname,int line_cnt)
+{
+  FILE* fh=fopen(fname.c_str(),"wb");
+  assert(fh!=NULL);
+  fprintf(fh,"name\tkey\tval\n");
+  // names and keys are out of order and repeat.
+  for (int i=0;i<line_cnt;i++) {
+    fprintf(fh,"rs%d\t%d\t%d\n",(int)(((int64_t)i*7919)%(line_cnt/2)),(int)(((int64_t)i*104729)%1000),i);
+  }
+  fclose(fh);
+}
+
+/// @brief     Check the string and int indexes against a scan of the
+///            file, with and without the sidecar index.
+static void
+check_index_2_file(const std::string& fname,int line_cnt,bool cache)
+{
+  affx::TsvFile tsv;
+  tsv.m_optIndexCache=cache;
+  int rv=tsv.open(fname);
+  assert(rv==TSV_OK);
+  rv=tsv.defineIndex(0,"name",TSV_INDEX_STRING,0);
+  assert(rv==TSV_OK);
+  rv=tsv.defineIndex(0,"key",TSV_INDEX_INT,0);
+  assert(rv==TSV_OK);
+
+  int key,val;
+  std::string name;
+  std::vector<int> key_vec;
+  std::vector<std::string> name_vec;
+  tsv.bind(0,"name",&name,TSV_BIND_REQUIRED);
+  tsv.bind(0,"key",&key,TSV_BIND_REQUIRED);
+  tsv.bind(0,"val",&val,TSV_BIND_REQUIRED);
+  while (tsv.nextLevel(0)==TSV_OK) {
+    name_vec.push_back(name);
+    key_vec.push_back(key);
+  }
+  assert((int)key_vec.size()==line_cnt);
+
+  // EQ, in line order.
+  rv=tsv.findBegin(0,"key",TSV_OP_EQ,500);
+  assert(rv==TSV_OK);
+  int last=-1;
+  unsigned int cnt=0;
+  while (tsv.findNext()==TSV_OK) {
+    assert((key==500)&&(val>last));
+    last=val;
+    cnt++;
+  }
+  assert(cnt==(unsigned int)std::count(key_vec.begin(),key_vec.end(),500));
+
+  // the other ops
+  rv=tsv.findBegin(0,"key",TSV_OP_LT,10);
+  assert(rv==TSV_OK);
+  cnt=0;
+  for (int i=0;i<line_cnt;i++) {
+    cnt+=(key_vec[i]<10);
+  }
+  assert(tsv.findResultsCount()==cnt);
+  rv=tsv.findBegin(0,"key",TSV_OP_GTEQ,990);
+  cnt=0;
+  for (int i=0;i<line_cnt;i++) {
+    cnt+=(key_vec[i]>=990);
+  }
+  assert(tsv.findResultsCount()==cnt);
+
+  // ranges
+  rv=tsv.findBeginRange(0,"key",100,199);
+  assert(rv==TSV_OK);
+  cnt=0;
+  for (int i=0;i<line_cnt;i++) {
+    cnt+=((key_vec[i]>=100)&&(key_vec[i]<=199));
+  }
+  assert(tsv.findResultsCount()==cnt);
+  while (tsv.findNext()==TSV_OK) {
+    assert((key>=100)&&(key<=199));
+  }
+
+  // strings and prefixes
+  rv=tsv.findBegin(0,"name",TSV_OP_EQ,std::string("rs42"));
+  assert(rv==TSV_OK);
+  assert(tsv.findResultsCount()==(unsigned int)std::count(name_vec.begin(),name_vec.end(),"rs42"));
+  while (tsv.findNext()==TSV_OK) {
+    assert(name=="rs42");
+  }
+  rv=tsv.findBegin(0,"name",TSV_OP_PREFIX,std::string("rs12"));
+  assert(rv==TSV_OK);
+  cnt=0;
+  for (int i=0;i<line_cnt;i++) {
+    cnt+=(name_vec[i].compare(0,4,"rs12")==0);
+  }
+  assert((cnt>0)&&(tsv.findResultsCount()==cnt));
+  while (tsv.findNext()==TSV_OK) {
+    assert(name.compare(0,4,"rs12")==0);
+  }
+  rv=tsv.findBeginRange(0,"name",std::string("rs2"),std::string("rs3"));
+  assert(rv==TSV_OK);
+  cnt=0;
+  for (int i=0;i<line_cnt;i++) {
+    cnt+=((name_vec[i]>="rs2")&&(name_vec[i]<="rs3"));
+  }
+  assert(tsv.findResultsCount()==cnt);
+
+  tsv.close();
+}
+
+/// @brief     Check the sorted indexes and the sidecar index file.
+void
+check_index_2()
+{
+  std::string fname="test-index.tsv";
+  std::string cache_name=fname+".tsvidx";
+  int line_cnt=20000;
+  remove(cache_name.c_str());
+
+  write_index_test(fname,line_cnt);
+  check_index_2_file(fname,line_cnt,false);
+  assert(!Fs::fileExists(cache_name));
+  // written...
+  check_index_2_file(fname,line_cnt,true);
+  assert(Fs::fileExists(cache_name));
+  // ...and read.
+  check_index_2_file(fname,line_cnt,true);
+
+  // a changed file is reindexed.
+  write_index_test(fname,line_cnt+100);
+  check_index_2_file(fname,line_cnt+100,true);
+
+  remove(cache_name.c_str());
+  remove(fname.c_str());
+}
+
+/// @brief     Time indexing a file and reading the indexes back.
+void
+check_index_timing()
+{
+  std::string fname="test-index-timing.tsv";
+  std::string cache_name=fname+".tsvidx";
+  int line_cnt=1000000;
+  remove(cache_name.c_str());
+  write_index_test(fname,line_cnt);
+
+  for (int pass=0;pass<2;pass++) {
+    clock_t start=clock();
+    affx::TsvFile tsv;
+    tsv.m_optIndexCache=true;
+    tsv.open(fname);
+    tsv.defineIndex(0,"name",TSV_INDEX_STRING,0);
+    tsv.defineIndex(0,"key",TSV_INDEX_INT,0);
+    int rv=tsv.findBegin(0,"key",TSV_OP_EQ,7);
+    assert(rv==TSV_OK);
+    unsigned int cnt=tsv.findResultsCount();
+    tsv.close();
+    double seconds=(double)(clock()-start)/CLOCKS_PER_SEC;
+    printf("%s index of %d lines: %.3fs (%u found)\n",(pass==0)?"Built":"Read",line_cnt,seconds,cnt);
+  }
+  remove(cache_name.c_str());
+  remove(fname.c_str());
+}
+
 /// @brief     Check that we can read a windows path name
 void
 check_winpath_1()
@@ -1151,6 +1318,324 @@ void check_replace()
 
 }
 
+/// @brief     Write a small file with the given line ending and check
+///            that the values and line numbers come back the same.
+void
+check_eol_1(const std::string& eol)
+{
+  std::string fname="test-eol.tsv";
+  FILE* fh=fopen(fname.c_str(),"wb");
+  assert(fh!=NULL);
+  fprintf(fh,"#%%key=val%s",eol.c_str());
+  fprintf(fh,"name\tval%s",eol.c_str());
+  for (int i=0;i<10;i++) {
+    fprintf(fh,"n%d\t%d%s",i,i*i,eol.c_str());
+  }
+  fclose(fh);
+
+  affx::TsvFile tsv;
+  int rv=tsv.open(fname);
+  assert(rv==TSV_OK);
+  std::string header;
+  assert((tsv.getHeader("key",header)==TSV_OK)&&(header=="val"));
+  std::string name;
+  int val;
+  tsv.bind(0,"name",&name,TSV_BIND_REQUIRED);
+  tsv.bind(0,"val",&val,TSV_BIND_REQUIRED);
+  int cnt=0;
+  while (tsv.nextLevel(0)==TSV_OK) {
+    assert(name==("n"+ToStr(cnt)));
+    assert(val==cnt*cnt);
+    cnt++;
+  }
+  assert(cnt==10);
+  tsv.close();
+  remove(fname.c_str());
+}
+
+/// @brief     Read a file which is several times the size of the read
+///            buffer so that fields and CRLF pairs are split across refills.
+void
+check_read_large_1()
+{
+  std::string fname="test-large.tsv";
+  int line_cnt=100000;
+  FILE* fh=fopen(fname.c_str(),"wb");
+  assert(fh!=NULL);
+  fprintf(fh,"id\tseq\tval\r\n");
+  for (int i=0;i<line_cnt;i++) {
+    // the escaped and quoted fields take the slow path.
+    if (i%1000==0) {
+      fprintf(fh,"%d\t'A\\tC'\t%d\r\n",i,i%97);
+    }
+    else {
+      fprintf(fh,"%d\t%.*s\t%d\r\n",i,i%40,"ACGTACGTACGTACGTACGTACGTACGTACGTACGTACGT",i%97);
+    }
+  }
+  fclose(fh);
+
+  affx::TsvFile tsv;
+  int rv=tsv.open(fname);
+  assert(rv==TSV_OK);
+  int id,val;
+  std::string seq;
+  tsv.bind(0,"id",&id,TSV_BIND_REQUIRED);
+  tsv.bind(0,"seq",&seq,TSV_BIND_REQUIRED);
+  tsv.bind(0,"val",&val,TSV_BIND_REQUIRED);
+  int cnt=0;
+  while (tsv.nextLevel(0)==TSV_OK) {
+    assert(id==cnt);
+    assert(val==cnt%97);
+    if (cnt%1000==0) {
+      assert(seq=="A\tC");
+    }
+    else {
+      assert(seq==std::string("ACGTACGTACGTACGTACGTACGTACGTACGTACGTACGT",cnt%40));
+    }
+    cnt++;
+  }
+  assert(cnt==line_cnt);
+
+  // jump back into the middle of the file.
+  rv=tsv.gotoLine(line_cnt/2);
+  assert(rv==TSV_OK);
+  tsv.nextLevel(0);
+  assert(id==line_cnt/2+1);
+  tsv.close();
+  remove(fname.c_str());
+}
+
+/// @brief     Write a pgf with probeset_cnt probesets of 4 atoms of 2 probes.
+static void
+write_test_pgf(const std::string& fname,int probeset_cnt)
+{
+  FILE* fh=fopen(fname.c_str(),"wb");
+  assert(fh!=NULL);
+  fprintf(fh,"#%%pgf_format_version=1.0\n");
+  fprintf(fh,"#%%chip_type=test\n");
+  fprintf(fh,"#%%lib_set_name=test\n");
+  fprintf(fh,"#%%lib_set_version=1\n");
+  fprintf(fh,"#%%header0=probeset_id\ttype\tprobeset_name\n");
+  fprintf(fh,"#%%header1=\tatom_id\n");
+  fprintf(fh,"#%%header2=\t\tprobe_id\ttype\tgc_count\tprobe_length\tinterrogation_position\tprobe_sequence\n");
+  int probe_id=1;
+  for (int ps=0;ps<probeset_cnt;ps++) {
+    fprintf(fh,"%d\tnormgene->intron\tps_%d\n",ps+1,ps+1);
+    for (int atom=0;atom<4;atom++) {
+      fprintf(fh,"\t%d\n",ps*4+atom+1);
+      for (int p=0;p<2;p++) {
+        fprintf(fh,"\t\t%d\tpm:st\t%d\t25\t13\tACAACGACCGTTCCGGAATCGACAT\n",probe_id,probe_id%26);
+        probe_id++;
+      }
+    }
+  }
+  fclose(fh);
+}
+
+/// @brief     Time loading pgf files of several sizes.
+void
+check_pgf_load_timing()
+{
+  int sizes[]={1000,10000,100000,300000};
+  std::string fname="test-timing.pgf";
+
+  for (int si=0;si<(int)(sizeof(sizes)/sizeof(sizes[0]));si++) {
+    write_test_pgf(fname,sizes[si]);
+
+    clock_t start=clock();
+    affx::PgfFile pgf;
+    int rv=pgf.open(fname);
+    assert(rv==TSV_OK);
+    int probe_cnt=0;
+    int64_t probe_sum=0;
+    while (pgf.next_probeset()==affx::TSV_OK) {
+      while (pgf.next_atom()==affx::TSV_OK) {
+        while (pgf.next_probe()==affx::TSV_OK) {
+          probe_cnt++;
+          probe_sum+=pgf.probe_id+pgf.gc_count;
+        }
+      }
+    }
+    pgf.close();
+    double seconds=(double)(clock()-start)/CLOCKS_PER_SEC;
+
+    int64_t n=sizes[si]*8;
+    assert(probe_cnt==n);
+    int64_t gc_sum=0;
+    for (int64_t i=1;i<=n;i++) {
+      gc_sum+=i%26;
+    }
+    assert(probe_sum==(n*(n+1))/2+gc_sum);
+    printf("Loaded pgf of %d probesets (%d probes) in %.3fs\n",sizes[si],probe_cnt,seconds);
+  }
+  remove(fname.c_str());
+}
+
+//////////
+
+/// @brief     The text of a double as an ostream set to fixed writes it.
+std::string
+ostream_fixed(double val,int precision)
+{
+  std::ostringstream stream;
+  stream.setf(std::ios::fixed,std::ios::floatfield);
+  stream.precision(precision);
+  stream << val;
+  return stream.str();
+}
+
+/// @brief     A random double spread over many magnitudes.
+double
+format_test_value(uint64_t& bits)
+{
+  bits^=bits<<13; bits^=bits>>7; bits^=bits<<17;
+  double val=(double)((int64_t)(bits%2000000001ULL)-1000000000);
+  return val/(double)((int64_t)1<<(bits%40));
+}
+
+/// @brief     Check the values written are the text the ostreams wrote
+///            and that the shortest values read back exactly.
+void
+check_write_format_1()
+{
+  std::string fname="check-format.tsv";
+  int precs[]={6,3,0,9};
+  int prec_cnt=sizeof(precs)/sizeof(precs[0]);
+  double special[]={-0.0,0.125,-0.0000001,2.5,0.5,1e300};
+  int special_cnt=sizeof(special)/sizeof(special[0]);
+  int line_cnt=5000;
+  int rv;
+
+  affx::TsvFile tsv;
+  tsv.defineColumn(0,0,"name");
+  tsv.defineColumn(0,1,"int");
+  for (int p=0;p<prec_cnt;p++) {
+    tsv.defineColumn(0,2+p,"fixed_"+ToStr(precs[p]));
+    tsv.setPrecision(0,2+p,precs[p]);
+  }
+  tsv.defineColumn(0,6,"shortest");
+  tsv.setPrecision(0,6,TSV_PRECISION_SHORTEST);
+  tsv.defineColumn(0,7,"vec");
+  tsv.setPrecision(0,7,2);
+  rv=tsv.writeTsv_v1(fname);
+  assert(rv==TSV_OK);
+
+  uint64_t bits=88172645463325252ULL;
+  for (int i=0;i<line_cnt;i++) {
+    double val=format_test_value(bits);
+    if (i<special_cnt) {
+      val=special[i];
+    }
+    std::vector<float> vec;
+    vec.push_back((float)val);
+    vec.push_back((float)(val/3));
+    // a tab in the name to be escaped.
+    tsv.set(0,0,"row\t"+ToStr(i));
+    tsv.set(0,1,(int)(bits%2000000000ULL)-1000000000);
+    for (int p=0;p<prec_cnt;p++) {
+      tsv.set(0,2+p,val);
+    }
+    tsv.set(0,6,val);
+    tsv.set(0,7,vec);
+    rv=tsv.writeLevel(0);
+    assert(rv==TSV_OK);
+  }
+  tsv.close();
+
+  rv=tsv.open(fname);
+  assert(rv==TSV_OK);
+  bits=88172645463325252ULL;
+  std::string str;
+  double dval;
+  int i=0;
+  while (tsv.nextLevel(0)==TSV_OK) {
+    double val=format_test_value(bits);
+    if (i<special_cnt) {
+      val=special[i];
+    }
+    tsv.get(0,0,str);
+    assert(str=="row\t"+ToStr(i));
+    tsv.get(0,1,str);
+    assert(str==ToStr((int)(bits%2000000000ULL)-1000000000));
+    for (int p=0;p<prec_cnt;p++) {
+      tsv.get(0,2+p,str);
+      assert(str==ostream_fixed(val,precs[p]));
+    }
+    tsv.get(0,6,dval);
+    assert(dval==val);
+    tsv.get(0,7,str);
+    assert(str==ostream_fixed((float)val,2)+","+ostream_fixed((float)(val/3),2));
+    i++;
+  }
+  assert(i==line_cnt);
+  tsv.close();
+  remove(fname.c_str());
+}
+
+/// @brief     MB/s for writing a wide matrix of doubles, against the
+///            same text made with an ostream per value.
+void
+check_write_matrix_timing()
+{
+  std::string fname="test-write-timing.tsv";
+  int row_cnt=2000;
+  int col_cnt=1000;
+
+  std::vector<double> vals(col_cnt);
+  uint64_t bits=88172645463325252ULL;
+  for (int c=0;c<col_cnt;c++) {
+    vals[c]=format_test_value(bits)/1000.0;
+  }
+
+  // the old way.
+  clock_t start=clock();
+  std::ofstream ostrm(fname.c_str());
+  for (int r=0;r<row_cnt;r++) {
+    ostrm << "probeset_" << r;
+    for (int c=0;c<col_cnt;c++) {
+      std::ostringstream stream;
+      stream.setf(std::ios::fixed,std::ios::floatfield);
+      stream.precision(5);
+      stream << vals[c]+r;
+      ostrm << '\t' << stream.str();
+    }
+    ostrm << "\n";
+  }
+  ostrm.close();
+  double ostream_seconds=(double)(clock()-start)/CLOCKS_PER_SEC;
+  int64_t ostream_bytes=Fs::fileSize(fname);
+
+  //
+  start=clock();
+  affx::TsvFile tsv;
+  // the default for the columns defined after it.
+  tsv.setPrecision(5);
+  tsv.defineColumn(0,0,"probeset_id");
+  for (int c=0;c<col_cnt;c++) {
+    tsv.defineColumn(0,c+1,"sample_"+ToStr(c));
+  }
+  tsv.writeTsv_v1(fname);
+  int64_t header_bytes=Fs::fileSize(fname);
+  for (int r=0;r<row_cnt;r++) {
+    tsv.set(0,0,"probeset_"+ToStr(r));
+    for (int c=0;c<col_cnt;c++) {
+      tsv.set(0,c+1,vals[c]+r);
+    }
+    tsv.writeLevel(0);
+  }
+  tsv.close();
+  double tsv_seconds=(double)(clock()-start)/CLOCKS_PER_SEC;
+  int64_t tsv_bytes=Fs::fileSize(fname)-header_bytes;
+  // the data lines are the same text.
+  assert(tsv_bytes==ostream_bytes);
+
+  printf("Wrote %dx%d matrix (%.1f MB): ostream %.1f MB/s, TsvFile %.1f MB/s\n",
+         row_cnt,col_cnt,tsv_bytes/1048576.0,
+         tsv_bytes/1048576.0/(ostream_seconds>0?ostream_seconds:1e-6),
+         tsv_bytes/1048576.0/(tsv_seconds>0?tsv_seconds:1e-6));
+  remove(fname.c_str());
+}
+
 //////////
 
 /// @brief     Main function to call all the check tests
@@ -1183,6 +1668,8 @@ main(int argc,char* argv[])
   check_csv_1();
   //
   check_index_1();
+  check_index_2();
+  check_index_timing();
   //
   check_winpath_1();
   //
@@ -1201,5 +1688,14 @@ main(int argc,char* argv[])
   //
   check_replace();
   //
+  check_eol_1("\n");
+  check_eol_1("\r\n");
+  check_eol_1("\r");
+  check_read_large_1();
+  //
+  check_pgf_load_timing();
+  check_write_format_1();
+  check_write_matrix_timing();
+  //
   printf("ok.\n");
 }
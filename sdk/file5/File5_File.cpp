@@ -33,16 +33,23 @@
 #include "util/Err.h"
 #include "util/Util.h"
 #include "util/Fs.h"
+#include "util/Thread.h"
 //
+#include <algorithm>
 #include <sys/stat.h>
 #include <sys/types.h>
 #include <vector>
 //
 
+/// See setThreadLock().
+static RecursiveMutex File5_File_threadLock;
+static bool File5_File_threadLockOn=false;
+
 //
 affx::File5_File::File5_File()
 {
   m_kind_char='F';
+  m_holds_thread_lock=false;
   init();
 }
 
@@ -99,18 +106,30 @@ affx::File5_File::setFilename(const std::string& file_name)
   m_name=file_name;
 }
 
+void
+affx::File5_File::setThreadLock(bool on)
+{
+  File5_File_threadLockOn=on;
+}
+
 bool
 affx::File5_File::isHdf5file(const std::string& file_name)
 {
   std::string tmp_unc_path=file_name;
   Fs::convertToUncPathInPlace(tmp_unc_path,10);
 
-  if (Fs::isReadable(tmp_unc_path) &&
-      H5Fis_hdf5(tmp_unc_path.c_str())==1) {
-    return true;
+  if (!Fs::isReadable(tmp_unc_path)) {
+    return false;
   }
-  //
-  return false;
+  bool locked=File5_File_threadLockOn;
+  if (locked) {
+    File5_File_threadLock.lock();
+  }
+  bool is_hdf5=(H5Fis_hdf5(tmp_unc_path.c_str())==1);
+  if (locked) {
+    File5_File_threadLock.unlock();
+  }
+  return is_hdf5;
 }
 
 
@@ -131,58 +150,79 @@ affx::File5_File::open(const std::string& file_name,int flags)
   m_flags=flags;
   m_readonly=true;
 
-  // replace means get rid of the orginal and implies create
-  if ((flags&FILE5_REPLACE)==FILE5_REPLACE) {
+  // held until close(); it is given back below if the open fails.
+  if (File5_File_threadLockOn&&!m_holds_thread_lock) {
+    File5_File_threadLock.lock();
+    m_holds_thread_lock=true;
+  }
+  // the chunk cache is set for the whole file.
+  hid_t h5_fapl=H5Pcreate(H5P_FILE_ACCESS);
+  try {
+    FILE5_CHECKID(h5_fapl,"H5Pcreate failed.");
+    affx::file5_hint_set_cache(getOptHint(),h5_fapl);
+    // replace means get rid of the orginal and implies create
+    if ((flags&FILE5_REPLACE)==FILE5_REPLACE) {
 #ifdef FILE5_DEBUG_PRINT
-    printf("### file5: file replace: '%s'\n",m_file_name.c_str());
+      printf("### file5: file replace: '%s'\n",m_file_name.c_str());
 #endif
-    m_h5_obj=H5Fcreate(tmp_unc_path.c_str(), H5F_ACC_TRUNC, H5P_DEFAULT, H5P_DEFAULT);
-    if ( m_h5_obj < 1 ) {
-      Verbose::out(1, "H5Fcreate failed on absolute path, trying relative..." + file_name);
-      m_h5_obj=H5Fcreate(file_name.c_str(), H5F_ACC_TRUNC, H5P_DEFAULT, H5P_DEFAULT);
-      if ( m_h5_obj >= 0 ) {
-        Verbose::out(1, "H5Fcreate ok for relative path: " + file_name);
-      }
-    }    
-    FILE5_CHECKID(m_h5_obj,"could not replace "+FS_QUOTE_PATH(file_name));
-    m_readonly=false;
-  }
-  //
-  else if (((flags&FILE5_OPEN)==FILE5_OPEN)&&(isHdf5file(m_file_name)==1)) {
-    // printf("### file5: file open: '%s'\n",m_file_name.c_str());
-    // check to see if it exists
-    if (!Fs::isReadable(tmp_unc_path)) {
-      FILE5_ABORT("File does not exist or is not readable: "+FS_QUOTE_PATH(tmp_unc_path));
+      m_h5_obj=H5Fcreate(tmp_unc_path.c_str(), H5F_ACC_TRUNC, H5P_DEFAULT, h5_fapl);
+      if ( m_h5_obj < 1 ) {
+        Verbose::out(1, "H5Fcreate failed on absolute path, trying relative..." + file_name);
+        m_h5_obj=H5Fcreate(file_name.c_str(), H5F_ACC_TRUNC, H5P_DEFAULT, h5_fapl);
+        if ( m_h5_obj >= 0 ) {
+          Verbose::out(1, "H5Fcreate ok for relative path: " + file_name);
+        }
+      }    
+      FILE5_CHECKID(m_h5_obj,"could not replace "+FS_QUOTE_PATH(file_name));
+      m_readonly=false;
     }
     //
-    int h5_open_flags;
-    if ((flags&affx::FILE5_RO)==affx::FILE5_RO) {
-      h5_open_flags=H5F_ACC_RDONLY;
-      m_readonly=true;
-    }
-    else {
-      h5_open_flags=H5F_ACC_RDWR;
-      m_readonly=false;
+    else if (((flags&FILE5_OPEN)==FILE5_OPEN)&&(isHdf5file(m_file_name)==1)) {
+      // printf("### file5: file open: '%s'\n",m_file_name.c_str());
+      // check to see if it exists
+      if (!Fs::isReadable(tmp_unc_path)) {
+        FILE5_ABORT("File does not exist or is not readable: "+FS_QUOTE_PATH(tmp_unc_path));
+      }
+      //
+      int h5_open_flags;
+      if ((flags&affx::FILE5_RO)==affx::FILE5_RO) {
+        h5_open_flags=H5F_ACC_RDONLY;
+        m_readonly=true;
+      }
+      else {
+        h5_open_flags=H5F_ACC_RDWR;
+        m_readonly=false;
+      }
+      m_h5_obj=H5Fopen(tmp_unc_path.c_str(),h5_open_flags,h5_fapl);
+      FILE5_CHECKID(m_h5_obj,"could not open: "+FS_QUOTE_PATH(tmp_unc_path));
     }
-    m_h5_obj=H5Fopen(tmp_unc_path.c_str(),h5_open_flags,H5P_DEFAULT);
-    FILE5_CHECKID(m_h5_obj,"could not open: "+FS_QUOTE_PATH(tmp_unc_path));
-  }
-  else if ((flags&FILE5_CREATE)==FILE5_CREATE) {
+    else if ((flags&FILE5_CREATE)==FILE5_CREATE) {
 #ifdef FILE5_DEBUG_PRINT
-    printf("### file5: file create: '%s'\n",tmp_unc_path.c_str());
+      printf("### file5: file create: '%s'\n",tmp_unc_path.c_str());
 #endif
-    m_h5_obj=H5Fcreate(tmp_unc_path.c_str(), H5F_ACC_EXCL, H5P_DEFAULT, H5P_DEFAULT);
-    FILE5_CHECKID(m_h5_obj,"could not create: "+FS_QUOTE_PATH(tmp_unc_path));
-    //
-    m_readonly=false;
-  }
-  else if ((flags&FILE5_OPEN)==FILE5_OPEN) {
-    printf("### file5: file open: unable to open: '%s'\n",tmp_unc_path.c_str());
-    return affx::FILE5_ERR;
+      m_h5_obj=H5Fcreate(tmp_unc_path.c_str(), H5F_ACC_EXCL, H5P_DEFAULT, h5_fapl);
+      FILE5_CHECKID(m_h5_obj,"could not create: "+FS_QUOTE_PATH(tmp_unc_path));
+      //
+      m_readonly=false;
+    }
+    else if ((flags&FILE5_OPEN)==FILE5_OPEN) {
+      printf("### file5: file open: unable to open: '%s'\n",tmp_unc_path.c_str());
+      H5Pclose(h5_fapl);
+      releaseThreadLock();
+      return affx::FILE5_ERR;
+    }
+    else {
+      FILE5_ABORT("Bad set of flags passed to File5_File::open()");
+    }
   }
-  else {
-    FILE5_ABORT("Bad set of flags passed to File5_File::open()");
+  catch (...) {
+    if (h5_fapl>=0) {
+      H5Pclose(h5_fapl);
+    }
+    releaseThreadLock();
+    throw;
   }
+  H5Pclose(h5_fapl);
 
   // we dont bump the refcnt, we loop back the parent to ourselves
   setParent(this);
@@ -230,12 +270,23 @@ affx::File5_File::close()
   //
   if (tmp_h5_obj!=-1) {
     m_h5_status=H5Fclose(tmp_h5_obj);
+    releaseThreadLock();
     FILE5_CHECKRV(m_h5_status,"H5Fclose failed.");
   }
+  releaseThreadLock();
   //
   return affx::FILE5_OK;
 }
 
+void
+affx::File5_File::releaseThreadLock()
+{
+  if (m_holds_thread_lock) {
+    m_holds_thread_lock=false;
+    File5_File_threadLock.unlock();
+  }
+}
+
 affx::File5_return_t
 affx::File5_File::flush()
 {
@@ -248,6 +299,196 @@ affx::File5_File::flush()
   return affx::FILE5_OK;
 }
 
+//////////
+
+// rechunk copies the data in slabs of about this size.
+#define FILE5_RECHUNK_SLAB_BYTES (64*1024*1024)
+
+static herr_t file5_rechunk_name(hid_t group,const char* name,void* op_data)
+{
+  ((std::vector<std::string>*)op_data)->push_back(name);
+  return 0;
+}
+
+static bool file5_rechunk_is_vlen(hid_t dtype)
+{
+  return ((H5Tdetect_class(dtype,H5T_VLEN)>0)||(H5Tis_variable_str(dtype)>0));
+}
+
+static void file5_rechunk_attribs(hid_t src_obj,hid_t dst_obj)
+{
+  int attrib_cnt=H5Aget_num_attrs(src_obj);
+  for (int i=0;i<attrib_cnt;i++) {
+    hid_t src_attrib=H5Aopen_idx(src_obj,i);
+    FILE5_CHECKID(src_attrib,"H5Aopen_idx");
+    char name_buf[1024];
+    H5Aget_name(src_attrib,sizeof(name_buf),name_buf);
+    hid_t dtype=H5Aget_type(src_attrib);
+    hid_t dspace=H5Aget_space(src_attrib);
+    std::vector<char> buf(H5Sget_simple_extent_npoints(dspace)*H5Tget_size(dtype)+1);
+    FILE5_CHECKRV(H5Aread(src_attrib,dtype,&buf[0]),"H5Aread");
+    hid_t dst_attrib=H5Acreate(dst_obj,name_buf,dtype,dspace,H5P_DEFAULT);
+    FILE5_CHECKID(dst_attrib,"H5Acreate");
+    FILE5_CHECKRV(H5Awrite(dst_attrib,dtype,&buf[0]),"H5Awrite");
+    if (file5_rechunk_is_vlen(dtype)) {
+      H5Dvlen_reclaim(dtype,dspace,H5P_DEFAULT,&buf[0]);
+    }
+    H5Aclose(dst_attrib);
+    H5Sclose(dspace);
+    H5Tclose(dtype);
+    H5Aclose(src_attrib);
+  }
+}
+
+static void file5_rechunk_dataset(hid_t src_group,hid_t dst_group,const std::string& name,affx::File5_hint_t hint)
+{
+  hid_t src_dset=H5Dopen(src_group,name.c_str());
+  FILE5_CHECKID(src_dset,"H5Dopen: "+name);
+  hid_t dtype=H5Dget_type(src_dset);
+  hid_t src_dspace=H5Dget_space(src_dset);
+  int rank=H5Sget_simple_extent_ndims(src_dspace);
+  std::vector<hsize_t> dims(std::max(rank,1),1);
+  std::vector<hsize_t> dims_max(std::max(rank,1),1);
+  if (rank>0) {
+    H5Sget_simple_extent_dims(src_dspace,&dims[0],&dims_max[0]);
+  }
+  bool is_vlen=file5_rechunk_is_vlen(dtype);
+
+  // the new layout.
+  hid_t src_cparms=H5Dget_create_plist(src_dset);
+  hid_t dst_cparms;
+  std::vector<hsize_t> chunk_dims;
+  if ((hint==affx::FILE5_HINT_DEFAULT)||(rank<1)||(H5Pget_layout(src_cparms)!=H5D_CHUNKED)) {
+    dst_cparms=H5Pcopy(src_cparms);
+  }
+  else {
+    dst_cparms=H5Pcreate(H5P_DATASET_CREATE);
+    affx::file5_hint_chunk_dims(hint,H5Tget_size(dtype),dims,chunk_dims);
+    for (int d=0;d<rank;d++) {
+      if ((dims_max[d]!=H5S_UNLIMITED)&&(chunk_dims[d]>dims_max[d])) {
+        chunk_dims[d]=std::max((hsize_t)1,dims_max[d]);
+      }
+    }
+    FILE5_CHECKRV(H5Pset_chunk(dst_cparms,rank,&chunk_dims[0]),"H5Pset_chunk");
+    affx::file5_hint_set_filters(hint,dst_cparms,-1,(!is_vlen)&&(H5Tget_class(dtype)!=H5T_STRING));
+    // keep the crc checks.
+    for (int f=0;f<H5Pget_nfilters(src_cparms);f++) {
+      unsigned int flags;
+      size_t cd_nelmts=0;
+      if (H5Pget_filter(src_cparms,f,&flags,&cd_nelmts,NULL,0,NULL)==H5Z_FILTER_FLETCHER32) {
+        FILE5_CHECKRV(H5Pset_fletcher32(dst_cparms),"H5Pset_fletcher32");
+      }
+    }
+  }
+  hid_t dst_dset=H5Dcreate(dst_group,name.c_str(),dtype,src_dspace,dst_cparms);
+  FILE5_CHECKID(dst_dset,"H5Dcreate: "+name);
+
+  // copy the data, in slabs of whole chunk rows.
+  if (rank==0) {
+    std::vector<char> buf(H5Tget_size(dtype));
+    FILE5_CHECKRV(H5Dread(src_dset,dtype,H5S_ALL,H5S_ALL,H5P_DEFAULT,&buf[0]),"H5Dread");
+    FILE5_CHECKRV(H5Dwrite(dst_dset,dtype,H5S_ALL,H5S_ALL,H5P_DEFAULT,&buf[0]),"H5Dwrite");
+    if (is_vlen) {
+      H5Dvlen_reclaim(dtype,src_dspace,H5P_DEFAULT,&buf[0]);
+    }
+  }
+  else if (H5Sget_simple_extent_npoints(src_dspace)>0) {
+    size_t row_bytes=H5Tget_size(dtype);
+    for (int d=1;d<rank;d++) {
+      row_bytes*=dims[d];
+    }
+    hsize_t slab_rows=std::max((size_t)1,FILE5_RECHUNK_SLAB_BYTES/row_bytes);
+    if (!chunk_dims.empty()&&(slab_rows>chunk_dims[0])) {
+      slab_rows-=slab_rows%chunk_dims[0];
+    }
+    slab_rows=std::min(slab_rows,dims[0]);
+    std::vector<char> buf(slab_rows*row_bytes);
+    std::vector<hsize_t> offset(rank,0);
+    std::vector<hsize_t> count(dims);
+    hid_t dst_dspace=H5Dget_space(dst_dset);
+    for (hsize_t row=0;row<dims[0];row+=slab_rows) {
+      offset[0]=row;
+      count[0]=std::min(slab_rows,dims[0]-row);
+      hid_t m_dspace=H5Screate_simple(rank,&count[0],NULL);
+      H5Sselect_hyperslab(src_dspace,H5S_SELECT_SET,&offset[0],NULL,&count[0],NULL);
+      H5Sselect_hyperslab(dst_dspace,H5S_SELECT_SET,&offset[0],NULL,&count[0],NULL);
+      FILE5_CHECKRV(H5Dread(src_dset,dtype,m_dspace,src_dspace,H5P_DEFAULT,&buf[0]),"H5Dread: "+name);
+      FILE5_CHECKRV(H5Dwrite(dst_dset,dtype,m_dspace,dst_dspace,H5P_DEFAULT,&buf[0]),"H5Dwrite: "+name);
+      if (is_vlen) {
+        H5Dvlen_reclaim(dtype,m_dspace,H5P_DEFAULT,&buf[0]);
+      }
+      H5Sclose(m_dspace);
+    }
+    H5Sclose(dst_dspace);
+  }
+  file5_rechunk_attribs(src_dset,dst_dset);
+
+  //
+  H5Dclose(dst_dset);
+  H5Pclose(dst_cparms);
+  H5Pclose(src_cparms);
+  H5Sclose(src_dspace);
+  H5Tclose(dtype);
+  H5Dclose(src_dset);
+}
+
+static void file5_rechunk_group(hid_t src_group,hid_t dst_group,affx::File5_hint_t hint)
+{
+  file5_rechunk_attribs(src_group,dst_group);
+  // get the names first, so we dont throw through H5Giterate.
+  std::vector<std::string> names;
+  FILE5_CHECKRV(H5Giterate(src_group,".",NULL,file5_rechunk_name,&names),"H5Giterate");
+  for (size_t i=0;i<names.size();i++) {
+    H5G_stat_t statbuf;
+    FILE5_CHECKRV(H5Gget_objinfo(src_group,names[i].c_str(),0,&statbuf),"H5Gget_objinfo");
+    if (statbuf.type==H5G_GROUP) {
+      hid_t src_sub=H5Gopen(src_group,names[i].c_str());
+      FILE5_CHECKID(src_sub,"H5Gopen: "+names[i]);
+      hid_t dst_sub=H5Gcreate(dst_group,names[i].c_str(),0);
+      FILE5_CHECKID(dst_sub,"H5Gcreate: "+names[i]);
+      file5_rechunk_group(src_sub,dst_sub,hint);
+      H5Gclose(dst_sub);
+      H5Gclose(src_sub);
+    }
+    else if (statbuf.type==H5G_DATASET) {
+      file5_rechunk_dataset(src_group,dst_group,names[i],hint);
+    }
+    else {
+      Verbose::out(1,"File5_File::rechunk: skipping '"+names[i]+"', which is not a group or dataset.");
+    }
+  }
+}
+
+void affx::File5_File::rechunk(const std::string& file_in,
+                               const std::string& file_out,
+                               affx::File5_hint_t hint)
+{
+  if (hint==affx::FILE5_HINT_ERR) {
+    FILE5_ABORT("File5_File::rechunk: bad hint.");
+  }
+  if (Fs::convertToUncPath(file_in)==Fs::convertToUncPath(file_out)) {
+    FILE5_ABORT("File5_File::rechunk: can not rechunk "+FS_QUOTE_PATH(file_in)+" in place.");
+  }
+  affx::File5_File file5_in;
+  if (file5_in.open(file_in,affx::FILE5_OPEN_RO)!=affx::FILE5_OK) {
+    FILE5_ABORT("File5_File::rechunk: could not open "+FS_QUOTE_PATH(file_in));
+  }
+  affx::File5_File file5_out;
+  file5_out.setOptHint(hint);
+  file5_out.open(file_out,affx::FILE5_REPLACE);
+  //
+  hid_t src_root=H5Gopen(file5_in.m_h5_obj,"/");
+  FILE5_CHECKID(src_root,"H5Gopen");
+  hid_t dst_root=H5Gopen(file5_out.m_h5_obj,"/");
+  FILE5_CHECKID(dst_root,"H5Gopen");
+  file5_rechunk_group(src_root,dst_root,hint);
+  H5Gclose(dst_root);
+  H5Gclose(src_root);
+  //
+  file5_out.close();
+  file5_in.close();
+}
+
 // I think this is a better signature. - jhg
 // bool affx::File5_File::equivalent(
 // const std::string& strFileName1,
@@ -63,6 +63,19 @@ public:
 
   static bool isHdf5file(const std::string& file_name);
 
+  /// Copy a file, giving each chunked dataset the chunk shape and
+  /// filters of hint. Groups, attributes and crc checks are kept.
+  /// With FILE5_HINT_DEFAULT it is a plain copy.
+  static void rechunk(const std::string& file_in,
+                      const std::string& file_out,
+                      affx::File5_hint_t hint);
+
+  /// The hdf5 library we build is not thread safe. When this is on,
+  /// open() takes a process wide lock which close() gives back, so
+  /// threads take turns using hdf5 files. A thread must not hold a
+  /// file open while it waits on another thread which might open one.
+  static void setThreadLock(bool on);
+
   static bool equivalent(	const std::string& strFileName1, 
                                 const std::string& strFileName2, 
                                 const std::string& strGroupName, 
@@ -73,6 +86,10 @@ public:
                                 bool bAllowNegation=false,
                                 bool flagNaNNumDiff=false);
 
+private:
+  void releaseThreadLock();
+  /// open() took the thread lock.
+  bool m_holds_thread_lock;
 };
 
 #endif // _FILE5_FILE_H_
@@ -87,7 +87,27 @@ affx::File5_Matrix::open(const std::string& name,
   FILE5_ASSERT(m_rank>0);
 
   if (getParent()->name_exists(name)==1) {
-    FILE5_ABORT(": name exists: '"+name+"'");
+    if ((flags&affx::FILE5_OPEN)!=affx::FILE5_OPEN) {
+      FILE5_ABORT(": name exists: '"+name+"'");
+    }
+    // open the one there; it says what its dims are.
+    m_h5_obj=H5Dopen(h5_parent_id(),m_name.c_str());
+    FILE5_CHECKID(m_h5_obj,"H5Dopen");
+    m_h5_dspace=H5Dget_space(m_h5_obj);
+    FILE5_CHECKID(m_h5_dspace,"H5Dget_space");
+    m_rank=H5Sget_simple_extent_ndims(m_h5_dspace);
+    FILE5_ASSERT(m_rank>0);
+    m_dims.resize(m_rank);
+    H5Sget_simple_extent_dims(m_h5_dspace,&m_dims[0],NULL);
+    hid_t tmp_dtype=H5Dget_type(m_h5_obj);
+    m_h5_dtype=affx::as_h5t_native_type(tmp_dtype);
+    H5Tclose(tmp_dtype);
+    m_dtype=affx::as_file5_dtype(m_h5_dtype);
+    if (m_dtype!=dtype) {
+      FILE5_ABORT("Data type of the matrix does not match the requested datatype to open.");
+    }
+    m_state=affx::FILE5_STATE_OPEN;
+    return 0;
   }
 
   //
@@ -96,10 +116,18 @@ affx::File5_Matrix::open(const std::string& name,
   //
   hid_t h5_cparms;
   std::vector<hsize_t> chunk_dims;
-  chunk_dims.resize(m_rank,100);
+  affx::File5_hint_t hint=getOptHint();
+  if (hint==affx::FILE5_HINT_DEFAULT) {
+    chunk_dims.resize(m_rank,100);
+  }
+  else {
+    affx::file5_hint_chunk_dims(hint,H5Tget_size(m_h5_dtype),m_dims,chunk_dims);
+  }
   h5_cparms=H5Pcreate(H5P_DATASET_CREATE);
   // chunk the data
   m_h5_status=H5Pset_chunk(h5_cparms,m_rank,&chunk_dims[0]);
+  // compress it?
+  affx::file5_hint_set_filters(hint,h5_cparms,m_opt_compress,true);
   // turn on crc checks.
   if (m_opt_crc==1) {
     m_h5_status=H5Pset_fletcher32(h5_cparms);
@@ -179,6 +207,52 @@ affx::File5_Matrix::set_void(const std::vector<int>& dims,void* val_ptr)
   return 0;
 }
 
+int
+affx::File5_Matrix::set_block_void(const std::vector<int>& start,const std::vector<int>& count,const void* vals)
+{
+  FILE5_ASSERT(((int)start.size()==m_rank)&&((int)count.size()==m_rank));
+  std::vector<hsize_t> f_offset;
+  std::vector<hsize_t> f_count;
+  affx::file5_dims_hsize_copy(f_offset,start);
+  affx::file5_dims_hsize_copy(f_count,count);
+  // the memory dspace is just the block.
+  hid_t m_dspace=H5Screate_simple(m_rank,&f_count[0],NULL);
+  hid_t f_dspace=H5Dget_space(m_h5_obj);
+  H5Sselect_hyperslab(f_dspace,H5S_SELECT_SET,&f_offset[0],NULL,&f_count[0],NULL);
+  //
+  m_h5_status=H5Dwrite(m_h5_obj,m_h5_dtype,m_dspace,f_dspace,H5P_DEFAULT,vals);
+  FILE5_CHECKRV(m_h5_status,"H5Dwrite");
+  //
+  H5Sclose(m_dspace);
+  H5Sclose(f_dspace);
+  //
+  return 0;
+}
+
+int
+affx::File5_Matrix::get_block_void(const std::vector<int>& start,const std::vector<int>& count,void* vals)
+{
+  FILE5_ASSERT(((int)start.size()==m_rank)&&((int)count.size()==m_rank));
+  std::vector<hsize_t> f_offset;
+  std::vector<hsize_t> f_count;
+  affx::file5_dims_hsize_copy(f_offset,start);
+  affx::file5_dims_hsize_copy(f_count,count);
+  //
+  hid_t m_dspace=H5Screate_simple(m_rank,&f_count[0],NULL);
+  hid_t f_dspace=H5Dget_space(m_h5_obj);
+  H5Sselect_hyperslab(f_dspace,H5S_SELECT_SET,&f_offset[0],NULL,&f_count[0],NULL);
+  //
+  m_h5_status=H5Dread(m_h5_obj,m_h5_dtype,m_dspace,f_dspace,H5P_DEFAULT,vals);
+  FILE5_CHECKRV(m_h5_status,"H5Dread");
+  //
+  H5Sclose(m_dspace);
+  H5Sclose(f_dspace);
+  //
+  return 0;
+}
+
+//////////
+
 int
 affx::File5_Matrix::set(const std::vector<int>& dims,int val)
 {
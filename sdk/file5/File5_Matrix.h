@@ -64,6 +64,11 @@ public:
   //
   int resize(const std::vector<int>& dims);
 
+  // a block of values; start and count have one entry for each dim.
+  // the values are in row major order.
+  int set_block_void(const std::vector<int>& start,const std::vector<int>& count,const void* vals);
+  int get_block_void(const std::vector<int>& start,const std::vector<int>& count,void* vals);
+
   //
   int set_void(const std::vector<int>&dims,void* val);
   //
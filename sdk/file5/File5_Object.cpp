@@ -93,6 +93,7 @@ affx::File5_Object::init()
   m_opt_chunksize=-1; // 
   m_opt_compress=-1; // our default
   m_opt_crc=1; // on
+  m_opt_hint=affx::FILE5_HINT_DEFAULT;
   //
   m_kind=FILE5_KIND_OBJECT;
   m_kind_char='O';
@@ -678,6 +679,31 @@ void affx::File5_Object::setOptCrc(int state)
   m_opt_crc=state;
 }
 
+/// @brief     Say how the objects created by (or under) this one will be read.
+///            Set it before they are created; a file takes its chunk
+///            cache from it when opened.
+void affx::File5_Object::setOptHint(affx::File5_hint_t hint)
+{
+  if (hint==affx::FILE5_HINT_ERR) {
+    FILE5_ABORT("setOptHint: bad hint.");
+  }
+  m_opt_hint=hint;
+}
+
+/// @brief     The hint set on this object, or else the nearest one set above it.
+affx::File5_hint_t affx::File5_Object::getOptHint()
+{
+  if (m_opt_hint!=affx::FILE5_HINT_DEFAULT) {
+    return m_opt_hint;
+  }
+  affx::File5_Object* parent=getParent();
+  // a file is its own parent.
+  if ((parent!=NULL)&&(parent!=this)) {
+    return parent->getOptHint();
+  }
+  return affx::FILE5_HINT_DEFAULT;
+}
+
 
 #ifdef FILE5_DEBUG_USAGE
 
@@ -85,6 +85,8 @@ public:
   int m_opt_compress;
   int m_opt_chunksize;
   int m_opt_crc;
+  // how what is created under us will be read.
+  affx::File5_hint_t m_opt_hint;
 
   //
   File5_Object();
@@ -107,6 +109,8 @@ public:
   void setOptChunkSize(int size);
   void setOptCompress(int level);
   void setOptCrc(int state);
+  void setOptHint(affx::File5_hint_t hint);
+  affx::File5_hint_t getOptHint();
 
   //
   void setParent(affx::File5_Group* parent);
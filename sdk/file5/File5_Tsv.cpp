@@ -746,6 +746,36 @@ TSV_SET_FUNC(string,const std::string&);
 
 /////
 
+#define TSV_BULK_FUNC(TYPE,DTYPE)                                       \
+  int affx::File5_Tsv::readColumn(int clvl,int cidx,size_t start,size_t cnt,TYPE* vals) \
+  {                                                                     \
+    affx::File5_TsvColumn* col=getColumnPtr(clvl,cidx);                 \
+    if (col==NULL) {                                                    \
+      return -1;                                                        \
+    }                                                                   \
+    return col->read_array_as(start,cnt,vals,DTYPE);                    \
+  }                                                                     \
+  int affx::File5_Tsv::appendColumn(int clvl,int cidx,size_t cnt,const TYPE* vals) \
+  {                                                                     \
+    affx::File5_TsvColumn* col=getColumnPtr(clvl,cidx);                 \
+    if (col==NULL) {                                                    \
+      return -1;                                                        \
+    }                                                                   \
+    if (m_line_clvl!=NULL) {                                            \
+      FILE5_ABORT("File5_Tsv::appendColumn: cant append to a tsv with line indexes."); \
+    }                                                                   \
+    return col->push_back_array_as(cnt,vals,DTYPE);                     \
+  }
+
+TSV_BULK_FUNC(char,affx::FILE5_DTYPE_CHAR);
+TSV_BULK_FUNC(int,affx::FILE5_DTYPE_INT);
+TSV_BULK_FUNC(float,affx::FILE5_DTYPE_FLOAT);
+TSV_BULK_FUNC(double,affx::FILE5_DTYPE_DOUBLE);
+
+#undef TSV_BULK_FUNC
+
+/////
+
 int affx::File5_Tsv::flush()
 {
   if (m_state!=affx::FILE5_STATE_OPEN) {
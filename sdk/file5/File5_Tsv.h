@@ -238,6 +238,21 @@ public:
   int set_d(int clvl,const std::string& cidx,double val);
   int set_string(int clvl,const std::string& cidx,const std::string& val);
 
+  // Bulk column IO: a run of rows of one column in a single hyperslab
+  // read or write. Rows are indexes into the columns of the level, which
+  // are the line numbers of a single level tsv. Values are converted to
+  // and from the column type. Not for string columns.
+  int readColumn(int clvl,int cidx,size_t start,size_t cnt,char* vals);
+  int readColumn(int clvl,int cidx,size_t start,size_t cnt,int* vals);
+  int readColumn(int clvl,int cidx,size_t start,size_t cnt,float* vals);
+  int readColumn(int clvl,int cidx,size_t start,size_t cnt,double* vals);
+  // Append the values to the end of the column. Fill every column of the
+  // level to the same length, as writeLevel() would.
+  int appendColumn(int clvl,int cidx,size_t cnt,const char* vals);
+  int appendColumn(int clvl,int cidx,size_t cnt,const int* vals);
+  int appendColumn(int clvl,int cidx,size_t cnt,const float* vals);
+  int appendColumn(int clvl,int cidx,size_t cnt,const double* vals);
+
   // @todo make a function that copies from one column to another
   // When defining a string must specify the maximum possible string size or -1 for unlimited string length
   int defineColumn(const int clvl,
@@ -382,6 +382,11 @@ void affx::File5_Vector::buffer_seek(size_t idx)
 
   // set the start
   m_buf_start_idx=idx;
+  // when reading data which is in the file, start the buffer on a
+  // chunk boundary, so each fill of a chunk sized buffer is one chunk.
+  if ((0<m_opt_chunksize)&&(m_opt_chunksize<=m_buf_max_cnt)&&(idx<m_file_end_idx)) {
+    m_buf_start_idx=idx-(idx%m_opt_chunksize);
+  }
   // now set where we think the end should be.
   m_buf_end_idx=m_buf_start_idx+m_buf_max_cnt;
   // trim the end of the buffer to the vector...
@@ -394,12 +399,12 @@ void affx::File5_Vector::buffer_seek(size_t idx)
   //}
   // set the count.
   int cnt=m_buf_end_idx-m_buf_start_idx;
-  if (idx+cnt>m_file_end_idx) {
-    cnt=m_file_end_idx-idx;
+  if (m_buf_start_idx+cnt>m_file_end_idx) {
+    cnt=m_file_end_idx-m_buf_start_idx;
   }
   //
   if (cnt>0) {
-    read_array_io(idx,cnt,m_buf_ptr);
+    read_array_io(m_buf_start_idx,cnt,m_buf_ptr);
   }
   //
   // buffer_print(); // dbg
@@ -575,6 +580,13 @@ affx::File5_Vector::open(const std::string& name,affx::File5_dtype_t dtype,int f
         m_h5_dtype=as_hdf5_dtype(m_dtype);
         m_h5_dtype_tofree=-1;
         //
+        if ((m_opt_chunksize==-1)&&(getOptHint()!=affx::FILE5_HINT_DEFAULT)) {
+          // the vector starts empty and grows.
+          std::vector<hsize_t> hint_dims(1,0);
+          std::vector<hsize_t> hint_chunk_dims;
+          affx::file5_hint_chunk_dims(getOptHint(),H5Tget_size(m_h5_dtype),hint_dims,hint_chunk_dims);
+          m_opt_chunksize=hint_chunk_dims[0];
+        }
         if (m_opt_chunksize==-1) {
           m_opt_chunksize=FILE5_CHUNKSIZE;
         }
@@ -587,10 +599,7 @@ affx::File5_Vector::open(const std::string& name,affx::File5_dtype_t dtype,int f
         FILE5_CHECKRV(m_h5_status,"H5Pset_chunk")
       }
       // compress it?
-      if (m_opt_compress>=0) {
-        m_h5_status=H5Pset_deflate(h5_cparms,m_opt_compress);
-        FILE5_CHECKRV(m_h5_status,"H5Pset_deflate");
-      }
+      affx::file5_hint_set_filters(getOptHint(),h5_cparms,m_opt_compress,(m_dtype!=FILE5_DTYPE_STRING));
       // turn on crc checks?
       if (m_opt_crc==1) {
         m_h5_status=H5Pset_fletcher32(h5_cparms);
@@ -740,6 +749,13 @@ affx::File5_Vector::open(const std::string& name,affx::File5_dtype_t dtype,int f
 /// @param     ptr       where to put the data
 /// @return    number of items read
 int affx::File5_Vector::read_array_io(size_t idx,size_t cnt,void* ptr)
+{
+  return read_array_io(idx,cnt,ptr,m_h5_dtype);
+}
+
+/// @brief     As above, converting to the memory type.
+/// @param     mem_dtype the HDF5 type of the data at ptr
+int affx::File5_Vector::read_array_io(size_t idx,size_t cnt,void* ptr,hid_t mem_dtype)
 {
   //printf("read_array(%lu,%lu,%p)\n",idx,cnt,ptr); // dbg
 
@@ -782,7 +798,7 @@ int affx::File5_Vector::read_array_io(size_t idx,size_t cnt,void* ptr)
 
   // affx::dump_h5_dset(m_h5_obj); // dbg
   // Do the actual IO
-  m_h5_status=H5Dread(m_h5_obj,m_h5_dtype,m_dspace,f_dspace,H5P_DEFAULT,ptr);
+  m_h5_status=H5Dread(m_h5_obj,mem_dtype,m_dspace,f_dspace,H5P_DEFAULT,ptr);
   if (m_h5_status!=0) {
     printf("read_array_io: failed (idx=%d,cnt=%d,vec_end=%d,file_end=%d)",
            (int)idx,(int)cnt,(int)m_vec_end_idx,(int)m_file_end_idx);
@@ -803,6 +819,14 @@ int affx::File5_Vector::read_array_io(size_t idx,size_t cnt,void* ptr)
 /// @return    number of items written
 int
 affx::File5_Vector::write_array_io(size_t idx,size_t cnt,const void* ptr)
+{
+  return write_array_io(idx,cnt,ptr,m_h5_dtype);
+}
+
+/// @brief     As above, converting from the memory type.
+/// @param     mem_dtype the HDF5 type of the data at ptr
+int
+affx::File5_Vector::write_array_io(size_t idx,size_t cnt,const void* ptr,hid_t mem_dtype)
 {
   if (cnt==0) {
     return 0;
@@ -829,7 +853,7 @@ affx::File5_Vector::write_array_io(size_t idx,size_t cnt,const void* ptr)
   m_h5_status=H5Sselect_hyperslab(f_dspace,H5S_SELECT_SET,f_start,NULL,f_count,NULL);
   FILE5_CHECKRV(m_h5_status,"H5Sselect_hyperslab");
   //
-  m_h5_status=H5Dwrite(m_h5_obj,m_h5_dtype,m_dspace,f_dspace,H5P_DEFAULT,ptr);
+  m_h5_status=H5Dwrite(m_h5_obj,mem_dtype,m_dspace,f_dspace,H5P_DEFAULT,ptr);
   FILE5_CHECKRV(m_h5_status,"H5Dwrite");
   //
   H5Sclose(m_dspace);
@@ -853,6 +877,9 @@ int affx::File5_Vector::read_array(size_t idx,size_t cnt,void* ptr)
   // as we should see its data during our read.
   flush();
   buffer_clear();
+  // the cleared buffer holds nothing now, leave it empty at the end.
+  m_buf_start_idx=m_vec_end_idx;
+  m_buf_end_idx=m_vec_end_idx;
   // now do our IO
   return read_array_io(idx,cnt,ptr);
 }
@@ -880,6 +907,10 @@ affx::File5_Vector::write_array(size_t idx,size_t cnt,const void* ptr)
   if (write_end_idx>m_vec_fill_idx) {
     m_vec_fill_idx=write_end_idx;
   }
+  // the buffer may hold the old values, empty it at the end.
+  buffer_clear();
+  m_buf_start_idx=m_vec_end_idx;
+  m_buf_end_idx=m_vec_end_idx;
   //
   return rv;
 }
@@ -899,6 +930,95 @@ affx::File5_Vector::write_scalar(size_t idx,void* ptr)
 
 /////
 
+/// @brief     Read a run of values in one hyperslab read,
+///            converting them to the type of the buffer.
+/// @param     idx       idx to start the read from
+/// @param     cnt       number of items to read
+/// @param     ptr       where to put the data
+/// @param     ptr_dtype the type of the data at ptr
+/// @return    number of items read (less than cnt at the end of the vector)
+int affx::File5_Vector::read_array_as(size_t idx,size_t cnt,void* ptr,affx::File5_dtype_t ptr_dtype)
+{
+  FILE5_ASSERT(ptr!=NULL);
+  if ((m_dtype==affx::FILE5_DTYPE_STRING)||(ptr_dtype==affx::FILE5_DTYPE_STRING)) {
+    FILE5_ABORT("File5_Vector::read_array_as: not for strings.");
+  }
+  // clamp to the values in the vector.
+  if (idx>=m_vec_fill_idx) {
+    return 0;
+  }
+  if (idx+cnt>m_vec_fill_idx) {
+    cnt=m_vec_fill_idx-idx;
+  }
+  // the buffered values have to be in the file for us to see them.
+  // the buffer itself is still good, so leave it be.
+  flush();
+  return read_array_io(idx,cnt,ptr,affx::as_hdf5_dtype(ptr_dtype));
+}
+
+/// @brief     Write a run of values in one hyperslab write,
+///            converting them from the type of the buffer.
+/// @param     idx       idx to start the write at
+/// @param     cnt       number of items to write
+/// @param     ptr       where to get the data
+/// @param     ptr_dtype the type of the data at ptr
+/// @return    number of items written (==cnt)
+int affx::File5_Vector::write_array_as(size_t idx,size_t cnt,const void* ptr,affx::File5_dtype_t ptr_dtype)
+{
+  FILE5_ASSERT(ptr!=NULL);
+  if ((m_dtype==affx::FILE5_DTYPE_STRING)||(ptr_dtype==affx::FILE5_DTYPE_STRING)) {
+    FILE5_ABORT("File5_Vector::write_array_as: not for strings.");
+  }
+  if (cnt==0) {
+    return 0;
+  }
+  // put out the buffer first, as it may hold older values of this run.
+  flush();
+  int rv=write_array_io(idx,cnt,ptr,affx::as_hdf5_dtype(ptr_dtype));
+  FILE5_ASSERT((size_t)rv==cnt);
+  // move the ends if needed.
+  size_t write_end_idx=idx+cnt;
+  if (write_end_idx>m_vec_end_idx) {
+    m_vec_end_idx=write_end_idx;
+  }
+  if (write_end_idx>m_vec_fill_idx) {
+    m_vec_fill_idx=write_end_idx;
+  }
+  // empty the buffer at the end, ready for push_backs.
+  buffer_zero();
+  m_buf_start_idx=m_vec_end_idx;
+  m_buf_end_idx=m_vec_end_idx;
+  // keep the meta-data up to date.
+  attrib_set(VECTOR_FILL_INDEX,m_vec_fill_idx);
+  m_dirty=0;
+  //
+  return rv;
+}
+
+/// @brief     Append a run of values.
+///            Runs shorter than the buffer, which is a chunk long,
+///            are copied into it so the writes stay chunk sized;
+///            longer runs are written directly.
+/// @param     cnt       number of items to append
+/// @param     ptr       where to get the data
+/// @param     ptr_dtype the type of the data at ptr
+/// @return    number of items written (==cnt)
+int affx::File5_Vector::push_back_array_as(size_t cnt,const void* ptr,affx::File5_dtype_t ptr_dtype)
+{
+  FILE5_ASSERT(ptr!=NULL);
+  if ((ptr_dtype==m_dtype)&&(m_dtype!=affx::FILE5_DTYPE_STRING)&&(cnt<(size_t)m_buf_max_cnt)) {
+    const char* src=(const char*)ptr;
+    for (size_t i=0;i<cnt;i++) {
+      memcpy(buffer_pushback2ptr(),src+i*m_dtype_size,m_dtype_size);
+    }
+    m_dirty=1;
+    return cnt;
+  }
+  return write_array_as(m_vec_fill_idx,cnt,ptr,ptr_dtype);
+}
+
+/////
+
 void affx::File5_Vector::assert_dtype(affx::File5_dtype_t dtype,const std::string& msg)
 {
   if (m_dtype!=dtype) {
@@ -919,7 +1039,7 @@ int affx::File5_Vector::read_vector(size_t idx,std::vector<char>* vec)
 int affx::File5_Vector::write_vector(size_t idx,const std::vector<char>* vec)
 {
   assert_dtype(affx::FILE5_DTYPE_CHAR,"File5_Vector::write_vector<char>");
-  return write_array(idx,vec->size(),&vec[0]);
+  return write_array(idx,vec->size(),&(*vec)[0]);
 }
 // short
 int affx::File5_Vector::read_vector(size_t idx,std::vector<short>* vec)
@@ -932,7 +1052,7 @@ int affx::File5_Vector::read_vector(size_t idx,std::vector<short>* vec)
 int affx::File5_Vector::write_vector(size_t idx,const std::vector<short>* vec)
 {
   assert_dtype(affx::FILE5_DTYPE_SHORT,"File5_Vector::write_vector<short>");
-  return write_array(idx,vec->size(),&vec[0]);
+  return write_array(idx,vec->size(),&(*vec)[0]);
 }
 
 // int
@@ -971,7 +1091,7 @@ int affx::File5_Vector::read_vector(size_t idx,std::vector<double>* vec)
 }
 int affx::File5_Vector::write_vector(size_t idx,const std::vector<double>* vec)
 {
-  assert_dtype(affx::FILE5_DTYPE_INT,"File5_Vector::write_vector<double>");
+  assert_dtype(affx::FILE5_DTYPE_DOUBLE,"File5_Vector::write_vector<double>");
   return write_array(idx,vec->size(),&(*vec)[0]);
 }
 
@@ -131,6 +131,8 @@ public:
   // they bypass the File5 caches.
   int read_array_io( size_t idx,size_t cnt,void* buf);
   int write_array_io(size_t idx,size_t cnt,const void* buf);
+  int read_array_io( size_t idx,size_t cnt,void* buf,hid_t mem_dtype);
+  int write_array_io(size_t idx,size_t cnt,const void* buf,hid_t mem_dtype);
 
   // these methods can be used if you know what you are doing.
   // (IE: you have checked the types and done the allocations.)
@@ -139,6 +141,13 @@ public:
   int read_array( size_t idx,size_t cnt,void* buf);
   int write_array(size_t idx,size_t cnt,const void* buf);
 
+  // Bulk IO: a run of values in one hyperslab read or write.
+  // HDF5 converts between the vector type and buf_dtype.
+  // Numeric vectors only.
+  int read_array_as( size_t idx,size_t cnt,void* buf,affx::File5_dtype_t buf_dtype);
+  int write_array_as(size_t idx,size_t cnt,const void* buf,affx::File5_dtype_t buf_dtype);
+  int push_back_array_as(size_t cnt,const void* buf,affx::File5_dtype_t buf_dtype);
+
   //
   int dump();
   int dump1();
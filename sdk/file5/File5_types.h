@@ -59,6 +59,21 @@ namespace affx {
     FILE5_DTYPE_DOUBLE  ,
   };
 
+  // How a dataset will be read, which picks its chunk shape,
+  // filters and the chunk cache. See file5_hint_chunk_dims().
+  enum File5_hint_t {
+    FILE5_HINT_DEFAULT = 0,
+    FILE5_HINT_ERR,
+    // whole rows in order. (The last dim is the fastest.)
+    FILE5_HINT_ROW_STREAMING,
+    // whole columns in order.
+    FILE5_HINT_COLUMN_STREAMING,
+    // small pieces from anywhere.
+    FILE5_HINT_RANDOM,
+    // written once and rarely read; compressed.
+    FILE5_HINT_ARCHIVE,
+  };
+
   enum File5_flag_t {
     FILE5_REPLACE    = 0x01,
     FILE5_CREATE     = 0x02,
@@ -28,6 +28,8 @@
 //
 #include "file5/File5.h"
 //
+#include <algorithm>
+#include <cmath>
 #include <iostream>
 #include <stdio.h>
 
@@ -393,3 +395,156 @@ affx::File5_dtype_t affx::file5_string_to_dtype(const std::string& str)
   //
   return affx::FILE5_DTYPE_ERR;
 }
+
+//////////
+
+// What each hint picks.
+// chunk_bytes: about how big a chunk is.
+// cache_bytes,cache_slots: the chunk cache for each open dataset.
+//   (HDF5 keeps one per dataset, so these stay small.)
+// compress: the deflate level, -1 for none. Shuffle goes with it.
+struct File5_hint_preset_t {
+  affx::File5_hint_t hint;
+  const char* name;
+  size_t chunk_bytes;
+  size_t cache_bytes;
+  size_t cache_slots;
+  int compress;
+};
+
+static const File5_hint_preset_t file5_hint_presets[]={
+  { affx::FILE5_HINT_ROW_STREAMING,    "row-streaming",     256*1024,   512*1024,  521, -1 },
+  { affx::FILE5_HINT_COLUMN_STREAMING, "column-streaming",  256*1024,   512*1024,  521, -1 },
+  { affx::FILE5_HINT_RANDOM,           "random",             16*1024, 4*1024*1024, 2053, -1 },
+  { affx::FILE5_HINT_ARCHIVE,          "archive",          1024*1024, 2*1024*1024,  521,  6 },
+};
+#define FILE5_HINT_PRESET_CNT (sizeof(file5_hint_presets)/sizeof(file5_hint_presets[0]))
+
+static const File5_hint_preset_t* file5_hint_preset(affx::File5_hint_t hint)
+{
+  for (size_t i=0;i<FILE5_HINT_PRESET_CNT;i++) {
+    if (file5_hint_presets[i].hint==hint) {
+      return &file5_hint_presets[i];
+    }
+  }
+  return NULL;
+}
+
+std::string affx::file5_hint_to_string(affx::File5_hint_t hint)
+{
+  if (hint==affx::FILE5_HINT_DEFAULT) {
+    return "default";
+  }
+  const File5_hint_preset_t* preset=file5_hint_preset(hint);
+  if (preset!=NULL) {
+    return preset->name;
+  }
+  return "unknown";
+}
+
+affx::File5_hint_t affx::file5_string_to_hint(const std::string& str)
+{
+  if (str=="default") {
+    return affx::FILE5_HINT_DEFAULT;
+  }
+  for (size_t i=0;i<FILE5_HINT_PRESET_CNT;i++) {
+    if (str==file5_hint_presets[i].name) {
+      return file5_hint_presets[i].hint;
+    }
+  }
+  //
+  return affx::FILE5_HINT_ERR;
+}
+
+/// @brief     The chunk shape for a dataset which will be read as the hint says.
+///            Streaming chunks hold whole rows (or columns) where they fit;
+///            random chunks are small and about as long on each side.
+/// @param     hint       how it will be read. (Not FILE5_HINT_DEFAULT,
+///                       each kind of object has its own default.)
+/// @param     dtype_size size of an element
+/// @param     dims       size of the dataset, 0 for a dim which will grow
+/// @param     chunk_dims the chunk shape
+void affx::file5_hint_chunk_dims(affx::File5_hint_t hint,
+                                 size_t dtype_size,
+                                 const std::vector<hsize_t>& dims,
+                                 std::vector<hsize_t>& chunk_dims)
+{
+  const File5_hint_preset_t* preset=file5_hint_preset(hint);
+  if (preset==NULL) {
+    FILE5_ABORT("file5_hint_chunk_dims: no chunk shape for hint '"+file5_hint_to_string(hint)+"'.");
+  }
+  FILE5_ASSERT(dtype_size>0);
+  int rank=dims.size();
+  FILE5_ASSERT(rank>0);
+  chunk_dims.resize(rank);
+  hsize_t elem_cnt=std::max((size_t)1,preset->chunk_bytes/dtype_size);
+
+  if (hint==affx::FILE5_HINT_RANDOM) {
+    hsize_t side=(hsize_t)(pow((double)elem_cnt,1.0/rank)+0.000001);
+    side=std::max((hsize_t)1,side);
+    for (int d=0;d<rank;d++) {
+      chunk_dims[d]=side;
+      if ((dims[d]>0)&&(dims[d]<side)) {
+        chunk_dims[d]=dims[d];
+      }
+    }
+    return;
+  }
+
+  // rows are filled from the last dim, columns from the first.
+  for (int i=0;i<rank;i++) {
+    int d=(hint==affx::FILE5_HINT_COLUMN_STREAMING)?i:(rank-1-i);
+    hsize_t len=elem_cnt;
+    if ((dims[d]>0)&&(dims[d]<len)) {
+      len=dims[d];
+    }
+    chunk_dims[d]=len;
+    elem_cnt=std::max((hsize_t)1,elem_cnt/len);
+  }
+}
+
+/// @brief     Add the filters of a hint to a dataset creation property list.
+/// @param     hint       how it will be read
+/// @param     h5_cparms  the property list
+/// @param     compress   the deflate level to use instead of the hint's, when >=0
+/// @param     shuffle_ok false when shuffling would not help. (strings)
+void affx::file5_hint_set_filters(affx::File5_hint_t hint,hid_t h5_cparms,int compress,bool shuffle_ok)
+{
+  const File5_hint_preset_t* preset=file5_hint_preset(hint);
+  if ((compress<0)&&(preset!=NULL)) {
+    compress=preset->compress;
+  }
+  if (compress<0) {
+    return;
+  }
+  herr_t rv;
+  // grouping the bytes of the numbers together helps deflate.
+  if (shuffle_ok&&(preset!=NULL)&&(preset->compress>=0)) {
+    rv=H5Pset_shuffle(h5_cparms);
+    FILE5_CHECKRV(rv,"H5Pset_shuffle");
+  }
+  rv=H5Pset_deflate(h5_cparms,compress);
+  FILE5_CHECKRV(rv,"H5Pset_deflate");
+}
+
+/// @brief     Size the chunk cache of a file access property list for a hint.
+///            The metadata cache is left as it is.
+/// @param     hint       how the datasets will be read
+/// @param     h5_fapl    the property list
+void affx::file5_hint_set_cache(affx::File5_hint_t hint,hid_t h5_fapl)
+{
+  const File5_hint_preset_t* preset=file5_hint_preset(hint);
+  if (preset==NULL) {
+    return;
+  }
+  int mdc_nelmts;
+  size_t rdcc_nelmts;
+  size_t rdcc_nbytes;
+  double rdcc_w0;
+  herr_t rv=H5Pget_cache(h5_fapl,&mdc_nelmts,&rdcc_nelmts,&rdcc_nbytes,&rdcc_w0);
+  FILE5_CHECKRV(rv,"H5Pget_cache");
+  // rdcc_w0 is left alone: at 1.0 the cache never preempts a
+  // partly read chunk and grows without bound.
+  rv=H5Pset_cache(h5_fapl,mdc_nelmts,preset->cache_slots,preset->cache_bytes,rdcc_w0);
+  FILE5_CHECKRV(rv,"H5Pset_cache");
+}
@@ -105,6 +105,16 @@ namespace affx {
   hid_t as_hdf5_dtype(affx::File5_dtype_t file5_dtype);
   hid_t as_h5t_native_type(hid_t dtype);
   
+  //
+  std::string file5_hint_to_string(affx::File5_hint_t hint);
+  affx::File5_hint_t file5_string_to_hint(const std::string& str);
+  void file5_hint_chunk_dims(affx::File5_hint_t hint,
+                             size_t dtype_size,
+                             const std::vector<hsize_t>& dims,
+                             std::vector<hsize_t>& chunk_dims);
+  void file5_hint_set_filters(affx::File5_hint_t hint,hid_t h5_cparms,int compress,bool shuffle_ok);
+  void file5_hint_set_cache(affx::File5_hint_t hint,hid_t h5_fapl);
+
   //
   void dump_h5_dset(hid_t dset_id,std::ostream& ostm=std::cout);
   void dump_h5_dspace(hid_t dspace_id,std::ostream& ostm=std::cout);
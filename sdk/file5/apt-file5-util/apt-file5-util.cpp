@@ -501,6 +501,11 @@ void define_aptfile5util_options(PgOptions* opts)
                  "    apt-file5-util -i test9.tsv5 --internal-name test9 --find-col COLNAME --find-val MATCHVAL\n"
                  "  The column names can be found by converting the file to text format.\n"
                  "\n"
+                 "* To lay out the datasets of a file for how they will be read:\n"
+                 "    apt-file5-util --rechunk --chunk-hint column-streaming -o by-column.a5 data.a5\n"
+                 "  The hints are 'row-streaming', 'column-streaming', 'random' and 'archive',\n"
+                 "  which compresses. Each sets the chunk shape and filters of the datasets.\n"
+                 "\n"
                  "NOTE: '--append' isnt the best name.  It appends the data set to an existing HDF5/A5 file.\n"
                  "      It does the append by REPLACING the dataset in that location.\n"
                  "      If there isnt a dataset by that name, then it really is an append.\n"
@@ -596,6 +601,13 @@ void define_aptfile5util_options(PgOptions* opts)
   opts->defOpt("lc","line-count",PgOpt::BOOL_OPT,
                "Count the lines in a Tsv5 File.",
                "false");
+  //
+  opts->defOpt("","rechunk",PgOpt::BOOL_OPT,
+               "Copy an A5 file, changing the chunks of its datasets to suit --chunk-hint.",
+               "false");
+  opts->defOpt("","chunk-hint",PgOpt::STRING_OPT,
+               "How the data will be read: 'row-streaming', 'column-streaming', 'random', 'archive' or 'default'.",
+               "row-streaming");
 }
 
 int main(int argc, const char* argv[]) {
@@ -715,6 +727,17 @@ int main(int argc, const char* argv[]) {
       printf("%d\n",lineCount);
     }
 
+    else if (opts->getBool("rechunk")) {
+      if ((opts->getArgCount()!=1)||(opts->get("output")=="")) {
+        Err::errAbort("--rechunk needs one input file and an --output file.");
+      }
+      affx::File5_hint_t hint=affx::file5_string_to_hint(opts->get("chunk-hint"));
+      if (hint==affx::FILE5_HINT_ERR) {
+        Err::errAbort("Unknown --chunk-hint: '"+opts->get("chunk-hint")+"'");
+      }
+      affx::File5_File::rechunk(opts->getArg(0),opts->get("output"),hint);
+    }
+
     // no args, print help.
     else {
       opts->usage();
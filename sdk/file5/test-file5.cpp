@@ -28,9 +28,11 @@
 #include "file/TsvFile/TsvFile.h"
 #include "util/PgOptions.h"
 //
+#include <algorithm>
 #include <cassert>
 #include <cstdio>
 #include <cstring>
+#include <ctime>
 #include <iostream>
 #include <map>
 #include <string.h>
@@ -482,6 +484,32 @@ void run_test_vector_3(const std::string& file_name) {
   vec->get(10,&tmp_int);
   FILE5_ASSERT(tmp_int==1100);
   
+  vec->close();
+  delete vec;
+
+  // gets after direct array reads and writes see the values in the file.
+  vec=file5->openVector("vector-buffer",affx::FILE5_DTYPE_INT,affx::FILE5_REPLACE);
+  data.resize(100);
+  for (int i=0;i<100;i++) {
+    data[i]=i;
+  }
+  vec->write_array(0,data.size(),&data[0]);
+  vec->get(95,&tmp_int);
+  FILE5_ASSERT(tmp_int==95);
+  std::vector<int> part(10);
+  vec->read_array(90,part.size(),&part[0]);
+  FILE5_ASSERT(part[0]==90);
+  vec->get(50,&tmp_int);
+  FILE5_ASSERT(tmp_int==50);
+  vec->get(95,&tmp_int);
+  FILE5_ASSERT(tmp_int==95);
+  std::fill(part.begin(),part.end(),-1);
+  vec->write_array(45,part.size(),&part[0]);
+  vec->get(50,&tmp_int);
+  FILE5_ASSERT(tmp_int==-1);
+  vec->get(55,&tmp_int);
+  FILE5_ASSERT(tmp_int==55);
+
   vec->close();
   delete vec;
   file5->close();
@@ -599,6 +627,76 @@ void run_test_tsv_write(const std::string& file_name)
 }
 
 
+void run_test_tsv_bulk(const std::string& file_name)
+{
+  DOT_TITLE("run_test_tsv_bulk",file_name.c_str());
+  DOT_CLEAR();
+
+  int cnt=12345;
+  std::vector<int> ints(cnt);
+  std::vector<float> floats(cnt);
+  for (int i=0;i<cnt;i++) {
+    ints[i]=i*3;
+    floats[i]=i+0.25f;
+  }
+
+  affx::File5_File* file5=new affx::File5_File();
+  file5->open(file_name,affx::FILE5_REPLACE);
+  affx::File5_Tsv* tsv5=file5->openTsv("tsv",affx::FILE5_REPLACE);
+  tsv5->defineColumn(0,0,"int",affx::FILE5_DTYPE_INT);
+  tsv5->defineColumn(0,1,"float",affx::FILE5_DTYPE_FLOAT);
+  // a few rows the old way, then runs short and long of the buffer.
+  for (int i=0;i<10;i++) {
+    tsv5->set_i(0,0,ints[i]);
+    tsv5->set_f(0,1,floats[i]);
+    tsv5->writeLevel(0);
+  }
+  FILE5_ASSERT(tsv5->appendColumn(0,0,90,&ints[10])==90);
+  FILE5_ASSERT(tsv5->appendColumn(0,1,90,&floats[10])==90);
+  FILE5_ASSERT(tsv5->appendColumn(0,0,cnt-100,&ints[100])==cnt-100);
+  FILE5_ASSERT(tsv5->appendColumn(0,1,cnt-100,&floats[100])==cnt-100);
+  FILE5_ASSERT(tsv5->appendColumn(0,5,1,&ints[0])==-1);
+  DOT_PRINT();
+  tsv5->close();
+  delete tsv5;
+
+  //
+  tsv5=file5->openTsv("tsv",affx::FILE5_OPEN);
+  FILE5_ASSERT(tsv5->getLineCount()==cnt);
+  // row by row agrees.
+  int val_i;
+  float val_f;
+  int line=0;
+  while (tsv5->nextLine()==affx::FILE5_OK) {
+    tsv5->get(0,0,&val_i);
+    tsv5->get(0,1,&val_f);
+    FILE5_ASSERT(val_i==ints[line]);
+    FILE5_ASSERT(val_f==floats[line]);
+    line++;
+  }
+  FILE5_ASSERT(line==cnt);
+  DOT_PRINT();
+  // a run across chunks, converted to other types, clamped at the end.
+  std::vector<double> dbls(8000);
+  FILE5_ASSERT(tsv5->readColumn(0,0,3990,8000,&dbls[0])==8000);
+  for (int i=0;i<8000;i++) {
+    FILE5_ASSERT(dbls[i]==ints[3990+i]);
+  }
+  std::vector<float> tail(100);
+  FILE5_ASSERT(tsv5->readColumn(0,1,cnt-40,100,&tail[0])==40);
+  for (int i=0;i<40;i++) {
+    FILE5_ASSERT(tail[i]==floats[cnt-40+i]);
+  }
+  FILE5_ASSERT(tsv5->readColumn(0,1,cnt,10,&tail[0])==0);
+  DOT_PRINT();
+  //
+  tsv5->close();
+  delete tsv5;
+  file5->close();
+  delete file5;
+  DOT_OK();
+}
+
 void run_test_twoleveltsv(const std::string& file_name)
 {
   DOT_TITLE("run_test_twoleveltsv",file_name.c_str());
@@ -747,6 +845,68 @@ void run_test_benchmark_write(const std::string& file_name,int benchmark_cnt)
   delete file5;
 }
 
+/// Time moving a table of an int and a float column row by row
+/// (set_*, writeLevel, nextLine, get) and a column at a time.
+void run_test_benchmark_tsv_bulk(const std::string& file_name,int row_cnt)
+{
+  DOT_TITLE("run_test_benchmark_tsv_bulk",file_name.c_str());
+  std::vector<int> ints(row_cnt);
+  std::vector<float> floats(row_cnt);
+  for (int i=0;i<row_cnt;i++) {
+    ints[i]=i;
+    floats[i]=i*0.5f;
+  }
+  std::vector<int> in_ints(row_cnt);
+  std::vector<float> in_floats(row_cnt);
+
+  affx::File5_File* file5=new affx::File5_File();
+  file5->open(file_name,affx::FILE5_REPLACE);
+
+  for (int bulk=0;bulk<2;bulk++) {
+    affx::File5_Tsv* tsv5=file5->openTsv(bulk?"bulk":"rows",affx::FILE5_REPLACE);
+    tsv5->defineColumn(0,0,"int",affx::FILE5_DTYPE_INT);
+    tsv5->defineColumn(0,1,"float",affx::FILE5_DTYPE_FLOAT);
+    clock_t start=clock();
+    if (bulk) {
+      tsv5->appendColumn(0,0,row_cnt,&ints[0]);
+      tsv5->appendColumn(0,1,row_cnt,&floats[0]);
+    }
+    else {
+      for (int i=0;i<row_cnt;i++) {
+        tsv5->set_i(0,0,ints[i]);
+        tsv5->set_f(0,1,floats[i]);
+        tsv5->writeLevel(0);
+      }
+    }
+    tsv5->close();
+    delete tsv5;
+    double write_sec=(double)(clock()-start)/CLOCKS_PER_SEC;
+
+    tsv5=file5->openTsv(bulk?"bulk":"rows",affx::FILE5_OPEN);
+    start=clock();
+    if (bulk) {
+      tsv5->readColumn(0,0,0,row_cnt,&in_ints[0]);
+      tsv5->readColumn(0,1,0,row_cnt,&in_floats[0]);
+    }
+    else {
+      int line=0;
+      while (tsv5->nextLine()==affx::FILE5_OK) {
+        tsv5->get(0,0,&in_ints[line]);
+        tsv5->get(0,1,&in_floats[line]);
+        line++;
+      }
+    }
+    double read_sec=(double)(clock()-start)/CLOCKS_PER_SEC;
+    tsv5->close();
+    delete tsv5;
+    FILE5_ASSERT((in_ints==ints)&&(in_floats==floats));
+    printf("%-5s: %d rows: write %.3fs read %.3fs\n",bulk?"bulk":"rows",row_cnt,write_sec,read_sec);
+  }
+
+  file5->close();
+  delete file5;
+}
+
 void run_test_vec_strlen_1(const std::string& file_base,int strlen)
 {
   //
@@ -948,6 +1108,208 @@ void run_test_list_names(const std::string& filename)
 
 //////////
 
+// dims in HDF5 order. (file5_dims() takes them fastest first.)
+std::vector<int> test_dims(int d0,int d1)
+{
+  std::vector<int> dims;
+  dims.push_back(d0);
+  dims.push_back(d1);
+  return dims;
+}
+
+// the chunk shape of an open dataset.
+std::vector<hsize_t> test_chunk_dims(hid_t h5_obj,int rank)
+{
+  std::vector<hsize_t> chunk_dims(rank,0);
+  hid_t h5_cparms=H5Dget_create_plist(h5_obj);
+  H5Pget_chunk(h5_cparms,rank,&chunk_dims[0]);
+  H5Pclose(h5_cparms);
+  return chunk_dims;
+}
+
+void run_test_hints(const std::string& file_name)
+{
+  DOT_TITLE("run_test_hints",file_name.c_str());
+  DOT_CLEAR();
+
+  // the names.
+  FILE5_ASSERT(affx::file5_string_to_hint("column-streaming")==affx::FILE5_HINT_COLUMN_STREAMING);
+  FILE5_ASSERT(affx::file5_string_to_hint(affx::file5_hint_to_string(affx::FILE5_HINT_ARCHIVE))==affx::FILE5_HINT_ARCHIVE);
+  FILE5_ASSERT(affx::file5_string_to_hint("default")==affx::FILE5_HINT_DEFAULT);
+  FILE5_ASSERT(affx::file5_string_to_hint("sideways")==affx::FILE5_HINT_ERR);
+
+  // the shapes for 1000x200 floats.
+  std::vector<hsize_t> dims(2);
+  dims[0]=1000;
+  dims[1]=200;
+  std::vector<hsize_t> chunk_dims;
+  affx::file5_hint_chunk_dims(affx::FILE5_HINT_ROW_STREAMING,sizeof(float),dims,chunk_dims);
+  FILE5_ASSERT((chunk_dims[0]==327)&&(chunk_dims[1]==200));
+  affx::file5_hint_chunk_dims(affx::FILE5_HINT_COLUMN_STREAMING,sizeof(float),dims,chunk_dims);
+  FILE5_ASSERT((chunk_dims[0]==1000)&&(chunk_dims[1]==65));
+  affx::file5_hint_chunk_dims(affx::FILE5_HINT_RANDOM,sizeof(float),dims,chunk_dims);
+  FILE5_ASSERT((chunk_dims[0]==64)&&(chunk_dims[1]==64));
+  // a growing vector.
+  dims.resize(1);
+  dims[0]=0;
+  affx::file5_hint_chunk_dims(affx::FILE5_HINT_ARCHIVE,sizeof(double),dims,chunk_dims);
+  FILE5_ASSERT(chunk_dims[0]==131072);
+  DOT_PRINT();
+
+  // objects take the hint of what is above them.
+  affx::File5_File* file5=new affx::File5_File();
+  file5->setOptHint(affx::FILE5_HINT_RANDOM);
+  file5->open(file_name,affx::FILE5_REPLACE);
+  affx::File5_Group* group5=file5->openGroup("group",affx::FILE5_REPLACE);
+  affx::File5_Vector* vec5=group5->openVector("vector",affx::FILE5_DTYPE_INT,affx::FILE5_REPLACE);
+  FILE5_ASSERT(vec5->m_opt_chunksize==4096);
+  vec5->close();
+  delete vec5;
+  group5->setOptHint(affx::FILE5_HINT_ARCHIVE);
+  affx::File5_Tsv* tsv5=group5->openTsv("tsv",affx::FILE5_REPLACE);
+  tsv5->defineColumn(0,0,"int",affx::FILE5_DTYPE_INT);
+  tsv5->defineColumn(0,1,"name",affx::FILE5_DTYPE_STRING,20);
+  FILE5_ASSERT(tsv5->getColumnPtr(0,0)->m_opt_chunksize==262144);
+  char buf[100];
+  for (int i=0;i<3000;i++) {
+    sprintf(buf,"name-%d",i);
+    tsv5->set_i(0,0,i);
+    tsv5->set_string(0,1,buf);
+    tsv5->writeLevel(0);
+  }
+  tsv5->close();
+  delete tsv5;
+  group5->close();
+  delete group5;
+  // a matrix laid out for reading columns.
+  file5->setOptHint(affx::FILE5_HINT_COLUMN_STREAMING);
+  affx::File5_Matrix* mat5=file5->openMatrix("matrix",affx::FILE5_DTYPE_FLOAT,test_dims(1000,200),affx::FILE5_REPLACE);
+  FILE5_ASSERT(test_chunk_dims(mat5->m_h5_obj,2)[1]==65);
+  std::vector<float> vals(1000*200);
+  for (size_t i=0;i<vals.size();i++) {
+    vals[i]=i;
+  }
+  mat5->set_block_void(test_dims(0,0),test_dims(1000,200),&vals[0]);
+  mat5->close();
+  delete mat5;
+  file5->close();
+  delete file5;
+  DOT_PRINT();
+
+  // rechunk it for reading rows, and check it all came along.
+  std::string file_name_rows=file_name+".rows";
+  affx::File5_File::rechunk(file_name,file_name_rows,affx::FILE5_HINT_ROW_STREAMING);
+  file5=new affx::File5_File();
+  file5->open(file_name_rows,affx::FILE5_OPEN);
+  mat5=file5->openMatrix("matrix",affx::FILE5_DTYPE_FLOAT,test_dims(0,0),affx::FILE5_OPEN);
+  FILE5_ASSERT((mat5->m_dims[0]==1000)&&(mat5->m_dims[1]==200));
+  FILE5_ASSERT(test_chunk_dims(mat5->m_h5_obj,2)[0]==327);
+  std::vector<float> col(1000);
+  mat5->get_block_void(test_dims(0,7),test_dims(1000,1),&col[0]);
+  for (int r=0;r<1000;r++) {
+    FILE5_ASSERT(col[r]==vals[r*200+7]);
+  }
+  mat5->close();
+  delete mat5;
+  tsv5=file5->openTsv("group/tsv",affx::FILE5_OPEN);
+  FILE5_ASSERT(tsv5->getLineCount()==3000);
+  FILE5_ASSERT(tsv5->getColumnPtr(0,0)->m_opt_chunksize==3000);
+  int val_i;
+  std::string val_s;
+  int line=0;
+  while (tsv5->nextLine()==affx::FILE5_OK) {
+    tsv5->get(0,0,&val_i);
+    tsv5->get(0,1,&val_s);
+    sprintf(buf,"name-%d",line);
+    FILE5_ASSERT((val_i==line)&&(val_s==buf));
+    line++;
+  }
+  FILE5_ASSERT(line==3000);
+  tsv5->close();
+  delete tsv5;
+  file5->close();
+  delete file5;
+  unlink(file_name_rows.c_str());
+  DOT_PRINT();
+  DOT_OK();
+}
+
+/// Time reading a float matrix by rows, by columns and in small blocks,
+/// with the matrix written and read under each hint.
+/// Each pass reads a sample (the first 100 rows, 16 columns, 2000 blocks), as reading
+/// against the layout is slow enough that a whole pass takes minutes.
+void run_test_benchmark_hints(const std::string& file_name,int row_cnt)
+{
+  DOT_TITLE("run_test_benchmark_hints",file_name.c_str());
+  int col_cnt=256;
+  int block_cnt=2000;
+  int read_row_cnt=std::min(row_cnt,100);
+  int read_col_cnt=16;
+  FILE5_ASSERT(row_cnt>8);
+  std::vector<float> buf((size_t)row_cnt*col_cnt);
+  affx::File5_hint_t hints[]={
+    affx::FILE5_HINT_DEFAULT,
+    affx::FILE5_HINT_ROW_STREAMING,
+    affx::FILE5_HINT_COLUMN_STREAMING,
+    affx::FILE5_HINT_RANDOM,
+    affx::FILE5_HINT_ARCHIVE,
+  };
+  double mb=(double)buf.size()*sizeof(float)/(1024*1024);
+  double rows_mb=(double)read_row_cnt*col_cnt*sizeof(float)/(1024*1024);
+  double cols_mb=(double)read_col_cnt*row_cnt*sizeof(float)/(1024*1024);
+  printf("%d x %d floats (%.1f MB): %d rows, %d columns, %d random 8x8 blocks\n",
+         row_cnt,col_cnt,mb,read_row_cnt,read_col_cnt,block_cnt);
+  printf("%-17s %10s %10s %10s\n","hint","rows MB/s","cols MB/s","blocks/s");
+
+  for (int h=0;h<5;h++) {
+    affx::File5_File* file5=new affx::File5_File();
+    file5->setOptHint(hints[h]);
+    file5->open(file_name,affx::FILE5_REPLACE);
+    affx::File5_Matrix* mat5=file5->openMatrix("matrix",affx::FILE5_DTYPE_FLOAT,test_dims(row_cnt,col_cnt),affx::FILE5_REPLACE);
+    for (size_t i=0;i<buf.size();i++) {
+      buf[i]=i%1000;
+    }
+    mat5->set_block_void(test_dims(0,0),test_dims(row_cnt,col_cnt),&buf[0]);
+    mat5->close();
+    delete mat5;
+    file5->close();
+
+    // a fresh open, so the chunk cache starts empty.
+    file5->open(file_name,affx::FILE5_OPEN);
+    mat5=file5->openMatrix("matrix",affx::FILE5_DTYPE_FLOAT,test_dims(0,0),affx::FILE5_OPEN);
+    clock_t start=clock();
+    for (int r=0;r<read_row_cnt;r++) {
+      mat5->get_block_void(test_dims(r,0),test_dims(1,col_cnt),&buf[(size_t)r*col_cnt]);
+    }
+    double rows_sec=(double)(clock()-start)/CLOCKS_PER_SEC;
+    start=clock();
+    for (int i=0;i<read_col_cnt;i++) {
+      int c=i*col_cnt/read_col_cnt;
+      mat5->get_block_void(test_dims(0,c),test_dims(row_cnt,1),&buf[(size_t)c*row_cnt]);
+    }
+    double cols_sec=(double)(clock()-start)/CLOCKS_PER_SEC;
+    unsigned int seed=17;
+    start=clock();
+    for (int b=0;b<block_cnt;b++) {
+      seed=seed*1103515245+12345;
+      int r=(seed>>8)%(row_cnt-8);
+      seed=seed*1103515245+12345;
+      int c=(seed>>8)%(col_cnt-8);
+      mat5->get_block_void(test_dims(r,c),test_dims(8,8),&buf[(size_t)b%1000*64]);
+    }
+    double blocks_sec=(double)(clock()-start)/CLOCKS_PER_SEC;
+    mat5->close();
+    delete mat5;
+    file5->close();
+    delete file5;
+    printf("%-17s %10.1f %10.1f %10.0f\n",
+           affx::file5_hint_to_string(hints[h]).c_str(),
+           rows_mb/rows_sec,cols_mb/cols_sec,block_cnt/blocks_sec);
+  }
+}
+
+//////////
+
 void define_testfile5_options(PgOptions* opts)
 {
   opts->setUsage("test-file5 -- A file5 test program.");
@@ -992,6 +1354,12 @@ void define_testfile5_options(PgOptions* opts)
   opts->defineOption("","benchmark", PgOpt::INT_OPT,
                      "Number of doubles to write for benchmarking output.",
                      "0");
+  opts->defineOption("","benchmark-tsv-bulk", PgOpt::INT_OPT,
+                     "Number of rows to move row by row and in bulk for benchmarking.",
+                     "0");
+  opts->defineOption("","benchmark-hints", PgOpt::INT_OPT,
+                     "Number of matrix rows to write under each hint for benchmarking. (20000 takes about 15 seconds.)",
+                     "0");
   opts->defOpt("o","output",PgOpt::STRING_OPT,
                "output file",
                "");
@@ -1033,6 +1401,14 @@ int main(int argc, const char* argv[])
     run_test_benchmark_write(opts->get("output"),opts->getInt("benchmark"));
     return 0;
   }
+  if (opts->getInt("benchmark-tsv-bulk")!=0) {
+    run_test_benchmark_tsv_bulk("test-file5-benchmark-tsv-bulk.file5",opts->getInt("benchmark-tsv-bulk"));
+    return 0;
+  }
+  if (opts->getInt("benchmark-hints")!=0) {
+    run_test_benchmark_hints("test-file5-benchmark-hints.file5",opts->getInt("benchmark-hints"));
+    return 0;
+  }
   if (opts->getBool("test-big-vectors")) {
     run_test_big_vectors("test-big-vectors.file5");
     return 0;
@@ -1051,6 +1427,7 @@ int main(int argc, const char* argv[])
   if (opts->getBool("test-matrix")) {
     num_run++;
     run_test_matrix("test-file5-matrix.file5");
+    run_test_hints("test-file5-hints.file5");
   }
   //
   if (opts->getBool("test-vector")) {
@@ -1079,6 +1456,7 @@ int main(int argc, const char* argv[])
     run_test_tsv_write(file_name);
     run_test_tsv_write(file_name);
     run_test_twoleveltsv("test-file5-twolevel.file5");
+    run_test_tsv_bulk("test-file5-tsv-bulk.file5");
     //
     run_test_tsv_delete("test-file5-tsv-delete.file5");
   }
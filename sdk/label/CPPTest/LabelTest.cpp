@@ -27,8 +27,13 @@
 #include <cppunit/extensions/TestFactoryRegistry.h>
 #include <cppunit/ui/text/TestRunner.h>
 //
+#include "util/Convert.h"
+#include "util/Verbose.h"
+//
 #include <cmath>
 #include <cstring>
+#include <ctime>
+#include <iostream>
 #include <string>
 //
 
@@ -48,6 +53,8 @@ class LabelTest : public CppUnit::TestFixture {
   CPPUNIT_TEST_SUITE( LabelTest );
   CPPUNIT_TEST( testLabel );
   CPPUNIT_TEST( HardTests );
+  CPPUNIT_TEST( WorkspaceTest );
+  CPPUNIT_TEST( TimingTest );
   CPPUNIT_TEST_SUITE_END();
 
 public:
@@ -66,6 +73,8 @@ public:
   void setUp();
 	void testLabel();
 	void HardTests();
+	void WorkspaceTest();
+	void TimingTest();
 	static bool closeEnough(double d1, double d2, int digits=6);
 
 };
@@ -435,6 +444,180 @@ void LabelTest::testLabel() {
 
 }
 
+/** a snp of n samples in three clusters, from a fixed seed */
+static void make_snp(vector<double> &x, vector<double> &y, int n, unsigned int seed)
+{
+	x.resize(n);
+	y.resize(n);
+	for (int i=0; i<n; i++)
+	{
+		seed = seed*1103515245 + 12345;
+		double noise = (double)((int)((seed >> 8) % 2001) - 1000)/10000.0;
+		int cluster = (seed >> 20) % 5;
+		x[i] = (cluster<2 ? .66 : (cluster<4 ? 0 : -.66)) + noise;
+		y[i] = 9 + noise;
+	}
+}
+
+/** parameters exercising the 2-d clusters, bins, penalties and copy qc */
+static void make_param(snp_param &sp, int variant)
+{
+	sp.Initialize();
+	sp.bins = (variant & 1) ? 0 : 40;
+	sp.clustertype = (variant & 2) ? 2 : 1;
+	sp.callmethod = (variant & 4) ? 0 : 1;
+	sp.mix = variant % 4;
+	sp.bic = (variant & 8) ? 2 : 0;
+	sp.CSepPen = (variant & 8) ? 0.1 : 0;
+	sp.hardshell = 1 + variant % 3;
+	sp.copynumber = (variant % 5 == 0) ? 1 : 2;
+	sp.copyqc = 0.00025;
+	sp.copytype = 1;
+	sp.ocean = 0.00001;
+}
+
+/** snp sizes of WorkspaceTest, the seeds and parameters follow the index */
+static const int workspaceSizes[] = {40, 7, 30, 60, 24, 1, 36};
+
+/** calls and confidences of WorkspaceTest from the per-call code before label_workspace */
+static const int workspaceRefCalls[] = {
+	0,2,0,0,0,0,2,0,0,2,0,2,0,0,2,2,0,2,0,2,0,0,0,0,0,2,0,0,2,0,2,2,0,2,0,0,0,2,2,2,
+	1,0,1,1,1,1,0,0,2,1,0,1,1,2,1,1,2,1,0,1,2,1,2,0,2,1,0,0,2,0,1,1,1,0,0,1,2,1,1,2,
+	1,0,0,0,1,2,2,0,1,2,0,1,0,1,1,2,1,0,2,2,0,0,2,1,1,0,1,0,1,1,0,1,0,1,1,1,2,2,1,1,
+	2,2,1,1,2,0,0,0,1,0,1,2,2,1,1,2,2,0,0,2,2,0,2,2,0,2,1,2,2,0,1,1,1,0,1,2,2,2,1,1,
+	1,0,2,1,0,2,2,1,2,1,0,1,0,2,2,0,0,0,0,1,0,1,1,0,1,2,0,2,0,0,1,0,2,0,0,1,2,1
+};
+static const double workspaceRefConfs[] = {
+	0.000656285360519,0.285915284113,0.363637307899,0.00125513284098,0.233762621368,0.144602099791,0.27676338202,0.136068064838,
+	0.419616539491,0.00161251914808,0.00161549915403,0.000678621445421,0.00145050786381,0.000632608800794,0.000656721080273,0.0013488489974,
+	0.000686794676424,0.000822805260942,0.16237042259,0.000984231958311,0.248491459092,0.000636338716087,0.00148378446674,0.114700944674,
+	0.329870016931,0.000642109146194,0.199698770394,0.000700616686763,0.244672264933,0.000638461345106,0.00161597098862,0.442013895838,
+	0.00229181916133,0.00112311869944,0.000976571770232,0.000671693696189,0.00103754063393,0.00145063704123,0.00194644878365,0.295981505928,
+	0.000663194738056,0.000707360515862,0.00198971304019,0.000663478750923,0.00127761705365,0.000661793449991,0.000707362024186,0.000690175471905,
+	0.000631597970293,0.00102602227431,0.000827128993412,0.00189077945382,0.00297384162733,0.000883293766979,0.00337983006807,0.000708417223608,
+	0.000674353159254,0.000969842665417,0.000742354052984,0.000717189001689,0.000655855180792,0.000630940564177,0.000637500409259,0.00225588994177,
+	0.000736113939392,0.000732836235613,0.000754390839859,0.00143435405118,0.00075996121739,0.000685795670709,0.0011016715372,0.00251436032114,
+	0.000788435140152,0.00102370870465,0.00063013437326,0.00145757497102,0.000695913167066,0.000912483435567,0.00119981009104,0.00157279541736,
+	0.00167201673433,0.000790260870454,0.000661477634298,0.000923374570191,0.000682591690159,0.00245816269597,0.000664193330463,0.000632874630549,
+	0.00102637520133,0.000713528982913,0.000707864778255,0.000630553647377,0.00066805733027,0.00319923717548,0.000816767823168,0.00115315825822,
+	0.00309936988592,0.000722176256752,0.000659719743635,0.00518217080193,0.000702199131413,0.00122498711191,0.000767536179309,0.00190454311023,
+	0.00279754665874,0.000739085809231,0.00204290117597,0.00110121211761,0.00225570367744,0.000651446234101,0.000639382887267,0.00147642993996,
+	0.000630720149587,0.000697682064789,0.00239526165514,0.000638700204787,0.000990071774018,0.000735932493233,0.00120222716302,0.000893464512253,
+	0.000778937019436,0.000884299676102,0.000969166102632,0.000631924648629,0.000663398838121,0.000634932080937,0.000916287584898,0.000667429793157,
+	0.000630154621836,0.000635158722574,0.00116053269049,0.000657648750761,0.00071416194893,0.000724510939003,0.00234745048366,0.000635782633038,
+	0.00354436476608,0.00187742363678,0.000743534923055,0.00126093093041,0.000764837261389,0.000629272425124,0.000851438808197,0.0006288768566,
+	0.00150954499828,0.00193656369674,0.000629874892706,0.000928171589332,0.000660570895269,0.000639625600312,0.0012195412537,0.00148132048354,
+	0.00131146239579,0.000633844328694,0.00107823554524,0.000991762285331,0.0024348579548,0.000686350649537,0.000712167863174,0.000673118626522,
+	0.00117884753304,0.000627106490677,0.00147568084728,0.000885367425782,0.00146195789742,0.00150668133558,0.00105137011323,0.000628389937457,
+	0.000722210040663,0.000729819062479,0.000741834637119,0.0017109810983,0.00193860760172,0.000627124542005,0.000822333756676,0.00097984205282,
+	0.00161278934871,0.00165930289104,0.0011312289179,0.00070409313963,0.000714556379103,0.00082975141345,0.00201819845105,0.00155006959819,
+	0.00109760339343,0.000902914575356,0.0014771048337,0.0007614566848,0.000715134601438,0.00114391361076,0.000828860651051,0.000854056174268,
+	0.000653660307627,0.000732904036455,0.000716570493003,0.00117170650344,0.000628373815092,0.00122577465374
+};
+/** posterior aa.m, ab.m, bb.m, aa.ss, ab.ss, bb.ss of each snp, from the same code */
+static const double workspaceRefPosteriors[] = {
+	0.439376869433,-2.40054377134e-17,-0.478264126077,0.0522193187362,0.0522193187362,0.0522193187362,
+	0.639316666666,-0.0230192307644,-0.659999999974,0.00590712616982,0.00590712616982,0.00590712616982,
+	0.674807692308,-0.0014696969697,-0.651766666667,0.0044004802258,0.0044004802258,0.0044004802258,
+	0.662533333333,-0.00308778625954,-0.674380952381,0.00425633281162,0.00425633281162,0.00425633281162,
+	0.66382,-0.0229756097562,-0.649842857143,0.00497723922543,0.00497723922543,0.00497723922543,
+	0.67058,0,-0.66,0.00645614086062,0.00645614086062,0.00645614086062,
+	0.658678947368,0.00142857142857,-0.649057142857,0.00508469658067,0.00508469658067,0.00508469658067
+};
+
+/** a fresh call and one workspace reused over snps of different sizes label each snp as the per-call code did */
+void LabelTest::WorkspaceTest() {
+	cout << endl;
+	Verbose::out(1, "****LabelTest::WorkspaceTest****");
+	label_workspace ws;
+	int first = 0;
+	for (int k=0; k<(int)(sizeof(workspaceSizes)/sizeof(workspaceSizes[0])); k++)
+	{
+		int n = workspaceSizes[k];
+		vector<double> x,y;
+		make_snp(x,y,n,101+k);
+		vector<int> hints;
+		if (k%2==0)
+		{
+			hints.resize(n);
+			for (int i=0; i<n; i++)
+				hints[i] = i%4-1;
+		}
+		vector<double> inbred(n,0);
+		snp_param sp1,sp2;
+		make_param(sp1,k);
+		sp1.hints = (k%2==0);
+		sp1.contradictionpenalty = 4;
+		sp2.copy(sp1);
+		vector<affx::GType> call1(n),call2(n);
+		vector<double> conf1(n),conf2(n);
+		vector<double> ted1,teh1,tec1,ted2,teh2,tec2;
+		bayes_label(call1,conf1,x,y,hints,inbred,sp1,ted1,teh1,tec1,true);
+		bayes_label(call2,conf2,x,y,hints,inbred,sp2,ted2,teh2,tec2,true,ws);
+		for (int i=0; i<n; i++)
+		{
+			CPPUNIT_ASSERT(call1[i]==workspaceRefCalls[first+i]);
+			CPPUNIT_ASSERT(closeEnough(conf1[i],workspaceRefConfs[first+i],10));
+			CPPUNIT_ASSERT(call1[i]==call2[i]);
+			CPPUNIT_ASSERT(conf1[i]==conf2[i]);
+		}
+		first += n;
+		CPPUNIT_ASSERT(ted1==ted2 && teh1==teh2 && tec1==tec2);
+		const double *ref = &workspaceRefPosteriors[6*k];
+		CPPUNIT_ASSERT(closeEnough(sp1.posterior.aa.m,ref[0],10));
+		CPPUNIT_ASSERT(closeEnough(sp1.posterior.ab.m,ref[1],10));
+		CPPUNIT_ASSERT(closeEnough(sp1.posterior.bb.m,ref[2],10));
+		CPPUNIT_ASSERT(closeEnough(sp1.posterior.aa.ss,ref[3],10));
+		CPPUNIT_ASSERT(closeEnough(sp1.posterior.ab.ss,ref[4],10));
+		CPPUNIT_ASSERT(closeEnough(sp1.posterior.bb.ss,ref[5],10));
+		CPPUNIT_ASSERT(sp1.posterior.aa.m==sp2.posterior.aa.m);
+		CPPUNIT_ASSERT(sp1.posterior.ab.ss==sp2.posterior.ab.ss);
+		CPPUNIT_ASSERT(sp1.posterior.bb.ym==sp2.posterior.bb.ym);
+	}
+	CPPUNIT_ASSERT(first==(int)(sizeof(workspaceRefCalls)/sizeof(workspaceRefCalls[0])));
+}
+
+/** a plate of 96 and one of 384 samples: once every parameter variant
+    has been seen the workspace is not reallocated, snps per second are logged */
+void LabelTest::TimingTest() {
+	Verbose::out(1, "****LabelTest::TimingTest****");
+	label_workspace ws;
+	int samples[] = {96, 384};
+	for (int k=0; k<2; k++)
+	{
+		int n = samples[k];
+		int snps = 20000/n;
+		vector<double> x,y;
+		vector<int> hints;
+		vector<double> inbred(n,0);
+		vector<affx::GType> call(n);
+		vector<double> conf(n),ted,teh,tec;
+		const double *q = NULL, *cumulative = NULL;
+		clock_t start = clock();
+		for (int s=0; s<snps; s++)
+		{
+			make_snp(x,y,n,s);
+			snp_param sp;
+			make_param(sp,s%16);
+			bayes_label(call,conf,x,y,hints,inbred,sp,ted,teh,tec,false,ws);
+			if (s==15)
+			{
+				q = &ws.q[0];
+				cumulative = &ws.cumulative[0];
+			}
+			else if (s>15)
+			{
+				CPPUNIT_ASSERT(q==&ws.q[0] && cumulative==&ws.cumulative[0]);
+			}
+		}
+		double seconds = (double)(clock() - start)/CLOCKS_PER_SEC;
+		for (int i=0; i<n; i++)
+			CPPUNIT_ASSERT(affx::GType_valid(call[i]));
+		if (seconds>0)
+			Verbose::out(1, ToStr(n) + " samples: " + ToStr(snps/seconds) + " snps per second");
+	}
+}
+
 // Registers the fixture into the 'registry'
 CPPUNIT_TEST_SUITE_REGISTRATION( LabelTest );
 
@@ -272,12 +272,11 @@ void vmult(vector<double> &X, double factor)
  * inverts 3x3 matrix
  * specialty code, avoid calling external routines
  *
- * @param w - output inverse of matrix
- * @param v - input matrix
+ * @param w - output inverse of matrix (9 values)
+ * @param v - input matrix (9 values)
  */
-void inversethree(vector<double> &w, vector<double> &v)
+inline void inversethree(double *w, const double *v)
 {
-    w.resize(9);
     double det;
     // v = 9 element matrix 11,12,...33
     w[0] = v[4]*v[8]-v[5]*v[7];
@@ -295,6 +294,32 @@ void inversethree(vector<double> &w, vector<double> &v)
         w[i]/=det;
 }
 
+/**
+ * inverts 3x3 matrix
+ *
+ * @param w - output inverse of matrix
+ * @param v - input matrix
+ */
+void inversethree(vector<double> &w, vector<double> &v)
+{
+    w.resize(9);
+    inversethree(&w[0],&v[0]);
+}
+
+/**
+ * sum two vectors
+ *
+ * @param z - output
+ * @param a - input
+ * @param b - input
+ * @param length - length of input vectors
+ */
+inline void sumthree(double *z, const double *a, const double *b, int length)
+{
+    for (int i=0; i<length; i++)
+        z[i] = a[i]+b[i];
+}
+
 /**
  * sum two vectors
  *
@@ -305,20 +330,18 @@ void inversethree(vector<double> &w, vector<double> &v)
 void sumthree(vector<double> &z, vector<double> &a, vector<double> &b)
 {
     z.resize(a.size());
-    for (int i=0; i<a.size(); i++)
-        z[i] = a[i]+b[i];
+    sumthree(&z[0],&a[0],&b[0],a.size());
 }
 
 /**
  * multiply two 3x3 matrices
  *
- * @param z - output
- * @param a - input 3x3 matrix (as 9 length vector)
- * @param b - input 3x3 matrix (as 9 length vector)
+ * @param z - output (9 values)
+ * @param a - input 3x3 matrix (9 values)
+ * @param b - input 3x3 matrix (9 values)
  */
-void timesthree(vector<double> &z, vector<double> &a, vector<double> &b)
+inline void timesthree(double *z, const double *a, const double *b)
 {
-    z.resize(9);
     z[0] = a[0]*b[0]+a[1]*b[3]+a[2]*b[6];
     z[1] = a[0]*b[1]+a[1]*b[4]+a[2]*b[7];
     z[2] = a[0]*b[2]+a[1]*b[5]+a[2]*b[8];
@@ -330,6 +353,33 @@ void timesthree(vector<double> &z, vector<double> &a, vector<double> &b)
     z[8] = a[6]*b[2]+a[7]*b[5]+a[8]*b[8];
 }
 
+/**
+ * multiply two 3x3 matrices
+ *
+ * @param z - output
+ * @param a - input 3x3 matrix (as 9 length vector)
+ * @param b - input 3x3 matrix (as 9 length vector)
+ */
+void timesthree(vector<double> &z, vector<double> &a, vector<double> &b)
+{
+    z.resize(9);
+    timesthree(&z[0],&a[0],&b[0]);
+}
+
+/**
+ * multiply a 1x3 vector by a 3x3 matrix
+ *
+ * @param z - output (3 values)
+ * @param a - 3x3 matrix (9 values)
+ * @param b - 1x3 vector (3 values)
+ */
+inline void timesone(double *z, const double *a, const double *b)
+{
+    z[0] = a[0]*b[0]+a[1]*b[1]+a[2]*b[2];
+    z[1] = a[3]*b[0]+a[4]*b[1]+a[5]*b[2];
+    z[2] = a[6]*b[0]+a[7]*b[1]+a[8]*b[2];
+}
+
 /**
  * multiply a 1x3 vector by a 3x3 matrix
  *
@@ -340,9 +390,7 @@ void timesthree(vector<double> &z, vector<double> &a, vector<double> &b)
 void timesone(vector<double> &z, vector<double> &a, vector<double> &b)
 {
     z.resize(3);
-    z[0] = a[0]*b[0]+a[1]*b[1]+a[2]*b[2];
-    z[1] = a[3]*b[0]+a[4]*b[1]+a[5]*b[2];
-    z[2] = a[6]*b[0]+a[7]*b[1]+a[8]*b[2];
+    timesone(&z[0],&a[0],&b[0]);
 }
 
 
@@ -963,13 +1011,17 @@ void qtoeq(vector<double> &q, int ZS)
                 qmin=q[tin];
         }
     // q, eq
-    for (i=0; i<q.size(); i++)
+    // mask out useless values rather than exponentiate them
+    for (i=0; i<ZS; i++)
     {
-        q[i] = qmin-q[i];
-        q[i] = exp(q[i]);
+        for (j=0; j<i; j++)
+            q[hax(i,j,ZS)] = 0;
+        for (j=i; j<ZS; j++)
+        {
+            tin = hax(i,j,ZS);
+            q[tin] = exp(qmin-q[tin]);
+        }
     }
-    // mask out useless values
-    vmask(q,ZS,0);
 }
 
 /**
@@ -980,8 +1032,9 @@ void qtoeq(vector<double> &q, int ZS)
  * @param ed - relative probability of d = b allele dominant
  * @param ZS - marginal size of matrix
  * @param q  - matrix of relative probability of labelings
+ * @param eqt - scratch for the marginal sums of q
  */
-void eqtoproblabel(vector<double> &ec, vector<double> &eh, vector<double> &ed, int ZS, vector<double> q)
+void eqtoproblabel(vector<double> &ec, vector<double> &eh, vector<double> &ed, int ZS, const vector<double> &q, vector<double> &eqt)
 {
     int i;
     double total;
@@ -994,7 +1047,6 @@ void eqtoproblabel(vector<double> &ec, vector<double> &eh, vector<double> &ed, i
     //  note 0 here is entry "0" in the original list of length l
     // entry j is in ec[l] iff j<=l
     // so straight cumulative sum
-    vector<double> eqt;
     eqt.resize(ZS);
     apply_sum(eqt,q,ZS,0);
     vcumsum(ec,eqt,ZS);
@@ -1516,72 +1568,56 @@ double HW_penalty(double a, double b, double c, double lambda)
  * @param zall - data in bins, sum, sum of squares
  * @param sp - snp parameters
  */
-void integratebrlmmoverlabelings(vector<double> &ec, vector<double> &eh, vector<double> &ed, int ZS, binned_data &zall,snp_param &sp)
+void integratebrlmmoverlabelings(vector<double> &ec, vector<double> &eh, vector<double> &ed, int ZS, binned_data &zall,snp_param &sp, label_workspace &ws)
 {
     int ZSS;
     int NS;
     int i,j;
     //double tmp;
-    // allocate memory for these puppies
-    // over allocate for most of these, but temporary
+    // memory comes from the workspace, sized by the largest snp so far
     ZSS = ZS*ZS;
 
     // likelihood of data, given 
-    vector<double> q;
-    q.resize(ZSS);
+    vector<double> &q = ws.q;
     q.assign(ZSS,0);
-    vector<double> ddx;
-    vector<double> ccx;
-    vector<double> nd;
-    vector<double> nc;
-    vector<double> dd;
-    vector<double> cc;
-    ddx.resize(ZS);
-    ccx.resize(ZS);
-    nd.resize(ZS);
-    nc.resize(ZS);
-    dd.resize(ZS);
-    cc.resize(ZS);
-
-    vector<double> dnod;
-    vector<double> dnoh;
-    vector<double> dnoc,cnoc;
-    dnod.resize(ZS);
-    //hnod.resize(ZS);
-    //cnod.resize(ZS);
-    dnoh.resize(ZS);
-    //hnoh.resize(ZS);
-    //cnoh.resize(ZS);
-    dnoc.resize(ZS);
-    //hnoc.resize(ZS);
-    cnoc.resize(ZS);
-
-    // count up the number of contradictions
-    // cumulative contradictions
-    vcumsum(dnod,zall.nod,ZS);
-    vcumsum(dnoh,zall.noh,ZS);
-    vcumsum(dnoc,zall.noc,ZS);
-    //vreversecumsum(cnod,dnod,ZS);
-    //vreversecumsum(cnoh,dnoh,ZS);
-    vreversecumsum(cnoc,dnoc,ZS);
-    // multiply by the penalty to reduce computational load
-    // obsolete: contradictions are directly penalized in the bins
-    //vmult(cnoc,sp.contradictionpenalty);
-    //vmult(dnod,sp.contradictionpenalty);
-    //vmult(dnoh,sp.contradictionpenalty);
-
-    
+    // cumulative sums of the bins, back to back in one block
+    ws.cumulative.resize(10*ZS);
+    double *nd = &ws.cumulative[0];
+    double *nc = nd+ZS;
+    double *dd = nc+ZS;
+    double *cc = dd+ZS;
+    double *ddx = cc+ZS;
+    double *ccx = ddx+ZS;
+    double *dnod = ccx+ZS;
+    double *dnoh = dnod+ZS;
+    double *dnoc = dnoh+ZS;
+    double *cnoc = dnoc+ZS;
 
     // cumulative number - weight for bins
-    vcumsum(nd,zall.nz,ZS);
+    // cumulative sum of values, of squares
+    // and count up the number of contradictions
+    // obsolete: contradictions are directly penalized in the bins
+    nd[0] = zall.nz[0];
+    dd[0] = zall.zz[0];
+    ddx[0] = zall.zzx[0];
+    dnod[0] = zall.nod[0];
+    dnoh[0] = zall.noh[0];
+    dnoc[0] = zall.noc[0];
+    for (i=1; i<ZS; i++)
+    {
+        nd[i] = zall.nz[i] + nd[i-1];
+        dd[i] = zall.zz[i] + dd[i-1];
+        ddx[i] = zall.zzx[i] + ddx[i-1];
+        dnod[i] = zall.nod[i] + dnod[i-1];
+        dnoh[i] = zall.noh[i] + dnoh[i-1];
+        dnoc[i] = zall.noc[i] + dnoc[i-1];
+    }
     NS = (int)floor(nd[ZS-1]+.00001); // number of points total
-    vreversecumsum(nc,nd,ZS);
-    //cumulative sum of values
-    vcumsum(dd,zall.zz,ZS);
-    vreversecumsum(cc,dd,ZS);
-    // cumulative sum squares
-    vcumsum(ddx,zall.zzx,ZS);
-    vreversecumsum(ccx,ddx,ZS);
+    // and from the other end
+    reversecumsum(nc,nd,ZS);
+    reversecumsum(cc,dd,ZS);
+    reversecumsum(ccx,ddx,ZS);
+    reversecumsum(cnoc,dnoc,ZS);
 
     int tin;
 
@@ -1591,6 +1627,8 @@ void integratebrlmmoverlabelings(vector<double> &ec, vector<double> &eh, vector<
     double yhij,xhij,xhxij;
     double ldij,lcij,lhij;
     double dvdij,dvcij,dvhij;
+    double lvdij,lvcij,lvhij;
+    double qt;
 
     // setup brlmm bits that don't change
     // speed
@@ -1599,19 +1637,29 @@ void integratebrlmmoverlabelings(vector<double> &ec, vector<double> &eh, vector<
             vector<double> Sinv;
             setupBRLMM(m,Minv,Sinv,sp);
             // only work with Sinv;
-            // scratch vectors
-            vector<double> Tz;
-            vector<double> Zt;
-            vector<double> Xinv;
-            vector<double> Xt;
-            vector<double> Mz;
-            // vectors that change
+            // scratch
+            double Tz[9];
+            double Zt[9];
+            double Xinv[9];
+            double Xt[3];
+            double Mz[3];
+            // prior part of the centers
+            double MinvM[3];
+            timesone(MinvM,&Minv[0],&m[0]);
+            // variance of the prior means
+            double vb = 1/Minv[8];
+            double vh = 1/Minv[4];
+            double va = 1/Minv[0];
+            double lvb = log(vb);
+            double lvh = log(vh);
+            double lva = log(va);
+            // values that change
             // sum of x
-            vector<double> Nv;
+            double Nv[3];
             // number of data points
-            vector<double> N;
-            Nv.resize(3);
-            N.assign(9,0);
+            double N[9];
+            for (i=0; i<9; i++)
+                N[i] = 0;
 
     // do some more setup
     // so that things that aren't executed don't get repeated conditionals
@@ -1699,6 +1747,13 @@ void integratebrlmmoverlabelings(vector<double> &ec, vector<double> &eh, vector<
     // big loop: try all reasonable labelings
     // bb^i->ab^(j-i)->aa^(n-j+1)
     for (i=0; i<ZS; i++)
+    {
+        // d
+        ydij = nd[i];
+        xdij = dd[i];
+        xdxij = ddx[i];
+        N[8] = ydij;
+        Nv[2] = xdij;
         for (j=i; j<ZS; j++)
         {
             tin = hax(i,j,ZS);
@@ -1707,10 +1762,6 @@ void integratebrlmmoverlabelings(vector<double> &ec, vector<double> &eh, vector<
             ycij = nc[j];
             xcij = cc[j];
             xcxij = ccx[j];
-            // d
-            ydij = nd[i];
-            xdij = dd[i];
-            xdxij = ddx[i];
             // h
             yhij = nd[j]-nd[i];
             xhij = dd[j]-dd[i];
@@ -1721,18 +1772,15 @@ void integratebrlmmoverlabelings(vector<double> &ec, vector<double> &eh, vector<
             // setup centers
             Nv[0] = xcij;
             Nv[1] = xhij;
-            Nv[2] = xdij;
             // number of data points
             N[0] = ycij;
             N[4] = yhij;
-            N[8] = ydij;
             // do some inversions
-            timesthree(Tz,N,Sinv);
-            sumthree(Zt, Minv,Tz);
+            timesthree(Tz,N,&Sinv[0]);
+            sumthree(Zt,&Minv[0],Tz,9);
             inversethree(Xinv,Zt);
-            timesone(Tz,Sinv, Nv);
-            timesone(Zt,Minv, m);
-            sumthree(Xt,Tz,Zt);
+            timesone(Tz,&Sinv[0],Nv);
+            sumthree(Xt,Tz,MinvM,3);
             timesone(Mz,Xinv,Xt);
             // Tz = three means
             //printf("%d %f %f %f\n", tin, Mz[0],Mz[1],Mz[2]);
@@ -1770,36 +1818,38 @@ void integratebrlmmoverlabelings(vector<double> &ec, vector<double> &eh, vector<
                 dvcij = (tl*td+tlm*tc+tl*th)/(tl*tnd+tlm*tnc+tl*tnh);
                 dvhij = (tl*td+tl*tc+tlm*th)/(tl*tnd+tl*tnc+tlm*tnh);
             }
+            // each log variance is shared by the data and the prior terms
+            lvdij = log(dvdij);
+            lvhij = log(dvhij);
+            lvcij = log(dvcij);
         ////
         ////
         //// now do the global likelihood with calculated values
+            // same terms, in the same order, as
+            // l_posterior, l_normal and l_inverse
             // likelihood of the data gvien mean/variance    
-            //q[tin] = 0;
-            q[tin] += l_posterior(xdxij,ldij,xdij,ydij,dvdij);
-            q[tin] += l_posterior(xhxij,lhij,xhij,yhij,dvhij);
-            q[tin] += l_posterior(xcxij,lcij,xcij,ycij,dvcij);    
-            //printf("%d %lf\n", i, q[i]);    
+            qt = q[tin];
+            qt += (xdxij-2*ldij*xdij+ldij*ldij*ydij)/dvdij + ydij*lvdij;
+            qt += (xhxij-2*lhij*xhij+lhij*lhij*yhij)/dvhij + yhij*lvhij;
+            qt += (xcxij-2*lcij*xcij+lcij*lcij*ycij)/dvcij + ycij*lvcij;
     
             // likelihood of mean under prior
-            //q[tin] += l_normal(sp.bb.m,ldij,sp.bb.ss/sp.bb.k);
-            //q[tin] += l_normal(sp.ab.m,lhij,sp.ab.ss/sp.ab.k);
-            //q[tin] += l_normal(sp.aa.m,lcij,sp.aa.ss/sp.aa.k);
-            q[tin] += l_normal(sp.prior.bb.m,ldij,1/Minv[8]);
-            q[tin] += l_normal(sp.prior.ab.m,lhij,1/Minv[4]);
-            q[tin] += l_normal(sp.prior.aa.m,lcij,1/Minv[0]);
+            qt += (sp.prior.bb.m-ldij)*(sp.prior.bb.m-ldij)/vb + lvb;
+            qt += (sp.prior.ab.m-lhij)*(sp.prior.ab.m-lhij)/vh + lvh;
+            qt += (sp.prior.aa.m-lcij)*(sp.prior.aa.m-lcij)/va + lva;
             // likelihood of variance under prior
-            q[tin] += l_inverse(sp.prior.bb.ss,dvdij,sp.prior.bb.v);
-            q[tin] += l_inverse(sp.prior.ab.ss,dvhij,sp.prior.ab.v);
-            q[tin] += l_inverse(sp.prior.aa.ss,dvcij,sp.prior.aa.v);
+            qt += sp.prior.bb.ss/dvdij + (sp.prior.bb.v+1)*lvdij;
+            qt += sp.prior.ab.ss/dvhij + (sp.prior.ab.v+1)*lvhij;
+            qt += sp.prior.aa.ss/dvcij + (sp.prior.aa.v+1)*lvcij;
             // half
-            q[tin] /= 2;
+            qt /= 2;
             
             // penalize assorted peculiar features of the data
             // i.e. too close, too strange
             if (sp.hardshell==2)
-                q[tin] += NS*fix_shell(ldij,lcij,lhij,sp.shellbarrier);
+                qt += NS*fix_shell(ldij,lcij,lhij,sp.shellbarrier);
             if (sp.hardshell==1)
-                q[tin] += NS*fix_hom_shell(ldij,lcij,lhij,sp.shellbarrier);
+                qt += NS*fix_hom_shell(ldij,lcij,lhij,sp.shellbarrier);
             if (sp.CSepPen>0)
             {
                 // avoid cluster splitting by ad-hoc penalty for FLD too small
@@ -1819,14 +1869,16 @@ void integratebrlmmoverlabelings(vector<double> &ec, vector<double> &eh, vector<
                 fldhc *= (yhij+ycij);
                 flddc *= (ydij+ycij);
                 // favor! [larger FLD better, up to a point]
-                q[tin] -= sp.CSepPen * (flddh+fldhc+flddc);
+                qt -= sp.CSepPen * (flddh+fldhc+flddc);
             }
+            q[tin] = qt;
         }
+    }
 
     
     qtoeq(q,ZS);
     // convert q to label
-    eqtoproblabel(ec,eh,ed,ZS,q);
+    eqtoproblabel(ec,eh,ed,ZS,q,ws.eqt);
 }
 
 /**
@@ -1913,11 +1965,11 @@ void qc_modify_confidences(vector<affx::GType> &call, vector<double> &conf, vect
     }
 }
 
-void qc_compute_copy_posterior(vector<affx::GType> call, vector<double> &y, snp_distribution &posterior)
+void qc_compute_copy_posterior(const vector<affx::GType> &call, vector<double> &y, snp_distribution &posterior)
 {
-    vector<double> cmean;
-    vector<double> cnum;
-    vector<double> residual;
+    double cmean[3];
+    double cnum[3];
+    double residual;
     double shrinkage = 0.00001;
     double vshrinkage = 0.1;
     double minvar = 0.1;
@@ -1925,10 +1977,6 @@ void qc_compute_copy_posterior(vector<affx::GType> call, vector<double> &y, snp_
     double cy,ss;
     
     // old_style computation
-    residual.resize(call.size());
-    cmean.resize(3);
-    cnum.resize(3);
-    
     for (cIx=0; cIx<3; cIx++)
     {
         cmean[cIx] = 0;
@@ -1949,20 +1997,19 @@ void qc_compute_copy_posterior(vector<affx::GType> call, vector<double> &y, snp_
     cmean[1] = (cy*shrinkage+cmean[1])/(cnum[1]+shrinkage);
     cmean[2] = (cy*shrinkage+cmean[2])/(cnum[2]+shrinkage);
     // all three exist
+    ss = 0;
     for (i=0; i<call.size(); i++)
     {
         // if (call[i]>-1 && call[i]<3) {
     if (affx::GType_called(call[i])) { // aa,ab,bb
-            residual[i] = y[i] - cmean[call[i]];
+            residual = y[i] - cmean[call[i]];
         }
         else {
-            residual[i] = 0.0;
+            residual = 0.0;
     }
+        ss+= residual*residual;
     }
-    ss = 0;
-    for (i=0; i<residual.size(); i++)
-        ss+= residual[i]*residual[i];
-    ss = (ss + minvar*vshrinkage)/(residual.size()+vshrinkage); // degrees of freedom close enough for large data sets
+    ss = (ss + minvar*vshrinkage)/(call.size()+vshrinkage); // degrees of freedom close enough for large data sets
 
     // output means (shrunk towards center)
     posterior.aa.ym = cmean[0];
@@ -1982,7 +2029,7 @@ void qc_compute_copy_posterior(vector<affx::GType> call, vector<double> &y, snp_
  * @param conf - confidence per data point
  * @param y - strength per data point
  */
-void qc_posterior_modify_confidences(vector<affx::GType> &call, vector<double> &conf, vector<double> &y, double perr, snp_distribution dist)
+void qc_posterior_modify_confidences(vector<affx::GType> &call, vector<double> &conf, vector<double> &y, double perr, const snp_distribution &dist)
 {
     // use scatter in y direction to find outlier data points
     // outlier = pr(under model for y)<pr(error)
@@ -1993,11 +2040,9 @@ void qc_posterior_modify_confidences(vector<affx::GType> &call, vector<double> &
     double tmp;
   // double num,ss;
     double residual;
-    vector<double> cmean,cvar;
+    double cmean[3],cvar[3];
     double wgt;
 
-    cmean.resize(3);
-    cvar.resize(3);
     cmean[0] = dist.aa.ym;
     cmean[1] = dist.ab.ym;
     cmean[2] = dist.bb.ym;
@@ -2033,9 +2078,10 @@ void qc_posterior_modify_confidences(vector<affx::GType> &call, vector<double> &
  * @param x    - initial data points (unsorted)
  * @param genohints - hints associated with data points
  * @param numbins - how many bins to make, if bins>points, go with points
+ * @param ws - scratch space for sorting
  *
  */
-void initialize_bins(binned_data &zall, vector<double> &x, vector<double> &y, vector<int> &genohints, vector<double> &SubsetInbred, int numbins, int hok, double CP)
+void initialize_bins(binned_data &zall, vector<double> &x, vector<double> &y, vector<int> &genohints, vector<double> &SubsetInbred, int numbins, int hok, double CP, label_workspace &ws)
 {
     int i;
 
@@ -2058,9 +2104,10 @@ void initialize_bins(binned_data &zall, vector<double> &x, vector<double> &y, ve
     zall.length = x.size();
     zall.NS = zall.length+1;
     
-    vector<double> z,w;
-    vector<int> zerohints;
-    vector<double> zeroInbred;
+    vector<double> &z = ws.z;
+    vector<double> &w = ws.w;
+    vector<int> &zerohints = ws.zerohints;
+    vector<double> &zeroInbred = ws.zeroInbred;
     // local hints always null unless assigned otherwise
     zerohints.assign(zall.length,-1);
     zeroInbred.assign(zall.length,0);
@@ -2080,7 +2127,8 @@ void initialize_bins(binned_data &zall, vector<double> &x, vector<double> &y, ve
     zall.noh.resize(zall.NS);
     zall.noc.resize(zall.NS);
 
-    vector< pair<int,double> > data;
+    vector< pair<int,double> > &data = ws.order;
+    data.clear();
 
     for (i=0; i<zall.length; i++)
     {
@@ -2110,9 +2158,9 @@ void initialize_bins(binned_data &zall, vector<double> &x, vector<double> &y, ve
             zeroInbred[i] = SubsetInbred.at(data[i].first);
     }
     zall.ZS = setup_bins(zall,z,w,zerohints, zeroInbred, zall.length,numbins,hok,CP);
-    zall.ec.resize(zall.ZS);
-    zall.ed.resize(zall.ZS);
-    zall.eh.resize(zall.ZS);    
+    zall.ec.assign(zall.ZS,0);
+    zall.ed.assign(zall.ZS,0);
+    zall.eh.assign(zall.ZS,0);
 }
 
 
@@ -2149,7 +2197,23 @@ void bayes_label(vector<affx::GType> &call,
                  vector<double> &tec, 
                  bool store_probabilities)
 {
-    binned_data zall;
+    label_workspace ws;
+    bayes_label(call, conf, x, y, genohints, SubsetInbred, sp, ted, teh, tec, store_probabilities, ws);
+}
+void bayes_label(vector<affx::GType> &call, 
+                 vector<double> &conf, 
+                 vector<double> &x, 
+                 vector<double> &y, 
+                 vector<int> &genohints, 
+                 vector<double> &SubsetInbred, 
+                 snp_param &sp, 
+                 vector<double> &ted,
+                 vector<double> &teh,
+                 vector<double> &tec, 
+                 bool store_probabilities,
+                 label_workspace &ws)
+{
+    binned_data &zall = ws.zall;
 
     // set up posterior in case no processing of data ("single sample mode")
     sp.priortoposterior();
@@ -2161,11 +2225,11 @@ void bayes_label(vector<affx::GType> &call,
     if (sp.callmethod<2)
     {
         // format the data & hints into bins
-        initialize_bins(zall, x, y, genohints, SubsetInbred, sp.bins,sp.hok,sp.contradictionpenalty);
+        initialize_bins(zall, x, y, genohints, SubsetInbred, sp.bins,sp.hok,sp.contradictionpenalty,ws);
 
         // take the setup-bins, integrate over all possible labelings
         // computing the relative likelihood of the data    
-        integratebrlmmoverlabelings(zall.ec,zall.eh,zall.ed,zall.ZS,zall,sp);
+        integratebrlmmoverlabelings(zall.ec,zall.eh,zall.ed,zall.ZS,zall,sp,ws);
 
         // take the estimated mixture fraction of labels
         // turn into approximate "posterior" distribution 
@@ -123,6 +123,26 @@ public:
 	std::vector<double> eh;
 };
 
+/**
+ *  scratch space for labeling one snp after another
+ *  bayes_label sizes these on first use and only grows them after that
+ *  so a run of snps does not allocate per snp: keep one per thread
+ */
+class label_workspace{
+public:
+	binned_data zall; ///< binned data for the current snp
+	// sorted data
+	std::vector< std::pair<int,double> > order; ///< index and contrast, sorted by contrast
+	std::vector<double> z; ///< contrast in sorted order
+	std::vector<double> w; ///< strength in sorted order
+	std::vector<int> zerohints; ///< hints in sorted order
+	std::vector<double> zeroInbred; ///< inbred penalty in sorted order
+	// labelings
+	std::vector<double> q; ///< log-likelihood of each labeling, ZS*ZS
+	std::vector<double> cumulative; ///< cumulative bin sums, 10 runs of ZS back to back
+	std::vector<double> eqt; ///< marginal sums of q
+};
+
 /** this class holds all three genotype clusters */
 class snp_distribution{
 public:
@@ -374,4 +394,18 @@ void bayes_label(std::vector<affx::GType> &call,
                  std::vector<double> &tec, 
                  bool store_probabilites);
 
+/** as above, reusing the scratch space of the previous snp */
+void bayes_label(std::vector<affx::GType> &call,
+                 std::vector<double> &conf,
+                 std::vector<double> &x,
+                 std::vector<double> &y,
+                 std::vector<int> &genohints,
+                 std::vector<double> &SubsetInbred,
+                 snp_param &sp,
+                 std::vector<double> &ted,
+                 std::vector<double> &teh,
+                 std::vector<double> &tec,
+                 bool store_probabilites,
+                 label_workspace &ws);
+
 #endif /* _SNPLABEL_H_ */
@@ -0,0 +1,400 @@
+////////////////////////////////////////////////////////////////
+//
+// Copyright (C) 2011 Affymetrix, Inc.
+//
+// This program is free software; you can redistribute it and/or modify 
+// it under the terms of the GNU General Public License (version 2) as 
+// published by the Free Software Foundation.
+// 
+// This program is distributed in the hope that it will be useful, 
+// but WITHOUT ANY WARRANTY; without even the implied warranty of 
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU 
+// General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License 
+// along with this program;if not, write to the 
+// 
+// Free Software Foundation, Inc., 
+// 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+//
+////////////////////////////////////////////////////////////////
+
+/// @file   MidasBlockTest.cpp
+/// @brief  Cppunit class for testing the block splice detector against
+///         the per exon newmat fit it replaced.
+
+//
+#include "midas/CPPTest/MidasBlockTest.h"
+//
+#include "midas/MidasConfigureRun.h"
+#include "midas/MidasCreateDirectory.h"
+#include "midas/MidasEngine.h"
+#include "midas/MidasSpliceDetector.h"
+//
+#include "stats/statfun.h"
+#include "util/CPPTest/Setup.h"
+#include "util/Convert.h"
+#include "util/Fs.h"
+#include "util/Verbose.h"
+//
+#include "newmatap.h"
+//
+#include <algorithm>
+#include <cmath>
+#include <ctime>
+#include <fstream>
+#include <iterator>
+
+#define PROGRAM_NAME "MidasBlockTest"
+#define OUTPUT_DIR "output"
+
+// Registers the fixture into the 'registry'
+CPPUNIT_TEST_SUITE_REGISTRATION( MidasBlockTest );
+
+using namespace std;
+
+/**
+ *  The per exon newmat fit of midasSpliceDetector from before the
+ *  designs were factored once, kept as the reference.
+ */
+class referenceMidas
+{
+public:
+  referenceMidas (const vector<int>& groups, float logStabilize, int noLogTransform)
+    : logStabilize (logStabilize), noLogTransform (noLogTransform), N (groups.size())
+  {
+    vector<int> sample_offsets (N);
+    vector<int> s_sorted (groups);
+    sort (s_sorted.begin(), s_sorted.end());
+    vector<int> unique_samples;
+    unique_copy (s_sorted.begin(), s_sorted.end(), back_inserter(unique_samples));
+    const int T = unique_samples.size();
+    for (unsigned int i = 0; i < N; ++i)
+      sample_offsets[i] = distance (unique_samples.begin(), lower_bound (unique_samples.begin(), unique_samples.end(), groups[i]));
+
+    fullDesign = Matrix (N, T);
+    fullDesign = 0.0;
+    for (unsigned int i = 0; i < N; ++i)
+      fullDesign (i + 1, (sample_offsets[i] + 1)) = 1.0;
+    df1 = fullDesign.Ncols();
+
+    Matrix sampleEffect (N, T);
+    sampleEffect = 0.0;
+    for (unsigned int i = 0; i < N; ++i)
+      sampleEffect (i + 1, sample_offsets[i] + 1) = 1.0;
+    Matrix B (N, (N - 1));
+    for (unsigned int i = 1; i <= N - 1; ++i)
+      B (1, i) = -1.0;
+    IdentityMatrix eyeB (N - 1);
+    B.SubMatrix (2, N, 1, (N - 1)) = eyeB;
+    Matrix X = B;
+    UpperTriangularMatrix U (N - 1);
+    Matrix M (N - 1, T);
+    QRZ (X, U);
+    QRZ (X, sampleEffect, M);
+    Matrix temp = B * U.i() * M;
+    reducedDesign = temp.SubMatrix (1, N, 1, (T - 1));
+    dfModel = reducedDesign.Ncols();
+  }
+
+  void run (const vector<float>& exonData, const vector<float>& geneData,
+            float& fstat, vector<float>& normalizedSignal, float& pvalue)
+  {
+    ColumnVector fittedData;
+    double residSsq;
+    double m1Ssq;
+    getEffects (fullDesign, exonData, geneData, fittedData, residSsq, m1Ssq);
+    double m2Ssq;
+    double modelSsq;
+    getEffects (reducedDesign, exonData, geneData, fittedData, m2Ssq, modelSsq);
+    double myFstat = 0.0;
+    if (residSsq != 0.0)
+      myFstat = modelSsq/residSsq;
+    fstat = (float) myFstat;
+    const double maxFitted = fittedData.Maximum();
+    for (unsigned int i = 0; i < N; ++i)
+      normalizedSignal[i] = (float) (fittedData (i+1) - maxFitted);
+    pvalue = (float) affxstat::Ftest (myFstat, dfModel, df1);
+  }
+
+private:
+  void getEffects (const Matrix& design, const vector<float>& exonData, const vector<float>& geneData,
+                   ColumnVector& fittedData, double& residSsq, double& modelSsq)
+  {
+    ColumnVector residuals (N);
+    for (unsigned int i = 0; i < N; ++i)
+    {
+      if (noLogTransform)
+        residuals (i+1) = exonData[i] - geneData[i];
+      else
+        residuals (i+1) = log (exonData[i] + logStabilize) - log (geneData[i] + logStabilize);
+    }
+    Matrix X = design;
+    const int dfModel = design.Ncols();
+    UpperTriangularMatrix U (dfModel);
+    Matrix M (dfModel, 1);
+    QRZ (X, U);
+    QRZ (X, residuals, M);
+    Matrix fit = U.i() * M;
+    fittedData = design * fit;
+    Matrix Ssq = (residuals.t() * residuals) / (N - dfModel);
+    residSsq = Ssq (1,1);
+    Ssq = (fittedData.t() * fittedData) / dfModel;
+    modelSsq = Ssq (1,1);
+  }
+
+  const float logStabilize;
+  const int noLogTransform;
+  const unsigned int N;
+  Matrix fullDesign;
+  double df1;
+  Matrix reducedDesign;
+  double dfModel;
+};
+
+/// Summary like values: a gene level, exon and sample effects, noise.
+static vector<float> testData (int count, float level, unsigned int& seed)
+{
+  vector<float> v (count);
+  for (int i = 0; i < count; ++i)
+  {
+    seed = seed * 1103515245 + 12345;
+    v[i] = level * (0.5 + (float)((seed >> 8) % 10000) / 10000.0) + (float)(i % 3);
+  }
+  return v;
+}
+
+static vector<int> testGroups ()
+{
+  const int groupsIn[] = { 2, 1, 1, 4, 2, 3, 3, 1, 4, 4, 2, 3, 1 };
+  return vector<int> (groupsIn, groupsIn + sizeof (groupsIn) / sizeof (groupsIn[0]));
+}
+
+void MidasBlockTest::testBlock()
+{
+  cout << endl;
+  Verbose::out(1, "****MidasBlockTest::testBlock****");
+  const vector<int> groups = testGroups();
+  const int N = groups.size();
+  const int pairCount = 1000;
+  unsigned int seed = 17;
+
+  // each gene is paired with several exons
+  vector<vector<float> > genes;
+  for (int g = 0; g < 40; ++g)
+    genes.push_back (testData (N, 50.0 + 20.0 * g, seed));
+  vector<vector<float> > exons;
+  vector<const vector<float>*> exonBlock;
+  vector<const vector<float>*> geneBlock;
+  for (int k = 0; k < pairCount; ++k)
+  {
+    exons.push_back (testData (N, 10.0 + (k % 97), seed));
+    geneBlock.push_back (&genes[(k / 25) % genes.size()]);
+  }
+  // gene and exon data identical
+  exons[3] = *geneBlock[3];
+  for (int k = 0; k < pairCount; ++k)
+    exonBlock.push_back (&exons[k]);
+
+  for (int noLogTransform = 0; noLogTransform < 2; ++noLogTransform)
+  {
+    referenceMidas reference (groups, 8.0, noLogTransform);
+    vector<float> fstatExpect (pairCount);
+    vector<vector<float> > normalizedExpect (pairCount, vector<float> (N));
+    vector<float> pvalueExpect (pairCount);
+    for (int k = 0; k < pairCount; ++k)
+      reference.run (exons[k], *geneBlock[k], fstatExpect[k], normalizedExpect[k], pvalueExpect[k]);
+
+    // the blocks are uneven, and one is empty
+    midasSpliceDetector m (groups, true, true, true, 8.0, noLogTransform);
+    vector<float> fstat (pairCount);
+    vector<vector<float> > normalized (pairCount, vector<float> (N));
+    vector<float> pvalue (pairCount);
+    const int starts[] = { 0, 1, 7, 7, 300, pairCount };
+    for (int b = 0; b < 5; ++b)
+      m.runMidasBlock (exonBlock, geneBlock, starts[b], starts[b + 1] - starts[b], &fstat, &normalized, &pvalue);
+
+    // the same to the bit as the per exon fit
+    CPPUNIT_ASSERT (fstat == fstatExpect);
+    CPPUNIT_ASSERT (normalized == normalizedExpect);
+    CPPUNIT_ASSERT (pvalue == pvalueExpect);
+    CPPUNIT_ASSERT (fstat[3] == 0.0);
+
+    float fstatSingle;
+    vector<float> normalizedSingle (N);
+    float pvalueSingle;
+    m.runMidasSingle (exons[10], *geneBlock[10], &fstatSingle, &normalizedSingle, &pvalueSingle);
+    CPPUNIT_ASSERT (fstatSingle == fstatExpect[10]);
+    CPPUNIT_ASSERT (normalizedSingle == normalizedExpect[10]);
+    CPPUNIT_ASSERT (pvalueSingle == pvalueExpect[10]);
+
+    // only the requested outputs are needed
+    midasSpliceDetector m1 (groups, true, false, false, 8.0, noLogTransform);
+    vector<float> pvalue1 (pairCount);
+    m1.runMidasBlock (exonBlock, geneBlock, 0, pairCount, 0, 0, &pvalue1);
+    CPPUNIT_ASSERT (pvalue1 == pvalueExpect);
+
+    // pairs past the end of the data
+    NEGATIVE_TEST (m.runMidasBlock (exonBlock, geneBlock, 990, 20, &fstat, &normalized, &pvalue), Except);
+  }
+}
+
+/// Writes an exon array like data set, many exons per gene.
+static void writeTestFiles (const string& dir, int geneCount, int exonsPerGene)
+{
+  const vector<int> groups = testGroups();
+  const int N = groups.size();
+  unsigned int seed = 5;
+  ofstream cels (Fs::join (dir, "Cels.txt").c_str());
+  ofstream geneData (Fs::join (dir, "GeneData.txt").c_str());
+  ofstream exonData (Fs::join (dir, "ExonData.txt").c_str());
+  ofstream meta (Fs::join (dir, "Meta.txt").c_str());
+  cels << "cel_files\tgroup_id" << endl;
+  geneData << "probeset_id";
+  exonData << "probeset_id";
+  for (int i = 0; i < N; ++i)
+  {
+    const string cel = "Sample" + ToStr (i + 1) + ".ccel";
+    cels << cel << "\tGroup" << groups[i] << endl;
+    geneData << "\t" << cel;
+    exonData << "\t" << cel;
+  }
+  geneData << endl;
+  exonData << endl;
+  meta << "probeset_id\tprobeset_list" << endl;
+  for (int g = 0; g < geneCount; ++g)
+  {
+    vector<float> gene = testData (N, 100.0 + g, seed);
+    geneData << (g + 1);
+    for (int i = 0; i < N; ++i)
+      geneData << "\t" << gene[i];
+    geneData << endl;
+    // the last exon of a gene is also in the next gene
+    meta << (g + 1) << "\t";
+    for (int e = 0; e <= exonsPerGene; ++e)
+      meta << (e ? " " : "") << (1000000 + ((g * exonsPerGene + e) % (geneCount * exonsPerGene)));
+    meta << endl;
+  }
+  for (int x = 0; x < geneCount * exonsPerGene; ++x)
+  {
+    vector<float> exon = testData (N, 20.0 + (x % 13), seed);
+    exonData << (1000000 + x);
+    for (int i = 0; i < N; ++i)
+      exonData << "\t" << exon[i];
+    exonData << endl;
+  }
+}
+
+/// Runs apt-midas on the test files with all outputs.
+static void runMidas (const string& dir, int threads)
+{
+  PgOptions opts;
+  define_midas_opts(&opts);
+  const string threadsString = ToStr (threads);
+  const string celFiles = Fs::join (dir, "Cels.txt");
+  const string geneDataFile = Fs::join (dir, "GeneData.txt");
+  const string exonDataFile = Fs::join (dir, "ExonData.txt");
+  const string metaFile = Fs::join (dir, "Meta.txt");
+  const string outputDir = Fs::join (dir, "threads-" + threadsString);
+  const char* argv[] = {PROGRAM_NAME,
+                        "--cel-files", celFiles.c_str(),
+                        "-g", geneDataFile.c_str(),
+                        "-e", exonDataFile.c_str(),
+                        "-m", metaFile.c_str(),
+                        "-o", outputDir.c_str(),
+                        "-f", "-n",
+                        "--threads", threadsString.c_str(),
+                        NULL};
+  opts.parseArgv(argv);
+  CPPUNIT_ASSERT (midasCreateDirectory (opts.get("out-dir")) == "");
+  Fs::rmIfExists (Fs::join (outputDir, PVALUES_OUTPUT));
+  Fs::rmIfExists (Fs::join (outputDir, FSTATS_OUTPUT));
+  Fs::rmIfExists (Fs::join (outputDir, NORMALIZED_OUTPUT));
+  midasConfigureRun configureRun (opts.get("cel-files"), opts.get("genedata"),
+                                  opts.get("exondata"), opts.get("metaprobeset"), opts.get("out-dir"),
+                                  opts.getBool("pvalues"), opts.getBool("fstats"), opts.getBool("normalized"),
+                                  opts.getDouble("stabilize"), opts.commandLine(), "NON-OFFICIAL-RELEASE",
+                                  opts.getBool("no-logtrans"), opts.getBool("keep-path"), opts.getInt("threads"));
+  CPPUNIT_ASSERT (configureRun.configure() == 0);
+  configureRun.run();
+}
+
+/// The data lines of a file, without the headers which carry guids and dates.
+static vector<string> dataLines (const string& fileName)
+{
+  vector<string> lines;
+  ifstream in (fileName.c_str());
+  string line;
+  while (getline (in, line))
+    if ((line.size() > 0) && (line[0] != '#'))
+      lines.push_back (line);
+  return lines;
+}
+
+void MidasBlockTest::testEngineThreads()
+{
+  Verbose::out(1, "****MidasBlockTest::testEngineThreads****");
+  const string dir = Fs::join (OUTPUT_DIR, "block");
+  CPPUNIT_ASSERT (midasCreateDirectory (OUTPUT_DIR) == "");
+  CPPUNIT_ASSERT (midasCreateDirectory (dir) == "");
+  // more pairs than one block of the engine
+  writeTestFiles (dir, 300, 60);
+  runMidas (dir, 1);
+  runMidas (dir, 3);
+
+  const char* outputs[] = { PVALUES_OUTPUT, FSTATS_OUTPUT, NORMALIZED_OUTPUT };
+  for (int i = 0; i < 3; ++i)
+  {
+    vector<string> lines1 = dataLines (Fs::join (Fs::join (dir, "threads-1"), outputs[i]));
+    vector<string> lines3 = dataLines (Fs::join (Fs::join (dir, "threads-3"), outputs[i]));
+    // the column names and one line per exon, gene pair
+    CPPUNIT_ASSERT (lines1.size() == 1 + 300 * 61);
+    CPPUNIT_ASSERT (lines1 == lines3);
+  }
+}
+
+void MidasBlockTest::testTiming()
+{
+  Verbose::out(1, "****MidasBlockTest::testTiming****");
+  const vector<int> groups = testGroups();
+  const int N = groups.size();
+  const int pairCount = 50000;
+  unsigned int seed = 3;
+  vector<vector<float> > genes;
+  for (int g = 0; g < 2000; ++g)
+    genes.push_back (testData (N, 50.0 + g, seed));
+  vector<vector<float> > exons;
+  vector<const vector<float>*> exonBlock;
+  vector<const vector<float>*> geneBlock;
+  for (int k = 0; k < pairCount; ++k)
+  {
+    exons.push_back (testData (N, 10.0 + (k % 89), seed));
+    geneBlock.push_back (&genes[k / 25]);
+  }
+  for (int k = 0; k < pairCount; ++k)
+    exonBlock.push_back (&exons[k]);
+
+  vector<float> fstatExpect (pairCount);
+  vector<vector<float> > normalizedExpect (pairCount, vector<float> (N));
+  vector<float> pvalueExpect (pairCount);
+  clock_t start = clock();
+  referenceMidas reference (groups, 8.0, false);
+  for (int k = 0; k < pairCount; ++k)
+    reference.run (exons[k], *geneBlock[k], fstatExpect[k], normalizedExpect[k], pvalueExpect[k]);
+  double referenceTime = (double)(clock() - start) / CLOCKS_PER_SEC;
+
+  vector<float> fstat (pairCount);
+  vector<vector<float> > normalized (pairCount, vector<float> (N));
+  vector<float> pvalue (pairCount);
+  start = clock();
+  midasSpliceDetector m (groups, true, true, true, 8.0, false);
+  for (int k = 0; k < pairCount; k += 512)
+    m.runMidasBlock (exonBlock, geneBlock, k, min (512, pairCount - k), &fstat, &normalized, &pvalue);
+  double blockTime = (double)(clock() - start) / CLOCKS_PER_SEC;
+  CPPUNIT_ASSERT (fstat == fstatExpect);
+  CPPUNIT_ASSERT (normalized == normalizedExpect);
+  CPPUNIT_ASSERT (pvalue == pvalueExpect);
+
+  Verbose::out(1, ToStr (pairCount) + " pairs of " + ToStr (N) + " samples, seconds: per exon newmat "
+               + ToStr (referenceTime) + " block " + ToStr (blockTime));
+}
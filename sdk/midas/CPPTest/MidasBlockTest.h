@@ -0,0 +1,46 @@
+////////////////////////////////////////////////////////////////
+//
+// Copyright (C) 2011 Affymetrix, Inc.
+//
+// This program is free software; you can redistribute it and/or modify 
+// it under the terms of the GNU General Public License (version 2) as 
+// published by the Free Software Foundation.
+// 
+// This program is distributed in the hope that it will be useful, 
+// but WITHOUT ANY WARRANTY; without even the implied warranty of 
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU 
+// General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License 
+// along with this program;if not, write to the 
+// 
+// Free Software Foundation, Inc., 
+// 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+//
+////////////////////////////////////////////////////////////////
+
+/// @file   MidasBlockTest.h
+/// @brief  Header for MidasBlockTest.cpp
+
+#ifndef __MIDASBLOCKTEST_H_
+#define __MIDASBLOCKTEST_H_
+
+//
+#include <cppunit/extensions/HelperMacros.h>
+//
+
+class MidasBlockTest : public CppUnit::TestFixture
+{
+  CPPUNIT_TEST_SUITE( MidasBlockTest );
+  CPPUNIT_TEST( testBlock );
+  CPPUNIT_TEST( testEngineThreads );
+  CPPUNIT_TEST( testTiming );
+  CPPUNIT_TEST_SUITE_END();
+
+public:
+  void testBlock();
+  void testEngineThreads();
+  void testTiming();
+};
+
+#endif // __MIDASBLOCKTEST_H_
@@ -94,6 +94,7 @@ MidasFileRoot(const std::string& str)
  * @param execVersion Version, cvs id string.
  * @param noLogTransform Do not log transform data.
  * @param keepPath Keep cel file path.
+ * @param threads Number of threads for the splice detector (0 = one per cpu).
  *
  *  Errors: exception if no output chosen
  */
@@ -103,14 +104,14 @@ midasConfigureRun::midasConfigureRun (std::string celsFileName, std::string gene
                                       const bool wantFstats, const bool wantNormalized,
                                       const float& logStabilize, const std::string& commandLine,
                                       const std::string& execVersion,const bool noLogTransform,
-                                      const bool keepPath)
+                                      const bool keepPath, const int threads)
     : celsFileName (celsFileName), geneDataFileName (geneDataFileName),
       exonDataFileName (exonDataFileName),
       metaFileName (metaFileName), outputDirectory (outputDirectory),
       wantPvalues (wantPvalues), wantFstats (wantFstats), wantNormalized (wantNormalized),
       logStabilize (logStabilize), commandLine (commandLine), noLogTransform (noLogTransform),
       comment ("############################################################"),
-      execVersion (execVersion), keepPath (keepPath)
+      execVersion (execVersion), keepPath (keepPath), threads (threads)
 {
   // require at least one output option
   if (! wantPvalues && ! wantFstats && ! wantNormalized)
@@ -492,7 +493,7 @@ void midasConfigureRun::run()
   // output file names, flags, and log stabilization factor
   midasEngine engine (geneDataCelFiles, groupIdInts, metaFileName, geneDataFileName, exonDataFileName,
 	pvaluesFileName.c_str(), fstatsFileName.c_str(), normalizedFileName.c_str(), wantPvalues,
-	wantFstats, wantNormalized, logStabilize, noLogTransform);
+	wantFstats, wantNormalized, logStabilize, noLogTransform, threads);
   // Add metatags to the bucket...
   addMetaTags(metatagBucketTsv);
   /// @todo  why do we have to copy it to another bucket?
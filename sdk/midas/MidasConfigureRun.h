@@ -58,6 +58,7 @@ public:
    * @param execVersion Version, cvs id string.
    * @param noLogTransform Do not log transform data.
    * @param keepPath Keep cel file path.
+   * @param threads Number of threads for the splice detector (0 = one per cpu).
    */
   midasConfigureRun (std::string celsFileName, std::string geneDataFileName,
                      std::string exonDataFileName, std::string metaFileName, 
@@ -65,7 +66,7 @@ public:
                      const bool wantFstats, const bool wantNormalized, 
                      const float& logStabilize, const std::string& commandLine, 
                      const std::string& execVersion, const bool noLogTransform = false,
-                     const bool keepPath = false);
+                     const bool keepPath = false, const int threads = 1);
 
   /** Set up for run.
    * @return pointer to non-fatal warning message
@@ -221,6 +222,8 @@ private:
   const std::string execVersion;
   /// keep cel file path
   const bool keepPath;
+  /// number of threads for the splice detector
+  const int threads;
 };
 
 #endif /* MIDASCONFIGURE_H */
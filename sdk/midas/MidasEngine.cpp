@@ -31,7 +31,9 @@
 #include "portability/affy-base-types.h"
 #include "util/Convert.h"
 #include "util/PgOptions.h"
+#include "util/Thread.h"
 //
+#include <algorithm>
 #include <cerrno>
 #include <iostream>
 #include <sstream>
@@ -41,6 +43,11 @@
 using namespace std;
 using namespace affx;
 
+/// exon, gene data pairs read before running the splice detector
+static const int MIDAS_BLOCK_PAIRS = 16384;
+/// pairs a thread runs at a time
+static const int MIDAS_THREAD_PAIRS = 512;
+
 void define_midas_opts(PgOptions* opts)
 {
   opts->setUsage("midas - Microarray Detection of Alternative Splicing.\n"
@@ -87,6 +94,9 @@ void define_midas_opts(PgOptions* opts)
   opts->defineOption("", "keep-path", PgOpt::BOOL_OPT,
                      "Keep cel file path.",
                      "false");
+  opts->defineOption("", "threads", PgOpt::INT_OPT,
+                     "Number of threads for the splice detection (0 = one per cpu).",
+                     "1");
 }
 
 /**
@@ -110,6 +120,7 @@ void define_midas_opts(PgOptions* opts)
  *  @param wantNormalized Caller requests normalized exon signal
  *  @param logStabilize Amount to add to data before taking logarithm.
  *  @param noLogTransform Do not log transform data.
+ *  @param threads Number of threads for the splice detector (0 = one per cpu).
  *
  *  Errors: exception if parameter checks fail
  */
@@ -125,12 +136,14 @@ midasEngine::midasEngine(const std::vector<std::string>& celFiles,
                          int wantFstats,
                          int wantNormalized,
                          const float& logStabilize,
-                         int noLogTransform)
+                         int noLogTransform,
+                         int threads)
     : celFiles (celFiles), groups (groups), metaFileName (metaFileName),
       geneDataFileName (geneDataFileName), exonDataFileName (exonDataFileName),
       pvaluesFileName (pvaluesFileName), fstatsFileName (fstatsFileName),
       normalizedFileName (normalizedFileName), wantPvalues (wantPvalues), wantFstats (wantFstats),
       wantNormalized (wantNormalized), logStabilize (logStabilize), noLogTransform (noLogTransform),
+      threads (threads),
       spliceDetector (groups, wantPvalues, wantFstats, wantNormalized, logStabilize, noLogTransform),
       numGroups (groups.size())
 {
@@ -326,8 +339,9 @@ midasEngine::openOutput_Normalized(std::string filename)
 /**
  *  \brief Read, process exon data
  *
- *  Read exon data; for each row, access associated gene data using
- *  the previously constructed maps and write the requested output to file.
+ *  Read exon data; pair each row with its associated gene data using
+ *  the previously constructed maps.  The pairs are collected into blocks
+ *  which processBlock() runs and writes to file in the order read.
  *
  *  Errors: call errAbort for any i/o or format problem in the input file,
  *  if there is no matching gene id from the map.
@@ -341,10 +355,7 @@ void midasEngine::processExonData ()
   typedef const map<int, int>::iterator mapIter_t;
 
   int32_t probesetListId;
-  float fstat;
-  vector<float> normalizedSignal (numGroups);
-  vector<float> probesetListData (numGroups);
-  float pvalue;
+  int exonRowCount = 0;
   //int rv;
 
   if (exonDataTsv.open(exonDataFileName)!=TSV_OK) {
@@ -363,6 +374,10 @@ void midasEngine::processExonData ()
 
   while (exonDataTsv.nextLevel(0)==TSV_OK) {
     // suck in data
+    if (exonRowCount==(int)blockExonData.size()) {
+      blockExonData.push_back(vector<float>(numGroups));
+    }
+    vector<float>& probesetListData=blockExonData[exonRowCount];
     exonDataTsv.get(0,"probeset_id",probesetListId);
     for (int col=1;col<col_cnt;col++) {
       /// @todo map names to columns
@@ -381,6 +396,7 @@ void midasEngine::processExonData ()
     }
     vector<int>* pGeneIds = geneIdVecPos->second;
     const size_t geneIdCount = (*pGeneIds).size();
+    bool paired = false;
     for (unsigned int i = 0; i < geneIdCount; ++i) {
       const int geneId = (*pGeneIds)[i];
       // map gene id to gene data row
@@ -391,32 +407,23 @@ void midasEngine::processExonData ()
       }
       const int geneRow = geneRowIter->second;
 
-      // run the detector
-      spliceDetector.runMidasSingle(probesetListData,geneData[geneRow],&fstat,&normalizedSignal,&pvalue);
-      
-      // dump the data
-      if (wantPvalues) {
-        pvaluesTsv.set(0,"probeset_list_id",probesetListId);
-        pvaluesTsv.set(0,"probeset_id"     ,geneId);
-        pvaluesTsv.set(0,"pvalue"          ,pvalue);
-        pvaluesTsv.writeLevel(0);
-      }
-      if (wantFstats) {
-        fstatsTsv.set(0,"probeset_list_id",probesetListId);
-        fstatsTsv.set(0,"probeset_id"     ,geneId);
-        fstatsTsv.set(0,"fstatistic"      ,fstat);
-        fstatsTsv.writeLevel(0);
-      }
-      if (wantNormalized) {
-        normalizedTsv.set(0,"probeset_list_id",probesetListId);
-        normalizedTsv.set(0,"probeset_id"     ,geneId);
-        for (unsigned int g=0;g<numGroups;g++) {
-          normalizedTsv.set(0,g+2,normalizedSignal[g]);
-        }
-        normalizedTsv.writeLevel(0);
-      }
+      // pair them up for the detector
+      blockExonRows.push_back(exonRowCount);
+      blockProbesetListIds.push_back(probesetListId);
+      blockGeneIds.push_back(geneId);
+      blockGeneData.push_back(&geneData[geneRow]);
+      paired = true;
     } // for
+    // keep the row if it is in the block
+    if (paired) {
+      exonRowCount++;
+    }
+    if ((int)blockGeneIds.size()>=MIDAS_BLOCK_PAIRS) {
+      processBlock();
+      exonRowCount = 0;
+    }
   } // while
+  processBlock();
   
   exonDataTsv.close();
 
@@ -429,6 +436,96 @@ void midasEngine::processExonData ()
     normalizedTsv.close();
 }
 
+/**
+ *  \brief Runs a block of exon, gene data pairs on several threads,
+ *  MIDAS_THREAD_PAIRS pairs at a time.  The pairs are fitted on their
+ *  own, so the thread count does not change the output.
+ */
+class midasBlockTask : public WorkQueueTask
+{
+public:
+  midasBlockTask (const midasSpliceDetector& detector,
+                  const vector<const vector<float>*>& exonData,
+                  const vector<const vector<float>*>& geneData,
+                  vector<float>* fstat,
+                  vector<vector<float> >* normalizedSignal,
+                  vector<float>* pvalue)
+    : WorkQueueTask ((int)exonData.size(), 0, MIDAS_THREAD_PAIRS),
+      detector (detector), exonData (exonData), geneData (geneData), fstat (fstat),
+      normalizedSignal (normalizedSignal), pvalue (pvalue)
+  {
+  }
+
+  virtual void runItems (int threadIx, int start, int count)
+  {
+    detector.runMidasBlock (exonData, geneData, start, count, fstat, normalizedSignal, pvalue);
+  }
+
+private:
+  const midasSpliceDetector& detector;
+  const vector<const vector<float>*>& exonData;
+  const vector<const vector<float>*>& geneData;
+  vector<float>* fstat;
+  vector<vector<float> >* normalizedSignal;
+  vector<float>* pvalue;
+};
+
+/**
+ *  \brief Run the splice detector on the block of pairs, write output
+ *
+ *  The block is split among the threads; the output is written
+ *  afterwards in the order the pairs were read.  The block is
+ *  emptied for the next one.
+*/
+void midasEngine::processBlock ()
+{
+  const int pairCount = blockGeneIds.size();
+  if (pairCount == 0)
+    return;
+
+  vector<const vector<float>*> blockExonPairs (pairCount);
+  for (int i = 0; i < pairCount; ++i)
+    blockExonPairs[i] = &blockExonData[blockExonRows[i]];
+  vector<float> fstat (wantFstats ? pairCount : 0);
+  vector<vector<float> > normalizedSignal (wantNormalized ? pairCount : 0, vector<float> (numGroups));
+  vector<float> pvalue (wantPvalues ? pairCount : 0);
+
+  // run the detector
+  midasBlockTask task (spliceDetector, blockExonPairs, blockGeneData, &fstat, &normalizedSignal, &pvalue);
+  task.run (ThreadGroup::resolveThreadCount (threads));
+
+  // dump the data
+  for (int i = 0; i < pairCount; ++i) {
+    const int probesetListId = blockProbesetListIds[i];
+    const int geneId = blockGeneIds[i];
+    if (wantPvalues) {
+      pvaluesTsv.set(0,"probeset_list_id",probesetListId);
+      pvaluesTsv.set(0,"probeset_id"     ,geneId);
+      pvaluesTsv.set(0,"pvalue"          ,pvalue[i]);
+      pvaluesTsv.writeLevel(0);
+    }
+    if (wantFstats) {
+      fstatsTsv.set(0,"probeset_list_id",probesetListId);
+      fstatsTsv.set(0,"probeset_id"     ,geneId);
+      fstatsTsv.set(0,"fstatistic"      ,fstat[i]);
+      fstatsTsv.writeLevel(0);
+    }
+    if (wantNormalized) {
+      normalizedTsv.set(0,"probeset_list_id",probesetListId);
+      normalizedTsv.set(0,"probeset_id"     ,geneId);
+      for (unsigned int g=0;g<numGroups;g++) {
+        normalizedTsv.set(0,g+2,normalizedSignal[i][g]);
+      }
+      normalizedTsv.writeLevel(0);
+    }
+  }
+
+  blockExonRows.clear();
+  blockProbesetListIds.clear();
+  blockGeneIds.clear();
+  blockGeneData.clear();
+}
+
 /**
  *  \brief Process gene, exon data
  *
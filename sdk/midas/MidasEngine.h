@@ -71,6 +71,7 @@ public:
    * @param wantNormalized Caller requests normalized exon signals.
    * @param logStabilize Amount to add to data before taking logarithm.
    * @param noLogTransform Do not log transform data.
+   * @param threads Number of threads for the splice detector (0 = one per cpu).
    */
 
   /* Note: the parameters wantPvalues, wantFstats, wantNormalized, and noLogTransform,
@@ -83,7 +84,7 @@ public:
       std::string metaFileName, std::string geneDataFileName, std::string exonDataFileName,
       std::string pvaluesFileName, std::string fstatsFileName, std::string normalizedFileName,
       int wantPvalues, int wantFstats, int wantNormalized, const float& logStabilize,
-      int noLogTransform);
+      int noLogTransform, int threads = 1);
 
   /** Destructor.
    */
@@ -119,6 +120,10 @@ private:
    */
   void processExonData ();
 
+  /** Run the splice detector on the block of pairs, write output
+   */
+  void processBlock ();
+
   /// private data
   /// list of cel_file names used
   const std::vector<std::string> celFiles;
@@ -160,6 +165,8 @@ private:
   const float logStabilize;
   /// caller requests no log transform of data
   const int noLogTransform;
+  /// number of threads for the splice detector
+  const int threads;
   /// SpliceDetector object
   midasSpliceDetector spliceDetector;
   /// number of experimental groups
@@ -170,6 +177,16 @@ private:
   std::map<int, int> geneIdToRowMap;
   /// vector of vectors containing gene data
   std::vector<std::vector<float> > geneData;
+  /// exon data rows read for the block
+  std::vector<std::vector<float> > blockExonData;
+  /// exon data row of each pair in the block
+  std::vector<int> blockExonRows;
+  /// probeset_list id of each pair in the block
+  std::vector<int> blockProbesetListIds;
+  /// gene id of each pair in the block
+  std::vector<int> blockGeneIds;
+  /// gene data of each pair in the block
+  std::vector<const std::vector<float>*> blockGeneData;
   /// fstream for output
   std::ofstream out;
 };
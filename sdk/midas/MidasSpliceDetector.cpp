@@ -41,7 +41,7 @@ using namespace std;
  *  \brief Constructor.
  *
  *  Translates group ids into offsets into list of unique ids,
- *  builds full, reduced design matrices.
+ *  builds and factors full, reduced design matrices.
  *
  *  @param groups Vector of experimental group ids.
  *  @param wantPvalues Caller requests p values.
@@ -65,6 +65,8 @@ midasSpliceDetector::midasSpliceDetector (const std::vector<int>& groups, int wa
   sampleSetup ();
   buildDesignMatrix ();
   buildSampleOnlyDesignMatrix ();
+  factorDesign (fullDesign, fullFactor);
+  factorDesign (reducedDesign, reducedFactor);
 }
 
 // Debug -- print the input values for comparison to the original
@@ -121,45 +123,16 @@ void midasSpliceDetector::runMidasSingle (const std::vector<float>& exonData,
   //dump_vector("exonData",exonData);
   //dump_vector("geneData",geneData);
 
-  // validate vector sizes
-  if (! ( exonData.size() == N && geneData.size() == N && (!wantNormalized || normalizedSignal->size() == N) ))
-    Err::errAbort("midasSpliceDetector: invalid vector sizes");
-
-  // Matlab: use exon level estimates
-  ColumnVector fittedData;
-  double residSsq;
-  double m1Ssq;
-  getEffects (fullDesign, exonData, geneData, fittedData, residSsq, m1Ssq);
-
-  double m2Ssq;
-  double modelSsq;
-  getEffects (reducedDesign, exonData, geneData, fittedData, m2Ssq, modelSsq);
-
-  // residSsq will be zero if the exonData and geneData vectors are identical
-  double myFstat = 0.0;
-  if (residSsq != 0.0)
-    myFstat = modelSsq/residSsq;
-
-  if (wantFstats)
-    *fstat = (float) myFstat;
-
-  if (wantNormalized)
-  {
-    const double maxFitted = fittedData.Maximum();
-    for (unsigned int i = 0; i < N; ++i)
-      (*normalizedSignal)[i] = (float) (fittedData (i+1) - maxFitted);
-  }
-
-  // convert the F statistic to a p value via the cumulative F distribution function
-  if (wantPvalues)
-    *pvalue = (float) affxstat::Ftest (myFstat, dfModel, df1);
+  const vector<float>* pExonData = &exonData;
+  const vector<float>* pGeneData = &geneData;
+  runMidasPairs (&pExonData, &pGeneData, 1, fstat, normalizedSignal, pvalue);
 }
 
 /**
  *  \brief Process multiple exons, single gene data.
  *
- *  Invokes the single exon, gene data runMidas for each
- *  exon in the input vector of vectors.
+ *  Pairs each exon in the input vector of vectors with the
+ *  gene data and runs them as one block.
  *  Produce vector of fstat and pvalue results, vector
  *  of vector of normalizedSignal results.
  *
@@ -184,13 +157,147 @@ void midasSpliceDetector::runMidasMultiple (const std::vector<std::vector<float>
       && (!wantPvalues || pvalue->size() == dataSize) ))
     Err::errAbort("midasSpliceDetector: invalid vector sizes");
 
-  // allow caller to pass a null pointer in the case of unwanted output
+  vector<const vector<float>*> exonBlock (dataSize);
+  vector<const vector<float>*> geneBlock (dataSize, &geneData);
   for (unsigned int i = 0; i < dataSize; ++i)
+    exonBlock[i] = &exonData[i];
+  runMidasBlock (exonBlock, geneBlock, 0, dataSize, fstat, normalizedSignal, pvalue);
+}
+
+/**
+ *  \brief Process a block of exon, gene data pairs.
+ *
+ *  Pair i is exonData[i] with geneData[i]; its results are
+ *  returned in entry i of the fstat, normalizedSignal and pvalue
+ *  vectors.  Only the pairs from start to start + count are run.
+ *
+ *  Errors: call errAbort if the pairs are not all in the exon and
+ *  gene vectors, or if the respective output requested flag is set
+ *  and the output vector does not hold them.
+ *
+ *  @param exonData Exon data, one vector per pair.
+ *  @param geneData Gene data, one vector per pair.
+ *  @param start Index of the first pair of the block.
+ *  @param count Number of pairs in the block.
+ *  @return fstat F statistics as a vector.
+ *  @return normalizedSignal(s) as a vector of vectors.
+ *  @return pvalue P values as a vector.
+*/
+void midasSpliceDetector::runMidasBlock (const std::vector<const std::vector<float>*>& exonData,
+                                         const std::vector<const std::vector<float>*>& geneData,
+                                         int start, int count,
+                                         std::vector<float>* fstat,
+                                         std::vector<std::vector<float> >* normalizedSignal,
+                                         std::vector<float>* pvalue) const
+{
+  const unsigned int end = start + count;
+  if (! ( start >= 0 && count >= 0 && exonData.size() >= end && geneData.size() >= end
+      && (!wantFstats || fstat->size() >= end) && (!wantNormalized || normalizedSignal->size() >= end)
+      && (!wantPvalues || pvalue->size() >= end) ))
+    Err::errAbort("midasSpliceDetector: invalid vector sizes");
+  if (count == 0)
+    return;
+
+  runMidasPairs (&exonData[start], &geneData[start], count,
+                 wantFstats ? &(*fstat)[start] : 0,
+                 wantNormalized ? &(*normalizedSignal)[start] : 0,
+                 wantPvalues ? &(*pvalue)[start] : 0);
+}
+
+/**
+ *  \brief Process pairs of exon, gene data.
+ *
+ *  Matlab: Do a 1-way ANOVA testing for no sample effects.
+ *  The data of all the pairs are fitted at once to each design; the
+ *  arithmetic for each pair is the same as fitting it on its own.
+ *
+ *  Errors: call errAbort if the exon and gene data vectors are not both
+ *  equal in size to the count N of group ids (scans), if a normalizedSignal
+ *  vector is requested and not equal in size to N, or if arguments
+ *  for log() are not positive.
+ *
+ *  @param exonData Exon data, one pointer per pair.
+ *  @param geneData Gene data, one pointer per pair.
+ *  @param count Number of pairs.
+ *  @return fstat F statistics.
+ *  @return normalizedSignal Vectors of normalized exon signals.
+ *  @return pvalue P values.
+*/
+void midasSpliceDetector::runMidasPairs (const std::vector<float>* const* exonData,
+                                         const std::vector<float>* const* geneData,
+                                         int count,
+                                         float* fstat,
+                                         std::vector<float>* normalizedSignal,
+                                         float* pvalue) const
+{
+  // validate vector sizes
+  for (int k = 0; k < count; ++k)
+    if (! ( exonData[k]->size() == N && geneData[k]->size() == N && (!wantNormalized || normalizedSignal[k].size() == N) ))
+      Err::errAbort("midasSpliceDetector: invalid vector sizes");
+
+  // the data, one column per pair; the residuals are returned here
+  vector<double> residuals (N * count);
+  for (unsigned int i = 0; i < N; ++i)
+  {
+    double* row = &residuals[i * count];
+    for (int k = 0; k < count; ++k)
+    {
+      const vector<float>& exon = *exonData[k];
+      const vector<float>& gene = *geneData[k];
+      if (noLogTransform)
+        row[k] = exon[i] - gene[i];
+      else
+      {
+        if ((exon[i] + logStabilize) <= 0 || (gene[i] + logStabilize) <= 0)
+          Err::errAbort("Attempt to take the logarithm of a non-positive number");
+
+        // Matlab: log is actually log + small ... logStabilize (default 8)
+        row[k] = log (exon[i] + logStabilize) - log (gene[i] + logStabilize);
+      }
+    }
+  }
+  vector<double> reducedResiduals (residuals);
+  vector<double> fittedData (N * count);
+
+  // Matlab: use exon level estimates
+  fitBlock (fullFactor, &residuals[0], count, 0);
+  fitBlock (reducedFactor, &reducedResiduals[0], count, &fittedData[0]);
+
+  // residSsq = residuals' * residuals/dfFull;
+  // modelSsq = fittedData'*fittedData/dfModel;
+  const double residScale = 1.0 / (N - fullFactor.cols);
+  const double modelScale = 1.0 / reducedFactor.cols;
+  for (int k = 0; k < count; ++k)
   {
-    float* pFstat = fstat ? &(*fstat)[i] : 0;
-    vector<float>* pNormalizedSignal = normalizedSignal ? &(*normalizedSignal)[i] : 0;
-    float* pPvalue = pvalue ? &(*pvalue)[i] : 0;
-    runMidasSingle (exonData[i], geneData, pFstat, pNormalizedSignal, pPvalue);
+    double residSsq = residuals[k] * residuals[k];
+    double modelSsq = fittedData[k] * fittedData[k];
+    double maxFitted = fittedData[k];
+    for (unsigned int i = 1; i < N; ++i)
+    {
+      residSsq += residuals[i * count + k] * residuals[i * count + k];
+      const double fitted = fittedData[i * count + k];
+      modelSsq += fitted * fitted;
+      if (maxFitted < fitted)
+        maxFitted = fitted;
+    }
+    residSsq *= residScale;
+    modelSsq *= modelScale;
+
+    // residSsq will be zero if the exonData and geneData vectors are identical
+    double myFstat = 0.0;
+    if (residSsq != 0.0)
+      myFstat = modelSsq/residSsq;
+
+    if (wantFstats)
+      fstat[k] = (float) myFstat;
+
+    if (wantNormalized)
+      for (unsigned int i = 0; i < N; ++i)
+        normalizedSignal[k][i] = (float) (fittedData[i * count + k] - maxFitted);
+
+    // convert the F statistic to a p value via the cumulative F distribution function
+    if (wantPvalues)
+      pvalue[k] = (float) affxstat::Ftest (myFstat, dfModel, df1);
   }
 }
 
@@ -306,68 +413,97 @@ void midasSpliceDetector::buildSampleOnlyDesignMatrix ()
 }
 
 /**
- *  \brief Find effects for given design matrix, data.
+ *  \brief Factor a design matrix.
  *
- *  Input: design matrix, vectors of probe and gene data.
- *  Output: fitted data vector (for normalized signal), residual
- *  and model sums of squares, model degrees of freedom.
+ *  The design is fixed for all the exons, so QRZ is run on it once
+ *  here rather than once per exon.  Q, U and the design are kept in
+ *  newmat's storage order for fitBlock.
  *
- *  If so requested by the user, do not log transform the data.
+ *  @param design Design matrix.
+ *  @return factor Factored design.
+*/
+void midasSpliceDetector::factorDesign (const Matrix& design, designFactor& factor)
+{
+  Matrix X = design;	// QRZ destroys input matrices
+  factor.cols = design.Ncols();
+  UpperTriangularMatrix U (factor.cols);
+  QRZ (X, U);
+  factor.design.assign (design.Store(), design.Store() + design.Storage());
+  factor.q.assign (X.Store(), X.Store() + X.Storage());
+  factor.u.assign (U.Store(), U.Store() + U.Storage());
+}
+
+/**
+ *  \brief Fit a block of data to a factored design.
  *
- *  Errors: call errAbort if arguments for log() are negative.
- *  Assume that the vectors are of the appropriate size
- *  (checked in runMidas()).
+ *  Each data column is fitted as the per exon code did with newmat:
+ *  QRZ (X, residuals, M); fit = U.i() * M; fittedData = design * fit;
+ *  The loops follow newmat's order of operations so the results are
+ *  the same to the bit, but run over all the columns at once.
  *
- *  @param design Design matrix.
- *  @param adjExonData Exon data.
- *  @param geneData Gene data.
- *  @return fittedData Column vector containing fitted data.
- *  @return residSsq Residual sum of squares.
- *  @return modelSsq Model sum of squares.
+ *  @param factor Factored design.
+ *  @param data Data, N x count by rows; returned as the residuals.
+ *  @param count Number of data columns.
+ *  @return fittedData Fitted data, N x count by rows, if not NULL.
 */
-void midasSpliceDetector::getEffects (const Matrix& design,
-                                      const std::vector<float>& exonData,
-                                      const std::vector<float>& geneData,
-                                      ColumnVector& fittedData,
-                                      double& residSsq,
-                                      double& modelSsq)
+void midasSpliceDetector::fitBlock (const designFactor& factor,
+                                    double* data,
+                                    int count,
+                                    double* fittedData) const
 {
-  ColumnVector residuals (N);	// residuals are returned here
-  for (unsigned int i = 0; i < N; ++i)
+  const int cols = factor.cols;
+  vector<double> fit (cols * count, 0.0);
+
+  // QRZ (X, residuals, M): take out one column of Q at a time.
+  for (int j = 0; j < cols; ++j)
   {
-    if (noLogTransform)
-      residuals (i+1) = exonData[i] - geneData[i];
-    else
+    double* m = &fit[j * count];
+    for (unsigned int i = 0; i < N; ++i)
     {
-        if ((exonData[i] + logStabilize) <= 0 || (geneData[i] + logStabilize) <= 0)
-            Err::errAbort("Attempt to take the logarithm of a non-positive number");
-
-        // Matlab: log is actually log + small ... logStabilize (default 8)
-        residuals (i+1) = log (exonData[i] + logStabilize) - log (geneData[i] + logStabilize);
+      const double q = factor.q[i * cols + j];
+      const double* row = data + i * count;
+      for (int k = 0; k < count; ++k)
+        m[k] += q * row[k];
+    }
+    for (unsigned int i = 0; i < N; ++i)
+    {
+      const double q = factor.q[i * cols + j];
+      double* row = data + i * count;
+      for (int k = 0; k < count; ++k)
+        row[k] -= m[k] * q;
     }
   }
+  if (fittedData == 0)
+    return;
 
-  // fit = design\(pData-gData);
-  Matrix X = design;	// QRZ destroys input matrices
-  const int dfModel = design.Ncols();
-  UpperTriangularMatrix U (dfModel);
-  Matrix M (dfModel, 1);
-  QRZ (X, U);
-  QRZ (X, residuals, M);
-  Matrix fit = U.i() * M;
-
-  // fittedData=design*fit;
-  fittedData = design * fit;
-  // residuals = pData - gData - fittedData;
-  // residuals have already been calculated by QRZ
-
-  // dfModel = rank(design);
-  // dfFull = (length(gData) - dfModel);
-  // residSsq = residuals' * residuals/dfFull;
-  Matrix Ssq = (residuals.t() * residuals) / (N - dfModel);
-  residSsq = Ssq (1,1);	// can't directly read product into a double
+  // fit = U.i() * M: back substitution, summing from the last column.
+  for (int k = 0; k < count; ++k)
+  {
+    for (int r = cols - 1; r >= 0; --r)
+    {
+      const double* u = &factor.u[r * cols - (r * (r - 1)) / 2];	// U (r, r)
+      double sum = 0.0;
+      for (int c = cols - 1; c > r; --c)
+        sum += u[c - r] * fit[c * count + k];
+      fit[r * count + k] = (fit[r * count + k] - sum) / u[0];
+    }
+  }
 
-  // modelSsq = fittedData'*fittedData/dfModel;
-  Ssq = (fittedData.t() * fittedData) / dfModel;
-  modelSsq = Ssq (1,1);
+  // fittedData = design * fit;
+  for (unsigned int i = 0; i < N; ++i)
+  {
+    double* row = fittedData + i * count;
+    if (cols == 0)
+    {
+      for (int k = 0; k < count; ++k)
+        row[k] = 0.0;
+      continue;
+    }
+    const double* d = &factor.design[i * cols];
+    for (int k = 0; k < count; ++k)
+      row[k] = d[0] * fit[k];
+    for (int j = 1; j < cols; ++j)
+      for (int k = 0; k < count; ++k)
+        row[k] += d[j] * fit[j * count + k];
+  }
 }
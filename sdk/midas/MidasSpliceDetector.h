@@ -75,6 +75,10 @@
  *  Here also, output is returned by reference to lvalues allocated
  *  by the caller.
  *
+ *  For processing many exons, runMidasBlock takes a block of exon and
+ *  gene data pairs and fits them all at once.  The design matrices
+ *  depend only on the groups, so the constructor factors them once.
+ *
  *  The caller may choose not to receive one or more of the outputs;
  *  this is signaled by flags passed to the constructor.
  */
@@ -129,8 +133,43 @@ public:
                          std::vector<std::vector<float> >* normalizedSignal,
                          std::vector<float>* pvalue);
 
+  /** Calculates stats on a block of exon, gene data pairs at once.
+   *  The designs are factored once by the constructor and the block
+   *  is fitted as matrix-matrix products. No newmat objects are used,
+   *  so several threads may run blocks on the same detector.
+   * @param exonData         Exon data, one vector per pair.
+   * @param geneData         Gene data, one vector per pair.
+   * @param start            Index of the first pair of the block.
+   * @param count            Number of pairs in the block.
+   * @param fstat            returned F statistics, indexed as exonData
+   * @param normalizedSignal returned normalized exon signal, indexed as exonData
+   * @param pvalue           returned P values, indexed as exonData
+   */
+  void runMidasBlock (const std::vector<const std::vector<float>*>& exonData,
+                      const std::vector<const std::vector<float>*>& geneData,
+                      int start, int count,
+                      std::vector<float>* fstat,
+                      std::vector<std::vector<float> >* normalizedSignal,
+                      std::vector<float>* pvalue) const;
+
 private:
 
+  /**
+   *  A design matrix factored by QRZ.  Kept in newmat's storage
+   *  order so that fitBlock repeats the arithmetic of a per exon fit.
+   */
+  struct designFactor
+  {
+    /// number of columns of the design
+    int cols;
+    /// design, N x cols by rows
+    std::vector<double> design;
+    /// orthonormal Q of the design, N x cols by rows
+    std::vector<double> q;
+    /// upper triangular U of the design, packed by rows
+    std::vector<double> u;
+  };
+
   /** Sets up sample (group) offsets into unique list of ids.
    */
   void sampleSetup ();
@@ -143,20 +182,37 @@ private:
    */
   void buildSampleOnlyDesignMatrix ();
 
-  /** Finds effects for given design matrix, data.
+  /** Factors a design matrix.
    * @param design        Design matrix.
-   * @param adjExonData   Exon data.
-   * @param geneData      Gene data.
-   * @param fittedData    Column vector containing fitted data.
-   * @param residSsq      Residual sum of squares.
-   * @param modelSsq      Model sum of squares.
+   * @param factor        Returned factorization.
+   */
+  void factorDesign (const Matrix& design, designFactor& factor);
+
+  /** Calculates stats on pairs of exon, gene data.
+   * @param exonData         Exon data, one pointer per pair.
+   * @param geneData         Gene data, one pointer per pair.
+   * @param count            Number of pairs.
+   * @param fstat            returned F statistics, or NULL
+   * @param normalizedSignal returned normalized exon signal, or NULL
+   * @param pvalue           returned P values, or NULL
+   */
+  void runMidasPairs (const std::vector<float>* const* exonData,
+                      const std::vector<float>* const* geneData,
+                      int count,
+                      float* fstat,
+                      std::vector<float>* normalizedSignal,
+                      float* pvalue) const;
+
+  /** Fits a block of data to a factored design.
+   * @param factor        Factored design matrix.
+   * @param data          Data, N x count by rows; returned as the residuals.
+   * @param count         Number of data columns.
+   * @param fittedData    Returned fitted data, N x count by rows, or NULL.
    */
-  void getEffects (const Matrix& design,
-                   const std::vector<float>& exonData,
-                   const std::vector<float>& geneData,
-                   ColumnVector& fittedData, 
-                   double& residSsq,
-                   double& modelSsq);
+  void fitBlock (const designFactor& factor,
+                 double* data,
+                 int count,
+                 double* fittedData) const;
 
   /// private data
   /// experimental groups
@@ -185,6 +241,10 @@ private:
   Matrix reducedDesign;
   /// rank of reduced design matrix
   double dfModel;
+  /// factored full design matrix
+  designFactor fullFactor;
+  /// factored reduced design matrix
+  designFactor reducedFactor;
 };
 
 #endif /* MIDASSPLICEDETECTOR_H */
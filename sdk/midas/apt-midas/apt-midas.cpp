@@ -88,7 +88,8 @@ int main (int argc, char* argv[])
         midasConfigureRun configureRun ( opts.get("cel-files"), opts.get("genedata"),
                                         opts.get("exondata"), opts.get("metaprobeset"),  opts.get("out-dir"),
                                         wantPvalues, wantFstats, wantNormalized, opts.getDouble("stabilize"),
-                                        opts.commandLine(), execVersion, opts.getBool("no-logtrans"), opts.getBool("keep-path") );
+                                        opts.commandLine(), execVersion, opts.getBool("no-logtrans"), opts.getBool("keep-path"),
+                                        opts.getInt("threads") );
         // configure step may return a non-fatal warning message
         std::string* msg = configureRun.configure();
         if (msg)
@@ -131,9 +131,9 @@ inline int CompareV(double *VA, double *VB, long VLength)
 
 inline void HeapMatrix(double **Vector, long *Rank, long ListSize, long VLength, long start)
 {
-static	long notdone;
-static	long left, right, largest, current;
-static	long tmprank;
+	long notdone;
+	long left, right, largest, current;
+	long tmprank;
 	// object at start has been put on the appropriate subheap
 	// propagate it down the heap as required
 	current = start;
@@ -173,8 +173,8 @@ static	long tmprank;
 
 inline int HeapIndexMatrix(double **Matrix, long *Rank, long ListSize, long VLength)
 {
-static	long i;
-static	long tmprank;
+	long i;
+	long tmprank;
 	// provides a rank vector to go with an array by using heapsort
 	// all vectors must be allocated beforehand
 	for (i=0; i<ListSize; i++)
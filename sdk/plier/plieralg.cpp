@@ -197,20 +197,11 @@ long FitAdditiveModel(plier_data *pData, double *TargetResponse, double *Feature
 	long ValSize;
 
 	long nSize = pData->m_nAnalyses*pData->m_nFeatures;
-  // this wont be freed at the end of the program.
-  static double *Val = NULL;
-  static int memSize = 0;
-
-  if(nSize > memSize) {
-    // free before reallocating
-    delete[] Val;
-    // now realloc scratch space
-    Val = new double [nSize];
-    if (Val == 0) {
-      return NO_DATAMEM;
-    }
-    // remember the size.
-    memSize = nSize;
+  // scratch space. (Not a static buffer as plier may be run on
+  // several threads at once.)
+  double *Val = new double [nSize];
+  if (Val == 0) {
+    return NO_DATAMEM;
   }
 
 // 	Rank = new long [nSize]; // scratch space for rank
@@ -315,7 +306,7 @@ long FitAdditiveModel(plier_data *pData, double *TargetResponse, double *Feature
 		}
 	}
 
-	   //	delete[] Val;
+	delete[] Val;
 	   //	delete[] Rank;
 
 	if (iter==pData->m_algParams->seaiteration && ssq>ssqlimit)
@@ -30,6 +30,7 @@
 //
 #include <cmath>
 #include <cstring>
+#include <ctime>
 #include <string>
 //
 #define EVEN 10
@@ -73,6 +74,8 @@ class RMATest : public CppUnit::TestFixture {
   CPPUNIT_TEST( testBackgroundCorrect );
   CPPUNIT_TEST( testMedianPolishPsetFromMatrix );
   CPPUNIT_TEST( testMedianPolishWithPrecomputedEffects );
+  CPPUNIT_TEST( testMedianPolishContiguous );
+  CPPUNIT_TEST( testMedianPolishTiming );
   CPPUNIT_TEST_SUITE_END();
 
 public:
@@ -99,6 +102,10 @@ public:
   void fillInDoubleVectorMatrix(vector< vector<float> > &matrix);
   void testMedianPolishPsetFromMatrix();
   void testMedianPolishWithPrecomputedEffects();
+  void testMedianPolishContiguous();
+  void testMedianPolishTiming();
+  static void fillInRandomMatrix(vector< vector<float> > &matrix, int numRow, int numCol, unsigned int seed);
+  static void matrixToContiguous(vector< vector<float> > &matrix, vector<float> &contig);
   static bool closeEnough(double d1, double d2, int digits=6);
   /* Big wad of normal test data. */
   double goldTestGauss[1024];
@@ -304,6 +311,109 @@ void RMATest::testMedianPolishPsetFromMatrix() {
   }
 }
 
+/** Log normalish intensities from a small lcg so runs are repeatable. */
+void RMATest::fillInRandomMatrix(vector< vector<float> > &matrix, int numRow, int numCol, unsigned int seed) {
+  matrix.assign(numRow, vector<float>(numCol));
+  for(int rowIx = 0; rowIx < numRow; rowIx++) {
+    for(int colIx = 0; colIx < numCol; colIx++) {
+      seed = seed * 1103515245 + 12345;
+      float u = (float)((seed >> 8) & 0xffff) / 65536.0f;
+      matrix[rowIx][colIx] = 20.0f + 100.0f * (rowIx % 7 + 1) * (colIx % 5 + 1) * (u + 0.05f);
+    }
+  }
+}
+
+void RMATest::matrixToContiguous(vector< vector<float> > &matrix, vector<float> &contig) {
+  contig.clear();
+  for(int rowIx = 0; rowIx < matrix.size(); rowIx++)
+    contig.insert(contig.end(), matrix[rowIx].begin(), matrix[rowIx].end());
+}
+
+/** The contiguous median polish has to give the same answers as the original. */
+void RMATest::testMedianPolishContiguous() {
+  int rows[] = { 1, 2, 11, 100, 333 };
+  int cols[] = { 1, 4, 7, 12, 25, 40 };
+  vector<float> work;
+  for(int r = 0; r < sizeof(rows)/sizeof(rows[0]); r++) {
+    for(int c = 0; c < sizeof(cols)/sizeof(cols[0]); c++) {
+      int numRow = rows[r], numCol = cols[c];
+      vector< vector<float> > data, residuals;
+      vector<float> contig, colEst, rowEst;
+      fillInRandomMatrix(data, numRow, numCol, numRow * 100 + numCol);
+
+      /* Plain median polish. */
+      residuals = data;
+      matrixToContiguous(data, contig);
+      RMA::medianPolishPsetFromMatrix(residuals, numRow, numCol, colEst, rowEst);
+      vector<float> colFast(numCol), rowFast(numRow);
+      RMA::medianPolishPsetFromMatrix(&contig[0], numRow, numCol, &colFast[0], &rowFast[0], work);
+      for(int i = 0; i < numCol; i++)
+        CPPUNIT_ASSERT( colEst[i] == colFast[i] );
+      for(int i = 0; i < numRow; i++)
+        CPPUNIT_ASSERT( rowEst[i] == rowFast[i] );
+      for(int i = 0; i < numRow; i++)
+        for(int j = 0; j < numCol; j++)
+          CPPUNIT_ASSERT( residuals[i][j] == contig[i * numCol + j] );
+
+      /* Seeded with the feature effects just found. */
+      vector<float> seed = colEst, seedFast = colEst;
+      residuals = data;
+      matrixToContiguous(data, contig);
+      RMA::medianPolishWithPrecomputedEffectsUsedAsSeedValues(residuals, numRow, numCol, seed, rowEst);
+      RMA::medianPolishWithPrecomputedEffectsUsedAsSeedValues(&contig[0], numRow, numCol, &seedFast[0], &rowFast[0], work);
+      for(int i = 0; i < numCol; i++)
+        CPPUNIT_ASSERT( seed[i] == seedFast[i] );
+      for(int i = 0; i < numRow; i++)
+        CPPUNIT_ASSERT( rowEst[i] == rowFast[i] );
+
+      /* One pass with fixed feature effects. */
+      residuals = data;
+      matrixToContiguous(data, contig);
+      RMA::medianPolishWithPrecomputedEffectsOnePass(residuals, numRow, numCol, colEst, rowEst);
+      RMA::medianPolishWithPrecomputedEffectsOnePass(&contig[0], numRow, numCol, &colEst[0], &rowFast[0], work);
+      for(int i = 0; i < numRow; i++)
+        CPPUNIT_ASSERT( rowEst[i] == rowFast[i] );
+    }
+  }
+}
+
+/** Probesets of 4-40 probes over 100-10,000 chips, old against new. */
+void RMATest::testMedianPolishTiming() {
+  int chips[] = { 100, 1000, 10000 };
+  int probes[] = { 4, 11, 25, 40 };
+  vector<float> work;
+  for(int c = 0; c < sizeof(chips)/sizeof(chips[0]); c++) {
+    for(int p = 0; p < sizeof(probes)/sizeof(probes[0]); p++) {
+      int numRow = chips[c], numCol = probes[p];
+      int reps = 200000 / (numRow * numCol) + 1;
+      vector< vector<float> > data, residuals;
+      vector<float> contig, colEst, rowEst;
+      vector<float> colFast(numCol), rowFast(numRow);
+      fillInRandomMatrix(data, numRow, numCol, 17);
+      double sum = 0;
+
+      clock_t start = clock();
+      for(int i = 0; i < reps; i++) {
+        residuals = data;
+        RMA::medianPolishPsetFromMatrix(residuals, numRow, numCol, colEst, rowEst);
+        sum += rowEst[0];
+      }
+      double oldTime = (double)(clock() - start) / CLOCKS_PER_SEC;
+
+      start = clock();
+      for(int i = 0; i < reps; i++) {
+        matrixToContiguous(data, contig);
+        RMA::medianPolishPsetFromMatrix(&contig[0], numRow, numCol, &colFast[0], &rowFast[0], work);
+        sum -= rowFast[0];
+      }
+      double newTime = (double)(clock() - start) / CLOCKS_PER_SEC;
+      CPPUNIT_ASSERT( sum == 0 );
+      Verbose::out(1, "median polish " + ToStr(numCol) + " probes x " + ToStr(numRow) + " chips x " + ToStr(reps) +
+                   ": vector of vectors " + ToStr(oldTime) + "s contiguous " + ToStr(newTime) + "s");
+    }
+  }
+}
+
 void RMATest::testBgParam() {
   double gold[] = {3.04743393238322,-0.0352978726152391,1.49083778699003};
   double mu = 0, sigma = 0, alpha = 0;
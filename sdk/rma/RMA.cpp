@@ -452,6 +452,232 @@ void RMA::medianPolishWithPrecomputedEffectsUsedAsSeedValues(vector< vector<floa
   }
 
 
+/** 
+ * Median of count values, reordering them. Same answer as median()
+ * from stats/stats.h.
+ * 
+ * @param dat - values, reordered in place.
+ * @param count - number of values.
+ * @return median of the values.
+ */
+float RMA::medianInPlace(float *dat, int count) {
+  assert(count > 0);
+  int half = (count - 1) / 2;
+  /* Probesets are small, a straight insertion sort beats selection. */
+  if(count <= 32) {
+    for(int i = 1; i < count; i++) {
+      float val = dat[i];
+      int j = i;
+      for(; j > 0 && val < dat[j - 1]; j--)
+        dat[j] = dat[j - 1];
+      dat[j] = val;
+    }
+    if(count % 2 == 1)
+      return dat[half];
+    return (dat[half] + dat[half + 1]) / 2;
+  }
+  nth_element(dat, dat + half, dat + count);
+  if(count % 2 == 1)
+    return dat[half];
+  /* The other middle value is the smallest of the upper part. */
+  float upper = *min_element(dat + half + 1, dat + count);
+  return (dat[half] + upper) / 2;
+}
+
+/** 
+ * log2() a contiguous matrix in place.
+ * @param pmMatrix - matrix.
+ * @param count - number of values in the matrix.
+ * @param caller - who to blame in the error message.
+ */
+static void contigLog2(float *pmMatrix, int count, const char *caller) {
+  float log_2=logf(2.0);
+  for(int i = 0; i < count; i++) {
+    if(pmMatrix[i] <= 0.0) {
+      Err::errAbort(std::string("RMA::") + caller + ". Values must be strictly positive. ");
+    }
+    pmMatrix[i] = logf(pmMatrix[i])/log_2;
+  }
+}
+
+/** 
+ * Fill in the median of each column of a contiguous matrix.
+ * @param pmMatrix - matrix.
+ * @param numRow - number of rows.
+ * @param numCol - number of columns.
+ * @param colEffect - filled in with numCol medians.
+ * @param sel - scratch for numRow values.
+ */
+static void contigColEffect(const float *pmMatrix, int numRow, int numCol, float *colEffect, float *sel) {
+  for(int colIx = 0; colIx < numCol; colIx++) {
+    const float *p = pmMatrix + colIx;
+    for(int rowIx = 0; rowIx < numRow; rowIx++, p += numCol)
+      sel[rowIx] = *p;
+    colEffect[colIx] = RMA::medianInPlace(sel, numRow);
+  }
+}
+
+/** 
+ * Subtract colEffect from each row of a contiguous matrix.
+ * @param pmMatrix - matrix.
+ * @param numRow - number of rows.
+ * @param numCol - number of columns.
+ * @param colEffect - values to subtract from each column.
+ */
+static void contigSubColEffect(float *pmMatrix, int numRow, int numCol, const float *colEffect) {
+  for(int rowIx = 0; rowIx < numRow; rowIx++) {
+    float *row = pmMatrix + (size_t)rowIx * numCol;
+    for(int colIx = 0; colIx < numCol; colIx++)
+      row[colIx] = row[colIx] - colEffect[colIx];
+  }
+}
+
+/** 
+ * Fill in the median of each row of a contiguous matrix and subtract it off.
+ * @param pmMatrix - matrix.
+ * @param numRow - number of rows.
+ * @param numCol - number of columns.
+ * @param rowEffect - filled in with numRow medians.
+ * @param sel - scratch for numCol values.
+ */
+static void contigSubRowEffect(float *pmMatrix, int numRow, int numCol, float *rowEffect, float *sel) {
+  for(int rowIx = 0; rowIx < numRow; rowIx++) {
+    float *row = pmMatrix + (size_t)rowIx * numCol;
+    for(int colIx = 0; colIx < numCol; colIx++)
+      sel[colIx] = row[colIx];
+    float effect = RMA::medianInPlace(sel, numCol);
+    for(int colIx = 0; colIx < numCol; colIx++)
+      row[colIx] = row[colIx] - effect;
+    rowEffect[rowIx] = effect;
+  }
+}
+
+/** 
+ * Sum of the absolute values of a contiguous matrix.
+ * @param pmMatrix - matrix.
+ * @param count - number of values.
+ * @return sum of absolute values.
+ */
+static double contigAbsSum(const float *pmMatrix, int count) {
+  double sum = 0.0;
+  for(int i = 0; i < count; i++)
+    sum += fabs(pmMatrix[i]);
+  return sum;
+}
+
+/** 
+ * The iterations shared by the contiguous median polish versions. If
+ * seedCols is not NULL it is used instead of the column medians on the
+ * first iteration.
+ */
+static void medianPolishContiguous(float *pmMatrix, int numRow, int numCol,
+                                   const float *seedCols,
+                                   float *colEstimates, float *rowEstimates,
+                                   vector<float> &work) {
+  int maxDim = max(numRow, numCol);
+  work.resize(numCol + numRow + 2 * maxDim);
+  float *colEffect = &work[0];
+  float *rowEffect = colEffect + numCol;
+  float *workBuff = rowEffect + numRow;
+  float *sel = workBuff + maxDim;
+  float totalEffect = 0;
+  int maxIter = 10; // How many iterations to do. 
+  double epsilon = 0.01;
+  double oldSum = 0.0, newSum = 0.0;
+  float delta = 0.0;
+  int i = 0;
+
+  for(i = 0; i < numCol; i++)
+    colEffect[i] = 0;
+  for(i = 0; i < numRow; i++)
+    rowEffect[i] = 0;
+
+  for(int iterIx = 0; iterIx < maxIter; iterIx++) {
+    // Do the columns
+    if(iterIx == 0 && seedCols != NULL) {
+      for(i = 0; i < numCol; i++)
+        workBuff[i] = seedCols[i];
+    }
+    else {
+      contigColEffect(pmMatrix, numRow, numCol, workBuff, sel);
+    }
+    contigSubColEffect(pmMatrix, numRow, numCol, workBuff);
+    for(i = 0; i < numCol; i++) 
+      colEffect[i] += workBuff[i];
+
+    for(i = 0; i < numRow; i++)
+      sel[i] = rowEffect[i];
+    delta = RMA::medianInPlace(sel, numRow);
+    for(i = 0; i < numRow; i++) 
+      rowEffect[i] -= delta;
+    totalEffect += delta;
+
+    // Do the rows    
+    contigSubRowEffect(pmMatrix, numRow, numCol, workBuff, sel);
+    for(i = 0; i < numRow; i++) 
+      rowEffect[i] += workBuff[i];
+
+    for(i = 0; i < numCol; i++)
+      sel[i] = colEffect[i];
+    delta = RMA::medianInPlace(sel, numCol);
+    for(i = 0; i < numCol; i++) 
+      colEffect[i] -= delta;
+    totalEffect += delta;
+
+    // Check for convergance.
+    newSum = contigAbsSum(pmMatrix, numRow * numCol);
+    if(newSum == 0 || fabs(newSum - oldSum) < epsilon  * newSum) 
+      break;
+    oldSum = newSum;
+  }
+
+  /* data to return. */
+  for(i = 0; i < numCol; i++)
+    colEstimates[i] = totalEffect + colEffect[i];
+  for(i = 0; i < numRow; i++)
+    rowEstimates[i] = totalEffect + rowEffect[i];
+}
+
+void RMA::medianPolishPsetFromMatrix(float *pmMatrix, int numRow, int numCol,
+                                     float *colEstimates, float *rowEstimates,
+                                     vector<float> &work, bool doLog) {
+  assert(numRow > 0 && numCol > 0);
+  if(doLog)
+    contigLog2(pmMatrix, numRow * numCol, "medianPolishPSetFromMatrix");
+  medianPolishContiguous(pmMatrix, numRow, numCol, NULL, colEstimates, rowEstimates, work);
+}
+
+void RMA::medianPolishWithPrecomputedEffectsUsedAsSeedValues(float *pmMatrix, int numChips, int numProbes,
+                                                             float *colEstimates, float *rowEstimates,
+                                                             vector<float> &work, bool doLog) {
+  assert(numChips > 0 && numProbes > 0);
+  if(doLog)
+    contigLog2(pmMatrix, numChips * numProbes, "medianPolishWithPrecomputedEffectsUsedAsSeedValues");
+  medianPolishContiguous(pmMatrix, numChips, numProbes, colEstimates, colEstimates, rowEstimates, work);
+}
+
+void RMA::medianPolishWithPrecomputedEffectsOnePass(float *pmMatrix, int numChips, int numProbes,
+                                                    const float *colEstimates, float *rowEstimates,
+                                                    vector<float> &work, bool doLog) {
+  assert(numChips > 0 && numProbes > 0);
+  if(doLog)
+    contigLog2(pmMatrix, numChips * numProbes, "medianPolishWithPrecomputedEffectsOnePass");
+  work.resize(numProbes);
+  contigSubColEffect(pmMatrix, numChips, numProbes, colEstimates);
+  for(int rowIx = 0; rowIx < numChips; rowIx++) {
+    float *row = pmMatrix + (size_t)rowIx * numProbes;
+    for(int colIx = 0; colIx < numProbes; colIx++)
+      work[colIx] = row[colIx];
+    rowEstimates[rowIx] = medianInPlace(&work[0], numProbes);
+  }
+  for(int colIx = 0; colIx < numProbes; colIx++)
+    work[colIx] = colEstimates[colIx];
+  float delta = medianInPlace(&work[0], numProbes);
+  for(int rowIx = 0; rowIx < numChips; rowIx++)
+    rowEstimates[rowIx] += delta;
+}
+
+
 /** 
  * Compute the mean of a given vector.
  * sum(column)/n
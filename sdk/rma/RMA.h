@@ -158,6 +158,74 @@ static inline void medianPolish(std::vector< std::vector<float> > &pmMatrix,
                                                                  std::vector<float> &rowEstimates, 
                                                                  bool doLog = true);
 
+/** 
+ * Median polish on one contiguous row major matrix (element [row,col]
+ * at pmMatrix[row * numCol + col]). Same algorithm and same results as
+ * the std::vector< std::vector<float> > version above, but the medians
+ * are found by selection in a reusable work buffer rather than with a
+ * copy per row/column so nothing is allocated per iteration once the
+ * work buffer has grown. Callers running on several threads each need
+ * their own work buffer.
+ * 
+ * @param pmMatrix - numRow * numCol matrix, residuals filled in here.
+ * @param numRow - Number of rows in the matrix.
+ * @param numCol - Number of columns in the matrix.
+ * @param colEstimates - Filled in with numCol feature effects.
+ * @param rowEstimates - Filled in with numRow target effects.
+ * @param work - Scratch space, resized as needed.
+ * @param doLog - Take log2 of the matrix first?
+ */
+static void medianPolishPsetFromMatrix(float *pmMatrix, int numRow, int numCol,
+                                       float *colEstimates, float *rowEstimates,
+                                       std::vector<float> &work,
+                                       bool doLog = true);
+
+/** 
+ * Contiguous version of medianPolishWithPrecomputedEffectsUsedAsSeedValues(),
+ * see medianPolishPsetFromMatrix(float *, ...) for the layout.
+ * 
+ * @param pmMatrix - numChips * numProbes matrix, residuals filled in here.
+ * @param numChips - Number of rows in the matrix.
+ * @param numProbes - Number of columns in the matrix.
+ * @param colEstimates - Precomputed feature effects on input, fitted ones on output.
+ * @param rowEstimates - Filled in with numChips target effects.
+ * @param work - Scratch space, resized as needed.
+ * @param doLog - Take log2 of the matrix first?
+ */
+static void medianPolishWithPrecomputedEffectsUsedAsSeedValues(float *pmMatrix, int numChips, int numProbes,
+                                                               float *colEstimates, float *rowEstimates,
+                                                               std::vector<float> &work,
+                                                               bool doLog = true);
+
+/** 
+ * Contiguous version of medianPolishWithPrecomputedEffectsOnePass(),
+ * see medianPolishPsetFromMatrix(float *, ...) for the layout.
+ * 
+ * @param pmMatrix - numChips * numProbes matrix, residuals filled in here.
+ * @param numChips - Number of rows in the matrix.
+ * @param numProbes - Number of columns in the matrix.
+ * @param colEstimates - The precomputed feature effects.
+ * @param rowEstimates - Filled in with numChips target effects.
+ * @param work - Scratch space, resized as needed.
+ * @param doLog - Take log2 of the matrix first?
+ */
+static void medianPolishWithPrecomputedEffectsOnePass(float *pmMatrix, int numChips, int numProbes,
+                                                      const float *colEstimates, float *rowEstimates,
+                                                      std::vector<float> &work,
+                                                      bool doLog = true);
+
+/** 
+ * Median of count values, reordering them. Gives the same answer as
+ * median() from stats/stats.h (mean of the middle two for an even
+ * count) without the copy. Small counts (the usual probeset size) are
+ * insertion sorted, larger ones use nth_element().
+ * 
+ * @param dat - values, reordered in place.
+ * @param count - number of values.
+ * @return median of the values.
+ */
+static float medianInPlace(float *dat, int count);
+
   /** 
    * Find the minimum value in a vector.
    * 
@@ -0,0 +1,180 @@
+////////////////////////////////////////////////////////////////
+//
+// Copyright (C) 2011 Affymetrix, Inc.
+//
+// This library is free software; you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License
+// (version 2.1) as published by the Free Software Foundation.
+//
+// This library is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+// or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License
+// for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this library; if not, write to the Free Software Foundation, Inc.,
+// 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+//
+////////////////////////////////////////////////////////////////
+
+/**
+ * @file   NumFormatTest.cpp
+ *
+ * @brief  Testing that NumFormat writes what the ostreams write.
+ */
+
+//
+#include "util/NumFormat.h"
+#include "util/Verbose.h"
+//
+#include <cppunit/CompilerOutputter.h>
+#include <cppunit/extensions/HelperMacros.h>
+#include <cppunit/extensions/TestFactoryRegistry.h>
+#include <cppunit/ui/text/TestRunner.h>
+//
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <sstream>
+#include <string>
+
+using namespace std;
+
+/**
+ * @class NumFormatTest
+ * @brief cppunit class for testing the number formatting.
+ */
+class NumFormatTest : public CppUnit::TestFixture
+{
+  CPPUNIT_TEST_SUITE( NumFormatTest );
+  CPPUNIT_TEST( testInt );
+  CPPUNIT_TEST( testFixedSpecial );
+  CPPUNIT_TEST( testFixedRandom );
+  CPPUNIT_TEST( testShortest );
+  CPPUNIT_TEST_SUITE_END();
+
+public:
+  /** Integers against ostream. */
+  void testInt();
+  /** Halfway, signed zero, huge, nan and inf values. */
+  void testFixedSpecial();
+  /** Random doubles and precisions against ostream. */
+  void testFixedRandom();
+  /** Shortest text reads back as the same value. */
+  void testShortest();
+};
+
+// Registers the fixture into the 'registry'
+CPPUNIT_TEST_SUITE_REGISTRATION( NumFormatTest );
+
+/// xorshift; the same numbers on every platform.
+static uint64_t NumFormatTest_rand(uint64_t& state) {
+  state^=state<<13;
+  state^=state>>7;
+  state^=state<<17;
+  return state;
+}
+
+/// A double with random bits, or one with few digits.
+static double NumFormatTest_double(uint64_t& state) {
+  uint64_t bits=NumFormatTest_rand(state);
+  double val;
+  switch (bits%4) {
+  case 0:
+    memcpy(&val,&bits,sizeof(val));
+    return val;
+  case 1:
+    return (double)((int64_t)(bits%2000001)-1000000)/1000.0;
+  case 2:
+    return (float)((double)(bits%100000000)/10000.0-5000.0);
+  default:
+    return ldexp((double)(bits>>11),-(int)(NumFormatTest_rand(state)%80));
+  }
+}
+
+static string ostreamFixed(double val,int prec) {
+  ostringstream stream;
+  stream.setf(ios::fixed,ios::floatfield);
+  stream.precision(prec);
+  stream << val;
+  return stream.str();
+}
+
+void NumFormatTest::testInt() {
+  Verbose::out(1, "NumFormatTest::testInt");
+  uint64_t state=88172645463325252ULL;
+  for (int i=0;i<100000;i++) {
+    int64_t val=(int64_t)NumFormatTest_rand(state);
+    // shift some to small values.
+    val>>=(i%64);
+    ostringstream s64,s32,su;
+    s64 << val;
+    s32 << (int)val;
+    su << (uint64_t)val;
+    string str;
+    NumFormat::appendInt64(str,val);
+    CPPUNIT_ASSERT( str == s64.str() );
+    str.clear();
+    NumFormat::appendInt(str,(int)val);
+    CPPUNIT_ASSERT( str == s32.str() );
+    str.clear();
+    NumFormat::appendUInt64(str,(uint64_t)val);
+    CPPUNIT_ASSERT( str == su.str() );
+  }
+  string str;
+  NumFormat::appendInt64(str,numeric_limits<int64_t>::min());
+  CPPUNIT_ASSERT( str == "-9223372036854775808" );
+  str.clear();
+  NumFormat::appendInt(str,0);
+  CPPUNIT_ASSERT( str == "0" );
+}
+
+void NumFormatTest::testFixedSpecial() {
+  Verbose::out(1, "NumFormatTest::testFixedSpecial");
+  double vals[]={0.0,-0.0,0.5,1.5,2.5,-0.5,0.125,0.05,0.15,0.25,0.35,
+                 1.005,2.675,1e-7,-1e-7,1e15,9e15,1e16,1e300,-1e300,
+                 numeric_limits<double>::denorm_min(),
+                 numeric_limits<double>::max(),
+                 numeric_limits<double>::infinity(),
+                 -numeric_limits<double>::infinity()};
+  for (int prec=-2;prec<30;prec++) {
+    for (int i=0;i<(int)(sizeof(vals)/sizeof(vals[0]));i++) {
+      CPPUNIT_ASSERT( NumFormat::fixedToStr(vals[i],prec) == ostreamFixed(vals[i],prec) );
+    }
+  }
+  CPPUNIT_ASSERT( NumFormat::fixedToStr(2.5,0) == "2" );
+  CPPUNIT_ASSERT( NumFormat::fixedToStr(-0.0001,2) == "-0.00" );
+  CPPUNIT_ASSERT( NumFormat::fixedToStr(3.14159,-1) == "3.141590" );
+}
+
+void NumFormatTest::testFixedRandom() {
+  Verbose::out(1, "NumFormatTest::testFixedRandom");
+  uint64_t state=2463534242ULL;
+  string str;
+  for (int i=0;i<500000;i++) {
+    double val=NumFormatTest_double(state);
+    int prec=(int)(NumFormatTest_rand(state)%12);
+    // appends to what is there.
+    str="x";
+    NumFormat::appendFixed(str,val,prec);
+    CPPUNIT_ASSERT( str == "x"+ostreamFixed(val,prec) );
+  }
+}
+
+void NumFormatTest::testShortest() {
+  Verbose::out(1, "NumFormatTest::testShortest");
+  CPPUNIT_ASSERT( NumFormat::shortestToStr(0.1) == "0.1" );
+  CPPUNIT_ASSERT( NumFormat::shortestToStr(100) == "100" );
+  CPPUNIT_ASSERT( NumFormat::shortestToStr(1.0/3.0) == "0.3333333333333333" );
+  uint64_t state=1234567ULL;
+  for (int i=0;i<200000;i++) {
+    double val=NumFormatTest_double(state);
+    if (val!=val) {
+      continue;
+    }
+    string str=NumFormat::shortestToStr(val);
+    CPPUNIT_ASSERT( strtod(str.c_str(),NULL) == val );
+    CPPUNIT_ASSERT( str.size() <= 24 );
+  }
+}
@@ -0,0 +1,133 @@
+////////////////////////////////////////////////////////////////
+//
+// Copyright (C) 2011 Affymetrix, Inc.
+//
+// This library is free software; you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License
+// (version 2.1) as published by the Free Software Foundation.
+//
+// This library is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+// or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License
+// for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this library; if not, write to the Free Software Foundation, Inc.,
+// 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+//
+////////////////////////////////////////////////////////////////
+
+/**
+ * @file   ThreadTest.cpp
+ *
+ * @brief  Testing the WorkQueueTask loop.
+ */
+
+//
+#include "util/Err.h"
+#include "util/Thread.h"
+#include "util/Verbose.h"
+//
+#include <cppunit/CompilerOutputter.h>
+#include <cppunit/extensions/HelperMacros.h>
+#include <cppunit/extensions/TestFactoryRegistry.h>
+#include <cppunit/ui/text/TestRunner.h>
+//
+#include <vector>
+
+using namespace std;
+
+/**
+ * @class ThreadTest
+ * @brief cppunit class for testing the thread helpers.
+ */
+class ThreadTest : public CppUnit::TestFixture
+{
+  CPPUNIT_TEST_SUITE( ThreadTest );
+  CPPUNIT_TEST( testWorkQueue );
+  CPPUNIT_TEST( testWorkQueueAbort );
+  CPPUNIT_TEST_SUITE_END();
+
+public:
+  /** Every item is run once, for any thread count and batch size. */
+  void testWorkQueue();
+  /** An error on one thread stops the others and reaches the caller. */
+  void testWorkQueueAbort();
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION( ThreadTest );
+
+/// Counts the times each item is run and the largest batch.
+class CountTask : public WorkQueueTask {
+public:
+  CountTask(int end, int first, int batch, int failAt=-1) :
+    WorkQueueTask(end, first, batch), m_counts(end, 0), m_maxCount(0), m_failAt(failAt) {
+  }
+
+  virtual void runItems(int threadIx, int start, int count) {
+    {
+      MutexLock lock(m_mutex);
+      if (count > m_maxCount) {
+        m_maxCount = count;
+      }
+    }
+    for (int ix = start; ix < start + count; ix++) {
+      if (ix == m_failAt) {
+        throw Except("CountTask: failing.");
+      }
+      m_counts[ix]++;
+    }
+  }
+
+  vector<int> m_counts;
+  int m_maxCount;
+
+private:
+  Mutex m_mutex;
+  int m_failAt;
+};
+
+void ThreadTest::testWorkQueue()
+{
+  Verbose::out(1, "****ThreadTest::testWorkQueue****");
+  int threadCounts[] = {1, 2, 4, 16};
+  int batches[] = {1, 3, 1000};
+  for (int t = 0; t < 4; t++) {
+    for (int b = 0; b < 3; b++) {
+      CountTask task(997, 5, batches[b]);
+      CPPUNIT_ASSERT(task.getBatchCount() == (992 + batches[b] - 1) / batches[b]);
+      task.run(threadCounts[t]);
+      bool same = true;
+      for (int ix = 0; ix < 997; ix++) {
+        same = same && (task.m_counts[ix] == ((ix < 5) ? 0 : 1));
+      }
+      CPPUNIT_ASSERT(same);
+      CPPUNIT_ASSERT(task.m_maxCount == min(batches[b], 992));
+    }
+  }
+  // Nothing to do.
+  CountTask empty(0, 0, 1);
+  CPPUNIT_ASSERT(empty.getBatchCount() == 0);
+  empty.run(4);
+}
+
+void ThreadTest::testWorkQueueAbort()
+{
+  Verbose::out(1, "****ThreadTest::testWorkQueueAbort****");
+  CountTask task(1000, 0, 1, 10);
+  bool thrown = false;
+  try {
+    task.run(4);
+  }
+  catch (Except&) {
+    thrown = true;
+  }
+  CPPUNIT_ASSERT(thrown);
+  // The failed item was not counted and no item ran twice.
+  CPPUNIT_ASSERT(task.m_counts[10] == 0);
+  bool once = true;
+  for (int ix = 0; ix < 1000; ix++) {
+    once = once && (task.m_counts[ix] <= 1);
+  }
+  CPPUNIT_ASSERT(once);
+}
@@ -129,6 +129,11 @@ AptErr_t Fs__stat(const std::string& path,
     else {
       stat_buf.st_mode |= S_IFREG;
       stat_buf.st_size = (win_attr_data.nFileSizeHigh * (((int)MAXDWORD)+1)) + win_attr_data.nFileSizeLow;
+      // FILETIME is 100ns ticks since 1601.
+      ULARGE_INTEGER mtime;
+      mtime.LowPart=win_attr_data.ftLastWriteTime.dwLowDateTime;
+      mtime.HighPart=win_attr_data.ftLastWriteTime.dwHighDateTime;
+      stat_buf.st_mtime=(time_t)((mtime.QuadPart-116444736000000000ULL)/10000000ULL);
       std::fstream fs;
       Fs::aptOpen(fs, path,std::ios::in|std::ios::binary);
       if (fs.is_open()) {
@@ -990,6 +995,16 @@ int64_t Fs::fileSize(const std::string& path,AptErr_t& errnum) {
   return file_size;
 }
 
+int64_t Fs::fileModTime(const std::string& path,bool abortOnErr) {
+  int stat_rv;
+  struct stat stat_buf;
+
+  if (Fs__stat(path,stat_buf,stat_rv,abortOnErr)!=APT_OK) {
+    return -1;
+  }
+  return stat_buf.st_mtime;
+}
+
 //////////
 
 AptErr_t Fs::chmodBasic(const std::string& path,int mode,bool abortOnErr)
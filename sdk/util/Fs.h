@@ -334,6 +334,12 @@ public:
   static int64_t fileSize(const std::string& path,bool abortOnErr=true);
   static int64_t fileSize(const std::string& path,AptErr_t& errnum);
 
+  /// @brief     The last modification time of the file
+  /// @param     path      The path to the file
+  /// @param     abortOnErr If true, call Err::errAbort when a error occurs.
+  /// @return    seconds since the epoch or -1
+  static int64_t fileModTime(const std::string& path,bool abortOnErr=true);
+
   /// @brief     
   /// @param     path      
   /// @param     names     
@@ -0,0 +1,185 @@
+////////////////////////////////////////////////////////////////
+//
+// Copyright (C) 2011 Affymetrix, Inc.
+//
+// This library is free software; you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License
+// (version 2.1) as published by the Free Software Foundation.
+//
+// This library is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+// or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License
+// for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this library; if not, write to the Free Software Foundation, Inc.,
+// 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+//
+////////////////////////////////////////////////////////////////
+
+//
+#include "util/NumFormat.h"
+//
+#include "portability/affy-system-api.h"
+//
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+//
+
+/// The powers of ten which are exact doubles.
+static const double NumFormat_pow10[]={
+  1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,
+  1e8,  1e9,  1e10, 1e11, 1e12, 1e13, 1e14, 1e15,
+  1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+#define NUMFORMAT_POW10_MAX 22
+
+/// Above this the doubles are not all integers, so the fast path stops.
+#define NUMFORMAT_INT_LIMIT 9007199254740992.0 // 2^53
+
+/// Write the digits of val to the end of buf, returning the first char.
+static char* NumFormat_utoa(char* end,uint64_t val)
+{
+  char* p=end;
+  do {
+    *--p=(char)('0'+(int)(val%10));
+    val/=10;
+  } while (val!=0);
+  return p;
+}
+
+/// signbit() is not in c++98 or msvc; look at the bits.
+static bool NumFormat_isNegative(double val)
+{
+  uint64_t bits;
+  memcpy(&bits,&val,sizeof(bits));
+  return (bits>>63)!=0;
+}
+
+void NumFormat::appendUInt64(std::string& out,uint64_t val)
+{
+  char buf[24];
+  char* end=buf+sizeof(buf);
+  char* p=NumFormat_utoa(end,val);
+  out.append(p,end-p);
+}
+
+void NumFormat::appendInt64(std::string& out,int64_t val)
+{
+  if (val<0) {
+    out.push_back('-');
+    // negate as unsigned so INT64_MIN works.
+    appendUInt64(out,(uint64_t)0-(uint64_t)val);
+  }
+  else {
+    appendUInt64(out,(uint64_t)val);
+  }
+}
+
+void NumFormat::appendInt(std::string& out,int val)
+{
+  appendInt64(out,val);
+}
+
+void NumFormat::appendUInt(std::string& out,unsigned int val)
+{
+  appendUInt64(out,val);
+}
+
+/// The general case; what the ostream would have done.
+static void NumFormat_appendFixedSlow(std::string& out,double val,int prec)
+{
+  // 309 digits for DBL_MAX, the sign, the point and the nul.
+  std::vector<char> buf(prec+320);
+  int len=snprintf(&buf[0],buf.size(),"%.*f",prec,val);
+  if ((len<0)||(len>=(int)buf.size())) {
+    len=(int)strlen(&buf[0]);
+  }
+  out.append(&buf[0],len);
+}
+
+void NumFormat::appendFixed(std::string& out,double val,int prec)
+{
+  if (prec<0) {
+    prec=6;
+  }
+  if (prec>NUMFORMAT_POW10_MAX) {
+    NumFormat_appendFixedSlow(out,val,prec);
+    return;
+  }
+
+  // The digits we want are round(|val|*10^prec).  The multiply is
+  // rounded to within half an ulp of the exact product, which does not
+  // matter unless the product is close to a halfway point; then the
+  // exact value decides, which is what snprintf knows how to do.
+  double aval=fabs(val);
+  double scaled=aval*NumFormat_pow10[prec];
+  // this is false for nan and inf too.
+  if (!(scaled<NUMFORMAT_INT_LIMIT)) {
+    NumFormat_appendFixedSlow(out,val,prec);
+    return;
+  }
+  double whole=floor(scaled);
+  double frac=scaled-whole;
+  // a couple of ulps of slack, which also covers x87 double rounding.
+  if (fabs(frac-0.5)<=(scaled*4.5e-16)) {
+    NumFormat_appendFixedSlow(out,val,prec);
+    return;
+  }
+  uint64_t digits=(uint64_t)whole;
+  if (frac>0.5) {
+    digits++;
+  }
+
+  // "-0.000" is printed for negative values which round to zero.
+  if (NumFormat_isNegative(val)) {
+    out.push_back('-');
+  }
+
+  char buf[48];
+  char* end=buf+sizeof(buf);
+  char* p=NumFormat_utoa(end,digits);
+  // zero pad so there is at least one digit before the point.
+  while ((end-p)<(prec+1)) {
+    *--p='0';
+  }
+  out.append(p,(end-p)-prec);
+  if (prec>0) {
+    out.push_back('.');
+    out.append(end-prec,prec);
+  }
+}
+
+void NumFormat::appendShortest(std::string& out,double val)
+{
+  char buf[40];
+  int len=0;
+  for (int digits=15;digits<=17;digits++) {
+    len=snprintf(buf,sizeof(buf),"%.*g",digits,val);
+    if ((len<0)||(len>=(int)sizeof(buf))) {
+      len=(int)strlen(buf);
+    }
+    // 17 always round trips. (nan and inf never do, but print the same.)
+    if ((digits==17)||(strtod(buf,NULL)==val)) {
+      break;
+    }
+  }
+  out.append(buf,len);
+}
+
+std::string NumFormat::fixedToStr(double val,int prec)
+{
+  std::string str;
+  appendFixed(str,val,prec);
+  return str;
+}
+
+std::string NumFormat::shortestToStr(double val)
+{
+  std::string str;
+  appendShortest(str,val);
+  return str;
+}
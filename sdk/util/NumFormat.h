@@ -0,0 +1,68 @@
+////////////////////////////////////////////////////////////////
+//
+// Copyright (C) 2011 Affymetrix, Inc.
+//
+// This library is free software; you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License
+// (version 2.1) as published by the Free Software Foundation.
+//
+// This library is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+// or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License
+// for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this library; if not, write to the Free Software Foundation, Inc.,
+// 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+//
+////////////////////////////////////////////////////////////////
+
+/// @file   util/NumFormat.h
+/// @brief  Number to text without iostreams.
+///
+/// The functions here append the text of a number to a std::string
+/// which the caller reuses (a line buffer) so that no stream or
+/// temporary string is made per value.  The output is byte for byte
+/// what an ostream in the "C" locale would produce:
+///   - appendInt/appendUInt/appendInt64/appendUInt64 : "os << val"
+///   - appendFixed    : "os << fixed << setprecision(prec) << val"
+///   - appendShortest : the fewest digits (up to 17) which read back
+///                      as the same double.  ("%.15g" to "%.17g")
+
+#ifndef _UTIL_NUMFORMAT_H_
+#define _UTIL_NUMFORMAT_H_
+
+//
+#include "portability/affy-base-types.h"
+#include "portability/apt-win-dll.h"
+//
+#include <string>
+//
+
+/// @brief Fast formatting of numbers into a reusable buffer.
+class APTLIB_API NumFormat {
+public:
+  /// @brief     Append the decimal text of val to out.
+  static void appendInt(std::string& out,int val);
+  static void appendUInt(std::string& out,unsigned int val);
+  static void appendInt64(std::string& out,int64_t val);
+  static void appendUInt64(std::string& out,uint64_t val);
+
+  /// @brief     Append val with prec digits after the decimal point.
+  ///            Same as printf("%.*f") and an ostream set to ios::fixed;
+  ///            a negative prec is 6, as it is for ostreams.
+  ///            Rounding is done on the exact binary value, so the
+  ///            common cases are done with integer math and the rest
+  ///            (halfway cases, huge values, nan, inf) go to snprintf.
+  static void appendFixed(std::string& out,double val,int prec);
+
+  /// @brief     Append the shortest "%.Ng" text of val which converts
+  ///            back to exactly val.
+  static void appendShortest(std::string& out,double val);
+
+  /// @brief     Convenience wrappers which return a new string.
+  static std::string fixedToStr(double val,int prec);
+  static std::string shortestToStr(double val);
+};
+
+#endif /* _UTIL_NUMFORMAT_H_ */
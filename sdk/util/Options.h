@@ -226,6 +226,28 @@ public:
                 m_Options[0].mustFindOpt(opts.m_option_vec[i]->m_longName)->m_values = opts.m_option_vec[i]->m_values;
   }
 
+  /**
+   * Copy the values of another's options, defining the ones we dont
+   * have. Options we already have are updated in place, so it can be
+   * called again to put back values which were changed. The snapshots,
+   * such as the "initial" options written to output headers, are copied
+   * too. Used to give each worker thread options it can set on its own.
+   */
+  void copyOptions(const Options &other) {
+      const PgOptions &opts = other.m_Options[0];
+      for(unsigned int i=0; i<opts.m_option_vec.size(); i++) {
+          PgOpt *opt = m_Options[0].findOpt(opts.m_option_vec[i]->m_longName);
+          if(opt == NULL)
+              m_Options[0].addPgOpt(opts.m_option_vec[i]);
+          else
+              opt->m_values = opts.m_option_vec[i]->m_values;
+      }
+      m_Options.resize(other.m_Options.size());
+      for(unsigned int i=1; i<other.m_Options.size(); i++)
+          m_Options[i] = other.m_Options[i];
+      m_Labels = other.m_Labels;
+  }
+
   int snapshotOptions() {
       std::string empty;
       return snapshotOptions(empty);
@@ -0,0 +1,363 @@
+////////////////////////////////////////////////////////////////
+//
+// Copyright (C) 2011 Affymetrix, Inc.
+//
+// This library is free software; you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License
+// (version 2.1) as published by the Free Software Foundation.
+//
+// This library is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+// or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License
+// for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this library; if not, write to the Free Software Foundation, Inc.,
+// 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+//
+////////////////////////////////////////////////////////////////
+
+//
+#include "util/Thread.h"
+//
+#include "util/Except.h"
+//
+#include <exception>
+#include <vector>
+//
+#ifdef _WIN32
+#include <process.h>
+#else
+#include <unistd.h>
+#endif
+
+//////////
+
+#ifdef _WIN32
+
+Mutex::Mutex() {
+  InitializeCriticalSection(&m_mutex);
+}
+Mutex::~Mutex() {
+  DeleteCriticalSection(&m_mutex);
+}
+void Mutex::lock() {
+  EnterCriticalSection(&m_mutex);
+}
+void Mutex::unlock() {
+  LeaveCriticalSection(&m_mutex);
+}
+
+RecursiveMutex::RecursiveMutex() {
+  InitializeCriticalSection(&m_mutex);
+}
+RecursiveMutex::~RecursiveMutex() {
+  DeleteCriticalSection(&m_mutex);
+}
+void RecursiveMutex::lock() {
+  EnterCriticalSection(&m_mutex);
+}
+void RecursiveMutex::unlock() {
+  LeaveCriticalSection(&m_mutex);
+}
+
+Condition::Condition() {
+  InitializeConditionVariable(&m_cond);
+}
+Condition::~Condition() {
+  // nothing to free on windows.
+}
+void Condition::wait(Mutex& mutex) {
+  SleepConditionVariableCS(&m_cond,&mutex.m_mutex,INFINITE);
+}
+void Condition::signal() {
+  WakeConditionVariable(&m_cond);
+}
+void Condition::broadcast() {
+  WakeAllConditionVariable(&m_cond);
+}
+
+#else
+
+Mutex::Mutex() {
+  pthread_mutex_init(&m_mutex,NULL);
+}
+Mutex::~Mutex() {
+  pthread_mutex_destroy(&m_mutex);
+}
+void Mutex::lock() {
+  pthread_mutex_lock(&m_mutex);
+}
+void Mutex::unlock() {
+  pthread_mutex_unlock(&m_mutex);
+}
+
+RecursiveMutex::RecursiveMutex() {
+  pthread_mutexattr_t attr;
+  pthread_mutexattr_init(&attr);
+  pthread_mutexattr_settype(&attr,PTHREAD_MUTEX_RECURSIVE);
+  pthread_mutex_init(&m_mutex,&attr);
+  pthread_mutexattr_destroy(&attr);
+}
+RecursiveMutex::~RecursiveMutex() {
+  pthread_mutex_destroy(&m_mutex);
+}
+void RecursiveMutex::lock() {
+  pthread_mutex_lock(&m_mutex);
+}
+void RecursiveMutex::unlock() {
+  pthread_mutex_unlock(&m_mutex);
+}
+
+Condition::Condition() {
+  pthread_cond_init(&m_cond,NULL);
+}
+Condition::~Condition() {
+  pthread_cond_destroy(&m_cond);
+}
+void Condition::wait(Mutex& mutex) {
+  pthread_cond_wait(&m_cond,&mutex.m_mutex);
+}
+void Condition::signal() {
+  pthread_cond_signal(&m_cond);
+}
+void Condition::broadcast() {
+  pthread_cond_broadcast(&m_cond);
+}
+
+#endif
+
+//////////
+
+/// The state shared by the threads of one ThreadGroup::run() call.
+class ThreadGroupState {
+public:
+  ThreadTask* m_task;
+  Mutex m_mutex;
+  bool m_failed;
+  std::string m_errMsg;
+
+  ThreadGroupState(ThreadTask* task) : m_task(task), m_failed(false) {
+  }
+
+  /// remember the first error and tell the task to stop.
+  void fail(const std::string& msg) {
+    bool first=false;
+    {
+      MutexLock lock(m_mutex);
+      if (!m_failed) {
+        m_failed=true;
+        m_errMsg=msg;
+        first=true;
+      }
+    }
+    if (first) {
+      m_task->abortThreads();
+    }
+  }
+
+  void runOne(int threadIx) {
+    try {
+      m_task->runThread(threadIx);
+    }
+    catch (std::exception& e) {
+      fail(e.what());
+    }
+    catch (...) {
+      fail("Unknown exception in worker thread.");
+    }
+  }
+};
+
+/// What is handed to the os thread.
+struct ThreadGroupArg {
+  ThreadGroupState* m_state;
+  int m_threadIx;
+};
+
+#ifdef _WIN32
+static unsigned __stdcall ThreadGroup_main(void* vp)
+#else
+static void* ThreadGroup_main(void* vp)
+#endif
+{
+  ThreadGroupArg* arg=(ThreadGroupArg*)vp;
+  arg->m_state->runOne(arg->m_threadIx);
+  return 0;
+}
+
+int ThreadGroup::getCpuCount()
+{
+  int cnt=1;
+#ifdef _WIN32
+  SYSTEM_INFO sysinfo;
+  GetSystemInfo(&sysinfo);
+  cnt=(int)sysinfo.dwNumberOfProcessors;
+#elif defined(_SC_NPROCESSORS_ONLN)
+  cnt=(int)sysconf(_SC_NPROCESSORS_ONLN);
+#endif
+  if (cnt<1) {
+    cnt=1;
+  }
+  return cnt;
+}
+
+int ThreadGroup::resolveThreadCount(int requested)
+{
+  if (requested<=0) {
+    return getCpuCount();
+  }
+  return requested;
+}
+
+void ThreadGroup::run(ThreadTask& task, int threadCount)
+{
+  if (threadCount<=1) {
+    task.runThread(0);
+    return;
+  }
+
+  ThreadGroupState state(&task);
+  std::vector<ThreadGroupArg> args(threadCount);
+#ifdef _WIN32
+  std::vector<HANDLE> threads(threadCount,(HANDLE)0);
+#else
+  std::vector<pthread_t> threads(threadCount);
+  std::vector<bool> started(threadCount,false);
+#endif
+
+  for (int i=1;i<threadCount;i++) {
+    args[i].m_state=&state;
+    args[i].m_threadIx=i;
+#ifdef _WIN32
+    threads[i]=(HANDLE)_beginthreadex(NULL,0,ThreadGroup_main,&args[i],0,NULL);
+    if (threads[i]==0) {
+      state.fail("ThreadGroup::run(): unable to start thread.");
+      break;
+    }
+#else
+    if (pthread_create(&threads[i],NULL,ThreadGroup_main,&args[i])!=0) {
+      state.fail("ThreadGroup::run(): unable to start thread.");
+      break;
+    }
+    started[i]=true;
+#endif
+  }
+
+  // the caller does its share.
+  if (!state.m_failed) {
+    state.runOne(0);
+  }
+
+  // join
+  for (int i=1;i<threadCount;i++) {
+#ifdef _WIN32
+    if (threads[i]!=0) {
+      WaitForSingleObject(threads[i],INFINITE);
+      CloseHandle(threads[i]);
+    }
+#else
+    if (started[i]) {
+      pthread_join(threads[i],NULL);
+    }
+#endif
+  }
+
+  if (state.m_failed) {
+    throw Except(state.m_errMsg);
+  }
+}
+
+//////////
+
+WorkQueueTask::WorkQueueTask(int end, int first, int batch) :
+  m_next(first), m_end(end), m_batch(batch), m_aborted(false)
+{
+  if (m_batch<1) {
+    m_batch=1;
+  }
+}
+
+int WorkQueueTask::getBatchCount() const
+{
+  if (m_end<=m_next) {
+    return 0;
+  }
+  return (m_end-m_next+m_batch-1)/m_batch;
+}
+
+void WorkQueueTask::run(int threadCount)
+{
+  int batchCount=getBatchCount();
+  if (threadCount>batchCount) {
+    threadCount=batchCount;
+  }
+  if (threadCount<1) {
+    threadCount=1;
+  }
+  ThreadGroup::run(*this,threadCount);
+}
+
+void WorkQueueTask::runThread(int threadIx)
+{
+  while (true) {
+    int start;
+    int count;
+    {
+      MutexLock lock(m_mutex);
+      if ((m_aborted)||(m_next>=m_end)) {
+        return;
+      }
+      start=m_next;
+      count=m_end-m_next;
+      if (count>m_batch) {
+        count=m_batch;
+      }
+      m_next+=count;
+    }
+    runItems(threadIx,start,count);
+  }
+}
+
+void WorkQueueTask::abortThreads()
+{
+  MutexLock lock(m_mutex);
+  m_aborted=true;
+}
+
+//////////
+
+OrderedTurn::OrderedTurn(int first) : m_next(first), m_aborted(false)
+{
+}
+
+void OrderedTurn::wait(int ix)
+{
+  MutexLock lock(m_mutex);
+  while ((m_next!=ix)&&(!m_aborted)) {
+    m_cond.wait(m_mutex);
+  }
+  if (m_aborted) {
+    throw Except("OrderedTurn::wait(): aborted.");
+  }
+}
+
+void OrderedTurn::done(int ix)
+{
+  MutexLock lock(m_mutex);
+  m_next=ix+1;
+  m_cond.broadcast();
+}
+
+void OrderedTurn::abort()
+{
+  MutexLock lock(m_mutex);
+  m_aborted=true;
+  m_cond.broadcast();
+}
+
+int OrderedTurn::current()
+{
+  MutexLock lock(m_mutex);
+  return m_next;
+}
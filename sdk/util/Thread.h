@@ -0,0 +1,219 @@
+////////////////////////////////////////////////////////////////
+//
+// Copyright (C) 2011 Affymetrix, Inc.
+//
+// This library is free software; you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License
+// (version 2.1) as published by the Free Software Foundation.
+//
+// This library is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+// or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License
+// for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this library; if not, write to the Free Software Foundation, Inc.,
+// 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+//
+////////////////////////////////////////////////////////////////
+
+/// @file   util/Thread.h
+/// @brief  Small portable threading layer (pthreads on unix, win32 on windows).
+///
+/// APT code is written as if it were single threaded. The classes here are
+/// the minimum needed to run independent units of work (probesets, samples,
+/// chromosomes...) on several cores:
+///   - Mutex/MutexLock  : mutual exclusion
+///   - RecursiveMutex   : a mutex which can be relocked by its holder
+///   - Condition        : wait/signal on a Mutex
+///   - ThreadGroup      : run a ThreadTask on N threads and join them.
+///   - WorkQueueTask    : a parallel for loop; threads claim the next items until none are left.
+///   - OrderedTurn      : let results computed out of order be consumed in order.
+///
+/// Errors (Err::errAbort) raised on a worker thread are caught, the other
+/// workers are asked to stop and the error is rethrown on the calling thread.
+
+#ifndef _UTIL_THREAD_H_
+#define _UTIL_THREAD_H_
+
+//
+#include "portability/apt-win-dll.h"
+//
+#include <string>
+//
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <pthread.h>
+#endif
+
+/// @brief A non-recursive mutex.
+class APTLIB_API Mutex {
+public:
+  Mutex();
+  ~Mutex();
+  void lock();
+  void unlock();
+
+private:
+  friend class Condition;
+  // not copyable.
+  Mutex(const Mutex&);
+  Mutex& operator=(const Mutex&);
+#ifdef _WIN32
+  CRITICAL_SECTION m_mutex;
+#else
+  pthread_mutex_t m_mutex;
+#endif
+};
+
+/// @brief A mutex which the thread holding it may lock again.
+///        It must be unlocked as many times as it was locked.
+class APTLIB_API RecursiveMutex {
+public:
+  RecursiveMutex();
+  ~RecursiveMutex();
+  void lock();
+  void unlock();
+
+private:
+  RecursiveMutex(const RecursiveMutex&);
+  RecursiveMutex& operator=(const RecursiveMutex&);
+#ifdef _WIN32
+  // critical sections are already recursive.
+  CRITICAL_SECTION m_mutex;
+#else
+  pthread_mutex_t m_mutex;
+#endif
+};
+
+/// @brief Hold a Mutex for the life of the object.
+class APTLIB_API MutexLock {
+public:
+  MutexLock(Mutex& mutex) : m_mutex(mutex) {
+    m_mutex.lock();
+  }
+  ~MutexLock() {
+    m_mutex.unlock();
+  }
+private:
+  MutexLock(const MutexLock&);
+  MutexLock& operator=(const MutexLock&);
+  Mutex& m_mutex;
+};
+
+/// @brief A condition variable to be used with a Mutex.
+class APTLIB_API Condition {
+public:
+  Condition();
+  ~Condition();
+  /// @brief Release the locked mutex, wait to be signaled and relock it.
+  void wait(Mutex& mutex);
+  /// @brief Wake one waiter.
+  void signal();
+  /// @brief Wake all the waiters.
+  void broadcast();
+
+private:
+  Condition(const Condition&);
+  Condition& operator=(const Condition&);
+#ifdef _WIN32
+  CONDITION_VARIABLE m_cond;
+#else
+  pthread_cond_t m_cond;
+#endif
+};
+
+/// @brief The work done by each thread of a ThreadGroup.
+class APTLIB_API ThreadTask {
+public:
+  virtual ~ThreadTask() {}
+  /// @brief     Called once on each thread.
+  /// @param     threadIx  0..threadCount-1; thread 0 is the calling thread.
+  virtual void runThread(int threadIx) = 0;
+  /// @brief     Called (once) when some thread has failed.
+  ///            Tasks which wait on each other should wake up and quit.
+  virtual void abortThreads() {}
+};
+
+/// @brief Fork/join a ThreadTask over a number of threads.
+class APTLIB_API ThreadGroup {
+public:
+  /// @brief     The number of cpus the os says we have.
+  static int getCpuCount();
+
+  /// @brief     Turn a user supplied "--threads" value into a count.
+  ///            Values <= 0 mean "one per cpu".
+  static int resolveThreadCount(int requested);
+
+  /// @brief     Run task.runThread(ix) on threadCount threads and wait for
+  ///            all of them to finish.  The caller is used as thread 0.
+  ///            If a thread throws, the first error is rethrown here as an Except.
+  /// @param     task         the work.
+  /// @param     threadCount  number of threads. (1 => just call it.)
+  static void run(ThreadTask& task, int threadCount);
+};
+
+/// @brief     A ThreadTask for a loop over the items [first,end) whose
+///            items do not depend on each other.
+///
+/// Each thread claims the next batch of items not yet claimed and passes
+/// it to runItems(), until no items are left or a thread has failed.
+/// Each item is run exactly once, but on no particular thread and in no
+/// particular order, so runItems() should only write the item's own output.
+class APTLIB_API WorkQueueTask : public ThreadTask {
+public:
+  /// @param     end    one past the last item.
+  /// @param     first  the first item.
+  /// @param     batch  the number of items claimed at a time.
+  WorkQueueTask(int end, int first=0, int batch=1);
+
+  /// @brief     Run the items [start,start+count).
+  /// @param     threadIx  the thread, as for runThread().
+  virtual void runItems(int threadIx, int start, int count) = 0;
+
+  /// @brief     The number of batches, which is as many threads as can be kept busy.
+  int getBatchCount() const;
+
+  /// @brief     Run the loop on up to threadCount threads, but no more
+  ///            than there are batches. (See ThreadGroup::run.)
+  void run(int threadCount);
+
+  virtual void runThread(int threadIx);
+  virtual void abortThreads();
+
+private:
+  Mutex m_mutex;
+  int m_next;
+  int m_end;
+  int m_batch;
+  bool m_aborted;
+};
+
+/// @brief     Hands out turns in strict sequence.
+///
+/// Workers compute items out of order and then call wait(ix) before
+/// consuming their result; wait(ix) returns only once items [0,ix) have
+/// called done().  This is how the threaded loops keep their output
+/// identical to the serial loop: the reporting is done in order while the
+/// work is not.
+class APTLIB_API OrderedTurn {
+public:
+  OrderedTurn(int first=0);
+  /// @brief     Block until it is ix's turn.  Throws if aborted.
+  void wait(int ix);
+  /// @brief     Finish ix's turn and let ix+1 go.
+  void done(int ix);
+  /// @brief     Wake and fail all the waiters. (Used when a thread dies.)
+  void abort();
+  /// @brief     The index which currently has the turn.
+  int current();
+
+private:
+  Mutex m_mutex;
+  Condition m_cond;
+  int m_next;
+  bool m_aborted;
+};
+
+#endif /* _UTIL_THREAD_H_ */
@@ -29,6 +29,7 @@
 #include "calvin_files/utils/src/StringUtils.h"
 #include "portability/affy-system-api.h"
 #include "util/Fs.h"
+#include "util/Thread.h"
 #include "util/Util.h"
 #include "util/Verbose.h"
 //
@@ -38,6 +39,13 @@
 using namespace std;
 using namespace affymetrix_calvin_utilities;
 
+/// Messages and progress dots may come from worker threads.
+/// (A local static, like getParam(), so it is there for static initializers.)
+static Mutex &Verbose_mutex() {
+  static Mutex m;
+  return m;
+}
+
 /**
  * @brief This function will create log file for test 
  * purposes.  
@@ -76,6 +84,7 @@ void em_out(const std::string& msg)
  * @param verbosity - What level of verbosity this message should be printed at.
  */
 void Verbose::progressStep(int verbosity) {
+  MutexLock lock(Verbose_mutex());
   Param &p = getParam();
  
   assert(p.m_DotCount.size() > 0);
@@ -257,6 +266,7 @@ void Verbose::setLevel(int level) {
  * @param nl - Should a newline be appended to message?
  */
 void Verbose::out(int level, const std::string &s, bool nl) { 
+  MutexLock lock(Verbose_mutex());
   Verbose::Param &p = getParam();
   if(p.m_Output) {
       for(unsigned int i = 0; i < p.m_MsgHandler.size(); i++) {
@@ -275,6 +285,7 @@ void Verbose::out(int level, const std::string &s, bool nl) {
  * @param nl - Should a newline be appended to message?
  */
 void Verbose::warn(int level, const std::string &s, bool nl, const std::string prefix) {
+  MutexLock lock(Verbose_mutex());
   Verbose::Param &p = getParam();
   if(p.m_Output) {
       for(unsigned int i = 0; i < p.m_WarnHandler.size(); i++) {